@@ -0,0 +1,5 @@
+#pragma once
+// Force-included into the counting build of the benchmark, see the bench target in the Makefile.
+#define WRENCH_BENCH_COUNT
+extern unsigned long long wr_benchInstructions;
+#define DEBUG_PER_INSTRUCTION { ++wr_benchInstructions; }
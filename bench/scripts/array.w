@@ -0,0 +1,22 @@
+// array fill, index and sum, like filtering a window of sensor samples
+var g_samples[64];
+
+function bench()
+{
+	for( var i = 0; i < 64; ++i )
+	{
+		g_samples[i] = (i * 37) % 101;
+	}
+	var total = 0;
+	for( var pass = 0; pass < 40; ++pass )
+	{
+		var prev = g_samples[0];
+		for( var j = 1; j < g_samples._count; ++j )
+		{
+			var cur = g_samples[j];
+			total += (prev + cur) >> 1;
+			prev = cur;
+		}
+	}
+	return total;
+}
@@ -0,0 +1,30 @@
+// small helpers called from a hot loop, and an accumulator that recurses
+// on itself as its last act
+function clamp( x, lo, hi )
+{
+	if ( x < lo ) return lo;
+	if ( x > hi ) return hi;
+	return x;
+}
+
+function scale( raw )
+{
+	return raw * 3 / 4 + 60;
+}
+
+function accumulate( n, acc )
+{
+	if ( n == 0 ) return acc;
+	return accumulate( n - 1, acc + (n & 7) );
+}
+
+function bench()
+{
+	var total = 0;
+	for( var i = 0; i < 2000; ++i )
+	{
+		total = total + clamp( scale(i & 1023), 100, 600 );
+		total = total + accumulate( i & 15, 0 );
+	}
+	return total;
+}
@@ -0,0 +1,29 @@
+// sensor scaling the way firmware scripts spell it: constants as expressions, a disabled
+// debug path, copies between locals and code left behind a return
+function bench()
+{
+	var total = 0;
+	for( var i = 0; i < 5000; ++i )
+	{
+		var raw = i & 1023;
+		var scale = 1000 * 3 / 4;
+		var offset = 60 * 60 - 3000;
+		var mv = raw * scale / 1024 + offset;
+		var reading = mv;
+		if ( 0 )
+		{
+			total = total - reading;
+		}
+		if ( 16 >> 2 > 3 )
+		{
+			total = total + (reading >> (1 + 1));
+		}
+		else
+		{
+			total = total + reading;
+		}
+		var unused = reading * 2;
+	}
+	return total;
+	total = 0;
+}
@@ -0,0 +1,16 @@
+// float arithmetic with a few int/float conversions
+function bench()
+{
+	var x = 0.5;
+	var acc = 0.0;
+	for( var i = 0; i < 10000; ++i )
+	{
+		x = x * 1.0001 + 0.25;
+		acc += x / (i + 1.5);
+		if ( x > 1000.0 )
+		{
+			x = x - 999.0;
+		}
+	}
+	return (int)(acc * 1000.0);
+}
@@ -0,0 +1,34 @@
+// hash table and struct member access
+struct Point
+{
+	var x;
+	var y;
+};
+
+function bench()
+{
+	var h = { 0:0 };
+	for( var i = 0; i < 500; ++i )
+	{
+		h[i] = i * 2;
+	}
+	var sum = 0;
+	for( var j = 0; j < 4; ++j )
+	{
+		for( var k = 0; k < 500; ++k )
+		{
+			sum += h[k];
+		}
+	}
+
+	var p = new Point;
+	p.x = 1;
+	p.y = 2;
+	for( var n = 0; n < 2000; ++n )
+	{
+		p.x = p.x + p.y;
+		p.y = p.x - p.y;
+		sum += p.y & 0xFF;
+	}
+	return sum;
+}
@@ -0,0 +1,14 @@
+// integer arithmetic, compares and branches on locals
+function bench()
+{
+	var sum = 0;
+	for( var i = 0; i < 20000; ++i )
+	{
+		sum = sum + i * 3 - (i >> 1);
+		if ( (i & 7) == 3 )
+		{
+			sum ^= i;
+		}
+	}
+	return sum;
+}
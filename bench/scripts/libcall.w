@@ -0,0 +1,11 @@
+// native library calls
+function bench()
+{
+	var acc = 0.0;
+	for( var i = 0; i < 3000; ++i )
+	{
+		acc += math::sqrt( i ) + math::abs( math::sin(i) );
+		acc -= math::floor( acc / 1000.0 ) * 1000.0;
+	}
+	return (int)acc;
+}
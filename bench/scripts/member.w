@@ -0,0 +1,22 @@
+// the same members read and written in a loop, on two struct layouts and a growing hash table
+struct P { var x; var y; var z; };
+struct Q { var a; var z; var x; };
+function bench()
+{
+	var p = new P;
+	var q = new Q;
+	var h = { "x":1, "y":2 };
+	var acc = 0;
+	for( var i = 0; i < 2000; ++i )
+	{
+		p.x = i; p.y = p.x + 1; p.z += p.y;
+		q.x = p.z; q.z += q.x & 7;
+		h.x += 1; h.y = h.x * 2;
+		if ( i == 1000 ) { h.w = 5; h.v = 6; h.u = 7; h.t = 8; }
+		var o = q;
+		if ( i & 1 ) { o = p; }
+		acc += o.x + o.z;
+		h.q = i;
+	}
+	return acc + h.x + h.y + h.w + p.z + q.z + h.q;
+}
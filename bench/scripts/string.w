@@ -0,0 +1,21 @@
+// string literals, formatting, compares and string library calls
+function bench()
+{
+	var count = 0;
+	for( var i = 0; i < 300; ++i )
+	{
+		var word = "sensor";
+		if ( word == "sensor" )
+		{
+			count++;
+		}
+		var s = str::concat( "t", str::format("%d", i) );
+		count += str::strlen( s );
+		if ( str::isdigit(s[1]) )
+		{
+			count += 2;
+		}
+	}
+	var buf = str::format( "%d:%s", count, "done" );
+	return count + str::strlen( buf );
+}
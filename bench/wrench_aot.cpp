@@ -0,0 +1,103 @@
+// Ahead-of-time translator for wrench scripts.
+//
+// Compiles every script and writes the C++ wr_translate() makes of it to stdout, one module
+// named wr_aot_<script> per script. Build the output next to wrench.cpp with WRENCH_AOT and
+// hand the modules to wr_addNativeModule(), contexts created from the bytecode written along
+// with them then run the translated functions natively. See `make aot`.
+#include "wrench.h"
+#include <cctype>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+namespace {
+
+bool read_file(const char *path, std::string &out) {
+	FILE *f = fopen(path, "rb");
+	if (!f) {
+		return false;
+	}
+	char buf[4096];
+	size_t n;
+	while ((n = fread(buf, 1, sizeof(buf), f)) > 0) {
+		out.append(buf, n);
+	}
+	fclose(f);
+	return true;
+}
+
+// wr_aot_<file name without extension>, as a C identifier.
+std::string module_name(const char *path) {
+	const char *slash = strrchr(path, '/');
+	std::string base = slash ? slash + 1 : path;
+	const size_t dot = base.rfind('.');
+	if (dot != std::string::npos) {
+		base = base.substr(0, dot);
+	}
+	std::string ret = "wr_aot_";
+	for (const char c : base) {
+		ret += isalnum((unsigned char)c) ? c : '_';
+	}
+	return ret;
+}
+
+int usage() {
+	fprintf(stderr, "usage: wrench_aot [--list NAME] script.w...\n"
+			"  --list NAME  also define NAME, a null terminated array of all the modules\n");
+	return 2;
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+	const char *list = nullptr;
+	int i = 1;
+	for (; i < argc && argv[i][0] == '-'; ++i) {
+		if (!strcmp(argv[i], "--list") && i + 1 < argc) {
+			list = argv[++i];
+		} else {
+			return usage();
+		}
+	}
+	if (i == argc) {
+		return usage();
+	}
+
+	std::vector<std::string> modules;
+	for (; i < argc; ++i) {
+		std::string source;
+		if (!read_file(argv[i], source)) {
+			fprintf(stderr, "%s: cannot read\n", argv[i]);
+			return 1;
+		}
+
+		// The default flags, the bytecode has to be what wr_compile() makes of the script on
+		// the target for the module to apply.
+		unsigned char *bytecode;
+		int len;
+		char err[1024] = "";
+		if (wr_compile(source.c_str(), source.size(), &bytecode, &len, err)) {
+			fprintf(stderr, "%s: compile error: %s\n", argv[i], err);
+			return 1;
+		}
+
+		const std::string name = module_name(argv[i]);
+		char *out;
+		wr_translate(bytecode, len, name.c_str(), &out);
+		printf("%s\n", out);
+		wr_free(out);
+		wr_free(bytecode);
+		modules.push_back(name);
+	}
+
+	if (list) {
+		printf("#ifdef WRENCH_AOT\nextern const WRNativeModule* const %s[] =\n{\n", list);
+		for (const std::string &name : modules) {
+			printf("\t&%s,\n", name.c_str());
+		}
+		printf("\t0\n};\n#endif\n");
+	}
+	return 0;
+}
@@ -0,0 +1,331 @@
+// Host benchmark of the wrench interpreter.
+//
+// Every script of the corpus defines function bench(). It is compiled once, run once to
+// load it, and then bench() is called until --min-ms milliseconds have passed.
+// The Makefile builds this file once per interpreter configuration, see `make bench`.
+#include "wrench.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <string>
+
+#ifndef WRENCH_BENCH_CONFIG
+#define WRENCH_BENCH_CONFIG "custom"
+#endif
+
+#ifdef WRENCH_BENCH_COUNT
+unsigned long long wr_benchInstructions = 0;
+#endif
+
+#ifdef WRENCH_BENCH_OPTIMIZE
+// The corpus compiled with the optimizing pass, compare bytes and ns/call to the other configs.
+const uint8_t COMPILER_FLAGS = WR_INCLUDE_GLOBALS | WR_OPTIMIZE;
+#else
+const uint8_t COMPILER_FLAGS = WR_INCLUDE_GLOBALS;
+#endif
+
+#ifdef WRENCH_BENCH_AOT
+// The translated corpus, see `make aot`.
+extern const WRNativeModule *const wr_benchModules[];
+#endif
+
+namespace {
+
+// Recursion in the corpus needs more than WRENCH_DEFAULT_STACK_SIZE.
+const int STACK_SIZE = 512;
+
+#ifdef WRENCH_SAMPLE_PROFILER
+// Branches and calls between two samples of the sampled bench() call.
+const int SAMPLE_INTERVAL = 1000;
+#endif
+
+struct Heap {
+	size_t live = 0;
+	size_t peak = 0;
+	size_t allocations = 0;
+};
+Heap heap;
+
+// Keeps the size in front of the block, so free() knows how much is released.
+void *bench_malloc(size_t size) {
+	size_t *p = static_cast<size_t *>(malloc(size + sizeof(max_align_t)));
+	if (!p) {
+		return nullptr;
+	}
+	*p = size;
+	heap.live += size;
+	heap.allocations++;
+	if (heap.live > heap.peak) {
+		heap.peak = heap.live;
+	}
+	return reinterpret_cast<char *>(p) + sizeof(max_align_t);
+}
+
+void bench_free(void *ptr) {
+	if (!ptr) {
+		return;
+	}
+	size_t *p = reinterpret_cast<size_t *>(static_cast<char *>(ptr) - sizeof(max_align_t));
+	heap.live -= *p;
+	free(p);
+}
+
+bool read_file(const char *path, std::string &out) {
+	FILE *f = fopen(path, "rb");
+	if (!f) {
+		return false;
+	}
+	char buf[4096];
+	size_t n;
+	while ((n = fread(buf, 1, sizeof(buf), f)) > 0) {
+		out.append(buf, n);
+	}
+	fclose(f);
+	return true;
+}
+
+// The file name, which names the script in the table and in --counts files.
+std::string script_name(const char *path) {
+	const char *slash = strrchr(path, '/');
+	return slash ? slash + 1 : path;
+}
+
+double now_ns() {
+	using namespace std::chrono;
+	return duration_cast<nanoseconds>(steady_clock::now().time_since_epoch()).count();
+}
+
+struct Result {
+	double compile_us;
+	double ns_per_call;
+	unsigned long long calls;
+	unsigned long long instructions_per_call;
+	size_t peak_heap;
+	int bytecode_size;
+	std::string value;
+};
+
+bool run_script(const char *path, double min_ms, bool count, bool profile, bool samples, Result &r) {
+	std::string source;
+	if (!read_file(path, source)) {
+		fprintf(stderr, "%s: cannot read\n", path);
+		return false;
+	}
+
+	unsigned char *bytecode;
+	int len;
+	char err[1024] = "";
+	double start = now_ns();
+	if (wr_compile(source.c_str(), source.size(), &bytecode, &len, err, COMPILER_FLAGS)) {
+		fprintf(stderr, "%s: compile error: %s\n", path, err);
+		return false;
+	}
+	r.compile_us = (now_ns() - start) / 1000;
+	r.bytecode_size = len;
+
+	// The context gets its own copy, the way firmware hands over a freshly compiled
+	// block. Owned code is writable, which WRENCH_QUICKEN needs.
+	unsigned char *code = static_cast<unsigned char *>(wr_malloc(len));
+	memcpy(code, bytecode, len);
+
+	const size_t baseline = heap.live;
+	heap.peak = heap.live;
+	WRState *w = wr_newState(STACK_SIZE);
+#ifdef WRENCH_BENCH_AOT
+	for (const WRNativeModule *const *m = wr_benchModules; *m; ++m) {
+		wr_addNativeModule(w, *m);
+	}
+#endif
+	wr_loadAllLibs(w);
+	WRContext *context = wr_run(w, code, len, true);
+	WRFunction *bench = context ? wr_getFunction(context, "bench") : nullptr;
+	if (!bench) {
+		fprintf(stderr, "%s: no bench() or error %d\n", path, wr_getLastError(w));
+		wr_destroyState(w);
+		wr_free(bytecode);
+		return false;
+	}
+
+	// Warm up, and the value every configuration must agree on.
+	WRValue *ret = wr_callFunction(context, bench);
+	if (!ret) {
+		fprintf(stderr, "%s: bench() failed with error %d\n", path, wr_getLastError(w));
+		wr_destroyState(w);
+		wr_free(bytecode);
+		return false;
+	}
+	char buf[64];
+	r.value = ret->asString(buf, sizeof(buf));
+
+#ifdef WRENCH_PROFILE_OPCODES
+	// Only the timed calls are profiled, not compiling and loading.
+	wr_profileReset();
+#endif
+
+	r.instructions_per_call = 0;
+#ifdef WRENCH_BENCH_COUNT
+	if (count) {
+		wr_benchInstructions = 0;
+		wr_callFunction(context, bench);
+		r.instructions_per_call = wr_benchInstructions;
+	}
+#else
+	(void)count;
+#endif
+
+	r.calls = 0;
+	start = now_ns();
+	double elapsed;
+	do {
+		wr_callFunction(context, bench);
+		r.calls++;
+		elapsed = now_ns() - start;
+	} while (elapsed < min_ms * 1e6 || r.calls < 3);
+	r.ns_per_call = elapsed / r.calls;
+	r.peak_heap = heap.peak - baseline;
+
+#ifdef WRENCH_PROFILE_OPCODES
+	if (profile) {
+		char *dump;
+		wr_profileDump(&dump);
+		printf("== %s\n%s", path, dump);
+		wr_free(dump);
+		// The profile knows locations by address, so this has to be the block that ran.
+		wr_disassemble(code, len, &dump);
+		printf("%s", dump);
+		wr_free(dump);
+	}
+#else
+	(void)profile;
+#endif
+
+#ifdef WRENCH_SAMPLE_PROFILER
+	// The timed calls ran with the profiler compiled in but not sampling. One more call is
+	// sampled, and has to agree with them.
+	if (!wr_sampleStart(w, SAMPLE_INTERVAL)) {
+		fprintf(stderr, "%s: cannot start sampling\n", path);
+		wr_destroyState(w);
+		wr_free(bytecode);
+		return false;
+	}
+	ret = wr_callFunction(context, bench);
+	if (!ret || r.value != ret->asString(buf, sizeof(buf))) {
+		fprintf(stderr, "%s: sampled bench() failed or disagrees\n", path);
+		wr_destroyState(w);
+		wr_free(bytecode);
+		return false;
+	}
+	char *folded;
+	wr_sampleFolded(w, &folded);
+	if (samples) {
+		printf("== %s\n%s", path, folded);
+	}
+	wr_free(folded);
+#else
+	(void)samples;
+#endif
+
+	wr_destroyState(w);
+	wr_free(bytecode);
+	return true;
+}
+
+// Lines of "<script> <instructions per call>" written by a --count run.
+std::map<std::string, unsigned long long> read_counts(const char *path) {
+	std::map<std::string, unsigned long long> ret;
+	FILE *f = fopen(path, "r");
+	if (!f) {
+		return ret;
+	}
+	char name[256];
+	unsigned long long n;
+	while (fscanf(f, "%255s %llu", name, &n) == 2) {
+		ret[name] = n;
+	}
+	fclose(f);
+	return ret;
+}
+
+int usage() {
+	fprintf(stderr, "usage: wrench_bench [--count] [--counts FILE] [--profile] [--samples] [--min-ms MS] script.w...\n"
+			"  --count        print the instructions executed by one bench() call per script\n"
+			"  --counts FILE  output of a --count run, to report instructions per second\n"
+			"  --profile      print the opcode profile and the annotated disassembly per script\n"
+			"  --samples      print the folded call stacks sampled from one bench() call per script\n"
+			"  --min-ms MS    time spent calling bench() per script, default 200\n");
+	return 2;
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+	bool count = false;
+	bool profile = false;
+	bool samples = false;
+	double min_ms = 200;
+	std::map<std::string, unsigned long long> counts;
+	int i = 1;
+	for (; i < argc && argv[i][0] == '-'; ++i) {
+		if (!strcmp(argv[i], "--count")) {
+#ifndef WRENCH_BENCH_COUNT
+			fprintf(stderr, "--count needs a build with bench/bench_count.h\n");
+			return 2;
+#endif
+			count = true;
+		} else if (!strcmp(argv[i], "--profile")) {
+#ifndef WRENCH_PROFILE_OPCODES
+			fprintf(stderr, "--profile needs a build with WRENCH_PROFILE_OPCODES\n");
+			return 2;
+#endif
+			profile = true;
+		} else if (!strcmp(argv[i], "--samples")) {
+#ifndef WRENCH_SAMPLE_PROFILER
+			fprintf(stderr, "--samples needs a build with WRENCH_SAMPLE_PROFILER\n");
+			return 2;
+#endif
+			samples = true;
+		} else if (!strcmp(argv[i], "--counts") && i + 1 < argc) {
+			counts = read_counts(argv[++i]);
+		} else if (!strcmp(argv[i], "--min-ms") && i + 1 < argc) {
+			min_ms = atof(argv[++i]);
+		} else {
+			return usage();
+		}
+	}
+	if (i == argc) {
+		return usage();
+	}
+
+	wr_setGlobalAllocator(bench_malloc, bench_free);
+
+	int failed = 0;
+	if (!count && !profile && !samples) {
+		printf("%-16s %-12s %12s %10s %10s %9s %8s %8s %s\n", "config", "script", "ns/call", "Minstr/s",
+		       "compile_us", "peak_heap", "bytes", "calls", "result");
+	}
+	for (; i < argc; ++i) {
+		Result r;
+		if (!run_script(argv[i], count ? 0 : min_ms, count, profile, samples, r)) {
+			failed++;
+			continue;
+		}
+		const std::string name = script_name(argv[i]);
+		if (count) {
+			printf("%s %llu\n", name.c_str(), r.instructions_per_call);
+			continue;
+		}
+		if (profile || samples) {
+			continue;
+		}
+		const auto it = counts.find(name);
+		char mips[32] = "-";
+		if (it != counts.end()) {
+			snprintf(mips, sizeof(mips), "%.1f", it->second / r.ns_per_call * 1e3);
+		}
+		printf("%-16s %-12s %12.0f %10s %10.0f %9zu %8d %8llu %s\n", WRENCH_BENCH_CONFIG, name.c_str(),
+		       r.ns_per_call, mips, r.compile_us, r.peak_heap, r.bytecode_size, r.calls, r.value.c_str());
+	}
+	return failed ? 1 : 0;
+}
@@ -0,0 +1,205 @@
+// Superinstruction generator for the wrench interpreter.
+//
+// Reads the opcode pair counts of one or more `wrench_bench --profile` runs and writes
+// wrench_super.h, the list of opcode pairs fused into one opcode. The most frequent pairs win,
+// as many as there are free opcodes. wrench.cpp turns every entry into an opcode, a keyhole rule
+// in pushOpcode() and an interpreter handler. The first opcode of a pair needs a
+// WR_SUPER_OPERANDS_/WR_SUPER_FIRST_ definition in wrench.cpp, that is the catalog this tool
+// chooses from. See `make bench-super`.
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+namespace {
+
+// The compiler asserts O_LAST < 255.
+const int MAX_OPCODES = 254;
+
+struct Pair {
+	std::string first;
+	std::string second;
+	std::string second_as_pushed;
+	unsigned long long count;
+};
+
+bool read_lines(const char *path, std::vector<std::string> &out) {
+	FILE *f = fopen(path, "r");
+	if (!f) {
+		return false;
+	}
+	char buf[1024];
+	while (fgets(buf, sizeof(buf), f)) {
+		out.push_back(buf);
+	}
+	fclose(f);
+	return true;
+}
+
+bool starts_with(const std::string &s, const char *prefix) {
+	return s.compare(0, strlen(prefix), prefix) == 0;
+}
+
+bool ends_with(const std::string &s, const char *suffix) {
+	const size_t n = strlen(suffix);
+	return s.size() >= n && s.compare(s.size() - n, n, suffix) == 0;
+}
+
+// The opcodes of enum WROpcode up to O_LAST, and the first opcodes with a catalog entry.
+bool read_opcodes(const char *path, std::vector<std::string> &opcodes, std::map<std::string, int> &firsts) {
+	std::vector<std::string> lines;
+	if (!read_lines(path, lines)) {
+		return false;
+	}
+	bool in_enum = false;
+	for (const std::string &line : lines) {
+		char name[128];
+		int operands;
+		if (sscanf(line.c_str(), "#define WR_SUPER_OPERANDS_%127s %d", name, &operands) == 2) {
+			firsts[name] = operands;
+		}
+		if (starts_with(line, "enum WROpcode")) {
+			in_enum = true;
+			continue;
+		}
+		if (!in_enum || sscanf(line.c_str(), " O_%127[A-Za-z0-9_]", name) != 1) {
+			continue;
+		}
+		if (!strcmp(name, "LAST")) {
+			in_enum = false;
+			continue;
+		}
+		opcodes.push_back(name);
+	}
+	return !opcodes.empty();
+}
+
+// Opcodes that only come about by the keyhole consuming loads in front of them, the pair is
+// never seen by pushOpcode().
+bool consumes_loads(const std::string &op) {
+	static const char *const prefixes[] = {"LL", "GG", "LG", "GL", "LS", "GS"};
+	for (const char *prefix : prefixes) {
+		if (starts_with(op, prefix) && op.size() > 2 && isupper(op[2])) {
+			return true;
+		}
+	}
+	return op.find("IndexHash") != std::string::npos || op.find("SkipLoad") != std::string::npos ||
+	       op.find("Values") != std::string::npos || starts_with(op, "IndexLocal") ||
+	       starts_with(op, "IndexGlobal") || starts_with(op, "IndexLiteral") || ends_with(op, "ToLocal") ||
+	       ends_with(op, "ToGlobal") || ends_with(op, "AndStoreLocal");
+}
+
+// What pushOpcode() sees of an opcode that is rewritten after it was pushed, empty when that
+// is not known.
+std::string as_pushed(const std::string &op, const std::set<std::string> &known) {
+	std::string ret = op;
+	if (consumes_loads(op)) {
+		return "";
+	}
+	if (ends_with(op, "AssignAndPop")) {
+		// the assignment is pushed, the pop folds into it
+		ret = op.substr(0, op.size() - strlen("AndPop"));
+	} else if (ends_with(op, "AndPop")) {
+		return "";
+	} else if (ends_with(op, "8") && known.count(op.substr(0, op.size() - 1))) {
+		// 8 bit branches are shortened once the jumps are resolved
+		ret = op.substr(0, op.size() - 1);
+		if (starts_with(ret, "CompareB")) {
+			// and the comparison became a branch when BZ was pushed
+			ret = "Compare" + ret.substr(strlen("CompareB"));
+		}
+	}
+	return known.count(ret) ? ret : "";
+}
+
+int usage() {
+	fprintf(stderr, "usage: wrench_super [--slots N] wrench.cpp profile.txt...\n"
+			"  --slots N  use at most N of the free opcodes\n"
+			"  the profiles must come from a build with WRENCH_NO_SUPERINSTRUCTIONS\n");
+	return 2;
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+	int slots = MAX_OPCODES;
+	int i = 1;
+	for (; i < argc && argv[i][0] == '-'; ++i) {
+		if (!strcmp(argv[i], "--slots") && i + 1 < argc) {
+			slots = atoi(argv[++i]);
+		} else {
+			return usage();
+		}
+	}
+	if (argc - i < 2) {
+		return usage();
+	}
+
+	std::vector<std::string> opcodes;
+	std::map<std::string, int> firsts;
+	if (!read_opcodes(argv[i], opcodes, firsts)) {
+		fprintf(stderr, "%s: no enum WROpcode\n", argv[i]);
+		return 1;
+	}
+	const std::set<std::string> known(opcodes.begin(), opcodes.end());
+	slots = std::max(0, std::min(slots, MAX_OPCODES - (int)opcodes.size()));
+
+	std::map<std::pair<std::string, std::string>, unsigned long long> counts;
+	for (++i; i < argc; ++i) {
+		std::vector<std::string> lines;
+		if (!read_lines(argv[i], lines)) {
+			fprintf(stderr, "%s: cannot read\n", argv[i]);
+			return 1;
+		}
+		for (const std::string &line : lines) {
+			char first[128], second[128];
+			unsigned long long n;
+			if (sscanf(line.c_str(), "pair %127s %127s %llu", first, second, &n) != 3) {
+				continue;
+			}
+			if (!known.count(first) || !known.count(second)) {
+				fprintf(stderr, "%s: unknown pair %s %s, profiled with superinstructions?\n", argv[i],
+						first, second);
+				return 1;
+			}
+			counts[{first, second}] += n;
+		}
+	}
+
+	std::vector<Pair> pairs;
+	for (const auto &c : counts) {
+		Pair p{c.first.first, c.first.second, as_pushed(c.first.second, known), c.second};
+		if (firsts.count(p.first) && !p.second_as_pushed.empty()) {
+			pairs.push_back(p);
+		}
+	}
+	std::stable_sort(pairs.begin(), pairs.end(), [](const Pair &a, const Pair &b) { return a.count > b.count; });
+
+	// One entry per keyhole match, the first one would always win.
+	std::vector<Pair> chosen;
+	std::set<std::pair<std::string, std::string>> matched;
+	for (const Pair &p : pairs) {
+		if ((int)chosen.size() < slots && matched.insert({p.first, p.second_as_pushed}).second) {
+			chosen.push_back(p);
+		}
+	}
+
+	printf("// Generated by bench/wrench_super.cpp, `make bench-super` regenerates it.\n");
+	printf("// %zu opcodes, %d free, pairs by count in the profiled corpus:\n", opcodes.size(),
+	       MAX_OPCODES - (int)opcodes.size());
+	for (const Pair &p : chosen) {
+		printf("//   %-32s %-32s %12llu\n", p.first.c_str(), p.second.c_str(), p.count);
+	}
+	printf("#define WRENCH_SUPERINSTRUCTIONS( X )");
+	for (const Pair &p : chosen) {
+		printf(" \\\n\tX( %s%s, %s, %s, %s )", p.first.c_str(), p.second.c_str(), p.first.c_str(),
+		       p.second_as_pushed.c_str(), p.second.c_str());
+	}
+	printf("\n");
+	return 0;
+}
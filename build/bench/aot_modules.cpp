@@ -0,0 +1,970 @@
+// Generated by wr_translate() from wrench bytecode with CRC 0x142D640C.
+// Built next to wrench.cpp with WRENCH_AOT defined, contexts created from
+// wr_aot_array_bytecode run these functions natively once wr_addNativeModule( w, &wr_aot_array )
+// is called
+#include "wrench.h"
+
+#ifdef WRENCH_AOT
+
+typedef void (*WRVoidFunc)( WRValue* to, WRValue* from );
+typedef void (*WRTargetFunc)( WRValue* to, WRValue* from, WRValue* target );
+typedef bool (*WRReturnFunc)( WRValue* to, WRValue* from );
+typedef void (*WRUnaryFunc)( WRValue* value );
+typedef bool (*WRReturnSingleFunc)( WRValue* value );
+extern WRTargetFunc wr_AdditionBinary[16];
+extern WRTargetFunc wr_SubtractBinary[16];
+extern WRTargetFunc wr_MultiplyBinary[16];
+extern WRTargetFunc wr_DivideBinary[16];
+extern WRTargetFunc wr_ModBinary[16];
+extern WRTargetFunc wr_LeftShiftBinary[16];
+extern WRTargetFunc wr_RightShiftBinary[16];
+extern WRTargetFunc wr_ANDBinary[16];
+extern WRTargetFunc wr_ORBinary[16];
+extern WRTargetFunc wr_XORBinary[16];
+extern WRVoidFunc wr_AddAssign[16];
+extern WRVoidFunc wr_SubtractAssign[16];
+extern WRVoidFunc wr_MultiplyAssign[16];
+extern WRVoidFunc wr_DivideAssign[16];
+extern WRVoidFunc wr_ModAssign[16];
+extern WRVoidFunc wr_LeftShiftAssign[16];
+extern WRVoidFunc wr_RightShiftAssign[16];
+extern WRVoidFunc wr_ANDAssign[16];
+extern WRVoidFunc wr_ORAssign[16];
+extern WRVoidFunc wr_XORAssign[16];
+extern WRVoidFunc wr_assign[16];
+extern WRReturnFunc wr_CompareEQ[16];
+extern WRReturnFunc wr_CompareLT[16];
+extern WRReturnFunc wr_CompareGT[16];
+extern WRUnaryFunc wr_preinc[4];
+extern WRUnaryFunc wr_predec[4];
+extern WRReturnSingleFunc wr_LogicalNot[4];
+
+//------------------------------------------------------------------------------
+static const WRNativeFunction wr_aot_array_functions[] =
+{
+	{ 0, 0 }, // 0x626EBEB9 left to the interpreter
+};
+
+extern const WRNativeModule wr_aot_array = { 0x142D640Cu, 1, wr_aot_array_functions };
+
+#endif
+
+extern const unsigned int wr_aot_array_bytecodeSize = 122;
+extern const unsigned char wr_aot_array_bytecode[] =
+{
+	0x01, 0x01, 0x01, 0x00, 0x00, 0x1B, 0x00, 0xB9, 0xBE, 0x6E, 0x62, 0x00, 0x06, 0x07, 0x56, 0xE9,
+	0xF5, 0xF8, 0x20, 0x00, 0xAF, 0x40, 0xF3, 0x11, 0x02, 0xEF, 0x14, 0xD2, 0x00, 0x00, 0xAF, 0x40,
+	0x71, 0x00, 0x17, 0x09, 0x22, 0x00, 0x00, 0x17, 0xAF, 0x65, 0x1F, 0x00, 0xAF, 0x25, 0x2B, 0x30,
+	0x1E, 0x02, 0x02, 0x95, 0xFB, 0x00, 0x37, 0xE7, 0x09, 0xD2, 0x01, 0x00, 0xD2, 0x02, 0x00, 0xAF,
+	0x28, 0x71, 0x02, 0x30, 0x09, 0x20, 0x00, 0x02, 0x16, 0x97, 0x03, 0xD2, 0x04, 0x01, 0x20, 0x00,
+	0x18, 0x1F, 0x04, 0xCA, 0x1A, 0x09, 0x22, 0x04, 0x00, 0x17, 0x97, 0x05, 0xAF, 0x01, 0xDC, 0x05,
+	0x03, 0x2E, 0x1F, 0x01, 0xA4, 0x1F, 0x05, 0x97, 0x03, 0xFB, 0x04, 0x37, 0xE2, 0x09, 0xFB, 0x02,
+	0x37, 0xCE, 0x09, 0x1F, 0x01, 0x13, 0x0C, 0x64, 0x2D, 0x14,
+};
+
+// Generated by wr_translate() from wrench bytecode with CRC 0x86F63E6D.
+// Built next to wrench.cpp with WRENCH_AOT defined, contexts created from
+// wr_aot_calls_bytecode run these functions natively once wr_addNativeModule( w, &wr_aot_calls )
+// is called
+#include "wrench.h"
+
+#ifdef WRENCH_AOT
+
+typedef void (*WRVoidFunc)( WRValue* to, WRValue* from );
+typedef void (*WRTargetFunc)( WRValue* to, WRValue* from, WRValue* target );
+typedef bool (*WRReturnFunc)( WRValue* to, WRValue* from );
+typedef void (*WRUnaryFunc)( WRValue* value );
+typedef bool (*WRReturnSingleFunc)( WRValue* value );
+extern WRTargetFunc wr_AdditionBinary[16];
+extern WRTargetFunc wr_SubtractBinary[16];
+extern WRTargetFunc wr_MultiplyBinary[16];
+extern WRTargetFunc wr_DivideBinary[16];
+extern WRTargetFunc wr_ModBinary[16];
+extern WRTargetFunc wr_LeftShiftBinary[16];
+extern WRTargetFunc wr_RightShiftBinary[16];
+extern WRTargetFunc wr_ANDBinary[16];
+extern WRTargetFunc wr_ORBinary[16];
+extern WRTargetFunc wr_XORBinary[16];
+extern WRVoidFunc wr_AddAssign[16];
+extern WRVoidFunc wr_SubtractAssign[16];
+extern WRVoidFunc wr_MultiplyAssign[16];
+extern WRVoidFunc wr_DivideAssign[16];
+extern WRVoidFunc wr_ModAssign[16];
+extern WRVoidFunc wr_LeftShiftAssign[16];
+extern WRVoidFunc wr_RightShiftAssign[16];
+extern WRVoidFunc wr_ANDAssign[16];
+extern WRVoidFunc wr_ORAssign[16];
+extern WRVoidFunc wr_XORAssign[16];
+extern WRVoidFunc wr_assign[16];
+extern WRReturnFunc wr_CompareEQ[16];
+extern WRReturnFunc wr_CompareLT[16];
+extern WRReturnFunc wr_CompareGT[16];
+extern WRUnaryFunc wr_preinc[4];
+extern WRUnaryFunc wr_predec[4];
+extern WRReturnSingleFunc wr_LogicalNot[4];
+
+//------------------------------------------------------------------------------
+static int wr_aot_calls_0( WRValue* s, WRValue* frameBase, WRValue* /*globalSpace*/, WRContext* /*context*/ )
+{
+	if ( frameBase[0].type == WR_INT && frameBase[1].type == WR_INT ) { if ( !(frameBase[0].i < frameBase[1].i) ) goto L8; }
+	else if ( frameBase[0].type == WR_FLOAT && frameBase[1].type == WR_FLOAT ) { if ( !(frameBase[0].f < frameBase[1].f) ) goto L8; }
+	else { if ( !wr_CompareLT[(frameBase[0].type<<2)|frameBase[1].type]( &frameBase[0], &frameBase[1] ) ) goto L8; }
+	s[0].p = frameBase + 1; s[0].p2 = WR_REF;
+	return 0;
+L8:
+	if ( frameBase[0].type == WR_INT && frameBase[2].type == WR_INT ) { if ( !(frameBase[0].i > frameBase[2].i) ) goto L16; }
+	else if ( frameBase[0].type == WR_FLOAT && frameBase[2].type == WR_FLOAT ) { if ( !(frameBase[0].f > frameBase[2].f) ) goto L16; }
+	else { if ( !wr_CompareGT[(frameBase[0].type<<2)|frameBase[2].type]( &frameBase[0], &frameBase[2] ) ) goto L16; }
+	s[0].p = frameBase + 2; s[0].p2 = WR_REF;
+	return 0;
+L16:
+	s[0].p = frameBase + 0; s[0].p2 = WR_REF;
+	return 0;
+}
+
+//------------------------------------------------------------------------------
+static int wr_aot_calls_1( WRValue* s, WRValue* frameBase, WRValue* /*globalSpace*/, WRContext* /*context*/ )
+{
+	s[0].p = frameBase + 0; s[0].p2 = WR_REF;
+	s[1].i = 3; s[1].p2 = WR_INT;
+	if ( frameBase[0].type == WR_INT ) { s[0].p2 = WR_INT; s[0].i = s[1].i * frameBase[0].i; }
+	else { wr_MultiplyBinary[(s[1].type<<2)|s[0].type]( &s[1], &s[0], &s[0] ); }
+	s[1].i = 4; s[1].p2 = WR_INT;
+	{ WRValue v; v = s[1]; s[1] = s[0]; s[0] = v; }
+	{ wr_DivideBinary[(s[1].type<<2)|s[0].type]( &s[1], &s[0], &s[0] ); }
+	s[1].i = 60; s[1].p2 = WR_INT;
+	{ WRValue v; v = s[1]; s[1] = s[0]; s[0] = v; }
+	if ( s[1].type == WR_INT ) { s[0].p2 = WR_INT; s[0].i = s[1].i + s[0].i; }
+	else { wr_AdditionBinary[(s[1].type<<2)|s[0].type]( &s[1], &s[0], &s[0] ); }
+	return 0;
+}
+
+//------------------------------------------------------------------------------
+static const WRNativeFunction wr_aot_calls_functions[] =
+{
+	{ wr_aot_calls_0, 1 }, // 0xA82EFCBC
+	{ wr_aot_calls_1, 2 }, // 0x82971C71
+	{ 0, 0 }, // 0x585E0593 left to the interpreter
+	{ 0, 0 }, // 0x626EBEB9 left to the interpreter
+};
+
+extern const WRNativeModule wr_aot_calls = { 0x86F63E6Du, 4, wr_aot_calls_functions };
+
+#endif
+
+extern const unsigned int wr_aot_calls_bytecodeSize = 181;
+extern const unsigned char wr_aot_calls_bytecode[] =
+{
+	0x00, 0x04, 0x01, 0x00, 0x00, 0x32, 0x00, 0xBC, 0xFC, 0x2E, 0xA8, 0x03, 0x03, 0x07, 0x00, 0x00,
+	0x45, 0x00, 0x71, 0x1C, 0x97, 0x82, 0x01, 0x01, 0x03, 0x00, 0x00, 0x55, 0x00, 0x93, 0x05, 0x5E,
+	0x58, 0x02, 0x02, 0x05, 0x00, 0x00, 0x71, 0x00, 0xB9, 0xBE, 0x6E, 0x62, 0x00, 0x02, 0x03, 0x02,
+	0xEF, 0x14, 0x7E, 0x01, 0x00, 0x05, 0x09, 0x1F, 0x01, 0x13, 0x80, 0x02, 0x00, 0x05, 0x09, 0x1F,
+	0x02, 0x13, 0x1F, 0x00, 0x13, 0x1F, 0x00, 0xAF, 0x03, 0x2B, 0xAF, 0x04, 0x1D, 0x02, 0x2D, 0xAF,
+	0x3C, 0x1D, 0x02, 0x34, 0x13, 0x02, 0x67, 0x00, 0x05, 0x09, 0x1F, 0x01, 0x13, 0xAF, 0x01, 0x1F,
+	0x00, 0x2C, 0x1F, 0x00, 0xAF, 0x07, 0x33, 0x1F, 0x01, 0x34, 0x07, 0x02, 0x02, 0x02, 0x58, 0x08,
+	0x13, 0xD2, 0x00, 0x00, 0xD2, 0x01, 0x00, 0xB0, 0xD0, 0x07, 0x71, 0x01, 0x32, 0x09, 0x1F, 0x01,
+	0xB0, 0xFF, 0x03, 0x33, 0x07, 0x01, 0x01, 0x02, 0x58, 0x08, 0xAF, 0x64, 0xB0, 0x58, 0x02, 0x07,
+	0x03, 0x00, 0x02, 0x58, 0x08, 0x1F, 0x00, 0xBB, 0x00, 0x1F, 0x01, 0xAF, 0x0F, 0x33, 0x02, 0x07,
+	0x02, 0x02, 0x02, 0x58, 0x08, 0x1F, 0x00, 0xBB, 0x00, 0xFB, 0x01, 0x37, 0xCB, 0x09, 0x1F, 0x00,
+	0x13, 0x6D, 0x3E, 0xF6, 0x86,
+};
+
+// Generated by wr_translate() from wrench bytecode with CRC 0x1B88BFA1.
+// Built next to wrench.cpp with WRENCH_AOT defined, contexts created from
+// wr_aot_constants_bytecode run these functions natively once wr_addNativeModule( w, &wr_aot_constants )
+// is called
+#include "wrench.h"
+
+#ifdef WRENCH_AOT
+
+typedef void (*WRVoidFunc)( WRValue* to, WRValue* from );
+typedef void (*WRTargetFunc)( WRValue* to, WRValue* from, WRValue* target );
+typedef bool (*WRReturnFunc)( WRValue* to, WRValue* from );
+typedef void (*WRUnaryFunc)( WRValue* value );
+typedef bool (*WRReturnSingleFunc)( WRValue* value );
+extern WRTargetFunc wr_AdditionBinary[16];
+extern WRTargetFunc wr_SubtractBinary[16];
+extern WRTargetFunc wr_MultiplyBinary[16];
+extern WRTargetFunc wr_DivideBinary[16];
+extern WRTargetFunc wr_ModBinary[16];
+extern WRTargetFunc wr_LeftShiftBinary[16];
+extern WRTargetFunc wr_RightShiftBinary[16];
+extern WRTargetFunc wr_ANDBinary[16];
+extern WRTargetFunc wr_ORBinary[16];
+extern WRTargetFunc wr_XORBinary[16];
+extern WRVoidFunc wr_AddAssign[16];
+extern WRVoidFunc wr_SubtractAssign[16];
+extern WRVoidFunc wr_MultiplyAssign[16];
+extern WRVoidFunc wr_DivideAssign[16];
+extern WRVoidFunc wr_ModAssign[16];
+extern WRVoidFunc wr_LeftShiftAssign[16];
+extern WRVoidFunc wr_RightShiftAssign[16];
+extern WRVoidFunc wr_ANDAssign[16];
+extern WRVoidFunc wr_ORAssign[16];
+extern WRVoidFunc wr_XORAssign[16];
+extern WRVoidFunc wr_assign[16];
+extern WRReturnFunc wr_CompareEQ[16];
+extern WRReturnFunc wr_CompareLT[16];
+extern WRReturnFunc wr_CompareGT[16];
+extern WRUnaryFunc wr_preinc[4];
+extern WRUnaryFunc wr_predec[4];
+extern WRReturnSingleFunc wr_LogicalNot[4];
+
+//------------------------------------------------------------------------------
+static int wr_aot_constants_0( WRValue* s, WRValue* frameBase, WRValue* /*globalSpace*/, WRContext* /*context*/ )
+{
+	frameBase[0].i = 0; frameBase[0].p2 = WR_INT;
+	frameBase[1].i = 0; frameBase[1].p2 = WR_INT;
+L6:
+	s[0].i = 5000; s[0].p2 = WR_INT;
+	if ( frameBase[1].type == WR_INT ) { if ( !(frameBase[1].i < s[0].i) ) goto L116; }
+	else { if ( !wr_CompareLT[(frameBase[1].type<<2)|s[0].type]( &frameBase[1], &s[0] ) ) goto L116; }
+	s[0].p = frameBase + 1; s[0].p2 = WR_REF;
+	s[1].i = 1023; s[1].p2 = WR_INT;
+	if ( frameBase[1].type == WR_INT ) { s[0].p2 = WR_INT; s[0].i = s[1].i & frameBase[1].i; }
+	else { wr_ANDBinary[(s[1].type<<2)|s[0].type]( &s[1], &s[0], &s[0] ); }
+	if ( frameBase[2].type <= WR_FLOAT && s[0].type <= WR_FLOAT ) { frameBase[2] = s[0]; }
+	else { wr_assign[(frameBase[2].type<<2)|s[0].type]( &frameBase[2], &s[0] ); }
+	s[0].i = 1000; s[0].p2 = WR_INT;
+	s[1].i = 3; s[1].p2 = WR_INT;
+	{ s[0].p2 = WR_INT; s[0].i = s[1].i * s[0].i; }
+	s[1].i = 4; s[1].p2 = WR_INT;
+	{ WRValue v; v = s[1]; s[1] = s[0]; s[0] = v; }
+	{ wr_DivideBinary[(s[1].type<<2)|s[0].type]( &s[1], &s[0], &frameBase[3] ); }
+	s[0].i = 60; s[0].p2 = WR_INT;
+	s[1].i = 60; s[1].p2 = WR_INT;
+	{ s[0].p2 = WR_INT; s[0].i = s[1].i * s[0].i; }
+	s[1].i = 3000; s[1].p2 = WR_INT;
+	{ WRValue v; v = s[1]; s[1] = s[0]; s[0] = v; }
+	{ frameBase[4].p2 = WR_INT; frameBase[4].i = s[1].i - s[0].i; }
+	s[0].p = frameBase + 2; s[0].p2 = WR_REF;
+	s[1].p = frameBase + 3; s[1].p2 = WR_REF;
+	if ( frameBase[3].type == WR_INT && frameBase[2].type == WR_INT ) { s[0].p2 = WR_INT; s[0].i = frameBase[3].i * frameBase[2].i; }
+	else if ( frameBase[3].type == WR_FLOAT && frameBase[2].type == WR_FLOAT ) { s[0].p2 = WR_FLOAT; s[0].f = frameBase[3].f * frameBase[2].f; }
+	else { wr_MultiplyBinary[(s[1].type<<2)|s[0].type]( &s[1], &s[0], &s[0] ); }
+	s[1].i = 1024; s[1].p2 = WR_INT;
+	{ WRValue v; v = s[1]; s[1] = s[0]; s[0] = v; }
+	{ wr_DivideBinary[(s[1].type<<2)|s[0].type]( &s[1], &s[0], &s[0] ); }
+	s[1].p = frameBase + 4; s[1].p2 = WR_REF;
+	{ WRValue v; v = s[1]; s[1] = s[0]; s[0] = v; }
+	if ( s[1].type == WR_INT && frameBase[4].type == WR_INT ) { frameBase[5].p2 = WR_INT; frameBase[5].i = s[1].i + frameBase[4].i; }
+	else if ( s[1].type == WR_FLOAT && frameBase[4].type == WR_FLOAT ) { frameBase[5].p2 = WR_FLOAT; frameBase[5].f = s[1].f + frameBase[4].f; }
+	else { wr_AdditionBinary[(s[1].type<<2)|s[0].type]( &s[1], &s[0], &frameBase[5] ); }
+	s[0].p = frameBase + 5; s[0].p2 = WR_REF;
+	if ( frameBase[6].type <= WR_FLOAT && frameBase[5].type <= WR_FLOAT ) { frameBase[6] = frameBase[5]; }
+	else { wr_assign[(frameBase[6].type<<2)|s[0].type]( &frameBase[6], &s[0] ); }
+	s[0].p = 0; s[0].p2 = WR_INT;
+	{ if ( !s[0].i ) goto L75; }
+	if ( frameBase[0].type == WR_INT && frameBase[6].type == WR_INT ) { s[0].p2 = WR_INT; s[0].i = frameBase[0].i - frameBase[6].i; }
+	else if ( frameBase[0].type == WR_FLOAT && frameBase[6].type == WR_FLOAT ) { s[0].p2 = WR_FLOAT; s[0].f = frameBase[0].f - frameBase[6].f; }
+	else { wr_SubtractBinary[(frameBase[0].type<<2)|frameBase[6].type]( &frameBase[0], &frameBase[6], &s[0] ); }
+	if ( frameBase[0].type <= WR_FLOAT && s[0].type <= WR_FLOAT ) { frameBase[0] = s[0]; }
+	else { wr_assign[(frameBase[0].type<<2)|s[0].type]( &frameBase[0], &s[0] ); }
+L75:
+	s[0].i = 2; s[0].p2 = WR_INT;
+	s[1].i = 16; s[1].p2 = WR_INT;
+	{ s[0].p2 = WR_INT; s[0].i = s[1].i >> s[0].i; }
+	s[1].i = 3; s[1].p2 = WR_INT;
+	{ if ( !(s[1].i < s[0].i) ) goto L100; }
+	s[0].i = 1; s[0].p2 = WR_INT;
+	s[1].i = 1; s[1].p2 = WR_INT;
+	{ s[0].p2 = WR_INT; s[0].i = s[1].i + s[0].i; }
+	s[1].p = frameBase + 6; s[1].p2 = WR_REF;
+	if ( frameBase[6].type == WR_INT ) { s[0].p2 = WR_INT; s[0].i = frameBase[6].i >> s[0].i; }
+	else { wr_RightShiftBinary[(s[1].type<<2)|s[0].type]( &s[1], &s[0], &s[0] ); }
+	s[1].p = frameBase + 0; s[1].p2 = WR_REF;
+	if ( frameBase[0].type == WR_INT && s[0].type == WR_INT ) { frameBase[0].p2 = WR_INT; frameBase[0].i = frameBase[0].i + s[0].i; }
+	else if ( frameBase[0].type == WR_FLOAT && s[0].type == WR_FLOAT ) { frameBase[0].p2 = WR_FLOAT; frameBase[0].f = frameBase[0].f + s[0].f; }
+	else { wr_AdditionBinary[(s[1].type<<2)|s[0].type]( &s[1], &s[0], &frameBase[0] ); }
+	goto L105;
+L100:
+	if ( frameBase[0].type == WR_INT && frameBase[6].type == WR_INT ) { s[0].p2 = WR_INT; s[0].i = frameBase[0].i + frameBase[6].i; }
+	else if ( frameBase[0].type == WR_FLOAT && frameBase[6].type == WR_FLOAT ) { s[0].p2 = WR_FLOAT; s[0].f = frameBase[0].f + frameBase[6].f; }
+	else { wr_AdditionBinary[(frameBase[0].type<<2)|frameBase[6].type]( &frameBase[0], &frameBase[6], &s[0] ); }
+	if ( frameBase[0].type <= WR_FLOAT && s[0].type <= WR_FLOAT ) { frameBase[0] = s[0]; }
+	else { wr_assign[(frameBase[0].type<<2)|s[0].type]( &frameBase[0], &s[0] ); }
+L105:
+	s[0].p = frameBase + 6; s[0].p2 = WR_REF;
+	s[1].i = 2; s[1].p2 = WR_INT;
+	if ( frameBase[6].type == WR_INT ) { frameBase[7].p2 = WR_INT; frameBase[7].i = s[1].i * frameBase[6].i; }
+	else { wr_MultiplyBinary[(s[1].type<<2)|s[0].type]( &s[1], &s[0], &frameBase[7] ); }
+	if ( frameBase[1].type == WR_INT ) { ++frameBase[1].i; } else { wr_preinc[frameBase[1].type]( &frameBase[1] ); }
+	goto L6;
+L116:
+	s[0].p = frameBase + 0; s[0].p2 = WR_REF;
+	return 0;
+}
+
+//------------------------------------------------------------------------------
+static const WRNativeFunction wr_aot_constants_functions[] =
+{
+	{ wr_aot_constants_0, 2 }, // 0x626EBEB9
+};
+
+extern const WRNativeModule wr_aot_constants = { 0x1B88BFA1u, 1, wr_aot_constants_functions };
+
+#endif
+
+extern const unsigned int wr_aot_constants_bytecodeSize = 143;
+extern const unsigned char wr_aot_constants_bytecode[] =
+{
+	0x00, 0x01, 0x01, 0x00, 0x00, 0x11, 0x00, 0xB9, 0xBE, 0x6E, 0x62, 0x00, 0x08, 0x09, 0x02, 0xEF,
+	0x14, 0xD2, 0x00, 0x00, 0xD2, 0x01, 0x00, 0xB0, 0x88, 0x13, 0x71, 0x01, 0x69, 0x09, 0x1F, 0x01,
+	0xB0, 0xFF, 0x03, 0x33, 0x97, 0x02, 0xB0, 0xE8, 0x03, 0xAF, 0x03, 0x2B, 0xAF, 0x04, 0x1D, 0x02,
+	0xBE, 0x03, 0xAF, 0x3C, 0xAF, 0x3C, 0x2B, 0xB0, 0xB8, 0x0B, 0x1D, 0x02, 0xBC, 0x04, 0x1F, 0x02,
+	0x1F, 0x03, 0x2B, 0xB0, 0x00, 0x04, 0x1D, 0x02, 0x2D, 0x1F, 0x04, 0x1D, 0x02, 0xBB, 0x05, 0x1F,
+	0x05, 0x97, 0x06, 0x02, 0x39, 0x07, 0x09, 0xE0, 0x06, 0x00, 0x97, 0x00, 0xAF, 0x02, 0xAF, 0x10,
+	0x2E, 0xAF, 0x03, 0xCA, 0x11, 0x09, 0xAF, 0x01, 0xAF, 0x01, 0x34, 0x1F, 0x06, 0x2E, 0x1F, 0x00,
+	0xBB, 0x00, 0x37, 0x07, 0x09, 0xDC, 0x06, 0x00, 0x97, 0x00, 0x1F, 0x06, 0xAF, 0x02, 0xBD, 0x07,
+	0xFB, 0x01, 0x37, 0x94, 0x09, 0x1F, 0x00, 0x13, 0xD2, 0x00, 0x00, 0xA1, 0xBF, 0x88, 0x1B,
+};
+
+// Generated by wr_translate() from wrench bytecode with CRC 0x1C75C878.
+// Built next to wrench.cpp with WRENCH_AOT defined, contexts created from
+// wr_aot_float_math_bytecode run these functions natively once wr_addNativeModule( w, &wr_aot_float_math )
+// is called
+#include "wrench.h"
+
+#ifdef WRENCH_AOT
+
+typedef void (*WRVoidFunc)( WRValue* to, WRValue* from );
+typedef void (*WRTargetFunc)( WRValue* to, WRValue* from, WRValue* target );
+typedef bool (*WRReturnFunc)( WRValue* to, WRValue* from );
+typedef void (*WRUnaryFunc)( WRValue* value );
+typedef bool (*WRReturnSingleFunc)( WRValue* value );
+extern WRTargetFunc wr_AdditionBinary[16];
+extern WRTargetFunc wr_SubtractBinary[16];
+extern WRTargetFunc wr_MultiplyBinary[16];
+extern WRTargetFunc wr_DivideBinary[16];
+extern WRTargetFunc wr_ModBinary[16];
+extern WRTargetFunc wr_LeftShiftBinary[16];
+extern WRTargetFunc wr_RightShiftBinary[16];
+extern WRTargetFunc wr_ANDBinary[16];
+extern WRTargetFunc wr_ORBinary[16];
+extern WRTargetFunc wr_XORBinary[16];
+extern WRVoidFunc wr_AddAssign[16];
+extern WRVoidFunc wr_SubtractAssign[16];
+extern WRVoidFunc wr_MultiplyAssign[16];
+extern WRVoidFunc wr_DivideAssign[16];
+extern WRVoidFunc wr_ModAssign[16];
+extern WRVoidFunc wr_LeftShiftAssign[16];
+extern WRVoidFunc wr_RightShiftAssign[16];
+extern WRVoidFunc wr_ANDAssign[16];
+extern WRVoidFunc wr_ORAssign[16];
+extern WRVoidFunc wr_XORAssign[16];
+extern WRVoidFunc wr_assign[16];
+extern WRReturnFunc wr_CompareEQ[16];
+extern WRReturnFunc wr_CompareLT[16];
+extern WRReturnFunc wr_CompareGT[16];
+extern WRUnaryFunc wr_preinc[4];
+extern WRUnaryFunc wr_predec[4];
+extern WRReturnSingleFunc wr_LogicalNot[4];
+
+//------------------------------------------------------------------------------
+static int wr_aot_float_math_0( WRValue* s, WRValue* frameBase, WRValue* /*globalSpace*/, WRContext* /*context*/ )
+{
+	frameBase[0].ui = 0x3F000000u; frameBase[0].p2 = WR_FLOAT; // 0.5
+	frameBase[1].ui = 0x00000000u; frameBase[1].p2 = WR_FLOAT; // 0
+	frameBase[2].i = 0; frameBase[2].p2 = WR_INT;
+L15:
+	s[0].i = 10000; s[0].p2 = WR_INT;
+	if ( frameBase[2].type == WR_INT ) { if ( !(frameBase[2].i < s[0].i) ) goto L76; }
+	else { if ( !wr_CompareLT[(frameBase[2].type<<2)|s[0].type]( &frameBase[2], &s[0] ) ) goto L76; }
+	s[0].p = frameBase + 0; s[0].p2 = WR_REF;
+	s[1].ui = 0x3F800347u; s[1].p2 = WR_FLOAT; // 1.0001
+	if ( frameBase[0].type == WR_FLOAT ) { s[0].p2 = WR_FLOAT; s[0].f = s[1].f * frameBase[0].f; }
+	else { wr_MultiplyBinary[(s[1].type<<2)|s[0].type]( &s[1], &s[0], &s[0] ); }
+	s[1].ui = 0x3E800000u; s[1].p2 = WR_FLOAT; // 0.25
+	{ WRValue v; v = s[1]; s[1] = s[0]; s[0] = v; }
+	if ( s[1].type == WR_FLOAT ) { frameBase[0].p2 = WR_FLOAT; frameBase[0].f = s[1].f + s[0].f; }
+	else { wr_AdditionBinary[(s[1].type<<2)|s[0].type]( &s[1], &s[0], &frameBase[0] ); }
+	s[0].ui = 0x3FC00000u; s[0].p2 = WR_FLOAT; // 1.5
+	s[1].p = frameBase + 2; s[1].p2 = WR_REF;
+	if ( frameBase[2].type == WR_FLOAT ) { s[0].p2 = WR_FLOAT; s[0].f = frameBase[2].f + s[0].f; }
+	else { wr_AdditionBinary[(s[1].type<<2)|s[0].type]( &s[1], &s[0], &s[0] ); }
+	s[1].p = frameBase + 0; s[1].p2 = WR_REF;
+	if ( frameBase[0].type == WR_FLOAT && s[0].type == WR_FLOAT ) { s[0].p2 = WR_FLOAT; s[0].f = frameBase[0].f / s[0].f; }
+	else { wr_DivideBinary[(s[1].type<<2)|s[0].type]( &s[1], &s[0], &s[0] ); }
+	s[1].p = frameBase + 1; s[1].p2 = WR_REF;
+	if ( frameBase[1].type == WR_INT && s[0].type == WR_INT ) { frameBase[1].i += s[0].i; }
+	else if ( frameBase[1].type == WR_FLOAT && s[0].type == WR_FLOAT ) { frameBase[1].f += s[0].f; }
+	else { wr_AddAssign[(s[1].type<<2)|s[0].type]( &s[1], &s[0] ); }
+	s[0].ui = 0x447A0000u; s[0].p2 = WR_FLOAT; // 1000
+	if ( frameBase[0].type == WR_FLOAT ) { if ( !(frameBase[0].f > s[0].f) ) goto L71; }
+	else { if ( !wr_CompareGT[(frameBase[0].type<<2)|s[0].type]( &frameBase[0], &s[0] ) ) goto L71; }
+	s[0].ui = 0x4479C000u; s[0].p2 = WR_FLOAT; // 999
+	s[1].p = frameBase + 0; s[1].p2 = WR_REF;
+	if ( frameBase[0].type == WR_FLOAT ) { frameBase[0].p2 = WR_FLOAT; frameBase[0].f = frameBase[0].f - s[0].f; }
+	else { wr_SubtractBinary[(s[1].type<<2)|s[0].type]( &s[1], &s[0], &frameBase[0] ); }
+L71:
+	if ( frameBase[2].type == WR_INT ) { ++frameBase[2].i; } else { wr_preinc[frameBase[2].type]( &frameBase[2] ); }
+	goto L15;
+L76:
+	s[0].p = frameBase + 1; s[0].p2 = WR_REF;
+	s[1].ui = 0x447A0000u; s[1].p2 = WR_FLOAT; // 1000
+	if ( frameBase[1].type == WR_FLOAT ) { s[0].p2 = WR_FLOAT; s[0].f = s[1].f * frameBase[1].f; }
+	else { wr_MultiplyBinary[(s[1].type<<2)|s[0].type]( &s[1], &s[0], &s[0] ); }
+	s[0].i = s[0].asInt(); s[0].p2 = WR_INT;
+	return 0;
+}
+
+//------------------------------------------------------------------------------
+static const WRNativeFunction wr_aot_float_math_functions[] =
+{
+	{ wr_aot_float_math_0, 2 }, // 0x626EBEB9
+};
+
+extern const WRNativeModule wr_aot_float_math = { 0x1C75C878u, 1, wr_aot_float_math_functions };
+
+#endif
+
+extern const unsigned int wr_aot_float_math_bytecodeSize = 107;
+extern const unsigned char wr_aot_float_math_bytecode[] =
+{
+	0x00, 0x01, 0x01, 0x00, 0x00, 0x11, 0x00, 0xB9, 0xBE, 0x6E, 0x62, 0x00, 0x03, 0x04, 0x02, 0xEF,
+	0x14, 0xD5, 0x00, 0x00, 0x00, 0x00, 0x3F, 0xD5, 0x01, 0x00, 0x00, 0x00, 0x00, 0xD2, 0x02, 0x00,
+	0xB0, 0x10, 0x27, 0x71, 0x02, 0x38, 0x09, 0x1F, 0x00, 0x03, 0x47, 0x03, 0x80, 0x3F, 0x2B, 0x03,
+	0x00, 0x00, 0x80, 0x3E, 0x1D, 0x02, 0xBB, 0x00, 0x03, 0x00, 0x00, 0xC0, 0x3F, 0x1F, 0x02, 0x34,
+	0x1F, 0x00, 0x2D, 0x1F, 0x01, 0xA4, 0x03, 0x00, 0x00, 0x7A, 0x44, 0x6F, 0x00, 0x0B, 0x09, 0x03,
+	0x00, 0xC0, 0x79, 0x44, 0x1F, 0x00, 0xBC, 0x00, 0xFB, 0x02, 0x37, 0xC5, 0x09, 0x1F, 0x01, 0x03,
+	0x00, 0x00, 0x7A, 0x44, 0x2B, 0xF0, 0x13, 0x78, 0xC8, 0x75, 0x1C,
+};
+
+// Generated by wr_translate() from wrench bytecode with CRC 0xFA7E0A37.
+// Built next to wrench.cpp with WRENCH_AOT defined, contexts created from
+// wr_aot_hash_bytecode run these functions natively once wr_addNativeModule( w, &wr_aot_hash )
+// is called
+#include "wrench.h"
+
+#ifdef WRENCH_AOT
+
+typedef void (*WRVoidFunc)( WRValue* to, WRValue* from );
+typedef void (*WRTargetFunc)( WRValue* to, WRValue* from, WRValue* target );
+typedef bool (*WRReturnFunc)( WRValue* to, WRValue* from );
+typedef void (*WRUnaryFunc)( WRValue* value );
+typedef bool (*WRReturnSingleFunc)( WRValue* value );
+extern WRTargetFunc wr_AdditionBinary[16];
+extern WRTargetFunc wr_SubtractBinary[16];
+extern WRTargetFunc wr_MultiplyBinary[16];
+extern WRTargetFunc wr_DivideBinary[16];
+extern WRTargetFunc wr_ModBinary[16];
+extern WRTargetFunc wr_LeftShiftBinary[16];
+extern WRTargetFunc wr_RightShiftBinary[16];
+extern WRTargetFunc wr_ANDBinary[16];
+extern WRTargetFunc wr_ORBinary[16];
+extern WRTargetFunc wr_XORBinary[16];
+extern WRVoidFunc wr_AddAssign[16];
+extern WRVoidFunc wr_SubtractAssign[16];
+extern WRVoidFunc wr_MultiplyAssign[16];
+extern WRVoidFunc wr_DivideAssign[16];
+extern WRVoidFunc wr_ModAssign[16];
+extern WRVoidFunc wr_LeftShiftAssign[16];
+extern WRVoidFunc wr_RightShiftAssign[16];
+extern WRVoidFunc wr_ANDAssign[16];
+extern WRVoidFunc wr_ORAssign[16];
+extern WRVoidFunc wr_XORAssign[16];
+extern WRVoidFunc wr_assign[16];
+extern WRReturnFunc wr_CompareEQ[16];
+extern WRReturnFunc wr_CompareLT[16];
+extern WRReturnFunc wr_CompareGT[16];
+extern WRUnaryFunc wr_preinc[4];
+extern WRUnaryFunc wr_predec[4];
+extern WRReturnSingleFunc wr_LogicalNot[4];
+
+//------------------------------------------------------------------------------
+static int wr_aot_hash_0( WRValue* s, WRValue* /*frameBase*/, WRValue* /*globalSpace*/, WRContext* /*context*/ )
+{
+	s[0].init();
+	return 0;
+}
+
+//------------------------------------------------------------------------------
+static const WRNativeFunction wr_aot_hash_functions[] =
+{
+	{ wr_aot_hash_0, 0 }, // 0xEAA8EF31
+	{ 0, 0 }, // 0x626EBEB9 left to the interpreter
+};
+
+extern const WRNativeModule wr_aot_hash = { 0xFA7E0A37u, 2, wr_aot_hash_functions };
+
+#endif
+
+extern const unsigned int wr_aot_hash_bytecodeSize = 236;
+extern const unsigned char wr_aot_hash_bytecode[] =
+{
+	0x00, 0x02, 0x01, 0x1C, 0x00, 0x2A, 0x00, 0x31, 0xEF, 0xA8, 0xEA, 0x00, 0x02, 0x03, 0x00, 0x00,
+	0x2B, 0x00, 0xB9, 0xBE, 0x6E, 0x62, 0x00, 0x07, 0x08, 0x02, 0xEF, 0x14, 0x02, 0x00, 0x02, 0x00,
+	0xF4, 0x4E, 0x0C, 0xFC, 0x01, 0x87, 0x50, 0x0C, 0xFD, 0x00, 0x12, 0x02, 0x02, 0x02, 0x0E, 0x97,
+	0x00, 0xD2, 0x01, 0x00, 0xB0, 0xF4, 0x01, 0x71, 0x01, 0x14, 0x09, 0x21, 0x01, 0x00, 0x17, 0x1F,
+	0x01, 0xAF, 0x02, 0x2B, 0x1E, 0x02, 0x02, 0x95, 0xFB, 0x01, 0x37, 0xE9, 0x09, 0xD2, 0x02, 0x00,
+	0xD2, 0x03, 0x00, 0xAF, 0x04, 0x71, 0x03, 0x1D, 0x09, 0xD2, 0x04, 0x00, 0xB0, 0xF4, 0x01, 0x71,
+	0x04, 0x0E, 0x09, 0x21, 0x04, 0x00, 0x17, 0x1F, 0x02, 0xA4, 0xFB, 0x04, 0x37, 0xEF, 0x09, 0xFB,
+	0x03, 0x37, 0xE1, 0x09, 0x07, 0x00, 0x00, 0x03, 0x58, 0x58, 0x0B, 0x1C, 0x00, 0x97, 0x05, 0x1C,
+	0x05, 0x87, 0x50, 0x0C, 0xFD, 0xAF, 0x01, 0x1D, 0x02, 0x95, 0x1C, 0x05, 0xF4, 0x4E, 0x0C, 0xFC,
+	0xAF, 0x02, 0x1D, 0x02, 0x95, 0xD2, 0x06, 0x00, 0xB0, 0xD0, 0x07, 0x71, 0x06, 0x48, 0x09, 0x1C,
+	0x05, 0x87, 0x50, 0x0C, 0xFD, 0x1C, 0x05, 0x87, 0x50, 0x0C, 0xFD, 0x1C, 0x05, 0xF4, 0x4E, 0x0C,
+	0xFC, 0x1E, 0x02, 0x02, 0x34, 0x1E, 0x02, 0x02, 0x95, 0x1C, 0x05, 0xF4, 0x4E, 0x0C, 0xFC, 0x1C,
+	0x05, 0x87, 0x50, 0x0C, 0xFD, 0x1C, 0x05, 0xF4, 0x4E, 0x0C, 0xFC, 0x1E, 0x02, 0x02, 0x2C, 0x1E,
+	0x02, 0x02, 0x95, 0x1C, 0x05, 0xF4, 0x4E, 0x0C, 0xFC, 0xB0, 0xFF, 0x00, 0x33, 0x1F, 0x02, 0xA4,
+	0xFB, 0x06, 0x37, 0xB5, 0x09, 0x1F, 0x02, 0x13, 0x37, 0x0A, 0x7E, 0xFA,
+};
+
+// Generated by wr_translate() from wrench bytecode with CRC 0x35522B60.
+// Built next to wrench.cpp with WRENCH_AOT defined, contexts created from
+// wr_aot_int_loop_bytecode run these functions natively once wr_addNativeModule( w, &wr_aot_int_loop )
+// is called
+#include "wrench.h"
+
+#ifdef WRENCH_AOT
+
+typedef void (*WRVoidFunc)( WRValue* to, WRValue* from );
+typedef void (*WRTargetFunc)( WRValue* to, WRValue* from, WRValue* target );
+typedef bool (*WRReturnFunc)( WRValue* to, WRValue* from );
+typedef void (*WRUnaryFunc)( WRValue* value );
+typedef bool (*WRReturnSingleFunc)( WRValue* value );
+extern WRTargetFunc wr_AdditionBinary[16];
+extern WRTargetFunc wr_SubtractBinary[16];
+extern WRTargetFunc wr_MultiplyBinary[16];
+extern WRTargetFunc wr_DivideBinary[16];
+extern WRTargetFunc wr_ModBinary[16];
+extern WRTargetFunc wr_LeftShiftBinary[16];
+extern WRTargetFunc wr_RightShiftBinary[16];
+extern WRTargetFunc wr_ANDBinary[16];
+extern WRTargetFunc wr_ORBinary[16];
+extern WRTargetFunc wr_XORBinary[16];
+extern WRVoidFunc wr_AddAssign[16];
+extern WRVoidFunc wr_SubtractAssign[16];
+extern WRVoidFunc wr_MultiplyAssign[16];
+extern WRVoidFunc wr_DivideAssign[16];
+extern WRVoidFunc wr_ModAssign[16];
+extern WRVoidFunc wr_LeftShiftAssign[16];
+extern WRVoidFunc wr_RightShiftAssign[16];
+extern WRVoidFunc wr_ANDAssign[16];
+extern WRVoidFunc wr_ORAssign[16];
+extern WRVoidFunc wr_XORAssign[16];
+extern WRVoidFunc wr_assign[16];
+extern WRReturnFunc wr_CompareEQ[16];
+extern WRReturnFunc wr_CompareLT[16];
+extern WRReturnFunc wr_CompareGT[16];
+extern WRUnaryFunc wr_preinc[4];
+extern WRUnaryFunc wr_predec[4];
+extern WRReturnSingleFunc wr_LogicalNot[4];
+
+//------------------------------------------------------------------------------
+static int wr_aot_int_loop_0( WRValue* s, WRValue* frameBase, WRValue* /*globalSpace*/, WRContext* /*context*/ )
+{
+	frameBase[0].i = 0; frameBase[0].p2 = WR_INT;
+	frameBase[1].i = 0; frameBase[1].p2 = WR_INT;
+L6:
+	s[0].i = 20000; s[0].p2 = WR_INT;
+	if ( frameBase[1].type == WR_INT ) { if ( !(frameBase[1].i < s[0].i) ) goto L50; }
+	else { if ( !wr_CompareLT[(frameBase[1].type<<2)|s[0].type]( &frameBase[1], &s[0] ) ) goto L50; }
+	s[0].p = frameBase + 1; s[0].p2 = WR_REF;
+	s[1].i = 3; s[1].p2 = WR_INT;
+	if ( frameBase[1].type == WR_INT ) { s[0].p2 = WR_INT; s[0].i = s[1].i * frameBase[1].i; }
+	else { wr_MultiplyBinary[(s[1].type<<2)|s[0].type]( &s[1], &s[0], &s[0] ); }
+	s[1].p = frameBase + 0; s[1].p2 = WR_REF;
+	if ( frameBase[0].type == WR_INT && s[0].type == WR_INT ) { s[0].p2 = WR_INT; s[0].i = frameBase[0].i + s[0].i; }
+	else if ( frameBase[0].type == WR_FLOAT && s[0].type == WR_FLOAT ) { s[0].p2 = WR_FLOAT; s[0].f = frameBase[0].f + s[0].f; }
+	else { wr_AdditionBinary[(s[1].type<<2)|s[0].type]( &s[1], &s[0], &s[0] ); }
+	s[1].i = 1; s[1].p2 = WR_INT;
+	s[2].p = frameBase + 1; s[2].p2 = WR_REF;
+	if ( frameBase[1].type == WR_INT ) { s[1].p2 = WR_INT; s[1].i = frameBase[1].i >> s[1].i; }
+	else { wr_RightShiftBinary[(s[2].type<<2)|s[1].type]( &s[2], &s[1], &s[1] ); }
+	{ WRValue v; v = s[1]; s[1] = s[0]; s[0] = v; }
+	if ( s[1].type == WR_INT && s[0].type == WR_INT ) { frameBase[0].p2 = WR_INT; frameBase[0].i = s[1].i - s[0].i; }
+	else if ( s[1].type == WR_FLOAT && s[0].type == WR_FLOAT ) { frameBase[0].p2 = WR_FLOAT; frameBase[0].f = s[1].f - s[0].f; }
+	else { wr_SubtractBinary[(s[1].type<<2)|s[0].type]( &s[1], &s[0], &frameBase[0] ); }
+	s[0].p = frameBase + 1; s[0].p2 = WR_REF;
+	s[1].i = 7; s[1].p2 = WR_INT;
+	if ( frameBase[1].type == WR_INT ) { s[0].p2 = WR_INT; s[0].i = s[1].i & frameBase[1].i; }
+	else { wr_ANDBinary[(s[1].type<<2)|s[0].type]( &s[1], &s[0], &s[0] ); }
+	s[1].i = 3; s[1].p2 = WR_INT;
+	if ( s[0].type == WR_INT ) { if ( !(s[1].i == s[0].i) ) goto L45; }
+	else { if ( !wr_CompareEQ[(s[1].type<<2)|s[0].type]( &s[1], &s[0] ) ) goto L45; }
+	s[0].p = frameBase + 1; s[0].p2 = WR_REF;
+	s[1].p = frameBase + 0; s[1].p2 = WR_REF;
+	if ( frameBase[0].type == WR_INT && frameBase[1].type == WR_INT ) { frameBase[0].i ^= frameBase[1].i; }
+	else { wr_XORAssign[(s[1].type<<2)|s[0].type]( &s[1], &s[0] ); }
+L45:
+	if ( frameBase[1].type == WR_INT ) { ++frameBase[1].i; } else { wr_preinc[frameBase[1].type]( &frameBase[1] ); }
+	goto L6;
+L50:
+	s[0].p = frameBase + 0; s[0].p2 = WR_REF;
+	return 0;
+}
+
+//------------------------------------------------------------------------------
+static const WRNativeFunction wr_aot_int_loop_functions[] =
+{
+	{ wr_aot_int_loop_0, 3 }, // 0x626EBEB9
+};
+
+extern const WRNativeModule wr_aot_int_loop = { 0x35522B60u, 1, wr_aot_int_loop_functions };
+
+#endif
+
+extern const unsigned int wr_aot_int_loop_bytecodeSize = 74;
+extern const unsigned char wr_aot_int_loop_bytecode[] =
+{
+	0x00, 0x01, 0x01, 0x00, 0x00, 0x11, 0x00, 0xB9, 0xBE, 0x6E, 0x62, 0x00, 0x02, 0x03, 0x02, 0xEF,
+	0x14, 0xD2, 0x00, 0x00, 0xD2, 0x01, 0x00, 0xB0, 0x20, 0x4E, 0x71, 0x01, 0x27, 0x09, 0x1F, 0x01,
+	0xAF, 0x03, 0x2B, 0x1F, 0x00, 0x34, 0xAF, 0x01, 0x1F, 0x01, 0x2E, 0x1D, 0x02, 0xBC, 0x00, 0x1F,
+	0x01, 0xAF, 0x07, 0x33, 0xAF, 0x03, 0xC5, 0x07, 0x09, 0x1F, 0x01, 0x1F, 0x00, 0xAA, 0xFB, 0x01,
+	0x37, 0xD6, 0x09, 0x1F, 0x00, 0x13, 0x60, 0x2B, 0x52, 0x35,
+};
+
+// Generated by wr_translate() from wrench bytecode with CRC 0xF85F7A92.
+// Built next to wrench.cpp with WRENCH_AOT defined, contexts created from
+// wr_aot_libcall_bytecode run these functions natively once wr_addNativeModule( w, &wr_aot_libcall )
+// is called
+#include "wrench.h"
+
+#ifdef WRENCH_AOT
+
+typedef void (*WRVoidFunc)( WRValue* to, WRValue* from );
+typedef void (*WRTargetFunc)( WRValue* to, WRValue* from, WRValue* target );
+typedef bool (*WRReturnFunc)( WRValue* to, WRValue* from );
+typedef void (*WRUnaryFunc)( WRValue* value );
+typedef bool (*WRReturnSingleFunc)( WRValue* value );
+extern WRTargetFunc wr_AdditionBinary[16];
+extern WRTargetFunc wr_SubtractBinary[16];
+extern WRTargetFunc wr_MultiplyBinary[16];
+extern WRTargetFunc wr_DivideBinary[16];
+extern WRTargetFunc wr_ModBinary[16];
+extern WRTargetFunc wr_LeftShiftBinary[16];
+extern WRTargetFunc wr_RightShiftBinary[16];
+extern WRTargetFunc wr_ANDBinary[16];
+extern WRTargetFunc wr_ORBinary[16];
+extern WRTargetFunc wr_XORBinary[16];
+extern WRVoidFunc wr_AddAssign[16];
+extern WRVoidFunc wr_SubtractAssign[16];
+extern WRVoidFunc wr_MultiplyAssign[16];
+extern WRVoidFunc wr_DivideAssign[16];
+extern WRVoidFunc wr_ModAssign[16];
+extern WRVoidFunc wr_LeftShiftAssign[16];
+extern WRVoidFunc wr_RightShiftAssign[16];
+extern WRVoidFunc wr_ANDAssign[16];
+extern WRVoidFunc wr_ORAssign[16];
+extern WRVoidFunc wr_XORAssign[16];
+extern WRVoidFunc wr_assign[16];
+extern WRReturnFunc wr_CompareEQ[16];
+extern WRReturnFunc wr_CompareLT[16];
+extern WRReturnFunc wr_CompareGT[16];
+extern WRUnaryFunc wr_preinc[4];
+extern WRUnaryFunc wr_predec[4];
+extern WRReturnSingleFunc wr_LogicalNot[4];
+
+//------------------------------------------------------------------------------
+static int wr_aot_libcall_0( WRValue* s, WRValue* frameBase, WRValue* /*globalSpace*/, WRContext* context )
+{
+	frameBase[0].ui = 0x00000000u; frameBase[0].p2 = WR_FLOAT; // 0
+	frameBase[1].i = 0; frameBase[1].p2 = WR_INT;
+L9:
+	s[0].i = 3000; s[0].p2 = WR_INT;
+	if ( frameBase[1].type == WR_INT ) { if ( !(frameBase[1].i < s[0].i) ) goto L70; }
+	else { if ( !wr_CompareLT[(frameBase[1].type<<2)|s[0].type]( &frameBase[1], &s[0] ) ) goto L70; }
+	s[0].p = frameBase + 1; s[0].p2 = WR_REF;
+	if ( wr_nativeCallLib(context, s + 1, 1, 0xBF4C2D6Bu, 0) ) { return 1; }
+	if ( wr_nativeCallLib(context, s + 1, 1, 0xDD9369F1u, 0) ) { return 1; }
+	s[1].p = frameBase + 1; s[1].p2 = WR_REF;
+	if ( wr_nativeCallLib(context, s + 2, 1, 0xFD7A3419u, 0) ) { return 1; }
+	if ( s[1].type == WR_INT && s[0].type == WR_INT ) { s[0].p2 = WR_INT; s[0].i = s[1].i + s[0].i; }
+	else if ( s[1].type == WR_FLOAT && s[0].type == WR_FLOAT ) { s[0].p2 = WR_FLOAT; s[0].f = s[1].f + s[0].f; }
+	else { wr_AdditionBinary[(s[1].type<<2)|s[0].type]( &s[1], &s[0], &s[0] ); }
+	s[1].p = frameBase + 0; s[1].p2 = WR_REF;
+	if ( frameBase[0].type == WR_INT && s[0].type == WR_INT ) { frameBase[0].i += s[0].i; }
+	else if ( frameBase[0].type == WR_FLOAT && s[0].type == WR_FLOAT ) { frameBase[0].f += s[0].f; }
+	else { wr_AddAssign[(s[1].type<<2)|s[0].type]( &s[1], &s[0] ); }
+	s[0].ui = 0x447A0000u; s[0].p2 = WR_FLOAT; // 1000
+	s[1].p = frameBase + 0; s[1].p2 = WR_REF;
+	if ( frameBase[0].type == WR_FLOAT ) { s[0].p2 = WR_FLOAT; s[0].f = frameBase[0].f / s[0].f; }
+	else { wr_DivideBinary[(s[1].type<<2)|s[0].type]( &s[1], &s[0], &s[0] ); }
+	if ( wr_nativeCallLib(context, s + 1, 1, 0x4CE54323u, 0) ) { return 1; }
+	s[1].ui = 0x447A0000u; s[1].p2 = WR_FLOAT; // 1000
+	if ( s[0].type == WR_FLOAT ) { s[0].p2 = WR_FLOAT; s[0].f = s[1].f * s[0].f; }
+	else { wr_MultiplyBinary[(s[1].type<<2)|s[0].type]( &s[1], &s[0], &s[0] ); }
+	s[1].p = frameBase + 0; s[1].p2 = WR_REF;
+	if ( frameBase[0].type == WR_INT && s[0].type == WR_INT ) { frameBase[0].i -= s[0].i; }
+	else if ( frameBase[0].type == WR_FLOAT && s[0].type == WR_FLOAT ) { frameBase[0].f -= s[0].f; }
+	else { wr_SubtractAssign[(s[1].type<<2)|s[0].type]( &s[1], &s[0] ); }
+	if ( frameBase[1].type == WR_INT ) { ++frameBase[1].i; } else { wr_preinc[frameBase[1].type]( &frameBase[1] ); }
+	goto L9;
+L70:
+	s[0].p = frameBase + 0; s[0].p2 = WR_REF;
+	s[0].i = s[0].asInt(); s[0].p2 = WR_INT;
+	return 0;
+}
+
+//------------------------------------------------------------------------------
+static const WRNativeFunction wr_aot_libcall_functions[] =
+{
+	{ wr_aot_libcall_0, 3 }, // 0x626EBEB9
+};
+
+extern const WRNativeModule wr_aot_libcall = { 0xF85F7A92u, 1, wr_aot_libcall_functions };
+
+#endif
+
+extern const unsigned int wr_aot_libcall_bytecodeSize = 95;
+extern const unsigned char wr_aot_libcall_bytecode[] =
+{
+	0x00, 0x01, 0x01, 0x00, 0x00, 0x11, 0x00, 0xB9, 0xBE, 0x6E, 0x62, 0x00, 0x02, 0x03, 0x02, 0xEF,
+	0x14, 0xD5, 0x00, 0x00, 0x00, 0x00, 0x00, 0xD2, 0x01, 0x00, 0xB0, 0xB8, 0x0B, 0x71, 0x01, 0x38,
+	0x09, 0x1F, 0x01, 0x09, 0x01, 0x6B, 0x2D, 0x4C, 0xBF, 0x09, 0x01, 0xF1, 0x69, 0x93, 0xDD, 0x1F,
+	0x01, 0x09, 0x01, 0x19, 0x34, 0x7A, 0xFD, 0x34, 0x1F, 0x00, 0xA4, 0x03, 0x00, 0x00, 0x7A, 0x44,
+	0x1F, 0x00, 0x2D, 0x09, 0x01, 0x23, 0x43, 0xE5, 0x4C, 0x03, 0x00, 0x00, 0x7A, 0x44, 0x2B, 0x1F,
+	0x00, 0xA3, 0xFB, 0x01, 0x37, 0xC5, 0x09, 0x1F, 0x00, 0xF0, 0x13, 0x92, 0x7A, 0x5F, 0xF8,
+};
+
+// Generated by wr_translate() from wrench bytecode with CRC 0x91FEBEE8.
+// Built next to wrench.cpp with WRENCH_AOT defined, contexts created from
+// wr_aot_member_bytecode run these functions natively once wr_addNativeModule( w, &wr_aot_member )
+// is called
+#include "wrench.h"
+
+#ifdef WRENCH_AOT
+
+typedef void (*WRVoidFunc)( WRValue* to, WRValue* from );
+typedef void (*WRTargetFunc)( WRValue* to, WRValue* from, WRValue* target );
+typedef bool (*WRReturnFunc)( WRValue* to, WRValue* from );
+typedef void (*WRUnaryFunc)( WRValue* value );
+typedef bool (*WRReturnSingleFunc)( WRValue* value );
+extern WRTargetFunc wr_AdditionBinary[16];
+extern WRTargetFunc wr_SubtractBinary[16];
+extern WRTargetFunc wr_MultiplyBinary[16];
+extern WRTargetFunc wr_DivideBinary[16];
+extern WRTargetFunc wr_ModBinary[16];
+extern WRTargetFunc wr_LeftShiftBinary[16];
+extern WRTargetFunc wr_RightShiftBinary[16];
+extern WRTargetFunc wr_ANDBinary[16];
+extern WRTargetFunc wr_ORBinary[16];
+extern WRTargetFunc wr_XORBinary[16];
+extern WRVoidFunc wr_AddAssign[16];
+extern WRVoidFunc wr_SubtractAssign[16];
+extern WRVoidFunc wr_MultiplyAssign[16];
+extern WRVoidFunc wr_DivideAssign[16];
+extern WRVoidFunc wr_ModAssign[16];
+extern WRVoidFunc wr_LeftShiftAssign[16];
+extern WRVoidFunc wr_RightShiftAssign[16];
+extern WRVoidFunc wr_ANDAssign[16];
+extern WRVoidFunc wr_ORAssign[16];
+extern WRVoidFunc wr_XORAssign[16];
+extern WRVoidFunc wr_assign[16];
+extern WRReturnFunc wr_CompareEQ[16];
+extern WRReturnFunc wr_CompareLT[16];
+extern WRReturnFunc wr_CompareGT[16];
+extern WRUnaryFunc wr_preinc[4];
+extern WRUnaryFunc wr_predec[4];
+extern WRReturnSingleFunc wr_LogicalNot[4];
+
+//------------------------------------------------------------------------------
+static int wr_aot_member_0( WRValue* s, WRValue* /*frameBase*/, WRValue* /*globalSpace*/, WRContext* /*context*/ )
+{
+	s[0].init();
+	return 0;
+}
+
+//------------------------------------------------------------------------------
+static int wr_aot_member_1( WRValue* s, WRValue* /*frameBase*/, WRValue* /*globalSpace*/, WRContext* /*context*/ )
+{
+	s[0].init();
+	return 0;
+}
+
+//------------------------------------------------------------------------------
+static const WRNativeFunction wr_aot_member_functions[] =
+{
+	{ wr_aot_member_0, 0 }, // 0xD50C118F
+	{ wr_aot_member_1, 0 }, // 0xD40C0FFC
+	{ 0, 0 }, // 0x626EBEB9 left to the interpreter
+};
+
+extern const WRNativeModule wr_aot_member = { 0x91FEBEE8u, 3, wr_aot_member_functions };
+
+#endif
+
+extern const unsigned int wr_aot_member_bytecodeSize = 453;
+extern const unsigned char wr_aot_member_bytecode[] =
+{
+	0x00, 0x03, 0x01, 0x27, 0x00, 0x44, 0x00, 0x8F, 0x11, 0x0C, 0xD5, 0x00, 0x03, 0x04, 0x45, 0x00,
+	0x80, 0x00, 0xFC, 0x0F, 0x0C, 0xD4, 0x00, 0x03, 0x04, 0x00, 0x00, 0x81, 0x00, 0xB9, 0xBE, 0x6E,
+	0x62, 0x00, 0x06, 0x07, 0x02, 0xEF, 0x14, 0x03, 0x00, 0x05, 0x00, 0x87, 0x50, 0x0C, 0xFD, 0x00,
+	0xF4, 0x4E, 0x0C, 0xFC, 0x01, 0xAB, 0xAB, 0xAB, 0xAB, 0x00, 0xAD, 0x53, 0x0C, 0xFF, 0x02, 0xAB,
+	0xAB, 0xAB, 0xAB, 0x00, 0x12, 0x03, 0x00, 0x0B, 0x00, 0xAB, 0xAB, 0xAB, 0xAB, 0x00, 0xAD, 0x53,
+	0x0C, 0xFF, 0x01, 0xAB, 0xAB, 0xAB, 0xAB, 0x00, 0xAB, 0xAB, 0xAB, 0xAB, 0x00, 0xAB, 0xAB, 0xAB,
+	0xAB, 0x00, 0xAB, 0xAB, 0xAB, 0xAB, 0x00, 0xAB, 0xAB, 0xAB, 0xAB, 0x00, 0x2C, 0x29, 0x0C, 0xE4,
+	0x00, 0xAB, 0xAB, 0xAB, 0xAB, 0x00, 0xAB, 0xAB, 0xAB, 0xAB, 0x00, 0x87, 0x50, 0x0C, 0xFD, 0x02,
+	0x12, 0x07, 0x00, 0x00, 0x03, 0x58, 0x58, 0x0B, 0x27, 0x00, 0x97, 0x00, 0x07, 0x00, 0x01, 0x03,
+	0x58, 0x58, 0x0B, 0x45, 0x00, 0x97, 0x01, 0x02, 0x04, 0x01, 0x00, 0x78, 0xAF, 0x01, 0x0E, 0x04,
+	0x01, 0x00, 0x79, 0xAF, 0x02, 0x0E, 0x97, 0x02, 0xD2, 0x03, 0x00, 0xD2, 0x04, 0x00, 0xB0, 0xD0,
+	0x07, 0x65, 0x04, 0xD9, 0x00, 0x1C, 0x00, 0x87, 0x50, 0x0C, 0xFD, 0x1F, 0x04, 0x1D, 0x02, 0x95,
+	0x1C, 0x00, 0xF4, 0x4E, 0x0C, 0xFC, 0x1C, 0x00, 0x87, 0x50, 0x0C, 0xFD, 0xAF, 0x01, 0x1D, 0x02,
+	0x34, 0x1E, 0x02, 0x02, 0x95, 0x1C, 0x00, 0xAD, 0x53, 0x0C, 0xFF, 0x1C, 0x00, 0xF4, 0x4E, 0x0C,
+	0xFC, 0x1E, 0x02, 0x02, 0xA4, 0x1C, 0x01, 0x87, 0x50, 0x0C, 0xFD, 0x1C, 0x00, 0xAD, 0x53, 0x0C,
+	0xFF, 0x1E, 0x02, 0x02, 0x95, 0x1C, 0x01, 0xAD, 0x53, 0x0C, 0xFF, 0x1C, 0x01, 0x87, 0x50, 0x0C,
+	0xFD, 0xAF, 0x07, 0x33, 0x1E, 0x02, 0x02, 0xA4, 0x1C, 0x02, 0x87, 0x50, 0x0C, 0xFD, 0xAF, 0x01,
+	0x1D, 0x02, 0xA4, 0x1C, 0x02, 0xF4, 0x4E, 0x0C, 0xFC, 0x1C, 0x02, 0x87, 0x50, 0x0C, 0xFD, 0xAF,
+	0x02, 0x2B, 0x1E, 0x02, 0x02, 0x95, 0xB0, 0xE8, 0x03, 0x67, 0x04, 0x2E, 0x09, 0x1C, 0x02, 0x36,
+	0x3F, 0x0C, 0xF2, 0xAF, 0x05, 0x1D, 0x02, 0x95, 0x1C, 0x02, 0xC9, 0x40, 0x0C, 0xF3, 0xAF, 0x06,
+	0x1D, 0x02, 0x95, 0x1C, 0x02, 0x10, 0x3C, 0x0C, 0xF0, 0xAF, 0x07, 0x1D, 0x02, 0x95, 0x1C, 0x02,
+	0xA3, 0x3D, 0x0C, 0xF1, 0xAF, 0x08, 0x1D, 0x02, 0x95, 0x1F, 0x01, 0x97, 0x05, 0x1F, 0x04, 0xAF,
+	0x01, 0x33, 0x39, 0x06, 0x09, 0x1F, 0x00, 0x97, 0x05, 0x1C, 0x05, 0x87, 0x50, 0x0C, 0xFD, 0x1C,
+	0x05, 0xAD, 0x53, 0x0C, 0xFF, 0x1E, 0x02, 0x02, 0x34, 0x1F, 0x03, 0xA4, 0x1C, 0x02, 0x5C, 0x42,
+	0x0C, 0xF4, 0x1F, 0x04, 0x1D, 0x02, 0x95, 0xFB, 0x04, 0x36, 0x24, 0xFF, 0x1C, 0x02, 0x87, 0x50,
+	0x0C, 0xFD, 0x1C, 0x02, 0xF4, 0x4E, 0x0C, 0xFC, 0x1C, 0x02, 0x36, 0x3F, 0x0C, 0xF2, 0x1C, 0x00,
+	0xAD, 0x53, 0x0C, 0xFF, 0x1C, 0x01, 0xAD, 0x53, 0x0C, 0xFF, 0x1C, 0x02, 0x5C, 0x42, 0x0C, 0xF4,
+	0x1D, 0x06, 0x1F, 0x03, 0x34, 0x1E, 0x01, 0x05, 0x34, 0x1E, 0x01, 0x03, 0x34, 0x34, 0x34, 0x34,
+	0x13, 0xE8, 0xBE, 0xFE, 0x91,
+};
+
+// Generated by wr_translate() from wrench bytecode with CRC 0x41CF9724.
+// Built next to wrench.cpp with WRENCH_AOT defined, contexts created from
+// wr_aot_recursion_bytecode run these functions natively once wr_addNativeModule( w, &wr_aot_recursion )
+// is called
+#include "wrench.h"
+
+#ifdef WRENCH_AOT
+
+typedef void (*WRVoidFunc)( WRValue* to, WRValue* from );
+typedef void (*WRTargetFunc)( WRValue* to, WRValue* from, WRValue* target );
+typedef bool (*WRReturnFunc)( WRValue* to, WRValue* from );
+typedef void (*WRUnaryFunc)( WRValue* value );
+typedef bool (*WRReturnSingleFunc)( WRValue* value );
+extern WRTargetFunc wr_AdditionBinary[16];
+extern WRTargetFunc wr_SubtractBinary[16];
+extern WRTargetFunc wr_MultiplyBinary[16];
+extern WRTargetFunc wr_DivideBinary[16];
+extern WRTargetFunc wr_ModBinary[16];
+extern WRTargetFunc wr_LeftShiftBinary[16];
+extern WRTargetFunc wr_RightShiftBinary[16];
+extern WRTargetFunc wr_ANDBinary[16];
+extern WRTargetFunc wr_ORBinary[16];
+extern WRTargetFunc wr_XORBinary[16];
+extern WRVoidFunc wr_AddAssign[16];
+extern WRVoidFunc wr_SubtractAssign[16];
+extern WRVoidFunc wr_MultiplyAssign[16];
+extern WRVoidFunc wr_DivideAssign[16];
+extern WRVoidFunc wr_ModAssign[16];
+extern WRVoidFunc wr_LeftShiftAssign[16];
+extern WRVoidFunc wr_RightShiftAssign[16];
+extern WRVoidFunc wr_ANDAssign[16];
+extern WRVoidFunc wr_ORAssign[16];
+extern WRVoidFunc wr_XORAssign[16];
+extern WRVoidFunc wr_assign[16];
+extern WRReturnFunc wr_CompareEQ[16];
+extern WRReturnFunc wr_CompareLT[16];
+extern WRReturnFunc wr_CompareGT[16];
+extern WRUnaryFunc wr_preinc[4];
+extern WRUnaryFunc wr_predec[4];
+extern WRReturnSingleFunc wr_LogicalNot[4];
+
+//------------------------------------------------------------------------------
+static const WRNativeFunction wr_aot_recursion_functions[] =
+{
+	{ 0, 0 }, // 0xBCE49236 left to the interpreter
+	{ 0, 0 }, // 0x3A4A5A02 left to the interpreter
+	{ 0, 0 }, // 0x626EBEB9 left to the interpreter
+};
+
+extern const WRNativeModule wr_aot_recursion = { 0x41CF9724u, 3, wr_aot_recursion_functions };
+
+#endif
+
+extern const unsigned int wr_aot_recursion_bytecodeSize = 151;
+extern const unsigned char wr_aot_recursion_bytecode[] =
+{
+	0x00, 0x03, 0x01, 0x00, 0x00, 0x27, 0x00, 0x36, 0x92, 0xE4, 0xBC, 0x01, 0x01, 0x03, 0x00, 0x00,
+	0x48, 0x00, 0x02, 0x5A, 0x4A, 0x3A, 0x02, 0x02, 0x05, 0x00, 0x00, 0x7F, 0x00, 0xB9, 0xBE, 0x6E,
+	0x62, 0x00, 0x00, 0x01, 0x02, 0xEF, 0x14, 0xAF, 0x02, 0x71, 0x00, 0x05, 0x09, 0x1F, 0x00, 0x13,
+	0xAF, 0x02, 0x1F, 0x00, 0x2C, 0x07, 0x01, 0x00, 0x02, 0x58, 0x08, 0xAF, 0x01, 0x1F, 0x00, 0x2C,
+	0x07, 0x01, 0x00, 0x02, 0x58, 0x08, 0x34, 0x13, 0x02, 0x67, 0x00, 0x08, 0x09, 0xAF, 0x01, 0x1F,
+	0x01, 0x34, 0x13, 0x02, 0x67, 0x01, 0x10, 0x09, 0xAF, 0x01, 0x1F, 0x00, 0x2C, 0xAF, 0x01, 0x07,
+	0x02, 0x01, 0x02, 0x58, 0x08, 0x13, 0xAF, 0x01, 0x1F, 0x00, 0x2C, 0x1F, 0x00, 0xAF, 0x01, 0x1F,
+	0x01, 0x2C, 0x07, 0x02, 0x01, 0x02, 0x58, 0x08, 0x07, 0x02, 0x01, 0x02, 0x58, 0x08, 0x13, 0xAF,
+	0x02, 0xAF, 0x03, 0x07, 0x02, 0x01, 0x02, 0x58, 0x08, 0xAF, 0x12, 0x07, 0x01, 0x00, 0x02, 0x58,
+	0x08, 0x34, 0x13, 0x24, 0x97, 0xCF, 0x41,
+};
+
+// Generated by wr_translate() from wrench bytecode with CRC 0xE51159E9.
+// Built next to wrench.cpp with WRENCH_AOT defined, contexts created from
+// wr_aot_string_bytecode run these functions natively once wr_addNativeModule( w, &wr_aot_string )
+// is called
+#include "wrench.h"
+
+#ifdef WRENCH_AOT
+
+typedef void (*WRVoidFunc)( WRValue* to, WRValue* from );
+typedef void (*WRTargetFunc)( WRValue* to, WRValue* from, WRValue* target );
+typedef bool (*WRReturnFunc)( WRValue* to, WRValue* from );
+typedef void (*WRUnaryFunc)( WRValue* value );
+typedef bool (*WRReturnSingleFunc)( WRValue* value );
+extern WRTargetFunc wr_AdditionBinary[16];
+extern WRTargetFunc wr_SubtractBinary[16];
+extern WRTargetFunc wr_MultiplyBinary[16];
+extern WRTargetFunc wr_DivideBinary[16];
+extern WRTargetFunc wr_ModBinary[16];
+extern WRTargetFunc wr_LeftShiftBinary[16];
+extern WRTargetFunc wr_RightShiftBinary[16];
+extern WRTargetFunc wr_ANDBinary[16];
+extern WRTargetFunc wr_ORBinary[16];
+extern WRTargetFunc wr_XORBinary[16];
+extern WRVoidFunc wr_AddAssign[16];
+extern WRVoidFunc wr_SubtractAssign[16];
+extern WRVoidFunc wr_MultiplyAssign[16];
+extern WRVoidFunc wr_DivideAssign[16];
+extern WRVoidFunc wr_ModAssign[16];
+extern WRVoidFunc wr_LeftShiftAssign[16];
+extern WRVoidFunc wr_RightShiftAssign[16];
+extern WRVoidFunc wr_ANDAssign[16];
+extern WRVoidFunc wr_ORAssign[16];
+extern WRVoidFunc wr_XORAssign[16];
+extern WRVoidFunc wr_assign[16];
+extern WRReturnFunc wr_CompareEQ[16];
+extern WRReturnFunc wr_CompareLT[16];
+extern WRReturnFunc wr_CompareGT[16];
+extern WRUnaryFunc wr_preinc[4];
+extern WRUnaryFunc wr_predec[4];
+extern WRReturnSingleFunc wr_LogicalNot[4];
+
+//------------------------------------------------------------------------------
+static const WRNativeFunction wr_aot_string_functions[] =
+{
+	{ 0, 0 }, // 0x626EBEB9 left to the interpreter
+};
+
+extern const WRNativeModule wr_aot_string = { 0xE51159E9u, 1, wr_aot_string_functions };
+
+#endif
+
+extern const unsigned int wr_aot_string_bytecodeSize = 157;
+extern const unsigned char wr_aot_string_bytecode[] =
+{
+	0x00, 0x01, 0x01, 0x00, 0x00, 0x11, 0x00, 0xB9, 0xBE, 0x6E, 0x62, 0x00, 0x05, 0x06, 0x02, 0xEF,
+	0x14, 0xD2, 0x00, 0x00, 0xD2, 0x01, 0x00, 0xB0, 0x2C, 0x01, 0x71, 0x01, 0x58, 0x09, 0x04, 0x06,
+	0x00, 0x73, 0x65, 0x6E, 0x73, 0x6F, 0x72, 0x97, 0x02, 0x1F, 0x02, 0xF6, 0x06, 0x00, 0x73, 0x65,
+	0x6E, 0x73, 0x6F, 0x72, 0xC5, 0x04, 0x09, 0x92, 0x00, 0x04, 0x01, 0x00, 0x74, 0x04, 0x02, 0x00,
+	0x25, 0x64, 0x1F, 0x01, 0x09, 0x02, 0x1F, 0xC7, 0x2E, 0x80, 0x09, 0x02, 0x0C, 0x98, 0xCD, 0xE3,
+	0x97, 0x03, 0x1F, 0x03, 0x09, 0x01, 0x0A, 0x4C, 0xDC, 0x0C, 0x1F, 0x00, 0xA4, 0xB3, 0x03, 0x01,
+	0x15, 0x09, 0x01, 0x39, 0x74, 0x40, 0xE4, 0x39, 0x07, 0x09, 0xAF, 0x02, 0x1F, 0x00, 0xA4, 0xFB,
+	0x01, 0x37, 0xA5, 0x09, 0x04, 0x05, 0x00, 0x25, 0x64, 0x3A, 0x25, 0x73, 0x1F, 0x00, 0x04, 0x04,
+	0x00, 0x64, 0x6F, 0x6E, 0x65, 0x09, 0x03, 0x1F, 0xC7, 0x2E, 0x80, 0x97, 0x04, 0x1F, 0x04, 0x09,
+	0x01, 0x0A, 0x4C, 0xDC, 0x0C, 0x1F, 0x00, 0x34, 0x13, 0xE9, 0x59, 0x11, 0xE5,
+};
+
+#ifdef WRENCH_AOT
+extern const WRNativeModule* const wr_benchModules[] =
+{
+	&wr_aot_array,
+	&wr_aot_calls,
+	&wr_aot_constants,
+	&wr_aot_float_math,
+	&wr_aot_hash,
+	&wr_aot_int_loop,
+	&wr_aot_libcall,
+	&wr_aot_member,
+	&wr_aot_recursion,
+	&wr_aot_string,
+	0
+};
+#endif
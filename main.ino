@@ -5,22 +5,51 @@
 
 using namespace my;
 
+static StateThread stateThread(4);
+static WifiThread wifiThread;
+static WebServerThread webServerThread;
+static ForwardLogsThread forwardLogsThread;
+static DutyCycleThread dutyCycleThread(forwardLogsThread);
+
 void setup() {
 	Serial.begin(115200);
 	while (!Serial) continue;
-	for (int i = 5; i; --i) {
-		delay(1000);
-		Log.infoln("Starting... ", i);
+	const bool journal = JOURNAL.begin();
+	// A wake from deep sleep is not a boot, RTC memory counts those without writing flash.
+	bool woke = false;
+	if (DutyCycleThread::ENABLED) {
+		woke = dutyCycleThread.restore();
+	} else {
+		for (int i = 5; i; --i) {
+			delay(1000);
+			Log.infoln("Starting... ", i);
+		}
+	}
+	if (!journal) {
+		Log.infoln("Journal in flash is not usable");
 	}
+	JOURNAL.get(JOURNAL_COUNTERS, COUNTERS);
 	CONFIG.load();
-	CONFIG.print();
+	if (!woke) {
+		COUNTERS.boots++;
+		JOURNAL.put(JOURNAL_COUNTERS, COUNTERS);
+		Log.infoln("Boot ", COUNTERS.boots, " journal sector=", JOURNAL.sector, " seq=", JOURNAL.seq,
+			   " erases=", JOURNAL.erases);
+		CONFIG.print();
+	}
+	WIFI.begin();
 }
 
-static StateThread stateThread(4);
-static WifiThread wifiThread;
-static WebServerThread webServerThread;
-
 void loop() {
+	if (DutyCycleThread::ENABLED) {
+		dutyCycleThread.run();
+		if (dutyCycleThread.uploading) {
+			wifiThread.run();
+			forwardLogsThread.run();
+		}
+		stateThread.run();
+		return;
+	}
 	wifiThread.run();
 	webServerThread.run();
 	stateThread.run();
@@ -3,6 +3,12 @@
 namespace my {
 
 LogPrinter Log;
+Journal<Esp8266Flash> JOURNAL;
+// A rotation carries the latest record of every key, the log ring being the biggest one.
+static_assert(decltype(JOURNAL)::fits({sizeof(Config), sizeof(Counters), sizeof(WifiCache), sizeof(Log.buffer.buffer.mBuffer)}));
+Counters COUNTERS;
 Config CONFIG;
+WifiEvents WIFI;
+DoubleBuffer<State> STATE;
 
 };
@@ -0,0 +1,66 @@
+#pragma once
+#include <Arduino.h>
+#include <atomic>
+
+namespace my {
+
+// Two copies of T and a seqlock style sequence number.
+// The writer fills back() across as many yields as it wants and then publish()es it.
+// Readers only ever see front(), which does not change until the next publish().
+// The sequence number is odd while publish() is flipping the buffers.
+template <typename T> struct DoubleBuffer {
+	T buf[2] = {};
+	volatile uint32_t seq = 0;
+
+	static void barrier() {
+		std::atomic_signal_fence(std::memory_order_seq_cst);
+	}
+
+	// Number of published versions. Comparing two of these is the change detection.
+	uint32_t version() const {
+		return this->seq >> 1;
+	}
+
+	// Cooperative readers that do not yield while holding the reference can use it directly.
+	const T &front() const {
+		return this->buf[(this->seq >> 1) & 1];
+	}
+
+	T &back() {
+		return this->buf[((this->seq >> 1) & 1) ^ 1];
+	}
+
+	// Start a new version from the currently published one.
+	T &begin_write() {
+		T &ret = this->back();
+		ret = this->front();
+		return ret;
+	}
+
+	void publish() {
+		barrier();
+		this->seq = this->seq + 1;
+		barrier();
+		this->seq = this->seq + 1;
+		barrier();
+	}
+
+	// Copy out a consistent snapshot, retrying when a publish() interrupted the copy.
+	// Returns the version of the snapshot.
+	uint32_t read(T &out) const {
+		while (1) {
+			const uint32_t s = this->seq;
+			if (s & 1) {
+				continue;
+			}
+			barrier();
+			out = this->buf[(s >> 1) & 1];
+			barrier();
+			if (s == this->seq) {
+				return s >> 1;
+			}
+		}
+	}
+};
+
+}; // namespace my
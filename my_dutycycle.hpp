@@ -0,0 +1,133 @@
+#pragma once
+#include "my_journal.hpp"
+#include <Arduino.h>
+#include <array>
+
+namespace my {
+
+#ifdef ARDUINO_ARCH_ESP8266
+// RTC user memory survives deep sleep but not a power loss.
+struct Esp8266Rtc {
+	// The first 128 bytes of the user RTC memory are used by OTA.
+	constexpr static const uint32_t OFFSET_BLOCKS = 32;
+	constexpr static const size_t SIZE = 512 - OFFSET_BLOCKS * 4;
+	bool read(void *data, size_t size) {
+		return ESP.rtcUserMemoryRead(OFFSET_BLOCKS, static_cast<uint32_t *>(data), size);
+	}
+	bool write(const void *data, size_t size) {
+		return ESP.rtcUserMemoryWrite(OFFSET_BLOCKS, (uint32_t *)data, size);
+	}
+	// Does not return. Needs GPIO16 wired to RST.
+	void sleep(uint64_t us, bool radio) {
+		ESP.deepSleep(us, radio ? RF_DEFAULT : RF_DISABLED);
+	}
+};
+#endif
+
+// What is carried from one wake to the next: a wake counter, a batch of samples and the log
+// bytes that were not uploaded yet. The samples are uploaded every `upload_every` wakes or
+// when the batch is full, and the radio is only enabled for the wakes that upload.
+template <typename Rtc, typename Sample, size_t SAMPLES> struct DutyCycle {
+	constexpr static const uint32_t MAGIC = 0x33435444; // "DTC3"
+	struct Entry {
+		uint32_t wake;
+		Sample sample;
+	};
+	// Whatever RTC memory the samples leave.
+	constexpr static const size_t LOG_BYTES =
+	    (Rtc::SIZE - 5 * sizeof(uint32_t) - sizeof(std::array<Entry, SAMPLES>) - 2 * sizeof(uint16_t)) & ~size_t(3);
+	struct Memory {
+		uint32_t magic;
+		uint32_t crc;
+		uint32_t wakes;
+		// The value of wakes at the last take_wakes().
+		uint32_t wakes_taken;
+		uint32_t count;
+		std::array<Entry, SAMPLES> entries;
+		uint16_t log_len;
+		// Older log bytes that did not fit are in the flash journal.
+		uint16_t log_journaled;
+		std::array<uint8_t, LOG_BYTES> log;
+	};
+	static_assert(sizeof(Memory) <= Rtc::SIZE && sizeof(Memory) % 4 == 0);
+
+	Rtc rtc;
+	Memory mem = {};
+	unsigned upload_every = 1;
+
+	static uint32_t crc(const Memory &m) {
+		return journal_crc32(&m.wakes, sizeof(m) - offsetof(Memory, wakes));
+	}
+
+	// Restore the memory of the previous wakes, or start over after a power loss.
+	// Returns false when there was nothing to restore.
+	bool wake(unsigned upload_every) {
+		this->upload_every = upload_every ? upload_every : 1;
+		bool restored = true;
+		if (!this->rtc.read(&this->mem, sizeof(this->mem)) || this->mem.magic != MAGIC ||
+		    this->mem.crc != crc(this->mem) || this->mem.count > SAMPLES || this->mem.log_len > LOG_BYTES) {
+			this->mem = {};
+			this->mem.magic = MAGIC;
+			restored = false;
+		}
+		this->mem.wakes++;
+		return restored;
+	}
+
+	// Wakes since the previous call, for counters kept in flash that a wake does not write.
+	uint32_t take_wakes() {
+		const uint32_t n = this->mem.wakes - this->mem.wakes_taken;
+		this->mem.wakes_taken = this->mem.wakes;
+		return n;
+	}
+
+	bool upload_due() const {
+		return this->mem.wakes % this->upload_every == 0 || this->mem.count >= SAMPLES;
+	}
+
+	// A full batch drops its oldest sample.
+	void add(const Sample &sample) {
+		if (this->mem.count == SAMPLES) {
+			std::move(this->mem.entries.begin() + 1, this->mem.entries.end(), this->mem.entries.begin());
+			this->mem.count--;
+		}
+		this->mem.entries[this->mem.count++] = Entry{this->mem.wakes, sample};
+	}
+
+	const Entry *begin() const {
+		return this->mem.entries.data();
+	}
+	const Entry *end() const {
+		return this->mem.entries.data() + this->mem.count;
+	}
+
+	void clear() {
+		this->mem.count = 0;
+	}
+
+	const uint8_t *log_begin() const {
+		return this->mem.log.data();
+	}
+	const uint8_t *log_end() const {
+		return this->mem.log.data() + this->mem.log_len;
+	}
+
+	// Replaces the kept log bytes, false when they do not fit.
+	bool keep_log(const uint8_t *data, size_t len) {
+		if (len > LOG_BYTES) {
+			return false;
+		}
+		memcpy(this->mem.log.data(), data, len);
+		this->mem.log_len = len;
+		return true;
+	}
+
+	void sleep(uint64_t us) {
+		this->mem.crc = crc(this->mem);
+		this->rtc.write(&this->mem, sizeof(this->mem));
+		const bool radio = (this->mem.wakes + 1) % this->upload_every == 0 || this->mem.count >= SAMPLES;
+		this->rtc.sleep(us, radio);
+	}
+};
+
+}; // namespace my
@@ -0,0 +1,317 @@
+#pragma once
+#include <Arduino.h>
+#include <array>
+#include <initializer_list>
+#include <type_traits>
+#ifdef ARDUINO_ARCH_ESP8266
+#include <flash_hal.h>
+#endif
+
+namespace my {
+
+static inline uint32_t journal_crc32(const void *data, size_t len, uint32_t crc = 0xffffffff) {
+	const uint8_t *p = static_cast<const uint8_t *>(data);
+	while (len--) {
+		crc ^= *p++;
+		for (int i = 0; i < 8; ++i) {
+			crc = (crc >> 1) ^ (0xedb88320 & -(crc & 1));
+		}
+	}
+	return crc;
+}
+
+#ifdef ARDUINO_ARCH_ESP8266
+// Raw flash sectors at the start of the filesystem area. The sketch never mounts a filesystem.
+struct Esp8266Flash {
+	constexpr static const uint32_t SECTOR_SIZE = SPI_FLASH_SEC_SIZE;
+	static uint32_t address(unsigned sector, uint32_t offset) {
+		return FS_PHYS_ADDR + sector * SECTOR_SIZE + offset;
+	}
+	static unsigned sectors() {
+		return FS_PHYS_SIZE / SECTOR_SIZE;
+	}
+	bool erase(unsigned sector) {
+		return ESP.flashEraseSector(address(sector, 0) / SECTOR_SIZE);
+	}
+	bool read(unsigned sector, uint32_t offset, uint32_t *data, size_t size) {
+		return ESP.flashRead(address(sector, offset), data, size);
+	}
+	bool write(unsigned sector, uint32_t offset, const uint32_t *data, size_t size) {
+		return ESP.flashWrite(address(sector, offset), data, size);
+	}
+};
+#endif
+
+// Append-only key/value journal over SECTORS flash sectors.
+//
+// Every put() appends a CRC protected record to the current sector. When the sector is
+// full the next sector is erased, the latest record of every other key is copied there
+// followed by the new record, and only then the sector header is written, so a power loss
+// leaves the previous sector as the newest valid one. Sectors are used round robin, which spreads the erases evenly.
+// Only the newest sector is scanned on begin(), so boot is O(records in one sector).
+template <typename Flash, unsigned SECTORS = 8, unsigned KEYS = 8> struct Journal {
+	constexpr static const uint32_t SECTOR_SIZE = Flash::SECTOR_SIZE;
+	constexpr static const uint32_t MAGIC = 0x314e524a; // "JRN1"
+	constexpr static const uint16_t ERASED = 0xffff;
+	constexpr static const size_t CHUNK = 64;
+
+	struct SectorHeader {
+		uint32_t magic;
+		uint32_t seq;
+	};
+	struct RecordHeader {
+		uint16_t key;
+		uint16_t len;
+		uint32_t crc;
+	};
+	static_assert(sizeof(SectorHeader) % 4 == 0 && sizeof(RecordHeader) % 4 == 0);
+
+	Flash flash;
+	// Set by a successful begin(), nothing is read or written before.
+	bool usable = false;
+	uint32_t seq = 0;
+	unsigned sector = SECTORS - 1;
+	uint32_t pos = SECTOR_SIZE;
+	// Offset of the latest record of each key in the current sector, 0 when there is none.
+	std::array<uint32_t, KEYS> index = {};
+	// Statistics.
+	uint32_t appends = 0;
+	uint32_t skipped = 0;
+	uint32_t erases = 0;
+
+	constexpr static uint32_t align(uint32_t v) {
+		return (v + 3) & ~(uint32_t)3;
+	}
+
+	// Flash taken by a record of len bytes.
+	constexpr static uint32_t record_size(uint32_t len) {
+		return sizeof(RecordHeader) + align(len);
+	}
+
+	// Whether the records of all keys, of these lengths at most, fit in one sector together.
+	// put() fails for good once a sector cannot hold the latest record of every key.
+	constexpr static bool fits(std::initializer_list<uint32_t> lens) {
+		uint32_t size = sizeof(SectorHeader);
+		for (const uint32_t len : lens) {
+			size += record_size(len);
+		}
+		return lens.size() <= KEYS && size <= SECTOR_SIZE;
+	}
+
+	bool read_header(unsigned s, uint32_t offset, RecordHeader &h) {
+		return this->flash.read(s, offset, reinterpret_cast<uint32_t *>(&h), sizeof(h));
+	}
+
+	uint32_t record_crc(const RecordHeader &h, const void *data) {
+		uint32_t crc = journal_crc32(&h.key, sizeof(h.key));
+		crc = journal_crc32(&h.len, sizeof(h.len), crc);
+		return journal_crc32(data, h.len, crc);
+	}
+
+	bool check_record(uint32_t offset, const RecordHeader &h) {
+		uint32_t buf[CHUNK / 4];
+		uint32_t crc = journal_crc32(&h.key, sizeof(h.key));
+		crc = journal_crc32(&h.len, sizeof(h.len), crc);
+		for (uint32_t done = 0; done < h.len; done += CHUNK) {
+			const uint32_t n = std::min<uint32_t>(CHUNK, h.len - done);
+			if (!this->flash.read(this->sector, offset + sizeof(h) + done, buf, align(n))) {
+				return false;
+			}
+			crc = journal_crc32(buf, n, crc);
+		}
+		return crc == h.crc;
+	}
+
+	// Find the newest sector and index its records.
+	bool begin() {
+		this->usable = false;
+		// Flash layouts without a filesystem leave no room for the journal.
+		if (SECTORS > Flash::sectors()) {
+			return false;
+		}
+		bool found = false;
+		for (unsigned s = 0; s < SECTORS; ++s) {
+			SectorHeader h;
+			if (!this->flash.read(s, 0, reinterpret_cast<uint32_t *>(&h), sizeof(h))) {
+				return false;
+			}
+			if (h.magic == MAGIC && (!found || (int32_t)(h.seq - this->seq) > 0)) {
+				found = true;
+				this->seq = h.seq;
+				this->sector = s;
+			}
+		}
+		this->index.fill(0);
+		if (!found) {
+			this->sector = SECTORS - 1;
+			this->usable = this->rotate();
+			return this->usable;
+		}
+		this->pos = sizeof(SectorHeader);
+		while (this->pos + sizeof(RecordHeader) <= SECTOR_SIZE) {
+			RecordHeader h;
+			if (!this->read_header(this->sector, this->pos, h)) {
+				return false;
+			}
+			if (h.key == ERASED) {
+				break;
+			}
+			if (h.key >= KEYS || this->pos + sizeof(h) + h.len > SECTOR_SIZE ||
+			    !this->check_record(this->pos, h)) {
+				// Torn write. Nothing can be appended after it, the next put() rotates.
+				this->pos = SECTOR_SIZE;
+				break;
+			}
+			this->index[h.key] = this->pos;
+			this->pos += record_size(h.len);
+		}
+		this->usable = true;
+		return true;
+	}
+
+	bool write_record(unsigned s, uint32_t offset, const RecordHeader &h, const void *data) {
+		// A header with a half written payload fails the CRC check and ends the scan.
+		if (!this->flash.write(s, offset, reinterpret_cast<const uint32_t *>(&h), sizeof(h))) {
+			return false;
+		}
+		uint32_t buf[CHUNK / 4];
+		for (uint32_t done = 0; done < h.len; done += CHUNK) {
+			const uint32_t n = std::min<uint32_t>(CHUNK, h.len - done);
+			buf[(n - 1) / 4] = 0;
+			memcpy(buf, static_cast<const uint8_t *>(data) + done, n);
+			if (!this->flash.write(s, offset + sizeof(h) + done, buf, align(n))) {
+				return false;
+			}
+		}
+		return true;
+	}
+
+	// Erase the next sector, carry the live records over, append the record of add when
+	// there is one and make it the current sector. The record add replaces is not carried.
+	// Nothing is erased when it would not all fit.
+	bool rotate(const RecordHeader *add = nullptr, const void *data = nullptr) {
+		const unsigned next = (this->sector + 1) % SECTORS;
+		std::array<RecordHeader, KEYS> live;
+		uint32_t need = sizeof(SectorHeader) + (add ? record_size(add->len) : 0);
+		for (unsigned k = 0; k < KEYS; ++k) {
+			if (!this->index[k] || (add && add->key == k)) {
+				continue;
+			}
+			if (!this->read_header(this->sector, this->index[k], live[k])) {
+				return false;
+			}
+			need += record_size(live[k].len);
+		}
+		if (need > SECTOR_SIZE) {
+			return false;
+		}
+		if (!this->flash.erase(next)) {
+			return false;
+		}
+		this->erases++;
+		uint32_t buf[CHUNK / 4];
+		uint32_t npos = sizeof(SectorHeader);
+		std::array<uint32_t, KEYS> nindex = {};
+		for (unsigned k = 0; k < KEYS; ++k) {
+			if (!this->index[k] || (add && add->key == k)) {
+				continue;
+			}
+			const uint32_t size = record_size(live[k].len);
+			for (uint32_t done = 0; done < size; done += CHUNK) {
+				const uint32_t n = std::min<uint32_t>(CHUNK, size - done);
+				if (!this->flash.read(this->sector, this->index[k] + done, buf, n) ||
+				    !this->flash.write(next, npos + done, buf, n)) {
+					return false;
+				}
+			}
+			nindex[k] = npos;
+			npos += size;
+		}
+		if (add) {
+			if (!this->write_record(next, npos, *add, data)) {
+				return false;
+			}
+			nindex[add->key] = npos;
+			npos += record_size(add->len);
+		}
+		const SectorHeader h{MAGIC, this->seq + 1};
+		if (!this->flash.write(next, 0, reinterpret_cast<const uint32_t *>(&h), sizeof(h))) {
+			return false;
+		}
+		this->seq = h.seq;
+		this->sector = next;
+		this->pos = npos;
+		this->index = nindex;
+		return true;
+	}
+
+	bool put(uint16_t key, const void *data, uint16_t len) {
+		if (!this->usable || key >= KEYS || sizeof(SectorHeader) + record_size(len) > SECTOR_SIZE) {
+			return false;
+		}
+		RecordHeader h{key, len, 0};
+		h.crc = this->record_crc(h, data);
+		if (this->index[key]) {
+			RecordHeader old;
+			if (this->read_header(this->sector, this->index[key], old) && old.len == h.len &&
+			    old.crc == h.crc) {
+				this->skipped++;
+				return true;
+			}
+		}
+		if (this->pos + record_size(len) > SECTOR_SIZE) {
+			// The new record goes in before the sector header, so a power loss keeps the old one.
+			if (!this->rotate(&h, data)) {
+				return false;
+			}
+		} else {
+			if (!this->write_record(this->sector, this->pos, h, data)) {
+				return false;
+			}
+			this->index[key] = this->pos;
+			this->pos += record_size(len);
+		}
+		this->appends++;
+		return true;
+	}
+
+	// Length of the latest record of key, -1 when there is none.
+	int length(uint16_t key) {
+		RecordHeader h;
+		if (!this->usable || key >= KEYS || !this->index[key] || !this->read_header(this->sector, this->index[key], h)) {
+			return -1;
+		}
+		return h.len;
+	}
+
+	bool get(uint16_t key, void *data, uint16_t len) {
+		if (!this->usable || key >= KEYS || !this->index[key]) {
+			return false;
+		}
+		RecordHeader h;
+		if (!this->read_header(this->sector, this->index[key], h) || h.len != len) {
+			return false;
+		}
+		uint32_t buf[CHUNK / 4];
+		for (uint32_t done = 0; done < len; done += CHUNK) {
+			const uint32_t n = std::min<uint32_t>(CHUNK, len - done);
+			if (!this->flash.read(this->sector, this->index[key] + sizeof(h) + done, buf, align(n))) {
+				return false;
+			}
+			memcpy(static_cast<uint8_t *>(data) + done, buf, n);
+		}
+		return true;
+	}
+
+	template <typename T> bool put(uint16_t key, const T &v) {
+		static_assert(std::is_trivially_copyable<T>::value);
+		static_assert(sizeof(SectorHeader) + record_size(sizeof(T)) <= SECTOR_SIZE);
+		return this->put(key, &v, sizeof(v));
+	}
+	template <typename T> bool get(uint16_t key, T &v) {
+		static_assert(std::is_trivially_copyable<T>::value);
+		return this->get(key, &v, sizeof(v));
+	}
+};
+
+}; // namespace my
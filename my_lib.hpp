@@ -1,5 +1,8 @@
 #pragma once
 #define private public
+#include "my_doublebuffer.hpp"
+#include "my_dutycycle.hpp"
+#include "my_journal.hpp"
 #include "my_log.hpp"
 #include "my_staticslots.hpp"
 #include "my_thread.hpp"
@@ -70,6 +73,23 @@ template <size_t SIZE> struct StaticString : Printable {
 
 ////////////////////////////////////////////////////////////////////////////////////////
 
+enum JournalKey : uint16_t {
+	JOURNAL_CONFIG = 0,
+	JOURNAL_COUNTERS = 1,
+	// 2 held a copy of the readings that nothing read back.
+	JOURNAL_WIFI = 3,
+	JOURNAL_LOGS = 4,
+};
+extern Journal<Esp8266Flash> JOURNAL;
+
+struct Counters {
+	uint32_t boots;
+	uint32_t sweeps;
+};
+extern Counters COUNTERS;
+
+////////////////////////////////////////////////////////////////////////////////////////
+
 struct Config {
 	constexpr static const unsigned VERSION = 1;
 	unsigned version;
@@ -77,10 +97,12 @@ struct Config {
 	char password[24];
 
 	void load() {
-		EEPROM.begin(sizeof(Config));
-		EEPROM.get(0, *this);
-		EEPROM.commit();
-		EEPROM.end();
+		if (!JOURNAL.get(JOURNAL_CONFIG, *this)) {
+			// Saved before the journal existed.
+			EEPROM.begin(sizeof(Config));
+			EEPROM.get(0, *this);
+			EEPROM.end();
+		}
 		if (this->version != VERSION) {
 			this->version = VERSION;
 			strcpy(this->ssid, "CukierekKawowy");
@@ -89,10 +111,7 @@ struct Config {
 	}
 
 	void save() {
-		EEPROM.begin(sizeof(Config));
-		EEPROM.put(0, *this);
-		EEPROM.commit();
-		EEPROM.end();
+		JOURNAL.put(JOURNAL_CONFIG, *this);
 	}
 
 	void print() {
@@ -105,43 +124,179 @@ extern Config CONFIG;
 
 ////////////////////////////////////////////////////////////////////////////////////////
 
+struct Reading {
+	float value;
+	// millis() when the value was read.
+	unsigned long ms;
+	// False until the sensor answers, and again when it stops answering.
+	bool valid;
+};
+
+struct State {
+	std::array<Reading, 10> T;
+	std::array<bool, 10> O;
+};
+// Written only by StateThread, one version per sweep.
+extern DoubleBuffer<State> STATE;
+
+// The readings of a sweep without the timestamps.
+struct SavedReadings {
+	std::array<float, 10> T;
+	uint16_t valid;
+
+	static SavedReadings from(const State &state) {
+		SavedReadings saved = {};
+		for (int i = 0; i < state.T.size(); i++) {
+			saved.T[i] = state.T[i].value;
+			saved.valid |= state.T[i].valid << i;
+		}
+		return saved;
+	}
+};
+
+// SavedReadings in half the space, so RTC memory has room for log lines next to a batch.
+struct RtcReadings {
+	// Hundredths of a degree.
+	std::array<int16_t, 10> T;
+	uint16_t valid;
+
+	static RtcReadings from(const SavedReadings &saved) {
+		RtcReadings rtc = {};
+		for (int i = 0; i < saved.T.size(); i++) {
+			rtc.T[i] = saved.valid & (1 << i) ? lroundf(saved.T[i] * 100) : 0;
+		}
+		rtc.valid = saved.valid;
+		return rtc;
+	}
+};
+
+////////////////////////////////////////////////////////////////////////////////////////
+
+// Connectivity as reported by the SDK event callbacks, so threads do not poll WiFi.status().
+struct WifiEvents {
+	// Bumped on every connect, disconnect and new IP.
+	// Sockets opened in an older epoch belong to a connection that is gone.
+	volatile uint32_t epoch = 0;
+	volatile bool associated = false;
+	volatile bool got_ip = false;
+	WiFiEventHandler on_connected;
+	WiFiEventHandler on_disconnected;
+	WiFiEventHandler on_got_ip;
+
+	void begin() {
+		this->on_connected = WiFi.onStationModeConnected([this](const WiFiEventStationModeConnected &) {
+			this->associated = true;
+			this->epoch = this->epoch + 1;
+		});
+		this->on_disconnected =
+		    WiFi.onStationModeDisconnected([this](const WiFiEventStationModeDisconnected &) {
+			    this->associated = false;
+			    this->got_ip = false;
+			    this->epoch = this->epoch + 1;
+		    });
+		this->on_got_ip = WiFi.onStationModeGotIP([this](const WiFiEventStationModeGotIP &) {
+			this->got_ip = true;
+			this->epoch = this->epoch + 1;
+		});
+	}
+
+	bool online() const {
+		return this->got_ip;
+	}
+};
+extern WifiEvents WIFI;
+
+// The access point of the last successful connection. The address always comes from DHCP,
+// a remembered lease would be used after the router gave it to someone else.
+struct WifiCache {
+	char ssid[24];
+	uint8_t bssid[6];
+	int32_t channel;
+};
+
 struct WifiThread : Thread {
+	// How long a directed connect to the cached access point, DHCP included, may take before
+	// falling back.
+	constexpr static const unsigned FAST_CONNECT_TIMEOUT_MS = 4000;
+	WifiCache cache;
+
 	void logprefix() {
 		Log.info("WIFI:");
 	}
+
+	// Connect straight to the cached BSSID and channel, which skips the scan.
+	bool fast_connect() {
+		if (!JOURNAL.get(JOURNAL_WIFI, this->cache) || !this->cache.channel) {
+			return false;
+		}
+		if (CONFIG.ssid[0] && strcmp(CONFIG.ssid, this->cache.ssid) != 0) {
+			return false;
+		}
+		this->infoln("Fast connecting to ", this->cache.ssid, " channel=", this->cache.channel);
+		WiFi.begin(this->cache.ssid, CONFIG.ssid[0] ? CONFIG.password : nullptr, this->cache.channel,
+			   this->cache.bssid, true);
+		return true;
+	}
+
+	void forget() {
+		WiFi.disconnect();
+		this->cache = {};
+		JOURNAL.put(JOURNAL_WIFI, this->cache);
+	}
+
+	void remember() {
+		WifiCache now = {};
+		strncpy(now.ssid, WiFi.SSID().c_str(), sizeof(now.ssid) - 1);
+		memcpy(now.bssid, WiFi.BSSID(), sizeof(now.bssid));
+		now.channel = WiFi.channel();
+		// Nothing is written when it did not change.
+		JOURNAL.put(JOURNAL_WIFI, now);
+	}
+
 	int run() {
 		TH_BEGIN();
+		// The SDK would otherwise write its own copy of the credentials to flash on every begin().
+		WiFi.persistent(false);
 		while (1) {
 			this->infoln("start");
 			WiFi.mode(WIFI_STA);
-			WiFi.disconnect();
-			TH_DELAY(1000);
-			if (CONFIG.ssid[0]) {
-				this->infoln("Connecting to ", CONFIG.ssid);
-				WiFi.begin(CONFIG.ssid, CONFIG.password);
-			} else {
-				this->infoln("Scan start");
-				WiFi.scanNetworks(true);
-				int n;
-				const int STILL_SCANNING = -1;
-				TH_WAIT_WHILE((n = WiFi.scanComplete()) == STILL_SCANNING);
-				this->infoln("WiFi.scanComplete=", n);
-				if (n < 0) {
-					TH_RESTART();
+			if (this->fast_connect()) {
+				if (TH_WAIT_WHILE_TIMEOUTED(!WIFI.online(), FAST_CONNECT_TIMEOUT_MS)) {
+					this->infoln("Fast connect failed, falling back to a full connect");
+					this->forget();
 				}
-				for (int i = 0; i < n; i++) {
-					if (WiFi.encryptionType(i) == ENC_TYPE_NONE) {
-						const auto ssid = WiFi.SSID(i);
-						this->infoln("Connecting to ", ssid);
-						WiFi.begin(ssid);
-						break;
+			}
+			if (!WIFI.online()) {
+				WiFi.disconnect();
+				TH_DELAY(1000);
+				if (CONFIG.ssid[0]) {
+					this->infoln("Connecting to ", CONFIG.ssid);
+					WiFi.begin(CONFIG.ssid, CONFIG.password);
+				} else {
+					this->infoln("Scan start");
+					WiFi.scanNetworks(true);
+					int n;
+					const int STILL_SCANNING = -1;
+					TH_WAIT_WHILE((n = WiFi.scanComplete()) == STILL_SCANNING);
+					this->infoln("WiFi.scanComplete=", n);
+					if (n < 0) {
+						TH_RESTART();
+					}
+					for (int i = 0; i < n; i++) {
+						if (WiFi.encryptionType(i) == ENC_TYPE_NONE) {
+							const auto ssid = WiFi.SSID(i);
+							this->infoln("Connecting to ", ssid);
+							WiFi.begin(ssid);
+							break;
+						}
 					}
 				}
+				TH_WAIT_WHILE(!WIFI.online());
 			}
-			TH_WAIT_WHILE(WiFi.status() != WL_CONNECTED);
-			while (WiFi.status() == WL_CONNECTED) {
-				this->infoln("Connection IP=", WiFi.localIP(), " RSSI=", WiFi.RSSI());
-				TH_DELAY(10000);
+			this->remember();
+			while (WIFI.online()) {
+				this->infoln("Connection IP=", WiFi.localIP(), " RSSI=", WiFi.RSSI(), " epoch=", WIFI.epoch);
+				TH_WAIT_WHILE_TIMEOUTED(WIFI.online(), 10000);
 			}
 			this->infoln("Lost connection!");
 		}
@@ -302,12 +457,34 @@ struct WebServerClient : Thread {
 		return 0;
 	}
 
-	constexpr static const std::array<Router, 5> routes = {
+	int serve_get_state() {
+		JsonDocument doc;
+		const State &state = STATE.front();
+		doc["version"] = STATE.version();
+		doc["now"] = millis();
+		JsonArray T = doc["T"].to<JsonArray>();
+		for (auto &&i : state.T) {
+			if (!i.ms) {
+				break;
+			}
+			JsonObject o = T.add<JsonObject>();
+			o["value"] = i.value;
+			o["ms"] = i.ms;
+			o["valid"] = i.valid;
+		}
+		this->send_header(STATUS_OK, measureJson(doc) + 2);
+		serializeJson(doc, this->client);
+		this->client.println();
+		return this->close();
+	}
+
+	constexpr static const std::array<Router, 6> routes = {
 	    Router{METHOD_GET, "/", &WebServerClient::serve_get_slash},
 	    Router{METHOD_GET, "/config", &WebServerClient::serve_get_config},
 	    Router{METHOD_POST, "/config", &WebServerClient::serve_post_config},
 	    Router{METHOD_GET, "/logsflush", &WebServerClient::serve_get_logsflush},
 	    Router{METHOD_GET, "/logs", &WebServerClient::serve_get_logs},
+	    Router{METHOD_GET, "/state", &WebServerClient::serve_get_state},
 	};
 
 	//////////////////////////////////////////////
@@ -394,6 +571,8 @@ struct WebServerClient : Thread {
 struct WebServerThread : Thread {
 	WiFiServer server;
 	StaticSlots<WebServerClient, 2> clients;
+	// WIFI.epoch the server was started in.
+	uint32_t epoch = 0;
 
 	virtual void logprefix() {
 		Log.info("WEBSERVER:");
@@ -404,29 +583,38 @@ struct WebServerThread : Thread {
 
 	int run() {
 		TH_BEGIN();
-		TH_WAIT_WHILE(WiFi.status() != WL_CONNECTED);
-		this->infoln("begin... ", WiFi.status(), " ", WL_CONNECTED);
-		this->server.begin();
 		while (1) {
-			TH_YIELD();
-			WiFiClient newClient = this->server.accept();
-			if (newClient) {
-				if (!this->clients.emplace_back(newClient)) {
-					WebServerClient tmp(newClient);
-					tmp.infoln("too many clients to accept");
-					tmp.close(tmp.STATUS_SERVICE_UNAVAILABLE);
-				} else {
-					this->infoln("accepting client from ", newClient.remoteIP(), ":",
-						     newClient.remotePort());
+			TH_WAIT_WHILE(!WIFI.online());
+			this->epoch = WIFI.epoch;
+			this->infoln("begin... epoch=", this->epoch);
+			this->server.begin();
+			while (WIFI.epoch == this->epoch) {
+				TH_YIELD();
+				WiFiClient newClient = this->server.accept();
+				if (newClient) {
+					if (!this->clients.emplace_back(newClient)) {
+						WebServerClient tmp(newClient);
+						tmp.infoln("too many clients to accept");
+						tmp.close(tmp.STATUS_SERVICE_UNAVAILABLE);
+					} else {
+						this->infoln("accepting client from ", newClient.remoteIP(), ":",
+							     newClient.remotePort());
+					}
+				}
+				for (auto it = this->clients.begin(); it != this->clients.end(); ++it) {
+					// this->infoln("handling client");
+					if (TH_IFEXITED(it->run())) {
+						this->infoln("erasing client");
+						this->clients.erase(it);
+					}
 				}
 			}
+			this->infoln("connectivity changed in epoch ", WIFI.epoch, ", dropping clients");
 			for (auto it = this->clients.begin(); it != this->clients.end(); ++it) {
-				// this->infoln("handling client");
-				if (TH_IFEXITED(it->run())) {
-					this->infoln("erasing client");
-					this->clients.erase(it);
-				}
+				it->close();
+				this->clients.erase(it);
 			}
+			this->server.stop();
 		}
 		TH_END();
 	}
@@ -452,13 +640,23 @@ struct KeepaliveThread : Thread {
 
 /////////////////////////////////////////////////////////////////////////////////////////////////
 
-struct State {
-	std::array<float, 10> T;
-	std::array<bool, 10> O;
-};
-static State STATE;
+#ifndef MY_DEEP_SLEEP_S
+// Seconds of deep sleep between two sweeps. 0 keeps the node awake with WiFi always on.
+#define MY_DEEP_SLEEP_S 0
+#endif
+#ifndef MY_UPLOAD_EVERY
+// Wakes between two uploads of the batched samples in the deep sleep mode.
+#define MY_UPLOAD_EVERY 6
+#endif
+
+#ifndef DEVICE_DISCONNECTED_C
+// What DallasTemperature returns for a sensor that did not answer.
+#define DEVICE_DISCONNECTED_C -127
+#endif
 
 struct StateThread : Thread {
+	// Sweeps between two writes of the counters to the journal.
+	constexpr static const unsigned SAVE_EVERY = 12;
 	DS18B20 ds;
 	int dscnt = 0;
 
@@ -491,10 +689,25 @@ struct StateThread : Thread {
 		return temp / 16.0;
 	}
 
+	// A sensor that drops off the bus mid read leaves 0xFF bytes, one shorting it leaves zeros.
+	bool scratchpad_ok() {
+		const uint8_t *sp = this->ds.selectedScratchpad;
+		bool zeros = true;
+		for (int i = 0; i < 8; i++) {
+			zeros = zeros && !sp[i];
+		}
+		return !zeros && OneWire::crc8(sp, 8) == sp[8];
+	}
+
+	void save_counters() {
+		JOURNAL.put(JOURNAL_COUNTERS, COUNTERS);
+	}
+
 	int run() {
 		TH_BEGIN();
 		while (1) {
-			for (dscnt = 0; dscnt < STATE.T.size() && this->ds.selectNext(); ++dscnt) {
+			STATE.begin_write();
+			for (dscnt = 0; dscnt < STATE.back().T.size() && this->ds.selectNext(); ++dscnt) {
 				uint8_t address[8];
 				this->ds.getAddress(address);
 				this->ds.sendCommand(MATCH_ROM, CONVERT_T, !this->ds.selectedPowerMode);
@@ -509,13 +722,27 @@ struct StateThread : Thread {
 					TH_DELAY(waittime);
 				}
 				this->ds.readScratchpad();
-				float v = this->getTempC();
-				STATE.T[dscnt] = this->ds.getTempC();
+				{
+					const float v = this->getTempC();
+					STATE.back().T[dscnt] = Reading{v, millis(), this->scratchpad_ok() && v != DEVICE_DISCONNECTED_C};
+				}
 				TH_YIELD();
 			}
-			this->infoln("Detected ", dscnt, " DS18B20 sensors");
-			for (int i = 0; i < dscnt; i++) {
-				this->infoln("STATE.T[", i, "]=", STATE.T[i]);
+			for (int i = dscnt; i < STATE.back().T.size(); i++) {
+				STATE.back().T[i].valid = false;
+			}
+			STATE.publish();
+			// A wake from deep sleep reloads COUNTERS, DutyCycleThread counts its sweeps.
+			if (!MY_DEEP_SLEEP_S && ++COUNTERS.sweeps % SAVE_EVERY == 0) {
+				this->save_counters();
+			}
+			// In the deep sleep mode the readings reach the log as the SAMPLE lines of an upload,
+			// and every byte logged on a wake that does not upload has to be kept until one does.
+			if (!MY_DEEP_SLEEP_S) {
+				this->infoln("Detected ", dscnt, " DS18B20 sensors in sweep ", STATE.version());
+				for (int i = 0; i < dscnt; i++) {
+					this->infoln("STATE.T[", i, "]=", STATE.front().T[i].value);
+				}
 			}
 			TH_DELAY(5000);
 		}
@@ -529,7 +756,7 @@ struct TimeSyncThread : Thread {
 	WiFiUDP ntpUDP;
 	NTPClient timeClient(ntpUDP);
 	void run() {
-		if (WiFi.status() == WL_CONNECTED) {
+		if (WIFI.online()) {
 			timeClient.update();
 		}
 	}
@@ -548,10 +775,16 @@ struct WiFiClientSecureWithWrite : public WiFiClientSecure {
 
 struct ForwardLogsThread : Thread {
 	WiFiClientSecureWithWrite client;
+	// Send whatever is buffered instead of waiting for the buffer to be half full.
+	bool flush = false;
+
+	virtual void logprefix() {
+		Log.info("LOKI:");
+	}
 
 	bool should_send_logs() {
 		const auto &buf = Log.buffer.buffer;
-		return WiFi.status() == WL_CONNECTED && buf.maxSize() < buf.size() * 2;
+		return WIFI.online() && (this->flush ? !buf.isEmpty() : buf.maxSize() < buf.size() * 2);
 	}
 
 	int run() {
@@ -561,6 +794,7 @@ struct ForwardLogsThread : Thread {
 			TH_WAIT_WHILE(!should_send_logs());
 			if (!client.connect(url, 443)) {
 				this->infoln("Connection to loki failed");
+				TH_DELAY(1000);
 			} else {
 				client.println("POST /loki/api/v1/push HTTP/1.0");
 				client.print("Host: ");
@@ -577,4 +811,103 @@ struct ForwardLogsThread : Thread {
 
 ///////////////////////////////////////////////////////////////
 
+// One wake of the deep sleep mode: wait for one sweep of StateThread, batch it in RTC memory,
+// upload the batch through ForwardLogsThread when it is due, keep the log lines that were not
+// uploaded in RTC memory and go back to sleep. The log lines only go to the journal when an
+// upload fails or they outgrow RTC memory.
+struct DutyCycleThread : Thread {
+	constexpr static const bool ENABLED = MY_DEEP_SLEEP_S != 0;
+	constexpr static const unsigned UPLOAD_TIMEOUT_MS = 10000;
+	DutyCycle<Esp8266Rtc, RtcReadings, 7> duty;
+	ForwardLogsThread &forward;
+	// Bytes at the start of the log that came from the journal.
+	size_t journaled = 0;
+	uint32_t version = 0;
+	bool uploading = false;
+	bool upload_failed = false;
+
+	DutyCycleThread(ForwardLogsThread &forward) : forward(forward) {
+	}
+
+	virtual void logprefix() {
+		Log.info("DUTY:");
+	}
+
+	// Called before anything is logged. Puts the log lines of the previous wakes in front of
+	// the ones of this wake, the journaled ones first. Returns false after a power loss, when
+	// RTC memory had nothing to restore.
+	bool restore() {
+		const bool woke = this->duty.wake(MY_UPLOAD_EVERY);
+		// After a power loss only the journal can tell whether it holds anything.
+		const int len = woke && !this->duty.mem.log_journaled ? 0 : JOURNAL.length(JOURNAL_LOGS);
+		auto &buf = Log.buffer.buffer;
+		if (len > 0 && len <= buf.maxSize() && JOURNAL.get(JOURNAL_LOGS, (void *)Log.buffer.linearize(), len)) {
+			Log.buffer.restore(len);
+			this->journaled = len;
+		}
+		this->duty.mem.log_journaled = this->journaled != 0;
+		for (const uint8_t *it = this->duty.log_begin(); it != this->duty.log_end(); ++it) {
+			buf.pushOverwrite(*it);
+		}
+		return woke;
+	}
+
+	void save_logs() {
+		const auto &buf = Log.buffer.buffer;
+		const uint8_t *const data = Log.buffer.linearize();
+		if (this->uploading && !this->upload_failed) {
+			// Whatever was journaled went out with the upload. Written once, the next empty
+			// record is skipped by the journal.
+			this->journaled = 0;
+			if (this->duty.mem.log_journaled) {
+				JOURNAL.put(JOURNAL_LOGS, data, 0);
+				this->duty.mem.log_journaled = false;
+			}
+		}
+		// A full ring may have overwritten journaled bytes, so it goes to the journal whole.
+		if (!this->upload_failed && buf.size() < buf.maxSize() &&
+		    this->duty.keep_log(data + this->journaled, buf.size() - this->journaled)) {
+			return;
+		}
+		JOURNAL.put(JOURNAL_LOGS, data, buf.size());
+		this->duty.mem.log_journaled = true;
+		this->duty.keep_log(data, 0);
+	}
+
+	int run() {
+		TH_BEGIN();
+		this->uploading = this->duty.upload_due();
+		this->version = STATE.version();
+		TH_WAIT_WHILE(STATE.version() == this->version);
+		this->duty.add(RtcReadings::from(SavedReadings::from(STATE.front())));
+		if (this->uploading) {
+			// One sweep per wake, the ones since the last upload wake are added up in RTC memory.
+			COUNTERS.sweeps += this->duty.take_wakes();
+			JOURNAL.put(JOURNAL_COUNTERS, COUNTERS);
+			this->infoln("wake ", this->duty.mem.wakes, " uploading ", this->duty.mem.count, " samples");
+			for (auto &&e : this->duty) {
+				Log.info("SAMPLE wake=", e.wake);
+				for (int i = 0; i < e.sample.T.size(); i++) {
+					if (e.sample.valid & (1 << i)) {
+						Log.info(" T", i, "=", e.sample.T[i] / 100.0f);
+					}
+				}
+				Log.infoln();
+			}
+			this->forward.flush = true;
+			if (TH_WAIT_WHILE_TIMEOUTED(!Log.buffer.buffer.isEmpty(), UPLOAD_TIMEOUT_MS)) {
+				this->upload_failed = true;
+				this->infoln("upload timed out, keeping ", this->duty.mem.count, " samples");
+			} else {
+				this->duty.clear();
+			}
+		}
+		this->save_logs();
+		this->duty.sleep(MY_DEEP_SLEEP_S * 1000000ull);
+		TH_END();
+	}
+};
+
+///////////////////////////////////////////////////////////////
+
 } // namespace my
@@ -6,6 +6,7 @@
 #include <ESP8266WiFi.h>
 #include <SafeString.h>
 #include <SafeStringReader.h>
+#include <algorithm>
 
 namespace my {
 
@@ -59,6 +60,20 @@ struct TimeAndLineStorage {
 		ret = now.ul;
 		return true;
 	}
+
+	// Move the oldest byte to the start of the storage, so the contents are one block.
+	const uint8_t *linearize() {
+		std::rotate(buffer.mBuffer, buffer.mBuffer + buffer.mReadIndex, buffer.mBuffer + buffer.maxSize());
+		buffer.mReadIndex = 0;
+		return buffer.mBuffer;
+	}
+	// After size bytes of a linearize()d storage were copied back into the start of it.
+	void restore(size_t size) {
+		buffer.mReadIndex = 0;
+		buffer.mSize = size;
+		linestarted = false;
+	}
+
 	bool read_line(uint8_t &c) {
 		if (!buffer.peek(c)) {
 			return false;
@@ -75,6 +75,100 @@ const uint16_t c_primeTable[] =
 
 WRContext* wr_createContext( WRState* w, const unsigned char* block, const int blockSize, bool takeOwnership, WRValue* stack =0 );
 
+#if defined(WRENCH_COMPILER_ARENA) && !defined(WRENCH_WITHOUT_COMPILER)
+#if WRENCH_COMPILER_ARENA_CHUNK > 16384
+#error WRENCH_COMPILER_ARENA_CHUNK must be 16384 or less
+#endif
+const unsigned int c_arenaClasses = 28; // blocks up to an eighth of the largest chunk, see wr_arenaClass()
+const uint32_t c_arenaHeapBlock = 0xFFFFFFFF; // marks a block that went to the heap on its own
+
+//-----------------------------------------------------------------------------
+// while wr_compile() runs WRarray, WRstr and WROpcodeStream take their
+// memory from here: small blocks are carved out of chunks and recycled
+// by size class when freed, and whatever is left is returned to the
+// heap in one go when the compile is over
+class WRCompilerArena
+{
+public:
+	WRCompilerArena();
+	~WRCompilerArena();
+
+	void* alloc( size_t size );
+	void free( void* p );
+	bool owns( const void* p ) const { return find(p) < m_chunkCount; }
+
+	unsigned int peak() const { return m_peak; }
+
+private:
+	struct Chunk
+	{
+		char* begin;
+		char* end;
+	};
+
+	char* newChunk( const size_t size );
+	void recycle( char* from, size_t bytes );
+	unsigned int find( const void* p ) const;
+
+	Chunk* m_chunks; // sorted by address
+	unsigned int m_chunkCount;
+	unsigned int m_chunkSlots;
+	unsigned int m_reserved;
+	unsigned int m_peak;
+
+	char* m_top;
+	char* m_end;
+	char* m_free[c_arenaClasses];
+};
+
+extern WRCompilerArena* g_compilerArena;
+
+inline void* wr_arenaMalloc( size_t size ) { return g_compilerArena ? g_compilerArena->alloc( size ) : g_malloc( size ); }
+inline void wr_arenaFree( void* p )
+{
+	if ( !p )
+	{
+		return;
+	}
+	
+	if ( g_compilerArena && g_compilerArena->owns(p) )
+	{
+		g_compilerArena->free( p );
+	}
+	else
+	{
+		g_free( p );
+	}
+}
+
+// memory handed to the caller must come from the heap, not the arena
+inline void* wr_arenaDetach( void* p, size_t size )
+{
+	if ( !g_compilerArena || !g_compilerArena->owns(p) )
+	{
+		return p;
+	}
+
+	void* ret = g_malloc( size );
+	if ( ret )
+	{
+		memcpy( ret, p, size );
+	}
+	g_compilerArena->free( p );
+	return ret;
+}
+#else
+inline void* wr_arenaMalloc( size_t size ) { return g_malloc( size ); }
+inline void wr_arenaFree( void* p ) { g_free( p ); }
+inline void* wr_arenaDetach( void* p, size_t /*size*/ ) { return p; }
+#endif
+
+#if __cplusplus > 199711L
+template <class T> inline T&& wr_move( T& t ) { return static_cast<T&&>(t); }
+#else
+template <class T> inline T& wr_move( T& t ) { return t; }
+#endif
+
 #ifndef WRENCH_WITHOUT_COMPILER
 
 #include <stdlib.h>
@@ -96,7 +190,7 @@ public:
 	{
 		if ( !size ) return 0;
 		
-		T* t = (T*)g_malloc( sizeof(T) * size );
+		T* t = (T*)wr_arenaMalloc( sizeof(T) * size );
 		for( int i=0; i<size; ++i )
 		{
 			new (&(t[i])) T();
@@ -115,7 +209,7 @@ public:
 			t[i].~T();
 		}
 
-		g_free( t );
+		wr_arenaFree( t );
 	}
 
 	//------------------------------------------------------------------------------
@@ -163,37 +257,20 @@ public:
 			newCount = m_elementsAllocated - count;
 		}
 
-		T* na = newArray( newCount );
-
-		if ( location == 0 )
+		// close the gap in place, what falls off the end is reset so
+		// it comes back fresh from append()
+		unsigned int j = location;
+		for( unsigned int i=location + count; i<m_elementsAllocated && j<newCount; ++i )
 		{
-			for( unsigned int i=0; i<(unsigned int)newCount; ++i )
-			{
-				na[i] = m_list[i+count];
-			}
+			m_list[j++] = wr_move( m_list[i] );
 		}
-		else
+		for( ; j<m_elementsAllocated; ++j )
 		{
-			unsigned int j = 0;
-			
-			unsigned int skipEnd = location + count;
-			for( unsigned int i=0; i<m_elementsAllocated; ++i )
-			{
-				if ( i < location )
-				{
-					na[j++] = m_list[i];
-				}
-				else if ( i >= skipEnd )
-				{
-					na[j++] = m_list[i];
-				}
-			}
+			m_list[j].~T();
+			new (&(m_list[j])) T();
 		}
 
-		deleteArray( m_list, m_elementsNewed );
-		m_list = na;
 		m_elementsAllocated = newCount;
-		m_elementsNewed = newCount;
 
 		return m_elementsAllocated;
 	}
@@ -210,7 +287,7 @@ public:
 			{
 				for( unsigned int i=0; i<m_elementsAllocated; ++i )
 				{
-					na[i] = m_list[i];
+					na[i] = wr_move( m_list[i] );
 				}
 
 				deleteArray( m_list, m_elementsNewed );
@@ -245,8 +322,7 @@ public:
 	//------------------------------------------------------------------------------
 	WRarray( const WRarray& A )
 	{
-		clear();
-		m_list = newArray( A.m_elementsAllocated );
+		m_list = newArray( A.m_elementsNewed );
 		m_elementsNewed = A.m_elementsNewed;
 		for( unsigned int i=0; i<A.m_elementsAllocated; ++i )
 		{
@@ -272,6 +348,30 @@ public:
 		return *this;
 	}
 
+#if __cplusplus > 199711L
+	WRarray( WRarray&& A ) : m_list(A.m_list), m_elementsNewed(A.m_elementsNewed), m_elementsAllocated(A.m_elementsAllocated)
+	{
+		A.m_list = 0;
+		A.m_elementsNewed = 0;
+		A.m_elementsAllocated = 0;
+	}
+
+	WRarray& operator= ( WRarray&& A )
+	{
+		if ( &A != this )
+		{
+			clear();
+			m_list = A.m_list;
+			m_elementsNewed = A.m_elementsNewed;
+			m_elementsAllocated = A.m_elementsAllocated;
+			A.m_list = 0;
+			A.m_elementsNewed = 0;
+			A.m_elementsAllocated = 0;
+		}
+		return *this;
+	}
+#endif
+
 	const T& operator[]( const unsigned int l ) const { return get(l); }
 	T& operator[]( const unsigned int l ) { return get(l); }
 
@@ -309,7 +409,7 @@ public:
 	{
 		if ( !size ) return 0;
 
-		Node* n = (Node*)g_malloc( sizeof(Node) * size );
+		Node* n = (Node*)wr_arenaMalloc( sizeof(Node) * size );
 		for( int i=0; i<size; ++i )
 		{
 			new (&(n[i].value)) T();
@@ -329,7 +429,7 @@ public:
 			n[i].value.~T();
 		}
 
-		g_free( n );
+		wr_arenaFree( n );
 	}
 
 	//------------------------------------------------------------------------------
@@ -1470,6 +1570,31 @@ struct WRFunction
 	uint8_t arguments;
 	uint8_t frameSpaceNeeded;
 	uint8_t frameBaseAdjustment;
+
+#ifdef WRENCH_JIT
+	uint16_t jitCalls; // counts up to WRENCH_JIT_THRESHOLD
+	struct WRJitCode* jit; // machine code, once translated
+#endif
+#ifdef WRENCH_AOT
+	const WRNativeFunction* native; // from a module of wr_addNativeModule()
+#endif
+};
+
+//------------------------------------------------------------------------------
+// where a hash was last found in the globalRegistry, see wr_linked()
+struct WRLinkSlot
+{
+	uint32_t hash;
+	uint32_t index; // +1, zero is an empty slot
+};
+
+//------------------------------------------------------------------------------
+// what an O_*IndexHash site found last time, see wr_indexHashCached()
+struct WRIndexCache
+{
+	uint32_t site; // pc offset +1, zero is an empty entry
+	uint32_t index; // struct member or hash table index
+	const unsigned char* layout; // the struct hash table, null for hash tables
 };
 
 //------------------------------------------------------------------------------
@@ -1518,9 +1643,19 @@ struct WRContext
 
 	WRFunction* localFunctions;
 	uint8_t numLocalFunctions;
+
+	WRLinkSlot links[WRENCH_LINK_SLOTS];
+	WRIndexCache indexCache[WRENCH_INDEX_CACHE_SLOTS];
+
+	WRGCObject literalViews[2]; // see O_LiteralStringView, both sides of a compare can be one
+	uint8_t literalView;
 	
 	WRContext* imported; // linked list of contexts this one imported
 
+#ifdef WRENCH_SAMPLE_PROFILER
+	uint16_t line; // of the last WRD_LineNumber executed
+#endif
+
 	void mark( WRValue* s );
 	void gc( WRValue* stackTop );
 	
@@ -1535,6 +1670,15 @@ struct WRLibraryCleanup
 	WRLibraryCleanup* next;
 };
 
+#ifdef WRENCH_AOT
+//------------------------------------------------------------------------------
+struct WRNativeModuleLink
+{
+	const WRNativeModule* module;
+	WRNativeModuleLink* next;
+};
+#endif
+
 //------------------------------------------------------------------------------
 struct WRState
 {
@@ -1546,10 +1690,19 @@ struct WRState
 	int sliceInstructionCount;
 	int yieldEnabled;
 #endif
+
+#ifdef WRENCH_SAMPLE_PROFILER
+	struct WRSampler* sampler;
+	uint32_t sampleCountdown;
+#endif
 	
 	WRContext* contextList;
 
 	WRLibraryCleanup* libCleanupFunctions;
+
+#ifdef WRENCH_AOT
+	WRNativeModuleLink* nativeModules;
+#endif
 	
 	WRGCObject globalRegistry;
 };
@@ -1690,6 +1843,7 @@ uint32_t wr_hashStr_read8( const char* dat );
 
  #ifndef READ_8_FROM_PC
   #define READ_8_FROM_PC(P) (*(P))
+  #define WRENCH_DIRECT_CODE_READS // the code stream can be pointed at
  #endif
 
 #endif
@@ -1720,6 +1874,15 @@ SOFTWARE.
 #define _OPCODE_H
 /*------------------------------------------------------------------------------*/
 
+// superinstructions generated from the opcode pair profile of a
+// corpus, see bench/wrench_super.cpp. Each entry is
+// X( NAME, FIRST, SECOND_AS_PUSHED, SECOND )
+#ifdef WRENCH_NO_SUPERINSTRUCTIONS
+#define WRENCH_SUPERINSTRUCTIONS( X )
+#else
+#include "wrench_super.h"
+#endif
+
 //------------------------------------------------------------------------------
 enum WROpcode
 {
@@ -2021,6 +2184,20 @@ enum WROpcode
 	O_InitVar,
 
 	O_DebugInfo,
+
+	// opcodes added since 6.0.4 go after the ones it shipped with, so
+	// the bytecode it compiled keeps its numbering
+	O_LiteralStringView,
+
+	// what WRENCH_QUICKEN rewrites the generic operations into
+	O_BinaryAdditionNumeric,
+	O_BinarySubtractionNumeric,
+	O_BinaryMultiplicationNumeric,
+
+	O_RelativeJump32,
+
+#define WR_SUPER_ENUM( NAME, FIRST, SECOND_AS_PUSHED, SECOND ) O_##NAME,
+	WRENCH_SUPERINSTRUCTIONS( WR_SUPER_ENUM )
 				
 	// non-interpreted opcodes
 	O_HASH_PLACEHOLDER,
@@ -2029,6 +2206,15 @@ enum WROpcode
 	O_LAST,
 };
 
+// opcodes a superinstruction can start with and the size of their
+// operands, the interpreter half is WR_SUPER_FIRST_<opcode>
+#define WR_SUPER_OPERANDS_LoadFromLocal 1
+#define WR_SUPER_OPERANDS_LoadFromGlobal 1
+#define WR_SUPER_OPERANDS_LiteralInt8 1
+#define WR_SUPER_OPERANDS_LiteralInt16 2
+#define WR_SUPER_OPERANDS_LiteralFloat 4
+#define WR_SUPER_OPERANDS_IncLocal 1
+
 extern const char* c_opcodeName[];
 
 #endif
@@ -2154,6 +2340,34 @@ public:
 	WRstr& operator = ( const char* c ) { set(c, (unsigned int)strlen(c)); return *this; }
 	WRstr& operator = ( const char c ) { set(&c, 1); return *this; }
 
+#if __cplusplus > 199711L
+	WRstr( WRstr&& str ) { m_len = 0; m_smallbuf[0] = 0; m_str = m_smallbuf; m_buflen = c_sizeofBaseString; take( str ); }
+	WRstr& operator = ( WRstr&& str ) { if ( &str != this ) take( str ); return *this; }
+
+	// steal the buffer of 'str' if it has one, leaving it empty
+	void take( WRstr& str )
+	{
+		if ( str.m_str == str.m_smallbuf )
+		{
+			set( str.m_str, str.m_len );
+			return;
+		}
+
+		if ( m_str != m_smallbuf )
+		{
+			wr_arenaFree( m_str );
+		}
+		m_str = str.m_str;
+		m_len = str.m_len;
+		m_buflen = str.m_buflen;
+
+		str.m_str = str.m_smallbuf;
+		str.m_buflen = c_sizeofBaseString;
+		str.m_len = 0;
+		str.m_smallbuf[0] = 0;
+	}
+#endif
+
 	friend bool operator == ( const WRstr& s1, const WRstr& s2 ) { return s1.m_len == s2.m_len && (strncmp(s1.m_str, s2.m_str, s1.m_len) == 0); }
 	friend bool operator == ( const char* z, const WRstr& s ) { return s.isMatch( z ); }
 	friend bool operator == ( const WRstr& s, const char* z ) { return s.isMatch( z ); }
@@ -2169,7 +2383,7 @@ public:
 	friend WRstr operator + ( const char c, const WRstr& str ) { WRstr T(c); T += str; return T; }
 	friend WRstr operator + ( const WRstr& str1, const WRstr& str2 ) { WRstr T(str1); T += str2; return T; }
 
-	~WRstr() { if ( m_str != m_smallbuf ) g_free(m_str); }
+	~WRstr() { if ( m_str != m_smallbuf ) wr_arenaFree(m_str); }
 
 protected:
 
@@ -2361,7 +2575,7 @@ void WRstr::release( char** toBuf, unsigned int* len )
 	}
 	else
 	{
-		*toBuf = m_str;
+		*toBuf = (char*)wr_arenaDetach( m_str, m_len + 1 );
 		m_str = m_smallbuf;
 		m_buflen = c_sizeofBaseString;
 	}
@@ -2381,14 +2595,14 @@ WRstr& WRstr::giveOwnership( char* buf, const unsigned int len )
 
 	if ( m_str != m_smallbuf )
 	{
-		g_free( m_str );
+		wr_arenaFree( m_str );
 	}
 
 	if ( len < c_sizeofBaseString )
 	{
 		m_str = m_smallbuf;
 		memcpy( m_str, buf, len );
-		g_free( buf );
+		wr_arenaFree( buf );
 		m_len = len;
 	}
 	else
@@ -2441,7 +2655,7 @@ WRstr& WRstr::alloc( const unsigned int characters, const bool preserveContents
 {
 	if ( characters >= m_buflen ) // only need to alloc if more space is requested than we have
 	{
-		char* newStr = (char*)g_malloc( characters + 1 ); // create the space
+		char* newStr = (char*)wr_arenaMalloc( characters + 1 ); // create the space
 
 		if ( preserveContents ) 
 		{
@@ -2450,7 +2664,7 @@ WRstr& WRstr::alloc( const unsigned int characters, const bool preserveContents
 
 		if ( m_str != m_smallbuf )
 		{
-			g_free( m_str );
+			wr_arenaFree( m_str );
 		}
 
 		m_str = newStr;
@@ -2474,7 +2688,7 @@ WRstr& WRstr::truncate( const unsigned int newLen )
 		{
 			m_buflen = c_sizeofBaseString;
 			memcpy( m_smallbuf, m_str, newLen );
-			g_free( m_str );
+			wr_arenaFree( m_str );
 			m_str = m_smallbuf;
 		}
 	}
@@ -2690,25 +2904,27 @@ WRstr& WRstr::appendFormatVA( const char* format, va_list arg )
 {
 	char buf[ c_formatBaseTrySize + 1 ]; // SOME space, malloc if we need a ton more
 
+	// 'arg' is consumed by the first attempt
+	va_list vacopy;
+	va_copy( vacopy, arg );
 	int len = vsnprintf( buf, c_formatBaseTrySize, format, arg );
 
 	if ( len < c_formatBaseTrySize )
 	{
+		va_end( vacopy );
 		insert( buf, len, m_len );
 	}
 	else
 	{
-		char* alloc = (char*)g_malloc( len + 1 );
+		char* alloc = (char*)wr_arenaMalloc( len + 1 );
 
-		va_list vacopy;
-		va_copy( vacopy, arg );
-		len = vsnprintf( alloc, len, format, arg );
+		len = vsnprintf( alloc, len + 1, format, vacopy );
 		va_end( vacopy );
 
 		if ( m_len )
 		{
 			insert( alloc, len, m_len );
-			g_free( alloc );
+			wr_arenaFree( alloc );
 		}
 		else
 		{
@@ -2737,7 +2953,7 @@ WRstr& WRstr::format( const char* format, ... )
 	}
 	else
 	{
-		char* alloc = (char*)g_malloc(len + 1);
+		char* alloc = (char*)wr_arenaMalloc(len + 1);
 
 		va_start( arg, format );
 		len = vsnprintf( alloc, len, format, arg );
@@ -2765,7 +2981,7 @@ WRstr& WRstr::appendFormat( const char* format, ... )
 	}
 	else
 	{
-		char* alloc = (char*)g_malloc(len + 1);
+		char* alloc = (char*)wr_arenaMalloc(len + 1);
 
 		va_start( arg, format );
 		len = vsnprintf( alloc, len, format, arg );
@@ -2774,7 +2990,7 @@ WRstr& WRstr::appendFormat( const char* format, ... )
 		if ( m_len )
 		{
 			insert( alloc, len, m_len );
-			g_free( alloc );
+			wr_arenaFree( alloc );
 		}
 		else
 		{
@@ -2824,7 +3040,7 @@ public:
 	WROpcodeStream& clear()
 	{
 		m_len = 0;
-		g_free( m_buf );
+		wr_arenaFree( m_buf );
 		m_buf = 0;
 		m_bufLen = 0;
 		return *this;
@@ -2846,6 +3062,23 @@ public:
 		return *this;
 	}
 
+#if __cplusplus > 199711L
+	WROpcodeStream( WROpcodeStream&& other ) : m_buf(other.m_buf), m_len(other.m_len), m_bufLen(other.m_bufLen) { other.m_buf = 0; other.clear(); }
+	WROpcodeStream& operator = ( WROpcodeStream&& str )
+	{
+		if ( &str != this )
+		{
+			clear();
+			m_buf = str.m_buf;
+			m_len = str.m_len;
+			m_bufLen = str.m_bufLen;
+			str.m_buf = 0;
+			str.clear();
+		}
+		return *this;
+	}
+#endif
+
 	WROpcodeStream& operator += ( const WROpcodeStream& stream ) { return append(stream.m_buf, stream.m_len); }
 	WROpcodeStream& operator += ( const unsigned char data ) { return append(&data, 1); }
 	WROpcodeStream& append( const unsigned char* data, const int size )
@@ -2853,13 +3086,14 @@ public:
 		if ( (size + m_len) >= m_bufLen )
 		{
 			unsigned char* buf = m_buf;
-			m_bufLen = size + m_len + 16;
-			m_buf = (unsigned char *)g_malloc( m_bufLen );
+			m_bufLen = size + m_len;
+			m_bufLen += (m_bufLen >> 1) + 16; // grow geometrically, code is appended a few bytes at a time
+			m_buf = (unsigned char *)wr_arenaMalloc( m_bufLen );
 			if ( m_len )
 			{
 				memcpy( m_buf, buf, m_len );
-				g_free( buf );
 			}
+			wr_arenaFree( buf );
 		}
 
 		memcpy( m_buf + m_len, data, size );
@@ -2881,8 +3115,17 @@ public:
 	unsigned int release( unsigned char** toBuf )
 	{
 		unsigned int retLen = m_len;
-		*toBuf = m_buf;
-		m_buf = 0;
+		if ( m_len && m_bufLen > m_len + 16 )
+		{
+			// leave the room it grew into behind
+			*toBuf = (unsigned char *)g_malloc( m_len );
+			memcpy( *toBuf, m_buf, m_len );
+		}
+		else
+		{
+			*toBuf = (unsigned char*)wr_arenaDetach( m_buf, m_len );
+			m_buf = 0;
+		}
 		clear();
 		return retLen;
 	}
@@ -3054,14 +3297,110 @@ struct WRNamespaceLookup
 	}
 };
 
+//------------------------------------------------------------------------------
+// open-addressed index over a localSpace so symbol lookups do not have
+// to walk it; entries are picked up lazily as the space grows and the
+// first of any equal hashes wins, same as a linear scan. Short-lived
+// copies (most expressions) are only scanned, building an index for
+// one or two lookups costs more than it saves
+struct WRNamespaceIndex
+{
+	uint16_t* slots; // entry + 1, 0 is empty
+	unsigned int mask;
+	unsigned int indexed;
+	unsigned int scans;
+
+	WRNamespaceIndex() : slots(0), mask(0), indexed(0), scans(0) {}
+	WRNamespaceIndex( const WRNamespaceIndex& ) : slots(0), mask(0), indexed(0), scans(0) {}
+	WRNamespaceIndex& operator= ( const WRNamespaceIndex& ) { clear(); return *this; }
+	~WRNamespaceIndex() { clear(); }
+
+	void clear()
+	{
+		if ( slots )
+		{
+			wr_arenaFree( slots );
+			slots = 0;
+		}
+		mask = 0;
+		indexed = 0;
+		scans = 0;
+	}
+
+	int find( WRarray<WRNamespaceLookup>& space, const uint32_t hash );
+};
+
+//------------------------------------------------------------------------------
+int WRNamespaceIndex::find( WRarray<WRNamespaceLookup>& space, const uint32_t hash )
+{
+	const unsigned int count = space.count();
+	if ( count < indexed )
+	{
+		clear();
+	}
+
+	if ( !slots && (count < 16 || ++scans < 4 || count >= 0xFFFF) )
+	{
+		for( unsigned int i=0; i<count; ++i )
+		{
+			if ( space[i].hash == hash )
+			{
+				return i;
+			}
+		}
+		return -1;
+	}
+
+	if ( count*2 > mask )
+	{
+		// (re)build at no more than half full
+		unsigned int size = 32;
+		while( size < count*2 + 2 )
+		{
+			size <<= 1;
+		}
+
+		if ( slots )
+		{
+			wr_arenaFree( slots );
+		}
+		slots = (uint16_t*)wr_arenaMalloc( size * sizeof(uint16_t) );
+		memset( slots, 0, size * sizeof(uint16_t) );
+		mask = size - 1;
+		indexed = 0;
+	}
+
+	for( ; indexed < count; ++indexed )
+	{
+		const uint32_t h = space[indexed].hash;
+		unsigned int s = (h ^ (h >> 16)) & mask;
+		for( ; slots[s] && space[slots[s] - 1].hash != h; s = (s + 1) & mask );
+		if ( !slots[s] )
+		{
+			slots[s] = (uint16_t)(indexed + 1);
+		}
+	}
+
+	for( unsigned int s = (hash ^ (hash >> 16)) & mask; slots[s]; s = (s + 1) & mask )
+	{
+		if ( space[slots[s] - 1].hash == hash )
+		{
+			return slots[s] - 1;
+		}
+	}
+
+	return -1;
+}
+
 //------------------------------------------------------------------------------
 struct BytecodeJumpOffset
 {
-	int offset;
+	int offset; // -1 until it is set
 	WRarray<int> references;
+	unsigned int resolved; // how many of the references point at 'offset'
 	uint32_t gotoHash;
 	
-	BytecodeJumpOffset() : offset(0), gotoHash(0) {}
+	BytecodeJumpOffset() : offset(-1), resolved(0), gotoHash(0) {}
 };
 
 //------------------------------------------------------------------------------
@@ -3083,9 +3422,15 @@ struct WRBytecode
 	WRarray<WRNamespaceLookup> functionSpace;
 	WRarray<WRNamespaceLookup> unitObjectSpace;
 
+	WRNamespaceIndex localIndex; // over localSpace, see findLocal()
+
 	void invalidateOpcodeCache() { opcodes.clear(); }
+
+	// index of 'hash' in localSpace or -1
+	int findLocal( const uint32_t hash ) { return localIndex.find( localSpace, hash ); }
 	
 	WRarray<BytecodeJumpOffset> jumpOffsetTargets;
+	WRarray<int> jumpsPending; // targets set or referenced since the last resolveRelativeJumps()
 	WRarray<GotoSource> gotoSource;
 	
 	void clear()
@@ -3094,11 +3439,13 @@ struct WRBytecode
 		opcodes.clear();
 		isStructSpace = false;
 		localSpace.clear();
+		localIndex.clear();
 		
 		functionSpace.clear();
 		unitObjectSpace.clear();
 		
 		jumpOffsetTargets.clear();
+		jumpsPending.clear();
 		gotoSource.clear();
 		
 		isStructSpace = false;
@@ -3129,10 +3476,15 @@ struct WRExpressionContext
 	void setLocalSpace( WRarray<WRNamespaceLookup>& localSpace, bool isStructSpace )
 	{
 		bytecode.localSpace.clear();
+		bytecode.localIndex.clear();
 		bytecode.isStructSpace = isStructSpace;
+		if ( localSpace.count() )
+		{
+			bytecode.localSpace.setCount( localSpace.count() );
+		}
 		for( unsigned int l=0; l<localSpace.count(); ++l )
 		{
-			bytecode.localSpace.append().hash = localSpace[l].hash;
+			bytecode.localSpace[l].hash = localSpace[l].hash;
 		}
 		type = EXTYPE_NONE;
 	}
@@ -3229,9 +3581,13 @@ public:
 	{
 		reset();
 		bytecode.isStructSpace = isStructSpace;
+		if ( localSpace.count() )
+		{
+			bytecode.localSpace.setCount( localSpace.count() );
+		}
 		for( unsigned int l=0; l<localSpace.count(); ++l )
 		{
-			bytecode.localSpace.append().hash = localSpace[l].hash;
+			bytecode.localSpace[l].hash = localSpace[l].hash;
 		}
 	}
 
@@ -3270,6 +3626,8 @@ struct WRUnitContext
 	WRBytecode bytecode;
 
 	int parentUnitIndex;
+
+	bool complete; // parsed to the closing brace, its locals are final
 	
 	WRUnitContext() { reset(); }
 	void reset()
@@ -3284,9 +3642,15 @@ struct WRUnitContext
 		offsetOfLocalHashMap = 0;
 		bytecode.clear();
 		parentUnitIndex = 0;
+		complete = false;
 	}
 };
 
+struct WROptimizer;
+
+// times the loops of a function are reshaped, one of them each time
+#define WR_OPT_LOOP_PASSES 16
+
 //------------------------------------------------------------------------------
 struct WRCompilationContext
 {
@@ -3296,7 +3660,10 @@ public:
 					 unsigned char** out,
 					 int* outLen,
 					 char* erroMsg,
-					 const uint8_t compilerOptionFlags );
+					 const uint8_t compilerOptionFlags,
+					 const bool farJumps =false );
+
+	bool m_jumpOutOfRange; // needs compiling again with farJumps
 
 private:
 	
@@ -3309,6 +3676,7 @@ private:
 	static bool CheckFastLoad( WROpcode opcode, WRBytecode& bytecode, int a, int o );
 	static bool IsLiteralLoadOpcode( unsigned char opcode );
 	static bool CheckCompareReplace( WROpcode LS, WROpcode GS, WROpcode ILS, WROpcode IGS, WRBytecode& bytecode, unsigned int a, unsigned int o );
+	static void MarkSuperinstruction( WROpcode opcode, WRBytecode& bytecode );
 
 	friend class WRExpression;
 	static void pushOpcode( WRBytecode& bytecode, WROpcode opcode );
@@ -3321,10 +3689,14 @@ private:
 	bool m_embedGlobalSymbols;
 	bool m_embedSourceCode;
 	bool m_needVar;
+	bool m_optimize;
+	bool m_farJumps; // every jump is 32-bit, see resolveRelativeJumps()
 	bool m_exportNextUnit;
 	
 	uint16_t m_lastCode;
 	uint16_t m_lastParam;
+	int m_linePos; // how far the lines have been counted
+	int m_line; // and the line that is on
 	void pushDebug( uint16_t code, WRBytecode& bytecode,int param );
 	int getSourcePosition();
 	int getSourcePosition( int& onLine, int& onChar, WRstr* line =0 );
@@ -3333,11 +3705,13 @@ private:
 	void setRelativeJumpTarget( WRBytecode& bytecode, int relativeJumpTarget );
 	void addRelativeJumpSourceEx( WRBytecode& bytecode, WROpcode opcode, int relativeJumpTarget, const unsigned char* data, const int dataSize );
 	void addRelativeJumpSource( WRBytecode& bytecode, WROpcode opcode, int relativeJumpTarget );
+	void addRelativeJumpReference( WRBytecode& bytecode, int relativeJumpTarget, int offset );
+	void addFarJump( WRBytecode& bytecode, int via, int relativeJumpTarget );
 	void resolveRelativeJumps( WRBytecode& bytecode );
 
 	void appendBytecode( WRBytecode& bytecode, WRBytecode& addMe );
 	
-	void pushLiteral( WRBytecode& bytecode, WRExpressionContext& context );
+	void pushLiteral( WRBytecode& bytecode, WRExpressionContext& context, WROpcode stringOpcode =O_LiteralString );
 	void pushLibConstant( WRBytecode& bytecode, WRExpressionContext& context );
 	int addLocalSpaceLoad( WRBytecode& bytecode, WRstr& token, bool addOnly, bool varSeen );
 	int addGlobalSpaceLoad( WRBytecode& bytecode, WRstr& token, bool addOnly, bool varSeen );
@@ -3348,6 +3722,7 @@ private:
 
 	bool operatorFound( WRstr const& token, WRarray<WRExpressionContext>& context, int depth );
 	bool parseCallFunction( WRExpression& expression, WRstr functionName, int depth, bool parseArguments );
+	int memberOffset( WRUnitContext& unit, uint32_t hash );
 	bool pushObjectTable( WRExpressionContext& context, WRarray<WRNamespaceLookup>& localSpace, uint32_t hash );
 	int parseInitializer( WRExpression& expression, int depth );
 	char parseExpression( WRExpression& expression );
@@ -3357,12 +3732,16 @@ private:
 	bool parseForLoop( bool& returnCalled, WROpcode opcodeToReturn );
 	bool lookupConstantValue( WRstr& prefix, WRValue* value =0 );
 	bool parseEnum( int unitIndex );
-	uint32_t getSingleValueHash( const char* end );
+	uint32_t getSingleValueHash( const char* end, bool& integer );
 	bool parseSwitch( bool& returnCalled, WROpcode opcodeToReturn );
 	bool parseIf( bool& returnCalled, WROpcode opcodeToReturn );
 	bool parseStatement( int unitIndex, char end, bool& returnCalled, WROpcode opcodeToReturn );
 
 	void createLocalHashMap( WRUnitContext& unit, unsigned char** buf, int* size );
+	void optimizeUnit( WRUnitContext& unit, const bool inlining, const int loops );
+	bool inlineCalls( WRUnitContext& unit, WROptimizer& o );
+	bool reshapeLoop( WRUnitContext& unit, WROptimizer& o );
+	void storeUnit( WRUnitContext& unit, WROptimizer& o );
 	void link( unsigned char** out, int* outLen, const uint8_t compilerOptionFlags );
 
 	const char* m_source;
@@ -3381,6 +3760,7 @@ private:
 	WRstr m_loadedToken;
 	WRValue m_loadedValue;
 	bool m_loadedQuoted;
+	unsigned int m_macros; // where the macros start in c_operations
 	
 	WRError m_err;
 	bool m_EOF;
@@ -3797,6 +4177,10 @@ void wr_ioPushConstants( WRState* w );
 
 void wr_stdout( const char* data, const int size );
 
+// whole files for native code, *data is g_malloc'ed
+bool wr_readFileBytes( const char* fileName, char** data, unsigned int* len );
+bool wr_writeFileBytes( const char* fileName, const char* data, const unsigned int len );
+
 #endif
 /*******************************************************************************
 Copyright (c) 2024 Curt Hartung -- curt.hartung@gmail.com
@@ -3861,7 +4245,8 @@ WRError WRCompilationContext::compile( const char* source,
 									   unsigned char** out,
 									   int* outLen,
 									   char* errorMsg,
-									   const uint8_t compilerOptionFlags )
+									   const uint8_t compilerOptionFlags,
+									   const bool farJumps )
 {
 	m_source = source;
 	m_sourceLen = size;
@@ -3871,6 +4256,10 @@ WRError WRCompilationContext::compile( const char* source,
 
 	m_lastParam = 0;
 	m_lastCode = 0;
+	m_linePos = 0;
+	m_line = 1;
+
+	for( m_macros = 0; c_operations[m_macros].token && strcmp(c_operations[m_macros].token, "@macroBegin"); ++m_macros );
 
 	m_pos = 0;
 	m_err = WR_ERR_None;
@@ -3890,6 +4279,9 @@ WRError WRCompilationContext::compile( const char* source,
 	m_embedSourceCode = compilerOptionFlags & WR_EMBED_SOURCE_CODE;
 	m_embedGlobalSymbols = compilerOptionFlags != 0; // (WR_INCLUDE_GLOBALS)
 	m_needVar = !(compilerOptionFlags & WR_NON_STRICT_VAR);
+	m_optimize = compilerOptionFlags & WR_OPTIMIZE;
+	m_farJumps = farJumps;
+	m_jumpOutOfRange = false;
 
 	do
 	{
@@ -3907,7 +4299,12 @@ WRError WRCompilationContext::compile( const char* source,
 		
 		parseStatement( 0, ';', returnCalled, O_GlobalStop );
 
-	} while ( !m_EOF && (m_err == WR_ERR_None) );
+	} while ( !m_EOF && (m_err == WR_ERR_None) && !m_jumpOutOfRange );
+
+	if ( m_jumpOutOfRange && m_err == WR_ERR_None )
+	{
+		return WR_ERR_None; // wr_compile() goes again
+	}
 
 	WRstr msg;
 
@@ -3962,2114 +4359,2335 @@ WRError WRCompilationContext::compile( const char* source,
 	return m_err;
 }
 
+#ifdef WRENCH_COMPILER_ARENA
+WRCompilerArena* g_compilerArena = 0;
+static unsigned int g_compilerPeak = 0;
+
 //------------------------------------------------------------------------------
-WRError wr_compile( const char* source,
-					const int size,
-					unsigned char** out,
-					int* outLen,
-					char* errMsg,
-					const uint8_t compilerOptionFlags )
+unsigned int wr_compilerPeakMemory()
 {
-	assert( sizeof(float) == 4 );
-	assert( sizeof(int) == 4 );
-	assert( sizeof(char) == 1 );
-	assert( O_LAST < 255 );
+	return g_compilerPeak;
+}
+
+//------------------------------------------------------------------------------
+// size classes are 8 byte steps up to 64 and then four per power of
+// two, so no block is more than a quarter larger than it was asked for
+static unsigned int wr_arenaClass( const size_t bytes )
+{
+	if ( bytes <= 64 )
+	{
+		return (unsigned int)((bytes + 7) >> 3) - 1;
+	}
 
-	// create a compiler context that has all the necessary stuff so it's completely unloaded when complete
-	WRCompilationContext comp; 
+	unsigned int e = 6;
+	while( (bytes - 1) >> (e + 1) )
+	{
+		++e;
+	}
+	const unsigned int k = (unsigned int)((bytes + ((size_t)1 << (e - 2)) - 1) >> (e - 2)); // 5..8
 
-	return comp.compile( source, size, out, outLen, errMsg, compilerOptionFlags );
+	return 8 + ((e - 6) << 2) + (k - 5);
 }
 
 //------------------------------------------------------------------------------
-void streamDump( WROpcodeStream const& stream )
+static size_t wr_arenaClassSize( const unsigned int c )
 {
-	WRstr str;
-	wr_asciiDump( stream, stream.size(), str );
-	printf( "%d:\n%s\n", stream.size(), str.c_str() );
+	if ( c < 8 )
+	{
+		return (c + 1) << 3;
+	}
+	
+	return (size_t)(5 + ((c - 8) & 3)) << (4 + ((c - 8) >> 2));
 }
 
 //------------------------------------------------------------------------------
-bool WRCompilationContext::isValidLabel( WRstr& token, bool& isGlobal, WRstr& prefix, bool& isLibConstant )
+WRCompilerArena::WRCompilerArena()
 {
-	isLibConstant = false;
-	
-	prefix.clear();
+	memset( (unsigned char*)this, 0, sizeof(WRCompilerArena) );
+}
 
-	if ( !token.size() || (!isalpha(token[0]) && token[0] != '_' && token[0] != ':') ) // non-zero size and start with alpha or '_' ?
+//------------------------------------------------------------------------------
+WRCompilerArena::~WRCompilerArena()
+{
+	for( unsigned int c=0; c<m_chunkCount; ++c )
 	{
-		return false;
+		g_free( m_chunks[c].begin );
 	}
+	g_free( m_chunks );
+}
 
-	isGlobal = false;
-
-	if ( token[0] == ':' )
+//------------------------------------------------------------------------------
+char* WRCompilerArena::newChunk( const size_t size )
+{
+	if ( m_chunkCount >= m_chunkSlots )
 	{
-		if ( (token.size() > 2) && (token[1] == ':') )
+		m_chunkSlots = m_chunkSlots ? m_chunkSlots * 2 : 16;
+		Chunk* chunks = (Chunk*)g_malloc( m_chunkSlots * sizeof(Chunk) );
+		if ( !chunks )
 		{
-			isGlobal = true;
+			return 0;
 		}
-		else
+		if ( m_chunks )
 		{
-			return false;
+			memcpy( chunks, m_chunks, m_chunkCount * sizeof(Chunk) );
+			g_free( m_chunks );
 		}
+		m_chunks = chunks;
 	}
 
-	for( unsigned int i=0; c_reserved[i][0]; ++i )
+	char* chunk = (char*)g_malloc( size );
+	if ( !chunk )
 	{
-		if ( token == c_reserved[i] )
-		{
-			return false;
-		}
+		return 0;
 	}
 
-	bool foundColon = false;
-	for( unsigned int i=0; i<token.size(); i++ ) // entire token alphanumeric or '_'?
+	unsigned int c = m_chunkCount++;
+	for( ; c && m_chunks[c - 1].begin > chunk; --c )
 	{
-		if ( token[i] == ':' )
-		{
-			if ( token[++i] != ':' )
-			{
-				m_err = WR_ERR_unexpected_token;
-				return false;
-			}
-
-			foundColon = true;
+		m_chunks[c] = m_chunks[c - 1];
+	}
+	m_chunks[c].begin = chunk;
+	m_chunks[c].end = chunk + size;
 
-			if ( i != 1 )
-			{
-				for( unsigned int p=0; p<i - 1 && p<token.size(); ++p )
-				{
-					prefix += token[p];
-				}
+	if ( (m_reserved += size) > m_peak )
+	{
+		m_peak = m_reserved;
+	}
+	return chunk;
+}
 
-				for( unsigned int t=2; (t+prefix.size())<token.size(); ++t)
-				{
-					token[t-2] = token[t+prefix.size()];
-				}
-				token.shave( prefix.size() + 2 );
-				i -= (prefix.size() + 1);
-			}
-			
-			isGlobal = true;
-			continue;
-		}
-		
-		if ( !isalnum(token[i]) && token[i] != '_' )
+//------------------------------------------------------------------------------
+void* WRCompilerArena::alloc( size_t size )
+{
+	char* block;
+	if ( size + 8 > (WRENCH_COMPILER_ARENA_CHUNK >> 3) )
+	{
+		// big blocks are mostly arrays that keep growing, they are
+		// given back to the heap when freed so it can coalesce them,
+		// the arena can not and would soon be all fragments
+		if ( !(block = newChunk(size + 8)) )
 		{
-			return false;
+			return 0;
 		}
+		*(uint32_t*)block = c_arenaHeapBlock;
+		return block + 8;
 	}
 
-	if ( foundColon && token[token.size() - 1] == ':' )
+	// each block starts with its size class
+	const unsigned int c = wr_arenaClass( size + 8 < 16 ? 16 : size + 8 );
+	if ( (block = m_free[c]) )
 	{
-		return false;
+		m_free[c] = *(char**)(block + 8);
+		return block + 8;
 	}
-	
-	if ( foundColon && token[0] != ':' )
+
+	const size_t bytes = wr_arenaClassSize( c );
+	if ( bytes > (size_t)(m_end - m_top) )
 	{
-		isLibConstant = true;
+		// split a larger free block before asking the heap for more
+		for( unsigned int l=c+1; l<c_arenaClasses; ++l )
+		{
+			if ( (block = m_free[l]) )
+			{
+				m_free[l] = *(char**)(block + 8);
+				recycle( block + bytes, wr_arenaClassSize(l) - bytes );
+				*(uint32_t*)block = c;
+				return block + 8;
+			}
+		}
+
+		recycle( m_top, m_end - m_top );
+		if ( !(m_top = newChunk(WRENCH_COMPILER_ARENA_CHUNK)) )
+		{
+			m_end = 0;
+			return 0;
+		}
+		m_end = m_top + WRENCH_COMPILER_ARENA_CHUNK;
 	}
 
-	return true;
+	block = m_top;
+	m_top += bytes;
+	*(uint32_t*)block = c;
+	return block + 8;
 }
 
+//------------------------------------------------------------------------------
+// cut what is left of a chunk or a split block into free blocks
+void WRCompilerArena::recycle( char* from, size_t bytes )
+{
+	while( bytes >= 16 )
+	{
+		unsigned int c = wr_arenaClass( bytes );
+		if ( wr_arenaClassSize(c) > bytes )
+		{
+			--c;
+		}
+
+		*(uint32_t*)from = c;
+		*(char**)(from + 8) = m_free[c];
+		m_free[c] = from;
+
+		from += wr_arenaClassSize( c );
+		bytes -= wr_arenaClassSize( c );
+	}
+}
 
 //------------------------------------------------------------------------------
-void WRCompilationContext::pushDebug( uint16_t code, WRBytecode& bytecode, int param )
+void WRCompilerArena::free( void* p )
 {
-	if ( !m_addDebugSymbols )
+	char* block = (char*)p - 8;
+	const uint32_t c = *(uint32_t*)block;
+	if ( c != c_arenaHeapBlock )
 	{
+		*(char**)p = m_free[c];
+		m_free[c] = block;
 		return;
 	}
 
-	if ( code == m_lastCode && (uint16_t)param == m_lastParam )
+	unsigned int i = find( block );
+	m_reserved -= (unsigned int)(m_chunks[i].end - m_chunks[i].begin);
+	for( --m_chunkCount; i<m_chunkCount; ++i )
 	{
-		return;
+		m_chunks[i] = m_chunks[i + 1];
 	}
+	g_free( block );
+}
 
-	m_lastParam = param;
-	m_lastCode = code;
-	
-	pushOpcode( bytecode, O_DebugInfo );
+//------------------------------------------------------------------------------
+// index of the chunk 'p' is in, or m_chunkCount
+unsigned int WRCompilerArena::find( const void* p ) const
+{
+	unsigned int low = 0;
+	unsigned int high = m_chunkCount;
+	while( low < high )
+	{
+		const unsigned int middle = (low + high) >> 1;
+		if ( (const char*)p < m_chunks[middle].begin )
+		{
+			high = middle;
+		}
+		else if ( (const char*)p >= m_chunks[middle].end )
+		{
+			low = middle + 1;
+		}
+		else
+		{
+			return middle;
+		}
+	}
 
-	uint16_t codeword = code | ((uint16_t)param & WRD_PayloadMask);
-	unsigned char data[2];
-	pushData( bytecode, wr_pack16(codeword, data), 2 );
+	return m_chunkCount;
 }
 
+#else
+
 //------------------------------------------------------------------------------
-int WRCompilationContext::getSourcePosition()
+unsigned int wr_compilerPeakMemory()
 {
-	int onChar;
-	int onLine;
-	return getSourcePosition( onLine, onChar, 0 );
+	return 0;
 }
 
+#endif
+
 //------------------------------------------------------------------------------
-int WRCompilationContext::getSourcePosition( int& onLine, int& onChar, WRstr* line )
+WRError wr_compile( const char* source,
+					const int size,
+					unsigned char** out,
+					int* outLen,
+					char* errMsg,
+					const uint8_t compilerOptionFlags )
 {
-	onChar = 0;
-	onLine = 1;
+	assert( sizeof(float) == 4 );
+	assert( sizeof(int) == 4 );
+	assert( sizeof(char) == 1 );
+	assert( O_LAST < 255 );
 
-	for( int p = 0; line && p<m_sourceLen && m_source[p] != '\n'; p++ )
-	{
-		(*line) += (char)m_source[p];
-	}
+#ifdef WRENCH_COMPILER_ARENA
+	// everything the compiler allocates goes in here and is released
+	// with it, so it must outlive the context
+	WRCompilerArena arena;
+	g_compilerArena = &arena;
+#endif
 
-	for( int i=0; i<m_pos; ++i )
+	WRError err;
+	bool farJumps = false;
+	for(;;)
 	{
-		if ( m_source[i] == '\n' )
-		{
-			onLine++;
-			onChar = 0;
+		// create a compiler context that has all the necessary stuff so it's completely unloaded when complete
+		WRCompilationContext comp; 
 
-			if( line )
-			{
-				line->clear();
-				for( int p = i+1; p<m_sourceLen && m_source[p] != '\n'; p++ )
-				{
-					(*line) += (char)m_source[p];
-				}
-			}
-		}
-		else
+		err = comp.compile( source, size, out, outLen, errMsg, compilerOptionFlags, farJumps );
+		if ( err != WR_ERR_None || !comp.m_jumpOutOfRange || farJumps )
 		{
-			onChar++;
+			break;
 		}
+
+		// a jump was more than 32k long, so all of them are made 32-bit
+		farJumps = true;
 	}
 
-	return onLine;
+#ifdef WRENCH_COMPILER_ARENA
+	g_compilerArena = 0;
+	g_compilerPeak = arena.peak();
+#endif
+
+	return err;
 }
 
+#ifdef WRENCH_COMPILE_CACHE
+
 //------------------------------------------------------------------------------
-int WRCompilationContext::addRelativeJumpTarget( WRBytecode& bytecode )
+// one allocation each, the bytecode follows
+struct WRCompileCacheEntry
 {
-	bytecode.jumpOffsetTargets.append().references.clear();
-	return bytecode.jumpOffsetTargets.count() - 1;
+	WRCompileCacheEntry* next; // most recently used first
+	uint32_t hash; // of the source, seeded with the build and flags
+	uint32_t check; // of the source again, seeded differently
+	uint32_t sourceLen;
+	uint32_t len;
+	uint8_t flags;
+
+	unsigned char* bytecode() { return (unsigned char*)(this + 1); }
+};
+
+static WRCompileCacheEntry* g_compileCache = 0;
+static WRCompileCacheStats g_compileCacheStats;
+
+//------------------------------------------------------------------------------
+// everything that changes what the compiler emits: the version, the
+// number of opcodes and which superinstructions they end with
+static uint32_t wr_compileCacheBuild()
+{
+	static uint32_t build = 0;
+	if ( !build )
+	{
+		build = wr_hashStr( "wrench", (WRENCH_VERSION_MAJOR << 24) | (WRENCH_VERSION_MINOR << 16) | (WRENCH_VERSION_BUILD << 8) | O_LAST );
+#define WR_SUPER_BUILD( NAME, FIRST, SECOND_AS_PUSHED, SECOND ) build = wr_hashStr( #NAME, build );
+		WRENCH_SUPERINSTRUCTIONS( WR_SUPER_BUILD )
+	}
+
+	return build;
 }
 
 //------------------------------------------------------------------------------
-void WRCompilationContext::setRelativeJumpTarget( WRBytecode& bytecode, int relativeJumpTarget )
+static WRCompileCacheEntry** wr_compileCacheFind( const uint32_t hash,
+												  const uint32_t check,
+												  const uint32_t sourceLen,
+												  const uint8_t flags )
 {
-	bytecode.jumpOffsetTargets[relativeJumpTarget].offset = bytecode.all.size();
+	for( WRCompileCacheEntry** E = &g_compileCache; *E; E = &(*E)->next )
+	{
+		if ( (*E)->hash == hash
+			 && (*E)->check == check
+			 && (*E)->sourceLen == sourceLen
+			 && (*E)->flags == flags )
+		{
+			return E;
+		}
+	}
+
+	return 0;
 }
 
 //------------------------------------------------------------------------------
-void WRCompilationContext::addRelativeJumpSourceEx( WRBytecode& bytecode, WROpcode opcode, int relativeJumpTarget, const unsigned char* data, const int dataSize )
+static void wr_compileCacheTrim()
 {
-	pushOpcode( bytecode, opcode );
+	while( g_compileCacheStats.bytes > WRENCH_COMPILE_CACHE_BYTES )
+	{
+		// there are never many entries, walk to the least recently used
+		WRCompileCacheEntry** E = &g_compileCache;
+		while( (*E)->next )
+		{
+			E = &(*E)->next;
+		}
 
-	int offset = bytecode.all.size();
-	
-	if ( dataSize ) // additional data
+		g_compileCacheStats.bytes -= (*E)->len;
+		--g_compileCacheStats.entries;
+		++g_compileCacheStats.evictions;
+
+		g_free( *E );
+		*E = 0;
+	}
+}
+
+//------------------------------------------------------------------------------
+// 'at' is where in the list it goes, the head for a new compile
+static void wr_compileCacheAdd( WRCompileCacheEntry** at,
+								const uint32_t hash,
+								const uint32_t check,
+								const uint32_t sourceLen,
+								const uint8_t flags,
+								const unsigned char* bytecode,
+								const uint32_t len )
+{
+	if ( len > WRENCH_COMPILE_CACHE_BYTES )
 	{
-		pushData( bytecode, data, dataSize );
+		return;
 	}
 
-	bytecode.jumpOffsetTargets[relativeJumpTarget].references.append() = offset;
+	WRCompileCacheEntry* entry = (WRCompileCacheEntry*)g_malloc( sizeof(WRCompileCacheEntry) + len );
+	if ( !entry )
+	{
+		return;
+	}
 
-	pushData( bytecode, "\t\t", 2 ); // 16-bit relative vector
-}
+	entry->hash = hash;
+	entry->check = check;
+	entry->sourceLen = sourceLen;
+	entry->len = len;
+	entry->flags = flags;
+	memcpy( entry->bytecode(), bytecode, len );
+
+	entry->next = *at;
+	*at = entry;
+
+	++g_compileCacheStats.entries;
+	g_compileCacheStats.bytes += len;
 
+	wr_compileCacheTrim();
+}
 
 //------------------------------------------------------------------------------
-// add a jump FROM with whatever opcode is supposed to do it
-void WRCompilationContext::addRelativeJumpSource( WRBytecode& bytecode, WROpcode opcode, int relativeJumpTarget )
+WRError wr_compileCached( const char* source,
+						  const int size,
+						  unsigned char** out,
+						  int* outLen,
+						  char* errMsg,
+						  const uint8_t compilerOptionFlags )
 {
-	pushOpcode( bytecode, opcode );
+	const uint32_t build = wr_compileCacheBuild();
+	const uint32_t hash = wr_hash( source, size, build + compilerOptionFlags );
+	const uint32_t check = wr_hash( source, size, ~build );
 
-	int offset = bytecode.all.size();
-	switch( bytecode.opcodes[bytecode.opcodes.size() - 1] )
+	WRCompileCacheEntry** E = wr_compileCacheFind( hash, check, size, compilerOptionFlags );
+	if ( E )
 	{
-		case O_GSCompareEQBZ:
-		case O_LSCompareEQBZ:
-		case O_GSCompareNEBZ:
-		case O_LSCompareNEBZ:
-		case O_GSCompareGEBZ:
-		case O_LSCompareGEBZ:
-		case O_GSCompareLEBZ:
-		case O_LSCompareLEBZ:
-		case O_GSCompareGTBZ:
-		case O_LSCompareGTBZ:
-		case O_GSCompareLTBZ:
-		case O_LSCompareLTBZ:
-		{
-			--offset;
-			break;
-		}
+		// most recently used goes to the front
+		WRCompileCacheEntry* entry = *E;
+		*E = entry->next;
+		entry->next = g_compileCache;
+		g_compileCache = entry;
 
-		case O_LLCompareLTBZ:
-		case O_LLCompareGTBZ:
-		case O_LLCompareLEBZ:
-		case O_LLCompareGEBZ:
-		case O_LLCompareEQBZ:
-		case O_LLCompareNEBZ:
-		case O_GGCompareLTBZ:
-		case O_GGCompareGTBZ:
-		case O_GGCompareLEBZ:
-		case O_GGCompareGEBZ:
-		case O_GGCompareEQBZ:
-		case O_GGCompareNEBZ:
+		if ( !(*out = (unsigned char*)g_malloc(entry->len)) )
 		{
-			offset -= 2;
-			break;
+			return WR_ERR_malloc_failed;
 		}
 
-		default: break;
+		memcpy( *out, entry->bytecode(), entry->len );
+		*outLen = entry->len;
+
+		++g_compileCacheStats.hits;
+		g_compileCacheStats.bytesSaved += size;
+		return WR_ERR_None;
 	}
-	
-	bytecode.jumpOffsetTargets[relativeJumpTarget].references.append() = offset;
-	pushData( bytecode, "\t\t", 2 );
+
+	++g_compileCacheStats.misses;
+
+	WRError err = wr_compile( source, size, out, outLen, errMsg, compilerOptionFlags );
+	if ( err == WR_ERR_None )
+	{
+		wr_compileCacheAdd( &g_compileCache, hash, check, size, compilerOptionFlags, *out, *outLen );
+	}
+
+	return err;
 }
 
 //------------------------------------------------------------------------------
-void WRCompilationContext::resolveRelativeJumps( WRBytecode& bytecode )
+void wr_compileCacheStats( WRCompileCacheStats* stats )
+{
+	*stats = g_compileCacheStats;
+}
+
+//------------------------------------------------------------------------------
+void wr_compileCacheClear()
 {
-	for( unsigned int j=0; j<bytecode.jumpOffsetTargets.count(); ++j )
+	while( g_compileCache )
 	{
-		for( unsigned int t=0; t<bytecode.jumpOffsetTargets[j].references.count(); ++t )
-		{
-			int16_t diff = bytecode.jumpOffsetTargets[j].offset - bytecode.jumpOffsetTargets[j].references[t];
+		WRCompileCacheEntry* next = g_compileCache->next;
+		g_free( g_compileCache );
+		g_compileCache = next;
+	}
 
-			int offset = bytecode.jumpOffsetTargets[j].references[t];
-			WROpcode o = (WROpcode)bytecode.all[offset - 1];
-			bool no8version = false;
+	memset( &g_compileCacheStats, 0, sizeof(g_compileCacheStats) );
+}
 
-			switch( o )
-			{
-				case O_GSCompareEQBZ8:
-				case O_LSCompareEQBZ8:
-				case O_GSCompareNEBZ8:
-				case O_LSCompareNEBZ8:
-				case O_GSCompareGEBZ8:
-				case O_LSCompareGEBZ8:
-				case O_GSCompareLEBZ8:
-				case O_LSCompareLEBZ8:
-				case O_GSCompareGTBZ8:
-				case O_LSCompareGTBZ8:
-				case O_GSCompareLTBZ8:
-				case O_LSCompareLTBZ8:
-				case O_GSCompareEQBZ:
-				case O_LSCompareEQBZ:
-				case O_GSCompareNEBZ:
-				case O_LSCompareNEBZ:
-				case O_GSCompareGEBZ:
-				case O_LSCompareGEBZ:
-				case O_GSCompareLEBZ:
-				case O_LSCompareLEBZ:
-				case O_GSCompareGTBZ:
-				case O_LSCompareGTBZ:
-				case O_GSCompareLTBZ:
-				case O_LSCompareLTBZ:
-				{
-					--diff; // these instructions are offset
-					break;
-				}
+#if defined(WRENCH_WIN32_FILE_IO) \
+	|| defined(WRENCH_LINUX_FILE_IO) \
+	|| defined(WRENCH_SPIFFS_FILE_IO) \
+	|| defined(WRENCH_LITTLEFS_FILE_IO) \
+	|| defined(WRENCH_CUSTOM_FILE_IO)
 
-				case O_LLCompareLTBZ8:
-				case O_LLCompareGTBZ8:
-				case O_LLCompareLEBZ8:
-				case O_LLCompareGEBZ8:
-				case O_LLCompareEQBZ8:
-				case O_LLCompareNEBZ8:
-				case O_GGCompareLTBZ8:
-				case O_GGCompareGTBZ8:
-				case O_GGCompareLEBZ8:
-				case O_GGCompareGEBZ8:
-				case O_GGCompareEQBZ8:
-				case O_GGCompareNEBZ8:
-				case O_LLCompareLTBZ:
-				case O_LLCompareGTBZ:
-				case O_LLCompareLEBZ:
-				case O_LLCompareGEBZ:
-				case O_LLCompareEQBZ:
-				case O_LLCompareNEBZ:
-				case O_GGCompareLTBZ:
-				case O_GGCompareGTBZ:
-				case O_GGCompareLEBZ:
-				case O_GGCompareGEBZ:
-				case O_GGCompareEQBZ:
-				case O_GGCompareNEBZ:
-				{
-					diff -= 2;
-					break;
-				}
+// file layout, little endian:
+// build[4] count[4] { hash[4] check[4] sourceLen[4] len[4] flags[1] bytecode[len] } * count
+#define WR_COMPILE_CACHE_ENTRY_HEADER 17
 
-				case O_GGNextKeyValueOrJump:
-				case O_GLNextKeyValueOrJump:
-				case O_LGNextKeyValueOrJump:
-				case O_LLNextKeyValueOrJump:
-				{
-					no8version = true;
-					diff -= 3;
-					break;
-				}
+//------------------------------------------------------------------------------
+bool wr_compileCacheSave( const char* fileName )
+{
+	unsigned int size = 8;
+	for( WRCompileCacheEntry* entry = g_compileCache; entry; entry = entry->next )
+	{
+		size += WR_COMPILE_CACHE_ENTRY_HEADER + entry->len;
+	}
 
-				case O_GNextValueOrJump:
-				case O_LNextValueOrJump:
-				{
-					no8version = true;
-					diff -= 2;
-					break;
-				}
+	unsigned char* data = (unsigned char*)g_malloc( size );
+	if ( !data )
+	{
+		return false;
+	}
 
-				default:
-					break;
-			}
+	unsigned char* pos = data;
+	wr_pack32( wr_compileCacheBuild(), pos );
+	wr_pack32( g_compileCacheStats.entries, pos + 4 );
+	pos += 8;
 
-			
-			if ( (diff < 128) && (diff > -129) && !no8version )
-			{
-				switch( o )
-				{
-					case O_RelativeJump: *bytecode.all.p_str(offset - 1) = O_RelativeJump8; break;
-					case O_BZ: *bytecode.all.p_str(offset - 1) = O_BZ8; break;
+	for( WRCompileCacheEntry* entry = g_compileCache; entry; entry = entry->next )
+	{
+		wr_pack32( entry->hash, pos );
+		wr_pack32( entry->check, pos + 4 );
+		wr_pack32( entry->sourceLen, pos + 8 );
+		wr_pack32( entry->len, pos + 12 );
+		pos[16] = entry->flags;
+		memcpy( pos + WR_COMPILE_CACHE_ENTRY_HEADER, entry->bytecode(), entry->len );
+		pos += WR_COMPILE_CACHE_ENTRY_HEADER + entry->len;
+	}
 
-					case O_CompareBEQ: *bytecode.all.p_str(offset - 1) = O_CompareBEQ8; break;
-					case O_CompareBNE: *bytecode.all.p_str(offset - 1) = O_CompareBNE8; break;
-					case O_CompareBGE: *bytecode.all.p_str(offset - 1) = O_CompareBGE8; break;
-					case O_CompareBLE: *bytecode.all.p_str(offset - 1) = O_CompareBLE8; break;
-					case O_CompareBGT: *bytecode.all.p_str(offset - 1) = O_CompareBGT8; break;
-					case O_CompareBLT: *bytecode.all.p_str(offset - 1) = O_CompareBLT8; break;
+	bool ret = wr_writeFileBytes( fileName, (char*)data, size );
+	g_free( data );
+	return ret;
+}
 
-					case O_GSCompareEQBZ: *bytecode.all.p_str(offset - 1) = O_GSCompareEQBZ8; ++offset; break;
-					case O_LSCompareEQBZ: *bytecode.all.p_str(offset - 1) = O_LSCompareEQBZ8; ++offset; break;
-					case O_GSCompareNEBZ: *bytecode.all.p_str(offset - 1) = O_GSCompareNEBZ8; ++offset; break;
-					case O_LSCompareNEBZ: *bytecode.all.p_str(offset - 1) = O_LSCompareNEBZ8; ++offset; break;
-					case O_GSCompareGEBZ: *bytecode.all.p_str(offset - 1) = O_GSCompareGEBZ8; ++offset; break;
-					case O_LSCompareGEBZ: *bytecode.all.p_str(offset - 1) = O_LSCompareGEBZ8; ++offset; break;
-					case O_GSCompareLEBZ: *bytecode.all.p_str(offset - 1) = O_GSCompareLEBZ8; ++offset; break;
-					case O_LSCompareLEBZ: *bytecode.all.p_str(offset - 1) = O_LSCompareLEBZ8; ++offset; break;
-					case O_GSCompareGTBZ: *bytecode.all.p_str(offset - 1) = O_GSCompareGTBZ8; ++offset; break;
-					case O_LSCompareGTBZ: *bytecode.all.p_str(offset - 1) = O_LSCompareGTBZ8; ++offset; break;
-					case O_GSCompareLTBZ: *bytecode.all.p_str(offset - 1) = O_GSCompareLTBZ8; ++offset; break;
-					case O_LSCompareLTBZ: *bytecode.all.p_str(offset - 1) = O_LSCompareLTBZ8; ++offset; break;
-										  
-					case O_LLCompareLTBZ: *bytecode.all.p_str(offset - 1) = O_LLCompareLTBZ8; offset += 2; break;
-					case O_LLCompareGTBZ: *bytecode.all.p_str(offset - 1) = O_LLCompareGTBZ8; offset += 2; break;
-					case O_LLCompareLEBZ: *bytecode.all.p_str(offset - 1) = O_LLCompareLEBZ8; offset += 2; break;
-					case O_LLCompareGEBZ: *bytecode.all.p_str(offset - 1) = O_LLCompareGEBZ8; offset += 2; break;
-					case O_LLCompareEQBZ: *bytecode.all.p_str(offset - 1) = O_LLCompareEQBZ8; offset += 2; break;
-					case O_LLCompareNEBZ: *bytecode.all.p_str(offset - 1) = O_LLCompareNEBZ8; offset += 2; break;
-					case O_GGCompareLTBZ: *bytecode.all.p_str(offset - 1) = O_GGCompareLTBZ8; offset += 2; break;
-					case O_GGCompareGTBZ: *bytecode.all.p_str(offset - 1) = O_GGCompareGTBZ8; offset += 2; break;
-					case O_GGCompareLEBZ: *bytecode.all.p_str(offset - 1) = O_GGCompareLEBZ8; offset += 2; break;
-					case O_GGCompareGEBZ: *bytecode.all.p_str(offset - 1) = O_GGCompareGEBZ8; offset += 2; break;
-					case O_GGCompareEQBZ: *bytecode.all.p_str(offset - 1) = O_GGCompareEQBZ8; offset += 2; break;
-					case O_GGCompareNEBZ: *bytecode.all.p_str(offset - 1) = O_GGCompareNEBZ8; offset += 2; break;
+//------------------------------------------------------------------------------
+bool wr_compileCacheLoad( const char* fileName )
+{
+	char* file;
+	unsigned int size;
+	if ( !wr_readFileBytes(fileName, &file, &size) )
+	{
+		return false;
+	}
 
-					case O_BLA: *bytecode.all.p_str(offset - 1) = O_BLA8; break;
-					case O_BLO: *bytecode.all.p_str(offset - 1) = O_BLO8; break;
+	const unsigned char* data = (const unsigned char*)file;
+	const unsigned char* end = data + size;
 
-					// no work to be done
-					case O_RelativeJump8:
-					case O_BZ8:
-					case O_BLA8:
-					case O_BLO8:
-					case O_CompareBLE8:
-					case O_CompareBGE8:
-					case O_CompareBGT8:
-					case O_CompareBLT8:
-					case O_CompareBEQ8:
-					case O_CompareBNE8:
-						break;
-						
-					case O_GSCompareEQBZ8:
-					case O_LSCompareEQBZ8:
-					case O_GSCompareNEBZ8:
-					case O_LSCompareNEBZ8:
-					case O_GSCompareGEBZ8:
-					case O_LSCompareGEBZ8:
-					case O_GSCompareLEBZ8:
-					case O_LSCompareLEBZ8:
-					case O_GSCompareGTBZ8:
-					case O_LSCompareGTBZ8:
-					case O_GSCompareLTBZ8:
-					case O_LSCompareLTBZ8:
-						++offset;
-						break;
+	// loaded entries are older than anything compiled already
+	WRCompileCacheEntry** tail = &g_compileCache;
+	while( *tail )
+	{
+		tail = &(*tail)->next;
+	}
 
-					case O_LLCompareLTBZ8:
-					case O_LLCompareGTBZ8:
-					case O_LLCompareLEBZ8:
-					case O_LLCompareGEBZ8:
-					case O_LLCompareEQBZ8:
-					case O_LLCompareNEBZ8:
-					case O_GGCompareLTBZ8:
-					case O_GGCompareGTBZ8:
-					case O_GGCompareLEBZ8:
-					case O_GGCompareGEBZ8:
-					case O_GGCompareEQBZ8:
-					case O_GGCompareNEBZ8:
-					{
-						offset += 2;
-						break;
-					}
+	if ( size >= 8 && (uint32_t)READ_32_FROM_PC(data) == wr_compileCacheBuild() )
+	{
+		uint32_t count = READ_32_FROM_PC( data + 4 );
+		const unsigned char* pos = data + 8;
 
-					default:
-						m_err = WR_ERR_compiler_panic;
-						return;
-				}
+		for( ; count && (end - pos) >= WR_COMPILE_CACHE_ENTRY_HEADER; --count )
+		{
+			const uint32_t hash = READ_32_FROM_PC( pos );
+			const uint32_t check = READ_32_FROM_PC( pos + 4 );
+			const uint32_t sourceLen = READ_32_FROM_PC( pos + 8 );
+			const uint32_t len = READ_32_FROM_PC( pos + 12 );
+			const uint8_t flags = pos[16];
+			const unsigned char* bytecode = pos + WR_COMPILE_CACHE_ENTRY_HEADER;
 
-				*bytecode.all.p_str(offset) = (int8_t)diff;
+			if ( len > (uint32_t)(end - bytecode) )
+			{
+				break;
 			}
-			else
+
+			pos = bytecode + len;
+
+			// is it what the compiler wrote?
+			if ( len < 4
+				 || (uint32_t)READ_32_FROM_PC(bytecode + (len - 4)) != wr_hash_read8(bytecode, len - 4) + WRENCH_VERSION_MAJOR
+				 || wr_compileCacheFind(hash, check, sourceLen, flags) )
 			{
-				switch( o )
-				{
-					// check to see if any were pushed into 16-bit land
-					// that were previously optimized
-					case O_RelativeJump8: *bytecode.all.p_str(offset - 1) = O_RelativeJump; break;
-					case O_BZ8: *bytecode.all.p_str(offset - 1) = O_BZ; break;
-					case O_CompareBEQ8: *bytecode.all.p_str(offset - 1) = O_CompareBEQ; break;
-					case O_CompareBNE8: *bytecode.all.p_str(offset - 1) = O_CompareBNE; break;
-					case O_CompareBGE8: *bytecode.all.p_str(offset - 1) = O_CompareBGE; break;
-					case O_CompareBLE8: *bytecode.all.p_str(offset - 1) = O_CompareBLE; break;
-					case O_CompareBGT8: *bytecode.all.p_str(offset - 1) = O_CompareBGT; break;
-					case O_CompareBLT8: *bytecode.all.p_str(offset - 1) = O_CompareBLT; break;
-					case O_GSCompareEQBZ8: *bytecode.all.p_str(offset - 1) = O_GSCompareEQBZ; ++offset; break;
-					case O_LSCompareEQBZ8: *bytecode.all.p_str(offset - 1) = O_LSCompareEQBZ; ++offset; break;
-					case O_GSCompareNEBZ8: *bytecode.all.p_str(offset - 1) = O_GSCompareNEBZ; ++offset; break;
-					case O_LSCompareNEBZ8: *bytecode.all.p_str(offset - 1) = O_LSCompareNEBZ; ++offset; break;
-					case O_GSCompareGEBZ8: *bytecode.all.p_str(offset - 1) = O_GSCompareGEBZ; ++offset; break;
-					case O_LSCompareGEBZ8: *bytecode.all.p_str(offset - 1) = O_LSCompareGEBZ; ++offset; break;
-					case O_GSCompareLEBZ8: *bytecode.all.p_str(offset - 1) = O_GSCompareLEBZ; ++offset; break;
-					case O_LSCompareLEBZ8: *bytecode.all.p_str(offset - 1) = O_LSCompareLEBZ; ++offset; break;
-					case O_GSCompareGTBZ8: *bytecode.all.p_str(offset - 1) = O_GSCompareGTBZ; ++offset; break;
-					case O_LSCompareGTBZ8: *bytecode.all.p_str(offset - 1) = O_LSCompareGTBZ; ++offset; break;
-					case O_GSCompareLTBZ8: *bytecode.all.p_str(offset - 1) = O_GSCompareLTBZ; ++offset; break;
-					case O_LSCompareLTBZ8: *bytecode.all.p_str(offset - 1) = O_LSCompareLTBZ; ++offset; break;
+				continue;
+			}
 
-					case O_LLCompareLTBZ8: *bytecode.all.p_str(offset - 1) = O_LLCompareLTBZ; offset += 2; break;
-					case O_LLCompareGTBZ8: *bytecode.all.p_str(offset - 1) = O_LLCompareGTBZ; offset += 2; break;
-					case O_LLCompareLEBZ8: *bytecode.all.p_str(offset - 1) = O_LLCompareLEBZ; offset += 2; break;
-					case O_LLCompareGEBZ8: *bytecode.all.p_str(offset - 1) = O_LLCompareGEBZ; offset += 2; break;
-					case O_LLCompareEQBZ8: *bytecode.all.p_str(offset - 1) = O_LLCompareEQBZ; offset += 2; break;
-					case O_LLCompareNEBZ8: *bytecode.all.p_str(offset - 1) = O_LLCompareNEBZ; offset += 2; break;
-					case O_GGCompareLTBZ8: *bytecode.all.p_str(offset - 1) = O_GGCompareLTBZ; offset += 2; break;
-					case O_GGCompareGTBZ8: *bytecode.all.p_str(offset - 1) = O_GGCompareGTBZ; offset += 2; break;
-					case O_GGCompareLEBZ8: *bytecode.all.p_str(offset - 1) = O_GGCompareLEBZ; offset += 2; break;
-					case O_GGCompareGEBZ8: *bytecode.all.p_str(offset - 1) = O_GGCompareGEBZ; offset += 2; break;
-					case O_GGCompareEQBZ8: *bytecode.all.p_str(offset - 1) = O_GGCompareEQBZ; offset += 2; break;
-					case O_GGCompareNEBZ8: *bytecode.all.p_str(offset - 1) = O_GGCompareNEBZ; offset += 2; break;
+			wr_compileCacheAdd( tail, hash, check, sourceLen, flags, bytecode, len );
+			if ( *tail )
+			{
+				tail = &(*tail)->next;
+			}
+		}
+	}
 
-					case O_GGNextKeyValueOrJump:
-					case O_GLNextKeyValueOrJump:
-					case O_LGNextKeyValueOrJump:
-					case O_LLNextKeyValueOrJump:
-					{
-						offset += 3;
-						break;
-					}
+	g_free( file );
+	return true;
+}
 
-					case O_GNextValueOrJump:
-					case O_LNextValueOrJump:
-					{
-						offset += 2;
-						break;
-					}
+#endif
 
-					case O_BLA8: *bytecode.all.p_str(offset - 1) = O_BLA; break;
-					case O_BLO8: *bytecode.all.p_str(offset - 1) = O_BLO; break;
+#endif
 
-					 // no work to be done, already visited
-					case O_RelativeJump:
-					case O_BZ:
-					case O_BLA:
-					case O_BLO:
-					case O_CompareBLE:
-					case O_CompareBGE:
-					case O_CompareBGT:
-					case O_CompareBLT:
-					case O_CompareBEQ:
-					case O_CompareBNE:
-						break;
-
-					case O_GSCompareEQBZ:
-					case O_LSCompareEQBZ:
-					case O_GSCompareNEBZ:
-					case O_LSCompareNEBZ:
-					case O_GSCompareGEBZ:
-					case O_LSCompareGEBZ:
-					case O_GSCompareLEBZ:
-					case O_LSCompareLEBZ:
-					case O_GSCompareGTBZ:
-					case O_LSCompareGTBZ:
-					case O_GSCompareLTBZ:
-					case O_LSCompareLTBZ:
-						++offset;
-						break;
-					
-					case O_LLCompareLTBZ:
-					case O_LLCompareGTBZ:
-					case O_LLCompareLEBZ:
-					case O_LLCompareGEBZ:
-					case O_LLCompareEQBZ:
-					case O_LLCompareNEBZ:
-					case O_GGCompareLTBZ:
-					case O_GGCompareGTBZ:
-					case O_GGCompareLEBZ:
-					case O_GGCompareGEBZ:
-					case O_GGCompareEQBZ:
-					case O_GGCompareNEBZ:
-					{
-						offset += 2;
-						break;
-					}
-						
-					default:
-					{
-						m_err = WR_ERR_compiler_panic;
-						return;
-					}
-				}
-				
-				wr_pack16( diff, bytecode.all.p_str(offset) );
-			}
-		}
-	}
-}
+//------------------------------------------------------------------------------
+void streamDump( WROpcodeStream const& stream )
+{
+	WRstr str;
+	wr_asciiDump( stream, stream.size(), str );
+	printf( "%d:\n%s\n", stream.size(), str.c_str() );
+}
 
 //------------------------------------------------------------------------------
-void WRCompilationContext::pushLiteral( WRBytecode& bytecode, WRExpressionContext& context )
+bool WRCompilationContext::isValidLabel( WRstr& token, bool& isGlobal, WRstr& prefix, bool& isLibConstant )
 {
-	WRValue& value = context.value;
-	unsigned char data[4];
+	isLibConstant = false;
 	
-	if ( value.type == WR_INT && value.i == 0 )
+	prefix.clear();
+
+	if ( !token.size() || (!isalpha(token[0]) && token[0] != '_' && token[0] != ':') ) // non-zero size and start with alpha or '_' ?
 	{
-		pushOpcode( bytecode, O_LiteralZero );
+		return false;
 	}
-	else if ( value.type == WR_INT )
+
+	isGlobal = false;
+
+	if ( token[0] == ':' )
 	{
-		if ( (value.i <= 127) && (value.i >= -128) )
-		{
-			pushOpcode( bytecode, O_LiteralInt8 );
-			unsigned char be = (char)value.i;
-			pushData( bytecode, &be, 1 );
-		}
-		else if ( (value.i <= 32767) && (value.i >= -32768) )
+		if ( (token.size() > 2) && (token[1] == ':') )
 		{
-			pushOpcode( bytecode, O_LiteralInt16 );
-			int16_t be = value.i;
-			pushData( bytecode, wr_pack16(be, data), 2 );
+			isGlobal = true;
 		}
 		else
 		{
-			pushOpcode( bytecode, O_LiteralInt32 );
-			unsigned char data[4];
-			pushData( bytecode, wr_pack32(value.i, data), 4 );
-		}
-	}
-	else if ( (uint8_t)value.type == WR_COMPILER_LITERAL_STRING )
-	{
-		pushOpcode( bytecode, O_LiteralString );
-		int16_t be = context.literalString.size();
-		pushData( bytecode, wr_pack16(be, data), 2 );
-		for( unsigned int i=0; i<context.literalString.size(); ++i )
-		{
-			pushData( bytecode, context.literalString.c_str(i), 1 );
+			return false;
 		}
 	}
-	else
-	{
-		pushOpcode( bytecode, O_LiteralFloat );
-		int32_t be = value.i;
-		pushData( bytecode, wr_pack32(be, data), 4 );
-	}
-}
-
-//------------------------------------------------------------------------------
-void WRCompilationContext::pushLibConstant( WRBytecode& bytecode, WRExpressionContext& context )
-{
-	pushOpcode( bytecode, O_LoadLibConstant );
-	unsigned char data[4];
-	uint32_t hash = wr_hashStr(context.prefix + "::" + context.token);
-	pushData( bytecode, wr_pack32(hash, data), 4 );
-}
-
-//------------------------------------------------------------------------------
-int WRCompilationContext::addLocalSpaceLoad( WRBytecode& bytecode, WRstr& token, bool addOnly, bool varSeen )
-{
-	if ( m_unitTop == 0 )
-	{
-		return addGlobalSpaceLoad( bytecode, token, addOnly, varSeen );
-	}
 
-	uint32_t hash = wr_hashStr(token);
-	
-	unsigned int i=0;
-		
-	for( ; i<bytecode.localSpace.count(); ++i )
+	for( unsigned int i=0; c_reserved[i][0]; ++i )
 	{
-		if ( bytecode.localSpace[i].hash == hash )
+		if ( token == c_reserved[i] )
 		{
-			break;
+			return false;
 		}
 	}
 
-	if ( i >= bytecode.localSpace.count() )
+	bool foundColon = false;
+	for( unsigned int i=0; i<token.size(); i++ ) // entire token alphanumeric or '_'?
 	{
-		if ( !addOnly )
+		if ( token[i] == ':' )
 		{
-			WRstr t2;
-			if ( varSeen || (token[0] == ':' && token[1] == ':') )
-			{
-				t2 = token;
-			}
-			else
+			if ( token[++i] != ':' )
 			{
-				t2.format("::%s", token.c_str());
+				m_err = WR_ERR_unexpected_token;
+				return false;
 			}
 
-			uint32_t ghash = wr_hashStr(t2);
+			foundColon = true;
 
-			// was NOT found locally which is possible for a "global" if
-			// the argument list names it, now check global with the global
-			// hash
-			if ( !bytecode.isStructSpace || varSeen ) // structs and explicit 'var' are immune to this
+			if ( i != 1 )
 			{
-				for (unsigned int j = 0; j < m_units[0].bytecode.localSpace.count(); ++j)
+				for( unsigned int p=0; p<i - 1 && p<token.size(); ++p )
 				{
-					if (m_units[0].bytecode.localSpace[j].hash == ghash)
-					{
-						pushOpcode(bytecode, O_LoadFromGlobal);
-						unsigned char c = j;
-						pushData(bytecode, &c, 1);
-						return j;
-					}
+					prefix += token[p];
+				}
+
+				for( unsigned int t=2; (t+prefix.size())<token.size(); ++t)
+				{
+					token[t-2] = token[t+prefix.size()];
 				}
+				token.shave( prefix.size() + 2 );
+				i -= (prefix.size() + 1);
 			}
+			
+			isGlobal = true;
+			continue;
 		}
-
-		if ( m_needVar && !varSeen )
+		
+		if ( !isalnum(token[i]) && token[i] != '_' )
 		{
-			m_err = WR_ERR_var_not_seen_before_label;
-			return 0;
+			return false;
 		}
 	}
 
-	bytecode.localSpace[i].hash = hash;
-	bytecode.localSpace[i].label = token;
-	
-	if ( !addOnly )
+	if ( foundColon && token[token.size() - 1] == ':' )
 	{
-		pushOpcode( bytecode, O_LoadFromLocal );
-		unsigned char c = i;
-		pushData( bytecode, &c, 1 );
+		return false;
 	}
 	
-	return i;
+	if ( foundColon && token[0] != ':' )
+	{
+		isLibConstant = true;
+	}
+
+	return true;
 }
 
+
 //------------------------------------------------------------------------------
-int WRCompilationContext::addGlobalSpaceLoad( WRBytecode& bytecode, WRstr& token, bool addOnly, bool varSeen )
+void WRCompilationContext::pushDebug( uint16_t code, WRBytecode& bytecode, int param )
 {
-	uint32_t hash;
-	WRstr t2;
-	if ( token[0] == ':' && token[1] == ':' )
+	if ( !m_addDebugSymbols )
 	{
-		t2 = token;
+		return;
 	}
-	else
+
+	if ( code == m_lastCode && (uint16_t)param == m_lastParam )
 	{
-		t2.format( "::%s", token.c_str() );
+		return;
 	}
-	hash = wr_hash( t2, t2.size() );
 
-	unsigned int i=0;
+	m_lastParam = param;
+	m_lastCode = code;
+	
+	pushOpcode( bytecode, O_DebugInfo );
 
-	for( ; i<m_units[0].bytecode.localSpace.count(); ++i )
-	{
-		if ( m_units[0].bytecode.localSpace[i].hash == hash )
-		{
-			break;
-		}
-	}
+	uint16_t codeword = code | ((uint16_t)param & WRD_PayloadMask);
+	unsigned char data[2];
+	pushData( bytecode, wr_pack16(codeword, data), 2 );
+}
 
-	if ( m_needVar && !varSeen && i >= m_units[0].bytecode.localSpace.count() )
+//------------------------------------------------------------------------------
+int WRCompilationContext::getSourcePosition()
+{
+	// asked for every statement, so the lines are counted on from where
+	// the last one was rather than from the top each time
+	const int end = m_pos < m_sourceLen ? m_pos : m_sourceLen;
+	if ( end < m_linePos )
 	{
-		m_err = WR_ERR_var_not_seen_before_label;
-		return 0;
+		m_linePos = 0;
+		m_line = 1;
 	}
-	
-	m_units[0].bytecode.localSpace[i].hash = hash;
-	m_units[0].bytecode.localSpace[i].label = t2;
 
-	if ( !addOnly )
+	const char* from = m_source + m_linePos;
+	const char* to = m_source + end;
+	while( (from = (const char*)memchr(from, '\n', to - from)) )
 	{
-		pushOpcode( bytecode, O_LoadFromGlobal );
-		unsigned char c = i;
-		pushData( bytecode, &c, 1 );
+		++m_line;
+		++from;
 	}
+	m_linePos = end;
 
-	return i;
+	return m_line;
 }
 
 //------------------------------------------------------------------------------
-void WRCompilationContext::loadExpressionContext( WRExpression& expression, int depth, int operation )
+int WRCompilationContext::getSourcePosition( int& onLine, int& onChar, WRstr* line )
 {
-	if ( operation > 0
-		 && expression.context[operation].operation
-		 && expression.context[operation].operation->opcode == O_HASH_PLACEHOLDER
-		 && depth > operation )
+	onChar = 0;
+	onLine = 1;
+
+	for( int p = 0; line && p<m_sourceLen && m_source[p] != '\n'; p++ )
 	{
-		unsigned char buf[4];
-		wr_pack32( wr_hash( expression.context[depth].token,
-							expression.context[depth].token.size()),
-				   buf );
-		pushOpcode( expression.bytecode, O_LiteralInt32 );
-		pushData( expression.bytecode, buf, 4 );
+		(*line) += (char)m_source[p];
 	}
-	else
+
+	for( int i=0; i<m_pos; ++i )
 	{
-		switch( expression.context[depth].type )
+		if ( m_source[i] == '\n' )
 		{
-			case EXTYPE_LIB_CONSTANT:
-			{
-				pushLibConstant( expression.bytecode, expression.context[depth] );
-				break;
-			}
-			
-			case EXTYPE_LITERAL:
-			{
-				pushLiteral( expression.bytecode, expression.context[depth] );
-				break;
-			}
+			onLine++;
+			onChar = 0;
 
-			case EXTYPE_LABEL_AND_NULL:
-			case EXTYPE_LABEL:
+			if( line )
 			{
-				if ( expression.context[depth].global )
-				{
-					addGlobalSpaceLoad( expression.bytecode,
-										expression.context[depth].token,
-										false,
-										expression.context[depth].varSeen );
-				}
-				else
-				{
-					addLocalSpaceLoad( expression.bytecode,
-									   expression.context[depth].token,
-									   false,
-									   expression.context[depth].varSeen );
-				}
-
-				if ( expression.context[depth].type == EXTYPE_LABEL_AND_NULL )
+				line->clear();
+				for( int p = i+1; p<m_sourceLen && m_source[p] != '\n'; p++ )
 				{
-					expression.bytecode.all += O_InitVar;
-					expression.bytecode.opcodes += O_InitVar;
+					(*line) += (char)m_source[p];
 				}
-						
-				break;
-			}
-
-			case EXTYPE_BYTECODE_RESULT:
-			{
-				appendBytecode( expression.bytecode,
-								expression.context[depth].bytecode );
-				break;
-			}
-
-			case EXTYPE_RESOLVED:
-			case EXTYPE_OPERATION:
-			default:
-			{
-				break;
 			}
 		}
+		else
+		{
+			onChar++;
+		}
 	}
 
-	expression.pushToStack( depth ); // make sure stack knows something got loaded on top of it
-	
-	expression.context[depth].type = EXTYPE_RESOLVED; // this slot is now a resolved value sitting on the stack
+	return onLine;
 }
 
 //------------------------------------------------------------------------------
-void WRExpression::swapWithTop( int stackPosition, bool addOpcodes )
+int WRCompilationContext::addRelativeJumpTarget( WRBytecode& bytecode )
 {
-	if ( stackPosition == 0 )
-	{
-		return;
-	}
+	BytecodeJumpOffset& target = bytecode.jumpOffsetTargets.append();
+	target.offset = -1;
+	target.references.clear();
+	target.resolved = 0;
+	target.gotoHash = 0;
+	return bytecode.jumpOffsetTargets.count() - 1;
+}
+
+//------------------------------------------------------------------------------
+void WRCompilationContext::setRelativeJumpTarget( WRBytecode& bytecode, int relativeJumpTarget )
+{
+	bytecode.jumpOffsetTargets[relativeJumpTarget].offset = bytecode.all.size();
+	bytecode.jumpOffsetTargets[relativeJumpTarget].resolved = 0; // all of them again if it moved
+	*bytecode.jumpsPending.push() = relativeJumpTarget;
+}
+
+//------------------------------------------------------------------------------
+void WRCompilationContext::addRelativeJumpReference( WRBytecode& bytecode, int relativeJumpTarget, int offset )
+{
+	bytecode.jumpOffsetTargets[relativeJumpTarget].references.append() = offset;
+	*bytecode.jumpsPending.push() = relativeJumpTarget;
+}
+
+//------------------------------------------------------------------------------
+// with m_farJumps a branch goes to a 32-bit jump placed right after
+// it, and steps over that when it is not taken:
+//   <branch> via; RelativeJump past; via: RelativeJump32 target; past:
+// 'via' is the target the branch was given
+void WRCompilationContext::addFarJump( WRBytecode& bytecode, int via, int relativeJumpTarget )
+{
+	const int past = addRelativeJumpTarget( bytecode );
+	pushOpcode( bytecode, O_RelativeJump );
+	addRelativeJumpReference( bytecode, past, bytecode.all.size() );
+	pushData( bytecode, "\t\t", 2 );
+
+	setRelativeJumpTarget( bytecode, via );
+	pushOpcode( bytecode, O_RelativeJump32 );
+	addRelativeJumpReference( bytecode, relativeJumpTarget, bytecode.all.size() );
+	pushData( bytecode, "\t\t\t\t", 4 );
+
+	setRelativeJumpTarget( bytecode, past );
+	bytecode.invalidateOpcodeCache(); // nothing may be folded into it
+}
+
+//------------------------------------------------------------------------------
+void WRCompilationContext::addRelativeJumpSourceEx( WRBytecode& bytecode, WROpcode opcode, int relativeJumpTarget, const unsigned char* data, const int dataSize )
+{
+	const int via = m_farJumps ? addRelativeJumpTarget( bytecode ) : relativeJumpTarget;
+
+	pushOpcode( bytecode, opcode );
+
+	int offset = bytecode.all.size();
 	
-	unsigned int currentTop = -1;
-	unsigned int swapWith = -1;
-	for( unsigned int i=0; i<context.count(); ++i )
+	if ( dataSize ) // additional data
 	{
-		if ( context[i].stackPosition == stackPosition )
-		{
-			swapWith = i;
-		}
-		
-		if ( context[i].stackPosition == 0 )
-		{
-			currentTop = i;
-		}
+		pushData( bytecode, data, dataSize );
 	}
 
-	assert( (currentTop != (unsigned int)-1) && (swapWith != (unsigned int)-1) );
+	addRelativeJumpReference( bytecode, via, offset );
 
-	if ( addOpcodes )
+	pushData( bytecode, "\t\t", 2 ); // 16-bit relative vector
+
+	if ( m_farJumps )
 	{
-		unsigned char pos = stackPosition + 1;
-		WRCompilationContext::pushOpcode( bytecode, O_StackSwap );
-		WRCompilationContext::pushData( bytecode, &pos, 1 );
+		addFarJump( bytecode, via, relativeJumpTarget );
 	}
-	context[currentTop].stackPosition = stackPosition;
-	context[swapWith].stackPosition = 0;
 }
 
+
 //------------------------------------------------------------------------------
-void WRCompilationContext::resolveExpression( WRExpression& expression )
+// add a jump FROM with whatever opcode is supposed to do it
+void WRCompilationContext::addRelativeJumpSource( WRBytecode& bytecode, WROpcode opcode, int relativeJumpTarget )
 {
-	if ( expression.context.count() == 1 ) // single expression is trivial to resolve, load it!
+	if ( m_farJumps && opcode == O_RelativeJump )
 	{
-		loadExpressionContext( expression, 0, 0 );
+		pushOpcode( bytecode, O_RelativeJump32 );
+		addRelativeJumpReference( bytecode, relativeJumpTarget, bytecode.all.size() );
+		pushData( bytecode, "\t\t\t\t", 4 );
 		return;
 	}
 
-	unsigned int resolves = 1;
-	unsigned int startedWith = expression.context.count();
+	const int via = m_farJumps ? addRelativeJumpTarget( bytecode ) : relativeJumpTarget;
 
-	for( int p=0; p<c_highestPrecedence && expression.context.count() > 1; ++p )
+	pushOpcode( bytecode, opcode );
+
+	int offset = bytecode.all.size();
+	switch( bytecode.opcodes[bytecode.opcodes.size() - 1] )
 	{
-		// left to right operations
-		for( int o=0; (unsigned int)o < expression.context.count(); ++o )
+		case O_GSCompareEQBZ:
+		case O_LSCompareEQBZ:
+		case O_GSCompareNEBZ:
+		case O_LSCompareNEBZ:
+		case O_GSCompareGEBZ:
+		case O_LSCompareGEBZ:
+		case O_GSCompareLEBZ:
+		case O_LSCompareLEBZ:
+		case O_GSCompareGTBZ:
+		case O_LSCompareGTBZ:
+		case O_GSCompareLTBZ:
+		case O_LSCompareLTBZ:
 		{
-			if ( (expression.context[o].type != EXTYPE_OPERATION)
-				 || expression.context[o].operation->precedence > p
-				 || !expression.context[o].operation->leftToRight )
-			{
-				continue;
-			}
-
-			resolves += resolveExpressionEx( expression, o, p );
-			if (m_err)
-			{
-				return;
-			}
-			o = (unsigned int)-1;
+			--offset;
+			break;
 		}
 
-		// right to left operations
-		for( int o = expression.context.count() - 1; o >= 0; --o )
+		case O_LLCompareLTBZ:
+		case O_LLCompareGTBZ:
+		case O_LLCompareLEBZ:
+		case O_LLCompareGEBZ:
+		case O_LLCompareEQBZ:
+		case O_LLCompareNEBZ:
+		case O_GGCompareLTBZ:
+		case O_GGCompareGTBZ:
+		case O_GGCompareLEBZ:
+		case O_GGCompareGEBZ:
+		case O_GGCompareEQBZ:
+		case O_GGCompareNEBZ:
 		{
-			if ( (expression.context[o].type != EXTYPE_OPERATION)
-				 || expression.context[o].operation->precedence > p
-				 || expression.context[o].operation->leftToRight )
-			{
-				continue;
-			}
-
-			resolves += resolveExpressionEx( expression, o, p );
-			if (m_err)
-			{
-				return;
-			}
-			o = expression.context.count();
+			offset -= 2;
+			break;
 		}
+
+		default: break;
 	}
+	
+	addRelativeJumpReference( bytecode, via, offset );
+	pushData( bytecode, "\t\t", 2 );
 
-	if ( startedWith && (resolves != startedWith) )
+	if ( m_farJumps )
 	{
-		m_err = WR_ERR_bad_expression;
-		return;
+		addFarJump( bytecode, via, relativeJumpTarget );
 	}
 }
 
 //------------------------------------------------------------------------------
-unsigned int WRCompilationContext::resolveExpressionEx( WRExpression& expression, int o, int p )
+// only the targets that were set or got a reference since the last time
+// are visited, and of those only the references not yet pointed at
+// where the target is, so every jump is written once unless its target
+// moves. A displacement that does not fit in 16 bits sends the compile
+// back for another go with m_farJumps
+void WRCompilationContext::resolveRelativeJumps( WRBytecode& bytecode )
 {
-	unsigned int ret = 0;
-	switch( expression.context[o].operation->type )
+	for( unsigned int p=0; p<bytecode.jumpsPending.count(); ++p )
 	{
-		case WR_OPER_PRE:
+		const unsigned int j = bytecode.jumpsPending[p];
+		if ( j >= bytecode.jumpOffsetTargets.count() || bytecode.jumpOffsetTargets[j].offset < 0 )
 		{
-			ret = 1;
-
-			if ( expression.context[o + 1].stackPosition == -1 )
-			{
-				loadExpressionContext( expression, o + 1, 0 ); // load argument
-			}
-			else if ( expression.context[o + 1].stackPosition != 0 )
-			{
-				expression.swapWithTop( expression.context[o + 1].stackPosition );
-			}
-
-			appendBytecode( expression.bytecode, expression.context[o].bytecode );  // apply operator
-			expression.context.remove( o, 1 ); // knock off operator
-			expression.pushToStack(o);
-			break;
+			continue; // popped, or not set yet and setRelativeJumpTarget() lists it again
 		}
 
-		case WR_OPER_BINARY_COMMUTE:
+		for( unsigned int& t = bytecode.jumpOffsetTargets[j].resolved; t<bytecode.jumpOffsetTargets[j].references.count(); ++t )
 		{
-			// for operations like + and * the operands can be in any
-			// order, so don't go to any great lengths to shift the stack
-			// around for them
+			int diff = bytecode.jumpOffsetTargets[j].offset - bytecode.jumpOffsetTargets[j].references[t];
 
-			ret = 2;
+			int offset = bytecode.jumpOffsetTargets[j].references[t];
+			WROpcode o = (WROpcode)bytecode.all[offset - 1];
+			bool no8version = false;
 
-			if( o == 0 )
+			if ( o == O_RelativeJump32 )
 			{
-				m_err = WR_ERR_bad_expression;
-				return 0;
+				wr_pack32( diff, bytecode.all.p_str(offset) );
+				continue;
 			}
 
-			int second = o + 1; // push first
-			int first = o - 1;  // push second
-			// so
-			// 1 - first
-			// [oper]
-			// 0 - second
-
-			if ( expression.context[second].stackPosition == -1 )
+			switch( o )
 			{
-				if ( expression.context[first].stackPosition == -1 )
+				case O_GSCompareEQBZ8:
+				case O_LSCompareEQBZ8:
+				case O_GSCompareNEBZ8:
+				case O_LSCompareNEBZ8:
+				case O_GSCompareGEBZ8:
+				case O_LSCompareGEBZ8:
+				case O_GSCompareLEBZ8:
+				case O_LSCompareLEBZ8:
+				case O_GSCompareGTBZ8:
+				case O_LSCompareGTBZ8:
+				case O_GSCompareLTBZ8:
+				case O_LSCompareLTBZ8:
+				case O_GSCompareEQBZ:
+				case O_LSCompareEQBZ:
+				case O_GSCompareNEBZ:
+				case O_LSCompareNEBZ:
+				case O_GSCompareGEBZ:
+				case O_LSCompareGEBZ:
+				case O_GSCompareLEBZ:
+				case O_LSCompareLEBZ:
+				case O_GSCompareGTBZ:
+				case O_LSCompareGTBZ:
+				case O_GSCompareLTBZ:
+				case O_LSCompareLTBZ:
 				{
-					loadExpressionContext( expression, first, o ); 
+					--diff; // these instructions are offset
+					break;
 				}
-				else if ( expression.context[first].stackPosition != 0 )
+
+				case O_LLCompareLTBZ8:
+				case O_LLCompareGTBZ8:
+				case O_LLCompareLEBZ8:
+				case O_LLCompareGEBZ8:
+				case O_LLCompareEQBZ8:
+				case O_LLCompareNEBZ8:
+				case O_GGCompareLTBZ8:
+				case O_GGCompareGTBZ8:
+				case O_GGCompareLEBZ8:
+				case O_GGCompareGEBZ8:
+				case O_GGCompareEQBZ8:
+				case O_GGCompareNEBZ8:
+				case O_LLCompareLTBZ:
+				case O_LLCompareGTBZ:
+				case O_LLCompareLEBZ:
+				case O_LLCompareGEBZ:
+				case O_LLCompareEQBZ:
+				case O_LLCompareNEBZ:
+				case O_GGCompareLTBZ:
+				case O_GGCompareGTBZ:
+				case O_GGCompareLEBZ:
+				case O_GGCompareGEBZ:
+				case O_GGCompareEQBZ:
+				case O_GGCompareNEBZ:
 				{
-					// otherwise swap first to the top and load the second
-					expression.swapWithTop( expression.context[first].stackPosition );
+					diff -= 2;
+					break;
 				}
 
-				loadExpressionContext( expression, second, o );
-			}
-			else if ( expression.context[first].stackPosition == -1 )
-			{
-				if ( expression.context[second].stackPosition != 0 )
+				case O_GGNextKeyValueOrJump:
+				case O_GLNextKeyValueOrJump:
+				case O_LGNextKeyValueOrJump:
+				case O_LLNextKeyValueOrJump:
 				{
-					expression.swapWithTop( expression.context[second].stackPosition );
+					no8version = true;
+					diff -= 3;
+					break;
 				}
 
-				// just load the second to top
-				loadExpressionContext( expression, first, o );
-			}
-			else if ( expression.context[second].stackPosition == 1 )
-			{
-				expression.swapWithTop( expression.context[first].stackPosition );
-			}
-			else if ( expression.context[first].stackPosition == 1 )
-			{
-				expression.swapWithTop( expression.context[second].stackPosition );
+				case O_GNextValueOrJump:
+				case O_LNextValueOrJump:
+				{
+					no8version = true;
+					diff -= 2;
+					break;
+				}
+
+				default:
+					break;
 			}
-			else
+
+			
+			if ( (diff < 128) && (diff > -129) && !no8version )
 			{
-				// first and second are both loaded but neither
-				// is in the correct position
+				switch( o )
+				{
+					case O_RelativeJump: *bytecode.all.p_str(offset - 1) = O_RelativeJump8; break;
+					case O_BZ: *bytecode.all.p_str(offset - 1) = O_BZ8; break;
 
-				WRCompilationContext::pushOpcode( expression.bytecode, O_SwapTwoToTop );
-				unsigned char pos = expression.context[first].stackPosition + 1;
-				WRCompilationContext::pushData( expression.bytecode, &pos, 1 );
-				pos = expression.context[second].stackPosition + 1;
-				WRCompilationContext::pushData( expression.bytecode, &pos, 1 );
+					case O_CompareBEQ: *bytecode.all.p_str(offset - 1) = O_CompareBEQ8; break;
+					case O_CompareBNE: *bytecode.all.p_str(offset - 1) = O_CompareBNE8; break;
+					case O_CompareBGE: *bytecode.all.p_str(offset - 1) = O_CompareBGE8; break;
+					case O_CompareBLE: *bytecode.all.p_str(offset - 1) = O_CompareBLE8; break;
+					case O_CompareBGT: *bytecode.all.p_str(offset - 1) = O_CompareBGT8; break;
+					case O_CompareBLT: *bytecode.all.p_str(offset - 1) = O_CompareBLT8; break;
 
-				expression.swapWithTop( expression.context[second].stackPosition, false );
-				expression.swapWithTop( 1, false );
-				expression.swapWithTop( expression.context[first].stackPosition, false );
-			}
+					case O_GSCompareEQBZ: *bytecode.all.p_str(offset - 1) = O_GSCompareEQBZ8; ++offset; break;
+					case O_LSCompareEQBZ: *bytecode.all.p_str(offset - 1) = O_LSCompareEQBZ8; ++offset; break;
+					case O_GSCompareNEBZ: *bytecode.all.p_str(offset - 1) = O_GSCompareNEBZ8; ++offset; break;
+					case O_LSCompareNEBZ: *bytecode.all.p_str(offset - 1) = O_LSCompareNEBZ8; ++offset; break;
+					case O_GSCompareGEBZ: *bytecode.all.p_str(offset - 1) = O_GSCompareGEBZ8; ++offset; break;
+					case O_LSCompareGEBZ: *bytecode.all.p_str(offset - 1) = O_LSCompareGEBZ8; ++offset; break;
+					case O_GSCompareLEBZ: *bytecode.all.p_str(offset - 1) = O_GSCompareLEBZ8; ++offset; break;
+					case O_LSCompareLEBZ: *bytecode.all.p_str(offset - 1) = O_LSCompareLEBZ8; ++offset; break;
+					case O_GSCompareGTBZ: *bytecode.all.p_str(offset - 1) = O_GSCompareGTBZ8; ++offset; break;
+					case O_LSCompareGTBZ: *bytecode.all.p_str(offset - 1) = O_LSCompareGTBZ8; ++offset; break;
+					case O_GSCompareLTBZ: *bytecode.all.p_str(offset - 1) = O_GSCompareLTBZ8; ++offset; break;
+					case O_LSCompareLTBZ: *bytecode.all.p_str(offset - 1) = O_LSCompareLTBZ8; ++offset; break;
+										  
+					case O_LLCompareLTBZ: *bytecode.all.p_str(offset - 1) = O_LLCompareLTBZ8; offset += 2; break;
+					case O_LLCompareGTBZ: *bytecode.all.p_str(offset - 1) = O_LLCompareGTBZ8; offset += 2; break;
+					case O_LLCompareLEBZ: *bytecode.all.p_str(offset - 1) = O_LLCompareLEBZ8; offset += 2; break;
+					case O_LLCompareGEBZ: *bytecode.all.p_str(offset - 1) = O_LLCompareGEBZ8; offset += 2; break;
+					case O_LLCompareEQBZ: *bytecode.all.p_str(offset - 1) = O_LLCompareEQBZ8; offset += 2; break;
+					case O_LLCompareNEBZ: *bytecode.all.p_str(offset - 1) = O_LLCompareNEBZ8; offset += 2; break;
+					case O_GGCompareLTBZ: *bytecode.all.p_str(offset - 1) = O_GGCompareLTBZ8; offset += 2; break;
+					case O_GGCompareGTBZ: *bytecode.all.p_str(offset - 1) = O_GGCompareGTBZ8; offset += 2; break;
+					case O_GGCompareLEBZ: *bytecode.all.p_str(offset - 1) = O_GGCompareLEBZ8; offset += 2; break;
+					case O_GGCompareGEBZ: *bytecode.all.p_str(offset - 1) = O_GGCompareGEBZ8; offset += 2; break;
+					case O_GGCompareEQBZ: *bytecode.all.p_str(offset - 1) = O_GGCompareEQBZ8; offset += 2; break;
+					case O_GGCompareNEBZ: *bytecode.all.p_str(offset - 1) = O_GGCompareNEBZ8; offset += 2; break;
 
-			appendBytecode( expression.bytecode, expression.context[o].bytecode ); // apply operator
+					case O_BLA: *bytecode.all.p_str(offset - 1) = O_BLA8; break;
+					case O_BLO: *bytecode.all.p_str(offset - 1) = O_BLO8; break;
 
-			expression.context.remove( o - 1, 2 ); // knock off operator and arg
-			expression.pushToStack(o - 1);
+					// no work to be done
+					case O_RelativeJump8:
+					case O_BZ8:
+					case O_BLA8:
+					case O_BLO8:
+					case O_CompareBLE8:
+					case O_CompareBGE8:
+					case O_CompareBGT8:
+					case O_CompareBLT8:
+					case O_CompareBEQ8:
+					case O_CompareBNE8:
+						break;
+						
+					case O_GSCompareEQBZ8:
+					case O_LSCompareEQBZ8:
+					case O_GSCompareNEBZ8:
+					case O_LSCompareNEBZ8:
+					case O_GSCompareGEBZ8:
+					case O_LSCompareGEBZ8:
+					case O_GSCompareLEBZ8:
+					case O_LSCompareLEBZ8:
+					case O_GSCompareGTBZ8:
+					case O_LSCompareGTBZ8:
+					case O_GSCompareLTBZ8:
+					case O_LSCompareLTBZ8:
+						++offset;
+						break;
 
-			break;
-		}
+					case O_LLCompareLTBZ8:
+					case O_LLCompareGTBZ8:
+					case O_LLCompareLEBZ8:
+					case O_LLCompareGEBZ8:
+					case O_LLCompareEQBZ8:
+					case O_LLCompareNEBZ8:
+					case O_GGCompareLTBZ8:
+					case O_GGCompareGTBZ8:
+					case O_GGCompareLEBZ8:
+					case O_GGCompareGEBZ8:
+					case O_GGCompareEQBZ8:
+					case O_GGCompareNEBZ8:
+					{
+						offset += 2;
+						break;
+					}
 
-		case WR_OPER_BINARY:
-		{
-			ret = 2;
+					default:
+						m_err = WR_ERR_compiler_panic;
+						return;
+				}
 
-			if( o == 0 )
-			{
-				m_err = WR_ERR_bad_expression;
-				return 0;
+				*bytecode.all.p_str(offset) = (int8_t)diff;
 			}
-
-			int second = o + 1; // push first
-			int first = o - 1;  // push second
-			bool useAlt = false;
-			// so
-			// 1 - first
-			// [oper]
-			// 0 - second
-
-			if ( expression.context[second].stackPosition == -1 )
+			else
 			{
-				if ( expression.context[first].stackPosition == -1 )
-				{
-					loadExpressionContext( expression, second, o ); // nope, grab 'em
-					loadExpressionContext( expression, first, o ); 
-				}
-				else
+				switch( o )
 				{
-					// first is in the stack somewhere, we need
-					// to swap it to the top, then load, then
-					// swap top values
-					expression.swapWithTop( expression.context[first].stackPosition );
+					// check to see if any were pushed into 16-bit land
+					// that were previously optimized
+					case O_RelativeJump8: *bytecode.all.p_str(offset - 1) = O_RelativeJump; break;
+					case O_BZ8: *bytecode.all.p_str(offset - 1) = O_BZ; break;
+					case O_CompareBEQ8: *bytecode.all.p_str(offset - 1) = O_CompareBEQ; break;
+					case O_CompareBNE8: *bytecode.all.p_str(offset - 1) = O_CompareBNE; break;
+					case O_CompareBGE8: *bytecode.all.p_str(offset - 1) = O_CompareBGE; break;
+					case O_CompareBLE8: *bytecode.all.p_str(offset - 1) = O_CompareBLE; break;
+					case O_CompareBGT8: *bytecode.all.p_str(offset - 1) = O_CompareBGT; break;
+					case O_CompareBLT8: *bytecode.all.p_str(offset - 1) = O_CompareBLT; break;
+					case O_GSCompareEQBZ8: *bytecode.all.p_str(offset - 1) = O_GSCompareEQBZ; ++offset; break;
+					case O_LSCompareEQBZ8: *bytecode.all.p_str(offset - 1) = O_LSCompareEQBZ; ++offset; break;
+					case O_GSCompareNEBZ8: *bytecode.all.p_str(offset - 1) = O_GSCompareNEBZ; ++offset; break;
+					case O_LSCompareNEBZ8: *bytecode.all.p_str(offset - 1) = O_LSCompareNEBZ; ++offset; break;
+					case O_GSCompareGEBZ8: *bytecode.all.p_str(offset - 1) = O_GSCompareGEBZ; ++offset; break;
+					case O_LSCompareGEBZ8: *bytecode.all.p_str(offset - 1) = O_LSCompareGEBZ; ++offset; break;
+					case O_GSCompareLEBZ8: *bytecode.all.p_str(offset - 1) = O_GSCompareLEBZ; ++offset; break;
+					case O_LSCompareLEBZ8: *bytecode.all.p_str(offset - 1) = O_LSCompareLEBZ; ++offset; break;
+					case O_GSCompareGTBZ8: *bytecode.all.p_str(offset - 1) = O_GSCompareGTBZ; ++offset; break;
+					case O_LSCompareGTBZ8: *bytecode.all.p_str(offset - 1) = O_LSCompareGTBZ; ++offset; break;
+					case O_GSCompareLTBZ8: *bytecode.all.p_str(offset - 1) = O_GSCompareLTBZ; ++offset; break;
+					case O_LSCompareLTBZ8: *bytecode.all.p_str(offset - 1) = O_LSCompareLTBZ; ++offset; break;
 
-					loadExpressionContext( expression, second, o );
+					case O_LLCompareLTBZ8: *bytecode.all.p_str(offset - 1) = O_LLCompareLTBZ; offset += 2; break;
+					case O_LLCompareGTBZ8: *bytecode.all.p_str(offset - 1) = O_LLCompareGTBZ; offset += 2; break;
+					case O_LLCompareLEBZ8: *bytecode.all.p_str(offset - 1) = O_LLCompareLEBZ; offset += 2; break;
+					case O_LLCompareGEBZ8: *bytecode.all.p_str(offset - 1) = O_LLCompareGEBZ; offset += 2; break;
+					case O_LLCompareEQBZ8: *bytecode.all.p_str(offset - 1) = O_LLCompareEQBZ; offset += 2; break;
+					case O_LLCompareNEBZ8: *bytecode.all.p_str(offset - 1) = O_LLCompareNEBZ; offset += 2; break;
+					case O_GGCompareLTBZ8: *bytecode.all.p_str(offset - 1) = O_GGCompareLTBZ; offset += 2; break;
+					case O_GGCompareGTBZ8: *bytecode.all.p_str(offset - 1) = O_GGCompareGTBZ; offset += 2; break;
+					case O_GGCompareLEBZ8: *bytecode.all.p_str(offset - 1) = O_GGCompareLEBZ; offset += 2; break;
+					case O_GGCompareGEBZ8: *bytecode.all.p_str(offset - 1) = O_GGCompareGEBZ; offset += 2; break;
+					case O_GGCompareEQBZ8: *bytecode.all.p_str(offset - 1) = O_GGCompareEQBZ; offset += 2; break;
+					case O_GGCompareNEBZ8: *bytecode.all.p_str(offset - 1) = O_GGCompareNEBZ; offset += 2; break;
 
-					if ( expression.context[o].operation->alt == O_LAST )
+					case O_GGNextKeyValueOrJump:
+					case O_GLNextKeyValueOrJump:
+					case O_LGNextKeyValueOrJump:
+					case O_LLNextKeyValueOrJump:
 					{
-						expression.swapWithTop( 1 );
+						offset += 3;
+						break;
 					}
-					else // otherwise top shuffle is NOT required because we have an equal-but-opposite operation
+
+					case O_GNextValueOrJump:
+					case O_LNextValueOrJump:
 					{
-						useAlt = true;
+						offset += 2;
+						break;
 					}
-				}
-			}
-			else if ( expression.context[first].stackPosition == -1 )
-			{
-				// perfect, swap up the second, then load the
-				// first
 
-				expression.swapWithTop( expression.context[second].stackPosition );
+					case O_BLA8: *bytecode.all.p_str(offset - 1) = O_BLA; break;
+					case O_BLO8: *bytecode.all.p_str(offset - 1) = O_BLO; break;
 
-				loadExpressionContext( expression, first, o );
-			}
-			else if ( expression.context[second].stackPosition == 1 )
-			{
-				// second is already where its supposed to be,
-				// swap first to top if it's not there already
-				if ( expression.context[first].stackPosition != 0 )
-				{
-					expression.swapWithTop( expression.context[first].stackPosition );
-				}
-			}
-			else if ( expression.context[second].stackPosition == 0 )
-			{
-				// second is on top of the stack, swap with
-				// next level down then swap first up
+					 // no work to be done, already visited
+					case O_RelativeJump:
+					case O_BZ:
+					case O_BLA:
+					case O_BLO:
+					case O_CompareBLE:
+					case O_CompareBGE:
+					case O_CompareBGT:
+					case O_CompareBLT:
+					case O_CompareBEQ:
+					case O_CompareBNE:
+						break;
 
-				WRCompilationContext::pushOpcode( expression.bytecode, O_SwapTwoToTop );
-				unsigned char pos = expression.context[first].stackPosition + 1;
-				WRCompilationContext::pushData( expression.bytecode, &pos, 1 );
-				pos = 2;
-				WRCompilationContext::pushData( expression.bytecode, &pos, 1 );
+					case O_GSCompareEQBZ:
+					case O_LSCompareEQBZ:
+					case O_GSCompareNEBZ:
+					case O_LSCompareNEBZ:
+					case O_GSCompareGEBZ:
+					case O_LSCompareGEBZ:
+					case O_GSCompareLEBZ:
+					case O_LSCompareLEBZ:
+					case O_GSCompareGTBZ:
+					case O_LSCompareGTBZ:
+					case O_GSCompareLTBZ:
+					case O_LSCompareLTBZ:
+						++offset;
+						break;
+					
+					case O_LLCompareLTBZ:
+					case O_LLCompareGTBZ:
+					case O_LLCompareLEBZ:
+					case O_LLCompareGEBZ:
+					case O_LLCompareEQBZ:
+					case O_LLCompareNEBZ:
+					case O_GGCompareLTBZ:
+					case O_GGCompareGTBZ:
+					case O_GGCompareLEBZ:
+					case O_GGCompareGEBZ:
+					case O_GGCompareEQBZ:
+					case O_GGCompareNEBZ:
+					{
+						offset += 2;
+						break;
+					}
+						
+					default:
+					{
+						m_err = WR_ERR_compiler_panic;
+						return;
+					}
+				}
 
-				expression.swapWithTop( 1, false );
-				expression.swapWithTop( expression.context[first].stackPosition, false );
+				if ( diff > 0x7FFF || diff < -0x8000 )
+				{
+					if ( m_farJumps )
+					{
+						m_err = WR_ERR_compiler_panic;
+						return;
+					}
+					m_jumpOutOfRange = true;
+				}
+				
+				wr_pack16( (int16_t)diff, bytecode.all.p_str(offset) );
 			}
-			else
-			{
-				// first and second are both loaded but neither is in the correct position
+		}
+	}
 
-				WRCompilationContext::pushOpcode( expression.bytecode, O_SwapTwoToTop );
-				unsigned char pos = expression.context[first].stackPosition + 1;
-				WRCompilationContext::pushData( expression.bytecode, &pos, 1 );
-				pos = expression.context[second].stackPosition + 1;
-				WRCompilationContext::pushData( expression.bytecode, &pos, 1 );
+	if ( bytecode.jumpsPending.count() )
+	{
+		bytecode.jumpsPending.setCount( 0 );
+	}
+}
 
-				expression.swapWithTop( expression.context[second].stackPosition, false );
-				expression.swapWithTop( 1, false );
-				expression.swapWithTop( expression.context[first].stackPosition, false );
-			}
+//------------------------------------------------------------------------------
+void WRCompilationContext::pushLiteral( WRBytecode& bytecode, WRExpressionContext& context, WROpcode stringOpcode )
+{
+	WRValue& value = context.value;
+	unsigned char data[4];
+	
+	if ( value.type == WR_INT && value.i == 0 )
+	{
+		pushOpcode( bytecode, O_LiteralZero );
+	}
+	else if ( value.type == WR_INT )
+	{
+		if ( (value.i <= 127) && (value.i >= -128) )
+		{
+			pushOpcode( bytecode, O_LiteralInt8 );
+			unsigned char be = (char)value.i;
+			pushData( bytecode, &be, 1 );
+		}
+		else if ( (value.i <= 32767) && (value.i >= -32768) )
+		{
+			pushOpcode( bytecode, O_LiteralInt16 );
+			int16_t be = value.i;
+			pushData( bytecode, wr_pack16(be, data), 2 );
+		}
+		else
+		{
+			pushOpcode( bytecode, O_LiteralInt32 );
+			unsigned char data[4];
+			pushData( bytecode, wr_pack32(value.i, data), 4 );
+		}
+	}
+	else if ( (uint8_t)value.type == WR_COMPILER_LITERAL_STRING )
+	{
+		pushOpcode( bytecode, stringOpcode );
+		int16_t be = context.literalString.size();
+		pushData( bytecode, wr_pack16(be, data), 2 );
+		for( unsigned int i=0; i<context.literalString.size(); ++i )
+		{
+			pushData( bytecode, context.literalString.c_str(i), 1 );
+		}
+	}
+	else
+	{
+		pushOpcode( bytecode, O_LiteralFloat );
+		int32_t be = value.i;
+		pushData( bytecode, wr_pack32(be, data), 4 );
+	}
+}
 
-			if ( useAlt )
-			{
-				pushOpcode( expression.bytecode, expression.context[o].operation->alt );
-			}
-			else
-			{
-				appendBytecode( expression.bytecode, expression.context[o].bytecode ); // apply operator
-			}
+//------------------------------------------------------------------------------
+void WRCompilationContext::pushLibConstant( WRBytecode& bytecode, WRExpressionContext& context )
+{
+	pushOpcode( bytecode, O_LoadLibConstant );
+	unsigned char data[4];
+	uint32_t hash = wr_hashStr(context.prefix + "::" + context.token);
+	pushData( bytecode, wr_pack32(hash, data), 4 );
+}
 
-			expression.context.remove( o - 1, 2 ); // knock off operator and arg
-			expression.pushToStack(o - 1);
+//------------------------------------------------------------------------------
+int WRCompilationContext::addLocalSpaceLoad( WRBytecode& bytecode, WRstr& token, bool addOnly, bool varSeen )
+{
+	if ( m_unitTop == 0 )
+	{
+		return addGlobalSpaceLoad( bytecode, token, addOnly, varSeen );
+	}
 
-			break;
-		}
+	uint32_t hash = wr_hash( token, token.size() );
+	
+	int i = bytecode.findLocal( hash );
 
-		case WR_OPER_POST:
+	if ( i < 0 )
+	{
+		if ( !addOnly )
 		{
-			ret = 1;
-
-			if( o == 0 )
-			{
-				m_err = WR_ERR_bad_expression;
-				return 0;
-			}
-
-			if ( expression.context[o - 1].stackPosition == -1 )
-			{
-				loadExpressionContext( expression, o - 1, o ); // load argument
-			}
-			else if ( expression.context[o - 1].stackPosition != 0 )
+			// was NOT found locally which is possible for a "global" if
+			// the argument list names it, now check global with the global
+			// hash
+			if ( !bytecode.isStructSpace || varSeen ) // structs and explicit 'var' are immune to this
 			{
-				expression.swapWithTop( expression.context[o - 1].stackPosition );
+				uint32_t ghash = (varSeen || (token[0] == ':' && token[1] == ':'))
+								 ? hash
+								 : wr_hash( token, token.size(), wr_hash("::", 2) );
+				
+				int j = m_units[0].bytecode.findLocal( ghash );
+				if ( j >= 0 )
+				{
+					pushOpcode(bytecode, O_LoadFromGlobal);
+					unsigned char c = j;
+					pushData(bytecode, &c, 1);
+					return j;
+				}
 			}
+		}
 
-			appendBytecode( expression.bytecode, expression.context[o].bytecode );
-			expression.context.remove( o, 1 ); // knock off operator
-			expression.pushToStack( o - 1 );
-
-			break;
+		if ( m_needVar && !varSeen )
+		{
+			m_err = WR_ERR_var_not_seen_before_label;
+			return 0;
 		}
+
+		i = bytecode.localSpace.count();
+		bytecode.localSpace[i].hash = hash;
+		bytecode.localSpace[i].label = token;
 	}
 	
-	return ret;
+	if ( !addOnly )
+	{
+		pushOpcode( bytecode, O_LoadFromLocal );
+		unsigned char c = i;
+		pushData( bytecode, &c, 1 );
+	}
+	
+	return i;
 }
 
 //------------------------------------------------------------------------------
-bool WRCompilationContext::operatorFound( WRstr const& token, WRarray<WRExpressionContext>& context, int depth )
+int WRCompilationContext::addGlobalSpaceLoad( WRBytecode& bytecode, WRstr& token, bool addOnly, bool varSeen )
 {
-	for( int i=0; c_operations[i].token; i++ )
+	const bool qualified = token[0] == ':' && token[1] == ':';
+	uint32_t hash = qualified ? wr_hash( token, token.size() )
+							  : wr_hash( token, token.size(), wr_hash("::", 2) );
+
+	int i = m_units[0].bytecode.findLocal( hash );
+
+	if ( i < 0 )
 	{
-		if ( token == c_operations[i].token )
+		if ( m_needVar && !varSeen )
 		{
-			if ( c_operations[i].type == WR_OPER_PRE
-				 && depth > 0
-				 && (context[depth-1].type != EXTYPE_OPERATION 
-					 || (context[depth - 1].type == EXTYPE_OPERATION &&
-						 (context[depth - 1].operation->type != WR_OPER_BINARY && context[depth - 1].operation->type != WR_OPER_BINARY_COMMUTE))) )
-			{
-				continue;
-			}
-			
-			context[depth].operation = c_operations + i;
-			context[depth].type = EXTYPE_OPERATION;
-
-			pushOpcode( context[depth].bytecode, c_operations[i].opcode );
+			m_err = WR_ERR_var_not_seen_before_label;
+			return 0;
+		}
 
-			return true;
+		// the label is only needed for the symbol table, build it once
+		i = m_units[0].bytecode.localSpace.count();
+		WRNamespaceLookup& space = m_units[0].bytecode.localSpace[i];
+		space.hash = hash;
+		if ( qualified )
+		{
+			space.label = token;
+		}
+		else
+		{
+			space.label.format( "::%s", token.c_str() );
 		}
 	}
 
-	return false;
+	if ( !addOnly )
+	{
+		pushOpcode( bytecode, O_LoadFromGlobal );
+		unsigned char c = i;
+		pushData( bytecode, &c, 1 );
+	}
+
+	return i;
 }
 
 //------------------------------------------------------------------------------
-bool WRCompilationContext::parseCallFunction( WRExpression& expression, WRstr functionName, int depth, bool parseArguments )
+void WRCompilationContext::loadExpressionContext( WRExpression& expression, int depth, int operation )
 {
-	WRstr prefix = expression.context[depth].prefix;
-
-	expression.context[depth].type = EXTYPE_BYTECODE_RESULT;
-	
-	unsigned char argsPushed = 0;
-
-	if ( parseArguments )
+	if ( operation > 0
+		 && expression.context[operation].operation
+		 && expression.context[operation].operation->opcode == O_HASH_PLACEHOLDER
+		 && depth > operation )
 	{
-		WRstr& token2 = expression.context[depth].token;
-		WRValue& value2 = expression.context[depth].value;
-
-		for(;;)
+		unsigned char buf[4];
+		wr_pack32( wr_hash( expression.context[depth].token,
+							expression.context[depth].token.size()),
+				   buf );
+		pushOpcode( expression.bytecode, O_LiteralInt32 );
+		pushData( expression.bytecode, buf, 4 );
+	}
+	else
+	{
+		switch( expression.context[depth].type )
 		{
-			if ( !getToken(expression.context[depth]) )
+			case EXTYPE_LIB_CONSTANT:
 			{
-				m_err = WR_ERR_unexpected_EOF;
-				return 0;
+				pushLibConstant( expression.bytecode, expression.context[depth] );
+				break;
 			}
-
-			if ( !m_quoted && token2 == ")" )
+			
+			case EXTYPE_LITERAL:
 			{
+				// a string that is only compared never escapes, so it
+				// can be a view of the code instead of a new array, as
+				// long as no code runs between loading it and the compare
+				WROpcode stringOpcode = O_LiteralString;
+				if ( operation > 0 && expression.context[operation].operation )
+				{
+					switch( expression.context[operation].operation->opcode )
+					{
+						case O_CompareEQ:
+						case O_CompareNE:
+						case O_CompareGT:
+						case O_CompareLT:
+						case O_CompareGE:
+						case O_CompareLE:
+						{
+							WRExpressionContext& other = expression.context[ 2*operation - depth ];
+							if ( other.stackPosition != -1
+								 || other.type == EXTYPE_LITERAL
+								 || other.type == EXTYPE_LABEL
+								 || other.type == EXTYPE_LIB_CONSTANT )
+							{
+								stringOpcode = O_LiteralStringView;
+							}
+							break;
+						}
+
+						default: break;
+					}
+				}
+				
+				pushLiteral( expression.bytecode, expression.context[depth], stringOpcode );
 				break;
 			}
 
-			++argsPushed;
-
-			WRExpression nex( expression.bytecode.localSpace, expression.bytecode.isStructSpace );
-			nex.context[0].token = token2;
-			nex.context[0].value = value2;
-			m_loadedToken = token2;
-			m_loadedValue = value2;
-			m_loadedQuoted = m_quoted;
-			
-			char end = parseExpression( nex );
-
-			if ( nex.bytecode.opcodes.size() > 0 )
+			case EXTYPE_LABEL_AND_NULL:
+			case EXTYPE_LABEL:
 			{
-				uint8_t op = nex.bytecode.opcodes[nex.bytecode.opcodes.size() - 1];
-				if ( op == O_Index
-					 || op == O_IndexSkipLoad
-					 || op == O_IndexLiteral8
-					 || op == O_IndexLiteral16
-					 || op == O_IndexLocalLiteral8
-					 || op == O_IndexGlobalLiteral8
-					 || op == O_IndexLocalLiteral16
-					 || op == O_IndexGlobalLiteral16 )
+				if ( expression.context[depth].global )
 				{
-					nex.bytecode.opcodes += O_Dereference;
-					nex.bytecode.all += O_Dereference;
+					addGlobalSpaceLoad( expression.bytecode,
+										expression.context[depth].token,
+										false,
+										expression.context[depth].varSeen );
+				}
+				else
+				{
+					addLocalSpaceLoad( expression.bytecode,
+									   expression.context[depth].token,
+									   false,
+									   expression.context[depth].varSeen );
+				}
+
+				if ( expression.context[depth].type == EXTYPE_LABEL_AND_NULL )
+				{
+					expression.bytecode.all += O_InitVar;
+					expression.bytecode.opcodes += O_InitVar;
 				}
+						
+				break;
 			}
-			
-			appendBytecode( expression.context[depth].bytecode, nex.bytecode );
 
-			if ( end == ')' )
+			case EXTYPE_BYTECODE_RESULT:
 			{
+				appendBytecode( expression.bytecode,
+								expression.context[depth].bytecode );
 				break;
 			}
-			else if ( end != ',' )
+
+			case EXTYPE_RESOLVED:
+			case EXTYPE_OPERATION:
+			default:
 			{
-				m_err = WR_ERR_unexpected_token;
-				return 0;
+				break;
 			}
 		}
 	}
 
-	pushDebug( WRD_LineNumber, expression.context[depth].bytecode, getSourcePosition() );
-	pushDebug( WRD_FunctionCall, expression.context[depth].bytecode, WRD_ExternalFunction );
+	expression.pushToStack( depth ); // make sure stack knows something got loaded on top of it
+	
+	expression.context[depth].type = EXTYPE_RESOLVED; // this slot is now a resolved value sitting on the stack
+}
 
-	if ( prefix.size() )
+//------------------------------------------------------------------------------
+void WRExpression::swapWithTop( int stackPosition, bool addOpcodes )
+{
+	if ( stackPosition == 0 )
 	{
-		prefix += "::";
-		prefix += functionName;
-
-		unsigned char buf[4];
-		wr_pack32( wr_hashStr(prefix), buf );
-
-		pushOpcode( expression.context[depth].bytecode, O_CallLibFunction );
-		pushData( expression.context[depth].bytecode, &argsPushed, 1 ); // arg #
-		pushData( expression.context[depth].bytecode, buf, 4 ); // hash id
-
-		// normal lib will copy down the result, otherwise
-		// ignore it, it will be AFTER args
+		return;
 	}
-	else
+	
+	unsigned int currentTop = -1;
+	unsigned int swapWith = -1;
+	for( unsigned int i=0; i<context.count(); ++i )
 	{
-		// push the number of args
-		uint32_t hash = wr_hashStr( functionName );
-
-		unsigned int i=0;
-		for( ; i<expression.context[depth].bytecode.functionSpace.count(); ++i )
-		{
-			if ( expression.context[depth].bytecode.functionSpace[i].hash == hash )
-			{
-				break;
-			}
-		}
-
-		expression.context[depth].bytecode.functionSpace[i].references.append() = getBytecodePosition( expression.context[depth].bytecode );
-		expression.context[depth].bytecode.functionSpace[i].hash = hash;
-
-		if ( hash == wr_hashStr("yield") )
+		if ( context[i].stackPosition == stackPosition )
 		{
-			pushOpcode( expression.context[depth].bytecode, O_Yield );
-			pushData( expression.context[depth].bytecode, &argsPushed, 1 );
+			swapWith = i;
 		}
-		else
+		
+		if ( context[i].stackPosition == 0 )
 		{
-			pushOpcode( expression.context[depth].bytecode, O_FUNCTION_CALL_PLACEHOLDER );
-			pushData( expression.context[depth].bytecode, &argsPushed, 1 );
-			pushData( expression.context[depth].bytecode, "XXXX", 4 ); // TBD opcode plus index, OR hash if index was not found
+			currentTop = i;
 		}
-		
-		// hash will copydown result same as lib, unless
-		// copy/pop which case does nothing
-
-		// normal call does nothing special, to preserve
-		// the return value a call to copy-down must be
-		// inserted
 	}
 
-	return true;
+	assert( (currentTop != (unsigned int)-1) && (swapWith != (unsigned int)-1) );
+
+	if ( addOpcodes )
+	{
+		unsigned char pos = stackPosition + 1;
+		WRCompilationContext::pushOpcode( bytecode, O_StackSwap );
+		WRCompilationContext::pushData( bytecode, &pos, 1 );
+	}
+	context[currentTop].stackPosition = stackPosition;
+	context[swapWith].stackPosition = 0;
 }
 
 //------------------------------------------------------------------------------
-bool WRCompilationContext::pushObjectTable( WRExpressionContext& context,
-											WRarray<WRNamespaceLookup>& localSpace,
-											uint32_t hash )
+void WRCompilationContext::resolveExpression( WRExpression& expression )
 {
-	WRstr& token2 = context.token;
-	WRValue& value2 = context.value;
-
-	bool byHash = false;
-	bool byOrder = false;
-	
-	unsigned int i=0;
-	for( ; i<context.bytecode.unitObjectSpace.count(); ++i )
+	if ( expression.context.count() == 1 ) // single expression is trivial to resolve, load it!
 	{
-		if ( context.bytecode.unitObjectSpace[i].hash == hash )
-		{
-			break;
-		}
+		loadExpressionContext( expression, 0, 0 );
+		return;
 	}
 
-	pushOpcode( context.bytecode, O_NewObjectTable );
-
-	context.bytecode.unitObjectSpace[i].references.append() = getBytecodePosition( context.bytecode );
-	context.bytecode.unitObjectSpace[i].hash = hash;
-
-	pushData( context.bytecode, "\0\0", 2 );
-
-	context.type = EXTYPE_BYTECODE_RESULT;
+	unsigned int resolves = 1;
+	unsigned int startedWith = expression.context.count();
 
-	if ( !m_quoted && token2 == "{" )
+	for( int p=0; p<c_highestPrecedence && expression.context.count() > 1; ++p )
 	{
-		unsigned char offset = 0;
-		for(;;)
+		// left to right operations
+		for( int o=0; (unsigned int)o < expression.context.count(); ++o )
 		{
-			WRExpression nex( localSpace, context.bytecode.isStructSpace );
-			nex.context[0].token = token2;
-			nex.context[0].value = value2;
-
-			m_parsingNew = true;
-
-			bool v = m_needVar;
-			m_needVar = false;
-			char end = parseExpression( nex );
-			m_needVar = v;
-
-			m_parsingNew = false;
-
-			if ( nex.bytecode.all.size() )
+			if ( (expression.context[o].type != EXTYPE_OPERATION)
+				 || expression.context[o].operation->precedence > p
+				 || !expression.context[o].operation->leftToRight )
 			{
-				appendBytecode( context.bytecode, nex.bytecode );
-
-				if ( m_newHashValue )
-				{
-					if ( byOrder )
-					{
-						m_err = WR_ERR_new_assign_by_label_or_offset_not_both;
-						return false;
-					}
-					byHash = true;
-					
-					pushOpcode( context.bytecode, O_AssignToObjectTableByHash );
-					uint8_t dat[4];
-					pushData( context.bytecode, wr_pack32(m_newHashValue, dat), 4 );
-				}
-				else
-				{
-					if ( byHash )
-					{
-						m_err = WR_ERR_new_assign_by_label_or_offset_not_both;
-						return false;
-					}
-					byOrder = true;
-
-					pushOpcode( context.bytecode, O_AssignToObjectTableByOffset );
-					pushData( context.bytecode, &offset, 1 );
-				}
+				continue;
 			}
 
-			++offset;
+			resolves += resolveExpressionEx( expression, o, p );
+			if (m_err)
+			{
+				return;
+			}
+			o = (unsigned int)-1;
+		}
 
-			if ( end == '}' )
+		// right to left operations
+		for( int o = expression.context.count() - 1; o >= 0; --o )
+		{
+			if ( (expression.context[o].type != EXTYPE_OPERATION)
+				 || expression.context[o].operation->precedence > p
+				 || expression.context[o].operation->leftToRight )
 			{
-				break;
+				continue;
 			}
-			else if ( end != ',' )
+
+			resolves += resolveExpressionEx( expression, o, p );
+			if (m_err)
 			{
-				m_err = WR_ERR_unexpected_token;
-				return false;
+				return;
 			}
+			o = expression.context.count();
 		}
 	}
 
-	return true;
+	if ( startedWith && (resolves != startedWith) )
+	{
+		m_err = WR_ERR_bad_expression;
+		return;
+	}
 }
 
 //------------------------------------------------------------------------------
-int WRCompilationContext::parseInitializer( WRExpression& expression, int depth )
+unsigned int WRCompilationContext::resolveExpressionEx( WRExpression& expression, int o, int p )
 {
-	bool inHashTable = false;
-	bool inArray = false;
-	
-	// start a value ... was something declared in front of us?
-	if ( depth == 3
-		 && expression.context[0].type == EXTYPE_LABEL
-		 && expression.context[1].type == EXTYPE_OPERATION
-		 && expression.context[1].operation->opcode
-		 && expression.context[1].operation->opcode == O_Index )
-	{
-		expression.context.remove( depth - 2, 1 );
-		depth -= 1;
-	}
-
-	WRValue& value = expression.context[depth].value;
-	WRstr& token = expression.context[depth].token;
-
-	expression.context[depth].type = EXTYPE_BYTECODE_RESULT;
-
-	pushOpcode( expression.context[depth].bytecode, O_LiteralZero ); // push the value we're going to create
-
-	// knock off the initial create
-	uint16_t initializer = 0;
-	unsigned char idat[2];
-	for(;;)
+	unsigned int ret = 0;
+	switch( expression.context[o].operation->type )
 	{
-		if ( !getToken(expression.context[depth]) )
+		case WR_OPER_PRE:
 		{
-			m_err = WR_ERR_unexpected_EOF;
-			return -1;
-		}
-
-		bool subTableValue = false;
+			ret = 1;
 
-		if ( token == '{' )
-		{
-			subTableValue = true;
-			if ( parseInitializer(expression, depth) == -1 )
+			if ( expression.context[o + 1].stackPosition == -1 )
 			{
-				return -1;
+				loadExpressionContext( expression, o + 1, 0 ); // load argument
+			}
+			else if ( expression.context[o + 1].stackPosition != 0 )
+			{
+				expression.swapWithTop( expression.context[o + 1].stackPosition );
 			}
 
-			pushOpcode( expression.context[depth].bytecode, O_AssignToArrayAndPop );
-			wr_pack16( initializer++, idat );
-			pushData( expression.context[depth].bytecode, idat, 2 );
-
-			continue;
+			appendBytecode( expression.bytecode, expression.context[o].bytecode );  // apply operator
+			expression.context.remove( o, 1 ); // knock off operator
+			expression.pushToStack(o);
+			break;
 		}
-	
-		if ( token == ',' )
+
+		case WR_OPER_BINARY_COMMUTE:
 		{
-			if ( initializer == 0 )
+			// for operations like + and * the operands can be in any
+			// order, so don't go to any great lengths to shift the stack
+			// around for them
+
+			ret = 2;
+
+			if( o == 0 )
 			{
 				m_err = WR_ERR_bad_expression;
-				return -1;
+				return 0;
 			}
-		}
-		else
-		{
-			m_loadedToken = token;
-			m_loadedValue = value;
-			m_loadedQuoted = m_quoted;
-		}
 
-		WRExpression val( expression.bytecode.localSpace, expression.bytecode.isStructSpace );
-		val.context[0].token = token;
-		val.context[0].value = value;
+			int second = o + 1; // push first
+			int first = o - 1;  // push second
+			// so
+			// 1 - first
+			// [oper]
+			// 0 - second
 
-		char end = parseExpression( val );
-		if ( end == ':' )
-		{
-			bool nullKey = false;
-			
-			// we are in a hash table!
-			inHashTable = true;
-			if ( inArray )
+			if ( expression.context[second].stackPosition == -1 )
 			{
-				m_err = WR_ERR_hash_declaration_in_array;
-				return -1;
+				if ( expression.context[first].stackPosition == -1 )
+				{
+					loadExpressionContext( expression, first, o ); 
+				}
+				else if ( expression.context[first].stackPosition != 0 )
+				{
+					// otherwise swap first to the top and load the second
+					expression.swapWithTop( expression.context[first].stackPosition );
+				}
+
+				loadExpressionContext( expression, second, o );
 			}
+			else if ( expression.context[first].stackPosition == -1 )
+			{
+				if ( expression.context[second].stackPosition != 0 )
+				{
+					expression.swapWithTop( expression.context[second].stackPosition );
+				}
 
-			if ( !val.bytecode.all.size() )
+				// just load the second to top
+				loadExpressionContext( expression, first, o );
+			}
+			else if ( expression.context[second].stackPosition == 1 )
 			{
-				nullKey = true;
-				pushOpcode( val.bytecode, O_LiteralZero );
+				expression.swapWithTop( expression.context[first].stackPosition );
 			}
-			
-			if ( subTableValue ) // sub-table keys don't make sense
+			else if ( expression.context[first].stackPosition == 1 )
 			{
-				m_err = WR_ERR_hash_table_invalid_key;
-				return -1;
+				expression.swapWithTop( expression.context[second].stackPosition );
 			}
-
-			appendBytecode( expression.context[depth].bytecode, val.bytecode );
-			
-			if ( !getToken(expression.context[depth]) )
+			else
 			{
-				m_err = WR_ERR_unexpected_EOF;
-				return -1;
+				// first and second are both loaded but neither
+				// is in the correct position
+
+				WRCompilationContext::pushOpcode( expression.bytecode, O_SwapTwoToTop );
+				unsigned char pos = expression.context[first].stackPosition + 1;
+				WRCompilationContext::pushData( expression.bytecode, &pos, 1 );
+				pos = expression.context[second].stackPosition + 1;
+				WRCompilationContext::pushData( expression.bytecode, &pos, 1 );
+
+				expression.swapWithTop( expression.context[second].stackPosition, false );
+				expression.swapWithTop( 1, false );
+				expression.swapWithTop( expression.context[first].stackPosition, false );
 			}
 
-			if ( token == '{' )
-			{
-				if ( parseInitializer(expression, depth) == -1 )
-				{
-					return -1;
-				}
+			appendBytecode( expression.bytecode, expression.context[o].bytecode ); // apply operator
 
-				pushOpcode( expression.context[depth].bytecode, O_AssignToHashTableAndPop );
-				continue;
+			expression.context.remove( o - 1, 2 ); // knock off operator and arg
+			expression.pushToStack(o - 1);
+
+			break;
+		}
+
+		case WR_OPER_BINARY:
+		{
+			ret = 2;
+
+			if( o == 0 )
+			{
+				m_err = WR_ERR_bad_expression;
+				return 0;
 			}
-			else
+
+			int second = o + 1; // push first
+			int first = o - 1;  // push second
+			bool useAlt = false;
+			// so
+			// 1 - first
+			// [oper]
+			// 0 - second
+
+			if ( expression.context[second].stackPosition == -1 )
 			{
-				m_loadedToken = token;
-				m_loadedValue = value;
-				m_loadedQuoted = m_quoted;
-				
-				WRExpression key( expression.bytecode.localSpace, expression.bytecode.isStructSpace );
-				key.context[0].token = token;
-				key.context[0].value = value;
-				end = parseExpression( key );
-				
-				if ( key.bytecode.all.size() ) // nor do null keys
+				if ( expression.context[first].stackPosition == -1 )
 				{
-					if ( nullKey )
-					{
-						m_err = WR_ERR_hash_table_invalid_key;
-						return -1;
-					}
-					
-					appendBytecode( expression.context[depth].bytecode, key.bytecode );
-					pushOpcode( expression.context[depth].bytecode, O_AssignToHashTableAndPop );
+					loadExpressionContext( expression, second, o ); // nope, grab 'em
+					loadExpressionContext( expression, first, o ); 
 				}
 				else
 				{
-					if ( nullKey )
+					// first is in the stack somewhere, we need
+					// to swap it to the top, then load, then
+					// swap top values
+					expression.swapWithTop( expression.context[first].stackPosition );
+
+					loadExpressionContext( expression, second, o );
+
+					if ( expression.context[o].operation->alt == O_LAST )
 					{
-						// null key AND value means null table, just create a zero-size table, by indexing as
-						// hash, which creates the table, then removing the entry we just added, nulling it
-						pushOpcode( expression.context[depth].bytecode, O_LiteralZero );
-						pushOpcode( expression.context[depth].bytecode, O_AssignToHashTableAndPop );
-						pushOpcode( expression.context[depth].bytecode, O_LiteralZero );
-						pushOpcode( expression.context[depth].bytecode, O_Remove );
+						expression.swapWithTop( 1 );
 					}
-					else
+					else // otherwise top shuffle is NOT required because we have an equal-but-opposite operation
 					{
-						pushOpcode( expression.context[depth].bytecode, O_LiteralZero );
-						pushOpcode( expression.context[depth].bytecode, O_AssignToHashTableAndPop );
+						useAlt = true;
 					}
 				}
 			}
-		}
-		else
-		{
-			if ( val.bytecode.all.size() )
+			else if ( expression.context[first].stackPosition == -1 )
 			{
-				inArray = true;
-				if ( inHashTable )
+				// perfect, swap up the second, then load the
+				// first
+
+				expression.swapWithTop( expression.context[second].stackPosition );
+
+				loadExpressionContext( expression, first, o );
+			}
+			else if ( expression.context[second].stackPosition == 1 )
+			{
+				// second is already where its supposed to be,
+				// swap first to top if it's not there already
+				if ( expression.context[first].stackPosition != 0 )
 				{
-					m_err = WR_ERR_array_declaration_in_hash;
-					return -1;
+					expression.swapWithTop( expression.context[first].stackPosition );
 				}
-
-				appendBytecode( expression.context[depth].bytecode, val.bytecode );
-				pushOpcode( expression.context[depth].bytecode, O_AssignToArrayAndPop );
-				wr_pack16( initializer++, idat );
-				pushData( expression.context[depth].bytecode, idat, 2 );
 			}
+			else if ( expression.context[second].stackPosition == 0 )
+			{
+				// second is on top of the stack, swap with
+				// next level down then swap first up
+
+				WRCompilationContext::pushOpcode( expression.bytecode, O_SwapTwoToTop );
+				unsigned char pos = expression.context[first].stackPosition + 1;
+				WRCompilationContext::pushData( expression.bytecode, &pos, 1 );
+				pos = 2;
+				WRCompilationContext::pushData( expression.bytecode, &pos, 1 );
+
+				expression.swapWithTop( 1, false );
+				expression.swapWithTop( expression.context[first].stackPosition, false );
+			}
+			else
+			{
+				// first and second are both loaded but neither is in the correct position
+
+				WRCompilationContext::pushOpcode( expression.bytecode, O_SwapTwoToTop );
+				unsigned char pos = expression.context[first].stackPosition + 1;
+				WRCompilationContext::pushData( expression.bytecode, &pos, 1 );
+				pos = expression.context[second].stackPosition + 1;
+				WRCompilationContext::pushData( expression.bytecode, &pos, 1 );
+
+				expression.swapWithTop( expression.context[second].stackPosition, false );
+				expression.swapWithTop( 1, false );
+				expression.swapWithTop( expression.context[first].stackPosition, false );
+			}
+
+			if ( useAlt )
+			{
+				pushOpcode( expression.bytecode, expression.context[o].operation->alt );
+			}
+			else
+			{
+				appendBytecode( expression.bytecode, expression.context[o].bytecode ); // apply operator
+			}
+
+			expression.context.remove( o - 1, 2 ); // knock off operator and arg
+			expression.pushToStack(o - 1);
+
+			break;
 		}
-		
-		if ( end == '}' )
-		{
-			break;
-		}
-		else if ( end == ',' )
-		{
-			continue;
-		}
-		else
+
+		case WR_OPER_POST:
 		{
-			m_err = WR_ERR_bad_expression;
-			return -1;
+			ret = 1;
+
+			if( o == 0 )
+			{
+				m_err = WR_ERR_bad_expression;
+				return 0;
+			}
+
+			if ( expression.context[o - 1].stackPosition == -1 )
+			{
+				loadExpressionContext( expression, o - 1, o ); // load argument
+			}
+			else if ( expression.context[o - 1].stackPosition != 0 )
+			{
+				expression.swapWithTop( expression.context[o - 1].stackPosition );
+			}
+
+			appendBytecode( expression.bytecode, expression.context[o].bytecode );
+			expression.context.remove( o, 1 ); // knock off operator
+			expression.pushToStack( o - 1 );
+
+			break;
 		}
 	}
-
-	return depth;
+	
+	return ret;
 }
 
-
 //------------------------------------------------------------------------------
-bool WRCompilationContext::parseUnit( bool isStruct, int parentUnitIndex )
+bool WRCompilationContext::operatorFound( WRstr const& token, WRarray<WRExpressionContext>& context, int depth )
 {
-	int previousIndex = m_unitTop;
-	m_unitTop = m_units.count();
-
-	if ( parentUnitIndex && isStruct )
+	for( int i=0; c_operations[i].token; i++ )
 	{
-		m_err = WR_ERR_struct_in_struct;
-		return false;
-	}
-
-	bool isGlobal;
+		if ( token == c_operations[i].token )
+		{
+			if ( c_operations[i].type == WR_OPER_PRE
+				 && depth > 0
+				 && (context[depth-1].type != EXTYPE_OPERATION 
+					 || (context[depth - 1].type == EXTYPE_OPERATION &&
+						 (context[depth - 1].operation->type != WR_OPER_BINARY && context[depth - 1].operation->type != WR_OPER_BINARY_COMMUTE))) )
+			{
+				continue;
+			}
+			
+			context[depth].operation = c_operations + i;
+			context[depth].type = EXTYPE_OPERATION;
 
-	WRExpressionContext ex;
-	WRstr& token = ex.token;
-	WRstr prefix;
-	bool isLibConstant;
+			pushOpcode( context[depth].bytecode, c_operations[i].opcode );
 
-	// get the function name
-	if ( !getToken(ex)
-		 || !isValidLabel(token, isGlobal, prefix, isLibConstant)
-		 || isGlobal
-		 || isLibConstant )
-	{
-		m_err = WR_ERR_bad_label;
-		return false;
+			return true;
+		}
 	}
 
-	m_units[m_unitTop].exportNamespace = m_exportNextUnit;
-	m_exportNextUnit = false;
-	m_units[m_unitTop].name = token;
-	m_units[m_unitTop].hash = wr_hash( token, token.size() );
-	m_units[m_unitTop].bytecode.isStructSpace = isStruct;
+	return false;
+}
 
-	m_units[m_unitTop].parentUnitIndex = parentUnitIndex; // if non-zero, must be called from a new'ed structure!
+//------------------------------------------------------------------------------
+bool WRCompilationContext::parseCallFunction( WRExpression& expression, WRstr functionName, int depth, bool parseArguments )
+{
+	WRstr prefix = expression.context[depth].prefix;
+
+	expression.context[depth].type = EXTYPE_BYTECODE_RESULT;
 	
-	// get the function name
-	if ( getToken(ex, "(") )
+	unsigned char argsPushed = 0;
+
+	if ( parseArguments )
 	{
+		WRstr& token2 = expression.context[depth].token;
+		WRValue& value2 = expression.context[depth].value;
+
 		for(;;)
 		{
-			if ( !getToken(ex) )
+			if ( !getToken(expression.context[depth]) )
 			{
 				m_err = WR_ERR_unexpected_EOF;
-				return false;
+				return 0;
 			}
-			
-			if ( !m_quoted && token == ")" )
+
+			if ( !m_quoted && token2 == ")" )
 			{
 				break;
 			}
-			
-			if ( !isValidLabel(token, isGlobal, prefix, isLibConstant) || isGlobal || isLibConstant )
-			{
-				m_err = WR_ERR_bad_label;
-				return false;
-			}
 
-			++m_units[m_unitTop].arguments;
+			++argsPushed;
 
-			// register the argument on the hash stack
-			addLocalSpaceLoad( m_units[m_unitTop].bytecode,
-							   token,
-							   true,
-							   true );
+			WRExpression nex( expression.bytecode.localSpace, expression.bytecode.isStructSpace );
+			nex.context[0].token = token2;
+			nex.context[0].value = value2;
+			m_loadedToken = token2;
+			m_loadedValue = value2;
+			m_loadedQuoted = m_quoted;
+			
+			char end = parseExpression( nex );
 
-			if ( !getToken(ex) )
+			if ( nex.bytecode.opcodes.size() > 0 )
 			{
-				m_err = WR_ERR_unexpected_EOF;
-				return false;
+				uint8_t op = nex.bytecode.opcodes[nex.bytecode.opcodes.size() - 1];
+				if ( op == O_Index
+					 || op == O_IndexSkipLoad
+					 || op == O_IndexLiteral8
+					 || op == O_IndexLiteral16
+					 || op == O_IndexLocalLiteral8
+					 || op == O_IndexGlobalLiteral8
+					 || op == O_IndexLocalLiteral16
+					 || op == O_IndexGlobalLiteral16 )
+				{
+					nex.bytecode.opcodes += O_Dereference;
+					nex.bytecode.all += O_Dereference;
+				}
 			}
+			
+			appendBytecode( expression.context[depth].bytecode, nex.bytecode );
 
-			if ( !m_quoted && token == ")" )
+			if ( end == ')' )
 			{
 				break;
 			}
-
-			if ( token != "," )
+			else if ( end != ',' )
 			{
 				m_err = WR_ERR_unexpected_token;
-				return false;
+				return 0;
 			}
 		}
-
-		if ( !getToken(ex, "{") )
-		{
-			m_err = WR_ERR_unexpected_token;
-			return false;
-		}
 	}
-	else if ( token != "{" )
-	{
-		m_err = WR_ERR_unexpected_token;
-		return false;
-	}
-		
-	bool returnCalled;
-	parseStatement( m_unitTop, '}', returnCalled, O_Return );
 
-	if ( !returnCalled )
-	{
-		pushDebug( WRD_LineNumber, m_units[m_unitTop].bytecode, getSourcePosition() );
-		pushOpcode( m_units[m_unitTop].bytecode, O_LiteralZero );
-		pushOpcode( m_units[m_unitTop].bytecode, O_Return );
-	}
+	pushDebug( WRD_LineNumber, expression.context[depth].bytecode, getSourcePosition() );
+	pushDebug( WRD_FunctionCall, expression.context[depth].bytecode, WRD_ExternalFunction );
 
-	m_unitTop = previousIndex;
+	if ( prefix.size() )
+	{
+		prefix += "::";
+		prefix += functionName;
 
-	return true;
-}
+		unsigned char buf[4];
+		wr_pack32( wr_hashStr(prefix), buf );
 
-//------------------------------------------------------------------------------
-bool WRCompilationContext::parseWhile( bool& returnCalled, WROpcode opcodeToReturn )
-{
-	WRExpressionContext ex;
-	WRstr& token = ex.token;
-	WRValue& value = ex.value;
+		pushOpcode( expression.context[depth].bytecode, O_CallLibFunction );
+		pushData( expression.context[depth].bytecode, &argsPushed, 1 ); // arg #
+		pushData( expression.context[depth].bytecode, buf, 4 ); // hash id
 
-	if ( !getToken(ex, "(") )
-	{
-		m_err = WR_ERR_unexpected_token;
-		return false;
+		// normal lib will copy down the result, otherwise
+		// ignore it, it will be AFTER args
 	}
-
-	if ( !getToken(ex) )
+	else
 	{
-		m_err = WR_ERR_unexpected_EOF;
-		return false;
-	}
-
-	WRExpression nex( m_units[m_unitTop].bytecode.localSpace, m_units[m_unitTop].bytecode.isStructSpace );
-	nex.context[0].token = token;
-	nex.context[0].value = value;
-	m_loadedToken = token;
-	m_loadedValue = value;
-	m_loadedQuoted = m_quoted;
+		// push the number of args
+		uint32_t hash = wr_hashStr( functionName );
 
-	if ( parseExpression(nex) != ')' )
-	{
-		m_err = WR_ERR_unexpected_token;
-		return false;
-	}
+		unsigned int i=0;
+		for( ; i<expression.context[depth].bytecode.functionSpace.count(); ++i )
+		{
+			if ( expression.context[depth].bytecode.functionSpace[i].hash == hash )
+			{
+				break;
+			}
+		}
 
-	*m_continueTargets.push() = addRelativeJumpTarget( m_units[m_unitTop].bytecode );
-	setRelativeJumpTarget(m_units[m_unitTop].bytecode, *m_continueTargets.tail() );
+		expression.context[depth].bytecode.functionSpace[i].references.append() = getBytecodePosition( expression.context[depth].bytecode );
+		expression.context[depth].bytecode.functionSpace[i].hash = hash;
 
-	appendBytecode( m_units[m_unitTop].bytecode, nex.bytecode );
+		if ( hash == wr_hashStr("yield") )
+		{
+			pushOpcode( expression.context[depth].bytecode, O_Yield );
+			pushData( expression.context[depth].bytecode, &argsPushed, 1 );
+		}
+		else
+		{
+			pushOpcode( expression.context[depth].bytecode, O_FUNCTION_CALL_PLACEHOLDER );
+			pushData( expression.context[depth].bytecode, &argsPushed, 1 );
+			pushData( expression.context[depth].bytecode, "XXXX", 4 ); // TBD opcode plus index, OR hash if index was not found
+		}
+		
+		// hash will copydown result same as lib, unless
+		// copy/pop which case does nothing
 
-	*m_breakTargets.push() = addRelativeJumpTarget( m_units[m_unitTop].bytecode );
+		// normal call does nothing special, to preserve
+		// the return value a call to copy-down must be
+		// inserted
+	}
 
-	addRelativeJumpSource( m_units[m_unitTop].bytecode, O_BZ, *m_breakTargets.tail() );
+	return true;
+}
 
-	if ( !parseStatement(m_unitTop, ';', returnCalled, opcodeToReturn) )
+//------------------------------------------------------------------------------
+int WRCompilationContext::memberOffset( WRUnitContext& unit, uint32_t hash )
+{
+	int i = unit.bytecode.findLocal( hash );
+	if ( i < (int)unit.arguments || i - unit.arguments >= 256 )
 	{
-		return false;
+		return -1;
 	}
-	
-	addRelativeJumpSource( m_units[m_unitTop].bytecode, O_RelativeJump, *m_continueTargets.tail() );
-	setRelativeJumpTarget( m_units[m_unitTop].bytecode, *m_breakTargets.tail() );
 
-	m_continueTargets.pop();
-	m_breakTargets.pop();
-	
-	resolveRelativeJumps( m_units[m_unitTop].bytecode );
-	
-	return true;
+	return i - unit.arguments; // same slot createLocalHashMap() gives it
 }
 
 //------------------------------------------------------------------------------
-bool WRCompilationContext::parseDoWhile( bool& returnCalled, WROpcode opcodeToReturn )
+bool WRCompilationContext::pushObjectTable( WRExpressionContext& context,
+											WRarray<WRNamespaceLookup>& localSpace,
+											uint32_t hash )
 {
-	*m_continueTargets.push() = addRelativeJumpTarget( m_units[m_unitTop].bytecode );
-	*m_breakTargets.push() = addRelativeJumpTarget( m_units[m_unitTop].bytecode );
+	WRstr& token2 = context.token;
+	WRValue& value2 = context.value;
 
-	int jumpToTop = addRelativeJumpTarget( m_units[m_unitTop].bytecode );
-	setRelativeJumpTarget( m_units[m_unitTop].bytecode, jumpToTop );
+	bool byHash = false;
+	bool byOrder = false;
 	
-	if ( !parseStatement(m_unitTop, ';', returnCalled, opcodeToReturn) )
+	unsigned int i=0;
+	for( ; i<context.bytecode.unitObjectSpace.count(); ++i )
 	{
-		return false;
+		if ( context.bytecode.unitObjectSpace[i].hash == hash )
+		{
+			break;
+		}
 	}
 
-	setRelativeJumpTarget(m_units[m_unitTop].bytecode, *m_continueTargets.tail() );
+	pushOpcode( context.bytecode, O_NewObjectTable );
 
-	WRExpressionContext ex;
-	WRstr& token = ex.token;
-	WRValue& value = ex.value;
+	context.bytecode.unitObjectSpace[i].references.append() = getBytecodePosition( context.bytecode );
+	context.bytecode.unitObjectSpace[i].hash = hash;
 
-	if ( !getToken(ex) )
-	{
-		m_err = WR_ERR_unexpected_EOF;
-		return false;
-	}
+	pushData( context.bytecode, "\0\0", 2 );
 
-	if ( token != "while" )
+	context.type = EXTYPE_BYTECODE_RESULT;
+
+	// a struct that is already parsed has a known member order, so
+	// labelled initializers can be assigned by offset instead of hash
+	WRUnitContext* layout = 0;
+	for( unsigned int u=1; u<m_units.count(); ++u )
 	{
-		m_err = WR_ERR_expected_while;
-		return false;
+		if ( m_units[u].hash == hash )
+		{
+			layout = m_units[u].complete ? &m_units[u] : 0;
+			break;
+		}
 	}
 
-	if ( !getToken(ex, "(") )
+	if ( !m_quoted && token2 == "{" )
 	{
-		m_err = WR_ERR_unexpected_token;
-		return false;
-	}
+		unsigned char offset = 0;
+		for(;;)
+		{
+			WRExpression nex( localSpace, context.bytecode.isStructSpace );
+			nex.context[0].token = token2;
+			nex.context[0].value = value2;
 
-	WRExpression nex( m_units[m_unitTop].bytecode.localSpace, m_units[m_unitTop].bytecode.isStructSpace );
-	nex.context[0].token = token;
-	nex.context[0].value = value;
-	//m_loadedToken = token;
-	//m_loadedValue = value;
+			m_parsingNew = true;
 
-	if ( parseExpression(nex) != ')' )
-	{
-		m_err = WR_ERR_unexpected_token;
-		return false;
-	}
+			bool v = m_needVar;
+			m_needVar = false;
+			char end = parseExpression( nex );
+			m_needVar = v;
 
-	if (!getToken(ex, ";"))
-	{
-		m_err = WR_ERR_unexpected_token;
-		return false;
-	}
-	setRelativeJumpTarget(m_units[m_unitTop].bytecode, *m_continueTargets.tail() );
+			m_parsingNew = false;
 
-	appendBytecode( m_units[m_unitTop].bytecode, nex.bytecode );
+			if ( nex.bytecode.all.size() )
+			{
+				appendBytecode( context.bytecode, nex.bytecode );
 
-	addRelativeJumpSource( m_units[m_unitTop].bytecode, O_BZ, *m_breakTargets.tail() );
-	addRelativeJumpSource( m_units[m_unitTop].bytecode, O_RelativeJump, jumpToTop );
-	
-	setRelativeJumpTarget( m_units[m_unitTop].bytecode, *m_breakTargets.tail() );
+				if ( m_newHashValue )
+				{
+					if ( byOrder )
+					{
+						m_err = WR_ERR_new_assign_by_label_or_offset_not_both;
+						return false;
+					}
+					byHash = true;
 
-	m_continueTargets.pop();
-	m_breakTargets.pop();
+					int member = layout ? memberOffset( *layout, m_newHashValue ) : -1;
+					if ( member >= 0 )
+					{
+						unsigned char slot = (unsigned char)member;
+						pushOpcode( context.bytecode, O_AssignToObjectTableByOffset );
+						pushData( context.bytecode, &slot, 1 );
+					}
+					else
+					{
+						pushOpcode( context.bytecode, O_AssignToObjectTableByHash );
+						uint8_t dat[4];
+						pushData( context.bytecode, wr_pack32(m_newHashValue, dat), 4 );
+					}
+				}
+				else
+				{
+					if ( byHash )
+					{
+						m_err = WR_ERR_new_assign_by_label_or_offset_not_both;
+						return false;
+					}
+					byOrder = true;
 
-	resolveRelativeJumps( m_units[m_unitTop].bytecode );
+					pushOpcode( context.bytecode, O_AssignToObjectTableByOffset );
+					pushData( context.bytecode, &offset, 1 );
+				}
+			}
+
+			++offset;
+
+			if ( end == '}' )
+			{
+				break;
+			}
+			else if ( end != ',' )
+			{
+				m_err = WR_ERR_unexpected_token;
+				return false;
+			}
+		}
+	}
 
 	return true;
 }
 
 //------------------------------------------------------------------------------
-bool WRCompilationContext::parseForLoop( bool& returnCalled, WROpcode opcodeToReturn )
+int WRCompilationContext::parseInitializer( WRExpression& expression, int depth )
 {
-	WRExpressionContext ex;
-	WRstr& token = ex.token;
-	WRValue& value = ex.value;
-
-	if ( !getToken(ex, "(") )
+	bool inHashTable = false;
+	bool inArray = false;
+	
+	// start a value ... was something declared in front of us?
+	if ( depth == 3
+		 && expression.context[0].type == EXTYPE_LABEL
+		 && expression.context[1].type == EXTYPE_OPERATION
+		 && expression.context[1].operation->opcode
+		 && expression.context[1].operation->opcode == O_Index )
 	{
-		m_err = WR_ERR_unexpected_token;
-		return false;
+		expression.context.remove( depth - 2, 1 );
+		depth -= 1;
 	}
 
-	// create the continue and break reference points
-	*m_continueTargets.push() = addRelativeJumpTarget( m_units[m_unitTop].bytecode );
-	*m_breakTargets.push() = addRelativeJumpTarget( m_units[m_unitTop].bytecode );
-
-
-/*
-	push iterator
-B:
-	get next or jump A
-	.
-	.
-	.
-	goto B
-A:
-*/					
-
-
-/*
-
-
-[setup]
-<- condition point
-[condition]
--> false jump break
-[code]
-<- continue point
-[post code]
--> always jump condition
-<- break point
-
-*/
+	WRValue& value = expression.context[depth].value;
+	WRstr& token = expression.context[depth].token;
 
-	bool foreachPossible = true;
-	bool foreachKV = false;
-	bool foreachV = false;
-	int foreachLoadI = 0;
-	unsigned char foreachLoad[4];
-	unsigned char g;
+	expression.context[depth].type = EXTYPE_BYTECODE_RESULT;
 
-	m_parsingFor = true;
+	pushOpcode( expression.context[depth].bytecode, O_LiteralZero ); // push the value we're going to create
 
-	// [setup]
+	// knock off the initial create
+	uint16_t initializer = 0;
+	unsigned char idat[2];
 	for(;;)
 	{
-		if ( !getToken(ex) )
+		if ( !getToken(expression.context[depth]) )
 		{
 			m_err = WR_ERR_unexpected_EOF;
-			return false;
+			return -1;
 		}
 
-		if ( !m_quoted && token == ";" )
-		{
-			break;
-		}
+		bool subTableValue = false;
 
-		WRExpression nex( m_units[m_unitTop].bytecode.localSpace, m_units[m_unitTop].bytecode.isStructSpace );
-		nex.context[0].token = token;
-		nex.context[0].value = value;
-		m_loadedToken = token;
-		m_loadedValue = value;
-		m_loadedQuoted = m_quoted;
-
-		char end = parseExpression( nex );
-
-		if ( foreachPossible )
+		if ( token == '{' )
 		{
-			if ( foreachLoadI < 3 )
-			{
-				if (nex.bytecode.opcodes.size() == 1
-					  && nex.bytecode.all.size() == 2
-					  && ((nex.bytecode.all[0] == O_LoadFromLocal) || (nex.bytecode.all[0] == O_LoadFromGlobal)) )
-				{
-					foreachLoad[foreachLoadI++] = nex.bytecode.all[0];
-					foreachLoad[foreachLoadI++] = nex.bytecode.all[1];
-				}
-				else if ( nex.bytecode.opcodes.size() == 2
-						  && nex.bytecode.all.size() == 5
-						  && nex.bytecode.all[0] == O_DebugInfo
-						  && ((nex.bytecode.all[3] == O_LoadFromLocal) || (nex.bytecode.all[3] == O_LoadFromGlobal)) )
-				{
-					foreachLoad[foreachLoadI++] = nex.bytecode.all[3];
-					foreachLoad[foreachLoadI++] = nex.bytecode.all[4];
-				}
-				else
-				{
-					foreachPossible = false;
-				}
-			}
-			else
+			subTableValue = true;
+			if ( parseInitializer(expression, depth) == -1 )
 			{
-				foreachPossible = false;
+				return -1;
 			}
-		}
 
-		pushOpcode( nex.bytecode, O_PopOne );
+			pushOpcode( expression.context[depth].bytecode, O_AssignToArrayAndPop );
+			wr_pack16( initializer++, idat );
+			pushData( expression.context[depth].bytecode, idat, 2 );
 
-		appendBytecode( m_units[m_unitTop].bytecode, nex.bytecode );
-		
-		if ( end == ';' )
-		{
-			foreachPossible = false;
-			break;
+			continue;
 		}
-		else if ( end == ':' )
+	
+		if ( token == ',' )
 		{
-			if ( foreachPossible )
-			{
-				WRExpression nex( m_units[m_unitTop].bytecode.localSpace, m_units[m_unitTop].bytecode.isStructSpace );
-				nex.context[0].token = token;
-				nex.context[0].value = value;
-				end = parseExpression( nex );
-				if ( end == ')'
-					 && nex.bytecode.opcodes.size() == 1
-					 && nex.bytecode.all.size() == 2 )
-				{
-
-					WRstr T;
-					T.format( "foreach:%d", m_foreachHash++ );
-					g = (unsigned char)(addGlobalSpaceLoad(m_units[0].bytecode, T, true, true)); // #25 force "var seen" true since we are runtime adding the temporary ourselves
-
-					if ( nex.bytecode.opcodes[0] == O_LoadFromLocal )
-					{
-						m_units[m_unitTop].bytecode.all += O_LPushIterator;
-					}
-					else
-					{
-						m_units[m_unitTop].bytecode.all += O_GPushIterator;
-					}
-
-					m_units[m_unitTop].bytecode.all += nex.bytecode.all[1];
-					pushData( m_units[m_unitTop].bytecode, &g, 1 );
-
-					if ( foreachLoadI == 4 )
-					{
-						foreachKV = true;
-					}
-					else if ( foreachLoadI == 2 )
-					{
-						foreachV = true;
-					}
-					else
-					{
-						m_err = WR_ERR_unexpected_token;
-						return 0;
-					}
-
-					break;
-				}
-				else
-				{
-					m_err = WR_ERR_unexpected_token;
-					return 0;
-				}
-			}
-			else
+			if ( initializer == 0 )
 			{
-				m_err = WR_ERR_unexpected_token;
-				return 0;
+				m_err = WR_ERR_bad_expression;
+				return -1;
 			}
 		}
-		else if ( end != ',' )
+		else
 		{
-			m_err = WR_ERR_unexpected_token;
-			return 0;
+			m_loadedToken = token;
+			m_loadedValue = value;
+			m_loadedQuoted = m_quoted;
 		}
-	}
 
-	// <- condition point
-	int conditionPoint = addRelativeJumpTarget( m_units[m_unitTop].bytecode );
+		WRExpression val( expression.bytecode.localSpace, expression.bytecode.isStructSpace );
+		val.context[0].token = token;
+		val.context[0].value = value;
 
-	setRelativeJumpTarget( m_units[m_unitTop].bytecode, conditionPoint );
-	
-	if ( foreachV || foreachKV )
-	{
-		if ( foreachV )
+		char end = parseExpression( val );
+		if ( end == ':' )
 		{
-			unsigned char load[2] = { foreachLoad[1], g };
+			bool nullKey = false;
+			
+			// we are in a hash table!
+			inHashTable = true;
+			if ( inArray )
+			{
+				m_err = WR_ERR_hash_declaration_in_array;
+				return -1;
+			}
 
-			if ( foreachLoad[0] == O_LoadFromLocal )
+			if ( !val.bytecode.all.size() )
 			{
-				addRelativeJumpSourceEx( m_units[m_unitTop].bytecode, O_LNextValueOrJump, *m_breakTargets.tail(), load, 2 );
+				nullKey = true;
+				pushOpcode( val.bytecode, O_LiteralZero );
 			}
-			else
+			
+			if ( subTableValue ) // sub-table keys don't make sense
 			{
-				addRelativeJumpSourceEx( m_units[m_unitTop].bytecode, O_GNextValueOrJump, *m_breakTargets.tail(), load, 2 );
+				m_err = WR_ERR_hash_table_invalid_key;
+				return -1;
 			}
-		}
-		else
-		{
-			unsigned char load[3] = { foreachLoad[1], foreachLoad[3], g };
+
+			appendBytecode( expression.context[depth].bytecode, val.bytecode );
 			
-			if ( foreachLoad[0] == O_LoadFromLocal )
+			if ( !getToken(expression.context[depth]) )
 			{
-				if ( foreachLoad[2] == O_LoadFromLocal )
-				{
-					addRelativeJumpSourceEx( m_units[m_unitTop].bytecode, O_LLNextKeyValueOrJump, *m_breakTargets.tail(), load, 3 );
-				}
-				else
+				m_err = WR_ERR_unexpected_EOF;
+				return -1;
+			}
+
+			if ( token == '{' )
+			{
+				if ( parseInitializer(expression, depth) == -1 )
 				{
-					addRelativeJumpSourceEx( m_units[m_unitTop].bytecode, O_LGNextKeyValueOrJump, *m_breakTargets.tail(), load, 3 );
+					return -1;
 				}
+
+				pushOpcode( expression.context[depth].bytecode, O_AssignToHashTableAndPop );
+				continue;
 			}
 			else
 			{
-				if ( foreachLoad[2] == O_LoadFromLocal )
+				m_loadedToken = token;
+				m_loadedValue = value;
+				m_loadedQuoted = m_quoted;
+				
+				WRExpression key( expression.bytecode.localSpace, expression.bytecode.isStructSpace );
+				key.context[0].token = token;
+				key.context[0].value = value;
+				end = parseExpression( key );
+				
+				if ( key.bytecode.all.size() ) // nor do null keys
 				{
-					addRelativeJumpSourceEx( m_units[m_unitTop].bytecode, O_GLNextKeyValueOrJump, *m_breakTargets.tail(), load, 3 );
+					if ( nullKey )
+					{
+						m_err = WR_ERR_hash_table_invalid_key;
+						return -1;
+					}
+					
+					appendBytecode( expression.context[depth].bytecode, key.bytecode );
+					pushOpcode( expression.context[depth].bytecode, O_AssignToHashTableAndPop );
 				}
 				else
 				{
-					addRelativeJumpSourceEx( m_units[m_unitTop].bytecode, O_GGNextKeyValueOrJump, *m_breakTargets.tail(), load, 3 );
+					if ( nullKey )
+					{
+						// null key AND value means null table, just create a zero-size table, by indexing as
+						// hash, which creates the table, then removing the entry we just added, nulling it
+						pushOpcode( expression.context[depth].bytecode, O_LiteralZero );
+						pushOpcode( expression.context[depth].bytecode, O_AssignToHashTableAndPop );
+						pushOpcode( expression.context[depth].bytecode, O_LiteralZero );
+						pushOpcode( expression.context[depth].bytecode, O_Remove );
+					}
+					else
+					{
+						pushOpcode( expression.context[depth].bytecode, O_LiteralZero );
+						pushOpcode( expression.context[depth].bytecode, O_AssignToHashTableAndPop );
+					}
 				}
 			}
 		}
-		
-		m_parsingFor = false;
+		else
+		{
+			if ( val.bytecode.all.size() )
+			{
+				inArray = true;
+				if ( inHashTable )
+				{
+					m_err = WR_ERR_array_declaration_in_hash;
+					return -1;
+				}
 
-		// [ code ]
-		if ( !parseStatement(m_unitTop, ';', returnCalled, opcodeToReturn) )
+				appendBytecode( expression.context[depth].bytecode, val.bytecode );
+				pushOpcode( expression.context[depth].bytecode, O_AssignToArrayAndPop );
+				wr_pack16( initializer++, idat );
+				pushData( expression.context[depth].bytecode, idat, 2 );
+			}
+		}
+		
+		if ( end == '}' )
 		{
-			return false;
+			break;
 		}
-	}
-	else
-	{
-		if ( !getToken(ex) )
+		else if ( end == ',' )
 		{
-			m_err = WR_ERR_unexpected_EOF;
-			return false;
+			continue;
 		}
-
-		// [ condition ]
-		if ( token != ";" )
+		else
 		{
-			WRExpression nex( m_units[m_unitTop].bytecode.localSpace, m_units[m_unitTop].bytecode.isStructSpace );
-			nex.context[0].token = token;
-			nex.context[0].value = value;
-			m_loadedToken = token;
-			m_loadedValue = value;
-			m_loadedQuoted = m_quoted;
+			m_err = WR_ERR_bad_expression;
+			return -1;
+		}
+	}
 
-			if ( parseExpression( nex ) != ';' )
-			{
-				m_err = WR_ERR_unexpected_token;
-				return false;
-			}
+	return depth;
+}
 
-			appendBytecode( m_units[m_unitTop].bytecode, nex.bytecode );
 
-			// -> false jump break
-			addRelativeJumpSource( m_units[m_unitTop].bytecode, O_BZ, *m_breakTargets.tail() );
-		}
+//------------------------------------------------------------------------------
+bool WRCompilationContext::parseUnit( bool isStruct, int parentUnitIndex )
+{
+	int previousIndex = m_unitTop;
+	m_unitTop = m_units.count();
+
+	if ( parentUnitIndex && isStruct )
+	{
+		m_err = WR_ERR_struct_in_struct;
+		return false;
+	}
 
+	bool isGlobal;
 
-		WRExpression post( m_units[m_unitTop].bytecode.localSpace, m_units[m_unitTop].bytecode.isStructSpace );
+	WRExpressionContext ex;
+	WRstr& token = ex.token;
+	WRstr prefix;
+	bool isLibConstant;
 
-		// [ post code ]
+	// get the function name
+	if ( !getToken(ex)
+		 || !isValidLabel(token, isGlobal, prefix, isLibConstant)
+		 || isGlobal
+		 || isLibConstant )
+	{
+		m_err = WR_ERR_bad_label;
+		return false;
+	}
+
+	m_units[m_unitTop].exportNamespace = m_exportNextUnit;
+	m_exportNextUnit = false;
+	m_units[m_unitTop].name = token;
+	m_units[m_unitTop].hash = wr_hash( token, token.size() );
+	m_units[m_unitTop].bytecode.isStructSpace = isStruct;
+
+	m_units[m_unitTop].parentUnitIndex = parentUnitIndex; // if non-zero, must be called from a new'ed structure!
+	
+	// get the function name
+	if ( getToken(ex, "(") )
+	{
 		for(;;)
 		{
 			if ( !getToken(ex) )
@@ -6077,267 +6695,203 @@ A:
 				m_err = WR_ERR_unexpected_EOF;
 				return false;
 			}
-
+			
 			if ( !m_quoted && token == ")" )
 			{
 				break;
 			}
+			
+			if ( !isValidLabel(token, isGlobal, prefix, isLibConstant) || isGlobal || isLibConstant )
+			{
+				m_err = WR_ERR_bad_label;
+				return false;
+			}
 
-			WRExpression nex( m_units[m_unitTop].bytecode.localSpace, m_units[m_unitTop].bytecode.isStructSpace );
-			nex.context[0].token = token;
-			nex.context[0].value = value;
-			m_loadedToken = token;
-			m_loadedValue = value;
-			m_loadedQuoted = m_quoted;
+			++m_units[m_unitTop].arguments;
 
-			char end = parseExpression( nex );
-			pushOpcode( nex.bytecode, O_PopOne );
+			// register the argument on the hash stack
+			addLocalSpaceLoad( m_units[m_unitTop].bytecode,
+							   token,
+							   true,
+							   true );
 
-			appendBytecode( post.bytecode, nex.bytecode );
+			if ( !getToken(ex) )
+			{
+				m_err = WR_ERR_unexpected_EOF;
+				return false;
+			}
 
-			if ( end == ')' )
+			if ( !m_quoted && token == ")" )
 			{
 				break;
 			}
-			else if ( end != ',' )
+
+			if ( token != "," )
 			{
 				m_err = WR_ERR_unexpected_token;
-				return 0;
+				return false;
 			}
 		}
 
-		m_parsingFor = false;
-
-		// [ code ]
-		if ( !parseStatement(m_unitTop, ';', returnCalled, opcodeToReturn) )
+		if ( !getToken(ex, "{") )
 		{
+			m_err = WR_ERR_unexpected_token;
 			return false;
 		}
-
-		// <- continue point
-		setRelativeJumpTarget( m_units[m_unitTop].bytecode, *m_continueTargets.tail() );
-
-		// [post code]
-		appendBytecode( m_units[m_unitTop].bytecode, post.bytecode );
 	}
-
-	addRelativeJumpSource( m_units[m_unitTop].bytecode, O_RelativeJump, conditionPoint );
-	setRelativeJumpTarget( m_units[m_unitTop].bytecode, *m_breakTargets.tail() );
-
-	m_continueTargets.pop();
-	m_breakTargets.pop();
-
-	resolveRelativeJumps( m_units[m_unitTop].bytecode );
-
-	return true;
-}
-
-//------------------------------------------------------------------------------
-bool WRCompilationContext::lookupConstantValue( WRstr& prefix, WRValue* value )
-{
-	for( unsigned int v=0; v<m_units[m_unitTop].constantValues.count(); ++v )
+	else if ( token != "{" )
 	{
-		if ( m_units[m_unitTop].constantValues[v].label == prefix )
-		{
-			if ( value )
-			{
-				*value = m_units[m_unitTop].constantValues[v].value;
-			}
-			return true;
-		}
+		m_err = WR_ERR_unexpected_token;
+		return false;
 	}
+		
+	bool returnCalled;
+	parseStatement( m_unitTop, '}', returnCalled, O_Return );
 
-	for( unsigned int v=0; v<m_units[0].constantValues.count(); ++v )
+	if ( !returnCalled )
 	{
-		if ( m_units[0].constantValues[v].label == prefix )
-		{
-			if ( value )
-			{
-				*value = m_units[0].constantValues[v].value;
-			}
-			return true;
-		}
+		pushDebug( WRD_LineNumber, m_units[m_unitTop].bytecode, getSourcePosition() );
+		pushOpcode( m_units[m_unitTop].bytecode, O_LiteralZero );
+		pushOpcode( m_units[m_unitTop].bytecode, O_Return );
 	}
 
-	return false;
+	m_units[m_unitTop].complete = true;
+	m_unitTop = previousIndex;
+
+	return true;
 }
 
 //------------------------------------------------------------------------------
-bool WRCompilationContext::parseEnum( int unitIndex )
+bool WRCompilationContext::parseWhile( bool& returnCalled, WROpcode opcodeToReturn )
 {
 	WRExpressionContext ex;
 	WRstr& token = ex.token;
 	WRValue& value = ex.value;
 
-	if ( !getToken(ex, "{") )
+	if ( !getToken(ex, "(") )
 	{
 		m_err = WR_ERR_unexpected_token;
 		return false;
 	}
 
-	unsigned int index = 0;
-
-	for(;;)
+	if ( !getToken(ex) )
 	{
-		if ( !getToken(ex) )
-		{
-			m_err = WR_ERR_unexpected_token;
-			return false;
-		}
-
-		if ( !m_quoted && token == "}" )
-		{
-			break;
-		}
-		else if ( !m_quoted && token == "," )
-		{
-			continue;
-		}
-
-		bool isGlobal;
-		WRstr prefix;
-		bool isLibConstant;
-		if ( !isValidLabel(token, isGlobal, prefix, isLibConstant) || isGlobal || isLibConstant )
-		{
-			m_err = WR_ERR_bad_label;
-			return false;
-		}
-
-		prefix = token;
-		
-		WRValue defaultValue;
-		defaultValue.init();
-		defaultValue.ui = index++;
+		m_err = WR_ERR_unexpected_EOF;
+		return false;
+	}
 
-		if ( !getToken(ex) )
-		{
-			m_err = WR_ERR_unexpected_EOF;
-			return false;
-		}
+	WRExpression nex( m_units[m_unitTop].bytecode.localSpace, m_units[m_unitTop].bytecode.isStructSpace );
+	nex.context[0].token = token;
+	nex.context[0].value = value;
+	m_loadedToken = token;
+	m_loadedValue = value;
+	m_loadedQuoted = m_quoted;
 
-		if ( !m_quoted && token == "=" )
-		{
-			if ( !getToken(ex) )
-			{
-				m_err = WR_ERR_bad_label;
-				return false;
-			}
+	if ( parseExpression(nex) != ')' )
+	{
+		m_err = WR_ERR_unexpected_token;
+		return false;
+	}
 
-			if ( value.type == WR_REF )
-			{
-				m_err = WR_ERR_bad_label;
-				return false;
-			}
-		}
-		else
-		{
-			m_loadedToken = token;
-			m_loadedValue = value;
-			m_loadedQuoted = m_quoted;
+	*m_continueTargets.push() = addRelativeJumpTarget( m_units[m_unitTop].bytecode );
+	setRelativeJumpTarget(m_units[m_unitTop].bytecode, *m_continueTargets.tail() );
 
-			value = defaultValue;
-		}
+	appendBytecode( m_units[m_unitTop].bytecode, nex.bytecode );
 
-		if ( value.type == WR_INT )
-		{
-			index = value.ui + 1;
-		}
-		else if ( value.type != WR_FLOAT )
-		{
-			m_err = WR_ERR_bad_label;
-			return false;
-		}
-		
-		if ( lookupConstantValue(prefix) )
-		{
-			m_err = WR_ERR_constant_redefined;
-			return false;
-		}
+	*m_breakTargets.push() = addRelativeJumpTarget( m_units[m_unitTop].bytecode );
 
-		ConstantValue& newVal = m_units[m_unitTop].constantValues.append();
-		newVal.label = prefix;
-		newVal.value = value;
-	}
+	addRelativeJumpSource( m_units[m_unitTop].bytecode, O_BZ, *m_breakTargets.tail() );
 
-	if ( getToken(ex) && token != ";" )
+	if ( !parseStatement(m_unitTop, ';', returnCalled, opcodeToReturn) )
 	{
-		m_loadedToken = token;
-		m_loadedValue = value;
-		m_loadedQuoted = m_quoted;
+		return false;
 	}
+	
+	addRelativeJumpSource( m_units[m_unitTop].bytecode, O_RelativeJump, *m_continueTargets.tail() );
+	setRelativeJumpTarget( m_units[m_unitTop].bytecode, *m_breakTargets.tail() );
 
+	m_continueTargets.pop();
+	m_breakTargets.pop();
+	
+	resolveRelativeJumps( m_units[m_unitTop].bytecode );
+	
 	return true;
 }
 
 //------------------------------------------------------------------------------
-uint32_t WRCompilationContext::getSingleValueHash( const char* end )
+bool WRCompilationContext::parseDoWhile( bool& returnCalled, WROpcode opcodeToReturn )
 {
-	WRExpressionContext ex;
+	*m_continueTargets.push() = addRelativeJumpTarget( m_units[m_unitTop].bytecode );
+	*m_breakTargets.push() = addRelativeJumpTarget( m_units[m_unitTop].bytecode );
+
+	int jumpToTop = addRelativeJumpTarget( m_units[m_unitTop].bytecode );
+	setRelativeJumpTarget( m_units[m_unitTop].bytecode, jumpToTop );
+	
+	if ( !parseStatement(m_unitTop, ';', returnCalled, opcodeToReturn) )
+	{
+		return false;
+	}
+
+	setRelativeJumpTarget(m_units[m_unitTop].bytecode, *m_continueTargets.tail() );
+
+	WRExpressionContext ex;
 	WRstr& token = ex.token;
 	WRValue& value = ex.value;
-	getToken( ex );
-	
-	if ( !m_quoted && token == "(" )
+
+	if ( !getToken(ex) )
 	{
-		return getSingleValueHash( ")" );
+		m_err = WR_ERR_unexpected_EOF;
+		return false;
 	}
 
-	if ( value.type == WR_REF )
+	if ( token != "while" )
 	{
-		m_err = WR_ERR_switch_bad_case_hash;
-		return 0;
+		m_err = WR_ERR_expected_while;
+		return false;
 	}
-	
-	uint32_t hash = ((uint8_t)value.type == WR_COMPILER_LITERAL_STRING) ? wr_hashStr(token) : value.getHash();
 
-	if ( !getToken(ex, end) )
+	if ( !getToken(ex, "(") )
 	{
 		m_err = WR_ERR_unexpected_token;
-		return 0;
+		return false;
 	}
 
-	return hash;
-}
+	WRExpression nex( m_units[m_unitTop].bytecode.localSpace, m_units[m_unitTop].bytecode.isStructSpace );
+	nex.context[0].token = token;
+	nex.context[0].value = value;
+	//m_loadedToken = token;
+	//m_loadedValue = value;
 
-/*
+	if ( parseExpression(nex) != ')' )
+	{
+		m_err = WR_ERR_unexpected_token;
+		return false;
+	}
 
+	if (!getToken(ex, ";"))
+	{
+		m_err = WR_ERR_unexpected_token;
+		return false;
+	}
+	setRelativeJumpTarget(m_units[m_unitTop].bytecode, *m_continueTargets.tail() );
 
-    continue target:
-    targetswitchLinear
-    8-bit max
-pc> 16-bit default location
-    16 bit case offset
-    16 bit case offset
-    16 bit case offset
-    cases...
-    [cases]
-    break target:
+	appendBytecode( m_units[m_unitTop].bytecode, nex.bytecode );
 
+	addRelativeJumpSource( m_units[m_unitTop].bytecode, O_BZ, *m_breakTargets.tail() );
+	addRelativeJumpSource( m_units[m_unitTop].bytecode, O_RelativeJump, jumpToTop );
+	
+	setRelativeJumpTarget( m_units[m_unitTop].bytecode, *m_breakTargets.tail() );
 
-continue target:
-switch ins
-16-bit mod
-16-bit default location
-32 hash case mod 0 : 16 bit case offset
-32 hash case mod 1 : 16 bit case offset
-32 hash case mod 2 : 16 bit case offset
-...
-[cases]
-break target:
+	m_continueTargets.pop();
+	m_breakTargets.pop();
 
-*/
+	resolveRelativeJumps( m_units[m_unitTop].bytecode );
 
-//------------------------------------------------------------------------------
-struct WRSwitchCase
-{
-	uint32_t hash; // hash to get this case
-	bool occupied; // null hash is legal and common, must mark occupation of a node with extra flag
-	bool defaultCase;
-	int16_t jumpOffset; // where to go to get to this case
-};
+	return true;
+}
 
 //------------------------------------------------------------------------------
-bool WRCompilationContext::parseSwitch( bool& returnCalled, WROpcode opcodeToReturn )
+bool WRCompilationContext::parseForLoop( bool& returnCalled, WROpcode opcodeToReturn )
 {
 	WRExpressionContext ex;
 	WRstr& token = ex.token;
@@ -6348,39 +6902,49 @@ bool WRCompilationContext::parseSwitch( bool& returnCalled, WROpcode opcodeToRet
 		m_err = WR_ERR_unexpected_token;
 		return false;
 	}
-	
-	WRExpression selectionCriteria( m_units[m_unitTop].bytecode.localSpace, m_units[m_unitTop].bytecode.isStructSpace );
-	selectionCriteria.context[0].token = token;
-	selectionCriteria.context[0].value = value;
-	
-	if ( parseExpression(selectionCriteria) != ')' )
-	{
-		m_err = WR_ERR_unexpected_token;
-		return false;
-	}
 
-	appendBytecode( m_units[m_unitTop].bytecode, selectionCriteria.bytecode );
+	// create the continue and break reference points
+	*m_continueTargets.push() = addRelativeJumpTarget( m_units[m_unitTop].bytecode );
+	*m_breakTargets.push() = addRelativeJumpTarget( m_units[m_unitTop].bytecode );
 
 
-	if ( !getToken(ex, "{") )
-	{
-		m_err = WR_ERR_unexpected_token;
-		return false;
-	}
+/*
+	push iterator
+B:
+	get next or jump A
+	.
+	.
+	.
+	goto B
+A:
+*/					
 
-	WRarray<WRSwitchCase> cases;
-	int16_t defaultOffset = -1;
-	WRSwitchCase* swCase = 0; // current case
 
-	int defaultCaseJumpTarget = addRelativeJumpTarget( m_units[m_unitTop].bytecode );
+/*
 
-	*m_breakTargets.push() = addRelativeJumpTarget( m_units[m_unitTop].bytecode );
 
-	int selectionLogicPoint = addRelativeJumpTarget( m_units[m_unitTop].bytecode );
-	addRelativeJumpSource( m_units[m_unitTop].bytecode, O_RelativeJump, selectionLogicPoint );
+[setup]
+<- condition point
+[condition]
+-> false jump break
+[code]
+<- continue point
+[post code]
+-> always jump condition
+<- break point
 
-	unsigned int startingBytecodeMarker = m_units[m_unitTop].bytecode.all.size();
-	
+*/
+
+	bool foreachPossible = true;
+	bool foreachKV = false;
+	bool foreachV = false;
+	int foreachLoadI = 0;
+	unsigned char foreachLoad[4];
+	unsigned char g;
+
+	m_parsingFor = true;
+
+	// [setup]
 	for(;;)
 	{
 		if ( !getToken(ex) )
@@ -6389,4192 +6953,9027 @@ bool WRCompilationContext::parseSwitch( bool& returnCalled, WROpcode opcodeToRet
 			return false;
 		}
 
-		if( !m_quoted && token == "}" )
+		if ( !m_quoted && token == ";" )
 		{
 			break;
 		}
 
-		if ( !m_quoted && token == "case" )
-		{
-			swCase = &cases.append();
-			swCase->jumpOffset = m_units[m_unitTop].bytecode.all.size();
-			swCase->hash = getSingleValueHash(":");
-			if ( m_err )
-			{
-				return false;
-			}
+		WRExpression nex( m_units[m_unitTop].bytecode.localSpace, m_units[m_unitTop].bytecode.isStructSpace );
+		nex.context[0].token = token;
+		nex.context[0].value = value;
+		m_loadedToken = token;
+		m_loadedValue = value;
+		m_loadedQuoted = m_quoted;
 
-			swCase->occupied = true;
-			swCase->defaultCase = false;
+		char end = parseExpression( nex );
 
-			if ( cases.count() > 1 )
+		if ( foreachPossible )
+		{
+			if ( foreachLoadI < 3 )
 			{
-				for( unsigned int h = 0; h < cases.count() - 1 ; ++h )
+				if (nex.bytecode.opcodes.size() == 1
+					  && nex.bytecode.all.size() == 2
+					  && ((nex.bytecode.all[0] == O_LoadFromLocal) || (nex.bytecode.all[0] == O_LoadFromGlobal)) )
 				{
-					if ( cases[h].occupied && !cases[h].defaultCase && (swCase->hash == cases[h].hash) )
-					{
-						m_err = WR_ERR_switch_duplicate_case;
-						return false;
-					}
+					foreachLoad[foreachLoadI++] = nex.bytecode.all[0];
+					foreachLoad[foreachLoadI++] = nex.bytecode.all[1];
+				}
+				else if ( nex.bytecode.opcodes.size() == 2
+						  && nex.bytecode.all.size() == 5
+						  && nex.bytecode.all[0] == O_DebugInfo
+						  && ((nex.bytecode.all[3] == O_LoadFromLocal) || (nex.bytecode.all[3] == O_LoadFromGlobal)) )
+				{
+					foreachLoad[foreachLoadI++] = nex.bytecode.all[3];
+					foreachLoad[foreachLoadI++] = nex.bytecode.all[4];
+				}
+				else
+				{
+					foreachPossible = false;
 				}
 			}
-		}
-		else if ( !m_quoted && token == "default" )
-		{
-			if ( defaultOffset != -1 )
+			else
 			{
-				m_err = WR_ERR_switch_duplicate_case;
-				return false;
+				foreachPossible = false;
 			}
+		}
 
-			if ( !getToken(ex, ":") )
-			{
-				m_err = WR_ERR_unexpected_token;
-				return false;
-			}
+		pushOpcode( nex.bytecode, O_PopOne );
 
-			defaultOffset = m_units[m_unitTop].bytecode.all.size();
-			setRelativeJumpTarget( m_units[m_unitTop].bytecode, defaultCaseJumpTarget );
+		appendBytecode( m_units[m_unitTop].bytecode, nex.bytecode );
+		
+		if ( end == ';' )
+		{
+			foreachPossible = false;
+			break;
 		}
-		else
+		else if ( end == ':' )
 		{
-			if ( swCase == 0 && defaultOffset == -1 )
+			if ( foreachPossible )
 			{
-				m_err = WR_ERR_switch_case_or_default_expected;
-				return false;
-			}
-
-			m_loadedToken = token;
-			m_loadedValue = value;
-			m_loadedQuoted = m_quoted;
+				WRExpression nex( m_units[m_unitTop].bytecode.localSpace, m_units[m_unitTop].bytecode.isStructSpace );
+				nex.context[0].token = token;
+				nex.context[0].value = value;
+				end = parseExpression( nex );
+				if ( end == ')'
+					 && nex.bytecode.opcodes.size() == 1
+					 && nex.bytecode.all.size() == 2 )
+				{
 
-			if ( !parseStatement(m_unitTop, ';', returnCalled, opcodeToReturn) )
-			{
-				return false;
-			}
-		}
-	}
+					WRstr T;
+					T.format( "foreach:%d", m_foreachHash++ );
+					g = (unsigned char)(addGlobalSpaceLoad(m_units[0].bytecode, T, true, true)); // #25 force "var seen" true since we are runtime adding the temporary ourselves
 
-	if ( startingBytecodeMarker == m_units[m_unitTop].bytecode.all.size() )
-	{
-		// no code was added so this is one big null operation, go
-		// ahead and null it
-		m_units[m_unitTop].bytecode.all.shave(3);
-		m_units[m_unitTop].bytecode.opcodes.clear();
-			
-		pushOpcode(m_units[m_unitTop].bytecode, O_PopOne); // pop off the selection criteria
-
-		m_units[m_unitTop].bytecode.jumpOffsetTargets.pop();
-		m_breakTargets.pop();
-		return true;
-	}
-	
-	// make sure the last instruction is a break (jump) so the
-	// selection logic is skipped at the end of the last case/default
-	if ( !m_units[m_unitTop].bytecode.opcodes.size() 
-		 || (m_units[m_unitTop].bytecode.opcodes.size() && m_units[m_unitTop].bytecode.opcodes[m_units[m_unitTop].bytecode.opcodes.size() - 1] != O_RelativeJump) )
-	{
-		addRelativeJumpSource( m_units[m_unitTop].bytecode, O_RelativeJump, *m_breakTargets.tail() );
-	}
+					if ( nex.bytecode.opcodes[0] == O_LoadFromLocal )
+					{
+						m_units[m_unitTop].bytecode.all += O_LPushIterator;
+					}
+					else
+					{
+						m_units[m_unitTop].bytecode.all += O_GPushIterator;
+					}
 
-	// selection logic jumps HERE
-	setRelativeJumpTarget( m_units[m_unitTop].bytecode, selectionLogicPoint );
+					m_units[m_unitTop].bytecode.all += nex.bytecode.all[1];
+					pushData( m_units[m_unitTop].bytecode, &g, 1 );
 
-	// find the highest hash value, and size an array to that
-	unsigned int size = 0;
-	for( unsigned int d=0; d<cases.count(); ++d )
-	{
-		if ( cases[d].defaultCase )
-		{
-			continue;
-		}
+					if ( foreachLoadI == 4 )
+					{
+						foreachKV = true;
+					}
+					else if ( foreachLoadI == 2 )
+					{
+						foreachV = true;
+					}
+					else
+					{
+						m_err = WR_ERR_unexpected_token;
+						return 0;
+					}
 
-		if ( cases[d].hash > size )
-		{
-			size = cases[d].hash;
+					break;
+				}
+				else
+				{
+					m_err = WR_ERR_unexpected_token;
+					return 0;
+				}
+			}
+			else
+			{
+				m_err = WR_ERR_unexpected_token;
+				return 0;
+			}
 		}
-
-		if ( size >= 254 )
+		else if ( end != ',' )
 		{
-			break;
+			m_err = WR_ERR_unexpected_token;
+			return 0;
 		}
 	}
 
-	// first try the easy way
-
-	++size;
-
-	WRSwitchCase* table = 0;
-	unsigned char packbuf[4];
+	// <- condition point
+	int conditionPoint = addRelativeJumpTarget( m_units[m_unitTop].bytecode );
 
-	if ( size < 254 ) // cases are labeled 0-254, just use a linear jump table
+	setRelativeJumpTarget( m_units[m_unitTop].bytecode, conditionPoint );
+	
+	if ( foreachV || foreachKV )
 	{
-		pushOpcode( m_units[m_unitTop].bytecode, O_SwitchLinear );
-
-		packbuf[0] = size;
-		pushData( m_units[m_unitTop].bytecode, packbuf, 1 ); // size
-
-		int currentPos = m_units[m_unitTop].bytecode.all.size();
-
-		if ( defaultOffset == -1 )
-		{
-			defaultOffset = size*2 + 2;
-		}
-		else
-		{
-			defaultOffset -= currentPos;
-		}
-
-		table = (WRSwitchCase *)g_malloc(size * sizeof(WRSwitchCase));
-		memset( table, 0, size*sizeof(WRSwitchCase) );
-
-		for( unsigned int i = 0; i<size; ++i ) // for each of the possible entries..
+		if ( foreachV )
 		{
-			for( unsigned int hash = 0; hash<cases.count(); ++hash ) // if a hash matches it, populate that table entry
-			{
-				if ( cases[hash].occupied && !cases[hash].defaultCase && (cases[hash].hash == i) )
-				{
-					table[cases[hash].hash].jumpOffset = cases[hash].jumpOffset - currentPos;
-					table[cases[hash].hash].occupied = true;
-					break;
-				}
-			}
-		}
-
-		pushData( m_units[m_unitTop].bytecode, wr_pack16(defaultOffset, packbuf), 2 );
+			unsigned char load[2] = { foreachLoad[1], g };
 
-		for( unsigned int i=0; i<size; ++i )
-		{
-			if ( table[i].occupied )
+			if ( foreachLoad[0] == O_LoadFromLocal )
 			{
-				pushData( m_units[m_unitTop].bytecode, wr_pack16(table[i].jumpOffset, packbuf), 2 );
+				addRelativeJumpSourceEx( m_units[m_unitTop].bytecode, O_LNextValueOrJump, *m_breakTargets.tail(), load, 2 );
 			}
 			else
 			{
-				pushData( m_units[m_unitTop].bytecode, wr_pack16(defaultOffset, packbuf), 2 );
+				addRelativeJumpSourceEx( m_units[m_unitTop].bytecode, O_GNextValueOrJump, *m_breakTargets.tail(), load, 2 );
 			}
 		}
-	}
-	else
-	{
-		pushOpcode( m_units[m_unitTop].bytecode, O_Switch ); // add switch command
-		unsigned char packbuf[4];
-
-		int currentPos = m_units[m_unitTop].bytecode.all.size();
-
-		// find a suitable mod
-		uint16_t mod = 1;
-		for( ; mod<0x7FFE; ++mod )
+		else
 		{
-			table = (WRSwitchCase *)g_malloc(mod * sizeof(WRSwitchCase));
-			memset( table, 0, sizeof(WRSwitchCase)*mod );
-
-			unsigned int c=0;
-			for( ; c<cases.count(); ++c )
+			unsigned char load[3] = { foreachLoad[1], foreachLoad[3], g };
+			
+			if ( foreachLoad[0] == O_LoadFromLocal )
 			{
-				if ( cases[c].defaultCase )
+				if ( foreachLoad[2] == O_LoadFromLocal )
 				{
-					continue;
+					addRelativeJumpSourceEx( m_units[m_unitTop].bytecode, O_LLNextKeyValueOrJump, *m_breakTargets.tail(), load, 3 );
 				}
-
-				if ( table[cases[c].hash % mod].occupied )
+				else
 				{
-					break;
+					addRelativeJumpSourceEx( m_units[m_unitTop].bytecode, O_LGNextKeyValueOrJump, *m_breakTargets.tail(), load, 3 );
 				}
-
-				table[cases[c].hash % mod].hash = cases[c].hash;
-				table[cases[c].hash % mod].jumpOffset = cases[c].jumpOffset - currentPos;
-				table[cases[c].hash % mod].occupied = true;
-			}
-
-			if ( c >= cases.count() )
-			{
-				break;
 			}
 			else
 			{
-				g_free( table );
-				table = 0;
-			} 
+				if ( foreachLoad[2] == O_LoadFromLocal )
+				{
+					addRelativeJumpSourceEx( m_units[m_unitTop].bytecode, O_GLNextKeyValueOrJump, *m_breakTargets.tail(), load, 3 );
+				}
+				else
+				{
+					addRelativeJumpSourceEx( m_units[m_unitTop].bytecode, O_GGNextKeyValueOrJump, *m_breakTargets.tail(), load, 3 );
+				}
+			}
 		}
+		
+		m_parsingFor = false;
 
-		if ( mod >= 0x7FFE )
+		// [ code ]
+		if ( !parseStatement(m_unitTop, ';', returnCalled, opcodeToReturn) )
 		{
-			m_err = WR_ERR_switch_construction_error;
 			return false;
 		}
-
-		if ( defaultOffset == -1 )
+	}
+	else
+	{
+		if ( !getToken(ex) )
 		{
-			defaultOffset = mod*6 + 4;
+			m_err = WR_ERR_unexpected_EOF;
+			return false;
 		}
-		else
+
+		// [ condition ]
+		if ( token != ";" )
 		{
-			defaultOffset -= currentPos;
+			WRExpression nex( m_units[m_unitTop].bytecode.localSpace, m_units[m_unitTop].bytecode.isStructSpace );
+			nex.context[0].token = token;
+			nex.context[0].value = value;
+			m_loadedToken = token;
+			m_loadedValue = value;
+			m_loadedQuoted = m_quoted;
+
+			if ( parseExpression( nex ) != ';' )
+			{
+				m_err = WR_ERR_unexpected_token;
+				return false;
+			}
+
+			appendBytecode( m_units[m_unitTop].bytecode, nex.bytecode );
+
+			// -> false jump break
+			addRelativeJumpSource( m_units[m_unitTop].bytecode, O_BZ, *m_breakTargets.tail() );
 		}
 
-		pushData( m_units[m_unitTop].bytecode, wr_pack16(mod, packbuf), 2 ); // mod value
-		pushData( m_units[m_unitTop].bytecode, wr_pack16(defaultOffset, packbuf), 2 ); // default offset
 
-		for( uint16_t m = 0; m<mod; ++m )
-		{
-			pushData( m_units[m_unitTop].bytecode, wr_pack32(table[m].hash, packbuf), 4 );
+		WRExpression post( m_units[m_unitTop].bytecode.localSpace, m_units[m_unitTop].bytecode.isStructSpace );
 
-			if ( !table[m].occupied )
+		// [ post code ]
+		for(;;)
+		{
+			if ( !getToken(ex) )
 			{
-				pushData( m_units[m_unitTop].bytecode, wr_pack16(defaultOffset, packbuf), 2 );
+				m_err = WR_ERR_unexpected_EOF;
+				return false;
 			}
-			else
+
+			if ( !m_quoted && token == ")" )
 			{
-				pushData( m_units[m_unitTop].bytecode, wr_pack16(table[m].jumpOffset, packbuf), 2 );
+				break;
 			}
-		}
-	}
 
-	g_free( table );
+			WRExpression nex( m_units[m_unitTop].bytecode.localSpace, m_units[m_unitTop].bytecode.isStructSpace );
+			nex.context[0].token = token;
+			nex.context[0].value = value;
+			m_loadedToken = token;
+			m_loadedValue = value;
+			m_loadedQuoted = m_quoted;
 
-	setRelativeJumpTarget( m_units[m_unitTop].bytecode, *m_breakTargets.tail() );
+			char end = parseExpression( nex );
+			pushOpcode( nex.bytecode, O_PopOne );
 
-	resolveRelativeJumps( m_units[m_unitTop].bytecode );
+			appendBytecode( post.bytecode, nex.bytecode );
 
-	m_breakTargets.pop();
+			if ( end == ')' )
+			{
+				break;
+			}
+			else if ( end != ',' )
+			{
+				m_err = WR_ERR_unexpected_token;
+				return 0;
+			}
+		}
 
-	return true;
-}
+		m_parsingFor = false;
 
-//------------------------------------------------------------------------------
-bool WRCompilationContext::parseIf( bool& returnCalled, WROpcode opcodeToReturn )
-{
-	WRExpressionContext ex;
-	WRstr& token = ex.token;
-	WRValue& value = ex.value;
+		// [ code ]
+		if ( !parseStatement(m_unitTop, ';', returnCalled, opcodeToReturn) )
+		{
+			return false;
+		}
 
-	if ( !getToken(ex, "(") )
-	{
-		m_err = WR_ERR_unexpected_token;
-		return false;
-	}
+		// <- continue point
+		setRelativeJumpTarget( m_units[m_unitTop].bytecode, *m_continueTargets.tail() );
 
-	if ( !getToken(ex) )
-	{
-		m_err = WR_ERR_unexpected_EOF;
-		return false;
+		// [post code]
+		appendBytecode( m_units[m_unitTop].bytecode, post.bytecode );
 	}
 
-	WRExpression nex( m_units[m_unitTop].bytecode.localSpace, m_units[m_unitTop].bytecode.isStructSpace );
-	nex.context[0].token = token;
-	nex.context[0].value = value;
-	m_loadedToken = token;
-	m_loadedValue = value;
-	m_loadedQuoted = m_quoted;
+	addRelativeJumpSource( m_units[m_unitTop].bytecode, O_RelativeJump, conditionPoint );
+	setRelativeJumpTarget( m_units[m_unitTop].bytecode, *m_breakTargets.tail() );
 
-	if ( parseExpression(nex) != ')' )
-	{
-		m_err = WR_ERR_unexpected_token;
-		return false;
-	}
+	m_continueTargets.pop();
+	m_breakTargets.pop();
 
-	appendBytecode( m_units[m_unitTop].bytecode, nex.bytecode );
+	resolveRelativeJumps( m_units[m_unitTop].bytecode );
 
-	int conditionFalseMarker = addRelativeJumpTarget( m_units[m_unitTop].bytecode );
-	
-	addRelativeJumpSource( m_units[m_unitTop].bytecode, O_BZ, conditionFalseMarker );
+	return true;
+}
 
-	if ( !parseStatement(m_unitTop, ';', returnCalled, opcodeToReturn) )
+//------------------------------------------------------------------------------
+bool WRCompilationContext::lookupConstantValue( WRstr& prefix, WRValue* value )
+{
+	for( unsigned int v=0; v<m_units[m_unitTop].constantValues.count(); ++v )
 	{
-		return false;
+		if ( m_units[m_unitTop].constantValues[v].label == prefix )
+		{
+			if ( value )
+			{
+				*value = m_units[m_unitTop].constantValues[v].value;
+			}
+			return true;
+		}
 	}
 
- 	if ( !getToken(ex) )
-	{
-		setRelativeJumpTarget(m_units[m_unitTop].bytecode, conditionFalseMarker);
-	}
-	else if ( !m_quoted && token == "else" )
+	for( unsigned int v=0; v<m_units[0].constantValues.count(); ++v )
 	{
-		int conditionTrueMarker = addRelativeJumpTarget( m_units[m_unitTop].bytecode ); // when it hits here it will jump OVER this section
-
-		addRelativeJumpSource( m_units[m_unitTop].bytecode, O_RelativeJump, conditionTrueMarker );
-		
-		setRelativeJumpTarget( m_units[m_unitTop].bytecode, conditionFalseMarker );
-
-		if ( !parseStatement(m_unitTop, ';', returnCalled, opcodeToReturn) )
+		if ( m_units[0].constantValues[v].label == prefix )
 		{
-			return false;
+			if ( value )
+			{
+				*value = m_units[0].constantValues[v].value;
+			}
+			return true;
 		}
-		
-		setRelativeJumpTarget( m_units[m_unitTop].bytecode, conditionTrueMarker );
-	}
-	else
-	{
-		m_loadedToken = token;
-		m_loadedValue = value;
-		m_loadedQuoted = m_quoted;
-		setRelativeJumpTarget( m_units[m_unitTop].bytecode, conditionFalseMarker );
 	}
 
-	resolveRelativeJumps( m_units[m_unitTop].bytecode ); // at least do the ones we added
-
-	return true;
+	return false;
 }
 
 //------------------------------------------------------------------------------
-bool WRCompilationContext::parseStatement( int unitIndex, char end, bool& returnCalled, WROpcode opcodeToReturn )
+bool WRCompilationContext::parseEnum( int unitIndex )
 {
 	WRExpressionContext ex;
-	returnCalled = false;
-	bool varSeen = false;
-	m_exportNextUnit = false;
+	WRstr& token = ex.token;
+	WRValue& value = ex.value;
 
-	for(;;)
+	if ( !getToken(ex, "{") )
 	{
-		WRstr& token = ex.token;
-//		WRValue& value = ex.value;
-
-		if ( !getToken(ex) ) // if we run out of tokens that's fine as long as we were not waiting for a }
-		{
-			if ( end == '}' )
-			{
-				m_err = WR_ERR_unexpected_EOF;
-				return false;
-			}
+		m_err = WR_ERR_unexpected_token;
+		return false;
+	}
 
-			break;
-		}
+	unsigned int index = 0;
 
-		if ( token[0] == end )
+	for(;;)
+	{
+		if ( !getToken(ex) )
 		{
-			break;
+			m_err = WR_ERR_unexpected_token;
+			return false;
 		}
 
-		if ( m_exportNextUnit
-			 && token != "function"
-			 && token != "struct"
-			 && token != "unit" )
+		if ( !m_quoted && token == "}" )
 		{
-			m_err = WR_ERR_unexpected_export_keyword;
 			break;
 		}
-		
-		if ( !m_quoted && token == "{" )
+		else if ( !m_quoted && token == "," )
 		{
-			return parseStatement( unitIndex, '}', returnCalled, opcodeToReturn );
+			continue;
 		}
 
-		if ( !m_quoted && token == "return" )
+		bool isGlobal;
+		WRstr prefix;
+		bool isLibConstant;
+		if ( !isValidLabel(token, isGlobal, prefix, isLibConstant) || isGlobal || isLibConstant )
 		{
-			returnCalled = true;
-			if ( !getToken(ex) )
-			{
-				m_err = WR_ERR_unexpected_EOF;
-				return false;
-			}
-
-			if ( !m_quoted && token == ";" ) // special case of a null return, add the null
-			{
-				pushOpcode( m_units[unitIndex].bytecode, O_LiteralZero );
-			}
-			else
-			{
-				WRExpression nex( m_units[unitIndex].bytecode.localSpace, m_units[unitIndex].bytecode.isStructSpace );
-				nex.context[0].token = token;
-				nex.context[0].value = ex.value;
-				m_loadedToken = token;
-				m_loadedValue = ex.value;
-				m_loadedQuoted = m_quoted;
-
-				if ( parseExpression( nex ) != ';')
-				{
-					m_err = WR_ERR_unexpected_token;
-					return false;
-				}
-
-				appendBytecode( m_units[unitIndex].bytecode, nex.bytecode );
-			}
-
-			pushDebug( WRD_LineNumber, m_units[m_unitTop].bytecode, getSourcePosition() );
-			pushOpcode( m_units[unitIndex].bytecode, opcodeToReturn );
+			m_err = WR_ERR_bad_label;
+			return false;
 		}
-		else if ( !m_quoted && token == "struct" )
-		{
-			if ( unitIndex != 0 )
-			{
-				m_err = WR_ERR_statement_expected;
-				return false;
-			}
 
-			if ( !parseUnit(true, unitIndex) )
-			{
-				return false;
-			}
-		}
-		else if ( !m_quoted && (token == "function" || token == "unit") )
+		prefix = token;
+		
+		WRValue defaultValue;
+		defaultValue.init();
+		defaultValue.ui = index++;
+
+		if ( !getToken(ex) )
 		{
-			if ( unitIndex != 0 )
-			{
-				m_err = WR_ERR_statement_expected;
-				return false;
-			}
-			
-			if ( !parseUnit(false, unitIndex) )
-			{
-				return false;
-			}
+			m_err = WR_ERR_unexpected_EOF;
+			return false;
 		}
-		else if ( !m_quoted && token == "if" )
+
+		if ( !m_quoted && token == "=" )
 		{
-			if ( !parseIf(returnCalled, opcodeToReturn) )
+			if ( !getToken(ex) )
 			{
+				m_err = WR_ERR_bad_label;
 				return false;
 			}
-		}
-		else if ( !m_quoted && token == "while" )
-		{
-			if ( !parseWhile(returnCalled, opcodeToReturn) )
+
+			if ( value.type == WR_REF )
 			{
+				m_err = WR_ERR_bad_label;
 				return false;
 			}
 		}
-		else if ( !m_quoted && token == "for" )
+		else
 		{
-			if ( !parseForLoop(returnCalled, opcodeToReturn) )
-			{
-				return false;
-			}
+			m_loadedToken = token;
+			m_loadedValue = value;
+			m_loadedQuoted = m_quoted;
+
+			value = defaultValue;
 		}
-		else if ( !m_quoted && token == "enum" )
+
+		if ( value.type == WR_INT )
 		{
-			if ( !parseEnum(unitIndex) )
-			{
-				return false;
-			}
+			index = value.ui + 1;
 		}
-		else if ( !m_quoted && token == "export" )
+		else if ( value.type != WR_FLOAT )
 		{
-			m_exportNextUnit = true;
-			continue;
+			m_err = WR_ERR_bad_label;
+			return false;
 		}
-		else if ( !m_quoted && token == "switch" )
+		
+		if ( lookupConstantValue(prefix) )
 		{
-			if ( !parseSwitch(returnCalled, opcodeToReturn) )
-			{
-				return false;
-			}
+			m_err = WR_ERR_constant_redefined;
+			return false;
 		}
-		else if ( !m_quoted && token == "do" )
-		{
-			if ( !parseDoWhile(returnCalled, opcodeToReturn) )
-			{
-				return false;
-			}
-		}
-		else if ( !m_quoted && token == "break" )
-		{
-			if ( !m_breakTargets.count() )
-			{
-				m_err = WR_ERR_break_keyword_not_in_looping_structure;
-				return false;
-			}
 
-			addRelativeJumpSource( m_units[unitIndex].bytecode, O_RelativeJump, *m_breakTargets.tail() );
-		}
-		else if ( !m_quoted && token == "continue" )
-		{
-			if ( !m_continueTargets.count() )
-			{
-				m_err = WR_ERR_continue_keyword_not_in_looping_structure;
-				return false;
-			}
+		ConstantValue& newVal = m_units[m_unitTop].constantValues.append();
+		newVal.label = prefix;
+		newVal.value = value;
+	}
 
-			addRelativeJumpSource( m_units[unitIndex].bytecode, O_RelativeJump, *m_continueTargets.tail() );
+	if ( getToken(ex) && token != ";" )
+	{
+		m_loadedToken = token;
+		m_loadedValue = value;
+		m_loadedQuoted = m_quoted;
+	}
+
+	return true;
+}
+
+//------------------------------------------------------------------------------
+uint32_t WRCompilationContext::getSingleValueHash( const char* end, bool& integer )
+{
+	WRExpressionContext ex;
+	WRstr& token = ex.token;
+	WRValue& value = ex.value;
+	getToken( ex );
+	
+	if ( !m_quoted && token == "(" )
+	{
+		return getSingleValueHash( ")", integer );
+	}
+
+	if ( value.type == WR_REF )
+	{
+		m_err = WR_ERR_switch_bad_case_hash;
+		return 0;
+	}
+	
+	uint32_t hash = ((uint8_t)value.type == WR_COMPILER_LITERAL_STRING) ? wr_hashStr(token) : value.getHash();
+	integer = value.type == WR_INT;
+
+	if ( !getToken(ex, end) )
+	{
+		m_err = WR_ERR_unexpected_token;
+		return 0;
+	}
+
+	return hash;
+}
+
+/*
+
+
+    continue target:
+    targetswitchLinear
+    8-bit max
+pc> 16-bit default location
+    16 bit case offset
+    16 bit case offset
+    16 bit case offset
+    cases...
+    [cases]
+    break target:
+
+
+integer cases too far from 0 for that, or too many, but still dense:
+
+    continue target:
+    targetswitchLinear
+    0 (never a size)
+    32-bit first case
+    16-bit number of cases
+pc> 16-bit default location
+    16 bit case offset
+    ...
+
+
+continue target:
+switch ins
+16-bit mod
+16-bit default location
+32 hash case mod 0 : 16 bit case offset
+32 hash case mod 1 : 16 bit case offset
+32 hash case mod 2 : 16 bit case offset
+...
+[cases]
+break target:
+
+
+sparse integer cases are searched for instead:
+
+pc> switch ins
+    0 (never a mod)
+    16-bit default location
+    16-bit number of cases
+    32 lowest case : 16 bit case offset
+    32 next case : 16 bit case offset
+    ...
+
+*/
+
+//------------------------------------------------------------------------------
+struct WRSwitchCase
+{
+	uint32_t hash; // hash to get this case
+	bool occupied; // null hash is legal and common, must mark occupation of a node with extra flag
+	bool defaultCase;
+	bool integer; // the hash is the value of an int
+	int16_t jumpOffset; // where to go to get to this case
+};
+
+// a dense switch can have this many table entries per case, more and the
+// cases are searched for
+#define WR_SWITCH_DENSITY 3
+
+//------------------------------------------------------------------------------
+bool WRCompilationContext::parseSwitch( bool& returnCalled, WROpcode opcodeToReturn )
+{
+	WRExpressionContext ex;
+	WRstr& token = ex.token;
+	WRValue& value = ex.value;
+
+	if ( !getToken(ex, "(") )
+	{
+		m_err = WR_ERR_unexpected_token;
+		return false;
+	}
+	
+	WRExpression selectionCriteria( m_units[m_unitTop].bytecode.localSpace, m_units[m_unitTop].bytecode.isStructSpace );
+	selectionCriteria.context[0].token = token;
+	selectionCriteria.context[0].value = value;
+	
+	if ( parseExpression(selectionCriteria) != ')' )
+	{
+		m_err = WR_ERR_unexpected_token;
+		return false;
+	}
+
+	appendBytecode( m_units[m_unitTop].bytecode, selectionCriteria.bytecode );
+
+
+	if ( !getToken(ex, "{") )
+	{
+		m_err = WR_ERR_unexpected_token;
+		return false;
+	}
+
+	WRarray<WRSwitchCase> cases;
+	int16_t defaultOffset = -1;
+	WRSwitchCase* swCase = 0; // current case
+
+	int defaultCaseJumpTarget = addRelativeJumpTarget( m_units[m_unitTop].bytecode );
+
+	*m_breakTargets.push() = addRelativeJumpTarget( m_units[m_unitTop].bytecode );
+
+	int selectionLogicPoint = addRelativeJumpTarget( m_units[m_unitTop].bytecode );
+	addRelativeJumpSource( m_units[m_unitTop].bytecode, O_RelativeJump, selectionLogicPoint );
+
+	unsigned int startingBytecodeMarker = m_units[m_unitTop].bytecode.all.size();
+	
+	for(;;)
+	{
+		if ( !getToken(ex) )
+		{
+			m_err = WR_ERR_unexpected_EOF;
+			return false;
 		}
-		else if ( !m_quoted && token == "goto" )
+
+		if( !m_quoted && token == "}" )
 		{
-			if ( !getToken(ex) ) // if we run out of tokens that's fine as long as we were not waiting for a }
-			{
-				m_err = WR_ERR_unexpected_EOF;
-				return false;
-			}
+			break;
+		}
 
-			bool isGlobal;
-			WRstr prefix;
-			bool isLibConstant;
-			if ( !isValidLabel(token, isGlobal, prefix, isLibConstant) || isGlobal || isLibConstant )
+		if ( !m_quoted && token == "case" )
+		{
+			swCase = &cases.append();
+			swCase->jumpOffset = m_units[m_unitTop].bytecode.all.size();
+			swCase->hash = getSingleValueHash( ":", swCase->integer );
+			if ( m_err )
 			{
-				m_err = WR_ERR_bad_goto_label;
 				return false;
 			}
 
-			GotoSource& G = m_units[unitIndex].bytecode.gotoSource.append();
-			G.hash = wr_hashStr( token );
-			G.offset = m_units[unitIndex].bytecode.all.size();
-			pushData( m_units[unitIndex].bytecode, "\0\0\0", 3 );
+			swCase->occupied = true;
+			swCase->defaultCase = false;
 
-			if ( !getToken(ex, ";"))
+			if ( cases.count() > 1 )
 			{
-				m_err = WR_ERR_unexpected_token;
-				return false;
+				for( unsigned int h = 0; h < cases.count() - 1 ; ++h )
+				{
+					if ( cases[h].occupied && !cases[h].defaultCase && (swCase->hash == cases[h].hash) )
+					{
+						m_err = WR_ERR_switch_duplicate_case;
+						return false;
+					}
+				}
 			}
 		}
-/*
-		else if ( !m_quoted && token == "var" )
+		else if ( !m_quoted && token == "default" )
 		{
-			if ( !getToken(ex) ) // if we run out of tokens that's fine as long as we were not waiting for a }
+			if ( defaultOffset != -1 )
 			{
-				m_err = WR_ERR_unexpected_EOF;
+				m_err = WR_ERR_switch_duplicate_case;
 				return false;
 			}
 
-			bool isGlobal;
-			WRstr prefix;
-			bool isLibConstant;
-			if ( !isValidLabel(token, isGlobal, prefix, isLibConstant) || isLibConstant )
+			if ( !getToken(ex, ":") )
 			{
-				m_err = WR_ERR_bad_goto_label;
+				m_err = WR_ERR_unexpected_token;
 				return false;
 			}
-			
-			varSeen = true;
-			goto parseAsVar;
+
+			defaultOffset = m_units[m_unitTop].bytecode.all.size();
+			setRelativeJumpTarget( m_units[m_unitTop].bytecode, defaultCaseJumpTarget );
 		}
 		else
 		{
-parseAsVar:
-*/
-		else
-		{
-			WRExpression nex( m_units[unitIndex].bytecode.localSpace, m_units[unitIndex].bytecode.isStructSpace );
-			nex.context[0].varSeen = varSeen;
-			nex.context[0].token = token;
-			nex.context[0].value = ex.value;
-			nex.lValue = true;
-			m_loadedToken = token;
-			m_loadedValue = ex.value;
-			m_loadedQuoted = m_quoted;
-			if ( parseExpression(nex) != ';' )
+			if ( swCase == 0 && defaultOffset == -1 )
 			{
-				if ( !m_err )
-				{
-					m_err = WR_ERR_unexpected_token;
-				}
+				m_err = WR_ERR_switch_case_or_default_expected;
 				return false;
 			}
 
-			appendBytecode( m_units[unitIndex].bytecode, nex.bytecode );
-			pushOpcode( m_units[unitIndex].bytecode, O_PopOne );
-		}
+			m_loadedToken = token;
+			m_loadedValue = value;
+			m_loadedQuoted = m_quoted;
 
-		if ( end == ';' ) // single statement
-		{
-			break;
+			if ( !parseStatement(m_unitTop, ';', returnCalled, opcodeToReturn) )
+			{
+				return false;
+			}
 		}
 	}
 
-	return m_err ? false : true;
-}
-
-//------------------------------------------------------------------------------
-bool WRCompilationContext::checkAsComment( char lead )
-{
-	char c;
-	if ( lead == '/' )
+	if ( startingBytecodeMarker == m_units[m_unitTop].bytecode.all.size() )
 	{
-		if ( !getChar(c) )
+		// no code was added so this is one big null operation, go
+		// ahead and null it
+		m_units[m_unitTop].bytecode.all.shave(3);
+		m_units[m_unitTop].bytecode.opcodes.clear();
+			
+		pushOpcode(m_units[m_unitTop].bytecode, O_PopOne); // pop off the selection criteria
+
+		m_units[m_unitTop].bytecode.jumpOffsetTargets.pop();
+		m_breakTargets.pop();
+		return true;
+	}
+	
+	// make sure the last instruction is a break (jump) so the
+	// selection logic is skipped at the end of the last case/default
+	if ( !m_units[m_unitTop].bytecode.opcodes.size() 
+		 || (m_units[m_unitTop].bytecode.opcodes.size() && m_units[m_unitTop].bytecode.opcodes[m_units[m_unitTop].bytecode.opcodes.size() - 1] != O_RelativeJump
+			 && m_units[m_unitTop].bytecode.opcodes[m_units[m_unitTop].bytecode.opcodes.size() - 1] != O_RelativeJump32) )
+	{
+		addRelativeJumpSource( m_units[m_unitTop].bytecode, O_RelativeJump, *m_breakTargets.tail() );
+	}
+
+	// selection logic jumps HERE
+	setRelativeJumpTarget( m_units[m_unitTop].bytecode, selectionLogicPoint );
+
+	// find the highest hash value, and size an array to that
+	unsigned int size = 0;
+	for( unsigned int d=0; d<cases.count(); ++d )
+	{
+		if ( cases[d].defaultCase )
 		{
-			m_err = WR_ERR_unexpected_EOF;
-			return false;
+			continue;
 		}
 
-		if ( c == '/' )
+		if ( cases[d].hash > size )
 		{
-			while( getChar(c) && c != '\n' );
-			return true;
+			size = cases[d].hash;
 		}
-		else if ( c == '*' )
-		{
-			for(;;)
-			{
-				if ( !getChar(c) )
-				{
-					m_err = WR_ERR_unexpected_EOF;
-					return false;
-				}
 
-				if ( c == '*' )
-				{
-					if ( !getChar(c) )
-					{
-						m_err = WR_ERR_unexpected_EOF;
-						return false;
-					}
+		if ( size >= 254 )
+		{
+			break;
+		}
+	}
 
-					if ( c == '/' )
-					{
-						break;
-					}
-				}
-			}
+	// first try the easy way
 
-			return true;
-		}
+	++size;
 
-		// else not a comment
+	// cases that are all ints can be looked up from the lowest one
+	bool integers = true;
+	int32_t low = 0x7FFFFFFF;
+	int32_t high = -0x7FFFFFFF - 1;
+	for( unsigned int d=0; d<cases.count(); ++d )
+	{
+		integers = integers && cases[d].integer;
+		low = (int32_t)cases[d].hash < low ? (int32_t)cases[d].hash : low;
+		high = (int32_t)cases[d].hash > high ? (int32_t)cases[d].hash : high;
 	}
+	const int64_t span = (int64_t)high - low + 1;
 
-	return false;
-}
-
-//------------------------------------------------------------------------------
-bool WRCompilationContext::readCurlyBlock( WRstr& block )
-{
-	char c;
-	int closesNeeded = 0;
+	WRSwitchCase* table = 0;
+	unsigned char packbuf[4];
 
-	for(;;)
+	if ( size < 254 ) // cases are labeled 0-254, just use a linear jump table
 	{
-		if ( !getChar(c) )
-		{
-			m_err = WR_ERR_unexpected_EOF;
-			return false;
-		}
+		pushOpcode( m_units[m_unitTop].bytecode, O_SwitchLinear );
 
-		// read past comments
-		if ( checkAsComment(c) )
+		packbuf[0] = size;
+		pushData( m_units[m_unitTop].bytecode, packbuf, 1 ); // size
+
+		int currentPos = m_units[m_unitTop].bytecode.all.size();
+
+		if ( defaultOffset == -1 )
 		{
-			continue;
+			defaultOffset = size*2 + 2;
 		}
-
-		if ( m_err )
+		else
 		{
-			return false;
+			defaultOffset -= currentPos;
 		}
 
-		block += c;
-		
-		if ( c == '{' )
+		table = (WRSwitchCase *)wr_arenaMalloc(size * sizeof(WRSwitchCase));
+		memset( table, 0, size*sizeof(WRSwitchCase) );
+
+		for( unsigned int i = 0; i<size; ++i ) // for each of the possible entries..
 		{
-			++closesNeeded;
+			for( unsigned int hash = 0; hash<cases.count(); ++hash ) // if a hash matches it, populate that table entry
+			{
+				if ( cases[hash].occupied && !cases[hash].defaultCase && (cases[hash].hash == i) )
+				{
+					table[cases[hash].hash].jumpOffset = cases[hash].jumpOffset - currentPos;
+					table[cases[hash].hash].occupied = true;
+					break;
+				}
+			}
 		}
-		
-		if ( c == '}' )
+
+		pushData( m_units[m_unitTop].bytecode, wr_pack16(defaultOffset, packbuf), 2 );
+
+		for( unsigned int i=0; i<size; ++i )
 		{
-			if ( closesNeeded == 0 )
+			if ( table[i].occupied )
 			{
-				m_err = WR_ERR_unexpected_token;
-				return false;
+				pushData( m_units[m_unitTop].bytecode, wr_pack16(table[i].jumpOffset, packbuf), 2 );
 			}
-			
-			if ( !--closesNeeded )
+			else
 			{
-				break;
+				pushData( m_units[m_unitTop].bytecode, wr_pack16(defaultOffset, packbuf), 2 );
 			}
 		}
 	}
+	else if ( integers && span < 0x3FFF && span <= WR_SWITCH_DENSITY * (int64_t)cases.count() )
+	{
+		// the same table starting somewhere else, a size of 0 says where
+		pushOpcode( m_units[m_unitTop].bytecode, O_SwitchLinear );
 
-	return true;
-}
+		packbuf[0] = 0;
+		pushData( m_units[m_unitTop].bytecode, packbuf, 1 );
+		pushData( m_units[m_unitTop].bytecode, wr_pack32(low, packbuf), 4 );
+		pushData( m_units[m_unitTop].bytecode, wr_pack16((int16_t)span, packbuf), 2 );
 
+		int currentPos = m_units[m_unitTop].bytecode.all.size();
 
-#else // WRENCH_WITHOUT_COMPILER
+		if ( defaultOffset == -1 )
+		{
+			defaultOffset = (int16_t)(span*2 + 2);
+		}
+		else
+		{
+			defaultOffset -= currentPos;
+		}
 
-WRError wr_compile( const char* source,
-					const int size,
-					unsigned char** out,
-					int* outLen,
-					char* errMsg,
-					const uint8_t compilerOptionFlags )
-{
-	return WR_ERR_compiler_not_loaded;
-}
-	
-#endif
-/*******************************************************************************
-Copyright (c) 2024 Curt Hartung -- curt.hartung@gmail.com
+		table = (WRSwitchCase *)wr_arenaMalloc( (size_t)span * sizeof(WRSwitchCase) );
+		memset( table, 0, (size_t)span * sizeof(WRSwitchCase) );
+		for( unsigned int c=0; c<cases.count(); ++c )
+		{
+			table[(int32_t)cases[c].hash - low].jumpOffset = cases[c].jumpOffset - currentPos;
+			table[(int32_t)cases[c].hash - low].occupied = true;
+		}
 
-MIT Licence
+		pushData( m_units[m_unitTop].bytecode, wr_pack16(defaultOffset, packbuf), 2 );
 
-Permission is hereby granted, free of charge, to any person obtaining a copy
-of this software and associated documentation files (the "Software"), to deal
-in the Software without restriction, including without limitation the rights
-to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
-copies of the Software, and to permit persons to whom the Software is
-furnished to do so, subject to the following conditions:
+		for( int i=0; i<span; ++i )
+		{
+			pushData( m_units[m_unitTop].bytecode, wr_pack16(table[i].occupied ? table[i].jumpOffset : defaultOffset, packbuf), 2 );
+		}
+	}
+	else if ( integers && cases.count() < 0x1000 )
+	{
+		// too sparse for a table, the cases are put in order and searched
+		pushOpcode( m_units[m_unitTop].bytecode, O_Switch );
 
-The above copyright notice and this permission notice shall be included in all
-copies or substantial portions of the Software.
+		int currentPos = m_units[m_unitTop].bytecode.all.size();
 
-THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
-IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
-FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
-AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
-LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
-OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
-SOFTWARE.
-*******************************************************************************/
+		if ( defaultOffset == -1 )
+		{
+			defaultOffset = cases.count()*6 + 6;
+		}
+		else
+		{
+			defaultOffset -= currentPos;
+		}
 
-#include "wrench.h"
-#ifndef WRENCH_WITHOUT_COMPILER
-#include <assert.h>
+		table = (WRSwitchCase *)wr_arenaMalloc( cases.count() * sizeof(WRSwitchCase) );
+		for( unsigned int c=0; c<cases.count(); ++c )
+		{
+			unsigned int at = c;
+			for( ; at > 0 && (int32_t)table[at - 1].hash > (int32_t)cases[c].hash; --at )
+			{
+				table[at] = table[at - 1];
+			}
+			table[at] = cases[c];
+		}
 
-#define WR_DUMP_LINK_OUTPUT(D) //D
-#define WR_DUMP_UNIT_OUTPUT(D) //D
-#define WR_DUMP_BYTECODE(D) //D
-//WRstr str;
+		pushData( m_units[m_unitTop].bytecode, wr_pack16(0, packbuf), 2 ); // never a mod
+		pushData( m_units[m_unitTop].bytecode, wr_pack16(defaultOffset, packbuf), 2 );
+		pushData( m_units[m_unitTop].bytecode, wr_pack16(cases.count(), packbuf), 2 );
 
-//------------------------------------------------------------------------------
-void WRCompilationContext::createLocalHashMap( WRUnitContext& unit, unsigned char** buf, int* size )
-{
-	if ( unit.bytecode.localSpace.count() == 0 )
-	{
-		*size = 0;
-		*buf = 0;
-		return;
+		for( unsigned int c=0; c<cases.count(); ++c )
+		{
+			pushData( m_units[m_unitTop].bytecode, wr_pack32(table[c].hash, packbuf), 4 );
+			pushData( m_units[m_unitTop].bytecode, wr_pack16(table[c].jumpOffset - currentPos, packbuf), 2 );
+		}
 	}
-
-	WRHashTable<unsigned char> offsets;
-	for( unsigned char i=unit.arguments; i<unit.bytecode.localSpace.count(); ++i )
+	else
 	{
-		offsets.set( unit.bytecode.localSpace[i].hash, i - unit.arguments );
-	}
+		pushOpcode( m_units[m_unitTop].bytecode, O_Switch ); // add switch command
+		unsigned char packbuf[4];
 
-	*buf = (unsigned char *)g_malloc( (offsets.m_mod * 5) + 4 );
+		int currentPos = m_units[m_unitTop].bytecode.all.size();
 
-	(*buf)[0] = (unsigned char)(unit.bytecode.localSpace.count() - unit.arguments);
-	(*buf)[1] = unit.arguments;
+		// find a suitable mod
+		uint16_t mod = 1;
+		for( ; mod<0x7FFE; ++mod )
+		{
+			table = (WRSwitchCase *)wr_arenaMalloc(mod * sizeof(WRSwitchCase));
+			memset( table, 0, sizeof(WRSwitchCase)*mod );
 
-	wr_pack16( offsets.m_mod, *buf + 2 );
+			unsigned int c=0;
+			for( ; c<cases.count(); ++c )
+			{
+				if ( cases[c].defaultCase )
+				{
+					continue;
+				}
 
-	*size = 4;
+				if ( table[cases[c].hash % mod].occupied )
+				{
+					break;
+				}
 
-	for( int i=0; i<offsets.m_mod; ++i )
-	{
-		wr_pack32( offsets.m_list[i].hash, *buf + *size );
-		*size += 4;
-		(*buf)[(*size)++] = offsets.m_list[i].hash ? offsets.m_list[i].value : (unsigned char)-1;
-	}
-}
+				table[cases[c].hash % mod].hash = cases[c].hash;
+				table[cases[c].hash % mod].jumpOffset = cases[c].jumpOffset - currentPos;
+				table[cases[c].hash % mod].occupied = true;
+			}
 
-//------------------------------------------------------------------------------
-void WRCompilationContext::link( unsigned char** out, int* outLen, const uint8_t compilerOptionFlags )
-{
-	WROpcodeStream code;
+			if ( c >= cases.count() )
+			{
+				break;
+			}
+			else
+			{
+				wr_arenaFree( table );
+				table = 0;
+			} 
+		}
 
-	uint8_t data[4];
+		if ( mod >= 0x7FFE )
+		{
+			m_err = WR_ERR_switch_construction_error;
+			return false;
+		}
 
-	NamespacePush *namespaceLookups = 0;
+		if ( defaultOffset == -1 )
+		{
+			defaultOffset = mod*6 + 4;
+		}
+		else
+		{
+			defaultOffset -= currentPos;
+		}
 
-	unsigned int globals = m_units[0].bytecode.localSpace.count();
-	assert( globals < 256 );
+		pushData( m_units[m_unitTop].bytecode, wr_pack16(mod, packbuf), 2 ); // mod value
+		pushData( m_units[m_unitTop].bytecode, wr_pack16(defaultOffset, packbuf), 2 ); // default offset
 
-	code += (uint8_t)globals; // globals count (for VM allocation)
-	code += (uint8_t)(m_units.count() - 1); // function count (for VM allocation)
-	code += (uint8_t)compilerOptionFlags;
+		for( uint16_t m = 0; m<mod; ++m )
+		{
+			pushData( m_units[m_unitTop].bytecode, wr_pack32(table[m].hash, packbuf), 4 );
 
-	// push function signatures
-	for( unsigned int u=1; u<m_units.count(); ++u )
-	{
-		m_units[u].offsetInBytecode = code.size(); // mark these two spots for later
+			if ( !table[m].occupied )
+			{
+				pushData( m_units[m_unitTop].bytecode, wr_pack16(defaultOffset, packbuf), 2 );
+			}
+			else
+			{
+				pushData( m_units[m_unitTop].bytecode, wr_pack16(table[m].jumpOffset, packbuf), 2 );
+			}
+		}
+	}
 
-		// WRFunction.namespaceOffset
-		data[0] = 0xAA;
-		data[1] = 0xBB;
-		code.append( data, 2 ); // placeholder
+	wr_arenaFree( table );
 
-		// WRFunction.functionOffset
-		data[0] = 0xCC;
-		data[1] = 0xDD;
-		code.append( data, 2 ); // placeholder
+	if ( m_units[m_unitTop].bytecode.all.size() - startingBytecodeMarker > 0x7FFF )
+	{
+		m_err = WR_ERR_switch_construction_error; // the table only reaches 32k back
+		return false;
+	}
 
-		// WRFunction.hash
-		code.append( wr_pack32(m_units[u].hash, data), 4 );
+	setRelativeJumpTarget( m_units[m_unitTop].bytecode, *m_breakTargets.tail() );
 
-		// WRFunction.arguments;
-		data[0] = m_units[u].arguments;
-		code.append( data, 1 );
+	resolveRelativeJumps( m_units[m_unitTop].bytecode );
 
-		// WRFunction.frameSpaceNeeded;
-		data[1] = m_units[u].bytecode.localSpace.count();
-		code.append( data + 1, 1 );
+	m_breakTargets.pop();
 
-		// WRFunction.frameBaseAdjustment;
-		data[2] = 1 + data[0] + data[1];
-		code.append( data + 2, 1 );
-	}
+	return true;
+}
 
-	m_units[0].name = "::global";
+//------------------------------------------------------------------------------
+bool WRCompilationContext::parseIf( bool& returnCalled, WROpcode opcodeToReturn )
+{
+	WRExpressionContext ex;
+	WRstr& token = ex.token;
+	WRValue& value = ex.value;
 
-	if ( compilerOptionFlags & WR_INCLUDE_GLOBALS )
+	if ( !getToken(ex, "(") )
 	{
-		for( unsigned int i=0; i<globals; ++i )
-		{
-			code.append( wr_pack32(m_units[0].bytecode.localSpace[i].hash, data), 4 );
-		}
+		m_err = WR_ERR_unexpected_token;
+		return false;
 	}
 
-	if ( (compilerOptionFlags & WR_EMBED_DEBUG_CODE)
-		 || (compilerOptionFlags & WR_EMBED_SOURCE_CODE) )
+	if ( !getToken(ex) )
 	{
-		// hash of source compiled for this
-		code.append( wr_pack32(wr_hash(m_source, m_sourceLen), data), 4 ); 
-
-		WRstr symbols;
+		m_err = WR_ERR_unexpected_EOF;
+		return false;
+	}
 
-		uint16_t functions = m_units.count();
-		symbols.append( (char*)wr_pack16(functions, data), 2 );
+	WRExpression nex( m_units[m_unitTop].bytecode.localSpace, m_units[m_unitTop].bytecode.isStructSpace );
+	nex.context[0].token = token;
+	nex.context[0].value = value;
+	m_loadedToken = token;
+	m_loadedValue = value;
+	m_loadedQuoted = m_quoted;
 
-		data[0] = 0; // terminator
-		for( unsigned int u=0; u<m_units.count(); ++u ) // all the local labels by unit
-		{
-			data[1] = m_units[u].bytecode.localSpace.count();
-			data[2] = m_units[u].arguments;
-			symbols.append( (char *)(data + 1), 2 );
+	if ( parseExpression(nex) != ')' )
+	{
+		m_err = WR_ERR_unexpected_token;
+		return false;
+	}
 
-			symbols.append( m_units[u].name );
-			symbols.append( (char *)data, 1 ); 
+	appendBytecode( m_units[m_unitTop].bytecode, nex.bytecode );
 
-			for( unsigned int s=0; s<m_units[u].bytecode.localSpace.count(); ++s )
-			{
-				symbols.append( m_units[u].bytecode.localSpace[s].label );
-				symbols.append( (char *)data, 1 ); 
-			}
-		}
+	int conditionFalseMarker = addRelativeJumpTarget( m_units[m_unitTop].bytecode );
+	
+	addRelativeJumpSource( m_units[m_unitTop].bytecode, O_BZ, conditionFalseMarker );
 
-		uint16_t symbolSize = symbols.size();
-		code.append( wr_pack16(symbolSize, data), 2 );
-		code.append( (uint8_t*)symbols.p_str(), symbols.size() );
+	if ( !parseStatement(m_unitTop, ';', returnCalled, opcodeToReturn) )
+	{
+		return false;
 	}
 
-	if ( compilerOptionFlags & WR_EMBED_SOURCE_CODE )
+ 	if ( !getToken(ex) )
 	{
-		code.append( wr_pack32(m_sourceLen, data), 4 );
-		code.append( (uint8_t*)m_source, m_sourceLen );
+		setRelativeJumpTarget(m_units[m_unitTop].bytecode, conditionFalseMarker);
 	}
-
-	// export any explicitly marked for export or are referred to by a 'new'
-	for( unsigned int ux=0; ux<m_units.count(); ++ux )
+	else if ( !m_quoted && token == "else" )
 	{
-		for( unsigned int f=0; f<m_units[ux].bytecode.unitObjectSpace.count(); ++f )
-		{
-			WRNamespaceLookup& N = m_units[ux].bytecode.unitObjectSpace[f];
+		int conditionTrueMarker = addRelativeJumpTarget( m_units[m_unitTop].bytecode ); // when it hits here it will jump OVER this section
 
-			for( unsigned int r=0; r<N.references.count(); ++r )
-			{
-				for( unsigned int u2 = 1; u2<m_units.count(); ++u2 )
-				{
-					if ( m_units[u2].hash == N.hash )
-					{
-						m_units[u2].exportNamespace = true;
-						break;
-					}
-				}
-			}
+		addRelativeJumpSource( m_units[m_unitTop].bytecode, O_RelativeJump, conditionTrueMarker );
+		
+		setRelativeJumpTarget( m_units[m_unitTop].bytecode, conditionFalseMarker );
+
+		if ( !parseStatement(m_unitTop, ';', returnCalled, opcodeToReturn) )
+		{
+			return false;
 		}
+		
+		setRelativeJumpTarget( m_units[m_unitTop].bytecode, conditionTrueMarker );
 	}
-
-	WR_DUMP_LINK_OUTPUT(printf("header funcs[%d] locals[%d] flags[0x%02X]:\n%s\n",
-							   (unsigned char)(m_units.count() - 1),
-							   (unsigned char)(m_units[0].bytecode.localSpace.count()),
-							   (unsigned char)compilerOptionFlags, wr_asciiDump( code.p_str(), code.size(), str )));
-
-	// append all the unit code
-	for( unsigned int u=0; u<m_units.count(); ++u )
+	else
 	{
-		uint16_t base;
+		m_loadedToken = token;
+		m_loadedValue = value;
+		m_loadedQuoted = m_quoted;
+		setRelativeJumpTarget( m_units[m_unitTop].bytecode, conditionFalseMarker );
+	}
 
-		if ( u > 0 ) // for the non-zero unit fill locations into the jump table
-		{
-			if ( m_units[u].exportNamespace )
-			{
-				base = code.size();
+	resolveRelativeJumps( m_units[m_unitTop].bytecode ); // at least do the ones we added
 
-				int size = 0;
-				uint8_t* map = 0;
-				createLocalHashMap( m_units[u], &map, &size );
-				
-				if ( size == 0 )
-				{
-					base = 0;
-				}
-				m_units[u].offsetOfLocalHashMap = base;
+	return true;
+}
 
-				wr_pack16( base, code.p_str(m_units[u].offsetInBytecode)); // WRFunction.namespaceOffset
+//------------------------------------------------------------------------------
+bool WRCompilationContext::parseStatement( int unitIndex, char end, bool& returnCalled, WROpcode opcodeToReturn )
+{
+	WRExpressionContext ex;
+	returnCalled = false;
+	bool varSeen = false;
+	m_exportNextUnit = false;
 
-				WR_DUMP_LINK_OUTPUT(printf("<new> namespace\n%s\n", wr_asciiDump(map, size, str)));
+	for(;;)
+	{
+		WRstr& token = ex.token;
+//		WRValue& value = ex.value;
 
-				code.append( map, size );
-				g_free( map );
-			}
-			else
+		if ( !getToken(ex) ) // if we run out of tokens that's fine as long as we were not waiting for a }
+		{
+			if ( end == '}' )
 			{
-				base = 0;
-				wr_pack16( base, code.p_str(m_units[u].offsetInBytecode) ); // WRFunction.namespaceOffset
+				m_err = WR_ERR_unexpected_EOF;
+				return false;
 			}
 
-			base = code.size();
-			wr_pack16( base, code.p_str(m_units[u].offsetInBytecode + 2) ); // WRFunction.functionOffset
+			break;
 		}
 
-		WR_DUMP_UNIT_OUTPUT(printf("unit %d:\n%s\n", u, wr_asciiDump(code, code.size(), str)));
+		if ( token[0] == end )
+		{
+			break;
+		}
 
-		base = code.size();
+		if ( m_exportNextUnit
+			 && token != "function"
+			 && token != "struct"
+			 && token != "unit" )
+		{
+			m_err = WR_ERR_unexpected_export_keyword;
+			break;
+		}
+		
+		if ( !m_quoted && token == "{" )
+		{
+			return parseStatement( unitIndex, '}', returnCalled, opcodeToReturn );
+		}
 
-		// fill relative jumps in for the goto's
-		for( unsigned int g=0; g<m_units[u].bytecode.gotoSource.count(); ++g )
+		if ( !m_quoted && token == "return" )
 		{
-			unsigned int j=0;
-			for( ; j<m_units[u].bytecode.jumpOffsetTargets.count(); j++ )
-			{
-				if ( m_units[u].bytecode.jumpOffsetTargets[j].gotoHash == m_units[u].bytecode.gotoSource[g].hash )
-				{
-					int diff = m_units[u].bytecode.jumpOffsetTargets[j].offset - m_units[u].bytecode.gotoSource[g].offset;
-					diff -= 2;
-					if ( (diff < 128) && (diff > -129) )
-					{
-						*m_units[u].bytecode.all.p_str( m_units[u].bytecode.gotoSource[g].offset ) = (unsigned char)O_RelativeJump8;
-						*m_units[u].bytecode.all.p_str( m_units[u].bytecode.gotoSource[g].offset + 1 ) = diff;
-					}
-					else
-					{
-						*m_units[u].bytecode.all.p_str( m_units[u].bytecode.gotoSource[g].offset ) = (unsigned char)O_RelativeJump;
-						wr_pack16( diff, m_units[u].bytecode.all.p_str(m_units[u].bytecode.gotoSource[g].offset + 1) );
-					}
-
-					break;
-				}
-			}
-
-			if ( j >= m_units[u].bytecode.jumpOffsetTargets.count() )
+			returnCalled = true;
+			if ( !getToken(ex) )
 			{
-				m_err = WR_ERR_goto_target_not_found;
-				return;
+				m_err = WR_ERR_unexpected_EOF;
+				return false;
 			}
-		}
-
-		WR_DUMP_LINK_OUTPUT(printf("Adding Unit %d [%d]\n%s", u, m_units[u].bytecode.all.size(), wr_asciiDump(m_units[u].bytecode.all, m_units[u].bytecode.all.size(), str)));
-
-		code.append( m_units[u].bytecode.all, m_units[u].bytecode.all.size() );
 
-		WR_DUMP_LINK_OUTPUT(printf("->\n%s\n", wr_asciiDump( code.p_str(), code.size(), str )));
-
-		// populate 'new' vectors
-		for( unsigned int f=0; f<m_units[u].bytecode.unitObjectSpace.count(); ++f )
-		{
-			WRNamespaceLookup& N = m_units[u].bytecode.unitObjectSpace[f];
-
-			for( unsigned int r=0; r<N.references.count(); ++r )
+			if ( !m_quoted && token == ";" ) // special case of a null return, add the null
 			{
-				for( unsigned int u2 = 1; u2<m_units.count(); ++u2 )
-				{
-					if ( m_units[u2].hash == N.hash )
-					{
-						NamespacePush *n = (NamespacePush *)g_malloc(sizeof(NamespacePush));
-						n->next = namespaceLookups;
-						namespaceLookups = n;
-						n->unit = u2;
-						n->location = base + N.references[r];
-
-						break;
-					}
-				}
+				pushOpcode( m_units[unitIndex].bytecode, O_LiteralZero );
 			}
-		}
-
-		// load function table
-		for( unsigned int x=0; x<m_units[u].bytecode.functionSpace.count(); ++x )
-		{
-			WRNamespaceLookup& N = m_units[u].bytecode.functionSpace[x];
-
-			WR_DUMP_LINK_OUTPUT(printf("function[%d] fixup before:\n%s\n", x, wr_asciiDump(code, code.size(), str)));
-
-			for( unsigned int r=0; r<N.references.count(); ++r )
+			else
 			{
-				unsigned int u2 = 1;
-				int index = base + N.references[r];
+				WRExpression nex( m_units[unitIndex].bytecode.localSpace, m_units[unitIndex].bytecode.isStructSpace );
+				nex.context[0].token = token;
+				nex.context[0].value = ex.value;
+				m_loadedToken = token;
+				m_loadedValue = ex.value;
+				m_loadedQuoted = m_quoted;
 
-				for( ; u2<m_units.count(); ++u2 )
+				if ( parseExpression( nex ) != ';')
 				{
-					if ( m_units[u2].hash == N.hash ) // local function! call it, manage preserving retval
-					{
-						if ( m_addDebugSymbols )
-						{
-							// fill in the codeword with internal function number
-							uint16_t codeword = (uint16_t)WRD_FunctionCall | (uint16_t)u2;
-							wr_pack16( codeword, (unsigned char *)code.p_str(index - 2) );
-						}
-
-						code[index] = O_CallFunctionByIndex;
-
-						code[index+2] = (char)(u2 - 1);
-
-						// r+1 = args
-						// r+2345 = hash
-						// r+6
-
-						if ( code[index+5] == O_PopOne || code[index + 6] == O_NewObjectTable)
-						{
-							code[index+3] = 3; // skip past the pop, or TO the NewObjectTable
-						}
-						else 
-						{
-							code[index+3] = 2; // skip by this push is seen
-							code[index+5] = O_PushIndexFunctionReturnValue;
-						}
-
-						break;
-					}
+					m_err = WR_ERR_unexpected_token;
+					return false;
 				}
 
-				if ( u2 >= m_units.count() ) // no local function found, rely on it being found run-time
-				{
-					if ( N.hash == wr_hashStr("yield") )
-					{
-						code[index] = O_Yield;
-					}
-					else
-					{
-						if ( code[index+5] == O_PopOne )
-						{
-							code[index] = O_CallFunctionByHashAndPop;
-						}
-						else
-						{
-							code[index] = O_CallFunctionByHash;
-						}
-
-						wr_pack32( N.hash, code.p_str(index+2) );
-					}
-				}
+				appendBytecode( m_units[unitIndex].bytecode, nex.bytecode );
 			}
 
-			WR_DUMP_LINK_OUTPUT(printf("function[%d] fixup after:\n%s\n", x, wr_asciiDump(code, code.size(), str)));
-		}
-	}
-
-	// plug in namespace lookups
-	while( namespaceLookups )
-	{
-		wr_pack16( m_units[namespaceLookups->unit].offsetOfLocalHashMap, code.p_str(namespaceLookups->location) );
-		NamespacePush* next = namespaceLookups->next;
-		g_free( namespaceLookups );
-		namespaceLookups = next;
-	}
-
-	// append a CRC
-	uint32_t salted = wr_hash( code, code.size() );
-	salted += WRENCH_VERSION_MAJOR;
-	code.append( wr_pack32(salted, data), 4 );
-
-	WR_DUMP_BYTECODE(printf("bytecode [%d]:\n%s\n", code.size(), wr_asciiDump(code, code.size(), str)));
-
-	if ( !m_err )
-	{
-		*outLen = code.size();
-		code.release( out );
-	}
-}
-
-#endif
-/*******************************************************************************
-Copyright (c) 2024 Curt Hartung -- curt.hartung@gmail.com
-
-MIT Licence
-
-Permission is hereby granted, free of charge, to any person obtaining a copy
-of this software and associated documentation files (the "Software"), to deal
-in the Software without restriction, including without limitation the rights
-to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
-copies of the Software, and to permit persons to whom the Software is
-furnished to do so, subject to the following conditions:
-
-The above copyright notice and this permission notice shall be included in all
-copies or substantial portions of the Software.
-
-THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
-IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
-FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
-AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
-LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
-OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
-SOFTWARE.
-*******************************************************************************/
-
-#include "wrench.h"
-#ifndef WRENCH_WITHOUT_COMPILER
-#include <assert.h>
-
-//------------------------------------------------------------------------------
-char WRCompilationContext::parseExpression( WRExpression& expression )
-{
-	int depth = 0;
-	char end = 0;
-
-	m_newHashValue = 0;
-
-	for(;;)
-	{
-		WRValue& value = expression.context[depth].value;
-		WRstr& token = expression.context[depth].token;
-
-		expression.context[depth].bytecode.clear();
-		expression.context[depth].setLocalSpace( expression.bytecode.localSpace, expression.bytecode.isStructSpace );
-		if ( !getToken(expression.context[depth]) )
-		{
-			return 0;
+			pushDebug( WRD_LineNumber, m_units[m_unitTop].bytecode, getSourcePosition() );
+			pushOpcode( m_units[unitIndex].bytecode, opcodeToReturn );
 		}
-
-		if ( value.type != WR_REF )
+		else if ( !m_quoted && token == "struct" )
 		{
-			if ( (depth > 0) 
-				 && ((expression.context[depth - 1].type == EXTYPE_LABEL) 
-					 || (expression.context[depth - 1].type == EXTYPE_LITERAL)) )
+			if ( unitIndex != 0 )
 			{
-				// two labels/literals cannot follow each other
-				m_err = WR_ERR_bad_expression;
-				return 0;
+				m_err = WR_ERR_statement_expected;
+				return false;
 			}
 
-			// it's a literal
-			expression.context[depth].type = EXTYPE_LITERAL;
-			if ( (uint8_t)value.type == WR_COMPILER_LITERAL_STRING )
+			if ( !parseUnit(true, unitIndex) )
 			{
-				expression.context[depth].literalString = *(WRstr*)value.p;
+				return false;
 			}
-			
-			++depth;
-			continue;
 		}
-
-		if ( token == ";" || token == ")" || token == "}" || token == "," || token == "]" || token == ":" )
+		else if ( !m_quoted && (token == "function" || token == "unit") )
 		{
-			end = token[0];
-			break;
+			if ( unitIndex != 0 )
+			{
+				m_err = WR_ERR_statement_expected;
+				return false;
+			}
+			
+			if ( !parseUnit(false, unitIndex) )
+			{
+				return false;
+			}
 		}
-
-		pushDebug( WRD_LineNumber, expression.bytecode, getSourcePosition() );
-		
-		if ( token == "var" )
+		else if ( !m_quoted && token == "if" )
 		{
-			expression.context[depth].varSeen = true;
-			continue;
+			if ( !parseIf(returnCalled, opcodeToReturn) )
+			{
+				return false;
+			}
 		}
-		else if ( token == "{" )
+		else if ( !m_quoted && token == "while" )
 		{
-			depth = parseInitializer( expression, depth ) + 1;
-			if ( depth == 0 )
+			if ( !parseWhile(returnCalled, opcodeToReturn) )
 			{
 				return false;
 			}
-
-			continue;
 		}
-		
-		if ( operatorFound(token, expression.context, depth) )
+		else if ( !m_quoted && token == "for" )
 		{
-			++depth;
+			if ( !parseForLoop(returnCalled, opcodeToReturn) )
+			{
+				return false;
+			}
+		}
+		else if ( !m_quoted && token == "enum" )
+		{
+			if ( !parseEnum(unitIndex) )
+			{
+				return false;
+			}
+		}
+		else if ( !m_quoted && token == "export" )
+		{
+			m_exportNextUnit = true;
 			continue;
 		}
-		
-		if ( !m_quoted && token == "new" )
+		else if ( !m_quoted && token == "switch" )
 		{
-			if ( (depth < 2) || 
-				 (expression.context[depth - 1].operation
-				  && expression.context[ depth - 1 ].operation->opcode != O_Assign) )
+			if ( !parseSwitch(returnCalled, opcodeToReturn) )
 			{
-				m_err = WR_ERR_unexpected_token;
-				return 0;
+				return false;
 			}
-
-			if ( (depth < 2) 
-				 || (expression.context[depth - 2].operation
-					 && expression.context[ depth - 2 ].operation->opcode != O_Index) )
+		}
+		else if ( !m_quoted && token == "do" )
+		{
+			if ( !parseDoWhile(returnCalled, opcodeToReturn) )
 			{
-				m_err = WR_ERR_unexpected_token;
-				return 0;
+				return false;
 			}
-			
-			WRstr& token2 = expression.context[depth].token;
-			WRValue& value2 = expression.context[depth].value;
-
-			bool isGlobal;
-			WRstr prefix;
-			bool isLibConstant;
-
-			if ( !getToken(expression.context[depth]) )
+		}
+		else if ( !m_quoted && token == "break" )
+		{
+			if ( !m_breakTargets.count() )
 			{
-				m_err = WR_ERR_bad_expression;
-				return 0;
+				m_err = WR_ERR_break_keyword_not_in_looping_structure;
+				return false;
 			}
 
-			if ( !isValidLabel(token2, isGlobal, prefix, isLibConstant) || isLibConstant )
+			addRelativeJumpSource( m_units[unitIndex].bytecode, O_RelativeJump, *m_breakTargets.tail() );
+		}
+		else if ( !m_quoted && token == "continue" )
+		{
+			if ( !m_continueTargets.count() )
 			{
-				m_err = WR_ERR_bad_expression;
-				return 0;
+				m_err = WR_ERR_continue_keyword_not_in_looping_structure;
+				return false;
 			}
 
-			WRstr functionName = token2;
-			uint32_t hash = wr_hashStr( functionName );
-			
-			if ( !getToken(expression.context[depth]) )
+			addRelativeJumpSource( m_units[unitIndex].bytecode, O_RelativeJump, *m_continueTargets.tail() );
+		}
+		else if ( !m_quoted && token == "goto" )
+		{
+			if ( !getToken(ex) ) // if we run out of tokens that's fine as long as we were not waiting for a }
 			{
-				m_err = WR_ERR_bad_expression;
-				return 0;
+				m_err = WR_ERR_unexpected_EOF;
+				return false;
 			}
 
-			if ( !m_quoted && token2 == ";" )
+			bool isGlobal;
+			WRstr prefix;
+			bool isLibConstant;
+			if ( !isValidLabel(token, isGlobal, prefix, isLibConstant) || isGlobal || isLibConstant )
 			{
-				if ( !parseCallFunction(expression, functionName, depth, false) )
-				{
-					return 0;
-				}
-
-				m_loadedToken = ";";
-				m_loadedValue.p2 = INIT_AS_REF;
-				m_loadedQuoted = m_quoted;
+				m_err = WR_ERR_bad_goto_label;
+				return false;
 			}
-			else if ( !m_quoted && token2 == "(" )
-			{
-				if ( !parseCallFunction(expression, functionName, depth, true) )
-				{
-					return 0;
-				}
 
-				if ( !getToken(expression.context[depth]) )
-				{
-					m_err = WR_ERR_unexpected_EOF;
-					return 0;
-				}
+			GotoSource& G = m_units[unitIndex].bytecode.gotoSource.append();
+			G.hash = wr_hashStr( token );
+			G.offset = m_units[unitIndex].bytecode.all.size();
+			pushData( m_units[unitIndex].bytecode, "\0\0\0\0\0", m_farJumps ? 5 : 3 );
 
-				if ( token2 != "{" )
-				{
-					m_loadedToken = token2;
-					m_loadedValue = value2;
-					m_loadedQuoted = m_quoted;
-				}
+			if ( !getToken(ex, ";"))
+			{
+				m_err = WR_ERR_unexpected_token;
+				return false;
 			}
-			else if (!m_quoted && token2 == "{")
+		}
+/*
+		else if ( !m_quoted && token == "var" )
+		{
+			if ( !getToken(ex) ) // if we run out of tokens that's fine as long as we were not waiting for a }
 			{
-				if ( !parseCallFunction(expression, functionName, depth, false) )
-				{
-					return 0;
-				}
-				token2 = "{";
+				m_err = WR_ERR_unexpected_EOF;
+				return false;
 			}
-			else if ( !m_quoted && token2 == "[" )
+
+			bool isGlobal;
+			WRstr prefix;
+			bool isLibConstant;
+			if ( !isValidLabel(token, isGlobal, prefix, isLibConstant) || isLibConstant )
 			{
-				// must be "array" directive
-				if ( !getToken(expression.context[depth], "]") )
+				m_err = WR_ERR_bad_goto_label;
+				return false;
+			}
+			
+			varSeen = true;
+			goto parseAsVar;
+		}
+		else
+		{
+parseAsVar:
+*/
+		else
+		{
+			WRExpression nex( m_units[unitIndex].bytecode.localSpace, m_units[unitIndex].bytecode.isStructSpace );
+			nex.context[0].varSeen = varSeen;
+			nex.context[0].token = token;
+			nex.context[0].value = ex.value;
+			nex.lValue = true;
+			m_loadedToken = token;
+			m_loadedValue = ex.value;
+			m_loadedQuoted = m_quoted;
+			if ( parseExpression(nex) != ';' )
+			{
+				if ( !m_err )
 				{
 					m_err = WR_ERR_unexpected_token;
-					return 0;
 				}
+				return false;
+			}
 
-				expression.context.remove( depth - 1, 1 ); // knock off the equate
-				depth--;
+			appendBytecode( m_units[unitIndex].bytecode, nex.bytecode );
+			pushOpcode( m_units[unitIndex].bytecode, O_PopOne );
+		}
 
-				WRstr& token3 = expression.context[depth].token;
-				WRValue& value3 = expression.context[depth].value;
+		if ( end == ';' ) // single statement
+		{
+			break;
+		}
+	}
 
-				if ( !getToken(expression.context[depth], "{") )
+	return m_err ? false : true;
+}
+
+//------------------------------------------------------------------------------
+bool WRCompilationContext::checkAsComment( char lead )
+{
+	char c;
+	if ( lead == '/' )
+	{
+		if ( !getChar(c) )
+		{
+			m_err = WR_ERR_unexpected_EOF;
+			return false;
+		}
+
+		if ( c == '/' )
+		{
+			while( getChar(c) && c != '\n' );
+			return true;
+		}
+		else if ( c == '*' )
+		{
+			for(;;)
+			{
+				if ( !getChar(c) )
 				{
-					m_err = WR_ERR_unexpected_token;
-					return 0;
+					m_err = WR_ERR_unexpected_EOF;
+					return false;
 				}
 
-				uint16_t initializer = 0;
-
-				if ( !m_quoted && token3 == "{" )
+				if ( c == '*' )
 				{
-					for(;;)
+					if ( !getChar(c) )
 					{
-						if ( !getToken(expression.context[depth]) )
-						{
-							m_err = WR_ERR_unexpected_EOF;
-							return 0;
-						}
-
-						if ( !m_quoted && token3 == "}" )
-						{
-							break;
-						}
+						m_err = WR_ERR_unexpected_EOF;
+						return false;
+					}
 
-						if ( !parseCallFunction(expression, functionName, depth, false) )
-						{
-							return 0;
-						}
+					if ( c == '/' )
+					{
+						break;
+					}
+				}
+			}
 
-						if (!m_quoted && token3 != "{")
-						{
-							m_err = WR_ERR_unexpected_token;
-							return 0;
-						}
+			return true;
+		}
 
-						if ( !pushObjectTable(expression.context[depth], expression.bytecode.localSpace, hash) )
-						{
-							m_err = WR_ERR_bad_expression;
-							return 0;
-						}
+		// else not a comment
+	}
 
-						pushOpcode( expression.context[depth].bytecode, O_AssignToArrayAndPop );
+	return false;
+}
 
-						unsigned char data[2];
-						wr_pack16( initializer, data );
-						++initializer;
-
-						pushData( expression.context[depth].bytecode, data, 2 );
-
-						if ( !getToken(expression.context[depth]) )
-						{
-							m_err = WR_ERR_unexpected_EOF;
-							return 0;
-						}
-
-						if ( !m_quoted && token3 == "," )
-						{
-							continue;
-						}
-						else if ( token3 != "}" )
-						{
-							m_err = WR_ERR_unexpected_token;
-							return 0;
-						}
-						else
-						{
-							break;
-						}
-					}
-					
-					if ( !getToken(expression.context[depth], ";") )
-					{
-						m_err = WR_ERR_unexpected_token;
-						return 0;
-					}
-
-					WRstr t("@init");
-					for( int o=0; c_operations[o].token; o++ )
-					{
-						if ( t == c_operations[o].token )
-						{
-							expression.context[depth].type = EXTYPE_OPERATION;
-							expression.context[depth].operation = c_operations + o;
-							break;
-						}
-					}
-
-					m_loadedToken = token3;
-					m_loadedValue = value3;
-					m_loadedQuoted = m_quoted;
-				}
-				else if ( token2 != ";" )
-				{
-					m_err = WR_ERR_unexpected_token;
-					return 0;
-				}
-
-				++depth;
-				continue;
-			}
-			else if ( token2 != "{" )
-			{
-				m_err = WR_ERR_bad_expression;
-				return 0;
-			}
+//------------------------------------------------------------------------------
+bool WRCompilationContext::readCurlyBlock( WRstr& block )
+{
+	char c;
+	int closesNeeded = 0;
 
-			if ( !pushObjectTable(expression.context[depth], expression.bytecode.localSpace, hash) )
-			{
-				m_err = WR_ERR_bad_expression;
-				return 0;
-			}
+	for(;;)
+	{
+		if ( !getChar(c) )
+		{
+			m_err = WR_ERR_unexpected_EOF;
+			return false;
+		}
 
-			++depth;
+		// read past comments
+		if ( checkAsComment(c) )
+		{
 			continue;
 		}
 
-		if ( !m_quoted && token == "(" )
+		if ( m_err )
 		{
-			// might be cast, call or sub-expression
-			
-			if ( (depth > 0) &&
-				 (expression.context[depth - 1].type == EXTYPE_LABEL
-				 || expression.context[depth - 1].type == EXTYPE_LIB_CONSTANT) )
-			{
-				// always only a call
-				expression.context[depth - 1].type = EXTYPE_LABEL;
-				
-				--depth;
-				if ( !parseCallFunction(expression, expression.context[depth].token, depth, true) )
-				{
-					return 0;
-				}
-			}
-			else if ( !getToken(expression.context[depth]) )
-			{
-				m_err = WR_ERR_unexpected_EOF;
-				return 0;
-			}
-			else if ( token == "int" )
-			{
-				if ( !getToken(expression.context[depth], ")") )
-				{
-					m_err = WR_ERR_bad_expression;
-					return 0;
-				}
+			return false;
+		}
 
-				operatorFound( WRstr("@i"), expression.context, depth );
-			}
-			else if ( token == "float" )
+		block += c;
+		
+		if ( c == '{' )
+		{
+			++closesNeeded;
+		}
+		
+		if ( c == '}' )
+		{
+			if ( closesNeeded == 0 )
 			{
-				if ( !getToken(expression.context[depth], ")") )
-				{
-					m_err = WR_ERR_bad_expression;
-					return 0;
-				}
-
-				operatorFound( WRstr("@f"), expression.context, depth );
+				m_err = WR_ERR_unexpected_token;
+				return false;
 			}
-			else if (depth < 0)
+			
+			if ( !--closesNeeded )
 			{
-				m_err = WR_ERR_bad_expression;
-				return 0;
+				break;
 			}
-			else
-			{
-				WRExpression nex( expression.bytecode.localSpace, expression.bytecode.isStructSpace );
-				nex.context[0].token = token;
-				nex.context[0].value = value;
-				m_loadedToken = token;
-				m_loadedValue = value;
-				m_loadedQuoted = m_quoted;
-				if ( parseExpression(nex) != ')' )
-				{
-					m_err = WR_ERR_unexpected_token;
-					return 0;
-				}
+		}
+	}
 
+	return true;
+}
 
-				if ( depth > 0 && expression.context[depth - 1].operation
-					 && expression.context[depth - 1].operation->opcode == O_Remove )
-				{
-					--depth;
-					expression.context[depth].bytecode = nex.bytecode;
-					operatorFound( WRstr("._remove"), expression.context, depth );
-				}
-				else if ( depth > 0 && expression.context[depth - 1].operation
-						  && expression.context[depth - 1].operation->opcode == O_HashEntryExists )
-				{
-					--depth;
-					expression.context[depth].bytecode = nex.bytecode;
-					operatorFound( WRstr("._exists"), expression.context, depth );
-				}
-				else
-				{
-					expression.context[depth].type = EXTYPE_BYTECODE_RESULT;
-					expression.context[depth].bytecode = nex.bytecode;
-				}
-			}
 
-			++depth;
-			continue;
-		}
+#else // WRENCH_WITHOUT_COMPILER
 
-		if ( !m_quoted && token == "[" )
-		{
-			WRExpression nex( expression.bytecode.localSpace, expression.bytecode.isStructSpace );
-			nex.context[0].token = token;
-			nex.context[0].value = value;
+WRError wr_compile( const char* source,
+					const int size,
+					unsigned char** out,
+					int* outLen,
+					char* errMsg,
+					const uint8_t compilerOptionFlags )
+{
+	return WR_ERR_compiler_not_loaded;
+}
 
-			if ( parseExpression(nex) != ']' )
-			{
-				m_err = WR_ERR_unexpected_EOF;
-				return 0;
-			}
+//------------------------------------------------------------------------------
+unsigned int wr_compilerPeakMemory()
+{
+	return 0;
+}
+	
+#endif
+/*******************************************************************************
+Copyright (c) 2024 Curt Hartung -- curt.hartung@gmail.com
 
-			if ( nex.bytecode.all.size() == 0 )
-			{
-				operatorFound( WRstr("@[]"), expression.context, depth );
-				expression.context[depth].bytecode.all.clear();
-				expression.context[depth].bytecode.opcodes.clear();
-				pushOpcode( expression.context[depth].bytecode, O_LiteralZero );
-				pushOpcode( expression.context[depth].bytecode, O_InitArray );
-			}
-			else 
-			{
-				expression.context[depth].bytecode = nex.bytecode;
-				operatorFound( WRstr("@[]"), expression.context, depth );
-			}
+MIT Licence
 
-			++depth;
-			continue;
-		}
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
 
-		bool isGlobal;
-		WRstr prefix;
-		bool isLibConstant;
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
 
-		if ( isValidLabel(token, isGlobal, prefix, isLibConstant) )
-		{
-			if ( (depth > 0) 
-				&& ((expression.context[depth - 1].type == EXTYPE_LABEL) 
-					|| (expression.context[depth - 1].type == EXTYPE_LITERAL)
-					|| (expression.context[depth - 1].type == EXTYPE_LIB_CONSTANT)) )
-			{
-				// two labels/literals cannot follow each other
-				m_err = WR_ERR_bad_expression;
-				return 0;
-			}
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*******************************************************************************/
 
-			WRstr label = token;
+#include "wrench.h"
+#ifndef WRENCH_WITHOUT_COMPILER
+#include <assert.h>
 
-			if ( depth == 0 && !m_parsingFor )
-			{
-				if ( !getToken(expression.context[depth]) )
-				{
-					m_err = WR_ERR_unexpected_EOF;
-					return 0;
-				}
+#define WR_DUMP_LINK_OUTPUT(D) //D
+#define WR_DUMP_UNIT_OUTPUT(D) //D
+#define WR_DUMP_BYTECODE(D) //D
+//WRstr str;
 
-				if ( m_parsingNew )
-				{
-					if ( token == "=" )
-					{
-						m_newHashValue = wr_hashStr( label );
+//------------------------------------------------------------------------------
+void WRCompilationContext::createLocalHashMap( WRUnitContext& unit, unsigned char** buf, int* size )
+{
+	if ( unit.bytecode.localSpace.count() == 0 )
+	{
+		*size = 0;
+		*buf = 0;
+		return;
+	}
 
-						continue;
-//						getToken(expression.context[depth]) );
-//						--depth;
-						
-					}
-				}
-				
-				if ( !m_quoted && token == ":" )
-				{
-					uint32_t hash = wr_hashStr( label );
-					for( unsigned int i=0; i<expression.bytecode.jumpOffsetTargets.count(); ++i )
-					{
-						if ( expression.bytecode.jumpOffsetTargets[i].gotoHash == hash )
-						{
-							m_err = WR_ERR_bad_goto_label;
-							return false;
-						}
-					}
-					
-					int index = addRelativeJumpTarget( expression.bytecode );
-					expression.bytecode.jumpOffsetTargets[index].gotoHash = hash;
-					expression.bytecode.jumpOffsetTargets[index].offset = expression.bytecode.all.size() + 1;
+	WRHashTable<unsigned char> offsets;
+	for( unsigned char i=unit.arguments; i<unit.bytecode.localSpace.count(); ++i )
+	{
+		offsets.set( unit.bytecode.localSpace[i].hash, i - unit.arguments );
+	}
 
-					// this always return a value
-					pushOpcode( expression.bytecode, O_LiteralZero );
+	*buf = (unsigned char *)wr_arenaMalloc( (offsets.m_mod * 5) + 4 );
 
-					
-					return ';';
-				}
-				else
-				{
-					m_loadedToken = token;
-					m_loadedValue = value;
-					m_loadedQuoted = m_quoted;
-				}
-			}
-			
+	(*buf)[0] = (unsigned char)(unit.bytecode.localSpace.count() - unit.arguments);
+	(*buf)[1] = unit.arguments;
 
-			expression.context[depth].type = isLibConstant ? EXTYPE_LIB_CONSTANT : EXTYPE_LABEL;
-			expression.context[depth].token = label;
-			expression.context[depth].global = isGlobal;
-			expression.context[depth].prefix = prefix;
-			++depth;
+	wr_pack16( offsets.m_mod, *buf + 2 );
 
-			continue;
-		}
+	*size = 4;
 
-		m_err = WR_ERR_bad_expression;
-		return 0;
+	for( int i=0; i<offsets.m_mod; ++i )
+	{
+		wr_pack32( offsets.m_list[i].hash, *buf + *size );
+		*size += 4;
+		(*buf)[(*size)++] = offsets.m_list[i].hash ? offsets.m_list[i].value : (unsigned char)-1;
 	}
+}
 
-	expression.context.setCount( expression.context.count() - 1 );
+//------------------------------------------------------------------------------
+void WRCompilationContext::link( unsigned char** out, int* outLen, const uint8_t compilerOptionFlags )
+{
+	WROpcodeStream code;
 
-	if ( depth == 2
-		 && expression.lValue
-		 && expression.context[0].type == EXTYPE_LABEL
-		 && expression.context[1].type == EXTYPE_OPERATION
-		 && expression.context[1].operation->opcode == O_Index
-		 && expression.context[1].bytecode.opcodes.size() > 0 )
+	uint8_t data[4];
+
+	NamespacePush *namespaceLookups = 0;
+
+	unsigned int globals = m_units[0].bytecode.localSpace.count();
+	assert( globals < 256 );
+
+	code += (uint8_t)globals; // globals count (for VM allocation)
+	code += (uint8_t)(m_units.count() - 1); // function count (for VM allocation)
+	code += (uint8_t)compilerOptionFlags;
+
+	// export any explicitly marked for export or are referred to by a 'new'
+	for( unsigned int ux=0; ux<m_units.count(); ++ux )
 	{
-		unsigned int i = expression.context[1].bytecode.opcodes.size() - 1;
-		unsigned int a = expression.context[1].bytecode.all.size() - 1;
-		WROpcode o = (WROpcode)(expression.context[1].bytecode.opcodes[ i ]);
-		
-		switch( o )
+		for( unsigned int f=0; f<m_units[ux].bytecode.unitObjectSpace.count(); ++f )
 		{
-			case O_Index:
-			{
-				expression.context[1].bytecode.all[a] = O_InitArray;
-				break;
-			}
+			WRNamespaceLookup& N = m_units[ux].bytecode.unitObjectSpace[f];
 
-			case O_IndexLiteral16:
+			for( unsigned int r=0; r<N.references.count(); ++r )
 			{
-				if (a > 1)
+				for( unsigned int u2 = 1; u2<m_units.count(); ++u2 )
 				{
-					expression.context[1].bytecode.all[a - 2] = O_LiteralInt16;
-					pushOpcode(expression.context[1].bytecode, O_InitArray);
+					if ( m_units[u2].hash == N.hash )
+					{
+						m_units[u2].exportNamespace = true;
+						break;
+					}
 				}
-				break;
 			}
-			
-			case O_IndexLiteral8:
+		}
+	}
+
+	// settle the code of every unit before the frame sizes are written
+	for( unsigned int u=0; u<m_units.count(); ++u )
+	{
+		// fill relative jumps in for the goto's
+		for( unsigned int g=0; g<m_units[u].bytecode.gotoSource.count(); ++g )
+		{
+			unsigned int j=0;
+			for( ; j<m_units[u].bytecode.jumpOffsetTargets.count(); j++ )
 			{
-				if (a > 0)
+				if ( m_units[u].bytecode.jumpOffsetTargets[j].gotoHash == m_units[u].bytecode.gotoSource[g].hash )
 				{
-					expression.context[1].bytecode.all[a - 1] = O_LiteralInt8;
-					pushOpcode(expression.context[1].bytecode, O_InitArray);
+					int diff = m_units[u].bytecode.jumpOffsetTargets[j].offset - m_units[u].bytecode.gotoSource[g].offset;
+					diff -= 2;
+					if ( m_farJumps )
+					{
+						*m_units[u].bytecode.all.p_str( m_units[u].bytecode.gotoSource[g].offset ) = (unsigned char)O_RelativeJump32;
+						wr_pack32( diff, m_units[u].bytecode.all.p_str(m_units[u].bytecode.gotoSource[g].offset + 1) );
+					}
+					else if ( (diff < 128) && (diff > -129) )
+					{
+						*m_units[u].bytecode.all.p_str( m_units[u].bytecode.gotoSource[g].offset ) = (unsigned char)O_RelativeJump8;
+						*m_units[u].bytecode.all.p_str( m_units[u].bytecode.gotoSource[g].offset + 1 ) = diff;
+					}
+					else
+					{
+						m_jumpOutOfRange = m_jumpOutOfRange || diff > 0x7FFF || diff < -0x8000;
+						*m_units[u].bytecode.all.p_str( m_units[u].bytecode.gotoSource[g].offset ) = (unsigned char)O_RelativeJump;
+						wr_pack16( diff, m_units[u].bytecode.all.p_str(m_units[u].bytecode.gotoSource[g].offset + 1) );
+					}
+
+					break;
 				}
-				break;
 			}
 
-			default: break;
+			if ( j >= m_units[u].bytecode.jumpOffsetTargets.count() )
+			{
+				m_err = WR_ERR_goto_target_not_found;
+				return;
+			}
 		}
 	}
 
-	resolveExpression( expression );
+	if ( m_jumpOutOfRange )
+	{
+		return; // wr_compile() goes again with m_farJumps
+	}
 
-	return end;
-}
+	if ( m_optimize )
+	{
+		// functions that call nothing first, what is inlined into the
+		// others has been optimized already
+		for( int pass=0; pass<2; ++pass )
+		{
+			for( unsigned int u=1; u<m_units.count(); ++u )
+			{
+				if ( (m_units[u].bytecode.functionSpace.count() == 0) == (pass == 0) )
+				{
+					optimizeUnit( m_units[u], pass == 1, WR_OPT_LOOP_PASSES );
+				}
+			}
+		}
+	}
 
-#endif
-/*******************************************************************************
-Copyright (c) 2024 Curt Hartung -- curt.hartung@gmail.com
+	// push function signatures
+	for( unsigned int u=1; u<m_units.count(); ++u )
+	{
+		m_units[u].offsetInBytecode = code.size(); // mark these two spots for later
 
-MIT Licence
+		// WRFunction.namespaceOffset
+		data[0] = 0xAA;
+		data[1] = 0xBB;
+		code.append( data, 2 ); // placeholder
 
-Permission is hereby granted, free of charge, to any person obtaining a copy
-of this software and associated documentation files (the "Software"), to deal
-in the Software without restriction, including without limitation the rights
-to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
-copies of the Software, and to permit persons to whom the Software is
-furnished to do so, subject to the following conditions:
+		// WRFunction.functionOffset
+		data[0] = 0xCC;
+		data[1] = 0xDD;
+		code.append( data, 2 ); // placeholder
 
-The above copyright notice and this permission notice shall be included in all
-copies or substantial portions of the Software.
+		// WRFunction.hash
+		code.append( wr_pack32(m_units[u].hash, data), 4 );
 
-THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
-IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
-FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
-AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
-LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
-OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
-SOFTWARE.
-*******************************************************************************/
+		// WRFunction.arguments;
+		data[0] = m_units[u].arguments;
+		code.append( data, 1 );
 
-#include "wrench.h"
-#ifndef WRENCH_WITHOUT_COMPILER
+		// WRFunction.frameSpaceNeeded;
+		data[1] = m_units[u].bytecode.localSpace.count();
+		code.append( data + 1, 1 );
 
-#define KEYHOLE_OPTIMIZER
+		// WRFunction.frameBaseAdjustment;
+		data[2] = 1 + data[0] + data[1];
+		code.append( data + 2, 1 );
+	}
 
-//------------------------------------------------------------------------------
-bool WRCompilationContext::CheckSkipLoad( WROpcode opcode, WRBytecode& bytecode, int a, int o )
-{
-	if ( bytecode.opcodes[o] == O_LoadFromLocal
-		 && bytecode.opcodes[o-1] == O_LoadFromLocal )
+	m_units[0].name = "::global";
+
+	if ( compilerOptionFlags & WR_INCLUDE_GLOBALS )
 	{
-		bytecode.all[a-3] = O_LLValues;
-		bytecode.all[a-1] = bytecode.all[a];
-		bytecode.all[a] = opcode;
-		bytecode.opcodes.shave(2);
-		bytecode.opcodes += opcode;
-		return true;
-	}
-	else if ( bytecode.opcodes[o] == O_LoadFromGlobal
-			  && bytecode.opcodes[o-1] == O_LoadFromLocal )
-	{
-		bytecode.all[a-3] = O_LGValues;
-		bytecode.all[a-1] = bytecode.all[a];
-		bytecode.all[a] = opcode;
-		bytecode.opcodes.shave(2);
-		bytecode.opcodes += opcode;
-		return true;
-	}
-	else if ( bytecode.opcodes[o] == O_LoadFromLocal
-			  && bytecode.opcodes[o-1] == O_LoadFromGlobal )
-	{
-		bytecode.all[a-3] = O_GLValues;
-		bytecode.all[a-1] = bytecode.all[a];
-		bytecode.all[a] = opcode;
-		bytecode.opcodes.shave(2);
-		bytecode.opcodes += opcode;
-		return true;
-	}
-	else if ( bytecode.opcodes[o] == O_LoadFromGlobal
-			  && bytecode.opcodes[o-1] == O_LoadFromGlobal )
-	{
-		bytecode.all[a-3] = O_GGValues;
-		bytecode.all[a-1] = bytecode.all[a];
-		bytecode.all[a] = opcode;
-		bytecode.opcodes.shave(2);
-		bytecode.opcodes += opcode;
-		return true;
-	}
-
-	return false;
-}
-
-//------------------------------------------------------------------------------
-bool WRCompilationContext::CheckFastLoad( WROpcode opcode, WRBytecode& bytecode, int a, int o )
-{
-	if ( a <= 2 || o == 0 )
-	{
-		return false;
+		for( unsigned int i=0; i<globals; ++i )
+		{
+			code.append( wr_pack32(m_units[0].bytecode.localSpace[i].hash, data), 4 );
+		}
 	}
 
-	if ( (opcode == O_Index && CheckSkipLoad(O_IndexSkipLoad, bytecode, a, o))
-		 || (opcode == O_BinaryMod && CheckSkipLoad(O_BinaryModSkipLoad, bytecode, a, o)) 
-		 || (opcode == O_BinaryRightShift && CheckSkipLoad(O_BinaryRightShiftSkipLoad, bytecode, a, o))
-		 || (opcode == O_BinaryLeftShift && CheckSkipLoad(O_BinaryLeftShiftSkipLoad, bytecode, a, o)) 
-		 || (opcode == O_BinaryAnd && CheckSkipLoad(O_BinaryAndSkipLoad, bytecode, a, o)) 
-		 || (opcode == O_BinaryOr && CheckSkipLoad(O_BinaryOrSkipLoad, bytecode, a, o)) 
-		 || (opcode == O_BinaryXOR && CheckSkipLoad(O_BinaryXORSkipLoad, bytecode, a, o)) )
+	if ( (compilerOptionFlags & WR_EMBED_DEBUG_CODE)
+		 || (compilerOptionFlags & WR_EMBED_SOURCE_CODE) )
 	{
-		return true;
-	}
+		// hash of source compiled for this
+		code.append( wr_pack32(wr_hash(m_source, m_sourceLen), data), 4 ); 
 
-	return false;
-}
+		WRstr symbols;
 
-//------------------------------------------------------------------------------
-bool WRCompilationContext::IsLiteralLoadOpcode( unsigned char opcode )
-{
-	return opcode == O_LiteralInt32
-			|| opcode == O_LiteralZero
-			|| opcode == O_LiteralFloat
-			|| opcode == O_LiteralInt8
-			|| opcode == O_LiteralInt16;
-}
+		uint16_t functions = m_units.count();
+		symbols.append( (char*)wr_pack16(functions, data), 2 );
 
-//------------------------------------------------------------------------------
-bool WRCompilationContext::CheckCompareReplace( WROpcode LS, WROpcode GS, WROpcode ILS, WROpcode IGS, WRBytecode& bytecode, unsigned int a, unsigned int o )
-{
-	if ( IsLiteralLoadOpcode(bytecode.opcodes[o-1]) )
-	{
-		if ( bytecode.opcodes[o] == O_LoadFromGlobal )
-		{
-			bytecode.all[ a - 1 ] = GS;
-			bytecode.opcodes[o] = GS;
-			return true;
-		}
-		else if ( bytecode.opcodes[o] == O_LoadFromLocal )
+		data[0] = 0; // terminator
+		for( unsigned int u=0; u<m_units.count(); ++u ) // all the local labels by unit
 		{
-			bytecode.all[ a - 1 ] = LS;
-			bytecode.opcodes[o] = LS;
-			return true;
+			data[1] = m_units[u].bytecode.localSpace.count();
+			data[2] = m_units[u].arguments;
+			symbols.append( (char *)(data + 1), 2 );
+
+			symbols.append( m_units[u].name );
+			symbols.append( (char *)data, 1 ); 
+
+			for( unsigned int s=0; s<m_units[u].bytecode.localSpace.count(); ++s )
+			{
+				symbols.append( m_units[u].bytecode.localSpace[s].label );
+				symbols.append( (char *)data, 1 ); 
+			}
 		}
+
+		uint16_t symbolSize = symbols.size();
+		code.append( wr_pack16(symbolSize, data), 2 );
+		code.append( (uint8_t*)symbols.p_str(), symbols.size() );
 	}
-	else if ( IsLiteralLoadOpcode(bytecode.opcodes[o]) )
+
+	if ( compilerOptionFlags & WR_EMBED_SOURCE_CODE )
 	{
-		if ( (bytecode.opcodes[o] == O_LiteralInt32 || bytecode.opcodes[o] == O_LiteralFloat)
-			 && bytecode.opcodes[o-1] == O_LoadFromGlobal )
-		{
-			bytecode.all[ a - 6 ] = bytecode.all[ a ]; // store i3
-			bytecode.all[ a ] = bytecode.all[ a - 5 ]; // move index
+		code.append( wr_pack32(m_sourceLen, data), 4 );
+		code.append( (uint8_t*)m_source, m_sourceLen );
+	}
 
-			bytecode.all[ a - 5 ] = bytecode.all[ a - 3 ];
-			bytecode.all[ a - 4 ] = bytecode.all[ a - 2 ];
-			bytecode.all[ a - 3 ] = bytecode.all[ a - 1 ];
-			bytecode.all[ a - 2 ] = bytecode.all[ a - 6 ];
-			bytecode.all[ a - 6 ] = bytecode.opcodes[o];
-			bytecode.all[ a - 1 ] = IGS;
+	WR_DUMP_LINK_OUTPUT(printf("header funcs[%d] locals[%d] flags[0x%02X]:\n%s\n",
+							   (unsigned char)(m_units.count() - 1),
+							   (unsigned char)(m_units[0].bytecode.localSpace.count()),
+							   (unsigned char)compilerOptionFlags, wr_asciiDump( code.p_str(), code.size(), str )));
 
-			bytecode.opcodes[o] = IGS; // reverse the logic
+	// append all the unit code
+	for( unsigned int u=0; u<m_units.count(); ++u )
+	{
+		uint16_t base;
 
-			return true;
-		}
-		else if ( bytecode.opcodes[o] == O_LiteralZero
-				  && bytecode.opcodes[o-1] == O_LoadFromGlobal )
-		{
-			bytecode.all[ a - 2 ] = O_LiteralZero;
-			bytecode.all[ a ] = bytecode.all[ a - 1];
-			bytecode.all[ a - 1 ] = IGS;
-			bytecode.opcodes[o] = IGS; // reverse the logic
-			return true;
-		}
-		else if ( bytecode.opcodes[o] == O_LiteralZero
-				  && bytecode.opcodes[o-1] == O_LoadFromGlobal )
-		{
-			bytecode.all[ a - 2 ] = O_LiteralZero;
-			bytecode.all[ a ] = bytecode.all[ a - 1];
-			bytecode.all[ a - 1 ] = IGS;
-			bytecode.opcodes[o] = IGS; // reverse the logic
-			return true;
-		}
-		else if ( bytecode.opcodes[o] == O_LiteralInt8
-				  && bytecode.opcodes[o-1] == O_LoadFromGlobal )
+		if ( u > 0 ) // for the non-zero unit fill locations into the jump table
 		{
-			bytecode.all[ a - 1 ] = bytecode.all[ a - 2 ];
-			bytecode.all[ a - 2 ] = bytecode.all[ a ];
-			bytecode.all[ a ] = bytecode.all[ a - 1 ];
-			bytecode.all[ a - 1 ] = IGS;
-			bytecode.all[ a - 3 ] = O_LiteralInt8;
+			if ( m_units[u].exportNamespace )
+			{
+				base = code.size();
 
-			bytecode.opcodes[o] = IGS; // reverse the logic
-			return true;
-		}
-		else if ( bytecode.opcodes[o] == O_LiteralInt16
-				  && bytecode.opcodes[o-1] == O_LoadFromGlobal )
-		{
-			bytecode.all[ a - 2 ] = bytecode.all[ a ];
+				int size = 0;
+				uint8_t* map = 0;
+				createLocalHashMap( m_units[u], &map, &size );
+				
+				if ( size == 0 )
+				{
+					base = 0;
+				}
+				m_units[u].offsetOfLocalHashMap = base;
 
-			bytecode.all[ a - 4 ] = bytecode.all[ a - 3 ];
-			bytecode.all[ a - 3 ] = bytecode.all[ a - 1 ];
-			bytecode.all[ a ] = bytecode.all[ a - 4 ];
-			bytecode.all[ a - 1 ] = IGS;
-			bytecode.all[ a - 4 ] = O_LiteralInt16;
+				wr_pack16( base, code.p_str(m_units[u].offsetInBytecode)); // WRFunction.namespaceOffset
 
-			bytecode.opcodes[o] = IGS; // reverse the logic
-			return true;
-		}
-		if ( (bytecode.opcodes[o] == O_LiteralInt32 || bytecode.opcodes[o] == O_LiteralFloat)
-			 && bytecode.opcodes[o-1] == O_LoadFromLocal )
-		{
-			bytecode.all[ a - 6 ] = bytecode.all[ a ]; // store i3
-			bytecode.all[ a ] = bytecode.all[ a - 5 ]; // move index
+				WR_DUMP_LINK_OUTPUT(printf("<new> namespace\n%s\n", wr_asciiDump(map, size, str)));
 
-			bytecode.all[ a - 5 ] = bytecode.all[ a - 3 ];
-			bytecode.all[ a - 4 ] = bytecode.all[ a - 2 ];
-			bytecode.all[ a - 3 ] = bytecode.all[ a - 1 ];
-			bytecode.all[ a - 2 ] = bytecode.all[ a - 6 ];
-			bytecode.all[ a - 6 ] = bytecode.opcodes[o];
-			bytecode.all[ a - 1 ] = ILS;
+				code.append( map, size );
+				wr_arenaFree( map );
+			}
+			else
+			{
+				base = 0;
+				wr_pack16( base, code.p_str(m_units[u].offsetInBytecode) ); // WRFunction.namespaceOffset
+			}
 
-			bytecode.opcodes[o] = ILS; // reverse the logic
+			if ( code.size() > 0xFFFF )
+			{
+				m_err = WR_ERR_compiler_panic; // functions are found by a 16-bit offset
+				break;
+			}
 
-			return true;
-		}
-		else if ( bytecode.opcodes[o] == O_LiteralZero
-				  && bytecode.opcodes[o-1] == O_LoadFromLocal )
-		{
-			bytecode.all[ a - 2 ] = O_LiteralZero;
-			bytecode.all[ a ] = bytecode.all[ a - 1];
-			bytecode.all[ a - 1 ] = ILS;
-			bytecode.opcodes[o] = ILS; // reverse the logic
-			return true;
-		}
-		else if ( bytecode.opcodes[o] == O_LiteralZero
-				  && bytecode.opcodes[o-1] == O_LoadFromLocal )
-		{
-			bytecode.all[ a - 2 ] = O_LiteralZero;
-			bytecode.all[ a ] = bytecode.all[ a - 1];
-			bytecode.all[ a - 1 ] = ILS;
-			bytecode.opcodes[o] = ILS; // reverse the logic
-			return true;
+			base = code.size();
+			wr_pack16( base, code.p_str(m_units[u].offsetInBytecode + 2) ); // WRFunction.functionOffset
 		}
-		else if ( bytecode.opcodes[o] == O_LiteralInt8
-				  && bytecode.opcodes[o-1] == O_LoadFromLocal )
-		{
-			bytecode.all[ a - 1 ] = bytecode.all[ a - 2 ];
-			bytecode.all[ a - 2 ] = bytecode.all[ a ];
-			bytecode.all[ a ] = bytecode.all[ a - 1 ];
-			bytecode.all[ a - 1 ] = ILS;
-			bytecode.all[ a - 3 ] = O_LiteralInt8;
 
-			bytecode.opcodes[o] = ILS; // reverse the logic
-			return true;
-		}
-		else if ( bytecode.opcodes[o] == O_LiteralInt16
-				  && bytecode.opcodes[o-1] == O_LoadFromLocal )
-		{
-			bytecode.all[ a - 2 ] = bytecode.all[ a ];
+		WR_DUMP_UNIT_OUTPUT(printf("unit %d:\n%s\n", u, wr_asciiDump(code, code.size(), str)));
 
-			bytecode.all[ a - 4 ] = bytecode.all[ a - 3 ];
-			bytecode.all[ a - 3 ] = bytecode.all[ a - 1 ];
-			bytecode.all[ a ] = bytecode.all[ a - 4 ];
-			bytecode.all[ a - 1 ] = ILS;
-			bytecode.all[ a - 4 ] = O_LiteralInt16;
+		base = code.size();
 
-			bytecode.opcodes[o] = ILS; // reverse the logic
-			return true;
-		}
-	}
+		WR_DUMP_LINK_OUTPUT(printf("Adding Unit %d [%d]\n%s", u, m_units[u].bytecode.all.size(), wr_asciiDump(m_units[u].bytecode.all, m_units[u].bytecode.all.size(), str)));
 
-	return false;
-}
+		code.append( m_units[u].bytecode.all, m_units[u].bytecode.all.size() );
 
-//------------------------------------------------------------------------------
-void WRCompilationContext::pushOpcode( WRBytecode& bytecode, WROpcode opcode )
-{
-#ifdef KEYHOLE_OPTIMIZER
-	unsigned int o = bytecode.opcodes.size();
-	if ( o )
-	{
-		// keyhole optimizations
+		WR_DUMP_LINK_OUTPUT(printf("->\n%s\n", wr_asciiDump( code.p_str(), code.size(), str )));
 
-		--o;
-		unsigned int a = bytecode.all.size() - 1;
-		if ( opcode == O_Return
-			 && bytecode.opcodes[o] == O_LiteralZero )
+		// populate 'new' vectors
+		for( unsigned int f=0; f<m_units[u].bytecode.unitObjectSpace.count(); ++f )
 		{
-			bytecode.all[a] = O_ReturnZero;
-			bytecode.opcodes[o] = O_ReturnZero;
-			return;
+			WRNamespaceLookup& N = m_units[u].bytecode.unitObjectSpace[f];
+
+			for( unsigned int r=0; r<N.references.count(); ++r )
+			{
+				for( unsigned int u2 = 1; u2<m_units.count(); ++u2 )
+				{
+					if ( m_units[u2].hash == N.hash )
+					{
+						NamespacePush *n = (NamespacePush *)wr_arenaMalloc(sizeof(NamespacePush));
+						n->next = namespaceLookups;
+						namespaceLookups = n;
+						n->unit = u2;
+						n->location = base + N.references[r];
+
+						break;
+					}
+				}
+			}
 		}
-		else if ( opcode == O_CompareEQ && o>0 && bytecode.opcodes[o] == O_LoadFromLocal && bytecode.opcodes[o-1] == O_LoadFromLocal )
+
+		// load function table
+		for( unsigned int x=0; x<m_units[u].bytecode.functionSpace.count(); ++x )
 		{
-			bytecode.all[ a - 3 ] = O_LLCompareEQ;
-			bytecode.all[ a - 1 ] = bytecode.all[ a ];
-			bytecode.all.shave( 1 );
-			bytecode.opcodes.clear();
-			bytecode.opcodes += O_LLCompareEQ;
-			return;
+			WRNamespaceLookup& N = m_units[u].bytecode.functionSpace[x];
+
+			WR_DUMP_LINK_OUTPUT(printf("function[%d] fixup before:\n%s\n", x, wr_asciiDump(code, code.size(), str)));
+
+			for( unsigned int r=0; r<N.references.count(); ++r )
+			{
+				unsigned int u2 = 1;
+				int index = base + N.references[r];
+
+				for( ; u2<m_units.count(); ++u2 )
+				{
+					if ( m_units[u2].hash == N.hash ) // local function! call it, manage preserving retval
+					{
+						if ( m_addDebugSymbols )
+						{
+							// fill in the codeword with internal function number
+							uint16_t codeword = (uint16_t)WRD_FunctionCall | (uint16_t)u2;
+							wr_pack16( codeword, (unsigned char *)code.p_str(index - 2) );
+						}
+
+						code[index] = O_CallFunctionByIndex;
+
+						code[index+2] = (char)(u2 - 1);
+
+						// r+1 = args
+						// r+2345 = hash
+						// r+6
+
+						if ( code[index+5] == O_PopOne || code[index + 6] == O_NewObjectTable)
+						{
+							code[index+3] = 3; // skip past the pop, or TO the NewObjectTable
+						}
+						else 
+						{
+							code[index+3] = 2; // skip by this push is seen
+							code[index+5] = O_PushIndexFunctionReturnValue;
+						}
+
+						break;
+					}
+				}
+
+				if ( u2 >= m_units.count() ) // no local function found, rely on it being found run-time
+				{
+					if ( N.hash == wr_hashStr("yield") )
+					{
+						code[index] = O_Yield;
+					}
+					else
+					{
+						if ( code[index+5] == O_PopOne )
+						{
+							code[index] = O_CallFunctionByHashAndPop;
+						}
+						else
+						{
+							code[index] = O_CallFunctionByHash;
+						}
+
+						wr_pack32( N.hash, code.p_str(index+2) );
+					}
+				}
+			}
+
+			WR_DUMP_LINK_OUTPUT(printf("function[%d] fixup after:\n%s\n", x, wr_asciiDump(code, code.size(), str)));
 		}
-		else if ( opcode == O_CompareNE && o>0 && bytecode.opcodes[o] == O_LoadFromLocal && bytecode.opcodes[o-1] == O_LoadFromLocal )
+	}
+
+	// plug in namespace lookups
+	while( namespaceLookups )
+	{
+		wr_pack16( m_units[namespaceLookups->unit].offsetOfLocalHashMap, code.p_str(namespaceLookups->location) );
+		NamespacePush* next = namespaceLookups->next;
+		wr_arenaFree( namespaceLookups );
+		namespaceLookups = next;
+	}
+
+	// append a CRC
+	uint32_t salted = wr_hash( code, code.size() );
+	salted += WRENCH_VERSION_MAJOR;
+	code.append( wr_pack32(salted, data), 4 );
+
+	WR_DUMP_BYTECODE(printf("bytecode [%d]:\n%s\n", code.size(), wr_asciiDump(code, code.size(), str)));
+
+	if ( !m_err )
+	{
+		*outLen = code.size();
+		code.release( out );
+	}
+}
+
+#endif
+/*******************************************************************************
+Copyright (c) 2024 Curt Hartung -- curt.hartung@gmail.com
+
+MIT Licence
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*******************************************************************************/
+
+#include "wrench.h"
+#ifndef WRENCH_WITHOUT_COMPILER
+#include <assert.h>
+
+//------------------------------------------------------------------------------
+char WRCompilationContext::parseExpression( WRExpression& expression )
+{
+	int depth = 0;
+	char end = 0;
+
+	m_newHashValue = 0;
+
+	for(;;)
+	{
+		WRValue& value = expression.context[depth].value;
+		WRstr& token = expression.context[depth].token;
+
+		expression.context[depth].bytecode.clear();
+		expression.context[depth].setLocalSpace( expression.bytecode.localSpace, expression.bytecode.isStructSpace );
+		if ( !getToken(expression.context[depth]) )
 		{
-			bytecode.all[ a - 3 ] = O_LLCompareNE;
-			bytecode.all[ a - 1 ] = bytecode.all[ a ];
-			bytecode.all.shave( 1 );
-			bytecode.opcodes.clear();
-			bytecode.opcodes += O_LLCompareNE;
-			return;
+			return 0;
 		}
-		else if ( opcode == O_CompareGT && o>0 && bytecode.opcodes[o] == O_LoadFromLocal && bytecode.opcodes[o-1] == O_LoadFromLocal )
+
+		if ( value.type != WR_REF )
 		{
-			bytecode.all[ a - 3 ] = O_LLCompareGT;
-			bytecode.all[ a - 1 ] = bytecode.all[ a ];
-			bytecode.all.shave( 1 );
-			bytecode.opcodes.clear();
-			bytecode.opcodes += O_LLCompareGT;
-			return;
+			if ( (depth > 0) 
+				 && ((expression.context[depth - 1].type == EXTYPE_LABEL) 
+					 || (expression.context[depth - 1].type == EXTYPE_LITERAL)) )
+			{
+				// two labels/literals cannot follow each other
+				m_err = WR_ERR_bad_expression;
+				return 0;
+			}
+
+			// it's a literal
+			expression.context[depth].type = EXTYPE_LITERAL;
+			if ( (uint8_t)value.type == WR_COMPILER_LITERAL_STRING )
+			{
+				expression.context[depth].literalString = *(WRstr*)value.p;
+			}
+			
+			++depth;
+			continue;
 		}
-		else if ( opcode == O_CompareLT && o>0 && bytecode.opcodes[o] == O_LoadFromLocal && bytecode.opcodes[o-1] == O_LoadFromLocal )
+
+		if ( token == ";" || token == ")" || token == "}" || token == "," || token == "]" || token == ":" )
 		{
-			bytecode.all[ a - 3 ] = O_LLCompareLT;
-			bytecode.all[ a - 1 ] = bytecode.all[ a ];
-			bytecode.all.shave( 1 );
-			bytecode.opcodes.clear();
-			bytecode.opcodes += O_LLCompareLT;
-			return;
+			end = token[0];
+			break;
 		}
-		else if ( opcode == O_CompareGE && o>0 && bytecode.opcodes[o] == O_LoadFromLocal && bytecode.opcodes[o-1] == O_LoadFromLocal )
+
+		pushDebug( WRD_LineNumber, expression.bytecode, getSourcePosition() );
+		
+		if ( token == "var" )
 		{
-			bytecode.all[ a - 3 ] = O_LLCompareGE;
-			bytecode.all[ a - 1 ] = bytecode.all[ a ];
-			bytecode.all.shave( 1 );
-			bytecode.opcodes.clear();
-			bytecode.opcodes += O_LLCompareGE;
-			return;
+			expression.context[depth].varSeen = true;
+			continue;
 		}
-		else if ( opcode == O_CompareLE && o>0 && bytecode.opcodes[o] == O_LoadFromLocal && bytecode.opcodes[o-1] == O_LoadFromLocal )
+		else if ( token == "{" )
 		{
-			bytecode.all[ a - 3 ] = O_LLCompareLE;
-			bytecode.all[ a - 1 ] = bytecode.all[ a ];
-			bytecode.all.shave( 1 );
-			bytecode.opcodes.clear();
-			bytecode.opcodes += O_LLCompareLE;
-			return;
+			depth = parseInitializer( expression, depth ) + 1;
+			if ( depth == 0 )
+			{
+				return false;
+			}
+
+			continue;
 		}
-		else if ( opcode == O_CompareEQ && o>0 && bytecode.opcodes[o] == O_LoadFromGlobal && bytecode.opcodes[o-1] == O_LoadFromGlobal )
+		
+		if ( operatorFound(token, expression.context, depth) )
 		{
-			bytecode.all[ a - 3 ] = O_GGCompareEQ;
-			bytecode.all[ a - 1 ] = bytecode.all[ a ];
-			bytecode.all.shave( 1 );
-			bytecode.opcodes.clear();
-			bytecode.opcodes += O_GGCompareEQ;
-			return;
-		}
-		else if ( opcode == O_CompareNE && o>0 && bytecode.opcodes[o] == O_LoadFromGlobal && bytecode.opcodes[o-1] == O_LoadFromGlobal )
-		{
-			bytecode.all[ a - 3 ] = O_GGCompareNE;
-			bytecode.all[ a - 1 ] = bytecode.all[ a ];
-			bytecode.all.shave( 1 );
-			bytecode.opcodes.clear();
-			bytecode.opcodes += O_GGCompareNE;
-			return;
-		}
-		else if ( opcode == O_CompareGT && o>0 && bytecode.opcodes[o] == O_LoadFromGlobal && bytecode.opcodes[o-1] == O_LoadFromGlobal )
-		{
-			bytecode.all[ a - 3 ] = O_GGCompareGT;
-			bytecode.all[ a - 1 ] = bytecode.all[ a ];
-			bytecode.all.shave( 1 );
-			bytecode.opcodes.clear();
-			bytecode.opcodes += O_GGCompareGT;
-			return;
-		}
-		else if ( opcode == O_CompareLT && o>0 && bytecode.opcodes[o] == O_LoadFromGlobal && bytecode.opcodes[o-1] == O_LoadFromGlobal )
-		{
-			bytecode.all[ a - 3 ] = O_GGCompareLT;
-			bytecode.all[ a - 1 ] = bytecode.all[ a ];
-			bytecode.all.shave( 1 );
-			bytecode.opcodes.clear();
-			bytecode.opcodes += O_GGCompareLT;
-			return;
-		}
-		else if ( opcode == O_CompareGE && o>0 && bytecode.opcodes[o] == O_LoadFromGlobal && bytecode.opcodes[o-1] == O_LoadFromGlobal )
-		{
-			bytecode.all[ a - 3 ] = O_GGCompareGE;
-			bytecode.all[ a - 1 ] = bytecode.all[ a ];
-			bytecode.all.shave( 1 );
-			bytecode.opcodes.clear();
-			bytecode.opcodes += O_GGCompareGE;
-			return;
-		}
-		else if ( opcode == O_CompareLE && o>0 && bytecode.opcodes[o] == O_LoadFromGlobal && bytecode.opcodes[o-1] == O_LoadFromGlobal )
-		{
-			bytecode.all[ a - 3 ] = O_GGCompareLE;
-			bytecode.all[ a - 1 ] = bytecode.all[ a ];
-			bytecode.all.shave( 1 );
-			bytecode.opcodes.clear();
-			bytecode.opcodes += O_GGCompareLE;
-			return;
-		}
-		else if ( (opcode == O_CompareEQ && (o>0))
-				  && CheckCompareReplace(O_LSCompareEQ, O_GSCompareEQ, O_LSCompareEQ, O_GSCompareEQ, bytecode, a, o) )
-		{
-			return;
-		}
-		else if ( (opcode == O_CompareNE && (o>0))
-				  && CheckCompareReplace(O_LSCompareNE, O_GSCompareNE, O_LSCompareNE, O_GSCompareNE, bytecode, a, o) )
-		{
-			return;
-		}
-		else if ( (opcode == O_CompareGE && (o>0))
-			 && CheckCompareReplace(O_LSCompareGE, O_GSCompareGE, O_LSCompareLE, O_GSCompareLE, bytecode, a, o) )
-		{
-			return;
-		}
-		else if ( (opcode == O_CompareLE && (o>0))
-				  && CheckCompareReplace(O_LSCompareLE, O_GSCompareLE, O_LSCompareGE, O_GSCompareGE, bytecode, a, o) )
-		{
-			return;
-		}
-		else if ( (opcode == O_CompareGT && (o>0))
-				  && CheckCompareReplace(O_LSCompareGT, O_GSCompareGT, O_LSCompareLT, O_GSCompareLT, bytecode, a, o) )
-		{
-			return;
-		}
-		else if ( (opcode == O_CompareLT && (o>0))
-				  && CheckCompareReplace(O_LSCompareLT, O_GSCompareLT, O_LSCompareGT, O_GSCompareGT, bytecode, a, o) )
-		{
-			return;
-		}
-		else if ( CheckFastLoad(opcode, bytecode, a, o) )
-		{
-			return;
+			++depth;
+			continue;
 		}
-		else if ( opcode == O_BinaryMultiplication && (a>2) )
+		
+		if ( !m_quoted && token == "new" )
 		{
-			if ( o>1 )
+			if ( (depth < 2) || 
+				 (expression.context[depth - 1].operation
+				  && expression.context[ depth - 1 ].operation->opcode != O_Assign) )
 			{
-				if ( bytecode.opcodes[o] == O_LoadFromGlobal
-					 && bytecode.opcodes[o-1] == O_LoadFromGlobal )
-				{
-					// LoadFromGlobal   a - 3
-					// [index]          a - 2
-					// LoadFromGlobal   a - 1
-					// [index]          a
-					
-					bytecode.all[ a - 3 ] = O_GGBinaryMultiplication;
-					bytecode.all[ a - 1 ] = bytecode.all[ a ];
-					bytecode.all.shave(1);
-					bytecode.opcodes.clear();
-					return;
-				}
-				else if ( bytecode.opcodes[o] == O_LoadFromLocal
-						  && bytecode.opcodes[o-1] == O_LoadFromGlobal )
-				{
-					bytecode.all[ a - 3 ] = O_GLBinaryMultiplication;
-					bytecode.all[ a - 1 ] = bytecode.all[ a - 2 ];
-					bytecode.all[ a - 2 ] = bytecode.all[ a ];
-					bytecode.all.shave(1);
-					bytecode.opcodes.clear();
-					return;
-				}
-				else if ( bytecode.opcodes[o] == O_LoadFromGlobal
-						  && bytecode.opcodes[o-1] == O_LoadFromLocal )
-				{
-					bytecode.all[ a - 3 ] = O_GLBinaryMultiplication;
-					bytecode.all[ a - 1 ] = bytecode.all[ a ];
-					bytecode.all.shave(1);
-					bytecode.opcodes.clear();
-					return;
-				}
-				else if ( bytecode.opcodes[o] == O_LoadFromLocal
-						  && bytecode.opcodes[o-1] == O_LoadFromLocal )
-				{
-					bytecode.all[ a - 3 ] = O_LLBinaryMultiplication;
-					bytecode.all[ a - 1 ] = bytecode.all[ a ];
-					bytecode.all.shave(1);
-					bytecode.opcodes.clear();
-					return;
-				}
+				m_err = WR_ERR_unexpected_token;
+				return 0;
 			}
-			
-			bytecode.all += opcode;
-			bytecode.opcodes += opcode;
-			return;
-		}
-		else if ( opcode == O_BinaryAddition && (a>2) )
-		{
-			if ( bytecode.opcodes[o] == O_LoadFromGlobal
-				 && bytecode.opcodes[o-1] == O_LoadFromGlobal )
-			{
-				bytecode.all[ a - 3 ] = O_GGBinaryAddition;
-				bytecode.all[ a - 1 ] = bytecode.all[ a ];
 
-				bytecode.all.shave(1);
-				bytecode.opcodes.clear();
-			}
-			else if ( bytecode.opcodes[o] == O_LoadFromLocal
-					  && bytecode.opcodes[o-1] == O_LoadFromGlobal )
+			if ( (depth < 2) 
+				 || (expression.context[depth - 2].operation
+					 && expression.context[ depth - 2 ].operation->opcode != O_Index) )
 			{
-				bytecode.all[ a - 3 ] = O_GLBinaryAddition;
-				bytecode.all[ a - 1 ] = bytecode.all[ a - 2 ];
-				bytecode.all[ a - 2 ] = bytecode.all[ a ];
-				bytecode.all.shave(1);
-				bytecode.opcodes.clear();
+				m_err = WR_ERR_unexpected_token;
+				return 0;
 			}
-			else if ( bytecode.opcodes[o] == O_LoadFromGlobal
-					  && bytecode.opcodes[o-1] == O_LoadFromLocal )
+			
+			WRstr& token2 = expression.context[depth].token;
+			WRValue& value2 = expression.context[depth].value;
+
+			bool isGlobal;
+			WRstr prefix;
+			bool isLibConstant;
+
+			if ( !getToken(expression.context[depth]) )
 			{
-				bytecode.all[ a - 3 ] = O_GLBinaryAddition;
-				bytecode.all[ a - 1 ] = bytecode.all[ a ];
-				bytecode.all.shave(1);
-				bytecode.opcodes.clear();
+				m_err = WR_ERR_bad_expression;
+				return 0;
 			}
-			else if ( bytecode.opcodes[o] == O_LoadFromLocal
-					  && bytecode.opcodes[o-1] == O_LoadFromLocal )
+
+			if ( !isValidLabel(token2, isGlobal, prefix, isLibConstant) || isLibConstant )
 			{
-				bytecode.all[ a - 3 ] = O_LLBinaryAddition;
-				bytecode.all[ a - 1 ] = bytecode.all[ a ];
-				bytecode.all.shave(1);
-				bytecode.opcodes.clear();
+				m_err = WR_ERR_bad_expression;
+				return 0;
 			}
-			else
+
+			WRstr functionName = token2;
+			uint32_t hash = wr_hashStr( functionName );
+			
+			if ( !getToken(expression.context[depth]) )
 			{
-				bytecode.all += opcode;
-				bytecode.opcodes += opcode;
+				m_err = WR_ERR_bad_expression;
+				return 0;
 			}
 
-			return;
-		}
-		else if ( opcode == O_BinarySubtraction && (a>2) )
-		{
-			if ( bytecode.opcodes[o] == O_LoadFromGlobal
-				 && bytecode.opcodes[o-1] == O_LoadFromGlobal )
+			if ( !m_quoted && token2 == ";" )
 			{
-				bytecode.all[ a - 3 ] = O_GGBinarySubtraction;
-				bytecode.all[ a - 1 ] = bytecode.all[ a ];
+				if ( !parseCallFunction(expression, functionName, depth, false) )
+				{
+					return 0;
+				}
 
-				bytecode.all.shave(1);
-				bytecode.opcodes.clear();
+				m_loadedToken = ";";
+				m_loadedValue.p2 = INIT_AS_REF;
+				m_loadedQuoted = m_quoted;
 			}
-			else if ( bytecode.opcodes[o] == O_LoadFromLocal
-					  && bytecode.opcodes[o-1] == O_LoadFromGlobal )
+			else if ( !m_quoted && token2 == "(" )
 			{
-				bytecode.all[ a - 3 ] = O_LGBinarySubtraction;
-				bytecode.all[ a - 1 ] = bytecode.all[ a ];
-				bytecode.all.shave(1);
-				bytecode.opcodes.clear();
+				if ( !parseCallFunction(expression, functionName, depth, true) )
+				{
+					return 0;
+				}
+
+				if ( !getToken(expression.context[depth]) )
+				{
+					m_err = WR_ERR_unexpected_EOF;
+					return 0;
+				}
+
+				if ( token2 != "{" )
+				{
+					m_loadedToken = token2;
+					m_loadedValue = value2;
+					m_loadedQuoted = m_quoted;
+				}
 			}
-			else if ( bytecode.opcodes[o] == O_LoadFromGlobal
-					  && bytecode.opcodes[o-1] == O_LoadFromLocal )
+			else if (!m_quoted && token2 == "{")
 			{
-				bytecode.all[ a - 3 ] = O_GLBinarySubtraction;
-				bytecode.all[ a - 1 ] = bytecode.all[ a ];
-				bytecode.all.shave(1);
-				bytecode.opcodes.clear();
+				if ( !parseCallFunction(expression, functionName, depth, false) )
+				{
+					return 0;
+				}
+				token2 = "{";
 			}
-			else if ( bytecode.opcodes[o] == O_LoadFromLocal
-					  && bytecode.opcodes[o-1] == O_LoadFromLocal )
+			else if ( !m_quoted && token2 == "[" )
 			{
-				bytecode.all[ a - 3 ] = O_LLBinarySubtraction;
-				bytecode.all[ a - 1 ] = bytecode.all[ a ];
-				bytecode.all.shave(1);
-				bytecode.opcodes.clear();
+				// must be "array" directive
+				if ( !getToken(expression.context[depth], "]") )
+				{
+					m_err = WR_ERR_unexpected_token;
+					return 0;
+				}
+
+				expression.context.remove( depth - 1, 1 ); // knock off the equate
+				depth--;
+
+				WRstr& token3 = expression.context[depth].token;
+				WRValue& value3 = expression.context[depth].value;
+
+				if ( !getToken(expression.context[depth], "{") )
+				{
+					m_err = WR_ERR_unexpected_token;
+					return 0;
+				}
+
+				uint16_t initializer = 0;
+
+				if ( !m_quoted && token3 == "{" )
+				{
+					for(;;)
+					{
+						if ( !getToken(expression.context[depth]) )
+						{
+							m_err = WR_ERR_unexpected_EOF;
+							return 0;
+						}
+
+						if ( !m_quoted && token3 == "}" )
+						{
+							break;
+						}
+
+						if ( !parseCallFunction(expression, functionName, depth, false) )
+						{
+							return 0;
+						}
+
+						if (!m_quoted && token3 != "{")
+						{
+							m_err = WR_ERR_unexpected_token;
+							return 0;
+						}
+
+						if ( !pushObjectTable(expression.context[depth], expression.bytecode.localSpace, hash) )
+						{
+							m_err = WR_ERR_bad_expression;
+							return 0;
+						}
+
+						pushOpcode( expression.context[depth].bytecode, O_AssignToArrayAndPop );
+
+						unsigned char data[2];
+						wr_pack16( initializer, data );
+						++initializer;
+
+						pushData( expression.context[depth].bytecode, data, 2 );
+
+						if ( !getToken(expression.context[depth]) )
+						{
+							m_err = WR_ERR_unexpected_EOF;
+							return 0;
+						}
+
+						if ( !m_quoted && token3 == "," )
+						{
+							continue;
+						}
+						else if ( token3 != "}" )
+						{
+							m_err = WR_ERR_unexpected_token;
+							return 0;
+						}
+						else
+						{
+							break;
+						}
+					}
+					
+					if ( !getToken(expression.context[depth], ";") )
+					{
+						m_err = WR_ERR_unexpected_token;
+						return 0;
+					}
+
+					WRstr t("@init");
+					for( int o=0; c_operations[o].token; o++ )
+					{
+						if ( t == c_operations[o].token )
+						{
+							expression.context[depth].type = EXTYPE_OPERATION;
+							expression.context[depth].operation = c_operations + o;
+							break;
+						}
+					}
+
+					m_loadedToken = token3;
+					m_loadedValue = value3;
+					m_loadedQuoted = m_quoted;
+				}
+				else if ( token2 != ";" )
+				{
+					m_err = WR_ERR_unexpected_token;
+					return 0;
+				}
+
+				++depth;
+				continue;
 			}
-			else
+			else if ( token2 != "{" )
 			{
-				bytecode.all += opcode;
-				bytecode.opcodes += opcode;
+				m_err = WR_ERR_bad_expression;
+				return 0;
 			}
 
-			return;
+			if ( !pushObjectTable(expression.context[depth], expression.bytecode.localSpace, hash) )
+			{
+				m_err = WR_ERR_bad_expression;
+				return 0;
+			}
+
+			++depth;
+			continue;
 		}
-		else if ( opcode == O_BinaryDivision && (a>2) )
+
+		if ( !m_quoted && token == "(" )
 		{
-			if ( bytecode.opcodes[o] == O_LoadFromGlobal
-				 && bytecode.opcodes[o-1] == O_LoadFromGlobal )
+			// might be cast, call or sub-expression
+			
+			if ( (depth > 0) &&
+				 (expression.context[depth - 1].type == EXTYPE_LABEL
+				 || expression.context[depth - 1].type == EXTYPE_LIB_CONSTANT) )
 			{
-				bytecode.all[ a - 3 ] = O_GGBinaryDivision;
-				bytecode.all[ a - 1 ] = bytecode.all[ a ];
-				bytecode.all.shave(1);
-				bytecode.opcodes.clear();
+				// always only a call
+				expression.context[depth - 1].type = EXTYPE_LABEL;
+				
+				--depth;
+				if ( !parseCallFunction(expression, expression.context[depth].token, depth, true) )
+				{
+					return 0;
+				}
 			}
-			else if ( bytecode.opcodes[o] == O_LoadFromLocal
-					  && bytecode.opcodes[o-1] == O_LoadFromGlobal )
+			else if ( !getToken(expression.context[depth]) )
 			{
-				bytecode.all[ a - 3 ] = O_LGBinaryDivision;
-				bytecode.all[ a - 1 ] = bytecode.all[ a ];
-				bytecode.all.shave(1);
-				bytecode.opcodes.clear();
+				m_err = WR_ERR_unexpected_EOF;
+				return 0;
 			}
-			else if ( bytecode.opcodes[o] == O_LoadFromGlobal
-					  && bytecode.opcodes[o-1] == O_LoadFromLocal )
+			else if ( token == "int" )
 			{
-				bytecode.all[ a - 3 ] = O_GLBinaryDivision;
-				bytecode.all[ a - 1 ] = bytecode.all[ a ];
-				bytecode.all.shave(1);
-				bytecode.opcodes.clear();
+				if ( !getToken(expression.context[depth], ")") )
+				{
+					m_err = WR_ERR_bad_expression;
+					return 0;
+				}
+
+				operatorFound( WRstr("@i"), expression.context, depth );
 			}
-			else if ( bytecode.opcodes[o] == O_LoadFromLocal
-					  && bytecode.opcodes[o-1] == O_LoadFromLocal )
+			else if ( token == "float" )
 			{
-				bytecode.all[ a - 3 ] = O_LLBinaryDivision;
-				bytecode.all[ a - 1 ] = bytecode.all[ a ];
-				bytecode.all.shave(1);
-				bytecode.opcodes.clear();
+				if ( !getToken(expression.context[depth], ")") )
+				{
+					m_err = WR_ERR_bad_expression;
+					return 0;
+				}
+
+				operatorFound( WRstr("@f"), expression.context, depth );
+			}
+			else if (depth < 0)
+			{
+				m_err = WR_ERR_bad_expression;
+				return 0;
 			}
 			else
 			{
-				bytecode.all += opcode;
-				bytecode.opcodes += opcode;
+				WRExpression nex( expression.bytecode.localSpace, expression.bytecode.isStructSpace );
+				nex.context[0].token = token;
+				nex.context[0].value = value;
+				m_loadedToken = token;
+				m_loadedValue = value;
+				m_loadedQuoted = m_quoted;
+				if ( parseExpression(nex) != ')' )
+				{
+					m_err = WR_ERR_unexpected_token;
+					return 0;
+				}
+
+
+				if ( depth > 0 && expression.context[depth - 1].operation
+					 && expression.context[depth - 1].operation->opcode == O_Remove )
+				{
+					--depth;
+					expression.context[depth].bytecode = nex.bytecode;
+					operatorFound( WRstr("._remove"), expression.context, depth );
+				}
+				else if ( depth > 0 && expression.context[depth - 1].operation
+						  && expression.context[depth - 1].operation->opcode == O_HashEntryExists )
+				{
+					--depth;
+					expression.context[depth].bytecode = nex.bytecode;
+					operatorFound( WRstr("._exists"), expression.context, depth );
+				}
+				else
+				{
+					expression.context[depth].type = EXTYPE_BYTECODE_RESULT;
+					expression.context[depth].bytecode = nex.bytecode;
+				}
 			}
 
-			return;
+			++depth;
+			continue;
 		}
-		else if ( opcode == O_Index )
+
+		if ( !m_quoted && token == "[" )
 		{
-			if ( bytecode.opcodes[o] == O_LiteralInt16 )
+			WRExpression nex( expression.bytecode.localSpace, expression.bytecode.isStructSpace );
+			nex.context[0].token = token;
+			nex.context[0].value = value;
+
+			if ( parseExpression(nex) != ']' )
 			{
-				bytecode.all[a-2] = O_IndexLiteral16;
-				bytecode.opcodes[o] = O_IndexLiteral16;
-				return;
+				m_err = WR_ERR_unexpected_EOF;
+				return 0;
 			}
-			else if ( bytecode.opcodes[o] == O_LiteralInt8 )
+
+			if ( nex.bytecode.all.size() == 0 )
 			{
-				bytecode.all[a-1] = O_IndexLiteral8;
-				bytecode.opcodes[o] = O_IndexLiteral8;
-				return;
+				operatorFound( WRstr("@[]"), expression.context, depth );
+				expression.context[depth].bytecode.all.clear();
+				expression.context[depth].bytecode.opcodes.clear();
+				pushOpcode( expression.context[depth].bytecode, O_LiteralZero );
+				pushOpcode( expression.context[depth].bytecode, O_InitArray );
 			}
-		}
-		else if ( opcode == O_BZ )
-		{
-			if ( bytecode.opcodes[o] == O_LLCompareLT )
-			{
-				bytecode.opcodes[o] = O_LLCompareLTBZ;
-				bytecode.all[ a - 2 ] = O_LLCompareLTBZ;
-				return;
-			}
-			else if ( bytecode.opcodes[o] == O_LLCompareGT )
-			{
-				bytecode.opcodes[o] = O_LLCompareGTBZ;
-				bytecode.all[ a - 2 ] = O_LLCompareGTBZ;
-				return;
-			}
-			else if ( bytecode.opcodes[o] == O_LLCompareGE )
-			{
-				bytecode.opcodes[o] = O_LLCompareGEBZ;
-				bytecode.all[ a - 2 ] = O_LLCompareGEBZ;
-				return;
-			}
-			else if ( bytecode.opcodes[o] == O_LLCompareLE )
-			{
-				bytecode.opcodes[o] = O_LLCompareLEBZ;
-				bytecode.all[ a - 2 ] = O_LLCompareLEBZ;
-				return;
-			}
-			else if ( bytecode.opcodes[o] == O_LLCompareEQ )
-			{
-				bytecode.opcodes[o] = O_LLCompareEQBZ;
-				bytecode.all[ a - 2 ] = O_LLCompareEQBZ;
-				return;
-			}
-			else if ( bytecode.opcodes[o] == O_LLCompareNE )
-			{
-				bytecode.opcodes[o] = O_LLCompareNEBZ;
-				bytecode.all[ a - 2 ] = O_LLCompareNEBZ;
-				return;
-			}
-			else if ( bytecode.opcodes[o] == O_GGCompareLT )
-			{
-				bytecode.opcodes[o] = O_GGCompareLTBZ;
-				bytecode.all[ a - 2 ] = O_GGCompareLTBZ;
-				return;
-			}
-			else if ( bytecode.opcodes[o] == O_GGCompareGT )
-			{
-				bytecode.opcodes[o] = O_GGCompareGTBZ;
-				bytecode.all[ a - 2 ] = O_GGCompareGTBZ;
-				return;
-			}
-			else if ( bytecode.opcodes[o] == O_GGCompareLE )
-			{
-				bytecode.opcodes[o] = O_GGCompareLEBZ;
-				bytecode.all[ a - 2 ] = O_GGCompareLEBZ;
-				return;
-			}
-			else if ( bytecode.opcodes[o] == O_GGCompareGE )
-			{
-				bytecode.opcodes[o] = O_GGCompareGEBZ;
-				bytecode.all[ a - 2 ] = O_GGCompareGEBZ;
-				return;
-			}
-			else if ( bytecode.opcodes[o] == O_GGCompareEQ )
-			{
-				bytecode.opcodes[o] = O_GGCompareEQBZ;
-				bytecode.all[ a - 2 ] = O_GGCompareEQBZ;
-				return;
-			}
-			else if ( bytecode.opcodes[o] == O_GGCompareNE )
-			{
-				bytecode.opcodes[o] = O_GGCompareNEBZ;
-				bytecode.all[ a - 2 ] = O_GGCompareNEBZ;
-				return;
-			}
-			else if ( bytecode.opcodes[o] == O_GSCompareEQ )
-			{
-				bytecode.opcodes[o] = O_GSCompareEQBZ;
-				bytecode.all[ a - 1 ] = O_GSCompareEQBZ;
-				return;
-			}
-			else if ( bytecode.opcodes[o] == O_LSCompareEQ )
-			{
-				bytecode.opcodes[o] = O_LSCompareEQBZ;
-				bytecode.all[ a - 1 ] = O_LSCompareEQBZ;
-				return;
-			}
-			else if ( bytecode.opcodes[o] == O_GSCompareNE )
-			{
-				bytecode.opcodes[o] = O_GSCompareNEBZ;
-				bytecode.all[ a - 1 ] = O_GSCompareNEBZ;
-				return;
-			}
-			else if ( bytecode.opcodes[o] == O_LSCompareNE )
-			{
-				bytecode.opcodes[o] = O_LSCompareNEBZ;
-				bytecode.all[ a - 1 ] = O_LSCompareNEBZ;
-				return;
-			}
-			else if ( bytecode.opcodes[o] == O_GSCompareGE )
-			{
-				bytecode.opcodes[o] = O_GSCompareGEBZ;
-				bytecode.all[ a - 1 ] = O_GSCompareGEBZ;
-				return;
-			}
-			else if ( bytecode.opcodes[o] == O_LSCompareGE )
-			{
-				bytecode.opcodes[o] = O_LSCompareGEBZ;
-				bytecode.all[ a - 1 ] = O_LSCompareGEBZ;
-				return;
-			}
-			else if ( bytecode.opcodes[o] == O_GSCompareLE )
-			{
-				bytecode.opcodes[o] = O_GSCompareLEBZ;
-				bytecode.all[ a - 1 ] = O_GSCompareLEBZ;
-				return;
-			}
-			else if ( bytecode.opcodes[o] == O_LSCompareLE )
-			{
-				bytecode.opcodes[o] = O_LSCompareLEBZ;
-				bytecode.all[ a - 1 ] = O_LSCompareLEBZ;
-				return;
-			}
-			else if ( bytecode.opcodes[o] == O_GSCompareGT )
-			{
-				bytecode.opcodes[o] = O_GSCompareGTBZ;
-				bytecode.all[ a - 1 ] = O_GSCompareGTBZ;
-				return;
-			}
-			else if ( bytecode.opcodes[o] == O_LSCompareGT )
+			else 
 			{
-				bytecode.opcodes[o] = O_LSCompareGTBZ;
-				bytecode.all[ a - 1 ] = O_LSCompareGTBZ;
-				return;
+				expression.context[depth].bytecode = nex.bytecode;
+				operatorFound( WRstr("@[]"), expression.context, depth );
 			}
-			else if ( bytecode.opcodes[o] == O_GSCompareLT )
+
+			++depth;
+			continue;
+		}
+
+		bool isGlobal;
+		WRstr prefix;
+		bool isLibConstant;
+
+		if ( isValidLabel(token, isGlobal, prefix, isLibConstant) )
+		{
+			if ( (depth > 0) 
+				&& ((expression.context[depth - 1].type == EXTYPE_LABEL) 
+					|| (expression.context[depth - 1].type == EXTYPE_LITERAL)
+					|| (expression.context[depth - 1].type == EXTYPE_LIB_CONSTANT)) )
 			{
-				bytecode.opcodes[o] = O_GSCompareLTBZ;
-				bytecode.all[ a - 1 ] = O_GSCompareLTBZ;
-				return;
+				// two labels/literals cannot follow each other
+				m_err = WR_ERR_bad_expression;
+				return 0;
 			}
-			else if ( bytecode.opcodes[o] == O_LSCompareLT )
-			{
-				bytecode.opcodes[o] = O_LSCompareLTBZ;
-				bytecode.all[ a - 1 ] = O_LSCompareLTBZ;
-				return;
-			}			
-			else if ( bytecode.opcodes[o] == O_CompareEQ ) // assign+pop is very common
+
+			WRstr label = token;
+
+			if ( depth == 0 && !m_parsingFor )
 			{
-				if ( (o>1) && (bytecode.opcodes[o-1] == O_LoadFromLocal) && (bytecode.opcodes[o-2] == O_LoadFromLocal) )
-				{
-					bytecode.all[a-4] = O_LLCompareEQBZ;
-					bytecode.all[a-2] = bytecode.all[a-1];
-					bytecode.opcodes.clear();
-					bytecode.opcodes[o-2] = O_LLCompareEQBZ;
-					bytecode.all.shave(2);
-				}
-				else if ( (o>1) && (bytecode.opcodes[o-1] == O_LoadFromGlobal) && (bytecode.opcodes[o-2] == O_LoadFromGlobal) )
-				{
-					bytecode.all[a-4] = O_GGCompareEQBZ;
-					bytecode.all[a-2] = bytecode.all[a-1];
-					bytecode.opcodes.clear();
-					bytecode.opcodes[o-2] = O_GGCompareEQBZ;
-					bytecode.all.shave(2);
-				}
-				else
+				if ( !getToken(expression.context[depth]) )
 				{
-					bytecode.all[a] = O_CompareBEQ;
-					bytecode.opcodes[o] = O_CompareBEQ;
+					m_err = WR_ERR_unexpected_EOF;
+					return 0;
 				}
-				return;
-			}
-			else if ( bytecode.opcodes[o] == O_CompareLT )
-			{
-				if ( (o>1) && (bytecode.opcodes[o-1] == O_LoadFromLocal) && (bytecode.opcodes[o-2] == O_LoadFromLocal) )
+
+				if ( m_parsingNew )
 				{
-					bytecode.all[a-4] = O_LLCompareLTBZ;
-					bytecode.all[a-2] = bytecode.all[a-1];
-					bytecode.opcodes.clear();
-					bytecode.opcodes[o-2] = O_LLCompareLTBZ;
-					bytecode.all.shave(2);
+					if ( token == "=" )
+					{
+						m_newHashValue = wr_hashStr( label );
+
+						continue;
+//						getToken(expression.context[depth]) );
+//						--depth;
+						
+					}
 				}
-				else if ( (o>1) && (bytecode.opcodes[o-1] == O_LoadFromGlobal) && (bytecode.opcodes[o-2] == O_LoadFromGlobal) )
+				
+				if ( !m_quoted && token == ":" )
 				{
-					bytecode.all[a-4] = O_GGCompareLTBZ;
-					bytecode.all[a-2] = bytecode.all[a-1];
-					bytecode.opcodes.clear();
-					bytecode.opcodes[o-2] = O_GGCompareLTBZ;
-					bytecode.all.shave(2);
+					uint32_t hash = wr_hashStr( label );
+					for( unsigned int i=0; i<expression.bytecode.jumpOffsetTargets.count(); ++i )
+					{
+						if ( expression.bytecode.jumpOffsetTargets[i].gotoHash == hash )
+						{
+							m_err = WR_ERR_bad_goto_label;
+							return false;
+						}
+					}
+					
+					int index = addRelativeJumpTarget( expression.bytecode );
+					expression.bytecode.jumpOffsetTargets[index].gotoHash = hash;
+					expression.bytecode.jumpOffsetTargets[index].offset = expression.bytecode.all.size() + 1;
+
+					// this always return a value
+					pushOpcode( expression.bytecode, O_LiteralZero );
+
+					
+					return ';';
 				}
 				else
 				{
-					bytecode.all[a] = O_CompareBLT;
-					bytecode.opcodes[o] = O_CompareBLT;
+					m_loadedToken = token;
+					m_loadedValue = value;
+					m_loadedQuoted = m_quoted;
 				}
-				return;
 			}
-			else if ( bytecode.opcodes[o] == O_CompareGT )
-			{
-				if ( (o>1) && (bytecode.opcodes[o-1] == O_LoadFromLocal) && (bytecode.opcodes[o-2] == O_LoadFromLocal) )
-				{
-					bytecode.all[a-4] = O_LLCompareGTBZ;
-					bytecode.all[a-2] = bytecode.all[a-1];
-					bytecode.opcodes.clear();
-					bytecode.opcodes[o-2] = O_LLCompareGTBZ;
-					bytecode.all.shave(2);
-				}
-				else if ( (o>1) && (bytecode.opcodes[o-1] == O_LoadFromGlobal) && (bytecode.opcodes[o-2] == O_LoadFromGlobal) )
-				{
-					bytecode.all[a-4] = O_GGCompareGTBZ;
-					bytecode.all[a-2] = bytecode.all[a-1];
-					bytecode.opcodes.clear();
-					bytecode.opcodes[o-2] = O_GGCompareGTBZ;
-					bytecode.all.shave(2);
-				}
-				else
-				{
-					bytecode.all[a] = O_CompareBGT;
-					bytecode.opcodes[o] = O_CompareBGT;
-				}
-				return;
-			}
-			else if ( bytecode.opcodes[o] == O_CompareGE )
-			{
-				if ( (o>1) && (bytecode.opcodes[o-1] == O_LoadFromLocal) && (bytecode.opcodes[o-2] == O_LoadFromLocal) )
-				{
-					bytecode.all[a-4] = O_LLCompareGEBZ;
-					bytecode.all[a-2] = bytecode.all[a-3];
-					bytecode.all[a-3] = bytecode.all[a-1];
-					bytecode.opcodes.clear();
-					bytecode.opcodes[o-2] = O_LLCompareLTBZ;
-					bytecode.all.shave(2);
-				}
-				else if ( (o>1) && (bytecode.opcodes[o-1] == O_LoadFromGlobal) && (bytecode.opcodes[o-2] == O_LoadFromGlobal) )
-				{
-					bytecode.all[a-4] = O_GGCompareGEBZ;
-					bytecode.all[a-2] = bytecode.all[a-3];
-					bytecode.all[a-3] = bytecode.all[a-1];
-					bytecode.opcodes.clear();
-					bytecode.opcodes[o-2] = O_GGCompareLTBZ;
-					bytecode.all.shave(2);
-				}
-				else
-				{
-					bytecode.all[a] = O_CompareBGE;
-					bytecode.opcodes[o] = O_CompareBGE;
-				}
-				return;
-			}
-			else if ( bytecode.opcodes[o] == O_CompareLE )
-			{
-				if ( (o>1) && (bytecode.opcodes[o-1] == O_LoadFromLocal) && (bytecode.opcodes[o-2] == O_LoadFromLocal) )
-				{
-					bytecode.all[a-4] = O_LLCompareLEBZ;
-					bytecode.all[a-2] = bytecode.all[a-3];
-					bytecode.all[a-3] = bytecode.all[a-1];
-					bytecode.opcodes.clear();
-					bytecode.opcodes[o-2] = O_LLCompareGTBZ;
-					bytecode.all.shave(2);
-				}
-				else if ( (o>1) && (bytecode.opcodes[o-1] == O_LoadFromGlobal) && (bytecode.opcodes[o-2] == O_LoadFromGlobal) )
-				{
-					bytecode.all[a-4] = O_GGCompareLEBZ;
-					bytecode.all[a-2] = bytecode.all[a-3];
-					bytecode.all[a-3] = bytecode.all[a-1];
-					bytecode.opcodes.clear();
-					bytecode.opcodes[o-2] = O_GGCompareGTBZ;
-					bytecode.all.shave(2);
-				}
-				else
-				{
-					bytecode.all[a] = O_CompareBLE;
-					bytecode.opcodes[o] = O_CompareBLE;
-				}
+			
 
-				return;
-			}
-			else if ( bytecode.opcodes[o] == O_CompareNE ) // assign+pop is very common
-			{
-				if ( (o>1) && (bytecode.opcodes[o-1] == O_LoadFromLocal) && (bytecode.opcodes[o-2] == O_LoadFromLocal) )
-				{
-					bytecode.all[a-4] = O_LLCompareNEBZ;
-					bytecode.all[a-2] = bytecode.all[a-1];
-					bytecode.opcodes.clear();
-					bytecode.opcodes[o-2] = O_LLCompareNEBZ;
-					bytecode.all.shave(2);
-				}
-				else if ( (o>1) && (bytecode.opcodes[o-1] == O_LoadFromGlobal) && (bytecode.opcodes[o-2] == O_LoadFromGlobal) )
-				{
-					bytecode.all[a-4] = O_GGCompareNEBZ;
-					bytecode.all[a-2] = bytecode.all[a-1];
-					bytecode.opcodes.clear();
-					bytecode.opcodes[o-2] = O_GGCompareNEBZ;
-					bytecode.all.shave(2);
-				}
-				else
-				{
-					bytecode.all[a] = O_CompareBNE;
-					bytecode.opcodes[o] = O_CompareBNE;
-				}
-				return;
-			}
-			else if ( bytecode.opcodes[o] == O_LogicalOr ) // assign+pop is very common
-			{
-				bytecode.all[a] = O_BLO;
-				bytecode.opcodes[o] = O_BLO;
-				return;
-			}
-			else if ( bytecode.opcodes[o] == O_LogicalAnd ) // assign+pop is very common
-			{
-				bytecode.all[a] = O_BLA;
-				bytecode.opcodes[o] = O_BLA;
-				return;
-			}
+			expression.context[depth].type = isLibConstant ? EXTYPE_LIB_CONSTANT : EXTYPE_LABEL;
+			expression.context[depth].token = label;
+			expression.context[depth].global = isGlobal;
+			expression.context[depth].prefix = prefix;
+			++depth;
+
+			continue;
 		}
-		else if ( opcode == O_PopOne )
+
+		m_err = WR_ERR_bad_expression;
+		return 0;
+	}
+
+	expression.context.setCount( expression.context.count() - 1 );
+
+	if ( depth == 2
+		 && expression.lValue
+		 && expression.context[0].type == EXTYPE_LABEL
+		 && expression.context[1].type == EXTYPE_OPERATION
+		 && expression.context[1].operation->opcode == O_Index
+		 && expression.context[1].bytecode.opcodes.size() > 0 )
+	{
+		unsigned int i = expression.context[1].bytecode.opcodes.size() - 1;
+		unsigned int a = expression.context[1].bytecode.all.size() - 1;
+		WROpcode o = (WROpcode)(expression.context[1].bytecode.opcodes[ i ]);
+		
+		switch( o )
 		{
-			if ( bytecode.opcodes[o] == O_LoadFromLocal || bytecode.opcodes[o] == O_LoadFromGlobal ) 
-			{
-				bytecode.all.shave(2);
-				bytecode.opcodes.clear();
-				return;
-			}
-			else if ( bytecode.opcodes[o] == O_CallLibFunction && (a > 4) )
+			case O_Index:
 			{
-				bytecode.all[a-5] = O_CallLibFunctionAndPop;
-				bytecode.opcodes[o] = O_CallLibFunctionAndPop;
-				return;
+				expression.context[1].bytecode.all[a] = O_InitArray;
+				break;
 			}
-			else if ( bytecode.opcodes[o] == O_FUNCTION_CALL_PLACEHOLDER )
+
+			case O_IndexLiteral16:
 			{
-				bytecode.all[ a ] = O_PopOne;
-				return;
-			}
-			else if ( bytecode.opcodes[o] == O_PreIncrement || bytecode.opcodes[o] == O_PostIncrement )
-			{	
-				if ( (o > 0) && bytecode.opcodes[o-1] == O_LoadFromGlobal )
-				{
-					bytecode.all[ a - 2 ] = O_IncGlobal;
-										
-					bytecode.all.shave(1);
-					bytecode.opcodes.clear();
-				}
-				else if ( (o > 0) && bytecode.opcodes[o-1] == O_LoadFromLocal )
-				{
-					bytecode.all[ a - 2 ] = O_IncLocal;
-					bytecode.all.shave(1);
-					bytecode.opcodes.clear();
-				}
-				else
+				if (a > 1)
 				{
-					bytecode.all[a] = O_PreIncrementAndPop;
-					bytecode.opcodes[o] = O_PreIncrementAndPop;
+					expression.context[1].bytecode.all[a - 2] = O_LiteralInt16;
+					pushOpcode(expression.context[1].bytecode, O_InitArray);
 				}
-
-				return;
+				break;
 			}
-			else if ( bytecode.opcodes[o] == O_PreDecrement || bytecode.opcodes[o] == O_PostDecrement )
-			{	
-				if ( (o > 0) && bytecode.opcodes[o-1] == O_LoadFromGlobal )
-				{
-					bytecode.all[ a - 2 ] = O_DecGlobal;
-					bytecode.all.shave(1);
-					bytecode.opcodes.clear();
-				}
-				else if ( (o > 0) && bytecode.opcodes[o-1] == O_LoadFromLocal )
-				{
-					bytecode.all[ a - 2 ] = O_DecLocal;
-					bytecode.all.shave(1);
-					bytecode.opcodes.clear();
-				}
-				else
+			
+			case O_IndexLiteral8:
+			{
+				if (a > 0)
 				{
-					bytecode.all[a] = O_PreDecrementAndPop;
-					bytecode.opcodes[o] = O_PreDecrementAndPop;
+					expression.context[1].bytecode.all[a - 1] = O_LiteralInt8;
+					pushOpcode(expression.context[1].bytecode, O_InitArray);
 				}
-				
-				return;
+				break;
 			}
-			else if ( bytecode.opcodes[o] == O_Assign ) // assign+pop is very common
-			{
-				if ( o > 0 )
-				{
-					if ( bytecode.opcodes[o-1] == O_LoadFromGlobal )
-					{
-						if ( o > 1 && bytecode.opcodes[o-2] == O_LiteralInt8 )
-						{
-							// a - 4: O_literalInt8
-							// a - 3: val
-							// a - 2: load from global
-							// a - 1: index
-							// a -- assign
 
-							bytecode.all[ a - 4 ] = O_LiteralInt8ToGlobal;
-							bytecode.all[ a - 2 ] = bytecode.all[ a - 3 ];
-							bytecode.all[ a - 3 ] = bytecode.all[ a - 1 ];
-							bytecode.all.shave(2);
-							bytecode.opcodes.clear();
-						}
-						else if ( o > 1 && bytecode.opcodes[o-2] == O_LiteralInt16 )
-						{
-							bytecode.all[ a - 5 ] = O_LiteralInt16ToGlobal;
-							bytecode.all[ a - 2 ] = bytecode.all[ a - 3 ];
-							bytecode.all[ a - 3 ] = bytecode.all[ a - 4 ];
-							bytecode.all[ a - 4 ] = bytecode.all[ a - 1 ];
-							bytecode.all.shave(2);
-							bytecode.opcodes.clear();
-						}
-						else if ( o > 1 && bytecode.opcodes[o-2] == O_LiteralInt32 )
-						{
-							bytecode.all[ a - 7 ] = O_LiteralInt32ToGlobal;
-							bytecode.all[ a - 2 ] = bytecode.all[ a - 3 ];
-							bytecode.all[ a - 3 ] = bytecode.all[ a - 4 ];
-							bytecode.all[ a - 4 ] = bytecode.all[ a - 5 ];
-							bytecode.all[ a - 5 ] = bytecode.all[ a - 6 ];
-							bytecode.all[ a - 6 ] = bytecode.all[ a - 1 ];
-							bytecode.all.shave(2);
-							bytecode.opcodes.clear();
-						}
-						else if ( o > 1 && bytecode.opcodes[o-2] == O_LiteralFloat )
-						{
-							bytecode.all[ a - 7 ] = O_LiteralFloatToGlobal;
-							bytecode.all[ a - 2 ] = bytecode.all[ a - 3 ];
-							bytecode.all[ a - 3 ] = bytecode.all[ a - 4 ];
-							bytecode.all[ a - 4 ] = bytecode.all[ a - 5 ];
-							bytecode.all[ a - 5 ] = bytecode.all[ a - 6 ];
-							bytecode.all[ a - 6 ] = bytecode.all[ a - 1 ];
-							bytecode.all.shave(2);
-							bytecode.opcodes.clear();
-						}
-						else if ( (o > 1) && bytecode.opcodes[o-2] == O_LiteralZero )
-						{
-							bytecode.all[ a - 3 ] = O_LiteralInt8ToGlobal;
-							bytecode.all[ a - 2 ] = bytecode.all[ a - 1 ];
+			default: break;
+		}
+	}
+
+	resolveExpression( expression );
+
+	return end;
+}
+
+#endif
+/*******************************************************************************
+Copyright (c) 2024 Curt Hartung -- curt.hartung@gmail.com
+
+MIT Licence
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*******************************************************************************/
+
+#include "wrench.h"
+#ifndef WRENCH_WITHOUT_COMPILER
+
+#define KEYHOLE_OPTIMIZER
+
+//------------------------------------------------------------------------------
+bool WRCompilationContext::CheckSkipLoad( WROpcode opcode, WRBytecode& bytecode, int a, int o )
+{
+	if ( bytecode.opcodes[o] == O_LoadFromLocal
+		 && bytecode.opcodes[o-1] == O_LoadFromLocal )
+	{
+		bytecode.all[a-3] = O_LLValues;
+		bytecode.all[a-1] = bytecode.all[a];
+		bytecode.all[a] = opcode;
+		bytecode.opcodes.shave(2);
+		bytecode.opcodes += opcode;
+		return true;
+	}
+	else if ( bytecode.opcodes[o] == O_LoadFromGlobal
+			  && bytecode.opcodes[o-1] == O_LoadFromLocal )
+	{
+		bytecode.all[a-3] = O_LGValues;
+		bytecode.all[a-1] = bytecode.all[a];
+		bytecode.all[a] = opcode;
+		bytecode.opcodes.shave(2);
+		bytecode.opcodes += opcode;
+		return true;
+	}
+	else if ( bytecode.opcodes[o] == O_LoadFromLocal
+			  && bytecode.opcodes[o-1] == O_LoadFromGlobal )
+	{
+		bytecode.all[a-3] = O_GLValues;
+		bytecode.all[a-1] = bytecode.all[a];
+		bytecode.all[a] = opcode;
+		bytecode.opcodes.shave(2);
+		bytecode.opcodes += opcode;
+		return true;
+	}
+	else if ( bytecode.opcodes[o] == O_LoadFromGlobal
+			  && bytecode.opcodes[o-1] == O_LoadFromGlobal )
+	{
+		bytecode.all[a-3] = O_GGValues;
+		bytecode.all[a-1] = bytecode.all[a];
+		bytecode.all[a] = opcode;
+		bytecode.opcodes.shave(2);
+		bytecode.opcodes += opcode;
+		return true;
+	}
+
+	return false;
+}
+
+//------------------------------------------------------------------------------
+bool WRCompilationContext::CheckFastLoad( WROpcode opcode, WRBytecode& bytecode, int a, int o )
+{
+	if ( a <= 2 || o == 0 )
+	{
+		return false;
+	}
+
+	if ( (opcode == O_Index && CheckSkipLoad(O_IndexSkipLoad, bytecode, a, o))
+		 || (opcode == O_BinaryMod && CheckSkipLoad(O_BinaryModSkipLoad, bytecode, a, o)) 
+		 || (opcode == O_BinaryRightShift && CheckSkipLoad(O_BinaryRightShiftSkipLoad, bytecode, a, o))
+		 || (opcode == O_BinaryLeftShift && CheckSkipLoad(O_BinaryLeftShiftSkipLoad, bytecode, a, o)) 
+		 || (opcode == O_BinaryAnd && CheckSkipLoad(O_BinaryAndSkipLoad, bytecode, a, o)) 
+		 || (opcode == O_BinaryOr && CheckSkipLoad(O_BinaryOrSkipLoad, bytecode, a, o)) 
+		 || (opcode == O_BinaryXOR && CheckSkipLoad(O_BinaryXORSkipLoad, bytecode, a, o)) )
+	{
+		return true;
+	}
+
+	return false;
+}
+
+//------------------------------------------------------------------------------
+bool WRCompilationContext::IsLiteralLoadOpcode( unsigned char opcode )
+{
+	return opcode == O_LiteralInt32
+			|| opcode == O_LiteralZero
+			|| opcode == O_LiteralFloat
+			|| opcode == O_LiteralInt8
+			|| opcode == O_LiteralInt16;
+}
+
+//------------------------------------------------------------------------------
+bool WRCompilationContext::CheckCompareReplace( WROpcode LS, WROpcode GS, WROpcode ILS, WROpcode IGS, WRBytecode& bytecode, unsigned int a, unsigned int o )
+{
+	if ( IsLiteralLoadOpcode(bytecode.opcodes[o-1]) )
+	{
+		if ( bytecode.opcodes[o] == O_LoadFromGlobal )
+		{
+			bytecode.all[ a - 1 ] = GS;
+			bytecode.opcodes[o] = GS;
+			return true;
+		}
+		else if ( bytecode.opcodes[o] == O_LoadFromLocal )
+		{
+			bytecode.all[ a - 1 ] = LS;
+			bytecode.opcodes[o] = LS;
+			return true;
+		}
+	}
+	else if ( IsLiteralLoadOpcode(bytecode.opcodes[o]) )
+	{
+		if ( (bytecode.opcodes[o] == O_LiteralInt32 || bytecode.opcodes[o] == O_LiteralFloat)
+			 && bytecode.opcodes[o-1] == O_LoadFromGlobal )
+		{
+			bytecode.all[ a - 6 ] = bytecode.all[ a ]; // store i3
+			bytecode.all[ a ] = bytecode.all[ a - 5 ]; // move index
+
+			bytecode.all[ a - 5 ] = bytecode.all[ a - 3 ];
+			bytecode.all[ a - 4 ] = bytecode.all[ a - 2 ];
+			bytecode.all[ a - 3 ] = bytecode.all[ a - 1 ];
+			bytecode.all[ a - 2 ] = bytecode.all[ a - 6 ];
+			bytecode.all[ a - 6 ] = bytecode.opcodes[o];
+			bytecode.all[ a - 1 ] = IGS;
+
+			bytecode.opcodes[o] = IGS; // reverse the logic
+
+			return true;
+		}
+		else if ( bytecode.opcodes[o] == O_LiteralZero
+				  && bytecode.opcodes[o-1] == O_LoadFromGlobal )
+		{
+			bytecode.all[ a - 2 ] = O_LiteralZero;
+			bytecode.all[ a ] = bytecode.all[ a - 1];
+			bytecode.all[ a - 1 ] = IGS;
+			bytecode.opcodes[o] = IGS; // reverse the logic
+			return true;
+		}
+		else if ( bytecode.opcodes[o] == O_LiteralZero
+				  && bytecode.opcodes[o-1] == O_LoadFromGlobal )
+		{
+			bytecode.all[ a - 2 ] = O_LiteralZero;
+			bytecode.all[ a ] = bytecode.all[ a - 1];
+			bytecode.all[ a - 1 ] = IGS;
+			bytecode.opcodes[o] = IGS; // reverse the logic
+			return true;
+		}
+		else if ( bytecode.opcodes[o] == O_LiteralInt8
+				  && bytecode.opcodes[o-1] == O_LoadFromGlobal )
+		{
+			bytecode.all[ a - 1 ] = bytecode.all[ a - 2 ];
+			bytecode.all[ a - 2 ] = bytecode.all[ a ];
+			bytecode.all[ a ] = bytecode.all[ a - 1 ];
+			bytecode.all[ a - 1 ] = IGS;
+			bytecode.all[ a - 3 ] = O_LiteralInt8;
+
+			bytecode.opcodes[o] = IGS; // reverse the logic
+			return true;
+		}
+		else if ( bytecode.opcodes[o] == O_LiteralInt16
+				  && bytecode.opcodes[o-1] == O_LoadFromGlobal )
+		{
+			bytecode.all[ a - 2 ] = bytecode.all[ a ];
+
+			bytecode.all[ a - 4 ] = bytecode.all[ a - 3 ];
+			bytecode.all[ a - 3 ] = bytecode.all[ a - 1 ];
+			bytecode.all[ a ] = bytecode.all[ a - 4 ];
+			bytecode.all[ a - 1 ] = IGS;
+			bytecode.all[ a - 4 ] = O_LiteralInt16;
+
+			bytecode.opcodes[o] = IGS; // reverse the logic
+			return true;
+		}
+		if ( (bytecode.opcodes[o] == O_LiteralInt32 || bytecode.opcodes[o] == O_LiteralFloat)
+			 && bytecode.opcodes[o-1] == O_LoadFromLocal )
+		{
+			bytecode.all[ a - 6 ] = bytecode.all[ a ]; // store i3
+			bytecode.all[ a ] = bytecode.all[ a - 5 ]; // move index
+
+			bytecode.all[ a - 5 ] = bytecode.all[ a - 3 ];
+			bytecode.all[ a - 4 ] = bytecode.all[ a - 2 ];
+			bytecode.all[ a - 3 ] = bytecode.all[ a - 1 ];
+			bytecode.all[ a - 2 ] = bytecode.all[ a - 6 ];
+			bytecode.all[ a - 6 ] = bytecode.opcodes[o];
+			bytecode.all[ a - 1 ] = ILS;
+
+			bytecode.opcodes[o] = ILS; // reverse the logic
+
+			return true;
+		}
+		else if ( bytecode.opcodes[o] == O_LiteralZero
+				  && bytecode.opcodes[o-1] == O_LoadFromLocal )
+		{
+			bytecode.all[ a - 2 ] = O_LiteralZero;
+			bytecode.all[ a ] = bytecode.all[ a - 1];
+			bytecode.all[ a - 1 ] = ILS;
+			bytecode.opcodes[o] = ILS; // reverse the logic
+			return true;
+		}
+		else if ( bytecode.opcodes[o] == O_LiteralZero
+				  && bytecode.opcodes[o-1] == O_LoadFromLocal )
+		{
+			bytecode.all[ a - 2 ] = O_LiteralZero;
+			bytecode.all[ a ] = bytecode.all[ a - 1];
+			bytecode.all[ a - 1 ] = ILS;
+			bytecode.opcodes[o] = ILS; // reverse the logic
+			return true;
+		}
+		else if ( bytecode.opcodes[o] == O_LiteralInt8
+				  && bytecode.opcodes[o-1] == O_LoadFromLocal )
+		{
+			bytecode.all[ a - 1 ] = bytecode.all[ a - 2 ];
+			bytecode.all[ a - 2 ] = bytecode.all[ a ];
+			bytecode.all[ a ] = bytecode.all[ a - 1 ];
+			bytecode.all[ a - 1 ] = ILS;
+			bytecode.all[ a - 3 ] = O_LiteralInt8;
+
+			bytecode.opcodes[o] = ILS; // reverse the logic
+			return true;
+		}
+		else if ( bytecode.opcodes[o] == O_LiteralInt16
+				  && bytecode.opcodes[o-1] == O_LoadFromLocal )
+		{
+			bytecode.all[ a - 2 ] = bytecode.all[ a ];
+
+			bytecode.all[ a - 4 ] = bytecode.all[ a - 3 ];
+			bytecode.all[ a - 3 ] = bytecode.all[ a - 1 ];
+			bytecode.all[ a ] = bytecode.all[ a - 4 ];
+			bytecode.all[ a - 1 ] = ILS;
+			bytecode.all[ a - 4 ] = O_LiteralInt16;
+
+			bytecode.opcodes[o] = ILS; // reverse the logic
+			return true;
+		}
+	}
+
+	return false;
+}
+
+//------------------------------------------------------------------------------
+// the previous opcode becomes the superinstruction, which runs it and
+// then jumps straight to this one. Nothing is moved, so a later keyhole
+// rewriting either of them or a jump to this one still works
+void WRCompilationContext::MarkSuperinstruction( WROpcode opcode, WRBytecode& bytecode )
+{
+#define WR_SUPER_MARK( NAME, FIRST, SECOND_AS_PUSHED, SECOND )								\
+	if ( opcode == O_##SECOND_AS_PUSHED														\
+		 && bytecode.opcodes[bytecode.opcodes.size() - 1] == O_##FIRST						\
+		 && bytecode.all.size() > WR_SUPER_OPERANDS_##FIRST									\
+		 && bytecode.all[bytecode.all.size() - 1 - WR_SUPER_OPERANDS_##FIRST] == O_##FIRST )	\
+	{																						\
+		bytecode.all[bytecode.all.size() - 1 - WR_SUPER_OPERANDS_##FIRST] = O_##NAME;		\
+		return;																				\
+	}
+
+	if ( bytecode.opcodes.size() )
+	{
+		WRENCH_SUPERINSTRUCTIONS( WR_SUPER_MARK )
+	}
+}
+
+//------------------------------------------------------------------------------
+void WRCompilationContext::pushOpcode( WRBytecode& bytecode, WROpcode opcode )
+{
+#ifdef KEYHOLE_OPTIMIZER
+	unsigned int o = bytecode.opcodes.size();
+	if ( o )
+	{
+		// keyhole optimizations
+
+		--o;
+		unsigned int a = bytecode.all.size() - 1;
+		if ( opcode == O_Return
+			 && bytecode.opcodes[o] == O_LiteralZero )
+		{
+			bytecode.all[a] = O_ReturnZero;
+			bytecode.opcodes[o] = O_ReturnZero;
+			return;
+		}
+		else if ( opcode == O_CompareEQ && o>0 && bytecode.opcodes[o] == O_LoadFromLocal && bytecode.opcodes[o-1] == O_LoadFromLocal )
+		{
+			bytecode.all[ a - 3 ] = O_LLCompareEQ;
+			bytecode.all[ a - 1 ] = bytecode.all[ a ];
+			bytecode.all.shave( 1 );
+			bytecode.opcodes.clear();
+			bytecode.opcodes += O_LLCompareEQ;
+			return;
+		}
+		else if ( opcode == O_CompareNE && o>0 && bytecode.opcodes[o] == O_LoadFromLocal && bytecode.opcodes[o-1] == O_LoadFromLocal )
+		{
+			bytecode.all[ a - 3 ] = O_LLCompareNE;
+			bytecode.all[ a - 1 ] = bytecode.all[ a ];
+			bytecode.all.shave( 1 );
+			bytecode.opcodes.clear();
+			bytecode.opcodes += O_LLCompareNE;
+			return;
+		}
+		else if ( opcode == O_CompareGT && o>0 && bytecode.opcodes[o] == O_LoadFromLocal && bytecode.opcodes[o-1] == O_LoadFromLocal )
+		{
+			bytecode.all[ a - 3 ] = O_LLCompareGT;
+			bytecode.all[ a - 1 ] = bytecode.all[ a ];
+			bytecode.all.shave( 1 );
+			bytecode.opcodes.clear();
+			bytecode.opcodes += O_LLCompareGT;
+			return;
+		}
+		else if ( opcode == O_CompareLT && o>0 && bytecode.opcodes[o] == O_LoadFromLocal && bytecode.opcodes[o-1] == O_LoadFromLocal )
+		{
+			bytecode.all[ a - 3 ] = O_LLCompareLT;
+			bytecode.all[ a - 1 ] = bytecode.all[ a ];
+			bytecode.all.shave( 1 );
+			bytecode.opcodes.clear();
+			bytecode.opcodes += O_LLCompareLT;
+			return;
+		}
+		else if ( opcode == O_CompareGE && o>0 && bytecode.opcodes[o] == O_LoadFromLocal && bytecode.opcodes[o-1] == O_LoadFromLocal )
+		{
+			bytecode.all[ a - 3 ] = O_LLCompareGE;
+			bytecode.all[ a - 1 ] = bytecode.all[ a ];
+			bytecode.all.shave( 1 );
+			bytecode.opcodes.clear();
+			bytecode.opcodes += O_LLCompareGE;
+			return;
+		}
+		else if ( opcode == O_CompareLE && o>0 && bytecode.opcodes[o] == O_LoadFromLocal && bytecode.opcodes[o-1] == O_LoadFromLocal )
+		{
+			bytecode.all[ a - 3 ] = O_LLCompareLE;
+			bytecode.all[ a - 1 ] = bytecode.all[ a ];
+			bytecode.all.shave( 1 );
+			bytecode.opcodes.clear();
+			bytecode.opcodes += O_LLCompareLE;
+			return;
+		}
+		else if ( opcode == O_CompareEQ && o>0 && bytecode.opcodes[o] == O_LoadFromGlobal && bytecode.opcodes[o-1] == O_LoadFromGlobal )
+		{
+			bytecode.all[ a - 3 ] = O_GGCompareEQ;
+			bytecode.all[ a - 1 ] = bytecode.all[ a ];
+			bytecode.all.shave( 1 );
+			bytecode.opcodes.clear();
+			bytecode.opcodes += O_GGCompareEQ;
+			return;
+		}
+		else if ( opcode == O_CompareNE && o>0 && bytecode.opcodes[o] == O_LoadFromGlobal && bytecode.opcodes[o-1] == O_LoadFromGlobal )
+		{
+			bytecode.all[ a - 3 ] = O_GGCompareNE;
+			bytecode.all[ a - 1 ] = bytecode.all[ a ];
+			bytecode.all.shave( 1 );
+			bytecode.opcodes.clear();
+			bytecode.opcodes += O_GGCompareNE;
+			return;
+		}
+		else if ( opcode == O_CompareGT && o>0 && bytecode.opcodes[o] == O_LoadFromGlobal && bytecode.opcodes[o-1] == O_LoadFromGlobal )
+		{
+			bytecode.all[ a - 3 ] = O_GGCompareGT;
+			bytecode.all[ a - 1 ] = bytecode.all[ a ];
+			bytecode.all.shave( 1 );
+			bytecode.opcodes.clear();
+			bytecode.opcodes += O_GGCompareGT;
+			return;
+		}
+		else if ( opcode == O_CompareLT && o>0 && bytecode.opcodes[o] == O_LoadFromGlobal && bytecode.opcodes[o-1] == O_LoadFromGlobal )
+		{
+			bytecode.all[ a - 3 ] = O_GGCompareLT;
+			bytecode.all[ a - 1 ] = bytecode.all[ a ];
+			bytecode.all.shave( 1 );
+			bytecode.opcodes.clear();
+			bytecode.opcodes += O_GGCompareLT;
+			return;
+		}
+		else if ( opcode == O_CompareGE && o>0 && bytecode.opcodes[o] == O_LoadFromGlobal && bytecode.opcodes[o-1] == O_LoadFromGlobal )
+		{
+			bytecode.all[ a - 3 ] = O_GGCompareGE;
+			bytecode.all[ a - 1 ] = bytecode.all[ a ];
+			bytecode.all.shave( 1 );
+			bytecode.opcodes.clear();
+			bytecode.opcodes += O_GGCompareGE;
+			return;
+		}
+		else if ( opcode == O_CompareLE && o>0 && bytecode.opcodes[o] == O_LoadFromGlobal && bytecode.opcodes[o-1] == O_LoadFromGlobal )
+		{
+			bytecode.all[ a - 3 ] = O_GGCompareLE;
+			bytecode.all[ a - 1 ] = bytecode.all[ a ];
+			bytecode.all.shave( 1 );
+			bytecode.opcodes.clear();
+			bytecode.opcodes += O_GGCompareLE;
+			return;
+		}
+		else if ( (opcode == O_CompareEQ && (o>0))
+				  && CheckCompareReplace(O_LSCompareEQ, O_GSCompareEQ, O_LSCompareEQ, O_GSCompareEQ, bytecode, a, o) )
+		{
+			return;
+		}
+		else if ( (opcode == O_CompareNE && (o>0))
+				  && CheckCompareReplace(O_LSCompareNE, O_GSCompareNE, O_LSCompareNE, O_GSCompareNE, bytecode, a, o) )
+		{
+			return;
+		}
+		else if ( (opcode == O_CompareGE && (o>0))
+			 && CheckCompareReplace(O_LSCompareGE, O_GSCompareGE, O_LSCompareLE, O_GSCompareLE, bytecode, a, o) )
+		{
+			return;
+		}
+		else if ( (opcode == O_CompareLE && (o>0))
+				  && CheckCompareReplace(O_LSCompareLE, O_GSCompareLE, O_LSCompareGE, O_GSCompareGE, bytecode, a, o) )
+		{
+			return;
+		}
+		else if ( (opcode == O_CompareGT && (o>0))
+				  && CheckCompareReplace(O_LSCompareGT, O_GSCompareGT, O_LSCompareLT, O_GSCompareLT, bytecode, a, o) )
+		{
+			return;
+		}
+		else if ( (opcode == O_CompareLT && (o>0))
+				  && CheckCompareReplace(O_LSCompareLT, O_GSCompareLT, O_LSCompareGT, O_GSCompareGT, bytecode, a, o) )
+		{
+			return;
+		}
+		else if ( CheckFastLoad(opcode, bytecode, a, o) )
+		{
+			return;
+		}
+		else if ( opcode == O_BinaryMultiplication && (a>2) )
+		{
+			if ( o>1 )
+			{
+				if ( bytecode.opcodes[o] == O_LoadFromGlobal
+					 && bytecode.opcodes[o-1] == O_LoadFromGlobal )
+				{
+					// LoadFromGlobal   a - 3
+					// [index]          a - 2
+					// LoadFromGlobal   a - 1
+					// [index]          a
+					
+					bytecode.all[ a - 3 ] = O_GGBinaryMultiplication;
+					bytecode.all[ a - 1 ] = bytecode.all[ a ];
+					bytecode.all.shave(1);
+					bytecode.opcodes.clear();
+					return;
+				}
+				else if ( bytecode.opcodes[o] == O_LoadFromLocal
+						  && bytecode.opcodes[o-1] == O_LoadFromGlobal )
+				{
+					bytecode.all[ a - 3 ] = O_GLBinaryMultiplication;
+					bytecode.all[ a - 1 ] = bytecode.all[ a - 2 ];
+					bytecode.all[ a - 2 ] = bytecode.all[ a ];
+					bytecode.all.shave(1);
+					bytecode.opcodes.clear();
+					return;
+				}
+				else if ( bytecode.opcodes[o] == O_LoadFromGlobal
+						  && bytecode.opcodes[o-1] == O_LoadFromLocal )
+				{
+					bytecode.all[ a - 3 ] = O_GLBinaryMultiplication;
+					bytecode.all[ a - 1 ] = bytecode.all[ a ];
+					bytecode.all.shave(1);
+					bytecode.opcodes.clear();
+					return;
+				}
+				else if ( bytecode.opcodes[o] == O_LoadFromLocal
+						  && bytecode.opcodes[o-1] == O_LoadFromLocal )
+				{
+					bytecode.all[ a - 3 ] = O_LLBinaryMultiplication;
+					bytecode.all[ a - 1 ] = bytecode.all[ a ];
+					bytecode.all.shave(1);
+					bytecode.opcodes.clear();
+					return;
+				}
+			}
+			
+			bytecode.all += opcode;
+			bytecode.opcodes += opcode;
+			return;
+		}
+		else if ( opcode == O_BinaryAddition && (a>2) )
+		{
+			if ( bytecode.opcodes[o] == O_LoadFromGlobal
+				 && bytecode.opcodes[o-1] == O_LoadFromGlobal )
+			{
+				bytecode.all[ a - 3 ] = O_GGBinaryAddition;
+				bytecode.all[ a - 1 ] = bytecode.all[ a ];
+
+				bytecode.all.shave(1);
+				bytecode.opcodes.clear();
+			}
+			else if ( bytecode.opcodes[o] == O_LoadFromLocal
+					  && bytecode.opcodes[o-1] == O_LoadFromGlobal )
+			{
+				bytecode.all[ a - 3 ] = O_GLBinaryAddition;
+				bytecode.all[ a - 1 ] = bytecode.all[ a - 2 ];
+				bytecode.all[ a - 2 ] = bytecode.all[ a ];
+				bytecode.all.shave(1);
+				bytecode.opcodes.clear();
+			}
+			else if ( bytecode.opcodes[o] == O_LoadFromGlobal
+					  && bytecode.opcodes[o-1] == O_LoadFromLocal )
+			{
+				bytecode.all[ a - 3 ] = O_GLBinaryAddition;
+				bytecode.all[ a - 1 ] = bytecode.all[ a ];
+				bytecode.all.shave(1);
+				bytecode.opcodes.clear();
+			}
+			else if ( bytecode.opcodes[o] == O_LoadFromLocal
+					  && bytecode.opcodes[o-1] == O_LoadFromLocal )
+			{
+				bytecode.all[ a - 3 ] = O_LLBinaryAddition;
+				bytecode.all[ a - 1 ] = bytecode.all[ a ];
+				bytecode.all.shave(1);
+				bytecode.opcodes.clear();
+			}
+			else
+			{
+				bytecode.all += opcode;
+				bytecode.opcodes += opcode;
+			}
+
+			return;
+		}
+		else if ( opcode == O_BinarySubtraction && (a>2) )
+		{
+			if ( bytecode.opcodes[o] == O_LoadFromGlobal
+				 && bytecode.opcodes[o-1] == O_LoadFromGlobal )
+			{
+				bytecode.all[ a - 3 ] = O_GGBinarySubtraction;
+				bytecode.all[ a - 1 ] = bytecode.all[ a ];
+
+				bytecode.all.shave(1);
+				bytecode.opcodes.clear();
+			}
+			else if ( bytecode.opcodes[o] == O_LoadFromLocal
+					  && bytecode.opcodes[o-1] == O_LoadFromGlobal )
+			{
+				bytecode.all[ a - 3 ] = O_LGBinarySubtraction;
+				bytecode.all[ a - 1 ] = bytecode.all[ a ];
+				bytecode.all.shave(1);
+				bytecode.opcodes.clear();
+			}
+			else if ( bytecode.opcodes[o] == O_LoadFromGlobal
+					  && bytecode.opcodes[o-1] == O_LoadFromLocal )
+			{
+				bytecode.all[ a - 3 ] = O_GLBinarySubtraction;
+				bytecode.all[ a - 1 ] = bytecode.all[ a ];
+				bytecode.all.shave(1);
+				bytecode.opcodes.clear();
+			}
+			else if ( bytecode.opcodes[o] == O_LoadFromLocal
+					  && bytecode.opcodes[o-1] == O_LoadFromLocal )
+			{
+				bytecode.all[ a - 3 ] = O_LLBinarySubtraction;
+				bytecode.all[ a - 1 ] = bytecode.all[ a ];
+				bytecode.all.shave(1);
+				bytecode.opcodes.clear();
+			}
+			else
+			{
+				bytecode.all += opcode;
+				bytecode.opcodes += opcode;
+			}
+
+			return;
+		}
+		else if ( opcode == O_BinaryDivision && (a>2) )
+		{
+			if ( bytecode.opcodes[o] == O_LoadFromGlobal
+				 && bytecode.opcodes[o-1] == O_LoadFromGlobal )
+			{
+				bytecode.all[ a - 3 ] = O_GGBinaryDivision;
+				bytecode.all[ a - 1 ] = bytecode.all[ a ];
+				bytecode.all.shave(1);
+				bytecode.opcodes.clear();
+			}
+			else if ( bytecode.opcodes[o] == O_LoadFromLocal
+					  && bytecode.opcodes[o-1] == O_LoadFromGlobal )
+			{
+				bytecode.all[ a - 3 ] = O_LGBinaryDivision;
+				bytecode.all[ a - 1 ] = bytecode.all[ a ];
+				bytecode.all.shave(1);
+				bytecode.opcodes.clear();
+			}
+			else if ( bytecode.opcodes[o] == O_LoadFromGlobal
+					  && bytecode.opcodes[o-1] == O_LoadFromLocal )
+			{
+				bytecode.all[ a - 3 ] = O_GLBinaryDivision;
+				bytecode.all[ a - 1 ] = bytecode.all[ a ];
+				bytecode.all.shave(1);
+				bytecode.opcodes.clear();
+			}
+			else if ( bytecode.opcodes[o] == O_LoadFromLocal
+					  && bytecode.opcodes[o-1] == O_LoadFromLocal )
+			{
+				bytecode.all[ a - 3 ] = O_LLBinaryDivision;
+				bytecode.all[ a - 1 ] = bytecode.all[ a ];
+				bytecode.all.shave(1);
+				bytecode.opcodes.clear();
+			}
+			else
+			{
+				bytecode.all += opcode;
+				bytecode.opcodes += opcode;
+			}
+
+			return;
+		}
+		else if ( opcode == O_Index )
+		{
+			if ( bytecode.opcodes[o] == O_LiteralInt16 )
+			{
+				bytecode.all[a-2] = O_IndexLiteral16;
+				bytecode.opcodes[o] = O_IndexLiteral16;
+				return;
+			}
+			else if ( bytecode.opcodes[o] == O_LiteralInt8 )
+			{
+				bytecode.all[a-1] = O_IndexLiteral8;
+				bytecode.opcodes[o] = O_IndexLiteral8;
+				return;
+			}
+		}
+		else if ( opcode == O_BZ )
+		{
+			if ( bytecode.opcodes[o] == O_LLCompareLT )
+			{
+				bytecode.opcodes[o] = O_LLCompareLTBZ;
+				bytecode.all[ a - 2 ] = O_LLCompareLTBZ;
+				return;
+			}
+			else if ( bytecode.opcodes[o] == O_LLCompareGT )
+			{
+				bytecode.opcodes[o] = O_LLCompareGTBZ;
+				bytecode.all[ a - 2 ] = O_LLCompareGTBZ;
+				return;
+			}
+			else if ( bytecode.opcodes[o] == O_LLCompareGE )
+			{
+				bytecode.opcodes[o] = O_LLCompareGEBZ;
+				bytecode.all[ a - 2 ] = O_LLCompareGEBZ;
+				return;
+			}
+			else if ( bytecode.opcodes[o] == O_LLCompareLE )
+			{
+				bytecode.opcodes[o] = O_LLCompareLEBZ;
+				bytecode.all[ a - 2 ] = O_LLCompareLEBZ;
+				return;
+			}
+			else if ( bytecode.opcodes[o] == O_LLCompareEQ )
+			{
+				bytecode.opcodes[o] = O_LLCompareEQBZ;
+				bytecode.all[ a - 2 ] = O_LLCompareEQBZ;
+				return;
+			}
+			else if ( bytecode.opcodes[o] == O_LLCompareNE )
+			{
+				bytecode.opcodes[o] = O_LLCompareNEBZ;
+				bytecode.all[ a - 2 ] = O_LLCompareNEBZ;
+				return;
+			}
+			else if ( bytecode.opcodes[o] == O_GGCompareLT )
+			{
+				bytecode.opcodes[o] = O_GGCompareLTBZ;
+				bytecode.all[ a - 2 ] = O_GGCompareLTBZ;
+				return;
+			}
+			else if ( bytecode.opcodes[o] == O_GGCompareGT )
+			{
+				bytecode.opcodes[o] = O_GGCompareGTBZ;
+				bytecode.all[ a - 2 ] = O_GGCompareGTBZ;
+				return;
+			}
+			else if ( bytecode.opcodes[o] == O_GGCompareLE )
+			{
+				bytecode.opcodes[o] = O_GGCompareLEBZ;
+				bytecode.all[ a - 2 ] = O_GGCompareLEBZ;
+				return;
+			}
+			else if ( bytecode.opcodes[o] == O_GGCompareGE )
+			{
+				bytecode.opcodes[o] = O_GGCompareGEBZ;
+				bytecode.all[ a - 2 ] = O_GGCompareGEBZ;
+				return;
+			}
+			else if ( bytecode.opcodes[o] == O_GGCompareEQ )
+			{
+				bytecode.opcodes[o] = O_GGCompareEQBZ;
+				bytecode.all[ a - 2 ] = O_GGCompareEQBZ;
+				return;
+			}
+			else if ( bytecode.opcodes[o] == O_GGCompareNE )
+			{
+				bytecode.opcodes[o] = O_GGCompareNEBZ;
+				bytecode.all[ a - 2 ] = O_GGCompareNEBZ;
+				return;
+			}
+			else if ( bytecode.opcodes[o] == O_GSCompareEQ )
+			{
+				bytecode.opcodes[o] = O_GSCompareEQBZ;
+				bytecode.all[ a - 1 ] = O_GSCompareEQBZ;
+				return;
+			}
+			else if ( bytecode.opcodes[o] == O_LSCompareEQ )
+			{
+				bytecode.opcodes[o] = O_LSCompareEQBZ;
+				bytecode.all[ a - 1 ] = O_LSCompareEQBZ;
+				return;
+			}
+			else if ( bytecode.opcodes[o] == O_GSCompareNE )
+			{
+				bytecode.opcodes[o] = O_GSCompareNEBZ;
+				bytecode.all[ a - 1 ] = O_GSCompareNEBZ;
+				return;
+			}
+			else if ( bytecode.opcodes[o] == O_LSCompareNE )
+			{
+				bytecode.opcodes[o] = O_LSCompareNEBZ;
+				bytecode.all[ a - 1 ] = O_LSCompareNEBZ;
+				return;
+			}
+			else if ( bytecode.opcodes[o] == O_GSCompareGE )
+			{
+				bytecode.opcodes[o] = O_GSCompareGEBZ;
+				bytecode.all[ a - 1 ] = O_GSCompareGEBZ;
+				return;
+			}
+			else if ( bytecode.opcodes[o] == O_LSCompareGE )
+			{
+				bytecode.opcodes[o] = O_LSCompareGEBZ;
+				bytecode.all[ a - 1 ] = O_LSCompareGEBZ;
+				return;
+			}
+			else if ( bytecode.opcodes[o] == O_GSCompareLE )
+			{
+				bytecode.opcodes[o] = O_GSCompareLEBZ;
+				bytecode.all[ a - 1 ] = O_GSCompareLEBZ;
+				return;
+			}
+			else if ( bytecode.opcodes[o] == O_LSCompareLE )
+			{
+				bytecode.opcodes[o] = O_LSCompareLEBZ;
+				bytecode.all[ a - 1 ] = O_LSCompareLEBZ;
+				return;
+			}
+			else if ( bytecode.opcodes[o] == O_GSCompareGT )
+			{
+				bytecode.opcodes[o] = O_GSCompareGTBZ;
+				bytecode.all[ a - 1 ] = O_GSCompareGTBZ;
+				return;
+			}
+			else if ( bytecode.opcodes[o] == O_LSCompareGT )
+			{
+				bytecode.opcodes[o] = O_LSCompareGTBZ;
+				bytecode.all[ a - 1 ] = O_LSCompareGTBZ;
+				return;
+			}
+			else if ( bytecode.opcodes[o] == O_GSCompareLT )
+			{
+				bytecode.opcodes[o] = O_GSCompareLTBZ;
+				bytecode.all[ a - 1 ] = O_GSCompareLTBZ;
+				return;
+			}
+			else if ( bytecode.opcodes[o] == O_LSCompareLT )
+			{
+				bytecode.opcodes[o] = O_LSCompareLTBZ;
+				bytecode.all[ a - 1 ] = O_LSCompareLTBZ;
+				return;
+			}			
+			else if ( bytecode.opcodes[o] == O_CompareEQ ) // assign+pop is very common
+			{
+				if ( (o>1) && (bytecode.opcodes[o-1] == O_LoadFromLocal) && (bytecode.opcodes[o-2] == O_LoadFromLocal) )
+				{
+					bytecode.all[a-4] = O_LLCompareEQBZ;
+					bytecode.all[a-2] = bytecode.all[a-1];
+					bytecode.opcodes.clear();
+					bytecode.opcodes[o-2] = O_LLCompareEQBZ;
+					bytecode.all.shave(2);
+				}
+				else if ( (o>1) && (bytecode.opcodes[o-1] == O_LoadFromGlobal) && (bytecode.opcodes[o-2] == O_LoadFromGlobal) )
+				{
+					bytecode.all[a-4] = O_GGCompareEQBZ;
+					bytecode.all[a-2] = bytecode.all[a-1];
+					bytecode.opcodes.clear();
+					bytecode.opcodes[o-2] = O_GGCompareEQBZ;
+					bytecode.all.shave(2);
+				}
+				else
+				{
+					bytecode.all[a] = O_CompareBEQ;
+					bytecode.opcodes[o] = O_CompareBEQ;
+				}
+				return;
+			}
+			else if ( bytecode.opcodes[o] == O_CompareLT )
+			{
+				if ( (o>1) && (bytecode.opcodes[o-1] == O_LoadFromLocal) && (bytecode.opcodes[o-2] == O_LoadFromLocal) )
+				{
+					bytecode.all[a-4] = O_LLCompareLTBZ;
+					bytecode.all[a-2] = bytecode.all[a-1];
+					bytecode.opcodes.clear();
+					bytecode.opcodes[o-2] = O_LLCompareLTBZ;
+					bytecode.all.shave(2);
+				}
+				else if ( (o>1) && (bytecode.opcodes[o-1] == O_LoadFromGlobal) && (bytecode.opcodes[o-2] == O_LoadFromGlobal) )
+				{
+					bytecode.all[a-4] = O_GGCompareLTBZ;
+					bytecode.all[a-2] = bytecode.all[a-1];
+					bytecode.opcodes.clear();
+					bytecode.opcodes[o-2] = O_GGCompareLTBZ;
+					bytecode.all.shave(2);
+				}
+				else
+				{
+					bytecode.all[a] = O_CompareBLT;
+					bytecode.opcodes[o] = O_CompareBLT;
+				}
+				return;
+			}
+			else if ( bytecode.opcodes[o] == O_CompareGT )
+			{
+				if ( (o>1) && (bytecode.opcodes[o-1] == O_LoadFromLocal) && (bytecode.opcodes[o-2] == O_LoadFromLocal) )
+				{
+					bytecode.all[a-4] = O_LLCompareGTBZ;
+					bytecode.all[a-2] = bytecode.all[a-1];
+					bytecode.opcodes.clear();
+					bytecode.opcodes[o-2] = O_LLCompareGTBZ;
+					bytecode.all.shave(2);
+				}
+				else if ( (o>1) && (bytecode.opcodes[o-1] == O_LoadFromGlobal) && (bytecode.opcodes[o-2] == O_LoadFromGlobal) )
+				{
+					bytecode.all[a-4] = O_GGCompareGTBZ;
+					bytecode.all[a-2] = bytecode.all[a-1];
+					bytecode.opcodes.clear();
+					bytecode.opcodes[o-2] = O_GGCompareGTBZ;
+					bytecode.all.shave(2);
+				}
+				else
+				{
+					bytecode.all[a] = O_CompareBGT;
+					bytecode.opcodes[o] = O_CompareBGT;
+				}
+				return;
+			}
+			else if ( bytecode.opcodes[o] == O_CompareGE )
+			{
+				if ( (o>1) && (bytecode.opcodes[o-1] == O_LoadFromLocal) && (bytecode.opcodes[o-2] == O_LoadFromLocal) )
+				{
+					bytecode.all[a-4] = O_LLCompareGEBZ;
+					bytecode.all[a-2] = bytecode.all[a-3];
+					bytecode.all[a-3] = bytecode.all[a-1];
+					bytecode.opcodes.clear();
+					bytecode.opcodes[o-2] = O_LLCompareLTBZ;
+					bytecode.all.shave(2);
+				}
+				else if ( (o>1) && (bytecode.opcodes[o-1] == O_LoadFromGlobal) && (bytecode.opcodes[o-2] == O_LoadFromGlobal) )
+				{
+					bytecode.all[a-4] = O_GGCompareGEBZ;
+					bytecode.all[a-2] = bytecode.all[a-3];
+					bytecode.all[a-3] = bytecode.all[a-1];
+					bytecode.opcodes.clear();
+					bytecode.opcodes[o-2] = O_GGCompareLTBZ;
+					bytecode.all.shave(2);
+				}
+				else
+				{
+					bytecode.all[a] = O_CompareBGE;
+					bytecode.opcodes[o] = O_CompareBGE;
+				}
+				return;
+			}
+			else if ( bytecode.opcodes[o] == O_CompareLE )
+			{
+				if ( (o>1) && (bytecode.opcodes[o-1] == O_LoadFromLocal) && (bytecode.opcodes[o-2] == O_LoadFromLocal) )
+				{
+					bytecode.all[a-4] = O_LLCompareLEBZ;
+					bytecode.all[a-2] = bytecode.all[a-3];
+					bytecode.all[a-3] = bytecode.all[a-1];
+					bytecode.opcodes.clear();
+					bytecode.opcodes[o-2] = O_LLCompareGTBZ;
+					bytecode.all.shave(2);
+				}
+				else if ( (o>1) && (bytecode.opcodes[o-1] == O_LoadFromGlobal) && (bytecode.opcodes[o-2] == O_LoadFromGlobal) )
+				{
+					bytecode.all[a-4] = O_GGCompareLEBZ;
+					bytecode.all[a-2] = bytecode.all[a-3];
+					bytecode.all[a-3] = bytecode.all[a-1];
+					bytecode.opcodes.clear();
+					bytecode.opcodes[o-2] = O_GGCompareGTBZ;
+					bytecode.all.shave(2);
+				}
+				else
+				{
+					bytecode.all[a] = O_CompareBLE;
+					bytecode.opcodes[o] = O_CompareBLE;
+				}
+
+				return;
+			}
+			else if ( bytecode.opcodes[o] == O_CompareNE ) // assign+pop is very common
+			{
+				if ( (o>1) && (bytecode.opcodes[o-1] == O_LoadFromLocal) && (bytecode.opcodes[o-2] == O_LoadFromLocal) )
+				{
+					bytecode.all[a-4] = O_LLCompareNEBZ;
+					bytecode.all[a-2] = bytecode.all[a-1];
+					bytecode.opcodes.clear();
+					bytecode.opcodes[o-2] = O_LLCompareNEBZ;
+					bytecode.all.shave(2);
+				}
+				else if ( (o>1) && (bytecode.opcodes[o-1] == O_LoadFromGlobal) && (bytecode.opcodes[o-2] == O_LoadFromGlobal) )
+				{
+					bytecode.all[a-4] = O_GGCompareNEBZ;
+					bytecode.all[a-2] = bytecode.all[a-1];
+					bytecode.opcodes.clear();
+					bytecode.opcodes[o-2] = O_GGCompareNEBZ;
+					bytecode.all.shave(2);
+				}
+				else
+				{
+					bytecode.all[a] = O_CompareBNE;
+					bytecode.opcodes[o] = O_CompareBNE;
+				}
+				return;
+			}
+			else if ( bytecode.opcodes[o] == O_LogicalOr ) // assign+pop is very common
+			{
+				bytecode.all[a] = O_BLO;
+				bytecode.opcodes[o] = O_BLO;
+				return;
+			}
+			else if ( bytecode.opcodes[o] == O_LogicalAnd ) // assign+pop is very common
+			{
+				bytecode.all[a] = O_BLA;
+				bytecode.opcodes[o] = O_BLA;
+				return;
+			}
+		}
+		else if ( opcode == O_PopOne )
+		{
+			if ( bytecode.opcodes[o] == O_LoadFromLocal || bytecode.opcodes[o] == O_LoadFromGlobal ) 
+			{
+				bytecode.all.shave(2);
+				bytecode.opcodes.clear();
+				return;
+			}
+			else if ( bytecode.opcodes[o] == O_CallLibFunction && (a > 4) )
+			{
+				bytecode.all[a-5] = O_CallLibFunctionAndPop;
+				bytecode.opcodes[o] = O_CallLibFunctionAndPop;
+				return;
+			}
+			else if ( bytecode.opcodes[o] == O_FUNCTION_CALL_PLACEHOLDER )
+			{
+				bytecode.all[ a ] = O_PopOne;
+				return;
+			}
+			else if ( bytecode.opcodes[o] == O_PreIncrement || bytecode.opcodes[o] == O_PostIncrement )
+			{	
+				if ( (o > 0) && bytecode.opcodes[o-1] == O_LoadFromGlobal )
+				{
+					bytecode.all[ a - 2 ] = O_IncGlobal;
+										
+					bytecode.all.shave(1);
+					bytecode.opcodes.clear();
+					bytecode.opcodes += O_IncGlobal;
+				}
+				else if ( (o > 0) && bytecode.opcodes[o-1] == O_LoadFromLocal )
+				{
+					bytecode.all[ a - 2 ] = O_IncLocal;
+					bytecode.all.shave(1);
+					bytecode.opcodes.clear();
+					bytecode.opcodes += O_IncLocal;
+				}
+				else
+				{
+					bytecode.all[a] = O_PreIncrementAndPop;
+					bytecode.opcodes[o] = O_PreIncrementAndPop;
+				}
+
+				return;
+			}
+			else if ( bytecode.opcodes[o] == O_PreDecrement || bytecode.opcodes[o] == O_PostDecrement )
+			{	
+				if ( (o > 0) && bytecode.opcodes[o-1] == O_LoadFromGlobal )
+				{
+					bytecode.all[ a - 2 ] = O_DecGlobal;
+					bytecode.all.shave(1);
+					bytecode.opcodes.clear();
+					bytecode.opcodes += O_DecGlobal;
+				}
+				else if ( (o > 0) && bytecode.opcodes[o-1] == O_LoadFromLocal )
+				{
+					bytecode.all[ a - 2 ] = O_DecLocal;
+					bytecode.all.shave(1);
+					bytecode.opcodes.clear();
+					bytecode.opcodes += O_DecLocal;
+				}
+				else
+				{
+					bytecode.all[a] = O_PreDecrementAndPop;
+					bytecode.opcodes[o] = O_PreDecrementAndPop;
+				}
+				
+				return;
+			}
+			else if ( bytecode.opcodes[o] == O_Assign ) // assign+pop is very common
+			{
+				if ( o > 0 )
+				{
+					if ( bytecode.opcodes[o-1] == O_LoadFromGlobal )
+					{
+						if ( o > 1 && bytecode.opcodes[o-2] == O_LiteralInt8 )
+						{
+							// a - 4: O_literalInt8
+							// a - 3: val
+							// a - 2: load from global
+							// a - 1: index
+							// a -- assign
+
+							bytecode.all[ a - 4 ] = O_LiteralInt8ToGlobal;
+							bytecode.all[ a - 2 ] = bytecode.all[ a - 3 ];
+							bytecode.all[ a - 3 ] = bytecode.all[ a - 1 ];
+							bytecode.all.shave(2);
+							bytecode.opcodes.clear();
+						}
+						else if ( o > 1 && bytecode.opcodes[o-2] == O_LiteralInt16 )
+						{
+							bytecode.all[ a - 5 ] = O_LiteralInt16ToGlobal;
+							bytecode.all[ a - 2 ] = bytecode.all[ a - 3 ];
+							bytecode.all[ a - 3 ] = bytecode.all[ a - 4 ];
+							bytecode.all[ a - 4 ] = bytecode.all[ a - 1 ];
+							bytecode.all.shave(2);
+							bytecode.opcodes.clear();
+						}
+						else if ( o > 1 && bytecode.opcodes[o-2] == O_LiteralInt32 )
+						{
+							bytecode.all[ a - 7 ] = O_LiteralInt32ToGlobal;
+							bytecode.all[ a - 2 ] = bytecode.all[ a - 3 ];
+							bytecode.all[ a - 3 ] = bytecode.all[ a - 4 ];
+							bytecode.all[ a - 4 ] = bytecode.all[ a - 5 ];
+							bytecode.all[ a - 5 ] = bytecode.all[ a - 6 ];
+							bytecode.all[ a - 6 ] = bytecode.all[ a - 1 ];
+							bytecode.all.shave(2);
+							bytecode.opcodes.clear();
+						}
+						else if ( o > 1 && bytecode.opcodes[o-2] == O_LiteralFloat )
+						{
+							bytecode.all[ a - 7 ] = O_LiteralFloatToGlobal;
+							bytecode.all[ a - 2 ] = bytecode.all[ a - 3 ];
+							bytecode.all[ a - 3 ] = bytecode.all[ a - 4 ];
+							bytecode.all[ a - 4 ] = bytecode.all[ a - 5 ];
+							bytecode.all[ a - 5 ] = bytecode.all[ a - 6 ];
+							bytecode.all[ a - 6 ] = bytecode.all[ a - 1 ];
+							bytecode.all.shave(2);
+							bytecode.opcodes.clear();
+						}
+						else if ( (o > 1) && bytecode.opcodes[o-2] == O_LiteralZero )
+						{
+							bytecode.all[ a - 3 ] = O_LiteralInt8ToGlobal;
+							bytecode.all[ a - 2 ] = bytecode.all[ a - 1 ];
+							bytecode.all[ a - 1 ] = 0;
+							bytecode.all.shave(1);
+							bytecode.opcodes.clear();
+						}
+						else if ( (o > 1) && bytecode.opcodes[o - 2] == O_BinaryDivision )
+						{
+							bytecode.all[ a - 3 ] = O_BinaryDivisionAndStoreGlobal;
+							bytecode.all[ a - 2 ] = bytecode.all[ a - 1 ];
+							bytecode.all.shave(2);
+							bytecode.opcodes.clear();
+						}
+						else if ( (o > 1) && bytecode.opcodes[o - 2] == O_BinaryAddition )
+						{
+							bytecode.all[ a - 3 ] = O_BinaryAdditionAndStoreGlobal;
+							bytecode.all[ a - 2 ] = bytecode.all[ a - 1 ];
+							bytecode.all.shave(2);
+							bytecode.opcodes.clear();
+						}
+						else if ( (o > 1) && bytecode.opcodes[o - 2] == O_BinaryMultiplication )
+						{
+							bytecode.all[ a - 3 ] = O_BinaryMultiplicationAndStoreGlobal;
+							bytecode.all[ a - 2 ] = bytecode.all[ a - 1 ];
+							bytecode.all.shave(2);
+							bytecode.opcodes.clear();
+						}
+						else if ( (o > 1) && bytecode.opcodes[o - 2] == O_BinarySubtraction )
+						{
+							bytecode.all[ a - 3 ] = O_BinarySubtractionAndStoreGlobal;
+							bytecode.all[ a - 2 ] = bytecode.all[ a - 1 ];
+							bytecode.all.shave(2);
+							bytecode.opcodes.clear();
+						}
+						else if ( (o > 1) && bytecode.opcodes[o - 2] == O_FUNCTION_CALL_PLACEHOLDER )
+						{
+							bytecode.all[a-2] = O_AssignToGlobalAndPop;
+							bytecode.all.shave(1);
+							bytecode.opcodes[o] = O_AssignToGlobalAndPop;
+						}
+						else
+						{
+							bytecode.all[ a - 2 ] = O_AssignToGlobalAndPop;
+							bytecode.all.shave(1);
+							bytecode.opcodes.clear();
+						}
+
+						return;
+					}
+					else if ( bytecode.opcodes[ o - 1 ] == O_LoadFromLocal )
+					{
+						if ( o > 1 && bytecode.opcodes[o-2] == O_LiteralInt8 )
+						{
+							bytecode.all[ a - 4 ] = O_LiteralInt8ToLocal;
+							bytecode.all[ a - 2 ] = bytecode.all[ a - 3 ];
+							bytecode.all[ a - 3 ] = bytecode.all[ a - 1 ];
+							bytecode.all.shave(2);
+							bytecode.opcodes.clear();
+						}
+						else if ( o > 1 && bytecode.opcodes[o-2] == O_LiteralInt16 )
+						{
+							bytecode.all[ a - 5 ] = O_LiteralInt16ToLocal;
+							bytecode.all[ a - 2 ] = bytecode.all[ a - 3 ];
+							bytecode.all[ a - 3 ] = bytecode.all[ a - 4 ];
+							bytecode.all[ a - 4 ] = bytecode.all[ a - 1 ];
+							bytecode.all.shave(2);
+							bytecode.opcodes.clear();
+						}
+						else if ( o > 1 && bytecode.opcodes[o-2] == O_LiteralInt32 )
+						{
+							bytecode.all[ a - 7 ] = O_LiteralInt32ToLocal;
+							bytecode.all[ a - 2 ] = bytecode.all[ a - 3 ];
+							bytecode.all[ a - 3 ] = bytecode.all[ a - 4 ];
+							bytecode.all[ a - 4 ] = bytecode.all[ a - 5 ];
+							bytecode.all[ a - 5 ] = bytecode.all[ a - 6 ];
+							bytecode.all[ a - 6 ] = bytecode.all[ a - 1 ];
+							bytecode.all.shave(2);
+							bytecode.opcodes.clear();
+						}
+						else if ( o > 1 && bytecode.opcodes[o-2] == O_LiteralFloat )
+						{
+							bytecode.all[ a - 7 ] = O_LiteralFloatToLocal;
+							bytecode.all[ a - 2 ] = bytecode.all[ a - 3 ];
+							bytecode.all[ a - 3 ] = bytecode.all[ a - 4 ];
+							bytecode.all[ a - 4 ] = bytecode.all[ a - 5 ];
+							bytecode.all[ a - 5 ] = bytecode.all[ a - 6 ];
+							bytecode.all[ a - 6 ] = bytecode.all[ a - 1 ];
+							bytecode.all.shave(2);
+							bytecode.opcodes.clear();
+						}
+						else if ( o > 1 && bytecode.opcodes[o-2] == O_LiteralZero )
+						{
+							bytecode.all[ a - 3 ] = O_LiteralInt8ToLocal;
+							bytecode.all[ a - 2 ] = bytecode.all[ a - 1 ];
 							bytecode.all[ a - 1 ] = 0;
 							bytecode.all.shave(1);
 							bytecode.opcodes.clear();
 						}
-						else if ( (o > 1) && bytecode.opcodes[o - 2] == O_BinaryDivision )
+						else if ( o > 1 && bytecode.opcodes[o - 2] == O_BinaryDivision )
+						{
+							bytecode.all[ a - 3 ] = O_BinaryDivisionAndStoreLocal;
+							bytecode.all[ a - 2 ] = bytecode.all[ a - 1 ];
+							bytecode.all.shave(2);
+							bytecode.opcodes.clear();
+						}
+						else if ( o > 1 && bytecode.opcodes[o - 2] == O_BinaryAddition )
+						{
+							bytecode.all[ a - 3 ] = O_BinaryAdditionAndStoreLocal;
+							bytecode.all[ a - 2 ] = bytecode.all[ a - 1 ];
+							bytecode.all.shave(2);
+							bytecode.opcodes.clear();
+						}
+						else if ( o > 1 && bytecode.opcodes[o - 2] == O_BinaryMultiplication )
+						{
+							bytecode.all[ a - 3 ] = O_BinaryMultiplicationAndStoreLocal;
+							bytecode.all[ a - 2 ] = bytecode.all[ a - 1 ];
+							bytecode.all.shave(2);
+							bytecode.opcodes.clear();
+						}
+						else if ( o > 1 && bytecode.opcodes[o - 2] == O_BinarySubtraction )
+						{
+							bytecode.all[ a - 3 ] = O_BinarySubtractionAndStoreLocal;
+							bytecode.all[ a - 2 ] = bytecode.all[ a - 1 ];
+							bytecode.all.shave(2);
+							bytecode.opcodes.clear();
+						}
+						else
+						{
+							bytecode.all[ a - 2 ] = O_AssignToLocalAndPop;
+							bytecode.all.shave(1);
+							bytecode.opcodes.clear();
+						}
+						return;
+					}
+				}
+								
+				bytecode.all[a] = O_AssignAndPop;
+				bytecode.opcodes[o] = O_AssignAndPop;
+				return;
+			}
+			else if ( bytecode.opcodes[o] == O_LiteralZero ) // put a zero on just to pop it off..
+			{
+				bytecode.opcodes.clear();
+				bytecode.all.shave(1);
+				return;
+			}
+			else if ( bytecode.opcodes[o] == O_SubtractAssign )
+			{
+				bytecode.all[a] = O_SubtractAssignAndPop;
+				bytecode.opcodes[o] = O_SubtractAssignAndPop;
+				return;
+			}
+			else if ( bytecode.opcodes[o] == O_AddAssign )
+			{
+				bytecode.all[a] = O_AddAssignAndPop;
+				bytecode.opcodes[o] = O_AddAssignAndPop;
+				return;
+			}
+			else if ( bytecode.opcodes[o] == O_ModAssign )
+			{
+				bytecode.all[a] = O_ModAssignAndPop;
+				bytecode.opcodes[o] = O_ModAssignAndPop;
+				return;
+			}
+			else if ( bytecode.opcodes[o] == O_MultiplyAssign )
+			{
+				bytecode.all[a] = O_MultiplyAssignAndPop;
+				bytecode.opcodes[o] = O_MultiplyAssignAndPop;
+				return;
+			}
+			else if ( bytecode.opcodes[o] == O_DivideAssign )
+			{
+				bytecode.all[a] = O_DivideAssignAndPop;
+				bytecode.opcodes[o] = O_DivideAssignAndPop;
+				return;
+			}
+			else if ( bytecode.opcodes[o] == O_ORAssign )
+			{
+				bytecode.all[a] = O_ORAssignAndPop;
+				bytecode.opcodes[o] = O_ORAssignAndPop;
+				return;
+			}
+			else if ( bytecode.opcodes[o] == O_ANDAssign )
+			{
+				bytecode.all[a] = O_ANDAssignAndPop;
+				bytecode.opcodes[o] = O_ANDAssignAndPop;
+				return;
+			}
+			else if ( bytecode.opcodes[o] == O_XORAssign )
+			{
+				bytecode.all[a] = O_XORAssignAndPop;
+				bytecode.opcodes[o] = O_XORAssignAndPop;
+				return;
+			}
+			else if ( bytecode.opcodes[o] == O_RightShiftAssign )
+			{
+				bytecode.all[a] = O_RightShiftAssignAndPop;
+				bytecode.opcodes[o] = O_RightShiftAssignAndPop;
+				return;
+			}
+			else if ( bytecode.opcodes[o] == O_LeftShiftAssign )
+			{
+				bytecode.all[a] = O_LeftShiftAssignAndPop;
+				bytecode.opcodes[o] = O_LeftShiftAssignAndPop;
+				return;
+			}
+		}
+	}
+
+	MarkSuperinstruction( opcode, bytecode );
+#endif
+	bytecode.all += opcode;
+	bytecode.opcodes += opcode;
+}
+
+//------------------------------------------------------------------------------
+void WRCompilationContext::appendBytecode( WRBytecode& bytecode, WRBytecode& addMe )
+{
+	for (unsigned int n = 0; n < addMe.jumpOffsetTargets.count(); ++n)
+	{
+		if (addMe.jumpOffsetTargets[n].gotoHash)
+		{
+			int index = addRelativeJumpTarget(bytecode);
+			bytecode.jumpOffsetTargets[index].gotoHash = addMe.jumpOffsetTargets[n].gotoHash;
+			bytecode.jumpOffsetTargets[index].offset = addMe.jumpOffsetTargets[n].offset + bytecode.all.size();
+		}
+	}
+
+	// add the namespace, making sure to offset it into the new block properly
+	for (unsigned int n = 0; n < addMe.localSpace.count(); ++n)
+	{
+		// addMe usually started as a copy of this space so the symbol
+		// is most often in the same slot
+		int m = (n < bytecode.localSpace.count() && bytecode.localSpace[n].hash == addMe.localSpace[n].hash)
+				? (int)n
+				: bytecode.findLocal( addMe.localSpace[n].hash );
+
+		if (m >= 0)
+		{
+			for (unsigned int s = 0; s < addMe.localSpace[n].references.count(); ++s)
+			{
+				bytecode.localSpace[m].references.append() = addMe.localSpace[n].references[s] + bytecode.all.size();
+			}
+		}
+		else
+		{
+			WRNamespaceLookup* space = &bytecode.localSpace.append();
+			*space = addMe.localSpace[n];
+			for (unsigned int s = 0; s < space->references.count(); ++s)
+			{
+				space->references[s] += bytecode.all.size();
+			}
+		}
+	}
+
+	// add the function space, making sure to offset it into the new block properly
+	for (unsigned int n = 0; n < addMe.functionSpace.count(); ++n)
+	{
+		WRNamespaceLookup* space = &bytecode.functionSpace.append();
+		*space = addMe.functionSpace[n];
+		for (unsigned int s = 0; s < space->references.count(); ++s)
+		{
+			space->references[s] += bytecode.all.size();
+		}
+	}
+
+	// add the function space, making sure to offset it into the new block properly
+	for (unsigned int u = 0; u < addMe.unitObjectSpace.count(); ++u)
+	{
+		WRNamespaceLookup* space = &bytecode.unitObjectSpace.append();
+		*space = addMe.unitObjectSpace[u];
+		for (unsigned int s = 0; s < space->references.count(); ++s)
+		{
+			space->references[s] += bytecode.all.size();
+		}
+	}
+
+	// add the goto targets, making sure to offset it into the new block properly
+	for (unsigned int u = 0; u < addMe.gotoSource.count(); ++u)
+	{
+		GotoSource* G = &bytecode.gotoSource.append();
+		G->hash = addMe.gotoSource[u].hash;
+		G->offset = addMe.gotoSource[u].offset + bytecode.all.size();
+	}
+
+	if ( bytecode.all.size() > 1
+		 && bytecode.opcodes.size() > 0
+		 && addMe.opcodes.size() == 1
+		 && addMe.all.size() > 2
+		 && addMe.gotoSource.count() == 0
+		 && addMe.opcodes[0] == O_IndexLiteral16
+		 && bytecode.opcodes[bytecode.opcodes.size() - 1] == O_LoadFromLocal )
+	{
+		bytecode.all[bytecode.all.size()-2] = O_IndexLocalLiteral16;
+		for( unsigned int i=1; i<addMe.all.size(); ++i )
+		{
+			bytecode.all += addMe.all[i];	
+		}
+		bytecode.opcodes.clear();
+		bytecode.opcodes += O_IndexLocalLiteral16;
+		return;
+	}
+	else if ( bytecode.all.size() > 1
+			  && bytecode.opcodes.size() > 0
+			  && addMe.opcodes.size() == 1
+			  && addMe.all.size() > 2
+			  && addMe.gotoSource.count() == 0
+			  && addMe.opcodes[0] == O_IndexLiteral16
+			  && bytecode.opcodes[bytecode.opcodes.size() - 1] == O_LoadFromGlobal )
+	{
+		bytecode.all[bytecode.all.size()-2] = O_IndexGlobalLiteral16;
+		for( unsigned int i=1; i<addMe.all.size(); ++i )
+		{
+			bytecode.all += addMe.all[i];	
+		}
+		bytecode.opcodes.clear();
+		bytecode.opcodes += O_IndexGlobalLiteral16;
+		return;
+	}
+	else if ( bytecode.all.size() > 1
+			  && bytecode.opcodes.size() > 0
+			  && addMe.opcodes.size() == 1
+			  && addMe.all.size() > 1
+			  && addMe.gotoSource.count() == 0
+			  && addMe.opcodes[0] == O_IndexLiteral8
+			  && bytecode.opcodes[bytecode.opcodes.size() - 1] == O_LoadFromLocal )
+	{
+		bytecode.all[bytecode.all.size()-2] = O_IndexLocalLiteral8;
+		for( unsigned int i=1; i<addMe.all.size(); ++i )
+		{
+			bytecode.all += addMe.all[i];	
+		}
+		bytecode.opcodes.clear();
+		bytecode.opcodes += O_IndexLocalLiteral8;
+		return;
+	}
+	else if ( bytecode.all.size() > 1
+			  && bytecode.opcodes.size() > 0
+			  && addMe.opcodes.size() == 1
+			  && addMe.all.size() > 1
+			  && addMe.gotoSource.count() == 0
+			  && addMe.opcodes[0] == O_IndexLiteral8
+			  && bytecode.opcodes[bytecode.opcodes.size() - 1] == O_LoadFromGlobal )
+	{
+		bytecode.all[bytecode.all.size()-2] = O_IndexGlobalLiteral8;
+		for( unsigned int i=1; i<addMe.all.size(); ++i )
+		{
+			bytecode.all += addMe.all[i];	
+		}
+		bytecode.opcodes.clear();
+		bytecode.opcodes += O_IndexGlobalLiteral8;
+		return;
+	}
+	else if ( bytecode.all.size() > 0
+			  && bytecode.opcodes.size() > 0
+			  && addMe.opcodes.size() == 2
+			  && addMe.gotoSource.count() == 0
+			  && addMe.all.size() == 3
+			  && addMe.opcodes[1] == O_Index )
+	{
+		if ( bytecode.opcodes[bytecode.opcodes.size() - 1] == O_LoadFromLocal
+			 && addMe.opcodes[0] == O_LoadFromLocal )
+		{
+			int a = bytecode.all.size() - 1;
+
+			addMe.all[0] = bytecode.all[a];
+			bytecode.all[a] = addMe.all[1];
+			bytecode.all[a-1] = O_LLValues;
+			bytecode.all += addMe.all[0];
+			bytecode.all += O_IndexSkipLoad;
+
+			bytecode.opcodes += O_LoadFromLocal;
+			bytecode.opcodes += O_IndexSkipLoad;
+			return;
+		}
+		else if ( bytecode.opcodes[bytecode.opcodes.size() - 1] == O_LoadFromGlobal
+				  && addMe.opcodes[0] == O_LoadFromGlobal )
+		{
+			int a = bytecode.all.size() - 1;
+
+			addMe.all[0] = bytecode.all[a];
+			bytecode.all[a] = addMe.all[1];
+			bytecode.all[a-1] = O_GGValues;
+			bytecode.all += addMe.all[0];
+			bytecode.all += O_IndexSkipLoad;
+
+			bytecode.opcodes += O_LoadFromLocal;
+			bytecode.opcodes += O_IndexSkipLoad;
+			return;
+		}
+		else if ( bytecode.opcodes[bytecode.opcodes.size() - 1] == O_LoadFromLocal
+				  && addMe.opcodes[0] == O_LoadFromGlobal )
+		{
+			int a = bytecode.all.size() - 1;
+
+			addMe.all[0] = bytecode.all[a];
+			bytecode.all[a] = addMe.all[1];
+			bytecode.all[a-1] = O_GLValues;
+			bytecode.all += addMe.all[0];
+			bytecode.all += O_IndexSkipLoad;
+
+			bytecode.opcodes += O_LoadFromLocal;
+			bytecode.opcodes += O_IndexSkipLoad;
+			return;
+		}
+		else if ( bytecode.opcodes[bytecode.opcodes.size() - 1] == O_LoadFromGlobal
+				  && addMe.opcodes[0] == O_LoadFromLocal )
+		{
+			int a = bytecode.all.size() - 1;
+
+			addMe.all[0] = bytecode.all[a];
+			bytecode.all[a] = addMe.all[1];
+			bytecode.all[a-1] = O_LGValues;
+			bytecode.all += addMe.all[0];
+			bytecode.all += O_IndexSkipLoad;
+
+			bytecode.opcodes += O_LoadFromLocal;
+			bytecode.opcodes += O_IndexSkipLoad;
+			return;
+		}
+	}
+	else if ( addMe.all.size() == 1 )
+	{
+		if ( addMe.opcodes[0] == O_HASH_PLACEHOLDER )
+		{
+			if ( bytecode.opcodes.size() > 1
+				 && bytecode.opcodes[ bytecode.opcodes.size() - 2 ] == O_LiteralInt32
+				 && bytecode.opcodes[ bytecode.opcodes.size() - 1 ] == O_LoadFromLocal )
+			{
+				int o = bytecode.all.size() - 7;
+
+				bytecode.all[o] = O_LocalIndexHash;
+				bytecode.all[o + 5] = bytecode.all[o + 4];
+				bytecode.all[o + 4] = bytecode.all[o + 3];
+				bytecode.all[o + 3] = bytecode.all[o + 2];
+				bytecode.all[o + 2] = bytecode.all[o + 1];
+				bytecode.all[o + 1] = bytecode.all[o + 6];
+
+				bytecode.opcodes.clear();
+				bytecode.all.shave(1);
+			}
+			else if (bytecode.opcodes.size() > 1
+					 && bytecode.opcodes[ bytecode.opcodes.size() - 2 ] == O_LiteralInt32
+					 && bytecode.opcodes[ bytecode.opcodes.size() - 1 ] == O_LoadFromGlobal )
+			{
+				int o = bytecode.all.size() - 7;
+
+				bytecode.all[o] = O_GlobalIndexHash;
+				bytecode.all[o + 5] = bytecode.all[o + 4];
+				bytecode.all[o + 4] = bytecode.all[o + 3];
+				bytecode.all[o + 3] = bytecode.all[o + 2];
+				bytecode.all[o + 2] = bytecode.all[o + 1];
+				bytecode.all[o + 1] = bytecode.all[o + 6];
+
+				bytecode.opcodes.clear();
+				bytecode.all.shave(1);
+			}
+			else if (bytecode.opcodes.size() > 1
+					 && bytecode.opcodes[ bytecode.opcodes.size() - 2 ] == O_LiteralInt32
+					 && bytecode.opcodes[ bytecode.opcodes.size() - 1 ] == O_StackSwap )
+			{
+				int a = bytecode.all.size() - 7;
+
+				bytecode.all[a] = O_StackIndexHash;
+
+				bytecode.opcodes.clear();
+				bytecode.all.shave(2);
+
+			}
+			else
+			{
+				m_err = WR_ERR_compiler_panic;
+			}
+
+			return;
+		}
+
+		pushOpcode( bytecode, (WROpcode)addMe.opcodes[0] );
+		return;
+	}
+
+	resolveRelativeJumps( addMe );
+
+	bytecode.all += addMe.all;
+	bytecode.opcodes += addMe.opcodes;
+}
+
+
+#endif
+/*******************************************************************************
+Copyright (c) 2024 Curt Hartung -- curt.hartung@gmail.com
+
+MIT Licence
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*******************************************************************************/
+
+#include "wrench.h"
+#ifndef WRENCH_WITHOUT_COMPILER
+
+//------------------------------------------------------------------------------
+int wr_strnlen( const char* s, int len )
+{
+	const char* found = (const char *)memchr( s, '\0', len );
+	return found ? (found - s) : len;
+}
+
+// what getToken() needs to know about a character, looked up rather than
+// asked of the locale
+#define WR_CHAR_SPACE      0x01 // isspace()
+#define WR_CHAR_DIGIT      0x02
+#define WR_CHAR_ALPHA      0x04
+#define WR_CHAR_UNDERSCORE 0x08
+#define WR_CHAR_HEX        0x10
+#define WR_CHAR_PLAIN      0x20 // goes into a string literal as it is
+#define WR_CHAR_ALNUM      (WR_CHAR_DIGIT | WR_CHAR_ALPHA)
+#define WR_CHAR_LABEL      (WR_CHAR_ALNUM | WR_CHAR_UNDERSCORE)
+#define WR_CHAR_IS( C, CLASS ) (c_charClass[(uint8_t)(C)] & (CLASS))
+
+const uint8_t c_charClass[256] =
+{
+	0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x21, 0x01, 0x21, 0x21, 0x21, 0x20, 0x20,
+	0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20,
+	0x21, 0x20, 0x00, 0x20, 0x20, 0x20, 0x20, 0x00, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20,
+	0x32, 0x32, 0x32, 0x32, 0x32, 0x32, 0x32, 0x32, 0x32, 0x32, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20,
+	0x20, 0x34, 0x34, 0x34, 0x34, 0x34, 0x34, 0x24, 0x24, 0x24, 0x24, 0x24, 0x24, 0x24, 0x24, 0x24,
+	0x24, 0x24, 0x24, 0x24, 0x24, 0x24, 0x24, 0x24, 0x24, 0x24, 0x24, 0x20, 0x00, 0x20, 0x20, 0x28,
+	0x20, 0x34, 0x34, 0x34, 0x34, 0x34, 0x34, 0x24, 0x24, 0x24, 0x24, 0x24, 0x24, 0x24, 0x24, 0x24,
+	0x24, 0x24, 0x24, 0x24, 0x24, 0x24, 0x24, 0x24, 0x24, 0x24, 0x24, 0x20, 0x20, 0x20, 0x20, 0x20,
+	0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20,
+	0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20,
+	0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20,
+	0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20,
+	0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20,
+	0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20,
+	0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20,
+	0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20,
+};
+
+//------------------------------------------------------------------------------
+bool WRCompilationContext::getToken( WRExpressionContext& ex, const char* expect )
+{
+	WRValue& value = ex.value;
+	WRstr& token = ex.token;
+	
+	if ( m_loadedToken.size() || (m_loadedValue.type != WR_REF) )
+	{
+		token = m_loadedToken;
+		value = m_loadedValue;
+		m_quoted = m_loadedQuoted;
+	}
+	else
+	{
+		m_quoted = false;
+		value.p2 = INIT_AS_REF;
+
+		ex.spaceBefore = (m_pos < m_sourceLen) && WR_CHAR_IS( m_source[m_pos], WR_CHAR_SPACE );
+
+		for( ; m_pos < m_sourceLen && WR_CHAR_IS(m_source[m_pos], WR_CHAR_SPACE); ++m_pos );
+		if ( m_pos >= m_sourceLen )
+		{
+			m_EOF = true;
+			return false;
+		}
+
+		token = m_source[m_pos++];
+
+		// the first character rules out most macros and constants before
+		// they are compared
+		unsigned int t = m_macros;
+		int offset = m_pos - 1;
+
+		for( ; c_operations[t].token; ++t )
+		{
+			if ( c_operations[t].token[0] != m_source[offset] )
+			{
+				continue;
+			}
+
+			int len = wr_strnlen( c_operations[t].token, 20 );
+			if ( ((offset + len) < m_sourceLen)
+				 && !strncmp(m_source + offset, c_operations[t].token, len) )
+			{
+				if ( WR_CHAR_IS(m_source[offset+len], WR_CHAR_ALNUM) )
+				{
+					continue;
+				}
+				
+				m_pos += len - 1;
+				token = c_operations[t].token;
+				goto foundMacroToken;
+			}
+		}
+
+		for( t = 0; t<m_units[0].constantValues.count(); ++t )
+		{
+			int len = m_units[0].constantValues[t].label.size();
+			if ( len
+				 && m_units[0].constantValues[t].label[0] == m_source[offset]
+				 && ((offset + len) < m_sourceLen)
+				 && !strncmp(m_source + offset, m_units[0].constantValues[t].label.c_str(), len) )
+			{
+				if ( WR_CHAR_IS(m_source[offset+len], WR_CHAR_ALNUM) )
+				{
+					continue;
+				}
+
+				m_pos += len - 1;
+				token.clear();
+				value = m_units[0].constantValues[t].value;
+				goto foundMacroToken;
+			}
+		}
+
+		for( t = 0; t<m_units[m_unitTop].constantValues.count(); ++t )
+		{
+			int len = m_units[m_unitTop].constantValues[t].label.size();
+			if ( len
+				 && m_units[m_unitTop].constantValues[t].label[0] == m_source[offset]
+				 && ((offset + len) < m_sourceLen)
+				 && !strncmp(m_source + offset, m_units[m_unitTop].constantValues[t].label.c_str(), len) )
+			{
+				if ( WR_CHAR_IS(m_source[offset+len], WR_CHAR_ALNUM) )
+				{
+					continue;
+				}
+
+				m_pos += len - 1;
+				token.clear();
+				value = m_units[m_unitTop].constantValues[t].value;
+				goto foundMacroToken;
+			}
+		}
+
+		if ( token[0] == '-' )
+		{
+			if ( m_pos < m_sourceLen )
+			{
+				if ( (WR_CHAR_IS(m_source[m_pos], WR_CHAR_DIGIT) && !m_LastParsedLabel) || m_source[m_pos] == '.' )
+				{
+					goto parseAsNumber;
+				}
+				else if ( m_source[m_pos] == '-' )
+				{
+					token += '-';
+					++m_pos;
+				}
+				else if ( m_source[m_pos] == '=' )
+				{
+					token += '=';
+					++m_pos;
+				}
+			}
+		}
+		else
+		{
+			m_LastParsedLabel = false;
+		
+			if ( token[0] == '=' )
+			{
+				if ( (m_pos < m_sourceLen) && m_source[m_pos] == '=' )
+				{
+					token += '=';
+					++m_pos;
+				}
+			}
+			else if ( token[0] == '!' )
+			{
+				if ( (m_pos < m_sourceLen) && m_source[m_pos] == '=' )
+				{
+					token += '=';
+					++m_pos;
+				}
+			}
+			else if ( token[0] == '*' )
+			{
+				if ( (m_pos < m_sourceLen) && m_source[m_pos] == '=' )
+				{
+					token += '=';
+					++m_pos;
+				}
+			}
+			else if ( token[0] == '%' )
+			{
+				if ( (m_pos < m_sourceLen) && m_source[m_pos] == '=' )
+				{
+					token += '=';
+					++m_pos;
+				}
+			}
+			else if ( token[0] == '<' )
+			{
+				if ( (m_pos < m_sourceLen) && m_source[m_pos] == '=' )
+				{
+					token += '=';
+					++m_pos;
+				}
+				else if ( (m_pos < m_sourceLen) && m_source[m_pos] == '<' )
+				{
+					token += '<';
+					++m_pos;
+
+					if ( (m_pos < m_sourceLen) && m_source[m_pos] == '=' )
+					{
+						token += '=';
+						++m_pos;
+					}
+				}
+			}
+			else if ( token[0] == '>' )
+			{
+				if ( (m_pos < m_sourceLen) && m_source[m_pos] == '=' )
+				{
+					token += '=';
+					++m_pos;
+				}
+				else if ( (m_pos < m_sourceLen) && m_source[m_pos] == '>' )
+				{
+					token += '>';
+					++m_pos;
+
+					if ( (m_pos < m_sourceLen) && m_source[m_pos] == '=' )
+					{
+						token += '=';
+						++m_pos;
+					}
+				}
+			}
+			else if ( token[0] == '&' )
+			{
+				if ( (m_pos < m_sourceLen) && m_source[m_pos] == '&' )
+				{
+					token += '&';
+					++m_pos;
+				}
+				else if ( (m_pos < m_sourceLen) && m_source[m_pos] == '=' )
+				{
+					token += '=';
+					++m_pos;
+				}
+			}
+			else if ( token[0] == '^' )
+			{
+				if ( (m_pos < m_sourceLen) && m_source[m_pos] == '=' )
+				{
+					token += '=';
+					++m_pos;
+				}
+			}
+			else if ( token[0] == '|' )
+			{
+				if ( (m_pos < m_sourceLen) && m_source[m_pos] == '|' )
+				{
+					token += '|';
+					++m_pos;
+				}
+				else if ( (m_pos < m_sourceLen) && m_source[m_pos] == '=' )
+				{
+					token += '=';
+					++m_pos;
+				}
+			}
+			else if ( token[0] == '+' )
+			{
+				if ( m_pos < m_sourceLen )
+				{
+					if ( m_source[m_pos] == '+' )
+					{
+						token += '+';
+						++m_pos;
+					}
+					else if ( m_source[m_pos] == '=' )
+					{
+						token += '=';
+						++m_pos;
+					}
+				}
+			}
+			else if ( token[0] == '\"' || token[0] == '\'' )
+			{
+				bool single = token[0] == '\'';
+				token.clear();
+				m_quoted = true;
+				
+				do
+				{
+					if (m_pos >= m_sourceLen)
+					{
+						m_err = WR_ERR_unterminated_string_literal;
+						m_EOF = true;
+						return false;
+					}
+
+					char c = m_source[m_pos];
+					if (c == '\"' && !single ) // terminating character
+					{
+						if ( single )
+						{
+							m_err = WR_ERR_bad_expression;
+							return false;
+						}
+						++m_pos;
+						break;
+					}
+					else if ( c == '\'' && single )
+					{
+						if ( !single || (token.size() > 1) )
 						{
-							bytecode.all[ a - 3 ] = O_BinaryDivisionAndStoreGlobal;
-							bytecode.all[ a - 2 ] = bytecode.all[ a - 1 ];
-							bytecode.all.shave(2);
-							bytecode.opcodes.clear();
+							m_err = WR_ERR_bad_expression;
+							return false;
 						}
-						else if ( (o > 1) && bytecode.opcodes[o - 2] == O_BinaryAddition )
+						++m_pos;
+						break;
+					}
+					else if (c == '\n')
+					{
+						m_err = WR_ERR_newline_in_string_literal;
+						return false;
+					}
+					else if (c == '\\')
+					{
+						c = m_source[++m_pos];
+						if (m_pos >= m_sourceLen)
 						{
-							bytecode.all[ a - 3 ] = O_BinaryAdditionAndStoreGlobal;
-							bytecode.all[ a - 2 ] = bytecode.all[ a - 1 ];
-							bytecode.all.shave(2);
-							bytecode.opcodes.clear();
+							m_err = WR_ERR_unterminated_string_literal;
+							m_EOF = true;
+							return false;
 						}
-						else if ( (o > 1) && bytecode.opcodes[o - 2] == O_BinaryMultiplication )
+
+						if (c == '\\') // escaped slash
 						{
-							bytecode.all[ a - 3 ] = O_BinaryMultiplicationAndStoreGlobal;
-							bytecode.all[ a - 2 ] = bytecode.all[ a - 1 ];
-							bytecode.all.shave(2);
-							bytecode.opcodes.clear();
+							token += '\\';
+						}
+						else if (c == '0')
+						{
+							token += atoi(m_source + m_pos);
+							for (; (m_pos < m_sourceLen) && isdigit(m_source[m_pos]); ++m_pos);
+							--m_pos;
+						}
+						else if (c == '\"')
+						{
+							token += '\"';
+						}
+						else if (c == '\'')
+						{
+							token += '\'';
+						}
+						else if (c == 'n')
+						{
+							token += '\n';
+						}
+						else if (c == 'r')
+						{
+							token += '\r';
+						}
+						else if (c == 't')
+						{
+							token += '\t';
+						}
+						else
+						{
+							m_err = WR_ERR_bad_string_escape_sequence;
+							return false;
+						}
+					}
+					else
+					{
+						// and everything up to the next character that needs a look
+						const int run = m_pos;
+						for( ; m_pos + 1 < m_sourceLen && WR_CHAR_IS(m_source[m_pos + 1], WR_CHAR_PLAIN); ++m_pos );
+						token.append( m_source + run, m_pos - run + 1 );
+					}
+
+				} while( ++m_pos < m_sourceLen );
+
+				value.p2 = INIT_AS_INT;
+				if ( single )
+				{
+					value.ui = token.size() == 1 ? token[0] : 0;
+					token.clear();
+				}
+				else
+				{
+					value.p2 = INIT_AS_INT;
+					value.type = (WRValueType)WR_COMPILER_LITERAL_STRING;
+					value.p = &token;
+				}
+			}
+			else if ( token[0] == '/' ) // might be a comment
+			{
+				if ( m_pos < m_sourceLen )
+				{	
+					if ( !WR_CHAR_IS(m_source[m_pos], WR_CHAR_SPACE) )
+					{
+						if ( m_source[m_pos] == '/' )
+						{
+							// clear to end EOL
+							const char* end = (const char*)memchr( m_source + m_pos, '\n', m_sourceLen - m_pos );
+							m_pos = end ? (int)(end - m_source) : m_sourceLen;
+
+							return getToken( ex, expect );
+						}
+						else if ( m_source[m_pos] == '*' )
+						{
+							// find end of comment, from one '*' to the next
+							for(;;)
+							{
+								const char* star = (const char*)memchr( m_source + m_pos, '*', m_sourceLen - 1 - m_pos );
+								if ( !star )
+								{
+									m_pos = m_sourceLen - 1;
+									break;
+								}
+
+								m_pos = (int)(star - m_source);
+								if ( m_source[m_pos + 1] == '/' )
+								{
+									break;
+								}
+								++m_pos;
+							}
+
+							m_pos += 2;
+
+							return getToken( ex, expect );
+
+						}
+						else if ( m_source[m_pos] == '=' )
+						{
+							token += '=';
+							++m_pos;
+						}
+					}					
+					//else // bare '/' 
+				}
+			}
+			else if ( WR_CHAR_IS(token[0], WR_CHAR_DIGIT)
+					  || (token[0] == '.' && WR_CHAR_IS(m_source[m_pos], WR_CHAR_DIGIT)) )
+			{
+				if ( m_pos >= m_sourceLen )
+				{
+					return false;
+				}
+
+parseAsNumber:
+
+				m_LastParsedLabel = true;
+
+				if ( token[0] == '0' && m_source[m_pos] == 'x' ) // interpret as hex
+				{
+					const int start = ++m_pos;
+
+					for(;;)
+					{
+						if ( m_pos >= m_sourceLen )
+						{
+							m_err = WR_ERR_unexpected_EOF;
+							return false;
+						}
+
+						if ( !WR_CHAR_IS(m_source[m_pos], WR_CHAR_HEX) )
+						{
+							break;
+						}
+
+						++m_pos;
+					}
+					token.set( m_source + start, m_pos - start );
+
+					value.p2 = INIT_AS_INT;
+					value.ui = strtoul( token, 0, 16 );
+				}
+				else if (token[0] == '0' && m_source[m_pos] == 'b' )
+				{
+					const int start = ++m_pos;
+
+					for(;;)
+					{
+						if ( m_pos >= m_sourceLen )
+						{
+							m_err = WR_ERR_unexpected_EOF;
+							return false;
+						}
+
+						if ( !WR_CHAR_IS(m_source[m_pos], WR_CHAR_HEX) )
+						{
+							break;
+						}
+
+						++m_pos;
+					}
+					token.set( m_source + start, m_pos - start );
+
+					value.p2 = INIT_AS_INT;
+					value.i = strtol( token, 0, 2 );
+				}
+				else if (token[0] == '0' && WR_CHAR_IS(m_source[m_pos], WR_CHAR_DIGIT) ) // octal
+				{
+					const int start = m_pos;
+
+					for(;;)
+					{
+						if ( m_pos >= m_sourceLen )
+						{
+							m_err = WR_ERR_unexpected_EOF;
+							return false;
+						}
+
+						if ( !WR_CHAR_IS(m_source[m_pos], WR_CHAR_DIGIT) )
+						{
+							break;
+						}
+
+						++m_pos;
+					}
+					token.set( m_source + start, m_pos - start );
+
+					value.p2 = INIT_AS_INT;
+					value.i = strtol( token, 0, 8 );
+				}
+				else
+				{
+					bool decimal = token[0] == '.';
+					const int start = m_pos - token.size();
+					for(;;)
+					{
+						if ( m_pos >= m_sourceLen )
+						{
+							m_err = WR_ERR_unexpected_EOF;
+							return false;
+						}
+
+						if ( m_source[m_pos] == '.' )
+						{
+							if ( decimal )
+							{
+								return false;
+							}
+
+							decimal = true;
 						}
-						else if ( (o > 1) && bytecode.opcodes[o - 2] == O_BinarySubtraction )
+						else if ( !WR_CHAR_IS(m_source[m_pos], WR_CHAR_DIGIT) )
 						{
-							bytecode.all[ a - 3 ] = O_BinarySubtractionAndStoreGlobal;
-							bytecode.all[ a - 2 ] = bytecode.all[ a - 1 ];
-							bytecode.all.shave(2);
-							bytecode.opcodes.clear();
+							break;
 						}
-						else if ( (o > 1) && bytecode.opcodes[o - 2] == O_FUNCTION_CALL_PLACEHOLDER )
+
+						++m_pos;
+					}
+					token.set( m_source + start, m_pos - start );
+
+					if ( m_source[m_pos] == 'f' || m_source[m_pos] == 'F' )
+					{
+						decimal = true;
+						m_pos++;
+					}
+
+					if ( decimal )
+					{
+						value.p2 = INIT_AS_FLOAT;
+						value.f = (float)atof( token );
+					}
+					else
+					{
+						value.p2 = INIT_AS_INT;
+						value.ui = (uint32_t)strtoul( token, 0, 10 );
+					}
+				}
+			}
+			else if ( token[0] == ':' && WR_CHAR_IS(m_source[m_pos], WR_CHAR_SPACE) )
+			{
+				
+			}
+			else if ( WR_CHAR_IS(token[0], WR_CHAR_ALPHA | WR_CHAR_UNDERSCORE) || token[0] == ':' ) // must be a label
+			{
+				if ( token[0] != ':' || m_source[m_pos] == ':' )
+				{
+					m_LastParsedLabel = true;
+					if ( m_pos < m_sourceLen
+						 && token[0] == ':'
+						 && m_source[m_pos] == ':' )
+					{
+						++m_pos;
+					}
+
+					// it is copied out of the source once its end is found
+					for (; m_pos < m_sourceLen; ++m_pos)
+					{
+						if ( m_source[m_pos] == ':' && m_source[m_pos + 1] == ':' )
 						{
-							bytecode.all[a-2] = O_AssignToGlobalAndPop;
-							bytecode.all.shave(1);
-							bytecode.opcodes[o] = O_AssignToGlobalAndPop;
+							m_pos ++;
+							continue;
 						}
-						else
+						
+						if ( !WR_CHAR_IS(m_source[m_pos], WR_CHAR_LABEL) )
 						{
-							bytecode.all[ a - 2 ] = O_AssignToGlobalAndPop;
-							bytecode.all.shave(1);
-							bytecode.opcodes.clear();
+							break;
 						}
+					}
+					token.set( m_source + offset, m_pos - offset );
+
+					if (token == "true")
+					{
+						value.p2 = INIT_AS_INT;
+						value.i = 1;
+						token = "1";
+					}
+					else if (token == "false" || token == "null" )
+					{
+						value.p2 = INIT_AS_INT;
+						value.i = 0;
+						token = "0";
+					}
+				}
+			}
+		}
+
+foundMacroToken:
+	
+		ex.spaceAfter = (m_pos < m_sourceLen) && WR_CHAR_IS( m_source[m_pos], WR_CHAR_SPACE );
+	}
+
+	m_loadedToken.clear();
+	m_loadedQuoted = m_quoted;
+	m_loadedValue.p2 = INIT_AS_REF;
+
+	if ( expect && (token != expect) )
+	{
+		return false;
+	}
+
+	return true;
+}
+
+#endif
+/*******************************************************************************
+Copyright (c) 2024 Curt Hartung -- curt.hartung@gmail.com
+
+MIT Licence
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*******************************************************************************/
+
+#include "wrench.h"
+
+//------------------------------------------------------------------------------
+void WRContext::mark( WRValue* s )
+{
+	if ( IS_ARRAY_MEMBER(s->xtype) && IS_EXARRAY_TYPE(s->r->xtype) )
+	{
+		// we don't mark this type, but we might mark it's target
+		mark( s->r );
+		return;
+	}
+
+	if ( !IS_EXARRAY_TYPE(s->xtype) || s->va->m_skipGC || (s->va->m_size & 0x40000000) )
+	{
+		return;
+	}
+
+	assert( !IS_RAW_ARRAY(s->xtype) );
+
+	WRGCObject* sva = s->va;
+
+	if ( sva->m_type == SV_VALUE )
+	{
+		WRValue* top = sva->m_Vdata + sva->m_size;
+
+		for( WRValue* V = sva->m_Vdata; V<top; ++V )
+		{
+			mark( V );
+		}
+	}
+	else if ( sva->m_type == SV_HASH_TABLE )
+	{
+		for( uint32_t i=0; i<sva->m_mod; ++i )
+		{
+			if ( sva->m_hashTable[i] != WRENCH_NULL_HASH )
+			{
+				uint32_t item = i<<1;
+				mark( sva->m_Vdata + item++ );
+				mark( sva->m_Vdata + item );
+			}
+		}
+	}
+
+	sva->m_size |= 0x40000000;
+}
+
+//------------------------------------------------------------------------------
+void WRContext::gc( WRValue* stackTop )
+{
+	if ( allocatedMemoryHint < allocatedMemoryLimit )
+	{
+		return;
+	}
+
+	allocatedMemoryHint = 0;
+
+	// mark stack
+	for( WRValue* s=stack; s<stackTop; ++s)
+	{
+		// an array in the chain?
+		mark( s );
+	}
+
+	// mark context's globals
+	WRValue* globalSpace = (WRValue *)(this + 1); // globals are allocated directly after this context
+
+	for( unsigned int i=0; i<globals; ++i, ++globalSpace )
+	{
+		mark( globalSpace );
+	}
+
+	// sweep
+	WRGCObject* current = svAllocated;
+	WRGCObject* prev = 0;
+	while( current )
+	{
+		// if set, clear it
+		if ( current->m_size & 0x40000000 )
+		{
+			current->m_size &= ~0x40000000;
+			prev = current;
+			current = current->m_next;
+		}
+		// otherwise free it as unreferenced
+		else
+		{
+			current->clear();
+
+			if ( prev == 0 )
+			{
+				svAllocated = current->m_next;
+				g_free( current );
+				current = svAllocated;
+			}
+			else
+			{
+				prev->m_next = current->m_next;
+				g_free( current );
+				current = prev->m_next;
+			}
+		}
+	}
+}
+
+/*  meh..
+//------------------------------------------------------------------------------
+void WRContext::scavenge( WRGCObject* va )
+{
+	// free the sub-array from this object, if the object itself
+	// needs to be cleaned that has to happen in the gc but this
+	// can be done anywhere
+	if ( va->m_type == SV_VOID_HASH_TABLE )
+	{
+		return;
+	}
+
+	g_free( va->m_data );
+	va->m_data = 0;
+
+	if ( va->m_type != SV_CHAR )
+	{
+		if ( va->m_type == SV_HASH_TABLE )
+		{
+			g_free( va->m_hashTable );
+			allocatedMemoryHint -= (va->m_mod * 4);
+		}
+
+		allocatedMemoryHint -= va->m_size * 3;
+		va->m_type = SV_CHAR;
+	}
+
+	allocatedMemoryHint -= va->m_size;
+	va->m_size = 0;
+}
+*/
+
+//------------------------------------------------------------------------------
+WRGCObject* WRContext::getSVA( int size, WRGCObjectType type, bool init )
+{
+	WRGCObject* ret = (WRGCObject*)g_malloc( sizeof(WRGCObject) );
+
+#ifdef WRENCH_HANDLE_MALLOC_FAIL
+	if ( !ret )
+	{
+		g_mallocFailed = true;
+		return 0;
+	}
+#endif
+
+	ret->init( size, type, init );
+
+	if ( type == SV_CHAR )
+	{
+		ret->m_creatorContext = this;
+		allocatedMemoryHint += size;
+	}
+	else if ( type == SV_VALUE )
+	{
+		ret->m_creatorContext = this;
+		allocatedMemoryHint += size * sizeof(WRValue);
+	}
+	else
+	{
+		allocatedMemoryHint += ret->m_size * sizeof(WRValue);
+	}
+
+	ret->m_next = svAllocated;
+	svAllocated = ret;
+
+	return ret;
+}
+
+/*******************************************************************************
+Copyright (c) 2024 Curt Hartung -- curt.hartung@gmail.com
+
+MIT Licence
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*******************************************************************************/
+
+#include "wrench.h"
+
+//------------------------------------------------------------------------------
+inline bool wr_getNextValue( WRValue* iterator, WRValue* value, WRValue* key )
+{
+	if ( !IS_ITERATOR(iterator->xtype) )
+	{
+		return false;
+	}
+
+	uint32_t element = DECODE_ARRAY_ELEMENT_FROM_P2( iterator->p2 );
+
+	if ( iterator->va->m_type == SV_HASH_TABLE )
+	{
+		for( ; element<iterator->va->m_mod; ++element )
+		{
+			if ( iterator->va->m_hashTable[element] != WRENCH_NULL_HASH )
+			{
+				iterator->p2 = INIT_AS_ITERATOR | ENCODE_ARRAY_ELEMENT_TO_P2(element+1);
+				
+				element <<= 1;
+
+				value->p2 = INIT_AS_REF;
+				value->r = iterator->va->m_Vdata + element;
+				if ( key )
+				{
+					key->p2 = INIT_AS_REF;
+					key->r = iterator->va->m_Vdata + element + 1;
+				}
+				
+				return true;
+			}
+		}
+		
+		return false;
+	}
+	else 
+	{
+		if ( element >= iterator->va->m_size )
+		{
+			return false;
+		}
+
+		if ( key )
+		{
+			key->p2 = INIT_AS_INT;
+			key->i = element;
+		}
+
+		if ( iterator->va->m_type == SV_VALUE )
+		{
+			value->p2 = INIT_AS_REF;
+			value->r = iterator->va->m_Vdata + element;
+		}
+		else if ( iterator->va->m_type == SV_CHAR )
+		{
+			value->p2 = INIT_AS_INT;
+			value->i = iterator->va->m_Cdata[element];
+		}
+		else
+		{
+			return false;
+		}
+
+		iterator->p2 = INIT_AS_ITERATOR | ENCODE_ARRAY_ELEMENT_TO_P2(++element);
+	}
+
+	return true;
+}
+
+
+/*
+static void dumpStack( const WRValue* bottom, const WRValue* top )
+{
+	WRstr out;
+	wr_stackDump( bottom, top, out );
+	printf( "stack:\n%s===================================\n", out.c_str() );
+}
+#define DEBUG_PER_INSTRUCTION { dumpStack(context->stack, stackTop); }
+*/
+#ifndef DEBUG_PER_INSTRUCTION
+#define DEBUG_PER_INSTRUCTION
+#endif
+
+//------------------------------------------------------------------------------
+#ifdef WRENCH_PROTECT_STACK_FROM_OVERFLOW
+#define CHECK_STACK { if ( stackTop >= stackLimit ) { w->err = WR_ERR_stack_overflow; return 0; } }
+#else
+#define CHECK_STACK
+#endif
+
+//------------------------------------------------------------------------------
+#ifdef WRENCH_HANDLE_MALLOC_FAIL
+  bool g_mallocFailed =false;
+  #define MALLOC_FAIL_CHECK {if( g_mallocFailed ) { w->err = WR_ERR_malloc_failed; g_mallocFailed = false; return 0; } }
+#else
+  #define MALLOC_FAIL_CHECK
+#endif
+
+//------------------------------------------------------------------------------
+#ifdef WRENCH_SAMPLE_PROFILER
+
+//------------------------------------------------------------------------------
+struct WRSampleStack
+{
+	WRContext* context; // null once the context is destroyed
+	uint32_t count; // zero is an empty slot
+	uint16_t line;
+	uint8_t depth;
+	uint8_t truncated; // the outer frames did not fit or could not be followed
+	uint8_t units[WRENCH_SAMPLE_DEPTH]; // innermost first, unit 0 is the global code
+};
+
+//------------------------------------------------------------------------------
+struct WRSampler
+{
+	uint32_t interval;
+	uint32_t samples;
+	uint32_t dropped; // samples of call stacks that did not fit the table
+	WRSampleStack stacks[WRENCH_SAMPLE_STACKS];
+};
+
+//------------------------------------------------------------------------------
+bool wr_sampleStart( WRState* w, const int interval )
+{
+	if ( !w->sampler )
+	{
+		w->sampler = (WRSampler*)g_malloc( sizeof(WRSampler) );
+		if ( !w->sampler )
+		{
+			return false;
+		}
+	}
+
+	memset( (char*)w->sampler, 0, sizeof(WRSampler) );
+	w->sampler->interval = interval > 0 ? interval : 0;
+	w->sampleCountdown = w->sampler->interval;
+	return true;
+}
+
+//------------------------------------------------------------------------------
+void wr_sampleStop( WRState* w )
+{
+	g_free( w->sampler );
+	w->sampler = 0;
+	w->sampleCountdown = 0;
+}
+
+//------------------------------------------------------------------------------
+void wr_sampleNow( WRState* w )
+{
+	w->sampleCountdown = 1;
+}
+
+//------------------------------------------------------------------------------
+static int wr_sampleUnit( WRContext* context, const unsigned char* pc )
+{
+	// the global code comes first, then the functions in order
+	const unsigned int offset = (unsigned int)(pc - context->bottom);
+	int unit = 0;
+	for( int i=0; i<context->numLocalFunctions && context->localFunctions[i].functionOffset <= offset; ++i )
+	{
+		unit = i + 1;
+	}
+	return unit;
+}
+
+//------------------------------------------------------------------------------
+// walks the frames the same way O_Return unwinds them
+static void wr_takeSample( WRContext* context, const unsigned char* pc, WRValue* frameBase )
+{
+	WRState* w = context->w;
+	WRSampler* S = w->sampler;
+	w->sampleCountdown = S ? S->interval : 0;
+	if ( !S )
+	{
+		return;
+	}
+
+	++S->samples;
+
+	WRSampleStack sample;
+	memset( (char*)&sample, 0, sizeof(sample) );
+	sample.context = context;
+	sample.line = context->line;
+
+	for(;;)
+	{
+		if ( pc < context->bottom || pc >= context->bottom + context->bottomSize
+			 || sample.depth == WRENCH_SAMPLE_DEPTH )
+		{
+			sample.truncated = 1;
+			break;
+		}
+
+		const int unit = wr_sampleUnit( context, pc );
+		sample.units[sample.depth++] = unit;
+		if ( !unit )
+		{
+			break;
+		}
+
+		WRFunction* function = context->localFunctions + (unit - 1);
+		WRValue* returnVector = frameBase + function->frameBaseAdjustment - 1;
+		pc = context->bottom + returnVector->returnOffset;
+		frameBase = returnVector->frame;
+
+		if ( pc >= context->bottom && pc < context->bottom + context->bottomSize && READ_8_FROM_PC(pc) == O_Stop )
+		{
+			break; // called by the host
+		}
+	}
+
+	WRSampleStack* empty = 0;
+	for( int i=0; i<WRENCH_SAMPLE_STACKS; ++i )
+	{
+		WRSampleStack* stack = S->stacks + i;
+		if ( !stack->count )
+		{
+			if ( !empty )
+			{
+				empty = stack;
+			}
+			continue;
+		}
+
+		if ( stack->context == context
+			 && stack->line == sample.line
+			 && stack->depth == sample.depth
+			 && stack->truncated == sample.truncated
+			 && !memcmp(stack->units, sample.units, sample.depth) )
+		{
+			++stack->count;
+			return;
+		}
+	}
+
+	if ( !empty )
+	{
+		++S->dropped;
+		return;
+	}
+
+	sample.count = 1;
+	*empty = sample;
+}
+
+//------------------------------------------------------------------------------
+static void wr_sampleForgetContext( WRContext* context )
+{
+	WRSampler* S = context->w->sampler;
+	for( int i=0; S && i<WRENCH_SAMPLE_STACKS; ++i )
+	{
+		if ( S->stacks[i].context == context )
+		{
+			S->stacks[i].context = 0;
+		}
+	}
+}
+
+//------------------------------------------------------------------------------
+// the name of a unit from the WR_EMBED_DEBUG_CODE symbol block, or its hash
+static void wr_sampleUnitName( WRstr& out, WRContext* context, const int unit )
+{
+	if ( !context )
+	{
+		out += "?";
+		return;
+	}
+
+	const unsigned char* block = context->bottom;
+	const uint8_t compilerFlags = READ_8_FROM_PC( block + 2 );
+	if ( compilerFlags & WR_EMBED_DEBUG_CODE )
+	{
+		const unsigned char* symbols = block + 3 + context->numLocalFunctions * WR_FUNCTION_CORE_SIZE;
+		if ( compilerFlags & WR_INCLUDE_GLOBALS )
+		{
+			symbols += context->globals * sizeof(uint32_t);
+		}
+		symbols += 6; // code hash and symbol block size
+		const unsigned char* end = symbols + READ_16_FROM_PC( symbols - 2 );
+
+		const int units = READ_16_FROM_PC( symbols );
+		symbols += 2;
+		for( int u=0; u<units && symbols < end; ++u )
+		{
+			const int locals = READ_8_FROM_PC( symbols );
+			symbols += 2; // locals and arguments
+
+			if ( u == unit )
+			{
+				for( ; symbols < end && READ_8_FROM_PC(symbols); ++symbols )
+				{
+					out += (char)READ_8_FROM_PC( symbols );
+				}
+				return;
+			}
+
+			// the name and the labels of the locals
+			for( int n=0; n<=locals && symbols < end; ++n )
+			{
+				while( symbols < end && READ_8_FROM_PC(symbols++) );
+			}
+		}
+	}
+
+	if ( unit == 0 )
+	{
+		out += "::global";
+	}
+	else
+	{
+		out.appendFormat( "0x%08X", context->localFunctions[unit - 1].hash );
+	}
+}
+
+//------------------------------------------------------------------------------
+void wr_sampleFolded( WRState* w, char** out, unsigned int* outLen )
+{
+	WRstr folded;
+
+	for( int i=0; w->sampler && i<WRENCH_SAMPLE_STACKS; ++i )
+	{
+		const WRSampleStack& stack = w->sampler->stacks[i];
+		if ( !stack.count )
+		{
+			continue;
+		}
+
+		if ( stack.truncated )
+		{
+			folded += "...;";
+		}
+		for( int d=stack.depth - 1; d>=0; --d )
+		{
+			wr_sampleUnitName( folded, stack.context, stack.units[d] );
+			folded += d ? ";" : "";
+		}
+		if ( stack.line )
+		{
+			folded.appendFormat( ":%d", stack.line );
+		}
+		folded.appendFormat( " %u\n", stack.count );
+	}
+
+	folded.release( out, outLen );
+}
+
+// a countdown of 0 is disarmed (interval 0, or not sampling) until wr_sampleNow()
+#define CHECK_SAMPLE { if ( w->sampleCountdown && !--w->sampleCountdown ) { wr_takeSample( context, pc, frameBase ); } }
+#else
+#define CHECK_SAMPLE
+#endif
+
+//------------------------------------------------------------------------------
+#ifdef WRENCH_TIME_SLICES
+
+//------------------------------------------------------------------------------
+void wr_setInstructionsPerSlice( WRState* w, const int instructions )
+{
+	w->instructionsPerSlice = instructions;
+}
+
+//------------------------------------------------------------------------------
+void wr_forceYield( WRState* w )
+{
+	w->yieldEnabled = true; // prevent a race in case the count is decremented before this flag is checked
+	w->sliceInstructionCount = 1;
+}
+
+#define CHECK_FORCE_YIELD { CHECK_SAMPLE; if ( !--w->sliceInstructionCount && w->yieldEnabled ) { context->yieldArgs = 0; context->flags |= (uint8_t)WRC_ForceYielded; goto doYield; } }
+#else
+#define CHECK_FORCE_YIELD CHECK_SAMPLE
+#endif
+
+//------------------------------------------------------------------------------
+#define WRENCH_JUMPTABLE_INTERPRETER
+#ifdef WRENCH_REALLY_COMPACT
+#undef WRENCH_JUMPTABLE_INTERPRETER
+#elif !defined(__clang__)
+#if _MSC_VER
+#undef WRENCH_JUMPTABLE_INTERPRETER
+#endif
+#endif
+
+#ifdef WRENCH_JUMPTABLE_INTERPRETER
+ #define CONTINUE { DEBUG_PER_INSTRUCTION; MALLOC_FAIL_CHECK; PROFILE_INSTRUCTION; goto *opcodeJumptable[READ_8_FROM_PC(pc++)];  }
+ #define FASTCONTINUE { DEBUG_PER_INSTRUCTION; PROFILE_INSTRUCTION; goto *opcodeJumptable[READ_8_FROM_PC(pc++)];  }
+ #define CASE(LABEL) LABEL
+#else
+ #define CONTINUE { DEBUG_PER_INSTRUCTION; MALLOC_FAIL_CHECK; continue; }
+ #define FASTCONTINUE { DEBUG_PER_INSTRUCTION; continue; }
+ #define CASE(LABEL) case O_##LABEL
+#endif
+
+//------------------------------------------------------------------------------
+// what the first opcode of a superinstruction does, exactly as its own
+// handler up to the dispatch
+#define WR_SUPER_FIRST_LoadFromLocal { stackTop->p = frameBase + READ_8_FROM_PC(pc++); (stackTop++)->p2 = INIT_AS_REF; CHECK_STACK; }
+#define WR_SUPER_FIRST_LoadFromGlobal { stackTop->p = globalSpace + READ_8_FROM_PC(pc++); (stackTop++)->p2 = INIT_AS_REF; CHECK_STACK; }
+#define WR_SUPER_FIRST_LiteralInt8 { stackTop->i = (int32_t)(int8_t)READ_8_FROM_PC(pc++); (stackTop++)->p2 = INIT_AS_INT; CHECK_STACK; }
+#define WR_SUPER_FIRST_LiteralInt16 { stackTop->i = READ_16_FROM_PC(pc); pc += 2; (stackTop++)->p2 = INIT_AS_INT; CHECK_STACK; }
+#define WR_SUPER_FIRST_LiteralFloat { register0 = stackTop++; register0->p2 = INIT_AS_FLOAT; register0->i = READ_32_FROM_PC(pc); pc += 4; }
+#ifdef WRENCH_COMPACT
+#define WR_SUPER_FIRST_IncLocal { register0 = frameBase + READ_8_FROM_PC(pc++); goto compactPreIncrement; }
+#else
+#define WR_SUPER_FIRST_IncLocal { register0 = frameBase + READ_8_FROM_PC(pc++); wr_preinc[ register0->type ]( register0 ); }
+#endif
+
+// the second opcode is still there and gets jumped to directly when it
+// was not rewritten since, so profiling and debugging see both
+#if defined(WRENCH_JUMPTABLE_INTERPRETER) && !defined(WRENCH_PROFILE_OPCODES) && !defined(WRENCH_INCLUDE_DEBUG_CODE)
+ #define WR_SUPER_SECOND(SECOND) { if ( READ_8_FROM_PC(pc) == O_##SECOND ) { ++pc; goto SECOND; } FASTCONTINUE; }
+#else
+ #define WR_SUPER_SECOND(SECOND) FASTCONTINUE
+#endif
+
+//------------------------------------------------------------------------------
+#define QUICK_FLOATS ( ((register1->type<<2)|register0->type) == ((WR_FLOAT<<2)|WR_FLOAT) )
+
+#ifdef WRENCH_QUICKEN
+//------------------------------------------------------------------------------
+// rewrite the generic operation at 'code' into the numeric one when it
+// is about to run on two ints or two floats
+static inline void wr_quicken( const unsigned char* code, const int opcode, const WRValue* top )
+{
+	const int types = (top->type<<2) | (top - 1)->type;
+	if ( types == ((WR_INT<<2)|WR_INT) || types == ((WR_FLOAT<<2)|WR_FLOAT) )
+	{
+		*(unsigned char*)code = (unsigned char)opcode;
+	}
+}
+
+// only code the context owns is writable, see wr_run()
+#define QUICKEN(OPCODE) { if ( context->flags & WRC_OwnsMemory ) { wr_quicken( pc - 1, (OPCODE), stackTop - 1 ); } }
+#else
+#define QUICKEN(OPCODE)
+#endif
+
+//------------------------------------------------------------------------------
+#ifdef WRENCH_PROFILE_OPCODES
+
+#ifndef WRENCH_PROFILE_CLOCK
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define WRENCH_PROFILE_CLOCK() ((uint32_t)__rdtsc())
+#elif defined(__XTENSA__)
+static inline uint32_t wr_profileCycleCount() { uint32_t c; __asm__ __volatile__( "rsr %0, ccount" : "=a"(c) ); return c; }
+#define WRENCH_PROFILE_CLOCK() wr_profileCycleCount()
+#else
+#define WRENCH_PROFILE_CLOCK() ((uint32_t)0)
+#endif
+#endif
+
+struct WRProfilePair
+{
+	uint16_t key; // ((first << 8) | second) + 1, zero is empty
+	uint64_t count;
+};
+
+struct WRProfileSite
+{
+	const uint8_t* pc; // null is empty
+	WRProfileCounter counter;
+};
+
+struct WRProfile
+{
+	WRProfileCounter opcodes[O_LAST];
+	WRProfilePair pairs[WRENCH_PROFILE_PAIRS];
+	WRProfileSite sites[WRENCH_PROFILE_SITES];
+	uint64_t dropped;
+
+	WRProfileSite* lastSite; // charged with the ticks up to the next dispatch
+	uint32_t clock;
+	uint8_t last; // O_LAST when nothing was dispatched yet in this call
+};
+static WRProfile g_profile;
+
+//------------------------------------------------------------------------------
+void wr_profileReset()
+{
+	memset( (char*)&g_profile, 0, sizeof(g_profile) );
+	g_profile.last = O_LAST;
+}
+
+//------------------------------------------------------------------------------
+static WRProfileSite* wr_profileSite( const uint8_t* pc )
+{
+	unsigned int i = (unsigned int)(((uintptr_t)pc * 2654435761u) % WRENCH_PROFILE_SITES);
+	for( unsigned int n=0; n<WRENCH_PROFILE_SITES; ++n )
+	{
+		WRProfileSite* site = g_profile.sites + i;
+		if ( site->pc == pc )
+		{
+			return site;
+		}
+		if ( !site->pc )
+		{
+			site->pc = pc;
+			return site;
+		}
+		i = (i + 1) % WRENCH_PROFILE_SITES;
+	}
+	return 0;
+}
+
+//------------------------------------------------------------------------------
+static WRProfilePair* wr_profilePairEntry( const uint16_t key, const bool add )
+{
+	unsigned int i = (key * 40503u) % WRENCH_PROFILE_PAIRS;
+	for( unsigned int n=0; n<WRENCH_PROFILE_PAIRS; ++n )
+	{
+		WRProfilePair* pair = g_profile.pairs + i;
+		if ( pair->key == key )
+		{
+			return pair;
+		}
+		if ( !pair->key )
+		{
+			if ( !add )
+			{
+				return 0;
+			}
+			pair->key = key;
+			return pair;
+		}
+		i = (i + 1) % WRENCH_PROFILE_PAIRS;
+	}
+	return 0;
+}
+
+//------------------------------------------------------------------------------
+// a (re)entry into the interpreter, what ran before is not an opcode
+static void wr_profileEnter()
+{
+	g_profile.last = O_LAST;
+	g_profile.lastSite = 0;
+}
+
+//------------------------------------------------------------------------------
+// called with pc on the opcode about to be dispatched
+static void wr_profileInstruction( const uint8_t* pc )
+{
+	const uint32_t ticks = WRENCH_PROFILE_CLOCK() - g_profile.clock;
+	const uint8_t opcode = READ_8_FROM_PC( pc );
+
+	if ( g_profile.last != O_LAST )
+	{
+		g_profile.opcodes[g_profile.last].ticks += ticks;
+		if ( g_profile.lastSite )
+		{
+			g_profile.lastSite->counter.ticks += ticks;
+		}
+
+		WRProfilePair* pair = wr_profilePairEntry( ((g_profile.last << 8) | opcode) + 1, true );
+		if ( pair )
+		{
+			++pair->count;
+		}
+		else
+		{
+			++g_profile.dropped;
+		}
+	}
+
+	if ( opcode < O_LAST )
+	{
+		++g_profile.opcodes[opcode].count;
+	}
+	g_profile.lastSite = wr_profileSite( pc );
+	if ( g_profile.lastSite )
+	{
+		++g_profile.lastSite->counter.count;
+	}
+	else
+	{
+		++g_profile.dropped;
+	}
+	g_profile.last = opcode < O_LAST ? opcode : (uint8_t)O_LAST;
+
+	// the bookkeeping above is not charged to any opcode
+	g_profile.clock = WRENCH_PROFILE_CLOCK();
+}
+
+//------------------------------------------------------------------------------
+const WRProfileCounter* wr_profileOpcode( const int opcode )
+{
+	return (opcode >= 0 && opcode < O_LAST) ? g_profile.opcodes + opcode : 0;
+}
+
+//------------------------------------------------------------------------------
+uint64_t wr_profilePair( const int first, const int second )
+{
+	if ( first < 0 || first >= O_LAST || second < 0 || second >= O_LAST )
+	{
+		return 0;
+	}
+	WRProfilePair* pair = wr_profilePairEntry( ((first << 8) | second) + 1, false );
+	return pair ? pair->count : 0;
+}
+
+//------------------------------------------------------------------------------
+uint64_t wr_profileDropped()
+{
+	return g_profile.dropped;
+}
+
+//------------------------------------------------------------------------------
+const char* wr_profileOpcodeName( const int opcode )
+{
+	if ( opcode < 0 || opcode >= O_LAST )
+	{
+		return "?";
+	}
+#ifndef WRENCH_WITHOUT_COMPILER
+	return c_opcodeName[opcode];
+#else
+	static char name[4];
+	name[0] = '0' + opcode / 100;
+	name[1] = '0' + (opcode / 10) % 10;
+	name[2] = '0' + opcode % 10;
+	return name;
+#endif
+}
+
+//------------------------------------------------------------------------------
+const WRProfileSite* wr_profileSites()
+{
+	return g_profile.sites;
+}
+
+//------------------------------------------------------------------------------
+void wr_profileDump( char** out, unsigned int* outLen )
+{
+	WRstr dump;
+
+	uint64_t count = 0;
+	uint64_t ticks = 0;
+	for( int i=0; i<O_LAST; ++i )
+	{
+		count += g_profile.opcodes[i].count;
+		ticks += g_profile.opcodes[i].ticks;
+	}
+	dump.format( "instructions %llu ticks %llu dropped %llu\n",
+				 (unsigned long long)count, (unsigned long long)ticks, (unsigned long long)g_profile.dropped );
+
+	// insertion sorts, the tables are small and this is not a hot path
+	uint8_t order[O_LAST];
+	int used = 0;
+	for( int i=0; i<O_LAST; ++i )
+	{
+		if ( !g_profile.opcodes[i].count )
+		{
+			continue;
+		}
+		int j = used++;
+		for( ; j>0 && g_profile.opcodes[order[j-1]].ticks < g_profile.opcodes[i].ticks; --j )
+		{
+			order[j] = order[j-1];
+		}
+		order[j] = i;
+	}
+	for( int i=0; i<used; ++i )
+	{
+		const WRProfileCounter& C = g_profile.opcodes[order[i]];
+		dump.appendFormat( "op %-36s %12llu %14llu %5.1f%%\n",
+						   wr_profileOpcodeName(order[i]),
+						   (unsigned long long)C.count,
+						   (unsigned long long)C.ticks,
+						   ticks ? (100.0 * C.ticks) / ticks : 0.0 );
+	}
+
+	uint16_t pairs[WRENCH_PROFILE_PAIRS];
+	used = 0;
+	for( int i=0; i<WRENCH_PROFILE_PAIRS; ++i )
+	{
+		if ( !g_profile.pairs[i].key )
+		{
+			continue;
+		}
+		int j = used++;
+		for( ; j>0 && g_profile.pairs[pairs[j-1]].count < g_profile.pairs[i].count; --j )
+		{
+			pairs[j] = pairs[j-1];
+		}
+		pairs[j] = i;
+	}
+	for( int i=0; i<used; ++i )
+	{
+		const WRProfilePair& P = g_profile.pairs[pairs[i]];
+		dump.appendFormat( "pair %-36s %-36s %12llu\n",
+						   wr_profileOpcodeName((P.key - 1) >> 8),
+						   wr_profileOpcodeName((P.key - 1) & 0xFF),
+						   (unsigned long long)P.count );
+	}
+
+	dump.release( out, outLen );
+}
+
+#define PROFILE_INSTRUCTION wr_profileInstruction( pc )
+
+#else
+
+#define PROFILE_INSTRUCTION
+
+#endif
+
+#ifdef WRENCH_COMPACT
+
+static float divisionF( float a, float b ) { return a / b; }
+static float addF( float a, float b ) { return a + b; }
+static float subtractionF( float a, float b ) { return a - b; }
+static float multiplicationF( float a, float b ) { return a * b; }
+
+static int divisionI( int a, int b ) { return a / b; }
+int wr_addI( int a, int b ) { return a + b; }
+static int subtractionI( int a, int b ) { return a - b; }
+static int multiplicationI( int a, int b ) { return a * b; }
+
+static int rightShiftI( int a, int b ) { return a >> b; }
+static int leftShiftI( int a, int b ) { return a << b; }
+static int modI( int a, int b ) { return a % b; }
+static int orI( int a, int b ) { return a | b; }
+static int xorI( int a, int b ) { return a ^ b; }
+static int andI( int a, int b ) { return a & b; }
+
+static bool CompareGTI( int a, int b ) { return a > b; }
+static bool CompareLTI( int a, int b ) { return a < b; }
+static bool CompareANDI( int a, int b ) { return a && b; }
+static bool CompareORI( int a, int b ) { return a || b; }
+
+static bool CompareLTF( float a, float b ) { return a < b; }
+static bool CompareGTF( float a, float b ) { return a > b; }
+
+bool CompareEQI( int a, int b ) { return a == b; }
+bool CompareEQF( float a, float b ) { return a == b; }
 
-						return;
-					}
-					else if ( bytecode.opcodes[ o - 1 ] == O_LoadFromLocal )
-					{
-						if ( o > 1 && bytecode.opcodes[o-2] == O_LiteralInt8 )
-						{
-							bytecode.all[ a - 4 ] = O_LiteralInt8ToLocal;
-							bytecode.all[ a - 2 ] = bytecode.all[ a - 3 ];
-							bytecode.all[ a - 3 ] = bytecode.all[ a - 1 ];
-							bytecode.all.shave(2);
-							bytecode.opcodes.clear();
-						}
-						else if ( o > 1 && bytecode.opcodes[o-2] == O_LiteralInt16 )
-						{
-							bytecode.all[ a - 5 ] = O_LiteralInt16ToLocal;
-							bytecode.all[ a - 2 ] = bytecode.all[ a - 3 ];
-							bytecode.all[ a - 3 ] = bytecode.all[ a - 4 ];
-							bytecode.all[ a - 4 ] = bytecode.all[ a - 1 ];
-							bytecode.all.shave(2);
-							bytecode.opcodes.clear();
-						}
-						else if ( o > 1 && bytecode.opcodes[o-2] == O_LiteralInt32 )
-						{
-							bytecode.all[ a - 7 ] = O_LiteralInt32ToLocal;
-							bytecode.all[ a - 2 ] = bytecode.all[ a - 3 ];
-							bytecode.all[ a - 3 ] = bytecode.all[ a - 4 ];
-							bytecode.all[ a - 4 ] = bytecode.all[ a - 5 ];
-							bytecode.all[ a - 5 ] = bytecode.all[ a - 6 ];
-							bytecode.all[ a - 6 ] = bytecode.all[ a - 1 ];
-							bytecode.all.shave(2);
-							bytecode.opcodes.clear();
-						}
-						else if ( o > 1 && bytecode.opcodes[o-2] == O_LiteralFloat )
-						{
-							bytecode.all[ a - 7 ] = O_LiteralFloatToLocal;
-							bytecode.all[ a - 2 ] = bytecode.all[ a - 3 ];
-							bytecode.all[ a - 3 ] = bytecode.all[ a - 4 ];
-							bytecode.all[ a - 4 ] = bytecode.all[ a - 5 ];
-							bytecode.all[ a - 5 ] = bytecode.all[ a - 6 ];
-							bytecode.all[ a - 6 ] = bytecode.all[ a - 1 ];
-							bytecode.all.shave(2);
-							bytecode.opcodes.clear();
-						}
-						else if ( o > 1 && bytecode.opcodes[o-2] == O_LiteralZero )
-						{
-							bytecode.all[ a - 3 ] = O_LiteralInt8ToLocal;
-							bytecode.all[ a - 2 ] = bytecode.all[ a - 1 ];
-							bytecode.all[ a - 1 ] = 0;
-							bytecode.all.shave(1);
-							bytecode.opcodes.clear();
-						}
-						else if ( o > 1 && bytecode.opcodes[o - 2] == O_BinaryDivision )
-						{
-							bytecode.all[ a - 3 ] = O_BinaryDivisionAndStoreLocal;
-							bytecode.all[ a - 2 ] = bytecode.all[ a - 1 ];
-							bytecode.all.shave(2);
-							bytecode.opcodes.clear();
-						}
-						else if ( o > 1 && bytecode.opcodes[o - 2] == O_BinaryAddition )
-						{
-							bytecode.all[ a - 3 ] = O_BinaryAdditionAndStoreLocal;
-							bytecode.all[ a - 2 ] = bytecode.all[ a - 1 ];
-							bytecode.all.shave(2);
-							bytecode.opcodes.clear();
-						}
-						else if ( o > 1 && bytecode.opcodes[o - 2] == O_BinaryMultiplication )
-						{
-							bytecode.all[ a - 3 ] = O_BinaryMultiplicationAndStoreLocal;
-							bytecode.all[ a - 2 ] = bytecode.all[ a - 1 ];
-							bytecode.all.shave(2);
-							bytecode.opcodes.clear();
-						}
-						else if ( o > 1 && bytecode.opcodes[o - 2] == O_BinarySubtraction )
-						{
-							bytecode.all[ a - 3 ] = O_BinarySubtractionAndStoreLocal;
-							bytecode.all[ a - 2 ] = bytecode.all[ a - 1 ];
-							bytecode.all.shave(2);
-							bytecode.opcodes.clear();
-						}
-						else
-						{
-							bytecode.all[ a - 2 ] = O_AssignToLocalAndPop;
-							bytecode.all.shave(1);
-							bytecode.opcodes.clear();
-						}
-						return;
-					}
+static bool CompareBlankF( float a, float b ) { return false; }
+static float blankF( float a, float b ) { return 0; }
+
+int32_t READ_32_FROM_PC_func( const unsigned char* P )
+{
+	return ( (((int32_t)*(P)) )
+			 | (((int32_t)*((P)+1)) << 8)
+			 | (((int32_t)*((P)+2)) << 16)
+			 | (((int32_t)*((P)+3)) << 24) );
+}
+
+int16_t READ_16_FROM_PC_func( const unsigned char* P )
+{
+	return ( ((int16_t)*(P)) )
+			| ((int16_t)*(P+1) << 8 );
+}
+
+#endif
+
+//------------------------------------------------------------------------------
+// the globalRegistry entry of a library function, function or constant.
+// the slot only remembers where the hash was found, it is checked
+// against the registry on every use so registering more functions
+// (which can rehash the registry) needs no invalidation, and avoids
+// the modulo of the registry lookup, which is a library call on
+// targets without a hardware divide
+static inline WRValue* wr_linked( WRContext* context, WRGCObject& registry, const uint32_t hash )
+{
+	WRLinkSlot& slot = context->links[ (hash ^ (hash >> 16)) & (WRENCH_LINK_SLOTS - 1) ];
+	if ( slot.hash == hash
+		 && slot.index - 1 < registry.m_mod
+		 && registry.m_hashTable[slot.index - 1] == hash )
+	{
+		return registry.m_Vdata + (slot.index - 1);
+	}
+
+	WRValue* entry = registry.getAsRawValueHashTable( hash );
+	slot.hash = hash;
+	slot.index = (uint32_t)(entry - registry.m_Vdata) + 1;
+	return entry;
+}
+
+//------------------------------------------------------------------------------
+void doIndexHash( WRValue* value, WRValue* target, WRValue* index );
+
+//------------------------------------------------------------------------------
+// monomorphic cache of "value.member" per bytecode location. a struct
+// hit needs the same struct layout (its hash table lives in the
+// bytecode), a hash table hit only needs the member hash to still be at
+// the remembered index, whichever table it is. otherwise does what
+// doIndexHash() does and remembers the result
+static inline void wr_indexHashCached( WRContext* context, const unsigned char* pc, WRValue* value, WRValue* index, WRValue* target )
+{
+	const uint32_t site = (uint32_t)(pc - context->bottom) + 1;
+	// two way: the pair of entries selected by the site
+	WRIndexCache* set = context->indexCache + ((((site * 2654435761u) >> 24) << 1) & (WRENCH_INDEX_CACHE_SLOTS - 2));
+	WRIndexCache& C = set[0].site == site ? set[0] : (set[1].site == site ? set[1] : set[set[0].site != 0]);
+	WRGCObject* va = value->va;
+
+	if ( C.site == site )
+	{
+		if ( value->xtype == WR_EX_STRUCT )
+		{
+			if ( C.layout == va->m_ROMHashTable )
+			{
+				target->p2 = INIT_AS_REF;
+				target->p = ((WRValue*)(va->m_data)) + C.index;
+				return;
+			}
+		}
+		else if ( !C.layout
+				  && va->m_type == SV_HASH_TABLE
+				  && C.index < va->m_mod
+				  && va->m_hashTable[C.index] == index->ui )
+		{
+			WRValue* entry = va->m_Vdata + (C.index << 1);
+			if ( IS_EX_SINGLE_CHAR_RAW_P2( (target->r = entry)->p2 ) )
+			{
+				target->p2 = INIT_AS_ARRAY_MEMBER;
+			}
+			else
+			{
+				*(entry + 1) = *index; // store key
+				target->p2 = INIT_AS_REF;
+			}
+			return;
+		}
+	}
+
+	doIndexHash( value, target, index );
+
+	if ( value->xtype == WR_EX_STRUCT )
+	{
+		if ( target->p2 == INIT_AS_REF )
+		{
+			C.site = site;
+			C.layout = va->m_ROMHashTable;
+			C.index = (uint32_t)((WRValue*)target->p - (WRValue*)va->m_data);
+		}
+	}
+	else if ( va->m_type == SV_HASH_TABLE )
+	{
+		C.site = site;
+		C.layout = 0;
+		C.index = (uint32_t)(target->r - va->m_Vdata) >> 1;
+	}
+}
+
+#if defined(WRENCH_JIT) || !defined(WRENCH_WITHOUT_COMPILER)
+//------------------------------------------------------------------------------
+// What the baseline JIT (WRENCH_JIT) and wr_translate() know of the
+// bytecode. Both translate a function one opcode at a time and leave the
+// values on the wrench stack where the interpreter keeps them, so ints
+// and floats are done inline and everything else goes through the
+// interpreter's own operation tables. A function with an opcode
+// wr_jitDecode() does not know is not translated at all and stays
+// interpreted
+
+// functions with more bytecode than this are not translated
+#define WR_JIT_MAX_BYTECODE 4096
+
+enum WRJitFlow
+{
+	WRJ_Next,
+	WRJ_Jump,
+	WRJ_Branch,
+	WRJ_Return,
+};
+
+// the operations, in the order of the tables below
+enum WRJitMath
+{
+	WRJ_Add,
+	WRJ_Sub,
+	WRJ_Mul,
+	WRJ_Div,
+	WRJ_Mod,
+	WRJ_Shl,
+	WRJ_Shr,
+	WRJ_And,
+	WRJ_Or,
+	WRJ_Xor,
+	WRJ_Assign,
+};
+
+enum WRJitCompare
+{
+	WRJ_EQ,
+	WRJ_LT,
+	WRJ_GT,
+};
+
+// where the two sides of a compare-and-branch are
+enum WRJitForm
+{
+	WRJ_TwoStack, // CompareB*
+	WRJ_LocalStack, // LSCompare*BZ
+	WRJ_GlobalStack, // GSCompare*BZ
+	WRJ_TwoLocal, // LLCompare*BZ
+	WRJ_TwoGlobal, // GGCompare*BZ
+};
+
+//------------------------------------------------------------------------------
+struct WRJitOp
+{
+	int opcode; // superinstructions and quickened opcodes decode as what they do
+	int length;
+	int pops;
+	int pushes;
+	int flow;
+	int target; // of a jump, relative to the opcode
+	int math; // WRJitMath
+	int compare; // WRJitCompare
+	int form; // WRJitForm
+	bool when; // a branch jumps when the compare is this
+};
+
+#define WR_JIT_BRANCH( OPCODE, FORM, WIDE, COMPARE, WHEN ) \
+	case O_##OPCODE: op.form = FORM; wide = WIDE; op.compare = COMPARE; op.when = WHEN; break;
+
+// 'NE' compares 'EQ' and jumps when it is true and so on, the way the
+// interpreter does it
+#define WR_JIT_BRANCHES( C, COMPARE, WHEN ) \
+	WR_JIT_BRANCH( CompareB##C, WRJ_TwoStack, true, COMPARE, WHEN ) \
+	WR_JIT_BRANCH( CompareB##C##8, WRJ_TwoStack, false, COMPARE, WHEN ) \
+	WR_JIT_BRANCH( LSCompare##C##BZ, WRJ_LocalStack, true, COMPARE, WHEN ) \
+	WR_JIT_BRANCH( LSCompare##C##BZ8, WRJ_LocalStack, false, COMPARE, WHEN ) \
+	WR_JIT_BRANCH( GSCompare##C##BZ, WRJ_GlobalStack, true, COMPARE, WHEN ) \
+	WR_JIT_BRANCH( GSCompare##C##BZ8, WRJ_GlobalStack, false, COMPARE, WHEN ) \
+	WR_JIT_BRANCH( LLCompare##C##BZ, WRJ_TwoLocal, true, COMPARE, WHEN ) \
+	WR_JIT_BRANCH( LLCompare##C##BZ8, WRJ_TwoLocal, false, COMPARE, WHEN ) \
+	WR_JIT_BRANCH( GGCompare##C##BZ, WRJ_TwoGlobal, true, COMPARE, WHEN ) \
+	WR_JIT_BRANCH( GGCompare##C##BZ8, WRJ_TwoGlobal, false, COMPARE, WHEN )
+
+//------------------------------------------------------------------------------
+// false for anything the JIT does not translate
+static bool wr_jitDecode( const unsigned char* pc, WRJitOp& op )
+{
+	op.opcode = READ_8_FROM_PC(pc);
+	switch( op.opcode )
+	{
+#define WR_SUPER_JIT( NAME, FIRST, SECOND_AS_PUSHED, SECOND ) case O_##NAME: op.opcode = O_##FIRST; break;
+		WRENCH_SUPERINSTRUCTIONS( WR_SUPER_JIT )
+#undef WR_SUPER_JIT
+		case O_BinaryAdditionNumeric: op.opcode = O_BinaryAddition; break;
+		case O_BinarySubtractionNumeric: op.opcode = O_BinarySubtraction; break;
+		case O_BinaryMultiplicationNumeric: op.opcode = O_BinaryMultiplication; break;
+		default: break;
+	}
+
+	op.length = 1;
+	op.pops = 0;
+	op.pushes = 0;
+	op.flow = WRJ_Next;
+	op.target = 0;
+	op.math = WRJ_Assign;
+
+	bool wide = true;
+	switch( op.opcode )
+	{
+		case O_LiteralZero: op.pushes = 1; return true;
+		case O_LiteralInt8:
+		case O_LoadFromLocal:
+		case O_LoadFromGlobal: op.length = 2; op.pushes = 1; return true;
+		case O_LiteralInt16: op.length = 3; op.pushes = 1; return true;
+		case O_LiteralInt32:
+		case O_LiteralFloat: op.length = 5; op.pushes = 1; return true;
+
+		case O_LiteralInt8ToLocal:
+		case O_LiteralInt8ToGlobal: op.length = 3; return true;
+		case O_LiteralInt16ToLocal:
+		case O_LiteralInt16ToGlobal: op.length = 4; return true;
+		case O_LiteralInt32ToLocal:
+		case O_LiteralInt32ToGlobal:
+		case O_LiteralFloatToLocal:
+		case O_LiteralFloatToGlobal: op.length = 6; return true;
+
+		case O_PopOne: op.pops = 1; return true;
+		case O_StackSwap: op.length = 2; return true;
+		case O_SwapTwoToTop: op.length = 3; return true;
+		case O_ToInt:
+		case O_ToFloat: op.pops = 1; op.pushes = 1; return true;
+
+		case O_IncLocal:
+		case O_DecLocal:
+		case O_IncGlobal:
+		case O_DecGlobal: op.length = 2; return true;
+
+		case O_BinaryAddition: op.math = WRJ_Add; goto binary;
+		case O_BinarySubtraction: op.math = WRJ_Sub; goto binary;
+		case O_BinaryMultiplication: op.math = WRJ_Mul; goto binary;
+		case O_BinaryDivision: op.math = WRJ_Div; goto binary;
+		case O_BinaryMod: op.math = WRJ_Mod; goto binary;
+		case O_BinaryLeftShift: op.math = WRJ_Shl; goto binary;
+		case O_BinaryRightShift: op.math = WRJ_Shr; goto binary;
+		case O_BinaryAnd: op.math = WRJ_And; goto binary;
+		case O_BinaryOr: op.math = WRJ_Or; goto binary;
+		case O_BinaryXOR:
+		{
+			op.math = WRJ_Xor;
+binary:
+			op.pops = 2;
+			op.pushes = 1;
+			return true;
+		}
+
+		case O_BinaryAdditionAndStoreLocal:
+		case O_BinaryAdditionAndStoreGlobal: op.math = WRJ_Add; goto binaryAndStore;
+		case O_BinarySubtractionAndStoreLocal:
+		case O_BinarySubtractionAndStoreGlobal: op.math = WRJ_Sub; goto binaryAndStore;
+		case O_BinaryMultiplicationAndStoreLocal:
+		case O_BinaryMultiplicationAndStoreGlobal: op.math = WRJ_Mul; goto binaryAndStore;
+		case O_BinaryDivisionAndStoreLocal:
+		case O_BinaryDivisionAndStoreGlobal:
+		{
+			op.math = WRJ_Div;
+binaryAndStore:
+			op.length = 2;
+			op.pops = 2;
+			return true;
+		}
+
+		case O_GGBinaryAddition:
+		case O_GLBinaryAddition:
+		case O_LLBinaryAddition: op.math = WRJ_Add; goto binaryValues;
+		case O_GGBinarySubtraction:
+		case O_GLBinarySubtraction:
+		case O_LGBinarySubtraction:
+		case O_LLBinarySubtraction: op.math = WRJ_Sub; goto binaryValues;
+		case O_GGBinaryMultiplication:
+		case O_GLBinaryMultiplication:
+		case O_LLBinaryMultiplication: op.math = WRJ_Mul; goto binaryValues;
+		case O_GGBinaryDivision:
+		case O_GLBinaryDivision:
+		case O_LGBinaryDivision:
+		case O_LLBinaryDivision:
+		{
+			op.math = WRJ_Div;
+binaryValues:
+			op.length = 3;
+			op.pushes = 1;
+			return true;
+		}
+
+		case O_AddAssignAndPop: op.math = WRJ_Add; goto assignAndPop;
+		case O_SubtractAssignAndPop: op.math = WRJ_Sub; goto assignAndPop;
+		case O_MultiplyAssignAndPop: op.math = WRJ_Mul; goto assignAndPop;
+		case O_DivideAssignAndPop: op.math = WRJ_Div; goto assignAndPop;
+		case O_ModAssignAndPop: op.math = WRJ_Mod; goto assignAndPop;
+		case O_LeftShiftAssignAndPop: op.math = WRJ_Shl; goto assignAndPop;
+		case O_RightShiftAssignAndPop: op.math = WRJ_Shr; goto assignAndPop;
+		case O_ANDAssignAndPop: op.math = WRJ_And; goto assignAndPop;
+		case O_ORAssignAndPop: op.math = WRJ_Or; goto assignAndPop;
+		case O_XORAssignAndPop: op.math = WRJ_Xor; goto assignAndPop;
+		case O_AssignAndPop:
+		{
+assignAndPop:
+			op.pops = 2;
+			return true;
+		}
+
+		case O_AssignToLocalAndPop:
+		case O_AssignToGlobalAndPop: op.length = 2; op.pops = 1; return true;
+
+		case O_CallLibFunction: op.pushes = 1; // fall through
+		case O_CallLibFunctionAndPop: op.length = 6; op.pops = READ_8_FROM_PC(pc + 1); return true;
+
+		case O_ReturnZero:
+		case O_Return: op.flow = WRJ_Return; return true;
+
+		case O_RelativeJump: op.length = 3; op.flow = WRJ_Jump; op.target = 1 + READ_16_FROM_PC(pc + 1); return true;
+		case O_RelativeJump8: op.length = 3; op.flow = WRJ_Jump; op.target = 1 + (int8_t)READ_8_FROM_PC(pc + 1); return true;
+		case O_RelativeJump32: op.length = 5; op.flow = WRJ_Jump; op.target = 1 + READ_32_FROM_PC(pc + 1); return true;
+		case O_BZ: op.length = 3; op.pops = 1; op.flow = WRJ_Branch; op.target = 1 + READ_16_FROM_PC(pc + 1); return true;
+		case O_BZ8: op.length = 3; op.pops = 1; op.flow = WRJ_Branch; op.target = 1 + (int8_t)READ_8_FROM_PC(pc + 1); return true;
+
+		WR_JIT_BRANCHES( EQ, WRJ_EQ, false )
+		WR_JIT_BRANCHES( NE, WRJ_EQ, true )
+		WR_JIT_BRANCHES( GE, WRJ_LT, true )
+		WR_JIT_BRANCHES( LE, WRJ_GT, true )
+		WR_JIT_BRANCHES( GT, WRJ_GT, false )
+		WR_JIT_BRANCHES( LT, WRJ_LT, false )
+
+		default: return false;
+	}
+
+	// a compare-and-branch, the 8 bit versions keep the 16 bit slot
+	op.flow = WRJ_Branch;
+	op.pops = op.form == WRJ_TwoStack ? 2 : (op.form == WRJ_LocalStack || op.form == WRJ_GlobalStack) ? 1 : 0;
+	op.length = op.form == WRJ_TwoStack ? 3 : (op.form == WRJ_LocalStack || op.form == WRJ_GlobalStack) ? 4 : 5;
+	op.target = op.length - 2;
+	op.target += wide ? READ_16_FROM_PC(pc + op.target) : (int8_t)READ_8_FROM_PC(pc + op.target);
+	return true;
+}
+
+#undef WR_JIT_BRANCHES
+#undef WR_JIT_BRANCH
+
+//------------------------------------------------------------------------------
+// where <T><S>Binary* finds its values, true for a local
+static void wr_jitBinarySpaces( const int opcode, bool& localT, bool& localS )
+{
+	switch( opcode )
+	{
+		case O_GGBinaryAddition:
+		case O_GGBinarySubtraction:
+		case O_GGBinaryMultiplication:
+		case O_GGBinaryDivision: localT = false; localS = false; break;
+		case O_GLBinaryAddition:
+		case O_GLBinarySubtraction:
+		case O_GLBinaryMultiplication:
+		case O_GLBinaryDivision: localT = false; localS = true; break;
+		case O_LGBinarySubtraction:
+		case O_LGBinaryDivision: localT = true; localS = false; break;
+		default: localT = true; localS = true; break;
+	}
+}
+
+//------------------------------------------------------------------------------
+// what is known about a stack entry at compile time
+enum WRJitSlotKind
+{
+	WRJ_Unknown,
+	WRJ_Int,
+	WRJ_Float,
+	WRJ_Local, // a reference to a local, as O_LoadFromLocal pushes it
+	WRJ_Global,
+};
+
+struct WRJitSlot
+{
+	uint8_t kind;
+	uint8_t index;
+};
+
+//------------------------------------------------------------------------------
+enum WRJitFlags
+{
+	WRJ_Start = 1<<0, // an instruction starts here
+	WRJ_Body = 1<<1, // operand bytes of one
+	WRJ_Target = 1<<2, // something jumps here
+};
+
+// every instruction of a function reachable from its start, with the
+// stack depth it sees, which must be the same on every path to it
+struct WRJitFunction
+{
+	const unsigned char* code;
+	int limit; // bytes looked at
+	int32_t* native; // per bytecode offset, free for the translator to use
+	int16_t* depth; // per bytecode offset, -1 when it is not reached
+	uint8_t* flags; // per bytecode offset, WRJitFlags
+	int maxDepth; // stack entries used above where it was entered
+	int instructions;
+
+	WRJitFunction() : native(0) {}
+	~WRJitFunction() { g_free( native ); }
+
+	bool analyze( const unsigned char* bottom, const int bottomSize, const int functionOffset );
+	bool analyze( const unsigned char* function, const int size );
+};
+
+//------------------------------------------------------------------------------
+// false if the function can not be translated
+bool WRJitFunction::analyze( const unsigned char* bottom, const int bottomSize, const int functionOffset )
+{
+	const int size = bottomSize - 4 - functionOffset; // the CRC ends the block
+	return analyze( bottom + functionOffset, size > WR_JIT_MAX_BYTECODE ? WR_JIT_MAX_BYTECODE : size );
+}
+
+//------------------------------------------------------------------------------
+// the code of a function, not all of 'size' has to be its own
+bool WRJitFunction::analyze( const unsigned char* function, const int size )
+{
+	code = function;
+	limit = size;
+	maxDepth = 0;
+	instructions = 0;
+	if ( limit <= 0
+		 || !(native = (int32_t*)g_malloc(limit * (2 * sizeof(int16_t) + sizeof(int32_t) + 1))) )
+	{
+		return false;
+	}
+	depth = (int16_t*)(native + limit);
+	int16_t* todo = depth + limit;
+	flags = (uint8_t*)(todo + limit);
+
+	memset( flags, 0, limit );
+	for( int i=0; i<limit; ++i )
+	{
+		depth[i] = -1;
+	}
+
+	int todoCount = 0;
+	depth[0] = 0;
+	todo[todoCount++] = 0;
+	while( todoCount )
+	{
+		const int pos = todo[--todoCount];
+		const int d = depth[pos];
+		WRJitOp op;
+		if ( (flags[pos] & WRJ_Body)
+			 || !wr_jitDecode(code + pos, op)
+			 || pos + op.length > limit
+			 || d < op.pops
+			 || (op.opcode == O_StackSwap && (READ_8_FROM_PC(code + pos + 1) < 1 || READ_8_FROM_PC(code + pos + 1) > d))
+			 || (op.opcode == O_SwapTwoToTop && (READ_8_FROM_PC(code + pos + 1) < 1 || READ_8_FROM_PC(code + pos + 1) > d
+												 || READ_8_FROM_PC(code + pos + 2) < 1 || READ_8_FROM_PC(code + pos + 2) > d || d < 2))
+			 || (op.opcode == O_Return && d != 1)
+			 || (op.opcode == O_ReturnZero && d != 0) )
+		{
+			return false;
+		}
+
+		flags[pos] |= WRJ_Start;
+		++instructions;
+		for( int i=1; i<op.length; ++i )
+		{
+			if ( depth[pos + i] != -1 )
+			{
+				return false; // jumps into the middle of an instruction
+			}
+			flags[pos + i] |= WRJ_Body;
+		}
+
+		const int next = d - op.pops + op.pushes;
+		const int used = (op.opcode == O_CallLibFunction || op.opcode == O_CallLibFunctionAndPop) ? d + 1 : next;
+		maxDepth = used > maxDepth ? used : maxDepth;
+
+		int successors[2];
+		int count = 0;
+		if ( op.flow == WRJ_Next || op.flow == WRJ_Branch )
+		{
+			successors[count++] = pos + op.length;
+		}
+		if ( op.flow == WRJ_Jump || op.flow == WRJ_Branch )
+		{
+			successors[count++] = pos + op.target;
+		}
+
+		for( int s=0; s<count; ++s )
+		{
+			const int to = successors[s];
+			if ( to < 0 || to >= limit || next > 0x7FFF )
+			{
+				return false;
+			}
+			if ( s || op.flow == WRJ_Jump )
+			{
+				flags[to] |= WRJ_Target;
+			}
+
+			if ( depth[to] == -1 )
+			{
+				depth[to] = (int16_t)next;
+				todo[todoCount++] = (int16_t)to;
+			}
+			else if ( depth[to] != next )
+			{
+				return false;
+			}
+		}
+	}
+
+	return true;
+}
+
+#endif
+
+#ifndef WRENCH_WITHOUT_COMPILER
+//------------------------------------------------------------------------------
+// WR_OPTIMIZE, a pass over the code of each function once it is compiled.
+// It sees the code the way the JIT does, through wr_jitDecode(), and a
+// function with an opcode that does not know is left as it was compiled.
+// Instructions are folded, rewritten and removed in place, then the
+// function is written out again and resolveRelativeJumps() settles its
+// jumps
+
+// one instruction of the function being optimized
+struct WROptInstruction
+{
+	unsigned char code[6]; // what is written for it
+	WRJitOp op; // decoded from 'code'
+	int pos; // where it was compiled, for the stack depth found there
+	int at; // where it is written
+	int target; // the instruction a jump or branch goes to
+	int call; // the functionSpace entry of a call to a script function, -1 for anything else
+	bool removed;
+	bool isTarget; // jumped to, nothing is known about the stack or the locals here
+};
+
+enum
+{
+	WRO_Unknown = -1, // could reference any local
+	WRO_Value = -2, // references no local
+};
+
+// what is known about a stack entry while copies are propagated
+struct WROptSlot
+{
+	int local; // the local it references, or WRO_Unknown/WRO_Value
+	int load; // the O_LoadFromLocal that pushed it when it can read 'copy' instead, -1 if not
+	int copy;
+};
+
+//------------------------------------------------------------------------------
+struct WROptimizer
+{
+	WROptInstruction* ins;
+	int count;
+	WRJitFunction* f;
+	int arguments; // the caller's values, by reference, anything can alias them
+	bool exported; // the locals are read by name from outside
+
+	// propagate()
+	WROptSlot* stack;
+	int depth;
+	int copyOf[256]; // the local each one is a copy of, -1 when it is not
+	bool changed;
+
+	int live( int i ) const { while( i < count && ins[i].removed ) { ++i; } return i; }
+	int next( const int i ) const { return live( i + 1 ); }
+	static bool isJump( const WROptInstruction& I ) { return I.op.flow == WRJ_Jump || I.op.flow == WRJ_Branch; }
+
+	void set( const int i, const unsigned char* code, const int length )
+	{
+		memcpy( ins[i].code, code, length );
+		wr_jitDecode( ins[i].code, ins[i].op );
+	}
+	void setJump( const int i, const int target )
+	{
+		const unsigned char jump[3] = { O_RelativeJump, 0, 0 };
+		set( i, jump, 3 );
+		ins[i].target = target;
+	}
+	void setLiteral( const int i, const WRValue& value );
+	void setLiteralTo( const int i, const WRValue& value, const bool local, const unsigned char index );
+	bool literal( const int i, WRValue& value ) const;
+	bool isPush( const int i ) const;
+
+	void markTargets();
+	bool thread();
+	bool fold();
+	bool reach();
+	bool deadStores();
+
+	bool propagate();
+	int read( WROptSlot& slot );
+	void write( const WROptSlot& slot );
+	void kill( const int local );
+	void forget();
+};
+
+//------------------------------------------------------------------------------
+// the bytes of an instruction naming a local it reads right away
+static int wr_optLocalOperands( const WROptInstruction& I, int* at )
+{
+	int n = 0;
+	switch( I.op.opcode )
+	{
+		case O_GGBinaryAddition:
+		case O_GLBinaryAddition:
+		case O_LLBinaryAddition:
+		case O_GGBinarySubtraction:
+		case O_GLBinarySubtraction:
+		case O_LGBinarySubtraction:
+		case O_LLBinarySubtraction:
+		case O_GGBinaryMultiplication:
+		case O_GLBinaryMultiplication:
+		case O_LLBinaryMultiplication:
+		case O_GGBinaryDivision:
+		case O_GLBinaryDivision:
+		case O_LGBinaryDivision:
+		case O_LLBinaryDivision:
+		{
+			bool localT, localS;
+			wr_jitBinarySpaces( I.op.opcode, localT, localS );
+			if ( localS )
+			{
+				at[n++] = 1;
+			}
+			if ( localT )
+			{
+				at[n++] = 2;
+			}
+			break;
+		}
+
+		case O_BZ:
+		case O_BZ8:
+			break;
+
+		default:
+		{
+			if ( I.op.flow == WRJ_Branch && (I.op.form == WRJ_LocalStack || I.op.form == WRJ_TwoLocal) )
+			{
+				at[n++] = 1;
+				if ( I.op.form == WRJ_TwoLocal )
+				{
+					at[n++] = 2;
 				}
-								
-				bytecode.all[a] = O_AssignAndPop;
-				bytecode.opcodes[o] = O_AssignAndPop;
-				return;
 			}
-			else if ( bytecode.opcodes[o] == O_LiteralZero ) // put a zero on just to pop it off..
+			break;
+		}
+	}
+	return n;
+}
+
+//------------------------------------------------------------------------------
+static bool wr_optStoresLiteral( const int opcode )
+{
+	switch( opcode )
+	{
+		case O_LiteralInt8ToLocal:
+		case O_LiteralInt16ToLocal:
+		case O_LiteralInt32ToLocal:
+		case O_LiteralFloatToLocal:
+		case O_LiteralInt8ToGlobal:
+		case O_LiteralInt16ToGlobal:
+		case O_LiteralInt32ToGlobal:
+		case O_LiteralFloatToGlobal:
+			return true;
+
+		default:
+			return false;
+	}
+}
+
+//------------------------------------------------------------------------------
+// the local an instruction stores to, -1 for none
+static int wr_optStoredLocal( const WROptInstruction& I )
+{
+	switch( I.op.opcode )
+	{
+		case O_AssignToLocalAndPop:
+		case O_LiteralInt8ToLocal:
+		case O_LiteralInt16ToLocal:
+		case O_LiteralInt32ToLocal:
+		case O_LiteralFloatToLocal:
+		case O_BinaryAdditionAndStoreLocal:
+		case O_BinarySubtractionAndStoreLocal:
+		case O_BinaryMultiplicationAndStoreLocal:
+		case O_BinaryDivisionAndStoreLocal:
+		case O_IncLocal:
+		case O_DecLocal:
+			return I.code[1];
+
+		default:
+			return -1;
+	}
+}
+
+//------------------------------------------------------------------------------
+// T 'math' S as the interpreter does it, false when that is left to run
+// time, which is anything but two ints or two floats
+static bool wr_optMath( const int math, const WRValue& T, const WRValue& S, WRValue& R )
+{
+	if ( T.type != S.type )
+	{
+		return false;
+	}
+
+	if ( T.type == WR_FLOAT )
+	{
+		R.p2 = INIT_AS_FLOAT;
+		switch( math )
+		{
+			case WRJ_Add: R.f = T.f + S.f; return true;
+			case WRJ_Sub: R.f = T.f - S.f; return true;
+			case WRJ_Mul: R.f = T.f * S.f; return true;
+			case WRJ_Div: R.f = T.f / S.f; return true;
+			default: return false;
+		}
+	}
+
+	const uint32_t t = (uint32_t)T.i;
+	const uint32_t s = (uint32_t)S.i;
+	R.p2 = INIT_AS_INT;
+	switch( math )
+	{
+		case WRJ_Add: R.i = (int32_t)(t + s); return true;
+		case WRJ_Sub: R.i = (int32_t)(t - s); return true;
+		case WRJ_Mul: R.i = (int32_t)(t * s); return true;
+		case WRJ_Div:
+		case WRJ_Mod:
+		{
+			if ( !S.i || (S.i == -1 && T.i == (int32_t)0x80000000) )
 			{
-				bytecode.opcodes.clear();
-				bytecode.all.shave(1);
-				return;
+				return false;
 			}
-			else if ( bytecode.opcodes[o] == O_SubtractAssign )
+			R.i = math == WRJ_Div ? T.i / S.i : T.i % S.i;
+			return true;
+		}
+		case WRJ_Shl:
+		case WRJ_Shr:
+		{
+			if ( s > 31 )
 			{
-				bytecode.all[a] = O_SubtractAssignAndPop;
-				bytecode.opcodes[o] = O_SubtractAssignAndPop;
-				return;
+				return false;
 			}
-			else if ( bytecode.opcodes[o] == O_AddAssign )
+			R.i = math == WRJ_Shl ? (int32_t)(t << s) : T.i >> s;
+			return true;
+		}
+		case WRJ_And: R.i = T.i & S.i; return true;
+		case WRJ_Or: R.i = T.i | S.i; return true;
+		case WRJ_Xor: R.i = T.i ^ S.i; return true;
+		default: return false;
+	}
+}
+
+//------------------------------------------------------------------------------
+static bool wr_optCompare( const int compare, const WRValue& X, const WRValue& Y, bool& result )
+{
+	if ( X.type != Y.type )
+	{
+		return false;
+	}
+
+	if ( X.type == WR_FLOAT )
+	{
+		result = compare == WRJ_EQ ? X.f == Y.f : compare == WRJ_LT ? X.f < Y.f : X.f > Y.f;
+	}
+	else
+	{
+		result = compare == WRJ_EQ ? X.i == Y.i : compare == WRJ_LT ? X.i < Y.i : X.i > Y.i;
+	}
+	return true;
+}
+
+//------------------------------------------------------------------------------
+// the shortest push of 'value', the way pushLiteral() picks it
+void WROptimizer::setLiteral( const int i, const WRValue& value )
+{
+	unsigned char code[5];
+	int length = 5;
+	if ( value.type == WR_FLOAT )
+	{
+		code[0] = O_LiteralFloat;
+		wr_pack32( value.i, code + 1 );
+	}
+	else if ( value.i == 0 )
+	{
+		code[0] = O_LiteralZero;
+		length = 1;
+	}
+	else if ( value.i <= 127 && value.i >= -128 )
+	{
+		code[0] = O_LiteralInt8;
+		code[1] = (unsigned char)value.i;
+		length = 2;
+	}
+	else if ( value.i <= 32767 && value.i >= -32768 )
+	{
+		code[0] = O_LiteralInt16;
+		wr_pack16( (int16_t)value.i, code + 1 );
+		length = 3;
+	}
+	else
+	{
+		code[0] = O_LiteralInt32;
+		wr_pack32( value.i, code + 1 );
+	}
+	set( i, code, length );
+}
+
+//------------------------------------------------------------------------------
+// what the keyhole makes of a literal assigned to a variable
+void WROptimizer::setLiteralTo( const int i, const WRValue& value, const bool local, const unsigned char index )
+{
+	unsigned char code[6];
+	int length = 6;
+	code[1] = index;
+	if ( value.type == WR_FLOAT )
+	{
+		code[0] = local ? O_LiteralFloatToLocal : O_LiteralFloatToGlobal;
+		wr_pack32( value.i, code + 2 );
+	}
+	else if ( value.i <= 127 && value.i >= -128 )
+	{
+		code[0] = local ? O_LiteralInt8ToLocal : O_LiteralInt8ToGlobal;
+		code[2] = (unsigned char)value.i;
+		length = 3;
+	}
+	else if ( value.i <= 32767 && value.i >= -32768 )
+	{
+		code[0] = local ? O_LiteralInt16ToLocal : O_LiteralInt16ToGlobal;
+		wr_pack16( (int16_t)value.i, code + 2 );
+		length = 4;
+	}
+	else
+	{
+		code[0] = local ? O_LiteralInt32ToLocal : O_LiteralInt32ToGlobal;
+		wr_pack32( value.i, code + 2 );
+	}
+	set( i, code, length );
+}
+
+//------------------------------------------------------------------------------
+bool WROptimizer::literal( const int i, WRValue& value ) const
+{
+	const unsigned char* code = ins[i].code;
+	value.p2 = INIT_AS_INT;
+	switch( ins[i].op.opcode )
+	{
+		case O_LiteralZero: value.i = 0; return true;
+		case O_LiteralInt8: value.i = (int8_t)READ_8_FROM_PC(code + 1); return true;
+		case O_LiteralInt16: value.i = READ_16_FROM_PC(code + 1); return true;
+		case O_LiteralInt32: value.i = READ_32_FROM_PC(code + 1); return true;
+		case O_LiteralFloat: value.p2 = INIT_AS_FLOAT; value.i = READ_32_FROM_PC(code + 1); return true;
+		default: return false;
+	}
+}
+
+//------------------------------------------------------------------------------
+// pushes without doing anything else
+bool WROptimizer::isPush( const int i ) const
+{
+	WRValue value;
+	return literal( i, value )
+		   || ins[i].op.opcode == O_LoadFromLocal
+		   || ins[i].op.opcode == O_LoadFromGlobal;
+}
+
+//------------------------------------------------------------------------------
+// removed instructions pass being jumped to on to the next one
+void WROptimizer::markTargets()
+{
+	for( int i=0; i<count; ++i )
+	{
+		ins[i].isTarget = false;
+	}
+	for( int i=live(0); i<count; i=next(i) )
+	{
+		if ( isJump(ins[i]) )
+		{
+			ins[i].target = live( ins[i].target );
+			if ( ins[i].target < count )
 			{
-				bytecode.all[a] = O_AddAssignAndPop;
-				bytecode.opcodes[o] = O_AddAssignAndPop;
-				return;
+				ins[ins[i].target].isTarget = true;
 			}
-			else if ( bytecode.opcodes[o] == O_ModAssign )
+		}
+	}
+}
+
+//------------------------------------------------------------------------------
+// jumps to jumps go straight to where those go, jumps to a return return
+// and jumps to the next instruction are not made
+bool WROptimizer::thread()
+{
+	markTargets();
+	bool changed = false;
+	for( int i=live(0); i<count; i=next(i) )
+	{
+		WROptInstruction& I = ins[i];
+		if ( !isJump(I) )
+		{
+			continue;
+		}
+
+		int target = I.target;
+		for( int hops=0; hops<count && target < count && target != i && ins[target].op.flow == WRJ_Jump; ++hops )
+		{
+			target = live( ins[target].target );
+		}
+		if ( target >= count )
+		{
+			continue;
+		}
+		if ( target != I.target )
+		{
+			I.target = target;
+			changed = true;
+		}
+
+		if ( I.op.flow == WRJ_Jump && ins[target].op.flow == WRJ_Return )
+		{
+			set( i, ins[target].code, 1 );
+			changed = true;
+		}
+		else if ( target == next(i) )
+		{
+			static const unsigned char pop = O_PopOne;
+			if ( I.op.flow == WRJ_Jump
+				 || (I.op.opcode != O_BZ && I.op.opcode != O_BZ8 && (I.op.form == WRJ_TwoLocal || I.op.form == WRJ_TwoGlobal)) )
 			{
-				bytecode.all[a] = O_ModAssignAndPop;
-				bytecode.opcodes[o] = O_ModAssignAndPop;
-				return;
+				I.removed = true;
+				changed = true;
 			}
-			else if ( bytecode.opcodes[o] == O_MultiplyAssign )
+			else if ( I.op.opcode == O_BZ || I.op.opcode == O_BZ8 || I.op.form != WRJ_TwoStack )
 			{
-				bytecode.all[a] = O_MultiplyAssignAndPop;
-				bytecode.opcodes[o] = O_MultiplyAssignAndPop;
-				return;
+				// one value was popped to decide
+				set( i, &pop, 1 );
+				changed = true;
 			}
-			else if ( bytecode.opcodes[o] == O_DivideAssign )
+		}
+	}
+	return changed;
+}
+
+//------------------------------------------------------------------------------
+// literals operated on or compared become the result, a value nobody
+// looks at is not pushed
+bool WROptimizer::fold()
+{
+	markTargets();
+	bool changed = false;
+	for( int i=live(0); i<count; i=next(i) )
+	{
+		const int j = next( i );
+		if ( j >= count || ins[j].isTarget )
+		{
+			continue;
+		}
+		const int k = next( j );
+		const bool third = k < count && !ins[k].isTarget;
+		const WRJitOp& J = ins[j].op;
+
+		if ( J.opcode == O_PopOne && isPush(i) )
+		{
+			ins[i].removed = true;
+			ins[j].removed = true;
+			changed = true;
+			continue;
+		}
+
+		if ( isPush(i) && wr_optStoresLiteral(J.opcode) )
+		{
+			// either can go first, what is pushed is only read where it is
+			// used. With the store first the push meets its user
+			const WROptInstruction I = ins[i];
+			memcpy( ins[i].code, ins[j].code, sizeof(ins[i].code) );
+			ins[i].op = J;
+			memcpy( ins[j].code, I.code, sizeof(ins[j].code) );
+			ins[j].op = I.op;
+			changed = true;
+			continue;
+		}
+
+		WRValue S;
+		WRValue T;
+		if ( !literal(i, S) )
+		{
+			continue;
+		}
+
+		if ( literal(j, T) )
+		{
+			if ( !third )
 			{
-				bytecode.all[a] = O_DivideAssignAndPop;
-				bytecode.opcodes[o] = O_DivideAssignAndPop;
-				return;
+				continue;
 			}
-			else if ( bytecode.opcodes[o] == O_ORAssign )
+
+			// T is on top, the way the binary and compare opcodes see it
+			const WRJitOp& K = ins[k].op;
+			WRValue R;
+			bool result;
+			if ( K.opcode == O_StackSwap && ins[k].code[1] == 2 )
+			{
+				// the compiler swaps the operands it pushed in the wrong order
+				const WROptInstruction I = ins[i];
+				memcpy( ins[i].code, ins[j].code, sizeof(ins[i].code) );
+				ins[i].op = ins[j].op;
+				memcpy( ins[j].code, I.code, sizeof(ins[j].code) );
+				ins[j].op = I.op;
+				ins[k].removed = true;
+				changed = true;
+				continue;
+			}
+			else if ( K.length == 1 && K.pops == 2 && K.pushes == 1 && wr_optMath(K.math, T, S, R) )
 			{
-				bytecode.all[a] = O_ORAssignAndPop;
-				bytecode.opcodes[o] = O_ORAssignAndPop;
-				return;
+				setLiteral( i, R );
 			}
-			else if ( bytecode.opcodes[o] == O_ANDAssign )
+			else if ( K.length == 2 && K.pops == 2 && K.pushes == 0 && wr_optMath(K.math, T, S, R) )
 			{
-				bytecode.all[a] = O_ANDAssignAndPop;
-				bytecode.opcodes[o] = O_ANDAssignAndPop;
-				return;
+				// BinaryXAndStoreLocal/Global
+				setLiteralTo( i, R, wr_optStoredLocal(ins[k]) >= 0, ins[k].code[1] );
+			}
+			else if ( K.flow == WRJ_Branch && K.opcode != O_BZ && K.opcode != O_BZ8
+					  && K.form == WRJ_TwoStack && wr_optCompare(K.compare, T, S, result) )
+			{
+				if ( result == K.when )
+				{
+					setJump( i, ins[k].target );
+				}
+				else
+				{
+					ins[i].removed = true;
+				}
+			}
+			else
+			{
+				continue;
+			}
+
+			ins[j].removed = true;
+			ins[k].removed = true;
+			changed = true;
+			continue;
+		}
+
+		switch( J.opcode )
+		{
+			case O_BZ:
+			case O_BZ8:
+			{
+				if ( S.type != WR_INT )
+				{
+					continue;
+				}
+				if ( S.i )
+				{
+					ins[i].removed = true;
+				}
+				else
+				{
+					setJump( i, ins[j].target );
+				}
+				break;
 			}
-			else if ( bytecode.opcodes[o] == O_XORAssign )
+
+			case O_ToInt:
 			{
-				bytecode.all[a] = O_XORAssignAndPop;
-				bytecode.opcodes[o] = O_XORAssignAndPop;
-				return;
+				if ( S.type == WR_FLOAT )
+				{
+					if ( !(S.f >= -2147483648.0f && S.f < 2147483648.0f) )
+					{
+						continue;
+					}
+					S.i = (int)S.f;
+					S.p2 = INIT_AS_INT;
+					setLiteral( i, S );
+				}
+				break;
 			}
-			else if ( bytecode.opcodes[o] == O_RightShiftAssign )
+
+			case O_ToFloat:
 			{
-				bytecode.all[a] = O_RightShiftAssignAndPop;
-				bytecode.opcodes[o] = O_RightShiftAssignAndPop;
-				return;
+				if ( S.type == WR_INT )
+				{
+					S.f = (float)S.i;
+					S.p2 = INIT_AS_FLOAT;
+					setLiteral( i, S );
+				}
+				break;
 			}
-			else if ( bytecode.opcodes[o] == O_LeftShiftAssign )
+
+			case O_AssignToLocalAndPop:
+			case O_AssignToGlobalAndPop:
 			{
-				bytecode.all[a] = O_LeftShiftAssignAndPop;
-				bytecode.opcodes[o] = O_LeftShiftAssignAndPop;
-				return;
+				setLiteralTo( i, S, J.opcode == O_AssignToLocalAndPop, ins[j].code[1] );
+				break;
 			}
+
+			default:
+				continue;
 		}
+
+		ins[j].removed = true;
+		changed = true;
 	}
-#endif
-	bytecode.all += opcode;
-	bytecode.opcodes += opcode;
+	return changed;
 }
 
 //------------------------------------------------------------------------------
-void WRCompilationContext::appendBytecode( WRBytecode& bytecode, WRBytecode& addMe )
+// what can not be reached from the start is removed
+bool WROptimizer::reach()
 {
-	for (unsigned int n = 0; n < addMe.jumpOffsetTargets.count(); ++n)
+	int* todo = (int*)wr_arenaMalloc( (count * 2 + 1) * sizeof(int) + count );
+	bool* seen = (bool*)(todo + count * 2 + 1);
+	memset( seen, 0, count );
+
+	int todoCount = 0;
+	todo[todoCount++] = live( 0 );
+	while( todoCount )
 	{
-		if (addMe.jumpOffsetTargets[n].gotoHash)
+		const int i = todo[--todoCount];
+		if ( i >= count || seen[i] )
 		{
-			int index = addRelativeJumpTarget(bytecode);
-			bytecode.jumpOffsetTargets[index].gotoHash = addMe.jumpOffsetTargets[n].gotoHash;
-			bytecode.jumpOffsetTargets[index].offset = addMe.jumpOffsetTargets[n].offset + bytecode.all.size();
+			continue;
+		}
+		seen[i] = true;
+		if ( ins[i].op.flow == WRJ_Next || ins[i].op.flow == WRJ_Branch )
+		{
+			todo[todoCount++] = next( i );
+		}
+		if ( isJump(ins[i]) )
+		{
+			todo[todoCount++] = live( ins[i].target );
 		}
 	}
 
-	// add the namespace, making sure to offset it into the new block properly
-	for (unsigned int n = 0; n < addMe.localSpace.count(); ++n)
+	bool changed = false;
+	for( int i=live(0); i<count; i=next(i) )
+	{
+		if ( !seen[i] )
+		{
+			ins[i].removed = true;
+			changed = true;
+		}
+	}
+
+	wr_arenaFree( todo );
+	return changed;
+}
+
+//------------------------------------------------------------------------------
+// stores to a local that is never read are not made, arguments are the
+// caller's and are left alone
+bool WROptimizer::deadStores()
+{
+	if ( exported )
+	{
+		return false;
+	}
+
+	markTargets();
+	bool used[256];
+	memset( used, 0, sizeof(used) );
+	for( int i=live(0); i<count; i=next(i) )
+	{
+		int at[2];
+		const int n = wr_optLocalOperands( ins[i], at );
+		for( int o=0; o<n; ++o )
+		{
+			used[ins[i].code[at[o]]] = true;
+		}
+		if ( ins[i].op.opcode == O_LoadFromLocal || ins[i].op.opcode == O_IncLocal || ins[i].op.opcode == O_DecLocal )
+		{
+			used[ins[i].code[1]] = true;
+		}
+	}
+
+	bool changed = false;
+	int before[2] = { count, count }; // the two live instructions in front
+	for( int i=live(0); i<count; i=next(i) )
 	{
-		unsigned int m = 0;
-		for (m = 0; m < bytecode.localSpace.count(); ++m)
+		const int local = wr_optStoredLocal( ins[i] );
+		if ( local >= arguments && !used[local] )
 		{
-			if (bytecode.localSpace[m].hash == addMe.localSpace[n].hash)
+			static const unsigned char pop = O_PopOne;
+			switch( ins[i].op.opcode )
 			{
-				for (unsigned int s = 0; s < addMe.localSpace[n].references.count(); ++s)
+				case O_AssignToLocalAndPop: set( i, &pop, 1 ); changed = true; break;
+
+				case O_LiteralInt8ToLocal:
+				case O_LiteralInt16ToLocal:
+				case O_LiteralInt32ToLocal:
+				case O_LiteralFloatToLocal: ins[i].removed = true; changed = true; break;
+
+				case O_BinaryAdditionAndStoreLocal:
+				case O_BinarySubtractionAndStoreLocal:
+				case O_BinaryMultiplicationAndStoreLocal:
+				case O_BinaryDivisionAndStoreLocal:
 				{
-					bytecode.localSpace[m].references.append() = addMe.localSpace[n].references[s] + bytecode.all.size();
+					// only when what it pops can go as well
+					if ( before[1] < count && isPush(before[0]) && isPush(before[1])
+						 && !ins[before[0]].isTarget && !ins[i].isTarget )
+					{
+						ins[before[1]].removed = true;
+						ins[before[0]].removed = true;
+						ins[i].removed = true;
+						changed = true;
+					}
+					break;
 				}
 
-				break;
+				default: break;
 			}
 		}
 
-		if (m >= bytecode.localSpace.count())
+		if ( !ins[i].removed )
 		{
-			WRNamespaceLookup* space = &bytecode.localSpace.append();
-			*space = addMe.localSpace[n];
-			for (unsigned int s = 0; s < space->references.count(); ++s)
+			before[1] = before[0];
+			before[0] = i;
+		}
+	}
+	return changed;
+}
+
+//------------------------------------------------------------------------------
+// where "b = a;" was done and neither has changed since, b is read from
+// a so the store to b can go when nothing else reads it. Only within
+// straight code and only locals of the function itself, the arguments
+// could be references to the same value
+bool WROptimizer::propagate()
+{
+	markTargets();
+	changed = false;
+	depth = 0;
+	bool fallsThrough = false;
+	for( int i=live(0); i<count; i=next(i) )
+	{
+		WROptInstruction& I = ins[i];
+		const WRJitOp& op = I.op;
+		const bool start = I.isTarget || !fallsThrough;
+		fallsThrough = op.flow == WRJ_Next || op.flow == WRJ_Branch;
+		if ( start )
+		{
+			forget();
+			depth = f->depth[I.pos];
+			for( int d=0; d<depth; ++d )
 			{
-				space->references[s] += bytecode.all.size();
+				stack[d].local = WRO_Unknown;
+				stack[d].load = -1;
+			}
+		}
+
+		int at[2];
+		const int n = wr_optLocalOperands( I, at );
+		for( int o=0; o<n; ++o )
+		{
+			if ( copyOf[I.code[at[o]]] >= 0 )
+			{
+				I.code[at[o]] = (unsigned char)copyOf[I.code[at[o]]];
+				changed = true;
+			}
+		}
+
+		switch( op.opcode )
+		{
+			case O_LoadFromLocal:
+			{
+				WROptSlot& slot = stack[depth++];
+				slot.local = I.code[1];
+				slot.copy = copyOf[slot.local];
+				slot.load = slot.copy >= 0 ? i : -1;
+				continue;
+			}
+
+			case O_AssignToLocalAndPop:
+			{
+				const int from = read( stack[--depth] );
+				const int to = I.code[1];
+				kill( to );
+				if ( from >= arguments && to >= arguments && from != to )
+				{
+					copyOf[to] = from;
+				}
+				continue;
+			}
+
+			case O_PopOne: --depth; continue;
+
+			case O_StackSwap:
+			case O_SwapTwoToTop:
+			{
+				for( int n=0; n<op.length - 1; ++n )
+				{
+					const WROptSlot swap = stack[depth - 1 - n];
+					stack[depth - 1 - n] = stack[depth - I.code[1 + n]];
+					stack[depth - I.code[1 + n]] = swap;
+				}
+				continue;
+			}
+
+			case O_AddAssignAndPop:
+			case O_SubtractAssignAndPop:
+			case O_MultiplyAssignAndPop:
+			case O_DivideAssignAndPop:
+			case O_ModAssignAndPop:
+			case O_LeftShiftAssignAndPop:
+			case O_RightShiftAssignAndPop:
+			case O_ANDAssignAndPop:
+			case O_ORAssignAndPop:
+			case O_XORAssignAndPop:
+			case O_AssignAndPop:
+			{
+				// assigns through the reference on top
+				read( stack[depth - 2] );
+				write( stack[depth - 1] );
+				depth -= 2;
+				continue;
+			}
+
+			case O_CallLibFunction:
+			case O_CallLibFunctionAndPop:
+			{
+				// the arguments are references the function could keep or write
+				forget();
+				depth -= op.pops;
+				if ( op.pushes )
+				{
+					stack[depth].local = WRO_Unknown;
+					stack[depth++].load = -1;
+				}
+				continue;
 			}
+
+			default: break;
+		}
+
+		for( int p=0; p<op.pops; ++p )
+		{
+			read( stack[--depth] );
+		}
+
+		const int stored = wr_optStoredLocal( I );
+		if ( stored >= 0 )
+		{
+			kill( stored );
+		}
+
+		for( int p=0; p<op.pushes; ++p )
+		{
+			stack[depth].local = WRO_Value;
+			stack[depth++].load = -1;
 		}
 	}
+	return changed;
+}
 
-	// add the function space, making sure to offset it into the new block properly
-	for (unsigned int n = 0; n < addMe.functionSpace.count(); ++n)
+//------------------------------------------------------------------------------
+// the value of a stack entry is used, returns the local it was read from
+int WROptimizer::read( WROptSlot& slot )
+{
+	if ( slot.load >= 0 )
 	{
-		WRNamespaceLookup* space = &bytecode.functionSpace.append();
-		*space = addMe.functionSpace[n];
-		for (unsigned int s = 0; s < space->references.count(); ++s)
+		ins[slot.load].code[1] = (unsigned char)slot.copy;
+		slot.local = slot.copy;
+		slot.load = -1;
+		changed = true;
+	}
+	return slot.local;
+}
+
+//------------------------------------------------------------------------------
+void WROptimizer::write( const WROptSlot& slot )
+{
+	if ( slot.local >= 0 )
+	{
+		kill( slot.local );
+	}
+	else if ( slot.local == WRO_Unknown )
+	{
+		forget();
+	}
+}
+
+//------------------------------------------------------------------------------
+// 'local' changes, copies of it or in it are not known anymore
+void WROptimizer::kill( const int local )
+{
+	copyOf[local] = -1;
+	for( int l=0; l<256; ++l )
+	{
+		if ( copyOf[l] == local )
 		{
-			space->references[s] += bytecode.all.size();
+			copyOf[l] = -1;
 		}
 	}
-
-	// add the function space, making sure to offset it into the new block properly
-	for (unsigned int u = 0; u < addMe.unitObjectSpace.count(); ++u)
+	for( int d=0; d<depth; ++d )
 	{
-		WRNamespaceLookup* space = &bytecode.unitObjectSpace.append();
-		*space = addMe.unitObjectSpace[u];
-		for (unsigned int s = 0; s < space->references.count(); ++s)
+		if ( stack[d].load >= 0 && (stack[d].local == local || stack[d].copy == local) )
 		{
-			space->references[s] += bytecode.all.size();
+			stack[d].load = -1;
 		}
 	}
+}
 
-	// add the goto targets, making sure to offset it into the new block properly
-	for (unsigned int u = 0; u < addMe.gotoSource.count(); ++u)
+//------------------------------------------------------------------------------
+void WROptimizer::forget()
+{
+	for( int l=0; l<256; ++l )
 	{
-		GotoSource* G = &bytecode.gotoSource.append();
-		G->hash = addMe.gotoSource[u].hash;
-		G->offset = addMe.gotoSource[u].offset + bytecode.all.size();
+		copyOf[l] = -1;
+	}
+	for( int d=0; d<depth; ++d )
+	{
+		stack[d].load = -1;
 	}
+}
 
-	if ( bytecode.all.size() > 1
-		 && bytecode.opcodes.size() > 0
-		 && addMe.opcodes.size() == 1
-		 && addMe.all.size() > 2
-		 && addMe.gotoSource.count() == 0
-		 && addMe.opcodes[0] == O_IndexLiteral16
-		 && bytecode.opcodes[bytecode.opcodes.size() - 1] == O_LoadFromLocal )
+//------------------------------------------------------------------------------
+// decodes 'code' into o.ins, 'calls' has the functionSpace entry of each
+// call to a script function by position, or is null when there are none
+static bool wr_optLoad( WROptimizer& o, WRJitFunction& f, const unsigned char* code, const int size, const int* calls )
+{
+	if ( !f.analyze(code, size) )
 	{
-		bytecode.all[bytecode.all.size()-2] = O_IndexLocalLiteral16;
-		for( unsigned int i=1; i<addMe.all.size(); ++i )
-		{
-			bytecode.all += addMe.all[i];	
-		}
-		bytecode.opcodes.clear();
-		bytecode.opcodes += O_IndexLocalLiteral16;
-		return;
+		return false;
 	}
-	else if ( bytecode.all.size() > 1
-			  && bytecode.opcodes.size() > 0
-			  && addMe.opcodes.size() == 1
-			  && addMe.all.size() > 2
-			  && addMe.gotoSource.count() == 0
-			  && addMe.opcodes[0] == O_IndexLiteral16
-			  && bytecode.opcodes[bytecode.opcodes.size() - 1] == O_LoadFromGlobal )
+
+	o.f = &f;
+	o.count = f.instructions;
+	o.ins = (WROptInstruction*)wr_arenaMalloc( o.count * sizeof(WROptInstruction) );
+
+	// in address order, falling through stays falling through
+	int n = 0;
+	for( int pos=0; pos<f.limit; ++pos )
 	{
-		bytecode.all[bytecode.all.size()-2] = O_IndexGlobalLiteral16;
-		for( unsigned int i=1; i<addMe.all.size(); ++i )
+		if ( f.flags[pos] & WRJ_Start )
 		{
-			bytecode.all += addMe.all[i];	
+			WROptInstruction& I = o.ins[n];
+			f.native[pos] = n++;
+			wr_jitDecode( code + pos, I.op );
+			memcpy( I.code, code + pos, I.op.length );
+			I.pos = pos;
+			I.call = calls ? calls[pos] : -1;
+			I.removed = false;
 		}
-		bytecode.opcodes.clear();
-		bytecode.opcodes += O_IndexGlobalLiteral16;
-		return;
 	}
-	else if ( bytecode.all.size() > 1
-			  && bytecode.opcodes.size() > 0
-			  && addMe.opcodes.size() == 1
-			  && addMe.all.size() > 1
-			  && addMe.gotoSource.count() == 0
-			  && addMe.opcodes[0] == O_IndexLiteral8
-			  && bytecode.opcodes[bytecode.opcodes.size() - 1] == O_LoadFromLocal )
+	for( int i=0; i<o.count; ++i )
+	{
+		o.ins[i].target = WROptimizer::isJump(o.ins[i]) ? f.native[o.ins[i].pos + o.ins[i].op.target] : 0;
+	}
+	return true;
+}
+
+//------------------------------------------------------------------------------
+// the global an instruction stores to, -1 for none
+static int wr_optStoredGlobal( const WROptInstruction& I )
+{
+	switch( I.op.opcode )
+	{
+		case O_LiteralInt8ToGlobal:
+		case O_LiteralInt16ToGlobal:
+		case O_LiteralInt32ToGlobal:
+		case O_LiteralFloatToGlobal:
+		case O_AssignToGlobalAndPop:
+		case O_BinaryAdditionAndStoreGlobal:
+		case O_BinarySubtractionAndStoreGlobal:
+		case O_BinaryMultiplicationAndStoreGlobal:
+		case O_BinaryDivisionAndStoreGlobal:
+		case O_IncGlobal:
+		case O_DecGlobal:
+			return I.code[1];
+
+		default:
+			return -1;
+	}
+}
+
+//------------------------------------------------------------------------------
+// true for an instruction writing through a reference on the stack, a
+// call can write through any of its arguments
+static bool wr_optWritesThrough( const WROptInstruction& I )
+{
+	switch( I.op.opcode )
+	{
+		case O_AddAssignAndPop:
+		case O_SubtractAssignAndPop:
+		case O_MultiplyAssignAndPop:
+		case O_DivideAssignAndPop:
+		case O_ModAssignAndPop:
+		case O_LeftShiftAssignAndPop:
+		case O_RightShiftAssignAndPop:
+		case O_ANDAssignAndPop:
+		case O_ORAssignAndPop:
+		case O_XORAssignAndPop:
+		case O_AssignAndPop:
+		case O_CallLibFunction:
+		case O_CallLibFunctionAndPop: // and the calls to script functions
+			return true;
+
+		default:
+			return false;
+	}
+}
+
+//------------------------------------------------------------------------------
+// true for an instruction changing anything but the locals of its own
+// function that are not arguments
+static bool wr_optWritesOutside( const WROptInstruction& I, const int arguments )
+{
+	const int local = wr_optStoredLocal( I );
+	return wr_optStoredGlobal( I ) >= 0
+		   || wr_optWritesThrough( I )
+		   || (local >= 0 && local < arguments);
+}
+
+//------------------------------------------------------------------------------
+// every byte of an instruction naming a local
+static int wr_optLocals( const WROptInstruction& I, int* at )
+{
+	int n = wr_optLocalOperands( I, at );
+	if ( I.op.opcode == O_LoadFromLocal || wr_optStoredLocal(I) >= 0 )
+	{
+		at[n++] = 1;
+	}
+	return n;
+}
+
+//------------------------------------------------------------------------------
+// the code of a function that can be inlined, in c.ins for the caller to
+// free, false if it can not be
+static bool wr_optInlinable( WRUnitContext& callee, WROptimizer& c, WRJitFunction& f )
+{
+	WRBytecode& bytecode = callee.bytecode;
+	if ( bytecode.functionSpace.count()
+		 || bytecode.unitObjectSpace.count()
+		 || callee.exportNamespace
+		 || bytecode.all.size() > WRENCH_INLINE_BUDGET
+		 || !wr_optLoad(c, f, bytecode.all.p_str(), bytecode.all.size(), 0) )
 	{
-		bytecode.all[bytecode.all.size()-2] = O_IndexLocalLiteral8;
-		for( unsigned int i=1; i<addMe.all.size(); ++i )
-		{
-			bytecode.all += addMe.all[i];	
-		}
-		bytecode.opcodes.clear();
-		bytecode.opcodes += O_IndexLocalLiteral8;
-		return;
+		return false;
 	}
-	else if ( bytecode.all.size() > 1
-			  && bytecode.opcodes.size() > 0
-			  && addMe.opcodes.size() == 1
-			  && addMe.all.size() > 1
-			  && addMe.gotoSource.count() == 0
-			  && addMe.opcodes[0] == O_IndexLiteral8
-			  && bytecode.opcodes[bytecode.opcodes.size() - 1] == O_LoadFromGlobal )
+
+	for( int i=0; i<c.count; ++i )
 	{
-		bytecode.all[bytecode.all.size()-2] = O_IndexGlobalLiteral8;
-		for( unsigned int i=1; i<addMe.all.size(); ++i )
+		if ( wr_optWritesOutside(c.ins[i], callee.arguments) )
 		{
-			bytecode.all += addMe.all[i];	
+			wr_arenaFree( c.ins );
+			return false;
 		}
-		bytecode.opcodes.clear();
-		bytecode.opcodes += O_IndexGlobalLiteral8;
-		return;
 	}
-	else if ( bytecode.all.size() > 0
-			  && bytecode.opcodes.size() > 0
-			  && addMe.opcodes.size() == 2
-			  && addMe.gotoSource.count() == 0
-			  && addMe.all.size() == 3
-			  && addMe.opcodes[1] == O_Index )
+	c.markTargets();
+	return true;
+}
+
+//------------------------------------------------------------------------------
+// true when the code starts with a store to 'local' that does not read it,
+// what it was set to before is never seen
+static bool wr_optWrittenFirst( const WROptimizer& c, const int local )
+{
+	for( int i=0; i<c.count && !c.ins[i].isTarget; ++i )
 	{
-		if ( bytecode.opcodes[bytecode.opcodes.size() - 1] == O_LoadFromLocal
-			 && addMe.opcodes[0] == O_LoadFromLocal )
+		const WROptInstruction& I = c.ins[i];
+		if ( wr_optStoredLocal(I) == local && I.op.opcode != O_IncLocal && I.op.opcode != O_DecLocal )
 		{
-			int a = bytecode.all.size() - 1;
-
-			addMe.all[0] = bytecode.all[a];
-			bytecode.all[a] = addMe.all[1];
-			bytecode.all[a-1] = O_LLValues;
-			bytecode.all += addMe.all[0];
-			bytecode.all += O_IndexSkipLoad;
+			return true;
+		}
 
-			bytecode.opcodes += O_LoadFromLocal;
-			bytecode.opcodes += O_IndexSkipLoad;
-			return;
+		int at[3];
+		const int n = wr_optLocals( I, at );
+		for( int o=0; o<n; ++o )
+		{
+			if ( I.code[at[o]] == local )
+			{
+				return false;
+			}
 		}
-		else if ( bytecode.opcodes[bytecode.opcodes.size() - 1] == O_LoadFromGlobal
-				  && addMe.opcodes[0] == O_LoadFromGlobal )
+		if ( I.op.flow != WRJ_Next )
 		{
-			int a = bytecode.all.size() - 1;
+			return false;
+		}
+	}
+	return false;
+}
 
-			addMe.all[0] = bytecode.all[a];
-			bytecode.all[a] = addMe.all[1];
-			bytecode.all[a-1] = O_GGValues;
-			bytecode.all += addMe.all[0];
-			bytecode.all += O_IndexSkipLoad;
+//------------------------------------------------------------------------------
+static WROptInstruction& wr_optEmit( WROptInstruction* to, int& n, const unsigned char* code )
+{
+	WROptInstruction& I = to[n++];
+	wr_jitDecode( code, I.op );
+	memcpy( I.code, code, I.op.length );
+	I.pos = 0;
+	I.target = 0;
+	I.call = -1;
+	I.removed = false;
+	return I;
+}
 
-			bytecode.opcodes += O_LoadFromLocal;
-			bytecode.opcodes += O_IndexSkipLoad;
-			return;
+//------------------------------------------------------------------------------
+// the instruction that pushed what is at 'level' of the stack when the one
+// at 'i' runs, -1 when that is not in the straight code before it or the
+// stack was shuffled since
+static int wr_optPushedBy( const WROptimizer& o, const int i, const int level )
+{
+	for( int j=i - 1; j >= 0 && !o.ins[j + 1].isTarget && o.ins[j].op.flow == WRJ_Next; --j )
+	{
+		if ( o.ins[j].op.opcode == O_StackSwap || o.ins[j].op.opcode == O_SwapTwoToTop )
+		{
+			return -1;
 		}
-		else if ( bytecode.opcodes[bytecode.opcodes.size() - 1] == O_LoadFromLocal
-				  && addMe.opcodes[0] == O_LoadFromGlobal )
+
+		const int low = o.f->depth[o.ins[j].pos] - o.ins[j].op.pops;
+		if ( level >= low && level < low + o.ins[j].op.pushes )
 		{
-			int a = bytecode.all.size() - 1;
+			return j;
+		}
+	}
+	return -1;
+}
 
-			addMe.all[0] = bytecode.all[a];
-			bytecode.all[a] = addMe.all[1];
-			bytecode.all[a-1] = O_GLValues;
-			bytecode.all += addMe.all[0];
-			bytecode.all += O_IndexSkipLoad;
+//------------------------------------------------------------------------------
+// true when no argument pushed for the call at 'i' can be a reference to
+// an argument of the function making it, so those can be released before
+// the new ones are stored without going through other locals
+static bool wr_optPushesValues( const WROptimizer& o, const int i, const int arguments )
+{
+	const int top = o.f->depth[o.ins[i].pos];
+	for( int level=top - o.ins[i].op.pops; level<top; ++level )
+	{
+		const int j = wr_optPushedBy( o, i, level );
+		if ( j < 0 )
+		{
+			return false;
+		}
 
-			bytecode.opcodes += O_LoadFromLocal;
-			bytecode.opcodes += O_IndexSkipLoad;
-			return;
+		int at[3];
+		const int n = wr_optLocals( o.ins[j], at );
+		for( int l=0; l<n; ++l )
+		{
+			if ( o.ins[j].code[at[l]] < arguments )
+			{
+				return false;
+			}
 		}
-		else if ( bytecode.opcodes[bytecode.opcodes.size() - 1] == O_LoadFromGlobal
-				  && addMe.opcodes[0] == O_LoadFromLocal )
+	}
+	return true;
+}
+
+// locals a caller can grow by for the functions inlined into it
+#define WR_OPT_INLINE_LOCALS 16
+
+//------------------------------------------------------------------------------
+// WRENCH_INLINE_BUDGET: a call to a small function that changes nothing
+// but its own locals is replaced by a copy of its code working on locals
+// added to the caller. The arguments are copied in, every call site gets
+// locals of its own so a reference to one that is returned stays valid
+// until it is used.
+// A function calling itself right before it returns jumps back to its
+// start instead, when it changes nothing but its own locals either. The
+// arguments are references to the caller's values, they are released
+// before the new ones are stored
+bool WRCompilationContext::inlineCalls( WRUnitContext& unit, WROptimizer& o )
+{
+	WRBytecode& bytecode = unit.bytecode;
+	const int arguments = unit.arguments;
+	const int locals = bytecode.localSpace.count();
+	int room = 254 - arguments - locals; // frameBaseAdjustment is 8 bits
+	room = room < WR_OPT_INLINE_LOCALS ? room : WR_OPT_INLINE_LOCALS;
+
+	// the unit to inline, -1 to jump back, -2 to jump back storing the
+	// arguments straight away or 0 for a call that stays
+	int* plan = (int*)wr_arenaMalloc( o.count * 2 * sizeof(int) );
+	int* moved = plan + o.count; // where each instruction went
+	int extra = 0; // instructions added, at most
+	int added = 0; // locals
+	bool tail = !unit.exportNamespace;
+	o.markTargets();
+	for( int i=0; i<o.count; ++i )
+	{
+		plan[i] = 0;
+		const WROptInstruction& I = o.ins[i];
+		if ( I.call < 0 )
+		{
+			tail = tail && !wr_optWritesOutside( I, arguments );
+			continue;
+		}
+
+		const uint32_t hash = bytecode.functionSpace[I.call].hash;
+		if ( hash == unit.hash )
 		{
-			int a = bytecode.all.size() - 1;
+			if ( I.op.pushes
+				 && i + 1 < o.count
+				 && o.ins[i + 1].op.opcode == O_Return
+				 && o.f->depth[I.pos] == I.op.pops )
+			{
+				plan[i] = wr_optPushesValues(o, i, arguments) ? -2 : -1;
+				extra += I.op.pops + 3 * arguments + locals + 1;
+			}
+			continue;
+		}
 
-			addMe.all[0] = bytecode.all[a];
-			bytecode.all[a] = addMe.all[1];
-			bytecode.all[a-1] = O_LGValues;
-			bytecode.all += addMe.all[0];
-			bytecode.all += O_IndexSkipLoad;
+		unsigned int u = 1;
+		for( ; u<m_units.count() && m_units[u].hash != hash; ++u );
 
-			bytecode.opcodes += O_LoadFromLocal;
-			bytecode.opcodes += O_IndexSkipLoad;
-			return;
+		WROptimizer c;
+		WRJitFunction f;
+		if ( u < m_units.count() && wr_optInlinable(m_units[u], c, f) )
+		{
+			const int slots = m_units[u].bytecode.localSpace.count();
+			if ( added + slots <= room )
+			{
+				plan[i] = u;
+				added += slots;
+				extra += I.op.pops + slots + 2 * c.count + 1;
+			}
+			wr_arenaFree( c.ins );
 		}
+
+		tail = tail && plan[i];
 	}
-	else if ( addMe.all.size() == 1 )
+
+	// otherwise the new arguments are stored aside until the old ones are
+	// released
+	const int temps = locals + added;
+	bool aside = false;
+	bool changed = false;
+	for( int i=0; i<o.count; ++i )
 	{
-		if ( addMe.opcodes[0] == O_HASH_PLACEHOLDER )
+		if ( plan[i] < 0 && !tail )
 		{
-			if ( bytecode.opcodes.size() > 1
-				 && bytecode.opcodes[ bytecode.opcodes.size() - 2 ] == O_LiteralInt32
-				 && bytecode.opcodes[ bytecode.opcodes.size() - 1 ] == O_LoadFromLocal )
+			plan[i] = 0;
+		}
+		else if ( plan[i] == -1 )
+		{
+			if ( added + arguments <= room )
 			{
-				int o = bytecode.all.size() - 7;
-
-				bytecode.all[o] = O_LocalIndexHash;
-				bytecode.all[o + 5] = bytecode.all[o + 4];
-				bytecode.all[o + 4] = bytecode.all[o + 3];
-				bytecode.all[o + 3] = bytecode.all[o + 2];
-				bytecode.all[o + 2] = bytecode.all[o + 1];
-				bytecode.all[o + 1] = bytecode.all[o + 6];
-
-				bytecode.opcodes.clear();
-				bytecode.all.shave(1);
+				aside = true;
 			}
-			else if (bytecode.opcodes.size() > 1
-					 && bytecode.opcodes[ bytecode.opcodes.size() - 2 ] == O_LiteralInt32
-					 && bytecode.opcodes[ bytecode.opcodes.size() - 1 ] == O_LoadFromGlobal )
+			else
 			{
-				int o = bytecode.all.size() - 7;
+				plan[i] = 0;
+			}
+		}
+		changed |= plan[i] != 0;
+	}
+	if ( !changed )
+	{
+		wr_arenaFree( plan );
+		return false;
+	}
+	for( int t=0; t<arguments && aside; ++t )
+	{
+		bytecode.localSpace.append();
+	}
 
-				bytecode.all[o] = O_GlobalIndexHash;
-				bytecode.all[o + 5] = bytecode.all[o + 4];
-				bytecode.all[o + 4] = bytecode.all[o + 3];
-				bytecode.all[o + 3] = bytecode.all[o + 2];
-				bytecode.all[o + 2] = bytecode.all[o + 1];
-				bytecode.all[o + 1] = bytecode.all[o + 6];
+	WROptInstruction* to = (WROptInstruction*)wr_arenaMalloc( (o.count + extra) * sizeof(WROptInstruction) );
+	int n = 0;
+	for( int i=0; i<o.count; ++i )
+	{
+		const WROptInstruction& I = o.ins[i];
+		moved[i] = n;
 
-				bytecode.opcodes.clear();
-				bytecode.all.shave(1);
+		if ( !plan[i] )
+		{
+			to[n] = I;
+			if ( WROptimizer::isJump(I) )
+			{
+				to[n].target = -1 - I.target; // once everything has moved
 			}
-			else if (bytecode.opcodes.size() > 1
-					 && bytecode.opcodes[ bytecode.opcodes.size() - 2 ] == O_LiteralInt32
-					 && bytecode.opcodes[ bytecode.opcodes.size() - 1 ] == O_StackSwap )
+			++n;
+		}
+		else if ( plan[i] < 0 )
+		{
+			int args = I.op.pops;
+			for( ; args > arguments; --args )
 			{
-				int a = bytecode.all.size() - 7;
+				static const unsigned char pop = O_PopOne;
+				wr_optEmit( to, n, &pop );
+			}
+			const int first = plan[i] == -1 ? temps : 0;
+			for( int a=0; a<arguments && !first; ++a )
+			{
+				const unsigned char release[3] = { O_LiteralInt8ToLocal, (unsigned char)a, 0 };
+				wr_optEmit( to, n, release );
+			}
+			for( int a=args - 1; a>=0; --a )
+			{
+				const unsigned char store[2] = { O_AssignToLocalAndPop, (unsigned char)(first + a) };
+				wr_optEmit( to, n, store );
+			}
+			for( int a=0; a<arguments && first; ++a )
+			{
+				const unsigned char release[3] = { O_LiteralInt8ToLocal, (unsigned char)a, 0 };
+				wr_optEmit( to, n, release );
+			}
+			for( int a=0; a<args && first; ++a )
+			{
+				const unsigned char load[2] = { O_LoadFromLocal, (unsigned char)(temps + a) };
+				const unsigned char store[2] = { O_AssignToLocalAndPop, (unsigned char)a };
+				wr_optEmit( to, n, load );
+				wr_optEmit( to, n, store );
+			}
+			for( int l=arguments; l<locals; ++l )
+			{
+				const unsigned char zero[3] = { O_LiteralInt8ToLocal, (unsigned char)l, 0 };
+				wr_optEmit( to, n, zero );
+			}
+			static const unsigned char jump[3] = { O_RelativeJump, 0, 0 };
+			wr_optEmit( to, n, jump ).target = 0;
+		}
+		else
+		{
+			WRUnitContext& callee = m_units[plan[i]];
+			WROptimizer c;
+			WRJitFunction f;
+			wr_optInlinable( callee, c, f );
 
-				bytecode.all[a] = O_StackIndexHash;
+			const int base = bytecode.localSpace.count();
+			const int slots = callee.bytecode.localSpace.count();
+			for( int s=0; s<slots; ++s )
+			{
+				bytecode.localSpace.append();
+			}
 
-				bytecode.opcodes.clear();
-				bytecode.all.shave(2);
+			int args = I.op.pops;
+			for( ; args > (int)callee.arguments; --args )
+			{
+				static const unsigned char pop = O_PopOne;
+				wr_optEmit( to, n, &pop );
+			}
+			for( int a=args - 1; a>=0; --a )
+			{
+				const unsigned char store[2] = { O_AssignToLocalAndPop, (unsigned char)(base + a) };
+				wr_optEmit( to, n, store );
+			}
+			for( int l=args; l<slots; ++l )
+			{
+				if ( l < (int)callee.arguments || !wr_optWrittenFirst(c, l) )
+				{
+					const unsigned char zero[3] = { O_LiteralInt8ToLocal, (unsigned char)(base + l), 0 };
+					wr_optEmit( to, n, zero );
+				}
+			}
 
+			// returning pushes zero first if it has to and jumps past the code
+			int at = n;
+			for( int k=0; k<c.count; ++k )
+			{
+				c.ins[k].at = at;
+				at += c.ins[k].op.opcode == O_ReturnZero ? 2 : 1;
 			}
-			else
+			for( int k=0; k<c.count; ++k )
 			{
-				m_err = WR_ERR_compiler_panic;
+				WROptInstruction& J = c.ins[k];
+				if ( J.op.opcode == O_Return || J.op.opcode == O_ReturnZero )
+				{
+					if ( J.op.opcode == O_ReturnZero )
+					{
+						static const unsigned char zero = O_LiteralZero;
+						wr_optEmit( to, n, &zero );
+					}
+					static const unsigned char jump[3] = { O_RelativeJump, 0, 0 };
+					wr_optEmit( to, n, jump ).target = at;
+					continue;
+				}
+
+				int operands[3];
+				const int m = wr_optLocals( J, operands );
+				for( int l=0; l<m; ++l )
+				{
+					J.code[operands[l]] += (unsigned char)base;
+				}
+				if ( WROptimizer::isJump(J) )
+				{
+					J.target = c.ins[J.target].at;
+				}
+				to[n++] = J;
 			}
 
-			return;
+			if ( !I.op.pushes )
+			{
+				static const unsigned char pop = O_PopOne;
+				wr_optEmit( to, n, &pop );
+			}
+			wr_arenaFree( c.ins );
 		}
-
-		pushOpcode( bytecode, (WROpcode)addMe.opcodes[0] );
-		return;
 	}
 
-	resolveRelativeJumps( addMe );
+	for( int i=0; i<n; ++i )
+	{
+		if ( WROptimizer::isJump(to[i]) && to[i].target < 0 )
+		{
+			to[i].target = moved[-1 - to[i].target];
+		}
+	}
 
-	bytecode.all += addMe.all;
-	bytecode.opcodes += addMe.opcodes;
+	wr_arenaFree( plan );
+	wr_arenaFree( o.ins );
+	o.ins = to;
+	o.count = n;
+	return true;
 }
 
+// a loop with no more trips than this is unrolled all the way
+#define WR_OPT_UNROLL_TRIPS 8
 
-#endif
-/*******************************************************************************
-Copyright (c) 2024 Curt Hartung -- curt.hartung@gmail.com
-
-MIT Licence
+// locals a function can grow by for what is hoisted out of its loops
+#define WR_OPT_HOIST_LOCALS 8
 
-Permission is hereby granted, free of charge, to any person obtaining a copy
-of this software and associated documentation files (the "Software"), to deal
-in the Software without restriction, including without limitation the rights
-to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
-copies of the Software, and to permit persons to whom the Software is
-furnished to do so, subject to the following conditions:
+//------------------------------------------------------------------------------
+// what the instructions from 'from' to 'to' can change, a loop from the
+// instruction a jump goes back to up to that jump
+struct WROptLoop
+{
+	bool calls; // any global can change, and so can an argument
+	bool unknown; // something is written through that could be any local
+	bool local[256];
+	bool global[256];
 
-The above copyright notice and this permission notice shall be included in all
-copies or substantial portions of the Software.
+	void scan( const WROptimizer& o, const int from, const int to );
+	bool invariant( const WROptimizer& o, const WROptInstruction& I ) const;
+};
 
-THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
-IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
-FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
-AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
-LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
-OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
-SOFTWARE.
-*******************************************************************************/
+//------------------------------------------------------------------------------
+void WROptLoop::scan( const WROptimizer& o, const int from, const int to )
+{
+	calls = false;
+	unknown = false;
+	memset( local, 0, sizeof(local) );
+	memset( global, 0, sizeof(global) );
 
-#include "wrench.h"
-#ifndef WRENCH_WITHOUT_COMPILER
+	for( int i=from; i<=to; ++i )
+	{
+		const WROptInstruction& I = o.ins[i];
+		const int l = wr_optStoredLocal( I );
+		if ( l >= 0 )
+		{
+			local[l] = true;
+			calls |= l < o.arguments; // written through to the caller's value
+		}
+		const int g = wr_optStoredGlobal( I );
+		if ( g >= 0 )
+		{
+			global[g] = true;
+		}
+		if ( !wr_optWritesThrough(I) )
+		{
+			continue;
+		}
+
+		// a call can change what its arguments reference, an assignment
+		// what is on top, the value assigned is under it
+		const int top = o.f->depth[I.pos];
+		const bool call = I.op.opcode == O_CallLibFunction || I.op.opcode == O_CallLibFunctionAndPop;
+		calls |= call;
+		for( int level=(call ? top - I.op.pops : top - 1); level < top; ++level )
+		{
+			const int j = wr_optPushedBy( o, i, level );
+			if ( j < 0 )
+			{
+				unknown = true;
+				calls = true;
+			}
+			else if ( o.ins[j].op.opcode == O_LoadFromLocal )
+			{
+				local[o.ins[j].code[1]] = true;
+				calls |= o.ins[j].code[1] < o.arguments;
+			}
+			else if ( o.ins[j].op.opcode == O_LoadFromGlobal )
+			{
+				global[o.ins[j].code[1]] = true;
+			}
+		}
+	}
+}
 
 //------------------------------------------------------------------------------
-int wr_strnlen( const char* s, int len )
+// true when what the instruction reads is the same every trip
+bool WROptLoop::invariant( const WROptimizer& o, const WROptInstruction& I ) const
 {
-	const char* found = (const char *)memchr( s, '\0', len );
-	return found ? (found - s) : len;
+	WRValue value;
+	int at[3];
+	bool locals[2] = { true, true };
+	int n = 0;
+	switch( I.op.opcode )
+	{
+		case O_LoadFromLocal: at[n++] = 1; break;
+		case O_LoadFromGlobal: at[n++] = 1; locals[0] = false; break;
+
+		case O_GGBinaryAddition:
+		case O_GLBinaryAddition:
+		case O_LLBinaryAddition:
+		case O_GGBinarySubtraction:
+		case O_GLBinarySubtraction:
+		case O_LGBinarySubtraction:
+		case O_LLBinarySubtraction:
+		case O_GGBinaryMultiplication:
+		case O_GLBinaryMultiplication:
+		case O_LLBinaryMultiplication:
+			wr_jitBinarySpaces( I.op.opcode, locals[1], locals[0] );
+			at[n++] = 1;
+			at[n++] = 2;
+			break;
+
+		default:
+			return false;
+	}
+
+	for( int k=0; k<n; ++k )
+	{
+		const int index = I.code[at[k]];
+		if ( locals[k] ? (unknown || local[index] || (index < o.arguments && calls))
+					   : (calls || global[index]) )
+		{
+			return false;
+		}
+	}
+	return true;
 }
 
 //------------------------------------------------------------------------------
-bool WRCompilationContext::getToken( WRExpressionContext& ex, const char* expect )
+// trips of a loop counting a local up by one from a literal to a literal,
+// "for( i = a; i < n; ++i )" as it is compiled, 0 when it is not one
+static int wr_optTrips( const WROptimizer& o, const int h, const int b, int& counter )
 {
-	WRValue& value = ex.value;
-	WRstr& token = ex.token;
-	
-	if ( m_loadedToken.size() || (m_loadedValue.type != WR_REF) )
+	WRValue n;
+	if ( b - h < 4 || !o.literal(h, n) || n.type != WR_INT )
 	{
-		token = m_loadedToken;
-		value = m_loadedValue;
-		m_quoted = m_loadedQuoted;
+		return 0;
+	}
+
+	const WROptInstruction& C = o.ins[h + 1];
+	const WROptInstruction& P = o.ins[b - 1];
+	if ( C.op.flow != WRJ_Branch
+		 || C.op.form != WRJ_LocalStack
+		 || C.target != b + 1
+		 || P.op.opcode != O_IncLocal
+		 || P.code[1] != C.code[1] )
+	{
+		return 0;
+	}
+	counter = C.code[1];
+
+	// branches out when "i < n" is false or "i <= n" is, and does not trip
+	// over the range of an int
+	int last;
+	if ( C.op.compare == WRJ_LT && !C.op.when )
+	{
+		last = n.i - 1;
+	}
+	else if ( C.op.compare == WRJ_GT && C.op.when )
+	{
+		last = n.i;
 	}
 	else
 	{
-		m_quoted = false;
-		value.p2 = INIT_AS_REF;
+		return 0;
+	}
 
-		ex.spaceBefore = (m_pos < m_sourceLen) && isspace(m_source[m_pos]);
-	
-		do
+	// and is set to an int right before
+	for( int j=h - 1; j >= 0 && (j + 1 == h || !o.ins[j + 1].isTarget) && o.ins[j].op.flow == WRJ_Next; --j )
+	{
+		const WROptInstruction& S = o.ins[j];
+		if ( wr_optWritesThrough(S) )
 		{
-			if ( m_pos >= m_sourceLen )
-			{
-				m_EOF = true;
-				return false;
-			}
-			
-		} while( isspace(m_source[m_pos++]) );
-
-		token = m_source[m_pos - 1];
+			return 0;
+		}
+		if ( wr_optStoredLocal(S) != counter )
+		{
+			continue;
+		}
 
-		unsigned int t=0;
-		for( ; c_operations[t].token && strncmp( c_operations[t].token, "@macroBegin", 11); ++t );
+		int first;
+		switch( S.op.opcode )
+		{
+			case O_LiteralInt8ToLocal: first = (int8_t)READ_8_FROM_PC(S.code + 2); break;
+			case O_LiteralInt16ToLocal: first = READ_16_FROM_PC(S.code + 2); break;
+			case O_LiteralInt32ToLocal: first = READ_32_FROM_PC(S.code + 2); break;
+			default: return 0;
+		}
+		return (last > first && last - first < 0x7FFF) ? last - first + 1 : 0;
+	}
+	return 0;
+}
 
-		int offset = m_pos - 1;
+//------------------------------------------------------------------------------
+// the instructions computing what the one at 'k' pushes start at 'from'
+// when all of them read what does not change in the loop and do nothing
+// else, and it is a number, not a string or an array a reference to would
+// be shared between the trips. false when they do not
+static bool wr_optHoistable( const WROptimizer& o, const WROptLoop& L, const int h, const int k, int& from )
+{
+	// what is pushed is a number when it is known at all
+	bool number[16];
+	int top = 0;
+	int need = 0;
+	for( from = k; ; --from )
+	{
+		if ( from < h || (from < k && o.ins[from + 1].isTarget) )
+		{
+			return false;
+		}
 
-		for( ; c_operations[t].token; ++t )
+		const WROptInstruction& I = o.ins[from];
+		WRValue value;
+		if ( o.literal(from, value) || L.invariant(o, I) )
 		{
-			int len = wr_strnlen( c_operations[t].token, 20 );
-			if ( ((offset + len) < m_sourceLen)
-				 && !strncmp(m_source + offset, c_operations[t].token, len) )
-			{
-				if ( isalnum(m_source[offset+len]) )
-				{
-					continue;
-				}
-				
-				m_pos += len - 1;
-				token = c_operations[t].token;
-				goto foundMacroToken;
-			}
+		}
+		else if ( I.op.opcode == O_BinaryAddition
+				  || I.op.opcode == O_BinarySubtraction
+				  || I.op.opcode == O_BinaryMultiplication
+				  || I.op.opcode == O_BinaryLeftShift
+				  || I.op.opcode == O_BinaryRightShift
+				  || I.op.opcode == O_BinaryAnd
+				  || I.op.opcode == O_BinaryOr
+				  || I.op.opcode == O_BinaryXOR
+				  || I.op.opcode == O_ToInt
+				  || I.op.opcode == O_ToFloat )
+		{
+		}
+		else
+		{
+			return false;
 		}
 
-		for( t = 0; t<m_units[0].constantValues.count(); ++t )
+		need += I.op.pops - I.op.pushes;
+		if ( need < 0 )
 		{
-			int len = m_units[0].constantValues[t].label.size();
-			if ( ((offset + len) < m_sourceLen)
-				 && !strncmp(m_source + offset, m_units[0].constantValues[t].label.c_str(), len) )
-			{
-				if ( isalnum(m_source[offset+len]) )
-				{
-					continue;
-				}
+			break;
+		}
+	}
+	if ( need != -1 || from == k )
+	{
+		return false;
+	}
 
-				m_pos += len - 1;
-				token.clear();
-				value = m_units[0].constantValues[t].value;
-				goto foundMacroToken;
-			}
+	for( int i=from; i<=k; ++i )
+	{
+		const WROptInstruction& I = o.ins[i];
+		WRValue value;
+		bool result = o.literal( i, value );
+		if ( I.op.pops == 2 )
+		{
+			top -= 2;
+			result = I.op.math != WRJ_Add || (number[top] && number[top + 1]);
+		}
+		else if ( I.op.pops == 1 )
+		{
+			--top;
+			result = true;
+		}
+		else if ( I.op.opcode != O_LoadFromLocal && I.op.opcode != O_LoadFromGlobal )
+		{
+			result = I.op.math != WRJ_Add; // <T><S>Binary*
+		}
+		if ( top >= 16 )
+		{
+			return false;
 		}
+		number[top++] = result;
+	}
+	if ( !number[0] )
+	{
+		return false;
+	}
 
-		for( t = 0; t<m_units[m_unitTop].constantValues.count(); ++t )
+	// and it is used by something that only reads it, it becomes a
+	// reference to the local it is kept in
+	const int level = o.f->depth[o.ins[k].pos] - o.ins[k].op.pops;
+	for( int j=k + 1; j < o.count && !o.ins[j].isTarget; ++j )
+	{
+		const WROptInstruction& J = o.ins[j];
+		if ( J.op.opcode == O_StackSwap || J.op.opcode == O_SwapTwoToTop )
 		{
-			int len = m_units[m_unitTop].constantValues[t].label.size();
-			if ( ((offset + len) < m_sourceLen)
-				 && !strncmp(m_source + offset, m_units[m_unitTop].constantValues[t].label.c_str(), len) )
-			{
-				if ( isalnum(m_source[offset+len]) )
-				{
-					continue;
-				}
+			return false;
+		}
+		if ( o.f->depth[J.pos] - J.op.pops <= level )
+		{
+			return !wr_optWritesThrough(J) && J.op.flow != WRJ_Return;
+		}
+		if ( J.op.flow != WRJ_Next )
+		{
+			return false;
+		}
+	}
+	return false;
+}
 
-				m_pos += len - 1;
-				token.clear();
-				value = m_units[m_unitTop].constantValues[t].value;
-				goto foundMacroToken;
-			}
+//------------------------------------------------------------------------------
+// WRENCH_UNROLL_BUDGET: one loop of the function is reshaped, the first
+// from the top that can be. What it computes the same on every trip is
+// computed once before it into locals of its own, or when there is
+// nothing like that and it counts from a literal to a literal, its code
+// is repeated: all the way through for a few trips, otherwise two or
+// four times between the compares. Each copy is followed by the
+// increment so "continue" has somewhere to go and the counter is what it
+// was at every point. false when no loop changed
+bool WRCompilationContext::reshapeLoop( WRUnitContext& unit, WROptimizer& o )
+{
+	if ( o.exported )
+	{
+		return false;
+	}
+
+	WRBytecode& bytecode = unit.bytecode;
+	const int locals = bytecode.localSpace.count();
+	int room = 254 - o.arguments - locals; // frameBaseAdjustment is 8 bits
+	room = room < WR_OPT_HOIST_LOCALS ? room : WR_OPT_HOIST_LOCALS;
+	room = room > 0 ? room : 0;
+
+	o.markTargets();
+	WROptLoop L;
+	for( int b=0; b<o.count; ++b )
+	{
+		const int h = o.ins[b].target;
+		if ( o.ins[b].op.flow != WRJ_Jump || h > b )
+		{
+			continue;
 		}
 
-		if ( token[0] == '-' )
+		// nothing else comes into the loop but from the top
+		bool entered = false;
+		bool alone = true;
+		for( int i=0; i<o.count && alone; ++i )
 		{
-			if ( m_pos < m_sourceLen )
+			if ( (i < h || i > b) && WROptimizer::isJump(o.ins[i]) )
 			{
-				if ( (isdigit(m_source[m_pos]) && !m_LastParsedLabel) || m_source[m_pos] == '.' )
-				{
-					goto parseAsNumber;
-				}
-				else if ( m_source[m_pos] == '-' )
-				{
-					token += '-';
-					++m_pos;
-				}
-				else if ( m_source[m_pos] == '=' )
-				{
-					token += '=';
-					++m_pos;
-				}
+				entered |= o.ins[i].target == h;
+				alone = o.ins[i].target <= h || o.ins[i].target > b;
 			}
 		}
-		else
+		if ( !alone )
 		{
-			m_LastParsedLabel = false;
-		
-			if ( token[0] == '=' )
+			continue;
+		}
+
+		L.scan( o, h, b );
+		int picked = 0;
+		int* pick = (int*)wr_arenaMalloc( 2 * (room + 1) * sizeof(int) );
+		for( int k=h; k<=b; ++k )
+		{
+			int from;
+			if ( !wr_optHoistable(o, L, h, k, from) )
 			{
-				if ( (m_pos < m_sourceLen) && m_source[m_pos] == '=' )
-				{
-					token += '=';
-					++m_pos;
-				}
+				continue;
 			}
-			else if ( token[0] == '!' )
+
+			// it can have what was picked before in it
+			while( picked && pick[2*(picked - 1)] >= from )
 			{
-				if ( (m_pos < m_sourceLen) && m_source[m_pos] == '=' )
-				{
-					token += '=';
-					++m_pos;
-				}
+				--picked;
 			}
-			else if ( token[0] == '*' )
+			if ( picked < room )
 			{
-				if ( (m_pos < m_sourceLen) && m_source[m_pos] == '=' )
-				{
-					token += '=';
-					++m_pos;
-				}
+				pick[2*picked] = from;
+				pick[2*picked + 1] = k;
+				++picked;
 			}
-			else if ( token[0] == '%' )
+		}
+
+		int counter = 0;
+		const int trips = picked ? 0 : wr_optTrips( o, h, b, counter );
+		int copies = 0;
+		if ( trips && !entered && counter >= o.arguments )
+		{
+			L.scan( o, h + 2, b - 2 );
+			int size = o.ins[b - 1].op.length;
+			bool straight = !L.unknown && !L.local[counter];
+			for( int i=h + 2; i<b - 1 && straight; ++i )
 			{
-				if ( (m_pos < m_sourceLen) && m_source[m_pos] == '=' )
-				{
-					token += '=';
-					++m_pos;
-				}
+				size += o.ins[i].op.length;
+				straight = !WROptimizer::isJump(o.ins[i])
+						   || ((o.ins[i].target < h || o.ins[i].target > h + 1) && o.ins[i].target != b);
 			}
-			else if ( token[0] == '<' )
-			{
-				if ( (m_pos < m_sourceLen) && m_source[m_pos] == '=' )
-				{
-					token += '=';
-					++m_pos;
-				}
-				else if ( (m_pos < m_sourceLen) && m_source[m_pos] == '<' )
-				{
-					token += '<';
-					++m_pos;
 
-					if ( (m_pos < m_sourceLen) && m_source[m_pos] == '=' )
-					{
-						token += '=';
-						++m_pos;
-					}
-				}
-			}
-			else if ( token[0] == '>' )
+			if ( !straight )
 			{
-				if ( (m_pos < m_sourceLen) && m_source[m_pos] == '=' )
-				{
-					token += '=';
-					++m_pos;
-				}
-				else if ( (m_pos < m_sourceLen) && m_source[m_pos] == '>' )
-				{
-					token += '>';
-					++m_pos;
-
-					if ( (m_pos < m_sourceLen) && m_source[m_pos] == '=' )
-					{
-						token += '=';
-						++m_pos;
-					}
-				}
 			}
-			else if ( token[0] == '&' )
+			else if ( trips <= WR_OPT_UNROLL_TRIPS && (trips - 1) * size <= WRENCH_UNROLL_BUDGET )
 			{
-				if ( (m_pos < m_sourceLen) && m_source[m_pos] == '&' )
-				{
-					token += '&';
-					++m_pos;
-				}
-				else if ( (m_pos < m_sourceLen) && m_source[m_pos] == '=' )
-				{
-					token += '=';
-					++m_pos;
-				}
+				copies = -trips;
 			}
-			else if ( token[0] == '^' )
+			else if ( !(trips & 3) && 3 * size <= WRENCH_UNROLL_BUDGET )
 			{
-				if ( (m_pos < m_sourceLen) && m_source[m_pos] == '=' )
-				{
-					token += '=';
-					++m_pos;
-				}
+				copies = 4;
 			}
-			else if ( token[0] == '|' )
+			else if ( !(trips & 1) && size <= WRENCH_UNROLL_BUDGET )
 			{
-				if ( (m_pos < m_sourceLen) && m_source[m_pos] == '|' )
-				{
-					token += '|';
-					++m_pos;
-				}
-				else if ( (m_pos < m_sourceLen) && m_source[m_pos] == '=' )
-				{
-					token += '=';
-					++m_pos;
-				}
+				copies = 2;
 			}
-			else if ( token[0] == '+' )
+		}
+
+		if ( !picked && !copies )
+		{
+			wr_arenaFree( pick );
+			continue;
+		}
+
+		// jumps to what moved are pointed at it once it has, 'o.count'
+		// stands for the code computed before the loop
+		int extra = 2 * (b - h + 1) * (copies < 0 ? -copies : copies) + picked;
+		for( int p=0; p<picked; ++p )
+		{
+			extra += pick[2*p + 1] - pick[2*p] + 1;
+		}
+		WROptInstruction* to = (WROptInstruction*)wr_arenaMalloc( (o.count + extra) * sizeof(WROptInstruction) );
+		int* moved = (int*)wr_arenaMalloc( (o.count + 1) * sizeof(int) );
+		int n = 0;
+		int p = 0;
+		for( int i=0; i<o.count; ++i )
+		{
+			const WROptInstruction& I = o.ins[i];
+			if ( i == h && picked )
 			{
-				if ( m_pos < m_sourceLen )
+				moved[o.count] = n;
+				for( int q=0; q<picked; ++q )
 				{
-					if ( m_source[m_pos] == '+' )
+					for( int j=pick[2*q]; j<=pick[2*q + 1]; ++j )
 					{
-						token += '+';
-						++m_pos;
-					}
-					else if ( m_source[m_pos] == '=' )
-					{
-						token += '=';
-						++m_pos;
+						to[n++] = o.ins[j];
 					}
+					const unsigned char store[2] = { O_AssignToLocalAndPop, (unsigned char)(locals + q) };
+					wr_optEmit( to, n, store );
+					bytecode.localSpace.append();
 				}
 			}
-			else if ( token[0] == '\"' || token[0] == '\'' )
+			moved[i] = n;
+
+			if ( p < picked && i == pick[2*p] )
 			{
-				bool single = token[0] == '\'';
-				token.clear();
-				m_quoted = true;
-				
-				do
+				const unsigned char load[2] = { O_LoadFromLocal, (unsigned char)(locals + p) };
+				wr_optEmit( to, n, load );
+				for( ; i<pick[2*p + 1]; ++i )
 				{
-					if (m_pos >= m_sourceLen)
-					{
-						m_err = WR_ERR_unterminated_string_literal;
-						m_EOF = true;
-						return false;
-					}
+					moved[i + 1] = moved[i];
+				}
+				++p;
+				continue;
+			}
 
-					char c = m_source[m_pos];
-					if (c == '\"' && !single ) // terminating character
-					{
-						if ( single )
-						{
-							m_err = WR_ERR_bad_expression;
-							return false;
-						}
-						++m_pos;
-						break;
-					}
-					else if ( c == '\'' && single )
-					{
-						if ( !single || (token.size() > 1) )
-						{
-							m_err = WR_ERR_bad_expression;
-							return false;
-						}
-						++m_pos;
-						break;
-					}
-					else if (c == '\n')
-					{
-						m_err = WR_ERR_newline_in_string_literal;
-						return false;
-					}
-					else if (c == '\\')
+			if ( i == h && copies )
+			{
+				// the compare stays when there are trips it can end, each
+				// copy leaves the counter as the trip it stands for did
+				if ( copies > 0 )
+				{
+					to[n] = o.ins[h];
+					to[n + 1] = o.ins[h + 1];
+					to[n + 1].target = -1 - (b + 1);
+					n += 2;
+				}
+				for( int c=0; c<(copies < 0 ? -copies : copies); ++c )
+				{
+					const int first = n;
+					for( int j=h + 2; j<b - 1; ++j )
 					{
-						c = m_source[++m_pos];
-						if (m_pos >= m_sourceLen)
-						{
-							m_err = WR_ERR_unterminated_string_literal;
-							m_EOF = true;
-							return false;
-						}
-
-						if (c == '\\') // escaped slash
-						{
-							token += '\\';
-						}
-						else if (c == '0')
-						{
-							token += atoi(m_source + m_pos);
-							for (; (m_pos < m_sourceLen) && isdigit(m_source[m_pos]); ++m_pos);
-							--m_pos;
-						}
-						else if (c == '\"')
-						{
-							token += '\"';
-						}
-						else if (c == '\'')
-						{
-							token += '\'';
-						}
-						else if (c == 'n')
-						{
-							token += '\n';
-						}
-						else if (c == 'r')
-						{
-							token += '\r';
-						}
-						else if (c == 't')
-						{
-							token += '\t';
-						}
-						else
+						to[n] = o.ins[j];
+						if ( WROptimizer::isJump(o.ins[j]) )
 						{
-							m_err = WR_ERR_bad_string_escape_sequence;
-							return false;
+							const int t = o.ins[j].target;
+							to[n].target = (t >= h + 2 && t <= b - 1) ? first + t - (h + 2) : -1 - t;
 						}
+						++n;
 					}
-					else
-					{
-						token += c;
-					}
-
-				} while( ++m_pos < m_sourceLen );
-
-				value.p2 = INIT_AS_INT;
-				if ( single )
+					const unsigned char inc[2] = { O_IncLocal, (unsigned char)counter };
+					wr_optEmit( to, n, inc );
+				}
+				if ( copies > 0 )
 				{
-					value.ui = token.size() == 1 ? token[0] : 0;
-					token.clear();
+					to[n] = o.ins[b];
+					to[n++].target = moved[h];
 				}
-				else
+
+				for( ; i<b; ++i )
 				{
-					value.p2 = INIT_AS_INT;
-					value.type = (WRValueType)WR_COMPILER_LITERAL_STRING;
-					value.p = &token;
+					moved[i + 1] = moved[h];
 				}
+				continue;
 			}
-			else if ( token[0] == '/' ) // might be a comment
+
+			to[n] = I;
+			if ( WROptimizer::isJump(I) )
 			{
-				if ( m_pos < m_sourceLen )
-				{	
-					if ( !isspace(m_source[m_pos]) )
-					{
-						if ( m_source[m_pos] == '/' )
-						{
-							for( ; m_pos<m_sourceLen && m_source[m_pos] != '\n'; ++m_pos ); // clear to end EOL
+				to[n].target = (picked && I.target == h && (i < h || i > b)) ? -1 - o.count : -1 - I.target;
+			}
+			++n;
+		}
 
-							return getToken( ex, expect );
-						}
-						else if ( m_source[m_pos] == '*' )
-						{
-							for( ; (m_pos+1)<m_sourceLen
-								 && !(m_source[m_pos] == '*' && m_source[m_pos+1] == '/');
-								 ++m_pos ); // find end of comment
+		for( int i=0; i<n; ++i )
+		{
+			if ( WROptimizer::isJump(to[i]) && to[i].target < 0 )
+			{
+				to[i].target = moved[-1 - to[i].target];
+			}
+		}
 
-							m_pos += 2;
+		wr_arenaFree( pick );
+		wr_arenaFree( moved );
+		wr_arenaFree( o.ins );
+		o.ins = to;
+		o.count = n;
+		return true;
+	}
 
-							return getToken( ex, expect );
+	return false;
+}
 
-						}
-						else if ( m_source[m_pos] == '=' )
-						{
-							token += '=';
-							++m_pos;
-						}
-					}					
-					//else // bare '/' 
-				}
+//------------------------------------------------------------------------------
+// writes the code of the unit back from what the optimizer left of it,
+// unless a jump lost its target
+void WRCompilationContext::storeUnit( WRUnitContext& unit, WROptimizer& o )
+{
+	WRBytecode& bytecode = unit.bytecode;
+	o.markTargets();
+
+	int at = 0;
+	for( int i=o.live(0); i<o.count; i=o.next(i) )
+	{
+		if ( WROptimizer::isJump(o.ins[i]) && o.ins[i].target >= o.count )
+		{
+			return; // keep the code as it was compiled
+		}
+		o.ins[i].at = at;
+		at += o.ins[i].op.length;
+	}
+	if ( at > 0x7FFF )
+	{
+		return; // what it made of calls it inlined has to stay in 16-bit reach
+	}
+
+	bytecode.all.clear();
+	bytecode.jumpOffsetTargets.clear();
+	bytecode.jumpsPending.clear();
+	for( unsigned int x=0; x<bytecode.functionSpace.count(); ++x )
+	{
+		bytecode.functionSpace[x].references.clear();
+	}
+	for( int i=o.live(0); i<o.count; i=o.next(i) )
+	{
+		WROptInstruction& I = o.ins[i];
+		if ( WROptimizer::isJump(I) )
+		{
+			const int jump = addRelativeJumpTarget( bytecode );
+			bytecode.jumpOffsetTargets[jump].offset = o.ins[I.target].at;
+			addRelativeJumpReference( bytecode, jump, I.at + 1 );
+		}
+		if ( I.call >= 0 )
+		{
+			// link() patches it in here
+			bytecode.functionSpace[I.call].references.append() = I.at;
+			I.code[0] = O_FUNCTION_CALL_PLACEHOLDER;
+		}
+		bytecode.all.append( I.code, I.op.length );
+	}
+	resolveRelativeJumps( bytecode );
+}
+
+//------------------------------------------------------------------------------
+void WRCompilationContext::optimizeUnit( WRUnitContext& unit, const bool inlining, const int loops )
+{
+	WRBytecode& bytecode = unit.bytecode;
+
+	// 'new' is patched in by link() where it was compiled
+	const int size = bytecode.all.size();
+	if ( !size || size > 0x7FFF || bytecode.unitObjectSpace.count() )
+	{
+		return;
+	}
+
+	// and so are calls to script functions, until then they have the shape
+	// of an O_CallLibFunction(AndPop) and are seen as one
+	int* calls = (int*)wr_arenaMalloc( size * (sizeof(int) + 1) );
+	unsigned char* code = (unsigned char*)(calls + size);
+	memcpy( code, bytecode.all.p_str(), size );
+	for( int pos=0; pos<size; ++pos )
+	{
+		calls[pos] = -1;
+	}
+	bool known = true;
+	for( unsigned int x=0; x<bytecode.functionSpace.count(); ++x )
+	{
+		for( unsigned int r=0; r<bytecode.functionSpace[x].references.count(); ++r )
+		{
+			const int pos = bytecode.functionSpace[x].references[r];
+			if ( pos + 6 > size || code[pos] != O_FUNCTION_CALL_PLACEHOLDER )
+			{
+				known = false; // yield
+				continue;
 			}
-			else if ( isdigit(token[0])
-					  || (token[0] == '.' && isdigit(m_source[m_pos])) )
+			calls[pos] = x;
+			code[pos] = code[pos + 5] == O_PopOne ? O_CallLibFunctionAndPop : O_CallLibFunction;
+		}
+	}
+
+	WROptimizer o;
+	o.ins = 0;
+	o.stack = 0;
+	o.arguments = unit.arguments;
+	o.exported = unit.exportNamespace;
+	WRJitFunction f;
+	if ( known && wr_optLoad(o, f, code, size, calls) )
+	{
+		const bool inlined = inlining && inlineCalls( unit, o );
+		if ( inlined || (loops && reshapeLoop(unit, o)) )
+		{
+			// and once more for what that became
+			storeUnit( unit, o );
+			wr_arenaFree( o.ins );
+			wr_arenaFree( calls );
+			optimizeUnit( unit, false, inlined ? loops : loops - 1 );
+			return;
+		}
+
+		o.stack = (WROptSlot*)wr_arenaMalloc( (f.maxDepth + 1) * sizeof(WROptSlot) );
+		for( int round=0; round<16; ++round )
+		{
+			bool changed = o.thread();
+			changed |= o.fold();
+			changed |= o.propagate();
+			changed |= o.deadStores();
+			changed |= o.reach();
+			if ( !changed )
 			{
-				if ( m_pos >= m_sourceLen )
-				{
-					return false;
-				}
+				break;
+			}
+		}
+		storeUnit( unit, o );
+	}
+
+	wr_arenaFree( o.stack );
+	wr_arenaFree( o.ins );
+	wr_arenaFree( calls );
+}
+#endif
+
+#if defined(WRENCH_JIT) || defined(WRENCH_AOT)
+//------------------------------------------------------------------------------
+// O_CallLibFunction(AndPop) for translated code
+int wr_nativeCallLib( WRContext* context, WRValue* stackTop, int args, const uint32_t hash, const int andPop )
+{
+	WRState* w = context->w;
+
+	if ( !andPop )
+	{
+		stackTop->p2 = INIT_AS_INT;
+		stackTop->p = 0;
+	}
+
+	WRValue* lib = wr_linked( context, w->globalRegistry, hash );
+	if ( !lib->lcb )
+	{
+		w->err = WR_ERR_lib_function_not_found;
+		return 1;
+	}
+
+	lib->lcb( stackTop, args, context );
+
+	if ( !andPop && args )
+	{
+		stackTop -= --args;
+		*(stackTop - 1) = *(stackTop + args);
+	}
+
+	return w->err;
+}
+
+#endif
 
-parseAsNumber:
+#ifdef WRENCH_JIT
+//------------------------------------------------------------------------------
+// Baseline JIT, see WRENCH_JIT in wrench.h. Every opcode becomes a fixed
+// x86-64 template with its operands patched in
+#include <sys/mman.h>
 
-				m_LastParsedLabel = true;
+// the machine code of a function is mapped with this in front of it
+struct WRJitCode
+{
+	uint32_t mapped; // bytes
+	uint16_t maxDepth; // stack entries used above where it was entered
+};
 
-				if ( token[0] == '0' && m_source[m_pos] == 'x' ) // interpret as hex
-				{
-					token.clear();
-					m_pos++;
+// returns non-zero where the interpreter would have returned an error
+typedef int (*WRJitEntry)( WRValue* stackTop, WRValue* frameBase, WRValue* globalSpace, WRContext* context );
 
-					for(;;)
-					{
-						if ( m_pos >= m_sourceLen )
-						{
-							m_err = WR_ERR_unexpected_EOF;
-							return false;
-						}
+static WRTargetFunc* const wr_jitBinary[] =
+{
+	wr_AdditionBinary, wr_SubtractBinary, wr_MultiplyBinary, wr_DivideBinary, wr_ModBinary,
+	wr_LeftShiftBinary, wr_RightShiftBinary, wr_ANDBinary, wr_ORBinary, wr_XORBinary,
+};
 
-						if ( !isxdigit(m_source[m_pos]) )
-						{
-							break;
-						}
+static WRVoidFunc* const wr_jitAssign[] =
+{
+	wr_AddAssign, wr_SubtractAssign, wr_MultiplyAssign, wr_DivideAssign, wr_ModAssign,
+	wr_LeftShiftAssign, wr_RightShiftAssign, wr_ANDAssign, wr_ORAssign, wr_XORAssign, wr_assign,
+};
 
-						token += m_source[m_pos++];
-					}
+static WRReturnFunc* const wr_jitCompare[] = { wr_CompareEQ, wr_CompareLT, wr_CompareGT };
 
-					value.p2 = INIT_AS_INT;
-					value.ui = strtoul( token, 0, 16 );
-				}
-				else if (token[0] == '0' && m_source[m_pos] == 'b' )
-				{
-					token.clear();
-					m_pos++;
+//------------------------------------------------------------------------------
+static void wr_jitToInt( WRValue* value )
+{
+	value->i = value->asInt();
+	value->p2 = INIT_AS_INT;
+}
 
-					for(;;)
-					{
-						if ( m_pos >= m_sourceLen )
-						{
-							m_err = WR_ERR_unexpected_EOF;
-							return false;
-						}
+//------------------------------------------------------------------------------
+static void wr_jitToFloat( WRValue* value )
+{
+	value->f = value->asFloat();
+	value->p2 = INIT_AS_FLOAT;
+}
 
-						if ( !isxdigit(m_source[m_pos]) )
-						{
-							break;
-						}
+//------------------------------------------------------------------------------
+enum WRJitRegister
+{
+	WRJ_RAX, WRJ_RCX, WRJ_RDX, WRJ_RBX, WRJ_RSP, WRJ_RBP, WRJ_RSI, WRJ_RDI,
+	WRJ_R8, WRJ_R9, WRJ_R10, WRJ_R11, WRJ_R12, WRJ_R13, WRJ_R14, WRJ_R15,
+};
 
-						token += m_source[m_pos++];
-					}
+// callee saved, so they survive calls into the operation tables
+#define WRJ_STACK WRJ_RBX // the stackTop the function was entered with
+#define WRJ_FRAME WRJ_R12
+#define WRJ_GLOBALS WRJ_R13
+#define WRJ_CONTEXT WRJ_R14
+
+enum WRJitCondition
+{
+	WRJ_B = 0x2,
+	WRJ_AE = 0x3,
+	WRJ_E = 0x4,
+	WRJ_NE = 0x5,
+	WRJ_BE = 0x6,
+	WRJ_A = 0x7,
+	WRJ_P = 0xA,
+	WRJ_L = 0xC,
+	WRJ_GE = 0xD,
+	WRJ_LE = 0xE,
+	WRJ_G = 0xF,
+};
 
-					value.p2 = INIT_AS_INT;
-					value.i = strtol( token, 0, 2 );
-				}
-				else if (token[0] == '0' && isdigit(m_source[m_pos]) ) // octal
-				{
-					token.clear();
+//------------------------------------------------------------------------------
+// x86-64 encoder, writes past 'size' are counted but dropped
+struct WRJitAsm
+{
+	uint8_t* code;
+	int pos;
+	int size;
 
-					for(;;)
-					{
-						if ( m_pos >= m_sourceLen )
-						{
-							m_err = WR_ERR_unexpected_EOF;
-							return false;
-						}
+	void b( const int v ) { if ( pos < size ) { code[pos] = (uint8_t)v; } ++pos; }
+	void d( const int32_t v ) { b( v ); b( v >> 8 ); b( v >> 16 ); b( v >> 24 ); }
+	void q( const uint64_t v ) { d( (int32_t)v ); d( (int32_t)(v >> 32) ); }
 
-						if ( !isdigit(m_source[m_pos]) )
-						{
-							break;
-						}
+	void op( const int prefix, const bool wide, const int opcode, const int reg, const int rm )
+	{
+		if ( prefix )
+		{
+			b( prefix ); // before REX
+		}
+		const int rex = (wide ? 8 : 0) | ((reg & 8) ? 4 : 0) | ((rm & 8) ? 1 : 0);
+		if ( rex )
+		{
+			b( 0x40 | rex );
+		}
+		if ( opcode > 0xFF )
+		{
+			b( opcode >> 8 );
+		}
+		b( opcode );
+	}
 
-						token += m_source[m_pos++];
-					}
+	// 'opcode reg, [base + disp]', 'reg' is the /digit for opcodes with one
+	void rm( const int prefix, const bool wide, const int opcode, const int reg, const int base, const int32_t disp )
+	{
+		op( prefix, wide, opcode, reg, base );
+		const int mod = (disp == 0 && (base & 7) != WRJ_RBP) ? 0 : (disp >= -128 && disp <= 127) ? 1 : 2;
+		b( (mod << 6) | ((reg & 7) << 3) | (base & 7) );
+		if ( (base & 7) == WRJ_RSP )
+		{
+			b( 0x24 ); // SIB, no index
+		}
+		if ( mod == 1 )
+		{
+			b( disp );
+		}
+		else if ( mod == 2 )
+		{
+			d( disp );
+		}
+	}
 
-					value.p2 = INIT_AS_INT;
-					value.i = strtol( token, 0, 8 );
-				}
-				else
-				{
-					bool decimal = token[0] == '.';
-					for(;;)
-					{
-						if ( m_pos >= m_sourceLen )
-						{
-							m_err = WR_ERR_unexpected_EOF;
-							return false;
-						}
+	// 'opcode reg, rm' on two registers
+	void rr( const bool wide, const int opcode, const int reg, const int rm )
+	{
+		op( 0, wide, opcode, reg, rm );
+		b( 0xC0 | ((reg & 7) << 3) | (rm & 7) );
+	}
 
-						if ( m_source[m_pos] == '.' )
-						{
-							if ( decimal )
-							{
-								return false;
-							}
+	void mov32( const int reg, const int32_t value ) { op( 0, false, 0xB8 + (reg & 7), 0, reg ); d( value ); }
+	void mov64( const int reg, const void* value ) { op( 0, true, 0xB8 + (reg & 7), 0, reg ); q( (uint64_t)value ); }
+	void lea( const int reg, const int base, const int32_t disp ) { rm( 0, true, 0x8D, reg, base, disp ); }
 
-							decimal = true;
-						}
-						else if ( !isdigit(m_source[m_pos]) )
-						{
-							if ( m_source[m_pos] == 'f' || m_source[m_pos] == 'F')
-							{
-								decimal = true;
-								m_pos++;
-							}
+	// rel32 jumps, return where the offset goes for patch()
+	int jmp() { b( 0xE9 ); d( 0 ); return pos - 4; }
+	int jcc( const int condition ) { b( 0x0F ); b( 0x80 | condition ); d( 0 ); return pos - 4; }
+	void patch( const int at, const int to )
+	{
+		if ( at + 4 <= size )
+		{
+			const int32_t rel = to - (at + 4);
+			memcpy( code + at, &rel, 4 );
+		}
+	}
 
-							break;
-						}
+	void call( const void* function ) { mov64( WRJ_RAX, function ); b( 0xFF ); b( 0xD0 ); }
 
-						token += m_source[m_pos++];
-					}
+	// call table[eax]
+	void callTable( const void* table )
+	{
+		mov64( WRJ_R11, table );
+		b( 0x41 ); b( 0xFF ); b( 0x14 ); b( 0xC3 ); // call [r11 + rax*8]
+	}
 
-					if ( decimal )
-					{
-						value.p2 = INIT_AS_FLOAT;
-						value.f = (float)atof( token );
-					}
-					else
-					{
-						value.p2 = INIT_AS_INT;
-						value.ui = (uint32_t)strtoul( token, 0, 10 );
-					}
-				}
-			}
-			else if ( token[0] == ':' && isspace(m_source[m_pos]) )
-			{
-				
-			}
-			else if ( isalpha(token[0]) || token[0] == '_' || token[0] == ':' ) // must be a label
-			{
-				if ( token[0] != ':' || m_source[m_pos] == ':' )
-				{
-					m_LastParsedLabel = true;
-					if ( m_pos < m_sourceLen
-						 && token[0] == ':'
-						 && m_source[m_pos] == ':' )
-					{
-						token += ':';
-						++m_pos;
-					}
+	void epilogue()
+	{
+		b( 0x41 ); b( 0x5E ); // pop r14
+		b( 0x41 ); b( 0x5D ); // pop r13
+		b( 0x41 ); b( 0x5C ); // pop r12
+		b( 0x5B ); // pop rbx
+		b( 0x5D ); // pop rbp
+		b( 0xC3 );
+	}
+};
 
-					for (; m_pos < m_sourceLen; ++m_pos)
-					{
-						if ( m_source[m_pos] == ':' && m_source[m_pos + 1] == ':' && token.size() > 0 )
-						{
-							token += "::";
-							m_pos ++;
-							continue;
-						}
-						
-						if (!isalnum(m_source[m_pos]) && m_source[m_pos] != '_' )
-						{
-							break;
-						}
+//------------------------------------------------------------------------------
+// jumps forward to the same place
+struct WRJitJumps
+{
+	int at[4];
+	int count;
 
-						token += m_source[m_pos];
-					}
+	WRJitJumps() : count(0) {}
+	void add( const int pos ) { if ( count < 4 ) { at[count] = pos; } ++count; }
+};
 
-					if (token == "true")
-					{
-						value.p2 = INIT_AS_INT;
-						value.i = 1;
-						token = "1";
-					}
-					else if (token == "false" || token == "null" )
-					{
-						value.p2 = INIT_AS_INT;
-						value.i = 0;
-						token = "0";
-					}
-				}
-			}
-		}
+// an operand is passed to the operation tables at [base + disp], and if
+// it is an int or a float the number is at [vbase + vdisp]
+struct WRJitOperand
+{
+	int base;
+	int32_t disp;
+	int vbase;
+	int32_t vdisp;
+	int type; // WR_INT or WR_FLOAT when it is known, -1 when it is checked
+};
 
-foundMacroToken:
-	
-		ex.spaceAfter = (m_pos < m_sourceLen) && isspace(m_source[m_pos]);
+//------------------------------------------------------------------------------
+struct WRJit
+{
+	WRJitAsm a;
+	WRJitSlot* slots;
+	int* fixupAt;
+	int* fixupTo; // bytecode offset, -1 is the error exit
+	int fixups;
+	int maxFixups;
+
+	void fixup( const int at, const int to )
+	{
+		if ( fixups < maxFixups )
+		{
+			fixupAt[fixups] = at;
+			fixupTo[fixups] = to;
+		}
+		++fixups;
 	}
 
-	m_loadedToken.clear();
-	m_loadedQuoted = m_quoted;
-	m_loadedValue.p2 = INIT_AS_REF;
+	void bind( const WRJitJumps& jumps )
+	{
+		for( int i=0; i<jumps.count && i<4; ++i )
+		{
+			a.patch( jumps.at[i], a.pos );
+		}
+	}
 
-	if ( expect && (token != expect) )
+	WRJitOperand slot( const int s )
 	{
-		return false;
+		WRJitOperand o;
+		o.base = o.vbase = WRJ_STACK;
+		o.disp = o.vdisp = s * (int)sizeof(WRValue);
+		o.type = -1;
+		switch( slots[s].kind )
+		{
+			case WRJ_Int: o.type = WR_INT; break;
+			case WRJ_Float: o.type = WR_FLOAT; break;
+			case WRJ_Local: o.vbase = WRJ_FRAME; o.vdisp = slots[s].index * (int)sizeof(WRValue); break;
+			case WRJ_Global: o.vbase = WRJ_GLOBALS; o.vdisp = slots[s].index * (int)sizeof(WRValue); break;
+			default: break;
+		}
+		return o;
 	}
 
-	return true;
-}
+	// a local or global the opcode names
+	WRJitOperand value( const int base, const int index )
+	{
+		WRJitOperand o;
+		o.base = o.vbase = base;
+		o.disp = o.vdisp = index * (int)sizeof(WRValue);
+		o.type = -1;
+		return o;
+	}
 
-#endif
-/*******************************************************************************
-Copyright (c) 2024 Curt Hartung -- curt.hartung@gmail.com
+	static bool maybe( const WRJitOperand& o, const int type ) { return o.type < 0 || o.type == type; }
 
-MIT Licence
+	// jump to 'fail' unless the operand is of 'type'
+	void check( const WRJitOperand& o, const int type, WRJitJumps& fail )
+	{
+		if ( o.type < 0 )
+		{
+			a.rm( 0, false, 0x80, 7, o.vbase, o.vdisp + 8 ); // cmp byte [type], type
+			a.b( type );
+			fail.add( a.jcc(WRJ_NE) );
+		}
+	}
 
-Permission is hereby granted, free of charge, to any person obtaining a copy
-of this software and associated documentation files (the "Software"), to deal
-in the Software without restriction, including without limitation the rights
-to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
-copies of the Software, and to permit persons to whom the Software is
-furnished to do so, subject to the following conditions:
+	// jump to 'fail' unless the operand is an int or a float
+	void checkNumber( const WRJitOperand& o, WRJitJumps& fail )
+	{
+		if ( o.type < 0 )
+		{
+			a.rm( 0, false, 0x80, 7, o.vbase, o.vdisp + 8 );
+			a.b( WR_FLOAT );
+			fail.add( a.jcc(WRJ_A) );
+		}
+	}
 
-The above copyright notice and this permission notice shall be included in all
-copies or substantial portions of the Software.
+	// eax = (x->type<<2)|y->type, the operation table index
+	void tableIndex( const WRJitOperand& x, const WRJitOperand& y )
+	{
+		a.rm( 0, false, 0x0FB6, WRJ_RAX, x.base, x.disp + 8 ); // movzx
+		a.b( 0xC1 ); a.b( 0xE0 ); a.b( 2 ); // shl eax, 2
+		a.rm( 0, false, 0x0FB6, WRJ_RCX, y.base, y.disp + 8 );
+		a.rr( false, 0x09, WRJ_RCX, WRJ_RAX ); // or eax, ecx
+	}
 
-THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
-IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
-FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
-AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
-LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
-OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
-SOFTWARE.
-*******************************************************************************/
+	void storeType( const int base, const int32_t disp, const uint32_t p2 )
+	{
+		a.rm( 0, false, 0xC7, 0, base, disp + 8 );
+		a.d( p2 );
+	}
 
-#include "wrench.h"
+	void binary( const int math, const WRJitOperand& T, const WRJitOperand& S, const int base, const int32_t disp );
+	void assign( const int math, const WRJitOperand& T, const WRJitOperand& S );
+	void branch( const int compare, const bool when, const WRJitOperand& X, const WRJitOperand& Y, const int target );
+	void branchZero( const WRJitOperand& Y, const int target );
+	void unary( WRUnaryFunc* table, const int step, const WRJitOperand& V );
+	bool emit( const unsigned char* pc, const WRJitOp& op, const int pos, const int depth );
+};
 
 //------------------------------------------------------------------------------
-void WRContext::mark( WRValue* s )
+// [base + disp] = T 'math' S, as wr_<math>Binary does it
+void WRJit::binary( const int math, const WRJitOperand& T, const WRJitOperand& S, const int base, const int32_t disp )
 {
-	if ( IS_ARRAY_MEMBER(s->xtype) && IS_EXARRAY_TYPE(s->r->xtype) )
+	WRJitJumps done;
+
+	if ( math != WRJ_Div && math != WRJ_Mod && maybe(T, WR_INT) && maybe(S, WR_INT) )
 	{
-		// we don't mark this type, but we might mark it's target
-		mark( s->r );
-		return;
+		WRJitJumps next;
+		check( T, WR_INT, next );
+		check( S, WR_INT, next );
+		a.rm( 0, false, 0x8B, WRJ_RAX, T.vbase, T.vdisp );
+		switch( math )
+		{
+			case WRJ_Add: a.rm( 0, false, 0x03, WRJ_RAX, S.vbase, S.vdisp ); break;
+			case WRJ_Sub: a.rm( 0, false, 0x2B, WRJ_RAX, S.vbase, S.vdisp ); break;
+			case WRJ_Mul: a.rm( 0, false, 0x0FAF, WRJ_RAX, S.vbase, S.vdisp ); break;
+			case WRJ_And: a.rm( 0, false, 0x23, WRJ_RAX, S.vbase, S.vdisp ); break;
+			case WRJ_Or: a.rm( 0, false, 0x0B, WRJ_RAX, S.vbase, S.vdisp ); break;
+			case WRJ_Xor: a.rm( 0, false, 0x33, WRJ_RAX, S.vbase, S.vdisp ); break;
+			default:
+			{
+				a.rm( 0, false, 0x8B, WRJ_RCX, S.vbase, S.vdisp );
+				a.rr( false, 0xD3, math == WRJ_Shl ? 4 : 7, WRJ_RAX ); // shl/sar eax, cl
+				break;
+			}
+		}
+		a.rm( 0, false, 0x89, WRJ_RAX, base, disp );
+		storeType( base, disp, INIT_AS_INT );
+		if ( !next.count )
+		{
+			return;
+		}
+		done.add( a.jmp() );
+		bind( next );
 	}
 
-	if ( !IS_EXARRAY_TYPE(s->xtype) || s->va->m_skipGC || (s->va->m_size & 0x40000000) )
+	if ( math <= WRJ_Div && maybe(T, WR_FLOAT) && maybe(S, WR_FLOAT) )
 	{
-		return;
+		static const int ops[] = { 0x0F58, 0x0F5C, 0x0F59, 0x0F5E }; // addss, subss, mulss, divss
+		WRJitJumps next;
+		check( T, WR_FLOAT, next );
+		check( S, WR_FLOAT, next );
+		a.rm( 0xF3, false, 0x0F10, 0, T.vbase, T.vdisp ); // movss xmm0
+		a.rm( 0xF3, false, ops[math], 0, S.vbase, S.vdisp );
+		a.rm( 0xF3, false, 0x0F11, 0, base, disp );
+		storeType( base, disp, INIT_AS_FLOAT );
+		if ( !next.count )
+		{
+			bind( done );
+			return;
+		}
+		done.add( a.jmp() );
+		bind( next );
 	}
 
-	assert( !IS_RAW_ARRAY(s->xtype) );
+	tableIndex( T, S );
+	a.lea( WRJ_RDI, T.base, T.disp );
+	a.lea( WRJ_RSI, S.base, S.disp );
+	a.lea( WRJ_RDX, base, disp );
+	a.callTable( wr_jitBinary[math] );
+	bind( done );
+}
 
-	WRGCObject* sva = s->va;
+//------------------------------------------------------------------------------
+// T 'math'= S, as wr_<math>Assign does it
+void WRJit::assign( const int math, const WRJitOperand& T, const WRJitOperand& S )
+{
+	WRJitJumps done;
 
-	if ( sva->m_type == SV_VALUE )
+	if ( math == WRJ_Assign )
 	{
-		WRValue* top = sva->m_Vdata + sva->m_size;
-
-		for( WRValue* V = sva->m_Vdata; V<top; ++V )
+		WRJitJumps next;
+		checkNumber( T, next );
+		checkNumber( S, next );
+		a.rm( 0, false, 0x0F10, 0, S.vbase, S.vdisp ); // movups
+		a.rm( 0, false, 0x0F11, 0, T.vbase, T.vdisp );
+		if ( !next.count )
 		{
-			mark( V );
+			return;
 		}
+		done.add( a.jmp() );
+		bind( next );
 	}
-	else if ( sva->m_type == SV_HASH_TABLE )
+	else if ( math != WRJ_Div && math != WRJ_Mod && maybe(T, WR_INT) && maybe(S, WR_INT) )
 	{
-		for( uint32_t i=0; i<sva->m_mod; ++i )
+		WRJitJumps next;
+		check( T, WR_INT, next );
+		check( S, WR_INT, next );
+		switch( math )
 		{
-			if ( sva->m_hashTable[i] != WRENCH_NULL_HASH )
+			case WRJ_Mul:
 			{
-				uint32_t item = i<<1;
-				mark( sva->m_Vdata + item++ );
-				mark( sva->m_Vdata + item );
+				a.rm( 0, false, 0x8B, WRJ_RAX, T.vbase, T.vdisp );
+				a.rm( 0, false, 0x0FAF, WRJ_RAX, S.vbase, S.vdisp );
+				a.rm( 0, false, 0x89, WRJ_RAX, T.vbase, T.vdisp );
+				break;
+			}
+
+			case WRJ_Shl:
+			case WRJ_Shr:
+			{
+				a.rm( 0, false, 0x8B, WRJ_RCX, S.vbase, S.vdisp );
+				a.rm( 0, false, 0xD3, math == WRJ_Shl ? 4 : 7, T.vbase, T.vdisp );
+				break;
+			}
+
+			default:
+			{
+				static const int ops[] = { 0x01, 0x29, 0, 0, 0, 0, 0, 0x21, 0x09, 0x31 }; // add, sub, and, or, xor
+				a.rm( 0, false, 0x8B, WRJ_RAX, S.vbase, S.vdisp );
+				a.rm( 0, false, ops[math], WRJ_RAX, T.vbase, T.vdisp );
+				break;
 			}
 		}
+		if ( !next.count )
+		{
+			return;
+		}
+		done.add( a.jmp() );
+		bind( next );
 	}
 
-	sva->m_size |= 0x40000000;
+	if ( math <= WRJ_Div && maybe(T, WR_FLOAT) && maybe(S, WR_FLOAT) )
+	{
+		static const int ops[] = { 0x0F58, 0x0F5C, 0x0F59, 0x0F5E };
+		WRJitJumps next;
+		check( T, WR_FLOAT, next );
+		check( S, WR_FLOAT, next );
+		a.rm( 0xF3, false, 0x0F10, 0, T.vbase, T.vdisp );
+		a.rm( 0xF3, false, ops[math], 0, S.vbase, S.vdisp );
+		a.rm( 0xF3, false, 0x0F11, 0, T.vbase, T.vdisp );
+		if ( !next.count )
+		{
+			bind( done );
+			return;
+		}
+		done.add( a.jmp() );
+		bind( next );
+	}
+
+	tableIndex( T, S );
+	a.lea( WRJ_RDI, T.base, T.disp );
+	a.lea( WRJ_RSI, S.base, S.disp );
+	a.callTable( wr_jitAssign[math] );
+	bind( done );
 }
 
 //------------------------------------------------------------------------------
-void WRContext::gc( WRValue* stackTop )
+// jump to bytecode 'target' when X 'compare' Y is 'when'
+void WRJit::branch( const int compare, const bool when, const WRJitOperand& X, const WRJitOperand& Y, const int target )
 {
-	if ( allocatedMemoryHint < allocatedMemoryLimit )
-	{
-		return;
-	}
-
-	allocatedMemoryHint = 0;
+	WRJitJumps done;
 
-	// mark stack
-	for( WRValue* s=stack; s<stackTop; ++s)
+	if ( maybe(X, WR_INT) && maybe(Y, WR_INT) )
 	{
-		// an array in the chain?
-		mark( s );
+		static const int conditions[] = { WRJ_E, WRJ_L, WRJ_G };
+		WRJitJumps next;
+		check( X, WR_INT, next );
+		check( Y, WR_INT, next );
+		a.rm( 0, false, 0x8B, WRJ_RAX, X.vbase, X.vdisp );
+		a.rm( 0, false, 0x3B, WRJ_RAX, Y.vbase, Y.vdisp ); // cmp
+		fixup( a.jcc(conditions[compare] ^ (when ? 0 : 1)), target );
+		if ( !next.count )
+		{
+			return;
+		}
+		done.add( a.jmp() );
+		bind( next );
 	}
 
-	// mark context's globals
-	WRValue* globalSpace = (WRValue *)(this + 1); // globals are allocated directly after this context
-
-	for( unsigned int i=0; i<globals; ++i, ++globalSpace )
+	if ( maybe(X, WR_FLOAT) && maybe(Y, WR_FLOAT) )
 	{
-		mark( globalSpace );
-	}
+		WRJitJumps next;
+		check( X, WR_FLOAT, next );
+		check( Y, WR_FLOAT, next );
 
-	// sweep
-	WRGCObject* current = svAllocated;
-	WRGCObject* prev = 0;
-	while( current )
-	{
-		// if set, clear it
-		if ( current->m_size & 0x40000000 )
+		// a NaN compares unordered, which is false for all three
+		const WRJitOperand& left = compare == WRJ_LT ? Y : X;
+		const WRJitOperand& right = compare == WRJ_LT ? X : Y;
+		a.rm( 0xF3, false, 0x0F10, 0, left.vbase, left.vdisp );
+		a.rm( 0, false, 0x0F2E, 0, right.vbase, right.vdisp ); // ucomiss
+		if ( compare != WRJ_EQ )
 		{
-			current->m_size &= ~0x40000000;
-			prev = current;
-			current = current->m_next;
+			fixup( a.jcc(when ? WRJ_A : WRJ_BE), target );
+		}
+		else if ( when )
+		{
+			const int unordered = a.jcc( WRJ_P );
+			fixup( a.jcc(WRJ_E), target );
+			a.patch( unordered, a.pos );
 		}
-		// otherwise free it as unreferenced
 		else
 		{
-			current->clear();
-
-			if ( prev == 0 )
-			{
-				svAllocated = current->m_next;
-				g_free( current );
-				current = svAllocated;
-			}
-			else
-			{
-				prev->m_next = current->m_next;
-				g_free( current );
-				current = prev->m_next;
-			}
+			fixup( a.jcc(WRJ_P), target );
+			fixup( a.jcc(WRJ_NE), target );
 		}
+		if ( !next.count )
+		{
+			bind( done );
+			return;
+		}
+		done.add( a.jmp() );
+		bind( next );
 	}
+
+	tableIndex( X, Y );
+	a.lea( WRJ_RDI, X.base, X.disp );
+	a.lea( WRJ_RSI, Y.base, Y.disp );
+	a.callTable( wr_jitCompare[compare] );
+	a.b( 0x84 ); a.b( 0xC0 ); // test al, al
+	fixup( a.jcc(when ? WRJ_NE : WRJ_E), target );
+	bind( done );
 }
 
-/*  meh..
 //------------------------------------------------------------------------------
-void WRContext::scavenge( WRGCObject* va )
+// O_BZ, ints and floats are zero when all their bits are
+void WRJit::branchZero( const WRJitOperand& Y, const int target )
 {
-	// free the sub-array from this object, if the object itself
-	// needs to be cleaned that has to happen in the gc but this
-	// can be done anywhere
-	if ( va->m_type == SV_VOID_HASH_TABLE )
+	WRJitJumps next;
+	checkNumber( Y, next );
+	a.rm( 0, false, 0x83, 7, Y.vbase, Y.vdisp ); // cmp dword, 0
+	a.b( 0 );
+	fixup( a.jcc(WRJ_E), target );
+	if ( !next.count )
 	{
 		return;
 	}
+	const int done = a.jmp();
+	bind( next );
 
-	g_free( va->m_data );
-	va->m_data = 0;
-
-	if ( va->m_type != SV_CHAR )
-	{
-		if ( va->m_type == SV_HASH_TABLE )
-		{
-			g_free( va->m_hashTable );
-			allocatedMemoryHint -= (va->m_mod * 4);
-		}
+	a.rm( 0, false, 0x0FB6, WRJ_RAX, Y.base, Y.disp + 8 );
+	a.lea( WRJ_RDI, Y.base, Y.disp );
+	a.callTable( wr_LogicalNot );
+	a.b( 0x84 ); a.b( 0xC0 );
+	fixup( a.jcc(WRJ_NE), target );
+	a.patch( done, a.pos );
+}
 
-		allocatedMemoryHint -= va->m_size * 3;
-		va->m_type = SV_CHAR;
-	}
+//------------------------------------------------------------------------------
+// O_Inc*, O_Dec*
+void WRJit::unary( WRUnaryFunc* table, const int step, const WRJitOperand& V )
+{
+	WRJitJumps next;
+	check( V, WR_INT, next );
+	a.rm( 0, false, 0xFF, step > 0 ? 0 : 1, V.vbase, V.vdisp ); // inc/dec dword
+	const int done = a.jmp();
+	bind( next );
 
-	allocatedMemoryHint -= va->m_size;
-	va->m_size = 0;
+	a.rm( 0, false, 0x0FB6, WRJ_RAX, V.base, V.disp + 8 );
+	a.lea( WRJ_RDI, V.base, V.disp );
+	a.callTable( table );
+	a.patch( done, a.pos );
 }
-*/
 
 //------------------------------------------------------------------------------
-WRGCObject* WRContext::getSVA( int size, WRGCObjectType type, bool init )
+// the template for one opcode, false if it can not be translated
+bool WRJit::emit( const unsigned char* pc, const WRJitOp& op, const int pos, const int depth )
 {
-	WRGCObject* ret = (WRGCObject*)g_malloc( sizeof(WRGCObject) );
+	const int top = depth - 1;
+	const int32_t slotSize = (int32_t)sizeof(WRValue);
+	const int k = READ_8_FROM_PC(pc + 1);
+	int result = -1; // kind of the pushed value
 
-#ifdef WRENCH_HANDLE_MALLOC_FAIL
-	if ( !ret )
+	switch( op.opcode )
 	{
-		g_mallocFailed = true;
-		return 0;
-	}
-#endif
+		case O_LiteralZero:
+		{
+			a.rm( 0, true, 0xC7, 0, WRJ_STACK, depth * slotSize ); // mov qword, 0
+			a.d( 0 );
+			storeType( WRJ_STACK, depth * slotSize, INIT_AS_INT );
+			result = WRJ_Int;
+			break;
+		}
 
-	ret->init( size, type, init );
+		case O_LiteralInt8:
+		case O_LiteralInt16:
+		case O_LiteralInt32:
+		case O_LiteralFloat:
+		{
+			a.rm( 0, false, 0xC7, 0, WRJ_STACK, depth * slotSize );
+			a.d( op.opcode == O_LiteralInt8 ? (int32_t)(int8_t)k
+				 : op.opcode == O_LiteralInt16 ? (int32_t)READ_16_FROM_PC(pc + 1)
+				 : READ_32_FROM_PC(pc + 1) );
+			result = op.opcode == O_LiteralFloat ? WRJ_Float : WRJ_Int;
+			storeType( WRJ_STACK, depth * slotSize, result == WRJ_Float ? INIT_AS_FLOAT : INIT_AS_INT );
+			break;
+		}
 
-	if ( type == SV_CHAR )
-	{
-		ret->m_creatorContext = this;
-		allocatedMemoryHint += size;
-	}
-	else if ( type == SV_VALUE )
-	{
-		ret->m_creatorContext = this;
-		allocatedMemoryHint += size * sizeof(WRValue);
-	}
-	else
-	{
-		allocatedMemoryHint += ret->m_size * sizeof(WRValue);
-	}
+		case O_LoadFromLocal:
+		case O_LoadFromGlobal:
+		{
+			a.lea( WRJ_RAX, op.opcode == O_LoadFromLocal ? WRJ_FRAME : WRJ_GLOBALS, k * slotSize );
+			a.rm( 0, true, 0x89, WRJ_RAX, WRJ_STACK, depth * slotSize );
+			storeType( WRJ_STACK, depth * slotSize, INIT_AS_REF );
+			slots[depth].kind = op.opcode == O_LoadFromLocal ? WRJ_Local : WRJ_Global;
+			slots[depth].index = (uint8_t)k;
+			break;
+		}
 
-	ret->m_next = svAllocated;
-	svAllocated = ret;
+		case O_LiteralInt8ToLocal:
+		case O_LiteralInt8ToGlobal:
+		case O_LiteralInt16ToLocal:
+		case O_LiteralInt16ToGlobal:
+		case O_LiteralInt32ToLocal:
+		case O_LiteralInt32ToGlobal:
+		case O_LiteralFloatToLocal:
+		case O_LiteralFloatToGlobal:
+		{
+			const int base = (op.opcode == O_LiteralInt8ToLocal || op.opcode == O_LiteralInt16ToLocal
+							  || op.opcode == O_LiteralInt32ToLocal || op.opcode == O_LiteralFloatToLocal) ? WRJ_FRAME : WRJ_GLOBALS;
+			a.rm( 0, false, 0xC7, 0, base, k * slotSize );
+			a.d( op.length == 3 ? (int32_t)(int8_t)READ_8_FROM_PC(pc + 2)
+				 : op.length == 4 ? (int32_t)READ_16_FROM_PC(pc + 2)
+				 : READ_32_FROM_PC(pc + 2) );
+			storeType( base, k * slotSize,
+					   (op.opcode == O_LiteralFloatToLocal || op.opcode == O_LiteralFloatToGlobal) ? INIT_AS_FLOAT : INIT_AS_INT );
+			break;
+		}
 
-	return ret;
-}
+		case O_PopOne: break;
 
-/*******************************************************************************
-Copyright (c) 2024 Curt Hartung -- curt.hartung@gmail.com
+		case O_StackSwap:
+		case O_SwapTwoToTop:
+		{
+			// the second swaps the entry under the top
+			for( int pair=0; pair<(op.opcode == O_StackSwap ? 1 : 2); ++pair )
+			{
+				const int at = top - pair;
+				const int other = depth - READ_8_FROM_PC(pc + 1 + pair);
+				a.rm( 0, false, 0x0F10, 0, WRJ_STACK, at * slotSize );
+				a.rm( 0, false, 0x0F10, 1, WRJ_STACK, other * slotSize );
+				a.rm( 0, false, 0x0F11, 1, WRJ_STACK, at * slotSize );
+				a.rm( 0, false, 0x0F11, 0, WRJ_STACK, other * slotSize );
+				const WRJitSlot s = slots[at];
+				slots[at] = slots[other];
+				slots[other] = s;
+			}
+			break;
+		}
 
-MIT Licence
+		case O_ToInt:
+		case O_ToFloat:
+		{
+			result = op.opcode == O_ToInt ? WRJ_Int : WRJ_Float;
+			if ( slots[top].kind == result )
+			{
+				storeType( WRJ_STACK, top * slotSize, result == WRJ_Int ? INIT_AS_INT : INIT_AS_FLOAT );
+			}
+			else
+			{
+				a.lea( WRJ_RDI, WRJ_STACK, top * slotSize );
+				a.call( (const void*)(op.opcode == O_ToInt ? wr_jitToInt : wr_jitToFloat) );
+			}
+			break;
+		}
 
-Permission is hereby granted, free of charge, to any person obtaining a copy
-of this software and associated documentation files (the "Software"), to deal
-in the Software without restriction, including without limitation the rights
-to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
-copies of the Software, and to permit persons to whom the Software is
-furnished to do so, subject to the following conditions:
+		case O_IncLocal: unary( wr_preinc, 1, value(WRJ_FRAME, k) ); break;
+		case O_DecLocal: unary( wr_predec, -1, value(WRJ_FRAME, k) ); break;
+		case O_IncGlobal: unary( wr_preinc, 1, value(WRJ_GLOBALS, k) ); break;
+		case O_DecGlobal: unary( wr_predec, -1, value(WRJ_GLOBALS, k) ); break;
+
+		case O_BinaryAddition:
+		case O_BinarySubtraction:
+		case O_BinaryMultiplication:
+		case O_BinaryDivision:
+		case O_BinaryMod:
+		case O_BinaryLeftShift:
+		case O_BinaryRightShift:
+		case O_BinaryAnd:
+		case O_BinaryOr:
+		case O_BinaryXOR:
+		case O_GGBinaryAddition:
+		case O_GLBinaryAddition:
+		case O_LLBinaryAddition:
+		case O_GGBinarySubtraction:
+		case O_GLBinarySubtraction:
+		case O_LGBinarySubtraction:
+		case O_LLBinarySubtraction:
+		case O_GGBinaryMultiplication:
+		case O_GLBinaryMultiplication:
+		case O_LLBinaryMultiplication:
+		case O_GGBinaryDivision:
+		case O_GLBinaryDivision:
+		case O_LGBinaryDivision:
+		case O_LLBinaryDivision:
+		{
+			WRJitOperand T, S;
+			int target;
+			if ( op.length == 1 )
+			{
+				T = slot( top );
+				S = slot( top - 1 );
+				target = top - 1;
+			}
+			else
+			{
+				bool localT, localS;
+				wr_jitBinarySpaces( op.opcode, localT, localS );
+				T = value( localT ? WRJ_FRAME : WRJ_GLOBALS, READ_8_FROM_PC(pc + 2) );
+				S = value( localS ? WRJ_FRAME : WRJ_GLOBALS, k );
+				target = depth;
+			}
 
-The above copyright notice and this permission notice shall be included in all
-copies or substantial portions of the Software.
+			binary( op.math, T, S, WRJ_STACK, target * slotSize );
+			result = (T.type == WR_INT && S.type == WR_INT) ? WRJ_Int
+					 : (T.type == WR_FLOAT && S.type == WR_FLOAT && op.math <= WRJ_Div) ? WRJ_Float
+					 : WRJ_Unknown;
+			if ( target != depth )
+			{
+				slots[target].kind = (uint8_t)result;
+				result = -1;
+			}
+			break;
+		}
 
-THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
-IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
-FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
-AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
-LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
-OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
-SOFTWARE.
-*******************************************************************************/
+		case O_BinaryAdditionAndStoreLocal:
+		case O_BinarySubtractionAndStoreLocal:
+		case O_BinaryMultiplicationAndStoreLocal:
+		case O_BinaryDivisionAndStoreLocal:
+		{
+			binary( op.math, slot(top), slot(top - 1), WRJ_FRAME, k * slotSize );
+			break;
+		}
 
-#include "wrench.h"
+		case O_BinaryAdditionAndStoreGlobal:
+		case O_BinarySubtractionAndStoreGlobal:
+		case O_BinaryMultiplicationAndStoreGlobal:
+		case O_BinaryDivisionAndStoreGlobal:
+		{
+			binary( op.math, slot(top), slot(top - 1), WRJ_GLOBALS, k * slotSize );
+			break;
+		}
 
-//------------------------------------------------------------------------------
-inline bool wr_getNextValue( WRValue* iterator, WRValue* value, WRValue* key )
-{
-	if ( !IS_ITERATOR(iterator->xtype) )
-	{
-		return false;
-	}
+		case O_AddAssignAndPop:
+		case O_SubtractAssignAndPop:
+		case O_MultiplyAssignAndPop:
+		case O_DivideAssignAndPop:
+		case O_ModAssignAndPop:
+		case O_LeftShiftAssignAndPop:
+		case O_RightShiftAssignAndPop:
+		case O_ANDAssignAndPop:
+		case O_ORAssignAndPop:
+		case O_XORAssignAndPop:
+		case O_AssignAndPop:
+		{
+			// T is what is assigned to, usually a reference
+			assign( op.math, slot(top), slot(top - 1) );
+			break;
+		}
 
-	uint32_t element = DECODE_ARRAY_ELEMENT_FROM_P2( iterator->p2 );
+		case O_AssignToLocalAndPop: assign( WRJ_Assign, value(WRJ_FRAME, k), slot(top) ); break;
+		case O_AssignToGlobalAndPop: assign( WRJ_Assign, value(WRJ_GLOBALS, k), slot(top) ); break;
 
-	if ( iterator->va->m_type == SV_HASH_TABLE )
-	{
-		for( ; element<iterator->va->m_mod; ++element )
+		case O_CallLibFunction:
+		case O_CallLibFunctionAndPop:
 		{
-			if ( iterator->va->m_hashTable[element] != WRENCH_NULL_HASH )
+			a.rr( true, 0x89, WRJ_CONTEXT, WRJ_RDI );
+			a.lea( WRJ_RSI, WRJ_STACK, depth * slotSize );
+			a.mov32( WRJ_RDX, k );
+			a.mov32( WRJ_RCX, READ_32_FROM_PC(pc + 2) );
+			a.mov32( WRJ_R8, op.opcode == O_CallLibFunctionAndPop );
+			a.call( (const void*)wr_nativeCallLib );
+			a.b( 0x85 ); a.b( 0xC0 ); // test eax, eax
+			fixup( a.jcc(WRJ_NE), -1 );
+			if ( op.pushes )
 			{
-				iterator->p2 = INIT_AS_ITERATOR | ENCODE_ARRAY_ELEMENT_TO_P2(element+1);
-				
-				element <<= 1;
-
-				value->p2 = INIT_AS_REF;
-				value->r = iterator->va->m_Vdata + element;
-				if ( key )
-				{
-					key->p2 = INIT_AS_REF;
-					key->r = iterator->va->m_Vdata + element + 1;
-				}
-				
-				return true;
+				slots[depth - op.pops].kind = WRJ_Unknown;
 			}
-		}
-		
-		return false;
-	}
-	else 
-	{
-		if ( element >= iterator->va->m_size )
-		{
-			return false;
+			break;
 		}
 
-		if ( key )
+		case O_ReturnZero:
+			a.rm( 0, true, 0xC7, 0, WRJ_STACK, 0 );
+			a.d( 0 );
+			storeType( WRJ_STACK, 0, 0 );
+			// fall through
+		case O_Return:
 		{
-			key->p2 = INIT_AS_INT;
-			key->i = element;
+			a.b( 0x31 ); a.b( 0xC0 ); // xor eax, eax
+			a.epilogue();
+			break;
 		}
 
-		if ( iterator->va->m_type == SV_VALUE )
+		case O_RelativeJump:
+		case O_RelativeJump8:
+		case O_RelativeJump32:
 		{
-			value->p2 = INIT_AS_REF;
-			value->r = iterator->va->m_Vdata + element;
+			fixup( a.jmp(), pos + op.target );
+			break;
 		}
-		else if ( iterator->va->m_type == SV_CHAR )
+
+		case O_BZ:
+		case O_BZ8:
 		{
-			value->p2 = INIT_AS_INT;
-			value->i = iterator->va->m_Cdata[element];
+			branchZero( slot(top), pos + op.target );
+			break;
 		}
-		else
+
+		default:
 		{
-			return false;
+			if ( op.flow != WRJ_Branch )
+			{
+				return false;
+			}
+
+			switch( op.form )
+			{
+				case WRJ_TwoStack: branch( op.compare, op.when, slot(top), slot(top - 1), pos + op.target ); break;
+				case WRJ_LocalStack: branch( op.compare, op.when, value(WRJ_FRAME, k), slot(top), pos + op.target ); break;
+				case WRJ_GlobalStack: branch( op.compare, op.when, value(WRJ_GLOBALS, k), slot(top), pos + op.target ); break;
+				case WRJ_TwoLocal: branch( op.compare, op.when, value(WRJ_FRAME, READ_8_FROM_PC(pc + 2)), value(WRJ_FRAME, k), pos + op.target ); break;
+				default: branch( op.compare, op.when, value(WRJ_GLOBALS, READ_8_FROM_PC(pc + 2)), value(WRJ_GLOBALS, k), pos + op.target ); break;
+			}
+			break;
 		}
+	}
 
-		iterator->p2 = INIT_AS_ITERATOR | ENCODE_ARRAY_ELEMENT_TO_P2(++element);
+	if ( result >= 0 )
+	{
+		slots[depth - op.pops].kind = (uint8_t)result;
 	}
 
 	return true;
 }
 
-
-/*
-static void dumpStack( const WRValue* bottom, const WRValue* top )
-{
-	WRstr out;
-	wr_stackDump( bottom, top, out );
-	printf( "stack:\n%s===================================\n", out.c_str() );
-}
-#define DEBUG_PER_INSTRUCTION { dumpStack(context->stack, stackTop); }
-*/
-#define DEBUG_PER_INSTRUCTION
-
-//------------------------------------------------------------------------------
-#ifdef WRENCH_PROTECT_STACK_FROM_OVERFLOW
-#define CHECK_STACK { if ( stackTop >= stackLimit ) { w->err = WR_ERR_stack_overflow; return 0; } }
-#else
-#define CHECK_STACK
-#endif
-
-//------------------------------------------------------------------------------
-#ifdef WRENCH_HANDLE_MALLOC_FAIL
-  bool g_mallocFailed =false;
-  #define MALLOC_FAIL_CHECK {if( g_mallocFailed ) { w->err = WR_ERR_malloc_failed; g_mallocFailed = false; return 0; } }
-#else
-  #define MALLOC_FAIL_CHECK
-#endif
-
-//------------------------------------------------------------------------------
-#ifdef WRENCH_TIME_SLICES
-
-//------------------------------------------------------------------------------
-void wr_setInstructionsPerSlice( WRState* w, const int instructions )
-{
-	w->instructionsPerSlice = instructions;
-}
-
 //------------------------------------------------------------------------------
-void wr_forceYield( WRState* w )
+// translate 'function', false leaves it to the interpreter for good
+static bool wr_jitCompile( WRContext* context, WRFunction* function )
 {
-	w->yieldEnabled = true; // prevent a race in case the count is decremented before this flag is checked
-	w->sliceInstructionCount = 1;
-}
-
-#define CHECK_FORCE_YIELD { if ( !--w->sliceInstructionCount && w->yieldEnabled ) { context->yieldArgs = 0; context->flags |= (uint8_t)WRC_ForceYielded; goto doYield; } }
-#else
-#define CHECK_FORCE_YIELD
-#endif
+	WRJitFunction f;
+	bool ok = f.analyze( context->bottom, context->bottomSize, function->functionOffset );
 
-//------------------------------------------------------------------------------
-#define WRENCH_JUMPTABLE_INTERPRETER
-#ifdef WRENCH_REALLY_COMPACT
-#undef WRENCH_JUMPTABLE_INTERPRETER
-#elif !defined(__clang__)
-#if _MSC_VER
-#undef WRENCH_JUMPTABLE_INTERPRETER
-#endif
-#endif
+	WRJit jit;
+	jit.a.size = 256 + f.instructions * 160;
+	jit.a.code = ok ? (uint8_t*)g_malloc( jit.a.size ) : 0;
+	jit.a.pos = 0;
+	jit.slots = jit.a.code ? (WRJitSlot*)g_malloc( (f.maxDepth + 1) * sizeof(WRJitSlot) ) : 0;
+	jit.maxFixups = f.instructions * 4 + 1;
+	jit.fixupAt = jit.slots ? (int*)g_malloc( jit.maxFixups * 2 * sizeof(int) ) : 0;
+	jit.fixupTo = jit.fixupAt + jit.maxFixups;
+	jit.fixups = 0;
 
-#ifdef WRENCH_JUMPTABLE_INTERPRETER
- #define CONTINUE { DEBUG_PER_INSTRUCTION; MALLOC_FAIL_CHECK; goto *opcodeJumptable[READ_8_FROM_PC(pc++)];  }
- #define FASTCONTINUE { DEBUG_PER_INSTRUCTION; goto *opcodeJumptable[READ_8_FROM_PC(pc++)];  }
- #define CASE(LABEL) LABEL
-#else
- #define CONTINUE { DEBUG_PER_INSTRUCTION; MALLOC_FAIL_CHECK; continue; }
- #define FASTCONTINUE { DEBUG_PER_INSTRUCTION; continue; }
- #define CASE(LABEL) case O_##LABEL
-#endif
+	WRJitCode* compiled = 0;
+	if ( jit.fixupAt )
+	{
+		WRJitAsm& a = jit.a;
 
-#ifdef WRENCH_COMPACT
+		// entered with the interpreter's registers, rsp is 16 byte
+		// aligned once five are pushed
+		a.b( 0x55 ); // push rbp
+		a.b( 0x53 ); // push rbx
+		a.b( 0x41 ); a.b( 0x54 ); // push r12
+		a.b( 0x41 ); a.b( 0x55 ); // push r13
+		a.b( 0x41 ); a.b( 0x56 ); // push r14
+		a.rr( true, 0x89, WRJ_RDI, WRJ_STACK );
+		a.rr( true, 0x89, WRJ_RSI, WRJ_FRAME );
+		a.rr( true, 0x89, WRJ_RDX, WRJ_GLOBALS );
+		a.rr( true, 0x89, WRJ_RCX, WRJ_CONTEXT );
 
-static float divisionF( float a, float b ) { return a / b; }
-static float addF( float a, float b ) { return a + b; }
-static float subtractionF( float a, float b ) { return a - b; }
-static float multiplicationF( float a, float b ) { return a * b; }
+		// in address order, so falling through is falling through
+		bool fallsThrough = false;
+		for( int pos=0; ok && pos<f.limit; ++pos )
+		{
+			if ( !(f.flags[pos] & WRJ_Start) )
+			{
+				continue;
+			}
 
-static int divisionI( int a, int b ) { return a / b; }
-int wr_addI( int a, int b ) { return a + b; }
-static int subtractionI( int a, int b ) { return a - b; }
-static int multiplicationI( int a, int b ) { return a * b; }
+			if ( (f.flags[pos] & WRJ_Target) || !fallsThrough )
+			{
+				// values could come from anywhere, check them all
+				for( int s=0; s<=f.maxDepth; ++s )
+				{
+					jit.slots[s].kind = WRJ_Unknown;
+				}
+			}
 
-static int rightShiftI( int a, int b ) { return a >> b; }
-static int leftShiftI( int a, int b ) { return a << b; }
-static int modI( int a, int b ) { return a % b; }
-static int orI( int a, int b ) { return a | b; }
-static int xorI( int a, int b ) { return a ^ b; }
-static int andI( int a, int b ) { return a & b; }
+			WRJitOp op;
+			wr_jitDecode( f.code + pos, op );
+			f.native[pos] = a.pos;
+			ok = jit.emit( f.code + pos, op, pos, f.depth[pos] );
+			fallsThrough = op.flow == WRJ_Next || op.flow == WRJ_Branch;
+		}
 
-static bool CompareGTI( int a, int b ) { return a > b; }
-static bool CompareLTI( int a, int b ) { return a < b; }
-static bool CompareANDI( int a, int b ) { return a && b; }
-static bool CompareORI( int a, int b ) { return a || b; }
+		// where an error returns to the interpreter
+		const int error = a.pos;
+		a.mov32( WRJ_RAX, 1 );
+		a.epilogue();
 
-static bool CompareLTF( float a, float b ) { return a < b; }
-static bool CompareGTF( float a, float b ) { return a > b; }
+		if ( ok && a.pos <= a.size && jit.fixups <= jit.maxFixups )
+		{
+			for( int i=0; i<jit.fixups; ++i )
+			{
+				a.patch( jit.fixupAt[i], jit.fixupTo[i] < 0 ? error : f.native[jit.fixupTo[i]] );
+			}
 
-bool CompareEQI( int a, int b ) { return a == b; }
-bool CompareEQF( float a, float b ) { return a == b; }
+			const int pageSize = 4096;
+			const uint32_t mapped = (uint32_t)((sizeof(WRJitCode) + a.pos + pageSize - 1) & ~(pageSize - 1));
+			void* block = mmap( 0, mapped, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0 );
+			if ( block != MAP_FAILED )
+			{
+				compiled = (WRJitCode*)block;
+				compiled->mapped = mapped;
+				compiled->maxDepth = (uint16_t)f.maxDepth;
+				memcpy( compiled + 1, a.code, a.pos );
+				if ( mprotect(block, mapped, PROT_READ | PROT_EXEC) )
+				{
+					munmap( block, mapped );
+					compiled = 0;
+				}
+			}
+		}
+	}
 
-static bool CompareBlankF( float a, float b ) { return false; }
-static float blankF( float a, float b ) { return 0; }
+	g_free( jit.fixupAt );
+	g_free( jit.slots );
+	g_free( jit.a.code );
 
-int32_t READ_32_FROM_PC_func( const unsigned char* P )
-{
-	return ( (((int32_t)*(P)) )
-			 | (((int32_t)*((P)+1)) << 8)
-			 | (((int32_t)*((P)+2)) << 16)
-			 | (((int32_t)*((P)+3)) << 24) );
+	function->jit = compiled;
+	return compiled != 0;
 }
 
-int16_t READ_16_FROM_PC_func( const unsigned char* P )
+//------------------------------------------------------------------------------
+static void wr_jitRelease( WRContext* context )
 {
-	return ( ((int16_t)*(P)) )
-			| ((int16_t)*(P+1) << 8 );
+	for( int i=0; i<context->numLocalFunctions; ++i )
+	{
+		if ( context->localFunctions[i].jit )
+		{
+			munmap( context->localFunctions[i].jit, context->localFunctions[i].jit->mapped );
+			context->localFunctions[i].jit = 0;
+		}
+	}
 }
 
 #endif
@@ -10895,6 +16294,17 @@ WRValue* wr_callFunction( WRContext* context, WRFunction* function, const WRValu
 		&&InitVar,
 
 		&&DebugInfo,
+
+		&&LiteralStringView,
+
+		&&BinaryAdditionNumeric,
+		&&BinarySubtractionNumeric,
+		&&BinaryMultiplicationNumeric,
+
+		&&RelativeJump32,
+
+#define WR_SUPER_LABEL( NAME, FIRST, SECOND_AS_PUSHED, SECOND ) &&NAME,
+		WRENCH_SUPERINSTRUCTIONS( WR_SUPER_LABEL )
 	};
 #endif
 
@@ -10960,6 +16370,10 @@ WRValue* wr_callFunction( WRContext* context, WRFunction* function, const WRValu
 
 	w->err = WR_ERR_None;
 
+#ifdef WRENCH_PROFILE_OPCODES
+	wr_profileEnter();
+#endif
+
 	WRValue* stackBase = context->stack + context->stackOffset;
 	WRValue* stackTop;
 #ifdef WRENCH_PROTECT_STACK_FROM_OVERFLOW
@@ -11023,6 +16437,7 @@ yieldContinue:
 
 	for(;;)
 	{
+		PROFILE_INSTRUCTION;
 		switch( READ_8_FROM_PC(pc++) )
 		{
 #endif
@@ -11049,6 +16464,30 @@ literalZero:
 				goto load32ToTemp;
 			}
 
+#ifdef WRENCH_DIRECT_CODE_READS
+			CASE(LiteralStringView):
+			{
+				// the literal is compared and dropped, point at it
+				// in place rather than allocating a copy
+				hash = (uint16_t)READ_16_FROM_PC(pc);
+				pc += 2;
+
+				register0 = stackTop++;
+				register0->va = context->literalViews + (context->literalView ^= 1);
+				register0->p2 = INIT_AS_ARRAY;
+				register0->va->m_type = SV_CHAR;
+				register0->va->m_skipGC = 1;
+				register0->va->m_size = hash;
+				register0->va->m_Cdata = (unsigned char*)pc;
+				register0->va->m_creatorContext = context;
+				pc += hash;
+
+				CHECK_STACK;
+				CONTINUE;
+			}
+#else
+			CASE(LiteralStringView):
+#endif
 			CASE(LiteralString):
 			{
 				hash = (uint16_t)READ_16_FROM_PC(pc);
@@ -11075,7 +16514,7 @@ literalZero:
 
 			CASE(LoadLibConstant):
 			{
-				*stackTop = *(w->globalRegistry.getAsRawValueHashTable(READ_32_FROM_PC(pc)));
+				*stackTop = *wr_linked( context, w->globalRegistry, READ_32_FROM_PC(pc) );
 
 				if ( (stackTop->p2 & INIT_AS_LIB_CONST) != INIT_AS_LIB_CONST )
 				{
@@ -11134,6 +16573,12 @@ debugReturn:
 					pc += 2;
 					goto doYield;
 				}
+#endif
+#ifdef WRENCH_SAMPLE_PROFILER
+				if ( (READ_16_FROM_PC(pc) & WRD_TypeMask) == WRD_LineNumber )
+				{
+					context->line = READ_16_FROM_PC(pc) & WRD_PayloadMask;
+				}
 #endif
 				pc += 2; // no debug code compiled in, just skip the directive
 				CONTINUE;
@@ -11148,7 +16593,7 @@ debugReturn:
 
 				uint32_t fhash = READ_32_FROM_PC(pc);
 				pc += 4;
-				if ( ! ((register1 = w->globalRegistry.getAsRawValueHashTable(fhash))->ccb) )
+				if ( ! ((register1 = wr_linked(context, w->globalRegistry, fhash))->ccb) )
 				{
 					if ( (import = context->imported) ) // check imported code
 					{
@@ -11228,7 +16673,7 @@ CallFunctionByHash_continue:
 
 				uint32_t fhash = READ_32_FROM_PC(pc);
 				pc += 4;
-				if ( !((register1 = w->globalRegistry.getAsRawValueHashTable(fhash))->ccb) )
+				if ( !((register1 = wr_linked(context, w->globalRegistry, fhash))->ccb) )
 				{
 					// is in an imported context
 					if ( (import = context->imported) )
@@ -11315,6 +16760,44 @@ callFunction:
 				frameBase = stackTop - function->frameBaseAdjustment;
 
 				CHECK_STACK;
+				CHECK_SAMPLE;
+
+#ifdef WRENCH_JIT
+				if ( function->jit
+					 || (function->jitCalls < WRENCH_JIT_THRESHOLD
+						 && ++function->jitCalls == WRENCH_JIT_THRESHOLD
+						 && wr_jitCompile(context, function)) )
+				{
+#ifdef WRENCH_PROTECT_STACK_FROM_OVERFLOW
+					if ( stackTop + function->jit->maxDepth < stackLimit )
+#endif
+					{
+						// runs the whole function, leaving the return
+						// value where O_Return expects it
+						if ( ((WRJitEntry)(void*)(function->jit + 1))(stackTop, frameBase, globalSpace, context) )
+						{
+							return 0;
+						}
+						++stackTop;
+						goto nativeReturn;
+					}
+				}
+#endif
+#ifdef WRENCH_AOT
+				if ( function->native
+#ifdef WRENCH_PROTECT_STACK_FROM_OVERFLOW
+					 && stackTop + function->native->maxDepth < stackLimit
+#endif
+				   )
+				{
+					if ( function->native->entry(stackTop, frameBase, globalSpace, context) )
+					{
+						return 0;
+					}
+					++stackTop;
+					goto nativeReturn;
+				}
+#endif
 				CONTINUE;
 			}
 
@@ -11332,7 +16815,7 @@ callFunction:
 
 				args = READ_8_FROM_PC(pc++); // which have already been pushed
 
-				if ( ! ((register1 = w->globalRegistry.getAsRawValueHashTable(READ_32_FROM_PC(pc)))->lcb) )
+				if ( ! ((register1 = wr_linked(context, w->globalRegistry, READ_32_FROM_PC(pc)))->lcb) )
 				{
 					w->err = WR_ERR_lib_function_not_found;
 					return 0;
@@ -11371,7 +16854,7 @@ callFunction:
 			{
 				args = READ_8_FROM_PC(pc++); // which have already been pushed
 
-				if ( ! ((register1 = w->globalRegistry.getAsRawValueHashTable(READ_32_FROM_PC(pc)))->lcb) )
+				if ( ! ((register1 = wr_linked(context, w->globalRegistry, READ_32_FROM_PC(pc)))->lcb) )
 				{
 					w->err = WR_ERR_lib_function_not_found;
 					return 0;
@@ -11553,6 +17036,9 @@ NewObjectTablePastLoad:
 			}
 			CASE(Return):
 			{
+#if defined(WRENCH_JIT) || defined(WRENCH_AOT)
+nativeReturn:
+#endif
 				register0 = stackTop - 2;
 
 				pc = context->bottom + register0->returnOffset; // grab return PC
@@ -11670,15 +17156,11 @@ hashIndexJump:
 					}
 #endif
 				}
-						
-#ifdef WRENCH_COMPACT
-				goto indexTempLiteralPostLoad;
-#else
+
 				stackTop->p2 = INIT_AS_INT;
-				wr_index[(WR_INT << 2) | register0->type](context, stackTop, register0, stackTop - 1);
+				wr_indexHashCached( context, pc, register0, stackTop, stackTop - 1 );
 				CHECK_STACK;
 				CONTINUE;
-#endif
 			}
 
 			CASE(StackSwap):
@@ -11767,6 +17249,13 @@ hashIndexJump:
 				FASTCONTINUE;
 			}
 
+			CASE(RelativeJump32):
+			{
+				pc += READ_32_FROM_PC(pc);
+				CHECK_FORCE_YIELD;
+				FASTCONTINUE;
+			}
+
 			CASE(BZ):
 			{
 				register0 = --stackTop;
@@ -12036,11 +17525,39 @@ NextIterator:
 			CASE(Switch):
 			{
 				hash = (--stackTop)->getHash(); // hash has been loaded
-				hashLoc = pc + 4 + 6*(hash % (uint16_t)READ_16_FROM_PC(pc)); // jump into the table
+				if ( READ_16_FROM_PC(pc) )
+				{
+					hashLoc = pc + 4 + 6*(hash % (uint16_t)READ_16_FROM_PC(pc)); // jump into the table
 
-				if ( (uint32_t)READ_32_FROM_PC(hashLoc) != hash )
+					if ( (uint32_t)READ_32_FROM_PC(hashLoc) != hash )
+					{
+						hashLoc = pc - 2; // nope, point it at default vector
+					}
+				}
+				else
 				{
-					hashLoc = pc - 2; // nope, point it at default vector
+					// a mod of 0: ints in order, halve the range until it is found
+					hashLoc = pc - 2;
+					int first = 0;
+					int last = READ_16_FROM_PC(pc + 4) - 1;
+					while( first <= last )
+					{
+						const int middle = (first + last) >> 1;
+						const unsigned char* entry = pc + 6 + 6*middle;
+						if ( READ_32_FROM_PC(entry) == (int32_t)hash )
+						{
+							hashLoc = entry;
+							break;
+						}
+						else if ( READ_32_FROM_PC(entry) < (int32_t)hash )
+						{
+							first = middle + 1;
+						}
+						else
+						{
+							last = middle - 1;
+						}
+					}
 				}
 
 				hashLoc += 4; // yup, point hashLoc to jump vector
@@ -12058,13 +17575,32 @@ NextIterator:
 					hashLoc = pc + (hashLocInt<<1) + 2; // jump to vector
 					pc += READ_16_FROM_PC( hashLoc ); // and read it
 				}
-				else
+				else if ( READ_8_FROM_PC(pc - 1) )
 				{
 					pc += READ_16_FROM_PC( pc );
 				}
+				else
+				{
+					// a size of 0: the table starts at the first case and
+					// is longer, both follow
+					hashLocInt -= (uint32_t)READ_32_FROM_PC( pc );
+					pc += 6;
+					if ( hashLocInt < (uint16_t)READ_16_FROM_PC(pc - 2) )
+					{
+						hashLoc = pc + (hashLocInt<<1) + 2;
+						pc += READ_16_FROM_PC( hashLoc );
+					}
+					else
+					{
+						pc += READ_16_FROM_PC( pc );
+					}
+				}
 				FASTCONTINUE;
 			}
 
+#define WR_SUPER_CASE( NAME, FIRST, SECOND_AS_PUSHED, SECOND ) CASE(NAME): { WR_SUPER_FIRST_##FIRST; WR_SUPER_SECOND(SECOND); }
+			WRENCH_SUPERINSTRUCTIONS( WR_SUPER_CASE )
+
 //-------------------------------------------------------------------------------------------------------------
 #ifdef WRENCH_COMPACT //---------------------------------------------------------------------------------------
 //-------------------------------------------------------------------------------------------------------------
@@ -12105,7 +17641,10 @@ targetFuncOpSkipLoadAndReg2:
 				CONTINUE;
 			}
 			
+			// compact builds are never quickened, the Numeric labels only keep the jumptable whole
+			CASE(BinaryMultiplicationNumeric):
 			CASE(BinaryMultiplication): { floatCall = multiplicationF; intCall = multiplicationI; goto targetFuncOp; }
+			CASE(BinarySubtractionNumeric):
 			CASE(BinarySubtraction): { floatCall = subtractionF; intCall = subtractionI; goto targetFuncOp; } 
 			CASE(BinaryDivision): { floatCall = divisionF; intCall = divisionI; goto targetFuncOp; }
 			CASE(BinaryRightShift): { floatCall = blankF; intCall = rightShiftI; goto targetFuncOp; }
@@ -12114,6 +17653,7 @@ targetFuncOpSkipLoadAndReg2:
 			CASE(BinaryOr): { floatCall = blankF; intCall = orI; goto targetFuncOp; }
 			CASE(BinaryXOR): { floatCall = blankF; intCall = xorI; goto targetFuncOp; }
 			CASE(BinaryAnd): { floatCall = blankF; intCall = andI; goto targetFuncOp; }
+			CASE(BinaryAdditionNumeric):
 			CASE(BinaryAddition):
 			{
 				floatCall = addF;
@@ -13341,8 +18881,8 @@ targetFuncOpSkipLoad:
 				CONTINUE;
 			}
 			
-			CASE(BinaryMultiplication): { targetFunc = wr_MultiplyBinary; goto targetFuncOp; }
-			CASE(BinarySubtraction): { targetFunc = wr_SubtractBinary; goto targetFuncOp; }
+			CASE(BinaryMultiplication): { QUICKEN( O_BinaryMultiplicationNumeric ); targetFunc = wr_MultiplyBinary; goto targetFuncOp; }
+			CASE(BinarySubtraction): { QUICKEN( O_BinarySubtractionNumeric ); targetFunc = wr_SubtractBinary; goto targetFuncOp; }
 			CASE(BinaryDivision): { targetFunc = wr_DivideBinary; goto targetFuncOp; }
 			CASE(BinaryRightShift): { targetFunc = wr_RightShiftBinary; goto targetFuncOp; }
 			CASE(BinaryLeftShift): { targetFunc = wr_LeftShiftBinary; goto targetFuncOp; }
@@ -13352,6 +18892,7 @@ targetFuncOpSkipLoad:
 			CASE(BinaryAnd): { targetFunc = wr_ANDBinary; goto targetFuncOp; }
 			CASE(BinaryAddition):
 			{
+				QUICKEN( O_BinaryAdditionNumeric );
 				targetFunc = wr_AdditionBinary;
 targetFuncOp:
 				register1 = --stackTop;
@@ -13359,6 +18900,74 @@ targetFuncOp:
 				targetFunc[(register1->type<<2)|register0->type]( register1, register0, register0 );
 				CONTINUE;
 			}
+
+			// quickened operations, int/int and float/float are done
+			// here, anything else puts the generic opcode back and
+			// runs it
+			CASE(BinaryAdditionNumeric):
+			{
+				register1 = stackTop - 1;
+				register0 = stackTop - 2;
+				if ( !(register1->type | register0->type) )
+				{
+					register0->i = register1->i + register0->i;
+					goto quickIntResult;
+				}
+				else if ( QUICK_FLOATS )
+				{
+					register0->f = register1->f + register0->f;
+					goto quickFloatResult;
+				}
+				targetFunc = wr_AdditionBinary;
+				hash = O_BinaryAddition;
+				goto quickDeoptimize;
+			}
+			
+			CASE(BinarySubtractionNumeric):
+			{
+				register1 = stackTop - 1;
+				register0 = stackTop - 2;
+				if ( !(register1->type | register0->type) )
+				{
+					register0->i = register1->i - register0->i;
+					goto quickIntResult;
+				}
+				else if ( QUICK_FLOATS )
+				{
+					register0->f = register1->f - register0->f;
+					goto quickFloatResult;
+				}
+				targetFunc = wr_SubtractBinary;
+				hash = O_BinarySubtraction;
+				goto quickDeoptimize;
+			}
+			
+			CASE(BinaryMultiplicationNumeric):
+			{
+				register1 = stackTop - 1;
+				register0 = stackTop - 2;
+				if ( !(register1->type | register0->type) )
+				{
+					register0->i = register1->i * register0->i;
+quickIntResult:
+					register0->p2 = INIT_AS_INT;
+					--stackTop;
+					CONTINUE;
+				}
+				else if ( QUICK_FLOATS )
+				{
+					register0->f = register1->f * register0->f;
+quickFloatResult:
+					register0->p2 = INIT_AS_FLOAT;
+					--stackTop;
+					CONTINUE;
+				}
+				targetFunc = wr_MultiplyBinary;
+				hash = O_BinaryMultiplication;
+quickDeoptimize:
+				*(unsigned char*)(pc - 1) = (unsigned char)hash;
+				goto targetFuncOp;
+			}
 			
 			CASE(SubtractAssign): { voidFunc = wr_SubtractAssign; goto binaryTableOp; }
 			CASE(AddAssign): { voidFunc = wr_AddAssign; goto binaryTableOp; }
@@ -13585,16 +19194,44 @@ WRState* wr_newState( int stackSize )
 #ifdef WRENCH_HANDLE_MALLOC_FAIL
 	if ( !w ) { return 0; }
 #endif
-																		   
-	memset( (unsigned char*)w, 0, sizeof(WRState) );
-
-	w->stackSize = stackSize;
-//	w->stack = (WRValue *)((unsigned char *)w + sizeof(WRState));
-
-	w->globalRegistry.init( 0, SV_VOID_HASH_TABLE, false );
+																		   
+	memset( (unsigned char*)w, 0, sizeof(WRState) );
+
+	w->stackSize = stackSize;
+//	w->stack = (WRValue *)((unsigned char *)w + sizeof(WRState));
+
+	w->globalRegistry.init( 0, SV_VOID_HASH_TABLE, false );
+
+	return w;
+}
+
+#ifdef WRENCH_AOT
+//------------------------------------------------------------------------------
+void wr_addNativeModule( WRState* w, const WRNativeModule* module )
+{
+	for( WRNativeModuleLink* link = w->nativeModules; link; link = link->next )
+	{
+		if ( link->module == module )
+		{
+			return;
+		}
+	}
+	
+	WRNativeModuleLink* link = (WRNativeModuleLink *)g_malloc(sizeof(WRNativeModuleLink));
+#ifdef WRENCH_HANDLE_MALLOC_FAIL
+	if ( !link )
+	{
+		g_mallocFailed = true;
+		w->err = WR_ERR_malloc_failed;
+		return;
+	}
+#endif
 
-	return w;
+	link->module = module;
+	link->next = w->nativeModules;
+	w->nativeModules = link;
 }
+#endif
 
 //------------------------------------------------------------------------------
 void wr_destroyState( WRState* w )
@@ -13614,6 +19251,19 @@ void wr_destroyState( WRState* w )
 
 	w->globalRegistry.clear();
 
+#ifdef WRENCH_AOT
+	while( w->nativeModules )
+	{
+		WRNativeModuleLink* next = w->nativeModules->next;
+		g_free( w->nativeModules );
+		w->nativeModules = next;
+	}
+#endif
+
+#ifdef WRENCH_SAMPLE_PROFILER
+	wr_sampleStop( w );
+#endif
+
 	g_free( w );
 }
 
@@ -13741,6 +19391,22 @@ WRContext* wr_createContext( WRState* w, const unsigned char* block, const int b
 		C->registry.getAsRawValueHashTable(C->localFunctions[i].hash)->wrf = C->localFunctions + i;
 	}
 
+#ifdef WRENCH_AOT
+	// translated from this very bytecode?
+	for( WRNativeModuleLink* link = w->nativeModules; link; link = link->next )
+	{
+		const WRNativeModule* module = link->module;
+		if ( module->crc == hash && module->count == C->numLocalFunctions )
+		{
+			for( int i=0; i<C->numLocalFunctions; ++i )
+			{
+				C->localFunctions[i].native = module->functions[i].entry ? module->functions + i : 0;
+			}
+			break;
+		}
+	}
+#endif
+
 	return C;
 }
 
@@ -13822,6 +19488,10 @@ WRContext* wr_run( WRState* w, const unsigned char* block, const int blockSize,
 //------------------------------------------------------------------------------
 void wr_destroyContextEx( WRContext* context )
 {
+#ifdef WRENCH_SAMPLE_PROFILER
+	wr_sampleForgetContext( context );
+#endif
+
 	// g_free all memory allocations by forcing the gc to collect everything
 	context->globals = 0;
 	context->allocatedMemoryHint = context->allocatedMemoryLimit;
@@ -13829,6 +19499,10 @@ void wr_destroyContextEx( WRContext* context )
 
 	context->registry.clear();
 
+#ifdef WRENCH_JIT
+	wr_jitRelease( context );
+#endif
+
 	if ( context->flags & WRC_OwnsMemory )
 	{
 		g_free( (void*)(context->bottom) );
@@ -13885,7 +19559,11 @@ bool wr_runCommand( WRState* w, const char* sourceCode, const int size )
 
 	unsigned char* outBytes;
 	int outLen;
+#ifdef WRENCH_COMPILE_CACHE
+	if ( !wr_compileCached(sourceCode, len, &outBytes, &outLen) )
+#else
 	if ( !wr_compile(sourceCode, len, &outBytes, &outLen) )
+#endif
 	{
 		wr_runOnce( w, outBytes, outLen );
 		g_free( outBytes );
@@ -14942,6 +20620,17 @@ const char* c_opcodeName[] =
 	"InitVar",
 
 	"DebugInfo",
+
+	"LiteralStringView",
+
+	"BinaryAdditionNumeric",
+	"BinarySubtractionNumeric",
+	"BinaryMultiplicationNumeric",
+
+	"RelativeJump32",
+
+#define WR_SUPER_NAME( NAME, FIRST, SECOND_AS_PUSHED, SECOND ) #NAME,
+	WRENCH_SUPERINSTRUCTIONS( WR_SUPER_NAME )
 };
 
 //------------------------------------------------------------------------------
@@ -15730,118 +21419,751 @@ Copyright (c) 2023 Curt Hartung -- curt.hartung@gmail.com
 
 MIT Licence
 
-Permission is hereby granted, free of charge, to any person obtaining a copy
-of this software and associated documentation files (the "Software"), to deal
-in the Software without restriction, including without limitation the rights
-to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
-copies of the Software, and to permit persons to whom the Software is
-furnished to do so, subject to the following conditions:
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*******************************************************************************/
+
+#include "wrench.h"
+
+#ifdef WRENCH_INCLUDE_DEBUG_CODE
+
+//------------------------------------------------------------------------------
+WRDebugServerInterface::WRDebugServerInterface( WRState* w )
+{
+	memset( this, 0, sizeof(*this) );
+	I = (WRDebugServerInterfacePrivate *)g_malloc( sizeof(WRDebugServerInterfacePrivate) );
+	new (I) WRDebugServerInterfacePrivate( this );
+
+	I->m_w = w;
+}
+
+//------------------------------------------------------------------------------
+WRDebugServerInterface::WRDebugServerInterface( WRState* w,
+												bool (*receiveFunction)( char* data, const int length ),
+												bool (*sendFunction)( const char* data, const int length ),
+												int (*dataAvailableFunction)() )
+{
+	memset( this, 0, sizeof(*this) );
+	I = (WRDebugServerInterfacePrivate *)g_malloc( sizeof(WRDebugServerInterfacePrivate) );
+	new (I) WRDebugServerInterfacePrivate( this );
+
+	I->m_w = w;
+
+	I->m_receiveFunction = receiveFunction;
+	I->m_sendFunction = sendFunction;
+	I->m_dataAvailableFunction = dataAvailableFunction;
+}
+
+//------------------------------------------------------------------------------
+WRDebugServerInterface::~WRDebugServerInterface()
+{
+	I->~WRDebugServerInterfacePrivate();
+	g_free( I );
+}
+
+#endif
+/*******************************************************************************
+Copyright (c) 2022 Curt Hartung -- curt.hartung@gmail.com
+
+MIT Licence
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*******************************************************************************/
+
+#include "wrench.h"
+
+WRContext* wr_import( WRContext* context, const unsigned char* block, const int blockSize, bool takeOwnership );
+
+#ifdef WRENCH_PROFILE_OPCODES
+const WRProfileSite* wr_profileSites();
+
+//------------------------------------------------------------------------------
+// the executed locations of this bytecode in address order, only matches
+// if it is the very block that was run (the VM does not copy it)
+static void wr_profileAnnotate( WRstr& listing, WRContext* context, const uint8_t* bytecode, const unsigned int len )
+{
+	const WRProfileSite* sites = wr_profileSites();
+
+	listing.appendFormat( "profile:\n" );
+	const uint8_t* from = bytecode;
+	for(;;)
+	{
+		// next executed location at or above 'from'
+		const WRProfileSite* next = 0;
+		for( int i=0; i<WRENCH_PROFILE_SITES; ++i )
+		{
+			if ( sites[i].pc >= from
+				 && sites[i].pc < bytecode + len
+				 && (!next || sites[i].pc < next->pc) )
+			{
+				next = sites + i;
+			}
+		}
+		if ( !next )
+		{
+			break;
+		}
+
+		const unsigned int offset = (unsigned int)(next->pc - bytecode);
+		int unit = 0; // unit 0 is the global code, the functions follow it
+		for( int i=0; i<context->numLocalFunctions; ++i )
+		{
+			if ( context->localFunctions[i].functionOffset <= offset )
+			{
+				unit = i + 1;
+			}
+		}
+
+		listing.appendFormat( "0x%04X unit %-3d %-36s %12llu %14llu\n",
+							  offset,
+							  unit,
+							  wr_profileOpcodeName(READ_8_FROM_PC(next->pc)),
+							  (unsigned long long)next->counter.count,
+							  (unsigned long long)next->counter.ticks );
+		from = next->pc + 1;
+	}
+}
+#endif
+
+//------------------------------------------------------------------------------
+void wr_disassemble( const uint8_t* bytecode, const unsigned int len, char** out, unsigned int* outLen )
+{
+	WRstr listing;
+	
+	WRState* w = wr_newState();
+	
+	WRContext* context = wr_createContext( w, bytecode, len, false );
+	if ( !context )
+	{
+		listing = "err: context failed\n";
+	}
+
+	else
+	{
+		listing.format( "%d globals\n", context->globals );
+		listing.appendFormat( "%d units\n", context->numLocalFunctions );
+		for( int i=0; i<context->numLocalFunctions; ++i )
+		{
+			listing.appendFormat( "unit %d[0x%08X] offset[0x%04X] arguments[%d]\n",
+								  i,
+								  context->localFunctions[i].hash,
+								  context->localFunctions[i].functionOffset,
+								  context->localFunctions[i].arguments );
+		}
+
+#ifdef WRENCH_PROFILE_OPCODES
+		wr_profileAnnotate( listing, context, bytecode, len );
+#endif
+	}
+
+	listing.release( out, outLen );
+}
+
+#ifndef WRENCH_WITHOUT_COMPILER
+//------------------------------------------------------------------------------
+// one operand of a translated opcode, as C++
+struct WRAotOperand
+{
+	char arg[24]; // what the operation tables are passed
+	char value[24]; // where the int or float is, when it is one
+	int type; // WR_INT or WR_FLOAT when it is known, -1 when it is checked
+};
+
+//------------------------------------------------------------------------------
+// writes the C++ of one function for wr_translate(), the same
+// translation WRJit does into machine code
+struct WRAot
+{
+	WRstr* out;
+	WRJitSlot* slots;
+	int cases; // of the operation being written
+	bool usesFrame;
+	bool usesGlobals;
+	bool usesContext;
+
+	WRAotOperand slot( const int s )
+	{
+		WRAotOperand o;
+		snprintf( o.arg, sizeof(o.arg), "s[%d]", s );
+		snprintf( o.value, sizeof(o.value), "s[%d]", s );
+		o.type = -1;
+		switch( slots[s].kind )
+		{
+			case WRJ_Int: o.type = WR_INT; break;
+			case WRJ_Float: o.type = WR_FLOAT; break;
+			case WRJ_Local: snprintf( o.value, sizeof(o.value), "frameBase[%d]", slots[s].index ); usesFrame = true; break;
+			case WRJ_Global: snprintf( o.value, sizeof(o.value), "globalSpace[%d]", slots[s].index ); usesGlobals = true; break;
+			default: break;
+		}
+		return o;
+	}
+
+	// a local or global the opcode names
+	WRAotOperand value( const bool local, const int index )
+	{
+		WRAotOperand o;
+		snprintf( o.arg, sizeof(o.arg), "%s[%d]", local ? "frameBase" : "globalSpace", index );
+		memcpy( o.value, o.arg, sizeof(o.value) );
+		o.type = -1;
+		usesFrame |= local;
+		usesGlobals |= !local;
+		return o;
+	}
+
+	static bool maybe( const WRAotOperand& o, const int type ) { return o.type < 0 || o.type == type; }
+
+	bool inlineCase( const WRAotOperand& x, const WRAotOperand& y, const char* check, const char* code, ... );
+	void tableCase( const char* code, ... );
+
+	void binary( const int math, const WRAotOperand& T, const WRAotOperand& S, const char* target );
+	void assign( const int math, const WRAotOperand& T, const WRAotOperand& S );
+	void branch( const int compare, const bool when, const WRAotOperand& X, const WRAotOperand& Y, const int target );
+	void emit( const unsigned char* pc, const WRJitOp& op, const int pos, const int depth );
+};
+
+static const char* const wr_aotOperators[] = { "+", "-", "*", "/", "%", "<<", ">>", "&", "|", "^", "=" };
+static const char* const wr_aotBinary[] =
+{
+	"wr_AdditionBinary", "wr_SubtractBinary", "wr_MultiplyBinary", "wr_DivideBinary", "wr_ModBinary",
+	"wr_LeftShiftBinary", "wr_RightShiftBinary", "wr_ANDBinary", "wr_ORBinary", "wr_XORBinary",
+};
+static const char* const wr_aotAssign[] =
+{
+	"wr_AddAssign", "wr_SubtractAssign", "wr_MultiplyAssign", "wr_DivideAssign", "wr_ModAssign",
+	"wr_LeftShiftAssign", "wr_RightShiftAssign", "wr_ANDAssign", "wr_ORAssign", "wr_XORAssign", "wr_assign",
+};
+static const char* const wr_aotCompare[] = { "wr_CompareEQ", "wr_CompareLT", "wr_CompareGT" };
+static const char* const wr_aotCompareOperators[] = { "==", "<", ">" };
+
+//------------------------------------------------------------------------------
+// the case of an operation for operands passing 'check' (" == WR_INT"
+// and such), false when it needs no check and is the last one
+bool WRAot::inlineCase( const WRAotOperand& x, const WRAotOperand& y, const char* check, const char* code, ... )
+{
+	const bool checkX = x.type < 0;
+	const bool checkY = y.type < 0;
+	
+	out->appendFormat( "\t%s", cases++ ? "else " : "" );
+	if ( checkX && checkY )
+	{
+		out->appendFormat( "if ( %s.type%s && %s.type%s ) ", x.value, check, y.value, check );
+	}
+	else if ( checkX || checkY )
+	{
+		out->appendFormat( "if ( %s.type%s ) ", checkX ? x.value : y.value, check );
+	}
+
+	va_list arg;
+	va_start( arg, code );
+	*out += "{ ";
+	out->appendFormatVA( code, arg );
+	*out += " }\n";
+	va_end( arg );
+
+	return checkX || checkY;
+}
+
+//------------------------------------------------------------------------------
+// the last case, through the operation table
+void WRAot::tableCase( const char* code, ... )
+{
+	out->appendFormat( "\t%s{ ", cases ? "else " : "" );
+	va_list arg;
+	va_start( arg, code );
+	out->appendFormatVA( code, arg );
+	va_end( arg );
+	*out += " }\n";
+}
+
+//------------------------------------------------------------------------------
+// target = T 'math' S, as wr_<math>Binary does it
+void WRAot::binary( const int math, const WRAotOperand& T, const WRAotOperand& S, const char* target )
+{
+	const char* o = wr_aotOperators[math];
+	cases = 0;
+	if ( math != WRJ_Div && math != WRJ_Mod && maybe(T, WR_INT) && maybe(S, WR_INT)
+		 && !inlineCase(T, S, " == WR_INT", "%s.p2 = WR_INT; %s.i = %s.i %s %s.i;", target, target, T.value, o, S.value) )
+	{
+		return;
+	}
+	if ( math <= WRJ_Div && maybe(T, WR_FLOAT) && maybe(S, WR_FLOAT)
+		 && !inlineCase(T, S, " == WR_FLOAT", "%s.p2 = WR_FLOAT; %s.f = %s.f %s %s.f;", target, target, T.value, o, S.value) )
+	{
+		return;
+	}
+	tableCase( "%s[(%s.type<<2)|%s.type]( &%s, &%s, &%s );", wr_aotBinary[math], T.arg, S.arg, T.arg, S.arg, target );
+}
+
+//------------------------------------------------------------------------------
+// T 'math'= S, as wr_<math>Assign does it
+void WRAot::assign( const int math, const WRAotOperand& T, const WRAotOperand& S )
+{
+	const char* o = wr_aotOperators[math];
+	cases = 0;
+	if ( math == WRJ_Assign )
+	{
+		if ( !inlineCase(T, S, " <= WR_FLOAT", "%s = %s;", T.value, S.value) )
+		{
+			return;
+		}
+	}
+	else if ( math != WRJ_Div && math != WRJ_Mod && maybe(T, WR_INT) && maybe(S, WR_INT)
+			  && !inlineCase(T, S, " == WR_INT", "%s.i %s= %s.i;", T.value, o, S.value) )
+	{
+		return;
+	}
+	if ( math <= WRJ_Div && maybe(T, WR_FLOAT) && maybe(S, WR_FLOAT)
+		 && !inlineCase(T, S, " == WR_FLOAT", "%s.f %s= %s.f;", T.value, o, S.value) )
+	{
+		return;
+	}
+	tableCase( "%s[(%s.type<<2)|%s.type]( &%s, &%s );", wr_aotAssign[math], T.arg, S.arg, T.arg, S.arg );
+}
+
+//------------------------------------------------------------------------------
+// goto 'target' when X 'compare' Y is 'when'
+void WRAot::branch( const int compare, const bool when, const WRAotOperand& X, const WRAotOperand& Y, const int target )
+{
+	const char* o = wr_aotCompareOperators[compare];
+	const char* n = when ? "" : "!";
+	cases = 0;
+	if ( maybe(X, WR_INT) && maybe(Y, WR_INT)
+		 && !inlineCase(X, Y, " == WR_INT", "if ( %s(%s.i %s %s.i) ) goto L%d;", n, X.value, o, Y.value, target) )
+	{
+		return;
+	}
+	if ( maybe(X, WR_FLOAT) && maybe(Y, WR_FLOAT)
+		 && !inlineCase(X, Y, " == WR_FLOAT", "if ( %s(%s.f %s %s.f) ) goto L%d;", n, X.value, o, Y.value, target) )
+	{
+		return;
+	}
+	tableCase( "if ( %s%s[(%s.type<<2)|%s.type]( &%s, &%s ) ) goto L%d;", n, wr_aotCompare[compare], X.arg, Y.arg, X.arg, Y.arg, target );
+}
+
+//------------------------------------------------------------------------------
+void WRAot::emit( const unsigned char* pc, const WRJitOp& op, const int pos, const int depth )
+{
+	const int top = depth - 1;
+	const int k = READ_8_FROM_PC(pc + 1);
+	int result = -1; // kind of the pushed value
+
+	switch( op.opcode )
+	{
+		case O_LiteralZero:
+		{
+			out->appendFormat( "\ts[%d].p = 0; s[%d].p2 = WR_INT;\n", depth, depth );
+			result = WRJ_Int;
+			break;
+		}
+
+		case O_LiteralInt8:
+		case O_LiteralInt16:
+		case O_LiteralInt32:
+		{
+			out->appendFormat( "\ts[%d].i = %d; s[%d].p2 = WR_INT;\n",
+							   depth,
+							   op.opcode == O_LiteralInt8 ? (int32_t)(int8_t)k
+							   : op.opcode == O_LiteralInt16 ? (int32_t)READ_16_FROM_PC(pc + 1)
+							   : READ_32_FROM_PC(pc + 1),
+							   depth );
+			result = WRJ_Int;
+			break;
+		}
+
+		case O_LiteralFloat:
+		{
+			WRValue f;
+			f.i = READ_32_FROM_PC(pc + 1);
+			out->appendFormat( "\ts[%d].ui = 0x%08Xu; s[%d].p2 = WR_FLOAT; // %g\n", depth, f.ui, depth, f.f );
+			result = WRJ_Float;
+			break;
+		}
 
-The above copyright notice and this permission notice shall be included in all
-copies or substantial portions of the Software.
+		case O_LoadFromLocal:
+		case O_LoadFromGlobal:
+		{
+			const bool local = op.opcode == O_LoadFromLocal;
+			out->appendFormat( "\ts[%d].p = %s + %d; s[%d].p2 = WR_REF;\n", depth, local ? "frameBase" : "globalSpace", k, depth );
+			usesFrame |= local;
+			usesGlobals |= !local;
+			slots[depth].kind = local ? WRJ_Local : WRJ_Global;
+			slots[depth].index = (uint8_t)k;
+			break;
+		}
 
-THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
-IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
-FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
-AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
-LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
-OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
-SOFTWARE.
-*******************************************************************************/
+		case O_LiteralInt8ToLocal:
+		case O_LiteralInt8ToGlobal:
+		case O_LiteralInt16ToLocal:
+		case O_LiteralInt16ToGlobal:
+		case O_LiteralInt32ToLocal:
+		case O_LiteralInt32ToGlobal:
+		case O_LiteralFloatToLocal:
+		case O_LiteralFloatToGlobal:
+		{
+			const WRAotOperand V = value( op.opcode == O_LiteralInt8ToLocal || op.opcode == O_LiteralInt16ToLocal
+										  || op.opcode == O_LiteralInt32ToLocal || op.opcode == O_LiteralFloatToLocal, k );
+			const int32_t literal = op.length == 3 ? (int32_t)(int8_t)READ_8_FROM_PC(pc + 2)
+									: op.length == 4 ? (int32_t)READ_16_FROM_PC(pc + 2)
+									: READ_32_FROM_PC(pc + 2);
+			if ( op.opcode == O_LiteralFloatToLocal || op.opcode == O_LiteralFloatToGlobal )
+			{
+				WRValue f;
+				f.i = literal;
+				out->appendFormat( "\t%s.ui = 0x%08Xu; %s.p2 = WR_FLOAT; // %g\n", V.value, f.ui, V.value, f.f );
+			}
+			else
+			{
+				out->appendFormat( "\t%s.i = %d; %s.p2 = WR_INT;\n", V.value, literal, V.value );
+			}
+			break;
+		}
 
-#include "wrench.h"
+		case O_PopOne: break;
 
-#ifdef WRENCH_INCLUDE_DEBUG_CODE
+		case O_StackSwap:
+		case O_SwapTwoToTop:
+		{
+			// the second swaps the entry under the top
+			for( int pair=0; pair<(op.opcode == O_StackSwap ? 1 : 2); ++pair )
+			{
+				const int at = top - pair;
+				const int other = depth - READ_8_FROM_PC(pc + 1 + pair);
+				out->appendFormat( "\t{ WRValue v; v = s[%d]; s[%d] = s[%d]; s[%d] = v; }\n", at, at, other, other );
+				const WRJitSlot swap = slots[at];
+				slots[at] = slots[other];
+				slots[other] = swap;
+			}
+			break;
+		}
 
-//------------------------------------------------------------------------------
-WRDebugServerInterface::WRDebugServerInterface( WRState* w )
-{
-	memset( this, 0, sizeof(*this) );
-	I = (WRDebugServerInterfacePrivate *)g_malloc( sizeof(WRDebugServerInterfacePrivate) );
-	new (I) WRDebugServerInterfacePrivate( this );
+		case O_ToInt:
+		case O_ToFloat:
+		{
+			result = op.opcode == O_ToInt ? WRJ_Int : WRJ_Float;
+			if ( slots[top].kind != result )
+			{
+				out->appendFormat( op.opcode == O_ToInt ? "\ts[%d].i = s[%d].asInt(); s[%d].p2 = WR_INT;\n"
+														: "\ts[%d].f = s[%d].asFloat(); s[%d].p2 = WR_FLOAT;\n",
+								   top, top, top );
+			}
+			break;
+		}
 
-	I->m_w = w;
-}
+		case O_IncLocal:
+		case O_DecLocal:
+		case O_IncGlobal:
+		case O_DecGlobal:
+		{
+			const WRAotOperand V = value( op.opcode == O_IncLocal || op.opcode == O_DecLocal, k );
+			const bool inc = op.opcode == O_IncLocal || op.opcode == O_IncGlobal;
+			out->appendFormat( "\tif ( %s.type == WR_INT ) { %s%s.i; } else { %s[%s.type]( &%s ); }\n",
+							   V.value, inc ? "++" : "--", V.value, inc ? "wr_preinc" : "wr_predec", V.value, V.value );
+			break;
+		}
 
-//------------------------------------------------------------------------------
-WRDebugServerInterface::WRDebugServerInterface( WRState* w,
-												bool (*receiveFunction)( char* data, const int length ),
-												bool (*sendFunction)( const char* data, const int length ),
-												int (*dataAvailableFunction)() )
-{
-	memset( this, 0, sizeof(*this) );
-	I = (WRDebugServerInterfacePrivate *)g_malloc( sizeof(WRDebugServerInterfacePrivate) );
-	new (I) WRDebugServerInterfacePrivate( this );
+		case O_BinaryAddition:
+		case O_BinarySubtraction:
+		case O_BinaryMultiplication:
+		case O_BinaryDivision:
+		case O_BinaryMod:
+		case O_BinaryLeftShift:
+		case O_BinaryRightShift:
+		case O_BinaryAnd:
+		case O_BinaryOr:
+		case O_BinaryXOR:
+		case O_GGBinaryAddition:
+		case O_GLBinaryAddition:
+		case O_LLBinaryAddition:
+		case O_GGBinarySubtraction:
+		case O_GLBinarySubtraction:
+		case O_LGBinarySubtraction:
+		case O_LLBinarySubtraction:
+		case O_GGBinaryMultiplication:
+		case O_GLBinaryMultiplication:
+		case O_LLBinaryMultiplication:
+		case O_GGBinaryDivision:
+		case O_GLBinaryDivision:
+		case O_LGBinaryDivision:
+		case O_LLBinaryDivision:
+		{
+			WRAotOperand T, S;
+			int target;
+			if ( op.length == 1 )
+			{
+				T = slot( top );
+				S = slot( top - 1 );
+				target = top - 1;
+			}
+			else
+			{
+				bool localT, localS;
+				wr_jitBinarySpaces( op.opcode, localT, localS );
+				T = value( localT, READ_8_FROM_PC(pc + 2) );
+				S = value( localS, k );
+				target = depth;
+			}
 
-	I->m_w = w;
+			char t[24];
+			snprintf( t, sizeof(t), "s[%d]", target );
+			binary( op.math, T, S, t );
+			slots[target].kind = (T.type == WR_INT && S.type == WR_INT) ? WRJ_Int
+								 : (T.type == WR_FLOAT && S.type == WR_FLOAT && op.math <= WRJ_Div) ? WRJ_Float
+								 : WRJ_Unknown;
+			break;
+		}
 
-	I->m_receiveFunction = receiveFunction;
-	I->m_sendFunction = sendFunction;
-	I->m_dataAvailableFunction = dataAvailableFunction;
-}
+		case O_BinaryAdditionAndStoreLocal:
+		case O_BinarySubtractionAndStoreLocal:
+		case O_BinaryMultiplicationAndStoreLocal:
+		case O_BinaryDivisionAndStoreLocal:
+		case O_BinaryAdditionAndStoreGlobal:
+		case O_BinarySubtractionAndStoreGlobal:
+		case O_BinaryMultiplicationAndStoreGlobal:
+		case O_BinaryDivisionAndStoreGlobal:
+		{
+			const WRAotOperand V = value( op.opcode == O_BinaryAdditionAndStoreLocal || op.opcode == O_BinarySubtractionAndStoreLocal
+										  || op.opcode == O_BinaryMultiplicationAndStoreLocal || op.opcode == O_BinaryDivisionAndStoreLocal, k );
+			binary( op.math, slot(top), slot(top - 1), V.value );
+			break;
+		}
 
-//------------------------------------------------------------------------------
-WRDebugServerInterface::~WRDebugServerInterface()
-{
-	I->~WRDebugServerInterfacePrivate();
-	g_free( I );
-}
+		case O_AddAssignAndPop:
+		case O_SubtractAssignAndPop:
+		case O_MultiplyAssignAndPop:
+		case O_DivideAssignAndPop:
+		case O_ModAssignAndPop:
+		case O_LeftShiftAssignAndPop:
+		case O_RightShiftAssignAndPop:
+		case O_ANDAssignAndPop:
+		case O_ORAssignAndPop:
+		case O_XORAssignAndPop:
+		case O_AssignAndPop:
+		{
+			assign( op.math, slot(top), slot(top - 1) );
+			break;
+		}
 
-#endif
-/*******************************************************************************
-Copyright (c) 2022 Curt Hartung -- curt.hartung@gmail.com
+		case O_AssignToLocalAndPop: assign( WRJ_Assign, value(true, k), slot(top) ); break;
+		case O_AssignToGlobalAndPop: assign( WRJ_Assign, value(false, k), slot(top) ); break;
 
-MIT Licence
+		case O_CallLibFunction:
+		case O_CallLibFunctionAndPop:
+		{
+			out->appendFormat( "\tif ( wr_nativeCallLib(context, s + %d, %d, 0x%08Xu, %d) ) { return 1; }\n",
+							   depth, k, (uint32_t)READ_32_FROM_PC(pc + 2), op.opcode == O_CallLibFunctionAndPop );
+			usesContext = true;
+			if ( op.pushes )
+			{
+				slots[depth - op.pops].kind = WRJ_Unknown;
+			}
+			break;
+		}
 
-Permission is hereby granted, free of charge, to any person obtaining a copy
-of this software and associated documentation files (the "Software"), to deal
-in the Software without restriction, including without limitation the rights
-to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
-copies of the Software, and to permit persons to whom the Software is
-furnished to do so, subject to the following conditions:
+		case O_ReturnZero: *out += "\ts[0].init();\n"; // fall through
+		case O_Return: *out += "\treturn 0;\n"; break;
 
-The above copyright notice and this permission notice shall be included in all
-copies or substantial portions of the Software.
+		case O_RelativeJump:
+		case O_RelativeJump8:
+		case O_RelativeJump32:
+		{
+			out->appendFormat( "\tgoto L%d;\n", pos + op.target );
+			break;
+		}
 
-THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
-IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
-FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
-AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
-LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
-OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
-SOFTWARE.
-*******************************************************************************/
+		case O_BZ:
+		case O_BZ8:
+		{
+			// ints and floats are zero when all their bits are
+			const WRAotOperand Y = slot( top );
+			cases = 0;
+			if ( inlineCase(Y, Y, " <= WR_FLOAT", "if ( !%s.i ) goto L%d;", Y.value, pos + op.target) )
+			{
+				tableCase( "if ( wr_LogicalNot[%s.type]( &%s ) ) goto L%d;", Y.arg, Y.arg, pos + op.target );
+			}
+			break;
+		}
 
-#include "wrench.h"
+		default:
+		{
+			const int to = pos + op.target;
+			switch( op.form )
+			{
+				case WRJ_TwoStack: branch( op.compare, op.when, slot(top), slot(top - 1), to ); break;
+				case WRJ_LocalStack: branch( op.compare, op.when, value(true, k), slot(top), to ); break;
+				case WRJ_GlobalStack: branch( op.compare, op.when, value(false, k), slot(top), to ); break;
+				case WRJ_TwoLocal: branch( op.compare, op.when, value(true, READ_8_FROM_PC(pc + 2)), value(true, k), to ); break;
+				default: branch( op.compare, op.when, value(false, READ_8_FROM_PC(pc + 2)), value(false, k), to ); break;
+			}
+			break;
+		}
+	}
 
-WRContext* wr_import( WRContext* context, const unsigned char* block, const int blockSize, bool takeOwnership );
+	if ( result >= 0 )
+	{
+		slots[depth - op.pops].kind = (uint8_t)result;
+	}
+}
 
 //------------------------------------------------------------------------------
-void wr_disassemble( const uint8_t* bytecode, const unsigned int len, char** out, unsigned int* outLen )
+void wr_translate( const uint8_t* bytecode, const unsigned int len, const char* name, char** out, unsigned int* outLen )
 {
-	WRstr listing;
-	
+	WRstr source;
 	WRState* w = wr_newState();
-	
 	WRContext* context = wr_createContext( w, bytecode, len, false );
 	if ( !context )
 	{
-		listing = "err: context failed\n";
+		source = "#error bad bytecode\n";
+		wr_destroyState( w );
+		source.release( out, outLen );
+		return;
 	}
 
-	listing.format( "%d globals\n", context->globals );
-	listing.appendFormat( "%d units\n", context->numLocalFunctions );
-	for( int i=0; i<context->numLocalFunctions; ++i )
+	const uint32_t crc = READ_32_FROM_PC( bytecode + len - 4 );
+	source.format( "// Generated by wr_translate() from wrench bytecode with CRC 0x%08X.\n"
+				   "// Built next to wrench.cpp with WRENCH_AOT defined, contexts created from\n"
+				   "// %s_bytecode run these functions natively once wr_addNativeModule( w, &%s )\n"
+				   "// is called\n"
+				   "#include \"wrench.h\"\n"
+				   "\n"
+				   "#ifdef WRENCH_AOT\n"
+				   "\n"
+				   "typedef void (*WRVoidFunc)( WRValue* to, WRValue* from );\n"
+				   "typedef void (*WRTargetFunc)( WRValue* to, WRValue* from, WRValue* target );\n"
+				   "typedef bool (*WRReturnFunc)( WRValue* to, WRValue* from );\n"
+				   "typedef void (*WRUnaryFunc)( WRValue* value );\n"
+				   "typedef bool (*WRReturnSingleFunc)( WRValue* value );\n",
+				   crc, name, name );
+	for( int i=0; i<WRJ_Assign; ++i )
+	{
+		source.appendFormat( "extern WRTargetFunc %s[16];\n", wr_aotBinary[i] );
+	}
+	for( int i=0; i<=WRJ_Assign; ++i )
+	{
+		source.appendFormat( "extern WRVoidFunc %s[16];\n", wr_aotAssign[i] );
+	}
+	for( int i=0; i<=WRJ_GT; ++i )
 	{
-		listing.appendFormat( "unit %d[0x%08X] offset[0x%04X] arguments[%d]\n",
-							  i,
-							  context->localFunctions[i].hash,
-							  context->localFunctions[i].functionOffset,
-							  context->localFunctions[i].arguments );
+		source.appendFormat( "extern WRReturnFunc %s[16];\n", wr_aotCompare[i] );
 	}
+	source += "extern WRUnaryFunc wr_preinc[4];\n"
+			  "extern WRUnaryFunc wr_predec[4];\n"
+			  "extern WRReturnSingleFunc wr_LogicalNot[4];\n";
 
-	listing.release( out, outLen );
+	WRstr table;
+	for( int f=0; f<context->numLocalFunctions; ++f )
+	{
+		const WRFunction& wrf = context->localFunctions[f];
+		WRJitFunction function;
+		WRAot aot;
+		aot.slots = 0;
+		if ( !function.analyze(bytecode, len, wrf.functionOffset)
+			 || !(aot.slots = (WRJitSlot*)g_malloc((function.maxDepth + 1) * sizeof(WRJitSlot))) )
+		{
+			table.appendFormat( "\t{ 0, 0 }, // 0x%08X left to the interpreter\n", wrf.hash );
+			continue;
+		}
+
+		// in address order, so falling through is falling through
+		WRstr body;
+		aot.out = &body;
+		aot.usesFrame = aot.usesGlobals = aot.usesContext = false;
+		bool fallsThrough = false;
+		for( int pos=0; pos<function.limit; ++pos )
+		{
+			if ( !(function.flags[pos] & WRJ_Start) )
+			{
+				continue;
+			}
+
+			if ( function.flags[pos] & WRJ_Target )
+			{
+				body.appendFormat( "L%d:\n", pos );
+			}
+			if ( (function.flags[pos] & WRJ_Target) || !fallsThrough )
+			{
+				for( int s=0; s<=function.maxDepth; ++s )
+				{
+					aot.slots[s].kind = WRJ_Unknown;
+				}
+			}
+
+			WRJitOp op;
+			wr_jitDecode( function.code + pos, op );
+			aot.emit( function.code + pos, op, pos, function.depth[pos] );
+			fallsThrough = op.flow == WRJ_Next || op.flow == WRJ_Branch;
+		}
+		g_free( aot.slots );
+
+		source.appendFormat( "\n"
+							 "//------------------------------------------------------------------------------\n"
+							 "static int %s_%d( WRValue* s, WRValue* %s, WRValue* %s, WRContext* %s )\n"
+							 "{\n"
+							 "%s"
+							 "}\n",
+							 name, f,
+							 aot.usesFrame ? "frameBase" : "/*frameBase*/",
+							 aot.usesGlobals ? "globalSpace" : "/*globalSpace*/",
+							 aot.usesContext ? "context" : "/*context*/",
+							 body.c_str() );
+		table.appendFormat( "\t{ %s_%d, %d }, // 0x%08X\n", name, f, function.maxDepth, wrf.hash );
+	}
+
+	source.appendFormat( "\n"
+						 "//------------------------------------------------------------------------------\n"
+						 "static const WRNativeFunction %s_functions[] =\n"
+						 "{\n"
+						 "%s"
+						 "};\n"
+						 "\n"
+						 "extern const WRNativeModule %s = { 0x%08Xu, %d, %s_functions };\n"
+						 "\n"
+						 "#endif\n"
+						 "\n"
+						 "extern const unsigned int %s_bytecodeSize = %u;\n"
+						 "extern const unsigned char %s_bytecode[] =\n"
+						 "{",
+						 name, table.c_str(), name, crc, context->numLocalFunctions, name, name, len, name );
+	for( unsigned int i=0; i<len; ++i )
+	{
+		source.appendFormat( "%s0x%02X,", (i % 16) ? " " : "\n\t", bytecode[i] );
+	}
+	source += "\n};\n";
+
+	wr_destroyState( w );
+	source.release( out, outLen );
 }
+#endif
 /*******************************************************************************
 Copyright (c) 2023 Curt Hartung -- curt.hartung@gmail.com
 
@@ -18451,6 +24773,49 @@ void wr_write_file( WRValue* stackTop, const int argn, WRContext* c )
 	}
 }
 
+//------------------------------------------------------------------------------
+bool wr_readFileBytes( const char* fileName, char** data, unsigned int* len )
+{
+	struct stat sbuf;
+	if ( stat(fileName, &sbuf) != 0 )
+	{
+		return false;
+	}
+
+	FILE *infil = fopen( fileName, "rb" );
+	if ( !infil )
+	{
+		return false;
+	}
+
+	*len = (unsigned int)sbuf.st_size;
+	*data = (char*)g_malloc( *len + 1 );
+	bool ret = *data && (!*len || fread(*data, *len, 1, infil) == 1);
+	fclose( infil );
+
+	if ( !ret && *data )
+	{
+		g_free( *data );
+		*data = 0;
+	}
+
+	return ret;
+}
+
+//------------------------------------------------------------------------------
+bool wr_writeFileBytes( const char* fileName, const char* data, const unsigned int len )
+{
+	FILE *outfil = fopen( fileName, "wb" );
+	if ( !outfil )
+	{
+		return false;
+	}
+
+	bool ret = !len || fwrite( data, len, 1, outfil ) == 1;
+	fclose( outfil );
+	return ret;
+}
+
 //------------------------------------------------------------------------------
 void wr_delete_file( WRValue* stackTop, const int argn, WRContext* c )
 {
@@ -18749,6 +25114,49 @@ void wr_write_file( WRValue* stackTop, const int argn, WRContext* c )
 	}
 }
 
+//------------------------------------------------------------------------------
+bool wr_readFileBytes( const char* fileName, char** data, unsigned int* len )
+{
+	struct _stat sbuf;
+	if ( _stat(fileName, &sbuf) != 0 )
+	{
+		return false;
+	}
+
+	FILE *infil = fopen( fileName, "rb" );
+	if ( !infil )
+	{
+		return false;
+	}
+
+	*len = (unsigned int)sbuf.st_size;
+	*data = (char*)g_malloc( *len + 1 );
+	bool ret = *data && (!*len || fread(*data, *len, 1, infil) == 1);
+	fclose( infil );
+
+	if ( !ret && *data )
+	{
+		g_free( *data );
+		*data = 0;
+	}
+
+	return ret;
+}
+
+//------------------------------------------------------------------------------
+bool wr_writeFileBytes( const char* fileName, const char* data, const unsigned int len )
+{
+	FILE *outfil = fopen( fileName, "wb" );
+	if ( !outfil )
+	{
+		return false;
+	}
+
+	bool ret = !len || fwrite( data, len, 1, outfil ) == 1;
+	fclose( outfil );
+	return ret;
+}
+
 //------------------------------------------------------------------------------
 void wr_delete_file( WRValue* stackTop, const int argn, WRContext* c )
 {
@@ -19087,6 +25495,43 @@ void wr_write_file( WRValue* stackTop, const int argn, WRContext* c )
 	file.close();
 }
 
+//------------------------------------------------------------------------------
+bool wr_readFileBytes( const char* fileName, char** data, unsigned int* len )
+{
+	File file = FILE_OBJ.open( fileName );
+	if ( !file || file.isDirectory() )
+	{
+		return false;
+	}
+
+	*len = file.size();
+	*data = (char*)g_malloc( *len + 1 );
+	bool ret = *data && file.readBytes( *data, *len ) == *len;
+	file.close();
+
+	if ( !ret && *data )
+	{
+		g_free( *data );
+		*data = 0;
+	}
+
+	return ret;
+}
+
+//------------------------------------------------------------------------------
+bool wr_writeFileBytes( const char* fileName, const char* data, const unsigned int len )
+{
+	File file = FILE_OBJ.open( fileName, FILE_WRITE );
+	if ( !file )
+	{
+		return false;
+	}
+
+	bool ret = file.write( (uint8_t *)data, len ) == len;
+	file.close();
+	return ret;
+}
+
 //------------------------------------------------------------------------------
 void wr_delete_file( WRValue* stackTop, const int argn, WRContext* c )
 {
@@ -20794,7 +27239,11 @@ void wr_importCompile( WRValue* stackTop, const int argn, WRContext* c )
 		{
 			unsigned char* out;
 			int outlen;
+#ifdef WRENCH_COMPILE_CACHE
+			if ( (stackTop->i = wr_compileCached(data, len, &out, &outlen)) == WR_ERR_None )
+#else
 			if ( (stackTop->i = wr_compile(data, len, &out, &outlen)) == WR_ERR_None )
+#endif
 			{
 				wr_import( c, out, outlen, true );
 			}
@@ -43,6 +43,23 @@ anyway)
 */
 //#define WRENCH_WITHOUT_COMPILER
 
+/************************************************************************
+With WR_OPTIMIZE the compiler copies functions of up to this many bytes
+of bytecode into their callers instead of calling them, when all they
+change is their own locals
+*/
+#ifndef WRENCH_INLINE_BUDGET
+#define WRENCH_INLINE_BUDGET 32
+#endif
+
+/************************************************************************
+With WR_OPTIMIZE a loop counting from one literal to another has its
+code repeated, when the copies add no more than this many bytes
+*/
+#ifndef WRENCH_UNROLL_BUDGET
+#define WRENCH_UNROLL_BUDGET 64
+#endif
+
 
 /***********************************************************************
 Cause the interpreter to compile into the smallest program size
@@ -109,6 +126,61 @@ depending on usage. (consumes 8 bytes per stack entry)
 // things like infinite recursion
 //#define WRENCH_PROTECT_STACK_FROM_OVERFLOW
 
+/************************************************************************
+Each context remembers where library functions, registered functions and
+library constants were found so calls skip the registry lookup. This is
+how many are remembered (8 bytes each per context), must be a power of 2
+*/
+#ifndef WRENCH_LINK_SLOTS
+#define WRENCH_LINK_SLOTS 16
+#endif
+
+// and how many "value.member" locations remember where the member was
+// found (12 bytes each on 32 bit targets), a power of 2 and at least 2
+#ifndef WRENCH_INDEX_CACHE_SLOTS
+#define WRENCH_INDEX_CACHE_SLOTS 32
+#endif
+
+/************************************************************************
+Rewrite +, - and * in place into a numeric version once they have
+seen two ints or two floats, which does the math inline instead of
+calling through the operand type table. Any other operands put the
+generic operation back.
+This writes to the bytecode, so it only applies to code handed over to
+wr_run() with takeOwnership, and not to WRENCH_COMPACT builds
+*/
+//#define WRENCH_QUICKEN
+
+/************************************************************************
+Opcode pairs frequent in the benchmark corpus are fused into one opcode,
+they are listed in wrench_super.h. This leaves them out. Code compiled
+with them does not run on a VM built without them
+*/
+//#define WRENCH_NO_SUPERINSTRUCTIONS
+
+/************************************************************************
+Translate a function into x86-64 machine code once it has been called
+WRENCH_JIT_THRESHOLD times. Functions using opcodes the translator does
+not know (anything with strings, arrays, structs or calls into script
+functions) are left to the interpreter. Only for 64 bit Linux hosts, it
+is ignored everywhere else and with the options that watch every
+instruction
+*/
+//#define WRENCH_JIT
+#ifndef WRENCH_JIT_THRESHOLD
+#define WRENCH_JIT_THRESHOLD 8
+#endif
+
+
+/************************************************************************
+Run functions translated ahead of time into C++ by wr_translate() (see
+`make aot`) natively, the translated module is added with
+wr_addNativeModule() and only applies to the bytecode it came from.
+Functions using anything but ints, floats and library calls stay
+interpreted. Ignored with the options that watch every instruction
+*/
+//#define WRENCH_AOT
+
 
 /************************************************************************
 With this defined the VM gives "slice" instructions before forcing a
@@ -124,6 +196,89 @@ void wr_setInstructionsPerSlice( WRState* w, const int instructions );
 void wr_forceYield( WRState* w );  // for the VM to yield right NOW, (called from a different thread)
 #endif
 
+/************************************************************************
+Opcode profiler: counts every executed opcode, every pair of consecutive
+opcodes and every bytecode location, and accumulates the clock ticks
+spent from each dispatch to the next. This adds a clock read and a few
+table lookups to EVERY INSTRUCTION, so it is only meant for measuring.
+Results are read with wr_profileOpcode()/wr_profilePair() or as text
+with wr_profileDump(), and wr_disassemble() lists the executed locations
+*/
+//#define WRENCH_PROFILE_OPCODES
+
+#ifdef WRENCH_PROFILE_OPCODES
+// the tick source, defaults to the cycle counter on x86 and xtensa and
+// to nothing (counts only) elsewhere. only the low 32 bits are used
+//#define WRENCH_PROFILE_CLOCK() my_cycle_counter()
+
+// distinct opcode pairs and bytecode locations that are tracked, what
+// does not fit is counted by wr_profileDropped()
+#ifndef WRENCH_PROFILE_PAIRS
+#define WRENCH_PROFILE_PAIRS 512
+#endif
+#ifndef WRENCH_PROFILE_SITES
+#define WRENCH_PROFILE_SITES 512
+#endif
+
+struct WRProfileCounter
+{
+	uint64_t count; // times executed
+	uint64_t ticks; // clock ticks until the next instruction was dispatched
+};
+
+void wr_profileReset();
+
+// per opcode totals, returns null for opcodes out of range so
+// for( int i=0; wr_profileOpcode(i); ++i ) visits all of them
+const WRProfileCounter* wr_profileOpcode( const int opcode );
+
+// times 'second' was dispatched right after 'first'
+uint64_t wr_profilePair( const int first, const int second );
+
+// executions that did not fit the pair or location tables
+uint64_t wr_profileDropped();
+
+// opcode names, if the compiler is linked in, or numbers
+const char* wr_profileOpcodeName( const int opcode );
+
+// human readable opcodes sorted by ticks then pairs sorted by count,
+// the output is wr_malloc'ed and must be wr_free'ed
+void wr_profileDump( char** out, unsigned int* outLen =0 );
+#endif
+
+/************************************************************************
+Sampling profiler: records the script call stack every 'interval'
+branches and function calls, and whenever wr_sampleNow() is called (from
+a timer for example). Code compiled with WR_EMBED_DEBUG_CODE gets
+function names and the current source line on the innermost frame.
+The output is the "folded stacks" format of flamegraph.pl. While not
+sampling it costs one test per branch and call
+*/
+//#define WRENCH_SAMPLE_PROFILER
+
+#ifdef WRENCH_SAMPLE_PROFILER
+#ifndef WRENCH_SAMPLE_STACKS
+#define WRENCH_SAMPLE_STACKS 128 // distinct call stacks kept
+#endif
+#ifndef WRENCH_SAMPLE_DEPTH
+#define WRENCH_SAMPLE_DEPTH 16 // innermost frames kept per call stack
+#endif
+
+// start (or restart) sampling, interval 0 only samples on wr_sampleNow()
+// returns false if the sample table could not be allocated
+bool wr_sampleStart( WRState* w, const int interval );
+void wr_sampleStop( WRState* w );
+
+// take a sample at the next branch or call, safe to call from an
+// interrupt or another thread
+void wr_sampleNow( WRState* w );
+
+// "frame;frame;frame:line count" lines, names are only known for
+// contexts that have not been destroyed yet
+// the output is wr_malloc'ed and must be wr_free'ed
+void wr_sampleFolded( WRState* w, char** out, unsigned int* outLen =0 );
+#endif
+
 /************************************************************************
 if you WANT full sprintf support for floats (%f/%g) this adds it at
 the cost of using the standard c library for it (stdlib.h), which can incur a
@@ -175,6 +330,45 @@ extern WR_FREE g_free;
 extern bool g_mallocFailed; // used as an internal global flag for when a malloc came back null
 #endif
 
+/************************************************************************
+The compiler keeps its arrays, strings and bytecode in an arena of
+WRENCH_COMPILER_ARENA_CHUNK byte chunks while wr_compile() runs, and
+hands it all back in one piece when it returns, instead of making
+thousands of small allocations that fragment a small heap. Blocks larger
+than an eighth of a chunk still come from the heap one at a time.
+
+NOTE: the arena is global and every WRstr and WRarray made while a
+compile runs comes from it, so with it enabled nothing else in wrench
+(wr_compile(), wr_disassemble(), the profilers...) may run on another
+thread at the same time
+*/
+//#define WRENCH_COMPILER_ARENA
+
+#ifndef WRENCH_COMPILER_ARENA_CHUNK
+#define WRENCH_COMPILER_ARENA_CHUNK 2048 // 16384 at most
+#endif
+
+/************************************************************************
+wr_runCommand() and sys::importCompile keep the bytecode they compile,
+keyed by a hash of the source text, the compiler flags and the compiler
+build, so compiling the same text again is a lookup and a copy. The
+least recently used entries are dropped to keep the bytecode held under
+WRENCH_COMPILE_CACHE_BYTES. With a file IO backend defined the cache can
+also be saved to and loaded from a file, so scripts compiled on one boot
+do not have to be compiled on the next.
+
+NOTE: the cache is global, like the arena above
+*/
+//#define WRENCH_COMPILE_CACHE
+
+#ifdef WRENCH_WITHOUT_COMPILER
+#undef WRENCH_COMPILE_CACHE // nothing to cache
+#endif
+
+#ifndef WRENCH_COMPILE_CACHE_BYTES
+#define WRENCH_COMPILE_CACHE_BYTES 8192
+#endif
+
 //------------------------------------------------------------------------------
 
 struct WRValue;
@@ -296,6 +490,13 @@ enum WrenchCompilerFlags
 	WR_EMBED_SOURCE_CODE = 1<<2, // include a copy of the source code
 	
 	WR_NON_STRICT_VAR    = 1<<3, // require 'var' to declare a variable (disabled by default)
+
+	WR_OPTIMIZE          = 1<<4, // fold constants, thread jumps and remove dead code
+								 // and stores in functions after they are compiled,
+								 // inline small functions and turn calls a
+								 // function makes to itself before returning
+								 // into jumps, hoist what does not change out
+								 // of loops and unroll counted ones
 };
 
 WRError wr_compile( const char* source,
@@ -305,9 +506,82 @@ WRError wr_compile( const char* source,
 					char* errMsg =0,
 					const uint8_t compilerOptionFlags = WR_INCLUDE_GLOBALS );
 
+// bytes the compiler arena took from the heap during the last
+// wr_compile(), 0 without WRENCH_COMPILER_ARENA
+unsigned int wr_compilerPeakMemory();
+
+#ifdef WRENCH_COMPILE_CACHE
+// wr_compile() through the compile cache, a hit copies the cached
+// bytecode out without compiling anything, errors are never cached
+WRError wr_compileCached( const char* source,
+						  const int size,
+						  unsigned char** out,
+						  int* outLen,
+						  char* errMsg =0,
+						  const uint8_t compilerOptionFlags = WR_INCLUDE_GLOBALS );
+
+struct WRCompileCacheStats
+{
+	uint32_t hits;
+	uint32_t misses;
+	uint32_t evictions;
+	uint32_t bytesSaved; // source bytes hits did not have to compile
+	uint32_t entries; // held now
+	uint32_t bytes; // bytecode held now
+};
+void wr_compileCacheStats( WRCompileCacheStats* stats );
+
+// drop every entry and zero the counters
+void wr_compileCacheClear();
+
+#if defined(WRENCH_WIN32_FILE_IO) \
+	|| defined(WRENCH_LINUX_FILE_IO) \
+	|| defined(WRENCH_SPIFFS_FILE_IO) \
+	|| defined(WRENCH_LITTLEFS_FILE_IO) \
+	|| defined(WRENCH_CUSTOM_FILE_IO)
+// write every entry out, most recently used first
+bool wr_compileCacheSave( const char* fileName );
+
+// add the entries of a file written by wr_compileCacheSave(), entries
+// from a different compiler build or with a bad CRC are skipped
+bool wr_compileCacheLoad( const char* fileName );
+#endif
+#endif
+
 // disassemble the bytecode and output humanm readable
 void wr_disassemble( const uint8_t* bytecode, const unsigned int len, char** out, unsigned int* outLen =0 );
 
+// translate the functions of compiled bytecode into C++ for a build
+// with WRENCH_AOT, 'name' is the C identifier of the module it defines.
+// the bytecode itself is written out with it as <name>_bytecode
+void wr_translate( const uint8_t* bytecode, const unsigned int len, const char* name, char** out, unsigned int* outLen =0 );
+
+#ifdef WRENCH_AOT
+// a function translated by wr_translate(), it returns non-zero where the
+// interpreter would have stopped with an error
+typedef int (*WRNativeEntry)( WRValue* stackTop, WRValue* frameBase, WRValue* globalSpace, WRContext* context );
+
+struct WRNativeFunction
+{
+	WRNativeEntry entry; // 0 for a function left to the interpreter
+	uint16_t maxDepth; // stack entries it uses
+};
+
+struct WRNativeModule
+{
+	uint32_t crc; // of the bytecode it was translated from
+	uint8_t count;
+	const WRNativeFunction* functions;
+};
+
+// contexts created from the bytecode 'module' was translated from run
+// its functions natively, adding the same module again does nothing
+void wr_addNativeModule( WRState* w, const WRNativeModule* module );
+
+// for translated code
+int wr_nativeCallLib( WRContext* context, WRValue* stackTop, int args, const uint32_t hash, const int andPop );
+#endif
+
 // w:          state (see wr_newState)
 // block:      location of bytecode
 // blockSize:  number of bytes in the block
@@ -1072,6 +1346,17 @@ public:
 #endif
 #endif
 
+#if defined(WRENCH_JIT) && (!defined(__x86_64__) || !defined(__linux__) || defined(WRENCH_COMPACT) \
+	|| defined(WRENCH_TIME_SLICES) || defined(WRENCH_INCLUDE_DEBUG_CODE) || defined(WRENCH_PROFILE_OPCODES) \
+	|| defined(WRENCH_SAMPLE_PROFILER) || defined(WRENCH_HANDLE_MALLOC_FAIL))
+#undef WRENCH_JIT
+#endif
+
+#if defined(WRENCH_AOT) && (defined(WRENCH_TIME_SLICES) || defined(WRENCH_INCLUDE_DEBUG_CODE) || defined(WRENCH_PROFILE_OPCODES) \
+	|| defined(WRENCH_SAMPLE_PROFILER) || defined(WRENCH_HANDLE_MALLOC_FAIL))
+#undef WRENCH_AOT
+#endif
+
 #ifndef WRENCH_COMBINED
 #include "utils/utils.h"
 #include "vm/gc_object.h"
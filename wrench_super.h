@@ -0,0 +1,5 @@
+// Generated by bench/wrench_super.cpp, `make bench-super` regenerates it.
+// 253 opcodes, 1 free, pairs by count in the profiled corpus:
+//   IncLocal                         RelativeJump8                          323208
+#define WRENCH_SUPERINSTRUCTIONS( X ) \
+	X( IncLocalRelativeJump8, IncLocal, RelativeJump, RelativeJump8 )